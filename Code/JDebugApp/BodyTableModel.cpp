@@ -0,0 +1,349 @@
+#include "BodyTableModel.h"
+
+#include <Foundation/Math/Math.h>
+
+#include <QTimer>
+
+namespace
+{
+  /// How often the order of a sorted table follows the changing values of the displayed frame.
+  constexpr double g_fSortIntervalSeconds = 0.5;
+
+  QString FormatVec3(const nsVec3& v)
+  {
+    return QStringLiteral("%1, %2, %3").arg(v.x, 0, 'f', 2).arg(v.y, 0, 'f', 2).arg(v.z, 0, 'f', 2);
+  }
+
+  /// Body IDs are matched as decimal digits, without allocating a string per body.
+  bool IdContains(nsUInt64 uiBodyId, nsStringView sDigits)
+  {
+    char szBuffer[24];
+    char* pEnd = szBuffer + NS_ARRAY_SIZE(szBuffer);
+    char* pStart = pEnd;
+    do
+    {
+      *--pStart = static_cast<char>('0' + uiBodyId % 10);
+      uiBodyId /= 10;
+    } while (uiBodyId != 0);
+
+    return nsStringView(pStart, pEnd).FindSubString(sDigits) != nullptr;
+  }
+
+  /// Sort key of a cell, vectors sort by length and rotations by angle.
+  double GetSortKey(const nsJvdBodyState& body, int iColumn)
+  {
+    switch (iColumn)
+    {
+      case BodyTableModel::BodyId:
+        return static_cast<double>(body.m_uiBodyId);
+      case BodyTableModel::Position:
+        return body.m_vPosition.GetLengthSquared();
+      case BodyTableModel::Rotation:
+        return -nsMath::Abs(body.m_qRotation.w);
+      case BodyTableModel::LinearVelocity:
+        return body.m_vLinearVelocity.GetLengthSquared();
+      case BodyTableModel::AngularVelocity:
+        return body.m_vAngularVelocity.GetLengthSquared();
+      case BodyTableModel::State:
+        return body.m_bIsSleeping ? 1.0 : 0.0;
+      default:
+        return 0.0;
+    }
+  }
+} // namespace
+
+BodyTableModel::BodyTableModel(QObject* parent)
+  : QAbstractTableModel(parent)
+{
+  m_SortTimer = new QTimer(this);
+  m_SortTimer->setSingleShot(true);
+  connect(m_SortTimer, &QTimer::timeout, this, [this]()
+    {
+      if (!IsIdentity())
+      {
+        UpdateRows(true);
+      } });
+}
+
+BodyTableModel::~BodyTableModel() = default;
+
+bool BodyTableModel::SetFrame(const nsJvdFrame* pFrame)
+{
+  if (m_pFrame != pFrame)
+  {
+    m_pFrame = pFrame;
+    ResetRows();
+    return true;
+  }
+
+  if (IsIdentity())
+  {
+    if (GetBodyCount() == m_uiRowCount)
+      return false;
+
+    ResetRows();
+    return true;
+  }
+
+  return UpdateRows(false);
+}
+
+bool BodyTableModel::UpdateRows(bool bForceSort)
+{
+  // the filter follows every change, the rows must never point at bodies that don't match it
+  FilterRows(m_NewRows);
+
+  if (m_NewRows.GetCount() != m_uiRowCount)
+  {
+    ResetRows();
+    return true;
+  }
+
+  if (m_iSortColumn >= 0)
+  {
+    // sorting every body on every tick is too expensive, the order is only refreshed every so often
+    const nsTime now = nsTime::Now();
+    const nsTime interval = nsTime::MakeFromSeconds(g_fSortIntervalSeconds);
+    if (!bForceSort && now - m_LastSort < interval && HasSameBodies(m_NewRows))
+    {
+      if (!m_SortTimer->isActive())
+      {
+        m_SortTimer->start(static_cast<int>((interval - (now - m_LastSort)).GetMilliseconds()) + 1);
+      }
+
+      return false;
+    }
+
+    SortRows(m_NewRows);
+    m_LastSort = now;
+    m_SortTimer->stop();
+  }
+
+  if (m_NewRows != m_Rows)
+  {
+    // same number of rows with different bodies or in a different order, the views repaint what is visible
+    ApplyNewRowOrder();
+  }
+
+  return false;
+}
+
+void BodyTableModel::RefreshRows(int iFirstRow, int iLastRow)
+{
+  iFirstRow = nsMath::Max(iFirstRow, 0);
+  iLastRow = nsMath::Min(iLastRow, static_cast<int>(m_uiRowCount) - 1);
+  if (iFirstRow > iLastRow)
+    return;
+
+  emit dataChanged(index(iFirstRow, 0), index(iLastRow, ColumnCount - 1), {Qt::DisplayRole});
+}
+
+void BodyTableModel::SetIdFilter(const QString& sFilter)
+{
+  const QByteArray filterUtf8 = sFilter.trimmed().toUtf8();
+  if (m_sIdFilter == filterUtf8.constData())
+    return;
+
+  m_sIdFilter = filterUtf8.constData();
+  ResetRows();
+}
+
+int BodyTableModel::GetRowOfBody(nsUInt32 uiBodyIndex) const
+{
+  if (IsIdentity())
+    return uiBodyIndex < m_uiRowCount ? static_cast<int>(uiBodyIndex) : -1;
+
+  const nsUInt32 uiRow = m_Rows.IndexOf(uiBodyIndex);
+  return uiRow != nsInvalidIndex ? static_cast<int>(uiRow) : -1;
+}
+
+int BodyTableModel::rowCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : static_cast<int>(m_uiRowCount);
+}
+
+int BodyTableModel::columnCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant BodyTableModel::data(const QModelIndex& index, int role) const
+{
+  if (role != Qt::DisplayRole || !index.isValid() || m_pFrame == nullptr)
+    return {};
+
+  const nsUInt32 uiRow = static_cast<nsUInt32>(index.row());
+  const nsUInt32 uiBody = IsIdentity() ? uiRow : (uiRow < m_Rows.GetCount() ? m_Rows[uiRow] : nsInvalidIndex);
+
+  // the frame may have shrunk since the row count was announced
+  if (uiBody >= m_pFrame->m_Bodies.GetCount())
+    return {};
+
+  const nsJvdBodyState& body = m_pFrame->m_Bodies[uiBody];
+  switch (index.column())
+  {
+    case BodyId:
+      return QString::number(static_cast<qulonglong>(body.m_uiBodyId));
+    case Position:
+      return FormatVec3(body.m_vPosition);
+    case Rotation:
+      return QStringLiteral("%1, %2, %3, %4")
+        .arg(body.m_qRotation.x, 0, 'f', 2)
+        .arg(body.m_qRotation.y, 0, 'f', 2)
+        .arg(body.m_qRotation.z, 0, 'f', 2)
+        .arg(body.m_qRotation.w, 0, 'f', 2);
+    case LinearVelocity:
+      return FormatVec3(body.m_vLinearVelocity);
+    case AngularVelocity:
+      return FormatVec3(body.m_vAngularVelocity);
+    case State:
+      return body.m_bIsSleeping ? tr("Sleeping") : tr("Active");
+    default:
+      return {};
+  }
+}
+
+QVariant BodyTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+  if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+    return QAbstractTableModel::headerData(section, orientation, role);
+
+  switch (section)
+  {
+    case BodyId:
+      return tr("Body ID");
+    case Position:
+      return tr("Position");
+    case Rotation:
+      return tr("Rotation");
+    case LinearVelocity:
+      return tr("Linear Velocity");
+    case AngularVelocity:
+      return tr("Angular Velocity");
+    case State:
+      return tr("State");
+    default:
+      return {};
+  }
+}
+
+void BodyTableModel::sort(int column, Qt::SortOrder order)
+{
+  if (m_iSortColumn == column && m_SortOrder == order)
+    return;
+
+  m_iSortColumn = column;
+  m_SortOrder = order;
+  ResetRows();
+}
+
+void BodyTableModel::FilterRows(nsDynamicArray<nsUInt32>& out_rows) const
+{
+  out_rows.Clear();
+  if (m_pFrame == nullptr)
+    return;
+
+  const nsArrayPtr<const nsJvdBodyState> bodies = m_pFrame->m_Bodies.GetArrayPtr();
+  out_rows.Reserve(bodies.GetCount());
+  for (nsUInt32 i = 0; i < bodies.GetCount(); ++i)
+  {
+    if (m_sIdFilter.IsEmpty() || IdContains(bodies[i].m_uiBodyId, m_sIdFilter))
+    {
+      out_rows.PushBack(i);
+    }
+  }
+}
+
+void BodyTableModel::SortRows(nsDynamicArray<nsUInt32>& inout_rows) const
+{
+  if (m_iSortColumn < 0 || m_pFrame == nullptr)
+    return;
+
+  // evaluate every key once, the comparisons only look up numbers
+  const nsArrayPtr<const nsJvdBodyState> bodies = m_pFrame->m_Bodies.GetArrayPtr();
+  m_SortKeys.SetCountUninitialized(bodies.GetCount());
+  for (nsUInt32 uiBody : inout_rows)
+  {
+    m_SortKeys[uiBody] = GetSortKey(bodies[uiBody], m_iSortColumn);
+  }
+
+  const bool bDescending = m_SortOrder == Qt::DescendingOrder;
+  inout_rows.Sort([this, bDescending](nsUInt32 a, nsUInt32 b)
+    {
+      if (m_SortKeys[a] != m_SortKeys[b])
+        return bDescending ? m_SortKeys[a] > m_SortKeys[b] : m_SortKeys[a] < m_SortKeys[b];
+      return a < b; });
+}
+
+bool BodyTableModel::HasSameBodies(const nsDynamicArray<nsUInt32>& rows)
+{
+  // m_NewRowOfBody is only scratch here, ApplyNewRowOrder() fills it again
+  m_NewRowOfBody.Clear();
+  m_NewRowOfBody.SetCount(GetBodyCount(), nsInvalidIndex);
+  for (nsUInt32 uiBody : m_Rows)
+  {
+    if (uiBody < m_NewRowOfBody.GetCount())
+    {
+      m_NewRowOfBody[uiBody] = 0;
+    }
+  }
+
+  for (nsUInt32 uiBody : rows)
+  {
+    if (m_NewRowOfBody[uiBody] == nsInvalidIndex)
+      return false;
+  }
+
+  return true;
+}
+
+void BodyTableModel::ResetRows()
+{
+  beginResetModel();
+
+  if (IsIdentity())
+  {
+    m_Rows.Clear();
+    m_uiRowCount = GetBodyCount();
+  }
+  else
+  {
+    FilterRows(m_Rows);
+    SortRows(m_Rows);
+    m_uiRowCount = m_Rows.GetCount();
+    m_LastSort = nsTime::Now();
+  }
+
+  m_SortTimer->stop();
+
+  endResetModel();
+}
+
+void BodyTableModel::ApplyNewRowOrder()
+{
+  emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+  m_NewRowOfBody.Clear();
+  m_NewRowOfBody.SetCount(GetBodyCount(), nsInvalidIndex);
+  for (nsUInt32 uiRow = 0; uiRow < m_NewRows.GetCount(); ++uiRow)
+  {
+    m_NewRowOfBody[m_NewRows[uiRow]] = uiRow;
+  }
+
+  // the selection and the current index stay on their bodies, bodies that were filtered out lose them
+  const QModelIndexList oldIndexes = persistentIndexList();
+  QModelIndexList newIndexes;
+  newIndexes.reserve(oldIndexes.size());
+  for (const QModelIndex& oldIndex : oldIndexes)
+  {
+    const nsUInt32 uiOldRow = static_cast<nsUInt32>(oldIndex.row());
+    const nsUInt32 uiBody = uiOldRow < m_Rows.GetCount() ? m_Rows[uiOldRow] : nsInvalidIndex;
+    const nsUInt32 uiNewRow = uiBody < m_NewRowOfBody.GetCount() ? m_NewRowOfBody[uiBody] : nsInvalidIndex;
+    newIndexes.append(uiNewRow != nsInvalidIndex ? index(static_cast<int>(uiNewRow), oldIndex.column()) : QModelIndex());
+  }
+
+  m_Rows.Swap(m_NewRows);
+  changePersistentIndexList(oldIndexes, newIndexes);
+
+  emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
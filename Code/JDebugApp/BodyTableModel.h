@@ -0,0 +1,88 @@
+#pragma once
+
+#include <QAbstractTableModel>
+
+#include <JVDSDK/Recording/JvdRecordingTypes.h>
+
+class QTimer;
+
+/// \brief Read-only table model over the bodies of one frame.
+///
+/// The model does not copy or pre-format anything: cells are formatted in data(), so only the rows the view actually
+/// paints cost anything. Sorting and filtering keep a permutation of body indices instead of reordering the frame.
+/// While the frame changes, the filter follows every change, but the sort order follows the new values only a few
+/// times per second.
+class BodyTableModel : public QAbstractTableModel
+{
+  Q_OBJECT
+
+public:
+  enum Column
+  {
+    BodyId,
+    Position,
+    Rotation,
+    LinearVelocity,
+    AngularVelocity,
+    State,
+    ColumnCount
+  };
+
+  explicit BodyTableModel(QObject* parent = nullptr);
+  ~BodyTableModel() override;
+
+  /// \brief The frame must stay alive and at the same address while it is set, its contents may change between calls.
+  ///
+  /// Returns true if the rows were reset, e.g. because the body count changed. Otherwise the caller is expected to
+  /// call RefreshRows() for the rows that are visible.
+  bool SetFrame(const nsJvdFrame* pFrame);
+
+  /// \brief Emits dataChanged() for the given rows only, clamped to the row count.
+  void RefreshRows(int iFirstRow, int iLastRow);
+
+  /// \brief Only shows bodies whose ID contains the given digits. An empty filter shows all bodies.
+  void SetIdFilter(const QString& sFilter);
+
+  /// \brief The row that shows the body with the given index in the frame, -1 if it is filtered out.
+  int GetRowOfBody(nsUInt32 uiBodyIndex) const;
+
+  int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+  QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+  void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+private:
+  bool IsIdentity() const { return m_iSortColumn < 0 && m_sIdFilter.IsEmpty(); }
+  nsUInt32 GetBodyCount() const { return m_pFrame != nullptr ? m_pFrame->m_Bodies.GetCount() : 0; }
+
+  /// Applies the filter to the bodies of the current frame, the rows are in body order.
+  void FilterRows(nsDynamicArray<nsUInt32>& out_rows) const;
+
+  /// Sorts the given rows by the sort column.
+  void SortRows(nsDynamicArray<nsUInt32>& inout_rows) const;
+
+  /// Brings the rows up to date with the contents of the frame. Returns true if the rows were reset.
+  bool UpdateRows(bool bForceSort);
+
+  /// Whether the given rows refer to the same bodies as m_Rows, in any order. Both must have the same count.
+  bool HasSameBodies(const nsDynamicArray<nsUInt32>& rows);
+
+  /// Recomputes the rows inside a model reset.
+  void ResetRows();
+
+  /// Replaces the rows with m_NewRows, which has the same count, and moves the persistent indexes along with their bodies.
+  void ApplyNewRowOrder();
+
+  const nsJvdFrame* m_pFrame = nullptr;
+  nsDynamicArray<nsUInt32> m_Rows; ///< Body index per row, unused while neither sorting nor filtering.
+  nsDynamicArray<nsUInt32> m_NewRows;
+  nsDynamicArray<nsUInt32> m_NewRowOfBody;
+  nsTime m_LastSort;
+  QTimer* m_SortTimer = nullptr; ///< Sorts once more when the throttle window ends, the frame may not change again.
+  mutable nsDynamicArray<double> m_SortKeys;
+  nsUInt32 m_uiRowCount = 0; ///< The row count announced to the views, the frame may already hold a different number of bodies.
+  int m_iSortColumn = -1;
+  Qt::SortOrder m_SortOrder = Qt::AscendingOrder;
+  nsString m_sIdFilter;
+};
@@ -0,0 +1,91 @@
+#include "BookmarkDockWidget.h"
+
+#include <QListWidget>
+#include <QListWidgetItem>
+#include <QVBoxLayout>
+
+namespace
+{
+  QString GetBookmarkKindName(nsJvdBookmarkKind::Enum kind)
+  {
+    switch (kind)
+    {
+      case nsJvdBookmarkKind::NonFiniteTransform:
+        return QObject::tr("Non-finite transform");
+      case nsJvdBookmarkKind::VelocitySpike:
+        return QObject::tr("Velocity spike");
+      case nsJvdBookmarkKind::AngularVelocitySpike:
+        return QObject::tr("Angular velocity spike");
+      case nsJvdBookmarkKind::Teleport:
+        return QObject::tr("Teleport");
+      case nsJvdBookmarkKind::EnergyGain:
+        return QObject::tr("Energy gain");
+      case nsJvdBookmarkKind::OutOfBounds:
+        return QObject::tr("Out of bounds");
+      default:
+        break;
+    }
+
+    return QObject::tr("Unknown");
+  }
+} // namespace
+
+BookmarkDockWidget::BookmarkDockWidget(QWidget* parent)
+  : QDockWidget(parent)
+{
+  setObjectName(QStringLiteral("BookmarkDockWidget"));
+  setAllowedAreas(Qt::AllDockWidgetAreas);
+  setWindowTitle(tr("Bookmarks"));
+
+  auto* container = new QWidget(this);
+  auto* layout = new QVBoxLayout(container);
+  layout->setContentsMargins(0, 0, 0, 0);
+
+  m_pList = new QListWidget(container);
+  m_pList->setSelectionMode(QAbstractItemView::SingleSelection);
+  m_pList->setContextMenuPolicy(Qt::NoContextMenu);
+
+  layout->addWidget(m_pList);
+  container->setLayout(layout);
+  setWidget(container);
+
+  connect(m_pList, &QListWidget::itemActivated, this, &BookmarkDockWidget::OnItemActivated);
+  connect(m_pList, &QListWidget::itemClicked, this, &BookmarkDockWidget::OnItemActivated);
+}
+
+BookmarkDockWidget::~BookmarkDockWidget() = default;
+
+void BookmarkDockWidget::SetBookmarks(const nsDynamicArray<nsJvdBookmark>& bookmarks)
+{
+  m_pList->clear();
+
+  for (const nsJvdBookmark& bookmark : bookmarks)
+  {
+    QString text = tr("%1 s  [frame %2]  %3  body %4")
+                     .arg(bookmark.m_Timestamp.GetSeconds(), 0, 'f', 3)
+                     .arg(bookmark.m_uiFrameIndex)
+                     .arg(GetBookmarkKindName(bookmark.m_Kind))
+                     .arg(bookmark.m_uiBodyId);
+
+    if (bookmark.m_uiBodyCount > 1)
+    {
+      text += tr(" (+%1 more)").arg(bookmark.m_uiBodyCount - 1);
+    }
+
+    if (bookmark.m_Kind != nsJvdBookmarkKind::NonFiniteTransform && bookmark.m_Kind != nsJvdBookmarkKind::OutOfBounds)
+    {
+      text += tr("  value %1").arg(bookmark.m_fValue, 0, 'g', 4);
+    }
+
+    auto* item = new QListWidgetItem(text, m_pList);
+    item->setData(Qt::UserRole, QVariant::fromValue<quint64>(bookmark.m_uiFrameIndex));
+  }
+}
+
+void BookmarkDockWidget::OnItemActivated(QListWidgetItem* item)
+{
+  if (!item)
+    return;
+
+  Q_EMIT BookmarkActivated(item->data(Qt::UserRole).value<quint64>());
+}
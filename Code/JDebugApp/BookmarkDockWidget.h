@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QDockWidget>
+
+#include <JVDSDK/Recording/JvdRecordingTypes.h>
+
+class QListWidget;
+class QListWidgetItem;
+
+/// \brief Dockable list of the anomaly bookmarks stored in a clip. Activating an entry requests a jump to its frame.
+class BookmarkDockWidget : public QDockWidget
+{
+  Q_OBJECT
+
+public:
+  explicit BookmarkDockWidget(QWidget* parent = nullptr);
+  ~BookmarkDockWidget() override;
+
+  void SetBookmarks(const nsDynamicArray<nsJvdBookmark>& bookmarks);
+
+signals:
+  void BookmarkActivated(quint64 frameIndex);
+
+private slots:
+  void OnItemActivated(QListWidgetItem* item);
+
+private:
+  QListWidget* m_pList = nullptr;
+};
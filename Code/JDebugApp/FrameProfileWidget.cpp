@@ -0,0 +1,165 @@
+#include "FrameProfileWidget.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QToolTip>
+
+#include <Foundation/Algorithm/HashingUtils.h>
+#include <Foundation/Math/Math.h>
+
+namespace
+{
+  constexpr int g_iHeaderHeight = 18;
+  constexpr int g_iRowHeight = 16;
+  constexpr int g_iThreadSpacing = 6;
+
+  QColor GetScopeColor(nsStringView sName)
+  {
+    // stable per name, so the same scope has the same colour in every frame
+    const nsUInt32 uiHash = nsHashingUtils::StringHashTo32(nsHashingUtils::StringHash(sName));
+    return QColor::fromHsv(static_cast<int>(uiHash % 360), 110, 220);
+  }
+
+  QString FormatDuration(nsTime duration)
+  {
+    return QStringLiteral("%1 ms").arg(duration.GetMilliseconds(), 0, 'f', 3);
+  }
+} // namespace
+
+FrameProfileWidget::FrameProfileWidget(QWidget* parent)
+  : QWidget(parent)
+{
+  setObjectName(QStringLiteral("FrameProfileWidget"));
+  setMinimumHeight(80);
+  setMouseTracking(true);
+}
+
+FrameProfileWidget::~FrameProfileWidget() = default;
+
+void FrameProfileWidget::SetProfile(const nsJvdProfilingData* pData, const nsJvdFrameProfile* pFrame)
+{
+  if (m_pData == pData && m_pFrame == pFrame)
+    return;
+
+  m_pData = pData;
+  m_pFrame = pFrame;
+  m_LayoutSize = QSize();
+  update();
+}
+
+void FrameProfileWidget::UpdateLayout()
+{
+  m_LayoutSize = size();
+  m_ScopeRects.Clear();
+  m_ThreadBands.Clear();
+
+  if (m_pData == nullptr || m_pFrame == nullptr || m_pFrame->m_Scopes.IsEmpty())
+    return;
+
+  const double fFrameDuration = nsMath::Max(m_pFrame->m_Duration.GetSeconds(), 1e-9);
+  const double fWidth = static_cast<double>(width());
+
+  // scopes are sorted by thread, every thread gets a band as deep as its deepest scope
+  int iBandTop = g_iHeaderHeight;
+  nsUInt32 uiBandStart = 0;
+  while (uiBandStart < m_pFrame->m_Scopes.GetCount())
+  {
+    const nsUInt16 uiThread = m_pFrame->m_Scopes[uiBandStart].m_uiThreadIndex;
+    nsUInt32 uiBandEnd = uiBandStart;
+    nsUInt32 uiMaxDepth = 0;
+    while (uiBandEnd < m_pFrame->m_Scopes.GetCount() && m_pFrame->m_Scopes[uiBandEnd].m_uiThreadIndex == uiThread)
+    {
+      uiMaxDepth = nsMath::Max<nsUInt32>(uiMaxDepth, m_pFrame->m_Scopes[uiBandEnd].m_uiDepth);
+      ++uiBandEnd;
+    }
+
+    const int iBandHeight = static_cast<int>(uiMaxDepth + 2) * g_iRowHeight;
+    m_ThreadBands.PushBack(QRectF(0, iBandTop, fWidth, iBandHeight));
+
+    for (nsUInt32 i = uiBandStart; i < uiBandEnd; ++i)
+    {
+      const nsJvdProfileScope& scope = m_pFrame->m_Scopes[i];
+      const double fX = scope.m_BeginTime.GetSeconds() / fFrameDuration * fWidth;
+      const double fW = nsMath::Max(scope.m_Duration.GetSeconds() / fFrameDuration * fWidth, 1.0);
+      const double fY = iBandTop + static_cast<double>(scope.m_uiDepth + 1) * g_iRowHeight;
+
+      ScopeRect& rect = m_ScopeRects.ExpandAndGetRef();
+      rect.m_Rect = QRectF(fX, fY, fW, g_iRowHeight - 1);
+      rect.m_uiScopeIndex = i;
+    }
+
+    iBandTop += iBandHeight + g_iThreadSpacing;
+    uiBandStart = uiBandEnd;
+  }
+}
+
+void FrameProfileWidget::paintEvent(QPaintEvent* /*event*/)
+{
+  QPainter painter(this);
+  painter.fillRect(rect(), palette().base());
+  painter.setPen(palette().text().color());
+
+  if (m_pData == nullptr || m_pFrame == nullptr)
+  {
+    painter.drawText(rect(), Qt::AlignCenter, tr("No profile for this frame"));
+    return;
+  }
+
+  if (m_LayoutSize != size())
+  {
+    UpdateLayout();
+  }
+
+  painter.drawText(QRect(4, 0, width() - 8, g_iHeaderHeight), Qt::AlignLeft | Qt::AlignVCenter,
+    tr("Frame %1: %2, %3 scopes").arg(m_pFrame->m_uiFrameIndex).arg(FormatDuration(m_pFrame->m_Duration)).arg(m_pFrame->m_Scopes.GetCount()));
+
+  const QColor bandColor = palette().alternateBase().color();
+  nsUInt32 uiBand = 0;
+  for (nsUInt32 i = 0; i < m_ScopeRects.GetCount(); ++i)
+  {
+    const nsJvdProfileScope& scope = m_pFrame->m_Scopes[m_ScopeRects[i].m_uiScopeIndex];
+
+    // the first scope of every thread starts a new band
+    if (i == 0 || m_pFrame->m_Scopes[m_ScopeRects[i - 1].m_uiScopeIndex].m_uiThreadIndex != scope.m_uiThreadIndex)
+    {
+      const QRectF& band = m_ThreadBands[uiBand++];
+      painter.fillRect(band, bandColor);
+      painter.setPen(palette().text().color());
+      painter.drawText(band.adjusted(4, 0, -4, 0).toRect(), Qt::AlignLeft | Qt::AlignTop, QString::fromUtf8(m_pData->GetThreadNames()[scope.m_uiThreadIndex].GetData()));
+    }
+
+    const QRectF& scopeRect = m_ScopeRects[i].m_Rect;
+    const nsString& sName = m_pData->GetScopeNames()[scope.m_uiNameIndex];
+    painter.fillRect(scopeRect, GetScopeColor(sName));
+
+    if (scopeRect.width() > 24.0)
+    {
+      painter.setPen(Qt::black);
+      const QString sText = painter.fontMetrics().elidedText(QString::fromUtf8(sName.GetData()), Qt::ElideRight, static_cast<int>(scopeRect.width()) - 4);
+      painter.drawText(scopeRect.adjusted(2, 0, -2, 0), Qt::AlignLeft | Qt::AlignVCenter, sText);
+    }
+  }
+}
+
+void FrameProfileWidget::mouseMoveEvent(QMouseEvent* event)
+{
+  QWidget::mouseMoveEvent(event);
+
+  if (m_pData == nullptr || m_pFrame == nullptr)
+    return;
+
+  const QPointF pos = event->position();
+  for (const ScopeRect& scopeRect : m_ScopeRects)
+  {
+    if (scopeRect.m_Rect.contains(pos))
+    {
+      const nsJvdProfileScope& scope = m_pFrame->m_Scopes[scopeRect.m_uiScopeIndex];
+      QToolTip::showText(event->globalPosition().toPoint(),
+        tr("%1\n%2, starts at %3").arg(QString::fromUtf8(m_pData->GetScopeNames()[scope.m_uiNameIndex].GetData())).arg(FormatDuration(scope.m_Duration)).arg(FormatDuration(scope.m_BeginTime)),
+        this);
+      return;
+    }
+  }
+
+  QToolTip::hideText();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QWidget>
+
+#include <JVDSDK/Recording/JvdProfilingData.h>
+
+/// \brief Flame graph of the CPU scopes that ran during one recorded frame, one band per thread.
+class FrameProfileWidget : public QWidget
+{
+  Q_OBJECT
+
+public:
+  explicit FrameProfileWidget(QWidget* parent = nullptr);
+  ~FrameProfileWidget() override;
+
+  /// \brief Both must stay alive while they are set. Pass nullptr for frames without a profile.
+  void SetProfile(const nsJvdProfilingData* pData, const nsJvdFrameProfile* pFrame);
+
+protected:
+  void paintEvent(QPaintEvent* event) override;
+  void mouseMoveEvent(QMouseEvent* event) override;
+
+private:
+  struct ScopeRect
+  {
+    QRectF m_Rect;
+    nsUInt32 m_uiScopeIndex = 0;
+  };
+
+  void UpdateLayout();
+
+  const nsJvdProfilingData* m_pData = nullptr;
+  const nsJvdFrameProfile* m_pFrame = nullptr;
+
+  /// Rows and rectangles are rebuilt whenever the profile or the widget size changes.
+  nsDynamicArray<ScopeRect> m_ScopeRects;
+  nsDynamicArray<QRectF> m_ThreadBands;
+  QSize m_LayoutSize;
+};
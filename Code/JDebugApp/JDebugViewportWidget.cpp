@@ -2,24 +2,48 @@
 
 #include <QCoreApplication>
 #include <QEvent>
+#include <QKeyEvent>
+#include <QMouseEvent>
 #include <QPaintEvent>
 #include <QResizeEvent>
 #include <QShowEvent>
+#include <QWheelEvent>
 #include <QWindow>
 
 #include <Core/System/Window.h>
 #include <Foundation/Logging/Log.h>
 #include <Foundation/Math/BoundingBox.h>
+#include <Foundation/Math/Frustum.h>
 #include <Foundation/Math/Math.h>
 #include <Foundation/Threading/AtomicInteger.h>
+#include <Foundation/Utilities/GraphicsUtils.h>
 
 #include <cmath>
 
 namespace
 {
   constexpr float s_fDefaultFov = 60.0f;
+
+  // the view FrameScene() moves to, slightly from the side and above
+  constexpr float s_fFramingYaw = 11.3f;
+  constexpr float s_fFramingPitch = -30.5f;
+  constexpr float s_fFramingDistance = 3.0f; ///< In multiples of the scene radius.
+
+  constexpr float s_fRotationPerPixel = 0.3f; ///< Degrees.
+  constexpr float s_fMaxPitch = 89.0f;
+  constexpr float s_fZoomPerWheelStep = 0.85f;
+  constexpr float s_fMoveStep = 0.02f; ///< In multiples of the scene radius, per key press.
 } // namespace
 
+struct JDebugViewportWidget::PickingUpdateTask final : public nsTask
+{
+  nsJvdBodyPicking* m_pPicking = nullptr;
+  nsArrayPtr<const nsJvdBodyState> m_Bodies;
+
+private:
+  virtual void Execute() override { m_pPicking->Update(m_Bodies); }
+};
+
 struct JDebugViewportWidget::QtWindowAdapter final : public nsWindowBase
 {
   explicit QtWindowAdapter(QWidget& widget)
@@ -74,6 +98,7 @@ JDebugViewportWidget::JDebugViewportWidget(QWidget* parent)
   setAttribute(Qt::WA_PaintOnScreen);
   setAttribute(Qt::WA_NoSystemBackground);
   setAutoFillBackground(false);
+  setFocusPolicy(Qt::ClickFocus);
 
   // Ensure a native window is created so that winId() returns a valid handle.
   winId();
@@ -86,15 +111,26 @@ JDebugViewportWidget::JDebugViewportWidget(QWidget* parent)
 
 JDebugViewportWidget::~JDebugViewportWidget()
 {
+  WaitForPickingUpdate();
   ShutdownRenderer();
 }
 
-void JDebugViewportWidget::DisplayFrame(const nsJvdFrame& frame)
+void JDebugViewportWidget::DisplayFrame(const nsJvdFrame& frame, const nsBoundingBox& bounds)
 {
+  WaitForPickingUpdate();
+
   m_CurrentFrame = frame;
+  m_SceneBounds = bounds;
   m_bHasFrame = true;
   m_bViewportDirty = true;
 
+  // refits the existing tree as long as the frame holds the same bodies, off the UI thread
+  nsSharedPtr<PickingUpdateTask> pTask = NS_DEFAULT_NEW(PickingUpdateTask);
+  pTask->m_pPicking = &m_Picking;
+  pTask->m_Bodies = m_CurrentFrame.m_Bodies;
+  pTask->ConfigureTask("JDebug Picking Update", nsTaskNesting::Never);
+  m_PickingUpdate = nsTaskSystem::StartSingleTask(pTask, nsTaskPriority::ThisFrame);
+
   InitializeRenderer();
 
   if (isVisible())
@@ -103,18 +139,48 @@ void JDebugViewportWidget::DisplayFrame(const nsJvdFrame& frame)
   }
 }
 
+void JDebugViewportWidget::SetOverlays(nsBitflags<nsVulkanOverlay> overlays)
+{
+  m_Overlays = overlays;
+
+  if (m_pVulkanRenderer)
+  {
+    m_pVulkanRenderer->SetOverlays(m_Overlays);
+  }
+
+  m_bViewportDirty = true;
+  update();
+}
+
+void JDebugViewportWidget::SetCameraMode(CameraMode mode)
+{
+  m_CameraMode = mode;
+}
+
+void JDebugViewportWidget::FrameScene()
+{
+  m_bFrameScene = true;
+  OnCameraChanged();
+}
+
+void JDebugViewportWidget::SetHistorySource(const nsJvdClip* pClip)
+{
+  m_pHistoryClip = pClip;
+
+  if (m_pVulkanRenderer)
+  {
+    m_pVulkanRenderer->SetHistorySource(m_pHistoryClip);
+  }
+}
+
 void JDebugViewportWidget::showEvent(QShowEvent* event)
 {
   QWidget::showEvent(event);
 
   m_bVisible = true;
+  m_bViewportDirty = true;
   InitializeRenderer();
 
-  if (!m_FrameTimer.isActive())
-  {
-    m_FrameTimer.start(0, this);
-  }
-
   update();
 }
 
@@ -125,11 +191,6 @@ void JDebugViewportWidget::changeEvent(QEvent* event)
   if (event->type() == QEvent::Hide)
   {
     m_bVisible = false;
-
-    if (m_FrameTimer.isActive())
-    {
-      m_FrameTimer.stop();
-    }
   }
 }
 
@@ -150,6 +211,9 @@ void JDebugViewportWidget::resizeEvent(QResizeEvent* event)
 void JDebugViewportWidget::paintEvent(QPaintEvent* event)
 {
   NS_IGNORE_UNUSED(event);
+
+  // there is no render loop, every paint event comes from a change or an expose and has to produce an image
+  m_bViewportDirty = true;
   RenderFrame();
 }
 
@@ -158,17 +222,6 @@ QPaintEngine* JDebugViewportWidget::paintEngine() const
   return nullptr;
 }
 
-void JDebugViewportWidget::timerEvent(QTimerEvent* event)
-{
-  if (event->timerId() == m_FrameTimer.timerId())
-  {
-    RenderFrame();
-    return;
-  }
-
-  QWidget::timerEvent(event);
-}
-
 void JDebugViewportWidget::InitializeRenderer()
 {
   if (m_bRendererInitialized || m_bRendererFailed)
@@ -213,6 +266,9 @@ void JDebugViewportWidget::InitializeRenderer()
       emit RendererStateChanged(false, true);
       return;
     }
+
+    m_pVulkanRenderer->SetOverlays(m_Overlays);
+    m_pVulkanRenderer->SetHistorySource(m_pHistoryClip);
   }
 
   m_pVulkanRenderer->SetBackBufferSize(initialSize.width, initialSize.height);
@@ -224,11 +280,6 @@ void JDebugViewportWidget::InitializeRenderer()
 
 void JDebugViewportWidget::ShutdownRenderer()
 {
-  if (m_FrameTimer.isActive())
-  {
-    m_FrameTimer.stop();
-  }
-
   if (m_pVulkanRenderer)
   {
     m_pVulkanRenderer->Deinitialize();
@@ -248,52 +299,191 @@ void JDebugViewportWidget::ShutdownRenderer()
 
 void JDebugViewportWidget::RetryRendererInitialization()
 {
-  const bool bWasVisible = isVisible();
-
   ShutdownRenderer();
+  InitializeRenderer();
 
-  if (bWasVisible && !m_FrameTimer.isActive())
+  if (m_bRendererInitialized)
   {
-    m_FrameTimer.start(0, this);
+    update();
   }
+}
 
-  InitializeRenderer();
+void JDebugViewportWidget::UpdateCamera(float fAspect)
+{
+  if (m_SceneBounds.IsValid())
+  {
+    m_fSceneRadius = nsMath::Max(m_SceneBounds.GetHalfExtents().GetLength(), 1.0f);
+  }
 
-  if (m_bRendererInitialized)
+  // the orbit camera only follows the scene once it left the view completely, so playback does not shake the camera
+  if (!m_bFrameScene && m_CameraMode == CameraMode::Orbit && m_bHasFrame && m_bViewProjectionValid && m_SceneBounds.IsValid())
   {
-    update();
+    const nsFrustum frustum = nsFrustum::MakeFromFOV(m_Camera.GetPosition(), m_Camera.GetDirForwards(), m_Camera.GetDirUp(), m_Camera.GetFovX(fAspect), m_Camera.GetFovY(fAspect), m_Camera.GetNearPlane(), m_Camera.GetFarPlane());
+    m_bFrameScene = frustum.GetObjectPosition(m_SceneBounds) == nsVolumePosition::Outside;
+  }
+
+  if (m_bFrameScene)
+  {
+    m_vCameraTarget = m_SceneBounds.IsValid() ? m_SceneBounds.GetCenter() : nsVec3::MakeZero();
+    m_fCameraDistance = m_fSceneRadius * s_fFramingDistance;
+    m_fCameraYaw = s_fFramingYaw;
+    m_fCameraPitch = s_fFramingPitch;
+    m_bFrameScene = false;
   }
+
+  m_Camera.LookAt(m_vCameraTarget - GetCameraForwards() * m_fCameraDistance, m_vCameraTarget, nsVec3(0, 0, 1));
+}
+
+nsVec3 JDebugViewportWidget::GetCameraForwards() const
+{
+  const nsAngle yaw = nsAngle::MakeFromDegree(m_fCameraYaw);
+  const nsAngle pitch = nsAngle::MakeFromDegree(m_fCameraPitch);
+  return nsVec3(nsMath::Cos(pitch) * nsMath::Cos(yaw), nsMath::Cos(pitch) * nsMath::Sin(yaw), nsMath::Sin(pitch));
+}
+
+void JDebugViewportWidget::MoveCamera(const nsVec3& vDelta)
+{
+  m_vCameraTarget += vDelta;
+  OnCameraChanged();
+}
+
+void JDebugViewportWidget::OnCameraChanged()
+{
+  m_bViewportDirty = true;
+  update();
 }
 
-void JDebugViewportWidget::UpdateCamera()
+void JDebugViewportWidget::mousePressEvent(QMouseEvent* event)
 {
-  if (!m_bHasFrame)
+  m_LastMousePosition = event->position();
+
+  if (event->button() != Qt::LeftButton)
+  {
+    QWidget::mousePressEvent(event);
     return;
+  }
+
+  emit BodyPicked(PickBody(event->position()));
+}
+
+void JDebugViewportWidget::mouseMoveEvent(QMouseEvent* event)
+{
+  const QPointF delta = event->position() - m_LastMousePosition;
+  m_LastMousePosition = event->position();
+
+  if (event->buttons() & Qt::RightButton)
+  {
+    const nsVec3 vEye = m_vCameraTarget - GetCameraForwards() * m_fCameraDistance;
+
+    m_fCameraYaw += static_cast<float>(delta.x()) * s_fRotationPerPixel;
+    m_fCameraPitch = nsMath::Clamp(m_fCameraPitch - static_cast<float>(delta.y()) * s_fRotationPerPixel, -s_fMaxPitch, s_fMaxPitch);
+
+    if (m_CameraMode == CameraMode::Fly)
+    {
+      // turn the head instead of circling the target
+      m_vCameraTarget = vEye + GetCameraForwards() * m_fCameraDistance;
+    }
+
+    OnCameraChanged();
+  }
+  else if (event->buttons() & Qt::MiddleButton)
+  {
+    // the point under the cursor at the target's depth stays under the cursor
+    const float fUnitsPerPixel = 2.0f * m_fCameraDistance * nsMath::Tan(nsAngle::MakeFromDegree(s_fDefaultFov * 0.5f)) / static_cast<float>(nsMath::Max(height(), 1));
+    MoveCamera((m_Camera.GetDirRight() * static_cast<float>(-delta.x()) + m_Camera.GetDirUp() * static_cast<float>(delta.y())) * fUnitsPerPixel);
+  }
+  else
+  {
+    QWidget::mouseMoveEvent(event);
+  }
+}
 
-  nsBoundingBox bounds = nsBoundingBox::MakeInvalid();
+void JDebugViewportWidget::wheelEvent(QWheelEvent* event)
+{
+  const float fSteps = static_cast<float>(event->angleDelta().y()) / 120.0f;
 
-  for (const nsJvdBodyState& state : m_CurrentFrame.m_Bodies)
+  if (m_CameraMode == CameraMode::Orbit)
+  {
+    m_fCameraDistance = nsMath::Max(m_fCameraDistance * nsMath::Pow(s_fZoomPerWheelStep, fSteps), m_fSceneRadius * 0.01f);
+    OnCameraChanged();
+  }
+  else
   {
-    const nsVec3 vHalfExtents = state.m_vScale * 0.5f;
-    bounds.ExpandToInclude(state.m_vPosition - vHalfExtents);
-    bounds.ExpandToInclude(state.m_vPosition + vHalfExtents);
+    MoveCamera(GetCameraForwards() * (fSteps * m_fSceneRadius * s_fMoveStep * 5.0f));
   }
 
-  if (!bounds.IsValid())
+  event->accept();
+}
+
+void JDebugViewportWidget::keyPressEvent(QKeyEvent* event)
+{
+  const nsVec3 vForwards = GetCameraForwards();
+  const nsVec3 vRight = m_Camera.GetDirRight();
+  const nsVec3 vUp(0, 0, 1);
+
+  nsVec3 vDirection = nsVec3::MakeZero();
+  switch (event->key())
   {
-    const nsVec3 vEye(-10.0f, 0.0f, 6.0f);
-    const nsVec3 vTarget = nsVec3::MakeZero();
-    m_Camera.LookAt(vEye, vTarget, nsVec3(0, 0, 1));
-    m_fSceneRadius = 10.0f;
-    return;
+    case Qt::Key_F:
+      FrameScene();
+      return;
+    case Qt::Key_W:
+      vDirection = vForwards;
+      break;
+    case Qt::Key_S:
+      vDirection = -vForwards;
+      break;
+    case Qt::Key_D:
+      vDirection = vRight;
+      break;
+    case Qt::Key_A:
+      vDirection = -vRight;
+      break;
+    case Qt::Key_E:
+      vDirection = vUp;
+      break;
+    case Qt::Key_Q:
+      vDirection = -vUp;
+      break;
+    default:
+      QWidget::keyPressEvent(event);
+      return;
   }
 
-  const nsVec3 vCenter = bounds.GetCenter();
-  const nsVec3 vExtents = bounds.GetHalfExtents();
-  m_fSceneRadius = nsMath::Max(vExtents.GetLength(), 1.0f);
+  const float fSpeed = (event->modifiers() & Qt::ShiftModifier) ? 5.0f : 1.0f;
+  MoveCamera(vDirection * (m_fSceneRadius * s_fMoveStep * fSpeed));
+}
+
+int JDebugViewportWidget::PickBody(const QPointF& position)
+{
+  if (width() <= 0 || height() <= 0)
+    return -1;
+
+  // usually finished long ago, the refit started when the frame was displayed
+  WaitForPickingUpdate();
 
-  const nsVec3 vEyeOffset(-m_fSceneRadius * 2.5f, -m_fSceneRadius * 0.5f, m_fSceneRadius * 1.5f);
-  m_Camera.LookAt(vCenter + vEyeOffset, vCenter, nsVec3(0, 0, 1));
+  const float fAspect = static_cast<float>(width()) / static_cast<float>(height());
+
+  nsMat4 projection = nsMat4::MakeIdentity();
+  m_Camera.GetProjectionMatrix(fAspect, projection, nsCameraEye::Left, nsClipSpaceDepthRange::ZeroToOne);
+  const nsMat4 inverseViewProjection = (projection * m_Camera.GetViewMatrix()).GetInverse();
+
+  nsVec3 vNearPoint;
+  nsVec3 vDirection;
+  if (nsGraphicsUtils::ConvertScreenPosToWorldPos(inverseViewProjection, 0, 0, width(), height(), nsVec3(static_cast<float>(position.x()), static_cast<float>(position.y()), 0.0f), vNearPoint, &vDirection, nsClipSpaceDepthRange::ZeroToOne).Failed())
+    return -1;
+
+  nsJvdPickResult result;
+  if (!m_Picking.CastRay(vNearPoint, vDirection, result))
+    return -1;
+
+  return static_cast<int>(result.m_uiBodyIndex);
+}
+
+void JDebugViewportWidget::WaitForPickingUpdate()
+{
+  nsTaskSystem::WaitForGroup(m_PickingUpdate);
+  m_PickingUpdate.Invalidate();
 }
 
 void JDebugViewportWidget::UpdateViewProjection()
@@ -306,8 +496,12 @@ void JDebugViewportWidget::UpdateViewProjection()
   }
 
   const float fAspect = static_cast<float>(viewportSize.width) / static_cast<float>(viewportSize.height);
-  const float fNearPlane = nsMath::Max(0.1f, m_fSceneRadius * 0.05f);
-  const float fFarPlane = nsMath::Max(100.0f, m_fSceneRadius * 6.0f);
+
+  // the camera may be anywhere now, the planes have to enclose the scene as seen from where it is
+  const nsVec3 vSceneCenter = m_SceneBounds.IsValid() ? m_SceneBounds.GetCenter() : m_vCameraTarget;
+  const float fSceneDistance = (m_Camera.GetPosition() - vSceneCenter).GetLength();
+  const float fFarPlane = nsMath::Max(100.0f, (fSceneDistance + m_fSceneRadius) * 1.5f);
+  const float fNearPlane = nsMath::Max(0.05f, fFarPlane * 0.0005f);
 
   m_Camera.SetCameraMode(nsCameraMode::PerspectiveFixedFovY, s_fDefaultFov, fNearPlane, fFarPlane);
 
@@ -316,6 +510,13 @@ void JDebugViewportWidget::UpdateViewProjection()
   const nsMat4& viewMatrix = m_Camera.GetViewMatrix();
   m_LastViewProjection = viewMatrix * projection;
   m_bViewProjectionValid = true;
+
+  if (m_pVulkanRenderer)
+  {
+    nsJvdCullingView cullingView;
+    cullingView.SetPerspective(m_Camera.GetPosition(), m_Camera.GetDirForwards(), m_Camera.GetDirUp(), m_Camera.GetFovX(fAspect), m_Camera.GetFovY(fAspect), fNearPlane, fFarPlane, viewportSize.height);
+    m_pVulkanRenderer->SetCullingView(cullingView);
+  }
 }
 
 void JDebugViewportWidget::RenderFrame()
@@ -350,9 +551,10 @@ void JDebugViewportWidget::RenderFrame()
     return;
   }
 
+  UpdateCamera(static_cast<float>(viewportSize.width) / static_cast<float>(viewportSize.height));
+
   if (m_bHasFrame)
   {
-    UpdateCamera();
     if (m_pVulkanRenderer)
     {
       m_pVulkanRenderer->UpdateFrame(m_CurrentFrame);
@@ -364,10 +566,14 @@ void JDebugViewportWidget::RenderFrame()
 
   if (m_pVulkanRenderer && m_bViewProjectionValid)
   {
+    const nsTime renderStart = nsTime::Now();
     if (m_pVulkanRenderer->Render(m_LastViewProjection).Failed())
     {
       nsLog::Error("Vulkan renderer failed to render viewport frame.");
     }
+
+    m_LastRenderDuration = nsTime::Now() - renderStart;
+    ++m_uiRenderedFrames;
   }
 
   m_bViewportDirty = false;
@@ -1,17 +1,21 @@
 #pragma once
 
-#include <QBasicTimer>
 #include <QEvent>
+#include <QKeyEvent>
+#include <QMouseEvent>
 #include <QPaintEngine>
 #include <QPaintEvent>
 #include <QResizeEvent>
 #include <QShowEvent>
-#include <QTimerEvent>
+#include <QWheelEvent>
 #include <QWidget>
 
 #include <Core/Graphics/Camera.h>
+#include <Foundation/Math/BoundingBox.h>
 #include <Foundation/Math/Mat4.h>
+#include <Foundation/Threading/TaskSystem.h>
 #include <Foundation/Types/UniquePtr.h>
+#include <JVDSDK/Playback/JvdBodyPicking.h>
 #include <JVDSDK/Recording/JvdRecordingTypes.h>
 #include <PvdRenderer/Renderer/PvdVulkanRenderer.h>
 
@@ -21,43 +25,91 @@ class JDebugViewportWidget : public QWidget
   Q_OBJECT
 
 public:
+  /// \brief How dragging with the right mouse button and the W/A/S/D/Q/E keys move the camera.
+  enum class CameraMode
+  {
+    Orbit, ///< Rotates around the scene and re-frames it when all bodies left the view.
+    Fly,   ///< Rotates in place and never moves on its own.
+  };
+
   explicit JDebugViewportWidget(QWidget* parent = nullptr);
   ~JDebugViewportWidget() override;
 
-  /// \brief Replaces the current frame to visualize on the next render tick.
-  void DisplayFrame(const nsJvdFrame& frame);
+  /// \brief Replaces the current frame and schedules a repaint. The viewport only renders when its frame or size changed.
+  ///
+  /// The bounds of the bodies are passed in because the clip's timeline summary already holds them for every frame.
+  void DisplayFrame(const nsJvdFrame& frame, const nsBoundingBox& bounds);
   void RetryRendererInitialization();
 
+  /// \brief Selects the motion overlays drawn on top of the bodies.
+  void SetOverlays(nsBitflags<nsVulkanOverlay> overlays);
+
+  /// \brief The clip the displayed frames belong to, the motion history is filled from it after seeking.
+  void SetHistorySource(const nsJvdClip* pClip);
+
+  void SetCameraMode(CameraMode mode);
+
+  /// \brief Moves the camera so that all bodies of the displayed frame are visible.
+  void FrameScene();
+
   bool IsRendererInitialized() const { return m_bRendererInitialized; }
   bool HasRendererFailed() const { return m_bRendererFailed; }
 
+  nsUInt64 GetRenderedFrameCount() const { return m_uiRenderedFrames; }
+  nsTime GetLastRenderDuration() const { return m_LastRenderDuration; }
+
 signals:
   void RendererStateChanged(bool bInitialized, bool bFailed);
 
+  /// \brief A left click hit the body with this index in the displayed frame, or nothing if the index is -1.
+  void BodyPicked(int iBodyIndex);
+
 protected:
   void showEvent(QShowEvent* event) override;
   void changeEvent(QEvent* event) override;
   void resizeEvent(QResizeEvent* event) override;
   void paintEvent(QPaintEvent* event) override;
+  void mousePressEvent(QMouseEvent* event) override;
+  void mouseMoveEvent(QMouseEvent* event) override;
+  void wheelEvent(QWheelEvent* event) override;
+  void keyPressEvent(QKeyEvent* event) override;
   QPaintEngine* paintEngine() const override;
-  void timerEvent(QTimerEvent* event) override;
 
 private:
   struct QtWindowAdapter;
 
   void InitializeRenderer();
   void ShutdownRenderer();
-  void UpdateCamera();
+  void UpdateCamera(float fAspect);
   void UpdateViewProjection();
   void RenderFrame();
+  int PickBody(const QPointF& position);
+  void WaitForPickingUpdate();
+
+  nsVec3 GetCameraForwards() const;
+  void MoveCamera(const nsVec3& vDelta);
+  void OnCameraChanged();
 
   nsUniquePtr<QtWindowAdapter> m_pWindowAdapter;
 
   nsJvdFrame m_CurrentFrame;
   bool m_bHasFrame = false;
   nsCamera m_Camera;
+  CameraMode m_CameraMode = CameraMode::Orbit;
+  nsVec3 m_vCameraTarget = nsVec3::MakeZero(); ///< The orbit pivot, the camera looks at it from m_fCameraDistance away.
+  float m_fCameraDistance = 10.0f;
+  float m_fCameraYaw = 0.0f;   ///< Degrees around +Z.
+  float m_fCameraPitch = 0.0f; ///< Degrees above the horizon.
+  bool m_bFrameScene = true;   ///< The next render frames the scene, set for the first frame and on request.
+  QPointF m_LastMousePosition;
+  nsBoundingBox m_SceneBounds = nsBoundingBox::MakeInvalid();
   float m_fSceneRadius = 10.0f;
+  struct PickingUpdateTask;
+  nsJvdBodyPicking m_Picking;    ///< Brought up to date on a task for every displayed frame, a click only casts the ray.
+  nsTaskGroupID m_PickingUpdate; ///< Reads m_CurrentFrame, finished before the frame is replaced.
   nsUniquePtr<nsPvdVulkanRenderer> m_pVulkanRenderer;
+  nsBitflags<nsVulkanOverlay> m_Overlays;
+  const nsJvdClip* m_pHistoryClip = nullptr;
   nsMat4 m_LastViewProjection = nsMat4::MakeIdentity();
   bool m_bViewProjectionValid = false;
 
@@ -66,5 +118,6 @@ private:
   bool m_bVisible = false;
   bool m_bRendererFailed = false;
 
-  QBasicTimer m_FrameTimer;
+  nsUInt64 m_uiRenderedFrames = 0;
+  nsTime m_LastRenderDuration;
 };
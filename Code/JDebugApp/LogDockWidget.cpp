@@ -1,17 +1,63 @@
 #include "LogDockWidget.h"
+#include "LogListModel.h"
 
-#include <QPlainTextEdit>
+#include <QListView>
 #include <QScrollBar>
-#include <QTextCursor>
-#include <QTextOption>
+#include <QTimer>
 #include <QVBoxLayout>
 
 #include <Foundation/Types/Delegate.h>
 
 namespace
 {
-  constexpr qsizetype s_iMaxLogBlocks = 1000;
-}
+  constexpr nsUInt32 s_uiMaxLogLines = 10000;
+  constexpr nsUInt32 s_uiLogQueueCapacity = 4096;
+  constexpr int s_iDrainIntervalMs = 16;
+
+  QString FormatLogEntry(const nsJvdLogEntry& entry)
+  {
+    QString prefix;
+    switch (entry.m_Type)
+    {
+      case nsLogMsgType::ErrorMsg:
+        prefix = QStringLiteral("[Error] ");
+        break;
+      case nsLogMsgType::SeriousWarningMsg:
+        prefix = QStringLiteral("[Serious] ");
+        break;
+      case nsLogMsgType::WarningMsg:
+        prefix = QStringLiteral("[Warning] ");
+        break;
+      case nsLogMsgType::SuccessMsg:
+        prefix = QStringLiteral("[Success] ");
+        break;
+      case nsLogMsgType::DevMsg:
+        prefix = QStringLiteral("[Dev] ");
+        break;
+      case nsLogMsgType::DebugMsg:
+        prefix = QStringLiteral("[Debug] ");
+        break;
+      default:
+        break;
+    }
+
+    QString indent;
+    if (entry.m_uiIndentation > 0)
+    {
+      indent = QString(static_cast<int>(entry.m_uiIndentation) * 2, QChar(' '));
+    }
+
+    const QString message = QString::fromUtf8(entry.m_sText.GetData(), static_cast<qsizetype>(entry.m_sText.GetElementCount()));
+
+    if (!entry.m_sTag.IsEmpty())
+    {
+      const QString tag = QString::fromUtf8(entry.m_sTag.GetData(), static_cast<qsizetype>(entry.m_sTag.GetElementCount()));
+      return prefix + indent + QStringLiteral("[") + tag + QStringLiteral("] ") + message;
+    }
+
+    return prefix + indent + message;
+  }
+} // namespace
 
 LogDockWidget::LogDockWidget(QWidget* parent)
   : QDockWidget(parent)
@@ -24,18 +70,26 @@ LogDockWidget::LogDockWidget(QWidget* parent)
   auto* layout = new QVBoxLayout(container);
   layout->setContentsMargins(0, 0, 0, 0);
 
-  m_pTextEdit = new QPlainTextEdit(container);
-  m_pTextEdit->setReadOnly(true);
-  m_pTextEdit->setWordWrapMode(QTextOption::NoWrap);
-  m_pTextEdit->setContextMenuPolicy(Qt::NoContextMenu);
-  m_pTextEdit->setPlaceholderText(tr("Application log output will appear here."));
-
-  layout->addWidget(m_pTextEdit);
+  // the view only lays out and paints the visible rows, all rows have the height of the first one
+  m_pModel = new LogListModel(s_uiMaxLogLines, this);
+  m_pListView = new QListView(container);
+  m_pListView->setModel(m_pModel);
+  m_pListView->setUniformItemSizes(true);
+  m_pListView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+  m_pListView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  m_pListView->setContextMenuPolicy(Qt::NoContextMenu);
+  m_pListView->setWordWrap(false);
+
+  layout->addWidget(m_pListView);
   container->setLayout(layout);
   setWidget(container);
 
-  connect(this, &LogDockWidget::LogLineReady, this, &LogDockWidget::AppendLogLine, Qt::QueuedConnection);
+  m_pDrainTimer = new QTimer(this);
+  m_pDrainTimer->setSingleShot(true);
+  m_pDrainTimer->setInterval(s_iDrainIntervalMs);
+  connect(m_pDrainTimer, &QTimer::timeout, this, &LogDockWidget::DrainLog);
 
+  m_LogQueue.Initialize(s_uiLogQueueCapacity);
   m_LogSubscription = nsGlobalLog::AddLogWriter(nsMakeDelegate(&LogDockWidget::HandleLogMessage, this));
 }
 
@@ -47,25 +101,44 @@ LogDockWidget::~LogDockWidget()
   }
 }
 
-void LogDockWidget::AppendLogLine(const QString& line)
+void LogDockWidget::DrainLog()
 {
-  if (!m_pTextEdit)
-    return;
+  // messages logged from here on schedule the next drain
+  m_bDrainScheduled = false;
+
+  m_DrainedEntries.Clear();
+  m_LogQueue.Drain(m_DrainedEntries);
+  const nsUInt32 uiDropped = m_LogQueue.TakeDroppedCount();
 
-  QPlainTextEdit* edit = m_pTextEdit;
-  edit->appendPlainText(line);
+  nsDynamicArray<LogLine> lines;
+  lines.Reserve(m_DrainedEntries.GetCount() + 1);
 
-  const qsizetype blockCount = edit->blockCount();
-  if (blockCount > s_iMaxLogBlocks)
+  for (const nsJvdLogEntry& entry : m_DrainedEntries)
   {
-    QTextCursor cursor(edit->document());
-    cursor.setPosition(0);
-    cursor.movePosition(QTextCursor::Down, QTextCursor::KeepAnchor, blockCount - s_iMaxLogBlocks);
-    cursor.removeSelectedText();
-    cursor.deleteChar();
+    LogLine& line = lines.ExpandAndGetRef();
+    line.m_sText = FormatLogEntry(entry);
+    line.m_Type = entry.m_Type;
   }
 
-  edit->verticalScrollBar()->setValue(edit->verticalScrollBar()->maximum());
+  if (uiDropped > 0)
+  {
+    LogLine& line = lines.ExpandAndGetRef();
+    line.m_sText = tr("[Warning] %n log message(s) were dropped because they arrived faster than the log could show them.", nullptr, static_cast<int>(uiDropped));
+    line.m_Type = nsLogMsgType::WarningMsg;
+  }
+
+  if (lines.IsEmpty())
+    return;
+
+  const QScrollBar* pScrollBar = m_pListView->verticalScrollBar();
+  const bool bFollow = pScrollBar->value() == pScrollBar->maximum();
+
+  m_pModel->AppendLines(lines);
+
+  if (bFollow)
+  {
+    m_pListView->scrollToBottom();
+  }
 }
 
 void LogDockWidget::HandleLogMessage(const nsLoggingEventData& data)
@@ -78,54 +151,11 @@ void LogDockWidget::HandleLogMessage(const nsLoggingEventData& data)
     return;
   }
 
-  QString tag;
-  if (!data.m_sTag.IsEmpty())
-  {
-    tag = QString::fromUtf8(data.m_sTag.GetStartPointer(), static_cast<qsizetype>(data.m_sTag.GetElementCount()));
-  }
-
-  const QString message = QString::fromUtf8(data.m_sText.GetStartPointer(), static_cast<qsizetype>(data.m_sText.GetElementCount()));
-
-  QString prefix;
-  switch (data.m_EventType)
-  {
-    case nsLogMsgType::ErrorMsg:
-      prefix = QStringLiteral("[Error] ");
-      break;
-    case nsLogMsgType::SeriousWarningMsg:
-      prefix = QStringLiteral("[Serious] ");
-      break;
-    case nsLogMsgType::WarningMsg:
-      prefix = QStringLiteral("[Warning] ");
-      break;
-    case nsLogMsgType::SuccessMsg:
-      prefix = QStringLiteral("[Success] ");
-      break;
-    case nsLogMsgType::DevMsg:
-      prefix = QStringLiteral("[Dev] ");
-      break;
-    case nsLogMsgType::DebugMsg:
-      prefix = QStringLiteral("[Debug] ");
-      break;
-    default:
-      break;
-  }
-
-  QString indent;
-  if (data.m_uiIndentation > 0)
-  {
-    indent = QString(static_cast<int>(data.m_uiIndentation) * 2, QChar(' '));
-  }
+  // called on whichever thread logged, the message is formatted when the UI thread drains the queue
+  m_LogQueue.TryPush(data.m_EventType, data.m_uiIndentation, data.m_sTag, data.m_sText);
 
-  QString text;
-  if (!tag.isEmpty())
+  if (!m_bDrainScheduled.Set(true))
   {
-    text = prefix + indent + QStringLiteral("[") + tag + QStringLiteral("] ") + message;
+    QMetaObject::invokeMethod(this, [this]() { m_pDrainTimer->start(); }, Qt::QueuedConnection);
   }
-  else
-  {
-    text = prefix + indent + message;
-  }
-
-  Q_EMIT LogLineReady(text);
 }
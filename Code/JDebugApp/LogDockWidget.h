@@ -3,10 +3,17 @@
 #include <QDockWidget>
 
 #include <Foundation/Logging/Log.h>
+#include <Foundation/Threading/AtomicInteger.h>
+#include <JVDSDK/Recording/JvdLogQueue.h>
 
-class QPlainTextEdit;
+class LogListModel;
+class QListView;
+class QTimer;
 
 /// \brief Dockable widget that mirrors nsLog output inside the JDebug UI.
+///
+/// Any thread may log. Messages are queued without locking and the UI thread picks them up at most once per frame, so
+/// a flood of warnings costs one view update per frame instead of one per message.
 class LogDockWidget : public QDockWidget
 {
   Q_OBJECT
@@ -15,15 +22,18 @@ public:
   explicit LogDockWidget(QWidget* parent = nullptr);
   ~LogDockWidget() override;
 
-signals:
-  void LogLineReady(const QString& line);
-
 private slots:
-  void AppendLogLine(const QString& line);
+  void DrainLog();
 
 private:
   void HandleLogMessage(const nsLoggingEventData& data);
 
-  QPlainTextEdit* m_pTextEdit = nullptr;
+  QListView* m_pListView = nullptr;
+  LogListModel* m_pModel = nullptr;
+  QTimer* m_pDrainTimer = nullptr;
+
+  nsJvdLogQueue m_LogQueue;
+  nsAtomicBool m_bDrainScheduled; ///< Set by the first message after a drain, so only that one posts an event to the UI thread.
+  nsDynamicArray<nsJvdLogEntry> m_DrainedEntries;
   nsEventSubscriptionID m_LogSubscription = 0;
 };
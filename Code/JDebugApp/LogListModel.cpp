@@ -0,0 +1,78 @@
+#include "LogListModel.h"
+
+#include <QColor>
+
+LogListModel::LogListModel(nsUInt32 uiCapacity, QObject* parent)
+  : QAbstractListModel(parent)
+{
+  NS_ASSERT_DEV(uiCapacity > 0, "The log needs room for at least one line.");
+  m_Lines.SetCount(uiCapacity);
+}
+
+LogListModel::~LogListModel() = default;
+
+void LogListModel::AppendLines(nsArrayPtr<LogLine> lines)
+{
+  const nsUInt32 uiCapacity = m_Lines.GetCount();
+
+  // lines that would be pushed out by the same batch are never shown
+  if (lines.GetCount() > uiCapacity)
+  {
+    lines = lines.GetSubArray(lines.GetCount() - uiCapacity);
+  }
+
+  if (lines.IsEmpty())
+    return;
+
+  const nsUInt32 uiTotal = m_uiCount + lines.GetCount();
+  const nsUInt32 uiOverflow = uiTotal > uiCapacity ? uiTotal - uiCapacity : 0;
+  if (uiOverflow > 0)
+  {
+    beginRemoveRows(QModelIndex(), 0, static_cast<int>(uiOverflow) - 1);
+    for (nsUInt32 i = 0; i < uiOverflow; ++i)
+    {
+      m_Lines[(m_uiFirst + i) % uiCapacity].m_sText.clear();
+    }
+    m_uiFirst = (m_uiFirst + uiOverflow) % uiCapacity;
+    m_uiCount -= uiOverflow;
+    endRemoveRows();
+  }
+
+  beginInsertRows(QModelIndex(), static_cast<int>(m_uiCount), static_cast<int>(m_uiCount + lines.GetCount()) - 1);
+  for (LogLine& line : lines)
+  {
+    m_Lines[(m_uiFirst + m_uiCount) % uiCapacity] = std::move(line);
+    ++m_uiCount;
+  }
+  endInsertRows();
+}
+
+int LogListModel::rowCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : static_cast<int>(m_uiCount);
+}
+
+QVariant LogListModel::data(const QModelIndex& index, int role) const
+{
+  if (!index.isValid() || static_cast<nsUInt32>(index.row()) >= m_uiCount)
+    return {};
+
+  const LogLine& line = GetLine(static_cast<nsUInt32>(index.row()));
+
+  switch (role)
+  {
+    case Qt::DisplayRole:
+    case Qt::ToolTipRole:
+      return line.m_sText;
+
+    case Qt::ForegroundRole:
+      if (line.m_Type == nsLogMsgType::ErrorMsg || line.m_Type == nsLogMsgType::SeriousWarningMsg)
+        return QColor(0xff, 0x6b, 0x6b);
+      if (line.m_Type == nsLogMsgType::WarningMsg)
+        return QColor(0xf0, 0xc0, 0x4a);
+      return {};
+
+    default:
+      return {};
+  }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QAbstractListModel>
+
+#include <Foundation/Containers/DynamicArray.h>
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Types/ArrayPtr.h>
+
+/// \brief One formatted line of the log view.
+struct LogLine
+{
+  QString m_sText;
+  nsLogMsgType::Enum m_Type = nsLogMsgType::None;
+};
+
+/// \brief Read-only list model over a capped ring of log lines.
+///
+/// Lines are appended in batches, each batch is a single row insertion. Once the ring is full the oldest lines are
+/// dropped in a single row removal, so neither floods of messages nor a long session make the view slower.
+class LogListModel : public QAbstractListModel
+{
+  Q_OBJECT
+
+public:
+  explicit LogListModel(nsUInt32 uiCapacity, QObject* parent = nullptr);
+  ~LogListModel() override;
+
+  /// \brief Moves the lines into the ring. Only the last GetCapacity() lines are kept if the batch is larger.
+  void AppendLines(nsArrayPtr<LogLine> lines);
+
+  nsUInt32 GetCapacity() const { return m_Lines.GetCount(); }
+
+  int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private:
+  const LogLine& GetLine(nsUInt32 uiRow) const { return m_Lines[(m_uiFirst + uiRow) % m_Lines.GetCount()]; }
+
+  nsDynamicArray<LogLine> m_Lines; ///< Ring storage, allocated for the full capacity up front.
+  nsUInt32 m_uiFirst = 0;          ///< Slot of the oldest line.
+  nsUInt32 m_uiCount = 0;
+};
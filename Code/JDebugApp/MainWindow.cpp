@@ -4,8 +4,12 @@
 #  include <Foundation/Platform/Win/Utils/IncludeWindows.h>
 #endif
 
+#include "BodyTableModel.h"
+#include "BookmarkDockWidget.h"
+#include "FrameProfileWidget.h"
 #include "JDebugViewportWidget.h"
 #include "LogDockWidget.h"
+#include "TimelineOverviewWidget.h"
 
 #include <QAbstractItemView>
 #include <QAction>
@@ -20,13 +24,13 @@
 #include <QLineEdit>
 #include <QMenuBar>
 #include <QMessageBox>
+#include <QProgressBar>
 #include <QPushButton>
 #include <QSizePolicy>
 #include <QSlider>
 #include <QStringList>
 #include <QStatusBar>
-#include <QTableWidget>
-#include <QTableWidgetItem>
+#include <QTableView>
 #include <QTimer>
 #include <QToolBar>
 #include <QVBoxLayout>
@@ -58,13 +62,25 @@ MainWindow::MainWindow(QWidget* parent)
   m_RecordSettings.m_TargetFrameInterval = nsTime::MakeFromSeconds(1.0 / s_fDefaultPlaybackFps);
   m_RecordSettings.m_bCaptureSleepingBodies = true;
   m_RecordSettings.m_bRecordVelocities = true;
+  m_RecordSettings.m_bDetectAnomalies = true;
 
   InitializeUi();
 
   m_PlaybackTimer = new QTimer(this);
   m_PlaybackTimer->setInterval(static_cast<int>(1000.0 / s_fDefaultPlaybackFps));
+  m_PlaybackTimer->setTimerType(Qt::PreciseTimer);
   connect(m_PlaybackTimer, &QTimer::timeout, this, &MainWindow::OnPlaybackTick);
 
+  // delivers the frames the session received
+  m_SessionTimer = new QTimer(this);
+  m_SessionTimer->setInterval(5);
+  connect(m_SessionTimer, &QTimer::timeout, this, &MainWindow::OnSessionTick);
+
+  // hands the decoded blocks of a clip that is loading to the views
+  m_ClipLoadTimer = new QTimer(this);
+  m_ClipLoadTimer->setInterval(16);
+  connect(m_ClipLoadTimer, &QTimer::timeout, this, &MainWindow::OnClipLoadTick);
+
   UpdateTimelineControls();
   UpdateStatusBar();
 }
@@ -72,6 +88,7 @@ MainWindow::MainWindow(QWidget* parent)
 MainWindow::~MainWindow()
 {
   OnSessionDisconnect();
+  StopClipLoad();
 }
 
 void MainWindow::InitializeUi()
@@ -91,6 +108,10 @@ void MainWindow::InitializeUi()
   m_ViewportWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
   centralLayout->addWidget(m_ViewportWidget, 2);
 
+  m_TimelineOverview = new TimelineOverviewWidget(this);
+  m_TimelineOverview->SetClip(&m_CurrentClip);
+  centralLayout->addWidget(m_TimelineOverview);
+
   auto* playbackLayout = new QHBoxLayout();
   playbackLayout->setContentsMargins(0, 0, 0, 0);
   playbackLayout->setSpacing(10);
@@ -118,18 +139,25 @@ void MainWindow::InitializeUi()
 
   centralLayout->addLayout(playbackLayout);
 
-  m_BodyTable = new QTableWidget(this);
-  m_BodyTable->setColumnCount(6);
-  QStringList headers;
-  headers << tr("Body ID") << tr("Position") << tr("Rotation") << tr("Linear Velocity") << tr("Angular Velocity") << tr("State");
-  m_BodyTable->setHorizontalHeaderLabels(headers);
+  m_BodyFilterEdit = new QLineEdit(this);
+  m_BodyFilterEdit->setPlaceholderText(tr("Filter by body ID"));
+  m_BodyFilterEdit->setClearButtonEnabled(true);
+  centralLayout->addWidget(m_BodyFilterEdit);
+
+  m_BodyTableModel = new BodyTableModel(this);
+  m_BodyTable = new QTableView(this);
+  m_BodyTable->setModel(m_BodyTableModel);
   m_BodyTable->horizontalHeader()->setStretchLastSection(true);
+  m_BodyTable->horizontalHeader()->setResizeContentsPrecision(64);
+  m_BodyTable->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
   m_BodyTable->verticalHeader()->setVisible(false);
+  m_BodyTable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
   m_BodyTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
   m_BodyTable->setSelectionBehavior(QAbstractItemView::SelectRows);
   m_BodyTable->setSelectionMode(QAbstractItemView::SingleSelection);
   m_BodyTable->setAlternatingRowColors(true);
   m_BodyTable->setShowGrid(false);
+  m_BodyTable->setSortingEnabled(true);
   m_BodyTable->horizontalHeader()->setDefaultAlignment(Qt::AlignLeft | Qt::AlignVCenter);
 
   centralLayout->addWidget(m_BodyTable, 1);
@@ -142,6 +170,8 @@ void MainWindow::InitializeUi()
   connect(m_RecordButton, &QPushButton::clicked, this, &MainWindow::OnToggleRecording);
   connect(m_RetryRendererButton, &QPushButton::clicked, this, &MainWindow::OnRetryRenderer);
   connect(m_TimeSlider, &QSlider::valueChanged, this, &MainWindow::OnTimelineChanged);
+  connect(m_BodyFilterEdit, &QLineEdit::textChanged, m_BodyTableModel, &BodyTableModel::SetIdFilter);
+  connect(m_TimelineOverview, &TimelineOverviewWidget::PositionRequested, m_TimeSlider, &QSlider::setValue);
 
   connect(m_ViewportWidget, &JDebugViewportWidget::RendererStateChanged, this, [this](bool /*initialized*/, bool bFailed) {
     if (!m_RetryRendererButton)
@@ -150,6 +180,8 @@ void MainWindow::InitializeUi()
     m_RetryRendererButton->setEnabled(bFailed);
   });
 
+  connect(m_ViewportWidget, &JDebugViewportWidget::BodyPicked, this, &MainWindow::OnBodyPicked);
+
   m_RetryRendererButton->setEnabled(m_ViewportWidget->HasRendererFailed());
 }
 
@@ -183,6 +215,36 @@ void MainWindow::CreateMenus()
 
   m_ViewMenu = menuBar()->addMenu(tr("&View"));
 
+  m_TrailsAction = m_ViewMenu->addAction(tr("Motion Trails"));
+  m_VelocityAction = m_ViewMenu->addAction(tr("Velocity Vectors"));
+  m_HeatmapAction = m_ViewMenu->addAction(tr("Heatmap"));
+  for (QAction* pAction : {m_TrailsAction, m_VelocityAction, m_HeatmapAction})
+  {
+    pAction->setCheckable(true);
+    connect(pAction, &QAction::toggled, this, &MainWindow::OnOverlaysChanged);
+  }
+  m_ViewMenu->addSeparator();
+
+  m_FrameSceneAction = m_ViewMenu->addAction(tr("Frame Scene"));
+  m_FrameSceneAction->setToolTip(tr("Moves the camera so that all bodies are visible (F in the viewport)"));
+  connect(m_FrameSceneAction, &QAction::triggered, this, [this]() {
+    if (m_ViewportWidget)
+    {
+      m_ViewportWidget->FrameScene();
+    }
+  });
+
+  m_FlyCameraAction = m_ViewMenu->addAction(tr("Fly Camera"));
+  m_FlyCameraAction->setCheckable(true);
+  m_FlyCameraAction->setToolTip(tr("Right mouse button looks around instead of orbiting the scene"));
+  connect(m_FlyCameraAction, &QAction::toggled, this, [this](bool bFly) {
+    if (m_ViewportWidget)
+    {
+      m_ViewportWidget->SetCameraMode(bFly ? JDebugViewportWidget::CameraMode::Fly : JDebugViewportWidget::CameraMode::Orbit);
+    }
+  });
+  m_ViewMenu->addSeparator();
+
   auto* helpMenu = menuBar()->addMenu(tr("&Help"));
   m_AboutAction = helpMenu->addAction(tr("&About"));
   connect(m_AboutAction, &QAction::triggered, this, [this]() {
@@ -229,10 +291,24 @@ void MainWindow::CreateDockWidgets()
   m_LogDockWidget->setMinimumHeight(160);
   addDockWidget(Qt::BottomDockWidgetArea, m_LogDockWidget);
 
+  m_BookmarkDockWidget = new BookmarkDockWidget(this);
+  m_BookmarkDockWidget->setObjectName(QStringLiteral("BookmarkDock"));
+  addDockWidget(Qt::RightDockWidgetArea, m_BookmarkDockWidget);
+  connect(m_BookmarkDockWidget, &BookmarkDockWidget::BookmarkActivated, this, &MainWindow::OnBookmarkActivated);
+
+  m_FrameProfileWidget = new FrameProfileWidget(this);
+  m_FrameProfileDock = new QDockWidget(tr("Frame Profile"), this);
+  m_FrameProfileDock->setObjectName(QStringLiteral("FrameProfileDock"));
+  m_FrameProfileDock->setAllowedAreas(Qt::BottomDockWidgetArea | Qt::TopDockWidgetArea);
+  m_FrameProfileDock->setWidget(m_FrameProfileWidget);
+  addDockWidget(Qt::BottomDockWidgetArea, m_FrameProfileDock);
+
   if (m_ViewMenu)
   {
     m_ViewMenu->addAction(m_GuidanceDock->toggleViewAction());
     m_ViewMenu->addAction(m_LogDockWidget->toggleViewAction());
+    m_ViewMenu->addAction(m_BookmarkDockWidget->toggleViewAction());
+    m_ViewMenu->addAction(m_FrameProfileDock->toggleViewAction());
   }
 }
 
@@ -240,6 +316,18 @@ void MainWindow::CreateStatusBar()
 {
   m_StatusLabel = new QLabel(this);
   statusBar()->addPermanentWidget(m_StatusLabel, 1);
+
+  m_ClipLoadProgressBar = new QProgressBar(this);
+  m_ClipLoadProgressBar->setRange(0, 100);
+  m_ClipLoadProgressBar->setMaximumWidth(200);
+  m_ClipLoadProgressBar->setVisible(false);
+  statusBar()->addPermanentWidget(m_ClipLoadProgressBar);
+
+  m_CancelClipLoadButton = new QPushButton(tr("Cancel"), this);
+  m_CancelClipLoadButton->setVisible(false);
+  connect(m_CancelClipLoadButton, &QPushButton::clicked, this, [this]()
+    { m_ClipLoadProgress.UserClickedCancel(); });
+  statusBar()->addPermanentWidget(m_CancelClipLoadButton);
 }
 
 void MainWindow::UpdateTimelineControls()
@@ -257,6 +345,12 @@ void MainWindow::UpdateTimelineControls()
   }
 
   m_SaveAction->setEnabled(frameCount > 0);
+
+  if (m_TimelineOverview)
+  {
+    m_TimelineOverview->SetCurrentPosition(m_TimeSlider->value());
+    m_TimelineOverview->update();
+  }
 }
 
 void MainWindow::UpdateStatusBar()
@@ -267,6 +361,19 @@ void MainWindow::UpdateStatusBar()
   QString durationInfo = tr("Duration: %1 s").arg(QString::number(duration.GetSeconds(), 'f', 2));
 
   QString status = tr("%1 | %2 | %3").arg(sessionState, framesInfo, durationInfo);
+
+  if (m_bIsPlaying)
+  {
+    const nsJvdPlaybackStats& stats = m_PlaybackController.GetStats();
+    const double fTickInterval = stats.m_AverageTickInterval.GetSeconds();
+    status += tr(" | Playback: %1 fps, %2 dropped").arg(fTickInterval > 0.0 ? 1.0 / fTickInterval : 0.0, 0, 'f', 1).arg(stats.m_uiDroppedFrames);
+  }
+
+  if (m_ViewportWidget && m_ViewportWidget->GetRenderedFrameCount() > 0)
+  {
+    status += tr(" | Render: %1 ms").arg(m_ViewportWidget->GetLastRenderDuration().GetMilliseconds(), 0, 'f', 2);
+  }
+
   m_StatusLabel->setText(status);
 }
 
@@ -276,15 +383,83 @@ void MainWindow::OnOpenRecording()
   if (path.isEmpty())
     return;
 
-  nsJvdClip clip;
-  if (nsJvdSerialization::LoadClipFromFile(path.toStdString().c_str(), clip).Failed())
+  StopClipLoad();
+
+  if (m_ClipLoader.Start(path.toStdString().c_str(), &m_ClipLoadProgress).Failed())
   {
     QMessageBox::critical(this, tr("Failed to open"), tr("Unable to load recording from %1").arg(path));
     return;
   }
 
-  SetClip(std::move(clip));
+  // the frames arrive block by block, OnClipLoadTick() shows the clip as soon as the first block is decoded
+  ShowClip(nsJvdClip());
+
+  m_ClipLoadProgressBar->setValue(0);
+  m_ClipLoadProgressBar->setVisible(true);
+  m_CancelClipLoadButton->setVisible(true);
+  m_ClipLoadTimer->start();
+}
+
+void MainWindow::OnClipLoadTick()
+{
+  const bool bHadFrames = !m_CurrentClip.IsEmpty();
+
+  if (m_ClipLoader.Update(m_CurrentClip) > 0)
+  {
+    if (bHadFrames)
+    {
+      UpdateTimelineControls();
+      UpdateStatusBar();
+    }
+    else
+    {
+      ShowClip(std::move(m_CurrentClip));
+    }
+  }
+
+  m_ClipLoadProgressBar->setValue(static_cast<int>(m_ClipLoadProgress.GetCompletion() * 100.0f));
+
+  if (m_ClipLoader.IsLoading())
+    return;
+
+  m_ClipLoadTimer->stop();
+  m_ClipLoadProgressBar->setVisible(false);
+  m_CancelClipLoadButton->setVisible(false);
+
+  // bookmarks and profiling data are complete only now
+  if (m_BookmarkDockWidget)
+  {
+    m_BookmarkDockWidget->SetBookmarks(m_CurrentClip.GetBookmarks());
+  }
+  UpdateFrameProfile(m_CurrentFrame);
+  UpdateTimelineControls();
   UpdateStatusBar();
+
+  const QString path = QString::fromUtf8(m_ClipLoader.GetFilePath().GetData());
+  if (m_ClipLoader.GetState() == nsJvdClipLoadState::Failed)
+  {
+    QMessageBox::critical(this, tr("Failed to open"), tr("Unable to load recording from %1").arg(path));
+  }
+  else if (m_ClipLoader.GetState() == nsJvdClipLoadState::Canceled)
+  {
+    nsLog::Info("Stopped loading '{0}' after {1} frames", m_ClipLoader.GetFilePath(), m_CurrentClip.GetFrames().GetCount());
+  }
+}
+
+void MainWindow::StopClipLoad()
+{
+  if (!m_ClipLoader.IsLoading())
+    return;
+
+  m_ClipLoader.Cancel();
+
+  // the frames of the canceled load are dropped with the clip that replaces it
+  nsJvdClip discarded;
+  m_ClipLoader.Wait(discarded).IgnoreResult();
+
+  m_ClipLoadTimer->stop();
+  m_ClipLoadProgressBar->setVisible(false);
+  m_CancelClipLoadButton->setVisible(false);
 }
 
 void MainWindow::OnSaveRecording()
@@ -324,24 +499,16 @@ void MainWindow::OnPlayPause()
   if (m_bIsPlaying)
   {
     const nsDynamicArray<nsJvdFrame>& frames = m_CurrentClip.GetFrames();
-    const nsTime sampleInterval = m_CurrentClip.GetSampleInterval();
     nsTime startTime = nsTime::MakeZero();
     const int index = m_TimeSlider->value();
-    if (index >= 0 && index < static_cast<int>(frames.GetCount()))
+    if (index >= 0 && index < static_cast<int>(frames.GetCount()) - 1)
     {
       startTime = frames[index].m_Timestamp;
-      if (sampleInterval.IsPositive() && startTime >= sampleInterval)
-      {
-        startTime -= sampleInterval;
-      }
-      else
-      {
-        startTime = nsTime::MakeZero();
-      }
     }
 
     m_PlaybackController.LoadClip(m_CurrentClip);
     m_PlaybackController.SetPlaybackPosition(startTime);
+    m_PlaybackController.StartPresenting();
     m_PlaybackTimer->start();
   }
   else
@@ -366,7 +533,9 @@ void MainWindow::OnStopPlayback()
     m_TimeSlider->blockSignals(true);
     m_TimeSlider->setValue(0);
     m_TimeSlider->blockSignals(false);
-    UpdateBodyTable(frame);
+    m_TimelineOverview->SetCurrentPosition(0);
+    UpdateBodyTable();
+    UpdateFrameProfile(m_CurrentFrame);
   }
 }
 
@@ -380,7 +549,13 @@ void MainWindow::OnTimelineChanged(int value)
     return;
 
   m_CurrentFrame = frames[value];
-  UpdateBodyTable(m_CurrentFrame);
+  UpdateBodyTable();
+  UpdateFrameProfile(m_CurrentFrame);
+
+  if (m_TimelineOverview)
+  {
+    m_TimelineOverview->SetCurrentPosition(value);
+  }
 }
 
 void MainWindow::OnSessionConnect()
@@ -389,6 +564,8 @@ void MainWindow::OnSessionConnect()
   if (cfg.m_sEndpoint.IsEmpty())
     return;
 
+  StopClipLoad();
+
   if (m_Session.Initialize(cfg).Failed())
   {
     QMessageBox::critical(this, tr("Connection failed"), tr("Unable to connect to %1:%2")
@@ -397,6 +574,7 @@ void MainWindow::OnSessionConnect()
   }
 
   ConnectSessionHandlers();
+  m_SessionTimer->start();
   m_ConnectAction->setEnabled(false);
   m_DisconnectAction->setEnabled(true);
   UpdateStatusBar();
@@ -404,6 +582,7 @@ void MainWindow::OnSessionConnect()
 
 void MainWindow::OnSessionDisconnect()
 {
+  m_SessionTimer->stop();
   DisconnectSessionHandlers();
   m_Session.Shutdown();
   m_ConnectAction->setEnabled(true);
@@ -411,37 +590,64 @@ void MainWindow::OnSessionDisconnect()
   UpdateStatusBar();
 }
 
+void MainWindow::OnSessionTick()
+{
+  m_Session.Update();
+}
+
 void MainWindow::OnPlaybackTick()
 {
   if (m_CurrentClip.IsEmpty())
     return;
 
-  nsTime delta = m_CurrentClip.GetSampleInterval();
-  if (!delta.IsPositive())
+  // the controller follows the wall clock, ticks that come late skip frames instead of slowing playback down
+  const nsJvdFrame* pFrame = m_PlaybackController.Present();
+  if (pFrame != nullptr)
   {
-    delta = nsTime::MakeFromSeconds(1.0 / s_fDefaultPlaybackFps);
-  }
+    m_CurrentFrame = *pFrame;
+    UpdateBodyTable();
+    UpdateFrameProfile(m_CurrentFrame);
 
-  nsJvdFrame frame;
-  if (!m_PlaybackController.Step(delta, frame))
-  {
-    if (!m_PlaybackController.GetLoop())
+    const int index = static_cast<int>(pFrame->m_uiFrameIndex);
+    if (index >= 0 && index <= m_TimeSlider->maximum())
     {
-      OnStopPlayback();
+      m_TimeSlider->blockSignals(true);
+      m_TimeSlider->setValue(index);
+      m_TimeSlider->blockSignals(false);
+
+      if (m_TimelineOverview)
+      {
+        m_TimelineOverview->SetCurrentPosition(index);
+      }
     }
-    return;
+
+    UpdateStatusBar();
   }
 
-  m_CurrentFrame = frame;
-  UpdateBodyTable(m_CurrentFrame);
+  if (m_PlaybackController.IsAtEnd())
+  {
+    // keep the last frame on screen
+    m_bIsPlaying = false;
+    m_PlayButton->setText(tr("Play"));
+    m_PlaybackTimer->stop();
+    UpdateStatusBar();
+  }
+}
+
+void MainWindow::OnBookmarkActivated(quint64 frameIndex)
+{
+  const nsJvdFrame* pFrame = m_CurrentClip.FindFrame(frameIndex);
+  if (pFrame == nullptr)
+    return;
 
-  const int index = static_cast<int>(frame.m_uiFrameIndex);
-  if (index >= 0 && index <= m_TimeSlider->maximum())
+  if (m_bIsPlaying)
   {
-    m_TimeSlider->blockSignals(true);
-    m_TimeSlider->setValue(index);
-    m_TimeSlider->blockSignals(false);
+    OnPlayPause();
   }
+
+  // the slider addresses frames by their position in the clip, not by their frame index
+  const int index = static_cast<int>(pFrame - m_CurrentClip.GetFrames().GetData());
+  m_TimeSlider->setValue(index);
 }
 
 void MainWindow::OnToggleRecording()
@@ -477,49 +683,88 @@ void MainWindow::OnRetryRenderer()
   }
 }
 
-void MainWindow::UpdateBodyTable(const nsJvdFrame& frame)
+void MainWindow::OnOverlaysChanged()
 {
-  const nsUInt32 count = frame.m_Bodies.GetCount();
-  m_BodyTable->setRowCount(static_cast<int>(count));
+  if (!m_ViewportWidget)
+    return;
+
+  nsBitflags<nsVulkanOverlay> overlays;
+  overlays.AddOrRemove(nsVulkanOverlay::Trails, m_TrailsAction->isChecked());
+  overlays.AddOrRemove(nsVulkanOverlay::Velocity, m_VelocityAction->isChecked());
+  overlays.AddOrRemove(nsVulkanOverlay::Heatmap, m_HeatmapAction->isChecked());
+  m_ViewportWidget->SetOverlays(overlays);
+}
 
-  for (nsUInt32 i = 0; i < count; ++i)
+void MainWindow::OnBodyPicked(int iBodyIndex)
+{
+  const int iRow = iBodyIndex >= 0 ? m_BodyTableModel->GetRowOfBody(static_cast<nsUInt32>(iBodyIndex)) : -1;
+  if (iRow < 0)
   {
-    const nsJvdBodyState& state = frame.m_Bodies[i];
+    m_BodyTable->clearSelection();
+    return;
+  }
 
-    auto setItem = [this, i](int column, const QString& text) {
-      auto* item = new QTableWidgetItem(text);
-      item->setFlags(item->flags() ^ Qt::ItemIsEditable);
-      m_BodyTable->setItem(static_cast<int>(i), column, item);
-    };
+  m_BodyTable->selectRow(iRow);
+  m_BodyTable->scrollTo(m_BodyTableModel->index(iRow, 0));
+}
 
-    setItem(0, QString::number(static_cast<qulonglong>(state.m_uiBodyId)));
-    setItem(1, QStringLiteral("%1, %2, %3").arg(state.m_vPosition.x, 0, 'f', 2).arg(state.m_vPosition.y, 0, 'f', 2).arg(state.m_vPosition.z, 0, 'f', 2));
-    setItem(2, QStringLiteral("%1, %2, %3, %4")
-                 .arg(state.m_qRotation.x, 0, 'f', 2)
-                 .arg(state.m_qRotation.y, 0, 'f', 2)
-                 .arg(state.m_qRotation.z, 0, 'f', 2)
-                 .arg(state.m_qRotation.w, 0, 'f', 2));
-    setItem(3, QStringLiteral("%1, %2, %3").arg(state.m_vLinearVelocity.x, 0, 'f', 2).arg(state.m_vLinearVelocity.y, 0, 'f', 2).arg(state.m_vLinearVelocity.z, 0, 'f', 2));
-    setItem(4, QStringLiteral("%1, %2, %3").arg(state.m_vAngularVelocity.x, 0, 'f', 2).arg(state.m_vAngularVelocity.y, 0, 'f', 2).arg(state.m_vAngularVelocity.z, 0, 'f', 2));
+void MainWindow::UpdateBodyTable()
+{
+  const nsJvdFrame& frame = m_CurrentFrame;
 
-    const QString stateLabel = state.m_bIsSleeping ? tr("Sleeping") : tr("Active");
-    setItem(5, stateLabel);
+  // the model reads straight from the current frame, only the visible rows are formatted again
+  if (m_BodyTableModel->SetFrame(&m_CurrentFrame))
+  {
+    m_BodyTable->resizeColumnsToContents();
+  }
+  else
+  {
+    const int iFirstRow = m_BodyTable->rowAt(0);
+    const int iLastRow = m_BodyTable->rowAt(m_BodyTable->viewport()->height() - 1);
+    m_BodyTableModel->RefreshRows(iFirstRow, iLastRow >= 0 ? iLastRow : m_BodyTableModel->rowCount() - 1);
   }
-
-  m_BodyTable->resizeColumnsToContents();
 
   if (m_ViewportWidget)
   {
-    m_ViewportWidget->DisplayFrame(frame);
+    // the timeline summary already holds the bounds of every frame of the clip
+    const nsJvdTimelineSummary& summary = m_CurrentClip.GetTimelineSummary();
+    const nsUInt32 uiPosition = nsJvdTimelineSummary::FindFramePosition(m_CurrentClip.GetFrames(), frame.m_uiFrameIndex);
+    const nsBoundingBox bounds = uiPosition < summary.GetFrameCount() ? summary.Query(uiPosition, 1).m_Bounds : nsJvdTimelineBucket::MakeFromFrame(frame).m_Bounds;
+
+    m_ViewportWidget->DisplayFrame(frame, bounds);
   }
 }
 
+void MainWindow::UpdateFrameProfile(const nsJvdFrame& frame)
+{
+  if (m_FrameProfileWidget == nullptr)
+    return;
+
+  const nsJvdProfilingData& profiling = m_CurrentClip.GetProfiling();
+  m_FrameProfileWidget->SetProfile(&profiling, profiling.FindFrame(frame.m_uiFrameIndex));
+}
+
 void MainWindow::SetClip(nsJvdClip clip)
+{
+  // any other clip replaces the one that is loading
+  StopClipLoad();
+  ShowClip(std::move(clip));
+}
+
+void MainWindow::ShowClip(nsJvdClip clip)
 {
   m_CurrentClip = std::move(clip);
+  m_CurrentClip.UpdateTimelineSummary();
   m_PlaybackController.LoadClip(m_CurrentClip);
   m_PlaybackController.Reset();
 
+  if (m_ViewportWidget)
+  {
+    // also drops the motion history of the previous clip
+    m_ViewportWidget->SetHistorySource(&m_CurrentClip);
+    m_ViewportWidget->FrameScene();
+  }
+
   m_bIsPlaying = false;
   if (m_PlaybackTimer)
   {
@@ -533,23 +778,27 @@ void MainWindow::SetClip(nsJvdClip clip)
   UpdateTimelineControls();
   UpdateStatusBar();
 
+  if (m_BookmarkDockWidget)
+  {
+    m_BookmarkDockWidget->SetBookmarks(m_CurrentClip.GetBookmarks());
+  }
+
   if (!m_CurrentClip.IsEmpty())
   {
     const nsJvdFrame& firstFrame = m_CurrentClip.GetFrames()[0];
     m_TimeSlider->blockSignals(true);
     m_TimeSlider->setValue(0);
     m_TimeSlider->blockSignals(false);
-    UpdateBodyTable(firstFrame);
+    m_TimelineOverview->SetCurrentPosition(0);
     m_CurrentFrame = firstFrame;
+    UpdateBodyTable();
+    UpdateFrameProfile(m_CurrentFrame);
   }
   else
   {
     m_CurrentFrame = nsJvdFrame();
-    m_BodyTable->setRowCount(0);
-    if (m_ViewportWidget)
-    {
-      m_ViewportWidget->DisplayFrame(m_CurrentFrame);
-    }
+    UpdateBodyTable();
+    UpdateFrameProfile(m_CurrentFrame);
   }
 }
 
@@ -557,8 +806,7 @@ void MainWindow::AppendLiveFrame(const nsJvdFrame& frame)
 {
   if (m_bRecordingLive)
   {
-    nsArrayPtr<const nsJvdBodyState> states(frame.m_Bodies.GetData(), frame.m_Bodies.GetCount());
-    m_Recorder.AppendFrame(frame.m_Timestamp, states);
+    m_Recorder.AppendFrame(frame);
   }
 
   m_CurrentFrame = frame;
@@ -576,7 +824,8 @@ void MainWindow::AppendLiveFrame(const nsJvdFrame& frame)
     UpdateTimelineControls();
   }
 
-  UpdateBodyTable(frame);
+  UpdateBodyTable();
+  UpdateFrameProfile(m_CurrentFrame);
 
   if (!m_CurrentClip.IsEmpty())
   {
@@ -584,6 +833,11 @@ void MainWindow::AppendLiveFrame(const nsJvdFrame& frame)
     m_TimeSlider->blockSignals(true);
     m_TimeSlider->setValue(lastIndex);
     m_TimeSlider->blockSignals(false);
+
+    if (m_TimelineOverview)
+    {
+      m_TimelineOverview->SetCurrentPosition(lastIndex);
+    }
   }
 }
 
@@ -682,6 +936,24 @@ nsJvdSessionConfiguration MainWindow::PromptSessionConfiguration()
   const QByteArray hostUtf8 = host.toUtf8();
   cfg.m_sEndpoint = hostUtf8.constData();
   cfg.m_uiPort = static_cast<nsUInt16>(port);
+
+  if (host.compare(QStringLiteral("localhost"), Qt::CaseInsensitive) == 0 || host == QStringLiteral("127.0.0.1"))
+  {
+    // the game has to use the same transport
+    const QStringList transports = {tr("Network"), tr("Shared memory")};
+    const QString transport = QInputDialog::getItem(this, tr("Connect to Session"), tr("Transport"), transports, 0, false, &ok);
+    if (!ok)
+    {
+      cfg.m_sEndpoint.Clear();
+      return cfg;
+    }
+
+    if (transport == transports[1])
+    {
+      cfg.m_Transport = nsJvdTransport::SharedMemory;
+    }
+  }
+
   return cfg;
 }
 
@@ -699,6 +971,7 @@ QString MainWindow::PromptRecordingPath(bool bSave)
   }
   else
   {
+    filter = tr("JDebug Recordings (*.jvdrec *.jvdsim)");
     return QFileDialog::getOpenFileName(this, tr("Open Recording"), QString(), filter);
   }
 }
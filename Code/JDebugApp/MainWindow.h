@@ -4,16 +4,24 @@
 
 #include <JVDSDK/JVDSDK.h>
 
+#include <Foundation/Utilities/Progress.h>
+
 class QTimer;
 class QSlider;
 class QLabel;
-class QTableWidget;
+class QTableView;
+class QLineEdit;
 class QPushButton;
+class QProgressBar;
 class QAction;
 class QMenu;
 class QDockWidget;
 class JDebugViewportWidget;
 class LogDockWidget;
+class BookmarkDockWidget;
+class BodyTableModel;
+class TimelineOverviewWidget;
+class FrameProfileWidget;
 
 class MainWindow : public QMainWindow
 {
@@ -33,8 +41,13 @@ private slots:
   void OnSessionConnect();
   void OnSessionDisconnect();
   void OnPlaybackTick();
+  void OnSessionTick();
+  void OnClipLoadTick();
   void OnToggleRecording();
   void OnRetryRenderer();
+  void OnBookmarkActivated(quint64 frameIndex);
+  void OnOverlaysChanged();
+  void OnBodyPicked(int iBodyIndex);
 
 private:
   void InitializeUi();
@@ -45,10 +58,14 @@ private:
   nsJvdClip CreateSampleClip() const;
   void UpdateTimelineControls();
   void UpdateStatusBar();
-  void UpdateBodyTable(const nsJvdFrame& frame);
+  void UpdateBodyTable();
+  void UpdateFrameProfile(const nsJvdFrame& frame);
   void SetClip(nsJvdClip clip);
+  /// Like SetClip(), but keeps a running clip load going, for the clip that load fills.
+  void ShowClip(nsJvdClip clip);
   void AppendLiveFrame(const nsJvdFrame& frame);
   void ReplaceClip(const nsJvdClip& clip);
+  void StopClipLoad();
 
   void ConnectSessionHandlers();
   void DisconnectSessionHandlers();
@@ -63,19 +80,31 @@ private:
   nsJvdRecordingSettings m_RecordSettings;
   nsJvdClipMetadata m_LiveMetadata;
   nsJvdFrame m_CurrentFrame;
+  nsJvdClipLoader m_ClipLoader;
+  nsProgress m_ClipLoadProgress;
 
   nsEvent<const nsJvdFrame&, nsMutex>::Handler m_SessionFrameHandler;
   nsEvent<const nsJvdClip&, nsMutex>::Handler m_SessionClipHandler;
 
   QTimer* m_PlaybackTimer = nullptr;
+  QTimer* m_SessionTimer = nullptr;
+  QTimer* m_ClipLoadTimer = nullptr;
   QSlider* m_TimeSlider = nullptr;
+  TimelineOverviewWidget* m_TimelineOverview = nullptr;
   QLabel* m_StatusLabel = nullptr;
-  QTableWidget* m_BodyTable = nullptr;
+  QProgressBar* m_ClipLoadProgressBar = nullptr;
+  QPushButton* m_CancelClipLoadButton = nullptr;
+  QTableView* m_BodyTable = nullptr;
+  BodyTableModel* m_BodyTableModel = nullptr;
+  QLineEdit* m_BodyFilterEdit = nullptr;
   QPushButton* m_PlayButton = nullptr;
   QPushButton* m_RecordButton = nullptr;
   QPushButton* m_RetryRendererButton = nullptr;
   JDebugViewportWidget* m_ViewportWidget = nullptr;
   LogDockWidget* m_LogDockWidget = nullptr;
+  BookmarkDockWidget* m_BookmarkDockWidget = nullptr;
+  FrameProfileWidget* m_FrameProfileWidget = nullptr;
+  QDockWidget* m_FrameProfileDock = nullptr;
   QDockWidget* m_GuidanceDock = nullptr;
   QMenu* m_ViewMenu = nullptr;
 
@@ -86,6 +115,11 @@ private:
   QAction* m_DisconnectAction = nullptr;
   QAction* m_ExitAction = nullptr;
   QAction* m_AboutAction = nullptr;
+  QAction* m_TrailsAction = nullptr;
+  QAction* m_VelocityAction = nullptr;
+  QAction* m_HeatmapAction = nullptr;
+  QAction* m_FrameSceneAction = nullptr;
+  QAction* m_FlyCameraAction = nullptr;
 
   bool m_bIsPlaying = false;
   bool m_bRecordingLive = false;
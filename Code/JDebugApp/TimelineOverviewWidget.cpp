@@ -0,0 +1,146 @@
+#include "TimelineOverviewWidget.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPainterPath>
+
+#include <Foundation/Math/Math.h>
+
+TimelineOverviewWidget::TimelineOverviewWidget(QWidget* parent)
+  : QWidget(parent)
+{
+  setObjectName(QStringLiteral("TimelineOverviewWidget"));
+  setFixedHeight(48);
+  setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+  setToolTip(tr("Clip overview: awake bodies (bars), kinetic energy (line) and bookmarked anomalies (red). Click to jump."));
+}
+
+TimelineOverviewWidget::~TimelineOverviewWidget() = default;
+
+void TimelineOverviewWidget::SetClip(const nsJvdClip* pClip)
+{
+  m_pClip = pClip;
+  m_iCurrentPosition = 0;
+  update();
+}
+
+void TimelineOverviewWidget::SetCurrentPosition(int iPosition)
+{
+  if (m_iCurrentPosition == iPosition)
+    return;
+
+  m_iCurrentPosition = iPosition;
+  update();
+}
+
+void TimelineOverviewWidget::paintEvent(QPaintEvent* /*event*/)
+{
+  QPainter painter(this);
+  painter.fillRect(rect(), palette().base());
+
+  if (m_pClip == nullptr)
+    return;
+
+  const nsJvdTimelineSummary& summary = m_pClip->GetTimelineSummary();
+  const nsUInt32 uiFrameCount = summary.GetFrameCount();
+  const int iWidth = width();
+  const int iHeight = height();
+  if (uiFrameCount == 0 || iWidth <= 0)
+    return;
+
+  m_Samples.SetCount(static_cast<nsUInt32>(iWidth));
+  summary.Sample(0, uiFrameCount, m_Samples);
+
+  nsUInt32 uiMaxBodies = 1;
+  float fMaxEnergy = 0.0f;
+  for (const nsJvdTimelineBucket& sample : m_Samples)
+  {
+    uiMaxBodies = nsMath::Max(uiMaxBodies, sample.m_uiMaxActiveBodies);
+    fMaxEnergy = nsMath::Max(fMaxEnergy, sample.m_fMaxKineticEnergy);
+  }
+
+  // leave room for the anomaly ticks at the top
+  const int iTickHeight = 6;
+  const float fGraphHeight = static_cast<float>(iHeight - iTickHeight);
+
+  const QColor bodyColor = palette().highlight().color().lighter(140);
+  const QColor anomalyColor(220, 60, 50);
+
+  QPainterPath energyPath;
+  for (int x = 0; x < iWidth; ++x)
+  {
+    const nsJvdTimelineBucket& sample = m_Samples[x];
+
+    const int iBarHeight = static_cast<int>(fGraphHeight * sample.m_uiMaxActiveBodies / uiMaxBodies);
+    if (iBarHeight > 0)
+    {
+      painter.fillRect(x, iHeight - iBarHeight, 1, iBarHeight, bodyColor);
+    }
+
+    if (sample.m_uiAnomalyMask != 0)
+    {
+      painter.fillRect(x, 0, 1, iTickHeight, anomalyColor);
+    }
+
+    const float fEnergy = fMaxEnergy > 0.0f ? sample.m_fMaxKineticEnergy / fMaxEnergy : 0.0f;
+    const QPointF point(x + 0.5, iHeight - fEnergy * fGraphHeight);
+    if (x == 0)
+    {
+      energyPath.moveTo(point);
+    }
+    else
+    {
+      energyPath.lineTo(point);
+    }
+  }
+
+  painter.setPen(QPen(palette().text().color(), 1.0));
+  painter.drawPath(energyPath);
+
+  if (uiFrameCount > 1)
+  {
+    const int iMarkerX = static_cast<int>(static_cast<qint64>(m_iCurrentPosition) * (iWidth - 1) / (uiFrameCount - 1));
+    painter.setPen(QPen(palette().highlight().color(), 2.0));
+    painter.drawLine(iMarkerX, 0, iMarkerX, iHeight);
+  }
+}
+
+void TimelineOverviewWidget::mousePressEvent(QMouseEvent* event)
+{
+  if (event->button() != Qt::LeftButton)
+  {
+    QWidget::mousePressEvent(event);
+    return;
+  }
+
+  const int iPosition = GetPositionAt(static_cast<int>(event->position().x()));
+  if (iPosition >= 0)
+  {
+    emit PositionRequested(iPosition);
+  }
+}
+
+void TimelineOverviewWidget::mouseMoveEvent(QMouseEvent* event)
+{
+  if ((event->buttons() & Qt::LeftButton) == 0)
+  {
+    QWidget::mouseMoveEvent(event);
+    return;
+  }
+
+  const int iPosition = GetPositionAt(static_cast<int>(event->position().x()));
+  if (iPosition >= 0)
+  {
+    emit PositionRequested(iPosition);
+  }
+}
+
+int TimelineOverviewWidget::GetPositionAt(int iPixelX) const
+{
+  if (m_pClip == nullptr || m_pClip->IsEmpty() || width() <= 1)
+    return -1;
+
+  const qint64 iLastPosition = static_cast<qint64>(m_pClip->GetFrames().GetCount()) - 1;
+  const qint64 iX = nsMath::Clamp<qint64>(iPixelX, 0, width() - 1);
+  return static_cast<int>((iX * iLastPosition + (width() - 1) / 2) / (width() - 1));
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QWidget>
+
+#include <JVDSDK/Recording/JvdRecordingTypes.h>
+
+/// \brief Strip above the time slider that shows the whole clip at once: awake bodies, kinetic energy and anomalies.
+///
+/// Every pixel column queries the clip's nsJvdTimelineSummary, so painting costs the same for any clip length.
+class TimelineOverviewWidget : public QWidget
+{
+  Q_OBJECT
+
+public:
+  explicit TimelineOverviewWidget(QWidget* parent = nullptr);
+  ~TimelineOverviewWidget() override;
+
+  /// \brief The clip must stay alive while it is set and its timeline summary must be up to date.
+  void SetClip(const nsJvdClip* pClip);
+
+  /// \brief Position of the current frame in the clip, drawn as a marker.
+  void SetCurrentPosition(int iPosition);
+
+signals:
+  void PositionRequested(int iPosition);
+
+protected:
+  void paintEvent(QPaintEvent* event) override;
+  void mousePressEvent(QMouseEvent* event) override;
+  void mouseMoveEvent(QMouseEvent* event) override;
+
+private:
+  int GetPositionAt(int iPixelX) const;
+
+  const nsJvdClip* m_pClip = nullptr;
+  int m_iCurrentPosition = 0;
+  nsDynamicArray<nsJvdTimelineBucket> m_Samples;
+};
@@ -0,0 +1,601 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Analysis/JvdClipDiff.h>
+#include <JVDSDK/Serialization/JvdFileIO.h>
+
+#include <Foundation/Containers/HashTable.h>
+#include <Foundation/Memory/MemoryUtils.h>
+#include <Foundation/SimdMath/SimdMath.h>
+#include <Foundation/SimdMath/SimdVec4b.h>
+#include <Foundation/SimdMath/SimdVec4f.h>
+#include <Foundation/Threading/TaskSystem.h>
+
+void nsJvdClipDiffResult::Clear()
+{
+  *this = nsJvdClipDiffResult();
+}
+
+namespace
+{
+  /// Frames of one clip, either borrowed from a loaded clip or decoded batch-wise from a file.
+  class nsJvdDiffFrameSource
+  {
+  public:
+    explicit nsJvdDiffFrameSource(const nsJvdClip& clip)
+      : m_pClip(&clip)
+    {
+    }
+
+    explicit nsJvdDiffFrameSource(nsJvdClipReader& reader)
+      : m_pReader(&reader)
+    {
+    }
+
+    bool IsStreaming() const { return m_pReader != nullptr; }
+
+    /// Makes sure that uiBatchSize frames are pending, unless the clip ends before that.
+    nsResult Refill(nsUInt32 uiBatchSize)
+    {
+      if (m_pClip != nullptr)
+      {
+        m_uiCount = nsMath::Min(uiBatchSize, m_pClip->GetFrames().GetCount() - m_uiFirst);
+        return NS_SUCCESS;
+      }
+
+      // move the pending frames to the front, the consumed ones get reused for decoding
+      if (m_uiFirst > 0)
+      {
+        for (nsUInt32 i = 0; i < m_uiCount; ++i)
+        {
+          nsMath::Swap(m_Frames[i], m_Frames[m_uiFirst + i]);
+        }
+
+        m_uiFirst = 0;
+      }
+
+      if (m_Frames.GetCount() < uiBatchSize)
+      {
+        m_Frames.SetCount(uiBatchSize);
+      }
+
+      while (m_uiCount < uiBatchSize && m_pReader->HasMoreFrames())
+      {
+        NS_SUCCEED_OR_RETURN(m_pReader->ReadNextFrame(m_Frames[m_uiCount]));
+        ++m_uiCount;
+      }
+
+      return NS_SUCCESS;
+    }
+
+    nsUInt32 GetCount() const { return m_uiCount; }
+
+    const nsJvdFrame& GetFrame(nsUInt32 uiIndex) const
+    {
+      return m_pClip != nullptr ? m_pClip->GetFrames()[m_uiFirst + uiIndex] : m_Frames[m_uiFirst + uiIndex];
+    }
+
+    void Consume(nsUInt32 uiCount)
+    {
+      m_uiFirst += uiCount;
+      m_uiCount -= uiCount;
+    }
+
+    /// Whether there are frames beyond the pending ones.
+    bool HasMoreFrames() const
+    {
+      return m_pClip != nullptr ? m_uiFirst + m_uiCount < m_pClip->GetFrames().GetCount() : m_pReader->HasMoreFrames();
+    }
+
+  private:
+    const nsJvdClip* m_pClip = nullptr;
+    nsJvdClipReader* m_pReader = nullptr;
+    nsDynamicArray<nsJvdFrame> m_Frames;
+    nsUInt32 m_uiFirst = 0;
+    nsUInt32 m_uiCount = 0;
+  };
+
+  /// Per frame pair state, every pair of a batch is compared by its own task.
+  struct nsJvdDiffFramePair
+  {
+    enum Column
+    {
+      PosXA,
+      PosYA,
+      PosZA,
+      RotXA,
+      RotYA,
+      RotZA,
+      RotWA,
+      PosXB,
+      PosYB,
+      PosZB,
+      RotXB,
+      RotYB,
+      RotZB,
+      RotWB,
+
+      ColumnCount
+    };
+
+    const nsJvdFrame* m_pFrameA = nullptr;
+    const nsJvdFrame* m_pFrameB = nullptr;
+
+    nsDynamicArray<nsUInt32> m_MatchedBodiesB; ///< For every matched body in frame A, the index of its partner in frame B.
+    nsDynamicArray<nsUInt64> m_MatchedIds;
+    nsDynamicArray<float> m_Columns;
+    nsDynamicArray<float> m_PositionErrors;
+    nsDynamicArray<float> m_RotationErrors;
+    nsHashTable<nsUInt64, nsUInt32> m_LookupB;
+
+    nsJvdClipDiffFrameError m_Error;
+  };
+
+  void MatchBodies(nsJvdDiffFramePair& ref_pair)
+  {
+    const nsDynamicArray<nsJvdBodyState>& bodiesA = ref_pair.m_pFrameA->m_Bodies;
+    const nsDynamicArray<nsJvdBodyState>& bodiesB = ref_pair.m_pFrameB->m_Bodies;
+
+    ref_pair.m_MatchedBodiesB.Clear();
+    ref_pair.m_MatchedIds.Clear();
+    bool bLookupBuilt = false;
+
+    for (nsUInt32 i = 0; i < bodiesA.GetCount(); ++i)
+    {
+      const nsUInt64 uiBodyId = bodiesA[i].m_uiBodyId;
+      nsUInt32 uiIndexB = nsInvalidIndex;
+
+      // deterministic runs usually report bodies in the same order, only fall back to the lookup table if they do not
+      if (i < bodiesB.GetCount() && bodiesB[i].m_uiBodyId == uiBodyId)
+      {
+        uiIndexB = i;
+      }
+      else
+      {
+        if (!bLookupBuilt)
+        {
+          ref_pair.m_LookupB.Clear();
+          ref_pair.m_LookupB.Reserve(bodiesB.GetCount());
+          for (nsUInt32 j = 0; j < bodiesB.GetCount(); ++j)
+          {
+            ref_pair.m_LookupB.Insert(bodiesB[j].m_uiBodyId, j);
+          }
+          bLookupBuilt = true;
+        }
+
+        ref_pair.m_LookupB.TryGetValue(uiBodyId, uiIndexB);
+      }
+
+      if (uiIndexB != nsInvalidIndex)
+      {
+        ref_pair.m_MatchedBodiesB.PushBack(uiIndexB);
+        ref_pair.m_MatchedIds.PushBack(uiBodyId);
+      }
+      else
+      {
+        ref_pair.m_MatchedBodiesB.PushBack(nsInvalidIndex);
+      }
+    }
+  }
+
+  /// nsSimdMath::ASin() is off by up to 7e-5 radians, far too coarse for determinism tolerances.
+  /// The series is precise for the small angles that matter here, large errors fall back to the approximation.
+  NS_ALWAYS_INLINE nsSimdVec4f PreciseASin(const nsSimdVec4f& x)
+  {
+    const nsSimdVec4f x2 = x.CompMul(x);
+    nsSimdVec4f series = nsSimdVec4f::MulAdd(x2, nsSimdVec4f(5.0f / 112.0f), nsSimdVec4f(3.0f / 40.0f));
+    series = nsSimdVec4f::MulAdd(x2, series, nsSimdVec4f(1.0f / 6.0f));
+    series = nsSimdVec4f::MulAdd(x2, series, nsSimdVec4f(1.0f));
+    return nsSimdVec4f::Select(x < nsSimdVec4f(0.5f), x.CompMul(series), nsSimdMath::ASin(x));
+  }
+
+  void CompareFramePair(nsJvdDiffFramePair& ref_pair, const nsJvdClipDiffSettings& settings)
+  {
+    MatchBodies(ref_pair);
+
+    const nsDynamicArray<nsJvdBodyState>& bodiesA = ref_pair.m_pFrameA->m_Bodies;
+    const nsDynamicArray<nsJvdBodyState>& bodiesB = ref_pair.m_pFrameB->m_Bodies;
+    const nsUInt32 uiMatchedCount = ref_pair.m_MatchedIds.GetCount();
+    const nsUInt32 uiStride = nsMemoryUtils::AlignSize(uiMatchedCount, 4u);
+
+    ref_pair.m_Columns.SetCountUninitialized(uiStride * nsJvdDiffFramePair::ColumnCount);
+    ref_pair.m_PositionErrors.SetCountUninitialized(uiStride);
+    ref_pair.m_RotationErrors.SetCountUninitialized(uiStride);
+
+    auto GetColumn = [&](nsJvdDiffFramePair::Column column)
+    { return ref_pair.m_Columns.GetData() + column * uiStride; };
+
+    // transpose the matched bodies into SoA columns, padding lanes compare two identical zero transforms
+    {
+      nsUInt32 uiMatched = 0;
+      for (nsUInt32 i = 0; i < bodiesA.GetCount(); ++i)
+      {
+        const nsUInt32 uiIndexB = ref_pair.m_MatchedBodiesB[i];
+        if (uiIndexB == nsInvalidIndex)
+          continue;
+
+        const nsJvdBodyState& a = bodiesA[i];
+        const nsJvdBodyState& b = bodiesB[uiIndexB];
+
+        GetColumn(nsJvdDiffFramePair::PosXA)[uiMatched] = a.m_vPosition.x;
+        GetColumn(nsJvdDiffFramePair::PosYA)[uiMatched] = a.m_vPosition.y;
+        GetColumn(nsJvdDiffFramePair::PosZA)[uiMatched] = a.m_vPosition.z;
+        GetColumn(nsJvdDiffFramePair::RotXA)[uiMatched] = a.m_qRotation.x;
+        GetColumn(nsJvdDiffFramePair::RotYA)[uiMatched] = a.m_qRotation.y;
+        GetColumn(nsJvdDiffFramePair::RotZA)[uiMatched] = a.m_qRotation.z;
+        GetColumn(nsJvdDiffFramePair::RotWA)[uiMatched] = a.m_qRotation.w;
+        GetColumn(nsJvdDiffFramePair::PosXB)[uiMatched] = b.m_vPosition.x;
+        GetColumn(nsJvdDiffFramePair::PosYB)[uiMatched] = b.m_vPosition.y;
+        GetColumn(nsJvdDiffFramePair::PosZB)[uiMatched] = b.m_vPosition.z;
+        GetColumn(nsJvdDiffFramePair::RotXB)[uiMatched] = b.m_qRotation.x;
+        GetColumn(nsJvdDiffFramePair::RotYB)[uiMatched] = b.m_qRotation.y;
+        GetColumn(nsJvdDiffFramePair::RotZB)[uiMatched] = b.m_qRotation.z;
+        GetColumn(nsJvdDiffFramePair::RotWB)[uiMatched] = b.m_qRotation.w;
+        ++uiMatched;
+      }
+
+      for (nsUInt32 uiColumn = 0; uiColumn < nsJvdDiffFramePair::ColumnCount; ++uiColumn)
+      {
+        float* pColumn = GetColumn(static_cast<nsJvdDiffFramePair::Column>(uiColumn));
+        for (nsUInt32 i = uiMatchedCount; i < uiStride; ++i)
+        {
+          pColumn[i] = 0.0f;
+        }
+      }
+    }
+
+    const nsSimdVec4f vZero = nsSimdVec4f::MakeZero();
+    const nsSimdVec4f vOne(1.0f);
+    const nsSimdVec4f vHalf(0.5f);
+    const nsSimdVec4f vFour(4.0f);
+    const nsSimdVec4f vInfinity(nsMath::Infinity<float>());
+    const nsSimdVec4f vPositionTolerance(settings.m_fPositionTolerance);
+    const nsSimdVec4f vRotationTolerance(settings.m_fRotationTolerance);
+
+    nsSimdVec4f vMaxPosition = vZero;
+    nsSimdVec4f vSumPosition = vZero;
+    nsSimdVec4f vMaxRotation = vZero;
+    nsSimdVec4f vDivergent = vZero;
+
+    for (nsUInt32 i = 0; i < uiStride; i += 4)
+    {
+      auto Load = [&](nsJvdDiffFramePair::Column column)
+      {
+        nsSimdVec4f v;
+        v.Load<4>(GetColumn(column) + i);
+        return v;
+      };
+
+      const nsSimdVec4f dx = Load(nsJvdDiffFramePair::PosXA) - Load(nsJvdDiffFramePair::PosXB);
+      const nsSimdVec4f dy = Load(nsJvdDiffFramePair::PosYA) - Load(nsJvdDiffFramePair::PosYB);
+      const nsSimdVec4f dz = Load(nsJvdDiffFramePair::PosZA) - Load(nsJvdDiffFramePair::PosZB);
+      nsSimdVec4f position = nsSimdVec4f::MulAdd(dx, dx, nsSimdVec4f::MulAdd(dy, dy, dz.CompMul(dz))).GetSqrt();
+
+      const nsSimdVec4f ax = Load(nsJvdDiffFramePair::RotXA);
+      const nsSimdVec4f ay = Load(nsJvdDiffFramePair::RotYA);
+      const nsSimdVec4f az = Load(nsJvdDiffFramePair::RotZA);
+      const nsSimdVec4f aw = Load(nsJvdDiffFramePair::RotWA);
+      nsSimdVec4f bx = Load(nsJvdDiffFramePair::RotXB);
+      nsSimdVec4f by = Load(nsJvdDiffFramePair::RotYB);
+      nsSimdVec4f bz = Load(nsJvdDiffFramePair::RotZB);
+      nsSimdVec4f bw = Load(nsJvdDiffFramePair::RotWB);
+
+      // q and -q are the same rotation, compare against the closer one
+      const nsSimdVec4f dot = nsSimdVec4f::MulAdd(ax, bx, nsSimdVec4f::MulAdd(ay, by, nsSimdVec4f::MulAdd(az, bz, aw.CompMul(bw))));
+      const nsSimdVec4b flip = dot < vZero;
+      bx = nsSimdVec4f::Select(flip, -bx, bx);
+      by = nsSimdVec4f::Select(flip, -by, by);
+      bz = nsSimdVec4f::Select(flip, -bz, bz);
+      bw = nsSimdVec4f::Select(flip, -bw, bw);
+
+      // the chord between the two unit quaternions stays precise for tiny angles, unlike acos of their dot product
+      const nsSimdVec4f cx = ax - bx;
+      const nsSimdVec4f cy = ay - by;
+      const nsSimdVec4f cz = az - bz;
+      const nsSimdVec4f cw = aw - bw;
+      const nsSimdVec4f halfChord = nsSimdVec4f::MulAdd(cx, cx, nsSimdVec4f::MulAdd(cy, cy, nsSimdVec4f::MulAdd(cz, cz, cw.CompMul(cw)))).GetSqrt().CompMul(vHalf);
+      nsSimdVec4f rotation = PreciseASin(halfChord.CompMin(vOne)).CompMul(vFour);
+
+      // non-finite values always count as the worst possible divergence
+      position = nsSimdVec4f::Select(position == position, position, vInfinity);
+      rotation = nsSimdVec4f::Select(rotation == rotation, rotation, vInfinity);
+
+      position.Store<4>(ref_pair.m_PositionErrors.GetData() + i);
+      rotation.Store<4>(ref_pair.m_RotationErrors.GetData() + i);
+
+      vMaxPosition = vMaxPosition.CompMax(position);
+      vSumPosition += position;
+      vMaxRotation = vMaxRotation.CompMax(rotation);
+      vDivergent += nsSimdVec4f::Select((position > vPositionTolerance) || (rotation > vRotationTolerance), vOne, vZero);
+    }
+
+    nsJvdClipDiffFrameError& error = ref_pair.m_Error;
+    error = nsJvdClipDiffFrameError();
+    error.m_uiFrameIndexA = ref_pair.m_pFrameA->m_uiFrameIndex;
+    error.m_uiFrameIndexB = ref_pair.m_pFrameB->m_uiFrameIndex;
+    error.m_Timestamp = ref_pair.m_pFrameA->m_Timestamp;
+    error.m_uiMatchedBodyCount = uiMatchedCount;
+    error.m_uiMissingBodyCount = (bodiesA.GetCount() - uiMatchedCount) + (bodiesB.GetCount() - uiMatchedCount);
+    error.m_uiDivergentBodyCount = static_cast<nsUInt32>(static_cast<float>(vDivergent.HorizontalSum<4>()));
+    error.m_fMaxPositionError = vMaxPosition.HorizontalMax<4>();
+    error.m_fMaxRotationError = vMaxRotation.HorizontalMax<4>();
+    error.m_fMeanPositionError = uiMatchedCount > 0 ? static_cast<float>(vSumPosition.HorizontalSum<4>()) / uiMatchedCount : 0.0f;
+  }
+
+  class nsJvdClipDiffContext
+  {
+  public:
+    nsJvdClipDiffContext(const nsJvdClipDiffSettings& settings, nsJvdClipDiffResult& ref_result)
+      : m_Settings(settings)
+      , m_Result(ref_result)
+    {
+      m_Settings.m_uiFramesPerBatch = nsMath::Max(m_Settings.m_uiFramesPerBatch, 1u);
+      m_Pairs.SetCount(m_Settings.m_uiFramesPerBatch);
+
+      // avoid divisions by zero when ranking the bodies
+      m_fInvPositionTolerance = 1.0f / nsMath::Max(m_Settings.m_fPositionTolerance, nsMath::SmallEpsilon<float>());
+      m_fInvRotationTolerance = 1.0f / nsMath::Max(m_Settings.m_fRotationTolerance, nsMath::SmallEpsilon<float>());
+    }
+
+    nsResult Run(nsJvdDiffFrameSource& ref_sourceA, nsJvdDiffFrameSource& ref_sourceB)
+    {
+      m_Result.Clear();
+
+      while (true)
+      {
+        NS_SUCCEED_OR_RETURN(Refill(ref_sourceA, ref_sourceB));
+
+        if (ref_sourceA.GetCount() == 0 && ref_sourceB.GetCount() == 0)
+          break;
+
+        const nsUInt32 uiPairCount = AlignFrames(ref_sourceA, ref_sourceB);
+
+        nsParallelForParams params;
+        params.m_uiBinSize = 4;
+        nsTaskSystem::ParallelForIndexed(
+          0u, uiPairCount, [this](nsUInt32 uiStart, nsUInt32 uiEnd)
+          {
+            for (nsUInt32 i = uiStart; i < uiEnd; ++i)
+            {
+              CompareFramePair(m_Pairs[i], m_Settings);
+            }
+          },
+          "JvdClipDiff", nsTaskNesting::Never, params);
+
+        for (nsUInt32 i = 0; i < uiPairCount; ++i)
+        {
+          MergePair(m_Pairs[i]);
+        }
+
+        ref_sourceA.Consume(m_uiConsumedA);
+        ref_sourceB.Consume(m_uiConsumedB);
+      }
+
+      CollectWorstBodies();
+      return NS_SUCCESS;
+    }
+
+  private:
+    nsResult Refill(nsJvdDiffFrameSource& ref_sourceA, nsJvdDiffFrameSource& ref_sourceB)
+    {
+      const nsUInt32 uiBatchSize = m_Settings.m_uiFramesPerBatch;
+
+      if (!ref_sourceA.IsStreaming() || !ref_sourceB.IsStreaming())
+      {
+        NS_SUCCEED_OR_RETURN(ref_sourceA.Refill(uiBatchSize));
+        return ref_sourceB.Refill(uiBatchSize);
+      }
+
+      // decoding dominates when streaming, so both files are read at the same time
+      nsJvdDiffFrameSource* sources[2] = {&ref_sourceA, &ref_sourceB};
+      nsResult results[2] = {NS_SUCCESS, NS_SUCCESS};
+
+      nsTaskSystem::ParallelForIndexed(
+        0u, 2u, [&sources, &results, uiBatchSize](nsUInt32 uiStart, nsUInt32 uiEnd)
+        {
+          for (nsUInt32 i = uiStart; i < uiEnd; ++i)
+          {
+            results[i] = sources[i]->Refill(uiBatchSize);
+          }
+        },
+        "JvdClipDiffDecode");
+
+      NS_SUCCEED_OR_RETURN(results[0]);
+      return results[1];
+    }
+
+    nsInt32 CompareFrames(const nsJvdFrame& a, const nsJvdFrame& b) const
+    {
+      if (m_Settings.m_Alignment == nsJvdClipDiffAlignment::FrameIndex)
+      {
+        if (a.m_uiFrameIndex == b.m_uiFrameIndex)
+          return 0;
+
+        return a.m_uiFrameIndex < b.m_uiFrameIndex ? -1 : 1;
+      }
+
+      const nsTime difference = a.m_Timestamp - b.m_Timestamp;
+      if (nsMath::Abs(difference.GetSeconds()) <= m_Settings.m_TimeTolerance.GetSeconds())
+        return 0;
+
+      return difference.IsNegative() ? -1 : 1;
+    }
+
+    /// Pairs up the pending frames of both sources, both are expected to be sorted by frame index and time.
+    nsUInt32 AlignFrames(const nsJvdDiffFrameSource& sourceA, const nsJvdDiffFrameSource& sourceB)
+    {
+      nsUInt32 a = 0;
+      nsUInt32 b = 0;
+      nsUInt32 uiPairCount = 0;
+
+      while (a < sourceA.GetCount() && b < sourceB.GetCount())
+      {
+        const nsJvdFrame& frameA = sourceA.GetFrame(a);
+        const nsJvdFrame& frameB = sourceB.GetFrame(b);
+        const nsInt32 iOrder = CompareFrames(frameA, frameB);
+
+        if (iOrder == 0)
+        {
+          nsJvdDiffFramePair& pair = m_Pairs[uiPairCount++];
+          pair.m_pFrameA = &frameA;
+          pair.m_pFrameB = &frameB;
+          ++a;
+          ++b;
+        }
+        else if (iOrder < 0)
+        {
+          ++m_Result.m_uiUnmatchedFrameCountA;
+          ++a;
+        }
+        else
+        {
+          ++m_Result.m_uiUnmatchedFrameCountB;
+          ++b;
+        }
+      }
+
+      // once a clip has ended, the remaining frames of the other one have no partner
+      if (a == sourceA.GetCount() && !sourceA.HasMoreFrames())
+      {
+        m_Result.m_uiUnmatchedFrameCountB += sourceB.GetCount() - b;
+        b = sourceB.GetCount();
+      }
+
+      if (b == sourceB.GetCount() && !sourceB.HasMoreFrames())
+      {
+        m_Result.m_uiUnmatchedFrameCountA += sourceA.GetCount() - a;
+        a = sourceA.GetCount();
+      }
+
+      m_uiConsumedA = a;
+      m_uiConsumedB = b;
+      return uiPairCount;
+    }
+
+    void MergePair(const nsJvdDiffFramePair& pair)
+    {
+      const nsJvdClipDiffFrameError& error = pair.m_Error;
+      m_Result.m_ErrorCurve.PushBack(error);
+      ++m_Result.m_uiComparedFrameCount;
+
+      m_Result.m_fMaxPositionError = nsMath::Max(m_Result.m_fMaxPositionError, error.m_fMaxPositionError);
+      m_Result.m_fMaxRotationError = nsMath::Max(m_Result.m_fMaxRotationError, error.m_fMaxRotationError);
+
+      if (!m_Result.m_bDiverged && error.IsDivergent())
+      {
+        m_Result.m_bDiverged = true;
+        m_Result.m_uiFirstDivergentFrameIndex = error.m_uiFrameIndexA;
+        m_Result.m_FirstDivergentTimestamp = error.m_Timestamp;
+      }
+
+      // exact zero errors are the common case for deterministic runs and have nothing to accumulate
+      if (error.m_fMaxPositionError == 0.0f && error.m_fMaxRotationError == 0.0f)
+        return;
+
+      m_LastSlots.SetCount(pair.m_MatchedIds.GetCount(), nsInvalidIndex);
+
+      for (nsUInt32 i = 0; i < pair.m_MatchedIds.GetCount(); ++i)
+      {
+        const float fPosition = pair.m_PositionErrors[i];
+        const float fRotation = pair.m_RotationErrors[i];
+        if (fPosition == 0.0f && fRotation == 0.0f)
+          continue;
+
+        const nsUInt64 uiBodyId = pair.m_MatchedIds[i];
+        nsUInt32 uiSlot = m_LastSlots[i];
+        if (uiSlot == nsInvalidIndex || m_Bodies[uiSlot].m_uiBodyId != uiBodyId)
+        {
+          if (!m_BodyLookup.TryGetValue(uiBodyId, uiSlot))
+          {
+            uiSlot = m_Bodies.GetCount();
+            m_Bodies.ExpandAndGetRef().m_uiBodyId = uiBodyId;
+            m_BodyScores.PushBack(-1.0f);
+            m_BodyLookup.Insert(uiBodyId, uiSlot);
+          }
+
+          m_LastSlots[i] = uiSlot;
+        }
+
+        nsJvdClipDiffBodyError& body = m_Bodies[uiSlot];
+        body.m_fMaxPositionError = nsMath::Max(body.m_fMaxPositionError, fPosition);
+        body.m_fMaxRotationError = nsMath::Max(body.m_fMaxRotationError, fRotation);
+
+        const float fScore = nsMath::Max(fPosition * m_fInvPositionTolerance, fRotation * m_fInvRotationTolerance);
+        if (fScore > m_BodyScores[uiSlot])
+        {
+          m_BodyScores[uiSlot] = fScore;
+          body.m_uiWorstFrameIndex = error.m_uiFrameIndexA;
+        }
+
+        if (fPosition > m_Settings.m_fPositionTolerance || fRotation > m_Settings.m_fRotationTolerance)
+        {
+          if (body.m_uiDivergentFrameCount == 0)
+          {
+            body.m_uiFirstDivergentFrameIndex = error.m_uiFrameIndexA;
+          }
+
+          ++body.m_uiDivergentFrameCount;
+        }
+      }
+    }
+
+    void CollectWorstBodies()
+    {
+      nsDynamicArray<nsUInt32> order;
+      order.SetCountUninitialized(m_Bodies.GetCount());
+      for (nsUInt32 i = 0; i < order.GetCount(); ++i)
+      {
+        order[i] = i;
+      }
+
+      // worst first, ties are broken by id to keep the report stable
+      order.Sort([this](nsUInt32 a, nsUInt32 b)
+        { return m_BodyScores[a] != m_BodyScores[b] ? m_BodyScores[a] > m_BodyScores[b] : m_Bodies[a].m_uiBodyId < m_Bodies[b].m_uiBodyId; });
+
+      const nsUInt32 uiCount = nsMath::Min(order.GetCount(), m_Settings.m_uiNumWorstBodies);
+      m_Result.m_WorstBodies.SetCount(uiCount);
+      for (nsUInt32 i = 0; i < uiCount; ++i)
+      {
+        m_Result.m_WorstBodies[i] = m_Bodies[order[i]];
+      }
+    }
+
+    nsJvdClipDiffSettings m_Settings;
+    nsJvdClipDiffResult& m_Result;
+    float m_fInvPositionTolerance = 1.0f;
+    float m_fInvRotationTolerance = 1.0f;
+
+    nsDynamicArray<nsJvdDiffFramePair> m_Pairs;
+    nsUInt32 m_uiConsumedA = 0;
+    nsUInt32 m_uiConsumedB = 0;
+
+    nsDynamicArray<nsJvdClipDiffBodyError> m_Bodies;
+    nsDynamicArray<float> m_BodyScores;
+    nsHashTable<nsUInt64, nsUInt32> m_BodyLookup;
+    nsDynamicArray<nsUInt32> m_LastSlots; ///< Body slot of each matched body in the previously merged frame.
+  };
+} // namespace
+
+void nsJvdClipDiff::CompareClips(const nsJvdClip& clipA, const nsJvdClip& clipB, const nsJvdClipDiffSettings& settings, nsJvdClipDiffResult& out_result)
+{
+  nsJvdDiffFrameSource sourceA(clipA);
+  nsJvdDiffFrameSource sourceB(clipB);
+
+  nsJvdClipDiffContext context(settings, out_result);
+  context.Run(sourceA, sourceB).AssertSuccess("Comparing loaded clips cannot fail.");
+}
+
+nsResult nsJvdClipDiff::CompareFiles(nsStringView sFileA, nsStringView sFileB, const nsJvdClipDiffSettings& settings, nsJvdClipDiffResult& out_result)
+{
+  nsJvdClipReader readerA;
+  nsJvdClipReader readerB;
+  NS_SUCCEED_OR_RETURN(readerA.Open(sFileA));
+  NS_SUCCEED_OR_RETURN(readerB.Open(sFileB));
+
+  nsJvdDiffFrameSource sourceA(readerA);
+  nsJvdDiffFrameSource sourceB(readerB);
+
+  nsJvdClipDiffContext context(settings, out_result);
+  return context.Run(sourceA, sourceB);
+}
+
+NS_STATICLINK_FILE(JVDSDK, Analysis_JvdClipDiff);
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <JVDSDK/Recording/JvdRecordingTypes.h>
+
+/// \brief How frames of two clips are paired up by nsJvdClipDiff.
+struct nsJvdClipDiffAlignment
+{
+  using StorageType = nsUInt8;
+
+  enum Enum : nsUInt8
+  {
+    FrameIndex, ///< Frames with the same frame index are compared.
+    Timestamp,  ///< Frames whose timestamps differ by at most the time tolerance are compared.
+
+    Default = FrameIndex
+  };
+};
+
+struct NS_JVDSDK_DLL nsJvdClipDiffSettings
+{
+  nsEnum<nsJvdClipDiffAlignment> m_Alignment;
+  nsTime m_TimeTolerance = nsTime::MakeFromMicroseconds(500);
+
+  float m_fPositionTolerance = 1e-4f; ///< Bodies further apart than this (in meters) diverge.
+  float m_fRotationTolerance = 1e-4f; ///< Bodies rotated further apart than this (in radians) diverge.
+
+  nsUInt32 m_uiNumWorstBodies = 10;
+
+  /// How many frames per clip are decoded before they are compared in parallel. Bounds the memory use when streaming.
+  nsUInt32 m_uiFramesPerBatch = 256;
+};
+
+/// \brief Errors of one pair of aligned frames, one sample of the error-over-time curve.
+struct nsJvdClipDiffFrameError
+{
+  nsUInt64 m_uiFrameIndexA = 0;
+  nsUInt64 m_uiFrameIndexB = 0;
+  nsTime m_Timestamp; ///< Taken from the first clip.
+
+  nsUInt32 m_uiMatchedBodyCount = 0;
+  nsUInt32 m_uiMissingBodyCount = 0; ///< Bodies that exist in only one of the two frames.
+  nsUInt32 m_uiDivergentBodyCount = 0;
+
+  float m_fMaxPositionError = 0.0f;
+  float m_fMeanPositionError = 0.0f;
+  float m_fMaxRotationError = 0.0f;
+
+  bool IsDivergent() const { return m_uiDivergentBodyCount > 0 || m_uiMissingBodyCount > 0; }
+};
+
+/// \brief Accumulated errors of a single body over all compared frames.
+struct nsJvdClipDiffBodyError
+{
+  nsUInt64 m_uiBodyId = 0;
+  float m_fMaxPositionError = 0.0f;
+  float m_fMaxRotationError = 0.0f;
+  nsUInt64 m_uiWorstFrameIndex = 0;          ///< Frame index (in the first clip) with the highest error relative to the tolerances.
+  nsUInt64 m_uiFirstDivergentFrameIndex = 0; ///< Only valid if m_uiDivergentFrameCount is not zero.
+  nsUInt64 m_uiDivergentFrameCount = 0;
+};
+
+struct NS_JVDSDK_DLL nsJvdClipDiffResult
+{
+  nsUInt64 m_uiComparedFrameCount = 0;
+  nsUInt64 m_uiUnmatchedFrameCountA = 0; ///< Frames of the first clip without a partner in the second one.
+  nsUInt64 m_uiUnmatchedFrameCountB = 0;
+
+  bool m_bDiverged = false;
+  nsUInt64 m_uiFirstDivergentFrameIndex = 0; ///< Frame index in the first clip, only valid if m_bDiverged is set.
+  nsTime m_FirstDivergentTimestamp;
+
+  float m_fMaxPositionError = 0.0f;
+  float m_fMaxRotationError = 0.0f;
+
+  /// The bodies with the highest errors relative to the tolerances, worst first.
+  nsDynamicArray<nsJvdClipDiffBodyError> m_WorstBodies;
+
+  /// One entry per compared frame pair.
+  nsDynamicArray<nsJvdClipDiffFrameError> m_ErrorCurve;
+
+  void Clear();
+
+  /// \brief Returns true if all frames were paired up and no body diverged.
+  bool IsIdentical() const { return !m_bDiverged && m_uiUnmatchedFrameCountA == 0 && m_uiUnmatchedFrameCountB == 0; }
+};
+
+/// \brief Compares two clips of the same scenario, e.g. recorded on two builds or platforms, to find where they diverge.
+///
+/// Frames are aligned by frame index or timestamp, bodies are matched by id. Each batch of aligned frames is compared in
+/// parallel with nsTaskSystem::ParallelForIndexed(), the per-body errors are computed with SIMD, four bodies at a time.
+namespace nsJvdClipDiff
+{
+  NS_JVDSDK_DLL void CompareClips(const nsJvdClip& clipA, const nsJvdClip& clipB, const nsJvdClipDiffSettings& settings, nsJvdClipDiffResult& out_result);
+
+  /// \brief Streams both .jvdrec files from disk, at most m_uiFramesPerBatch frames per file are held in memory at a time.
+  NS_JVDSDK_DLL nsResult CompareFiles(nsStringView sFileA, nsStringView sFileB, const nsJvdClipDiffSettings& settings, nsJvdClipDiffResult& out_result);
+} // namespace nsJvdClipDiff
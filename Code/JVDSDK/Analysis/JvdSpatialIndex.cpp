@@ -0,0 +1,440 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Analysis/JvdSpatialIndex.h>
+
+#include <Foundation/Algorithm/Sorting.h>
+#include <Foundation/Containers/HashSet.h>
+#include <Foundation/Containers/HashTable.h>
+
+class nsJvdSpatialIndex::nsJvdSpatialIndexBuildTask final : public nsTask
+{
+public:
+  nsJvdSpatialIndex* m_pIndex = nullptr;
+  nsArrayPtr<const nsJvdFrame> m_Frames;
+  nsJvdSpatialIndexSettings m_Settings;
+
+private:
+  virtual void Execute() override { m_pIndex->Build(m_Frames, m_Settings); }
+};
+
+nsJvdSpatialIndex::nsJvdSpatialIndex() = default;
+nsJvdSpatialIndex::~nsJvdSpatialIndex() = default;
+
+void nsJvdSpatialIndex::Clear()
+{
+  m_FrameIndices.Clear();
+  m_Timestamps.Clear();
+  m_Windows.Clear();
+  m_Bounds = nsBoundingBox::MakeInvalid();
+}
+
+void nsJvdSpatialIndex::Build(nsArrayPtr<const nsJvdFrame> frames, const nsJvdSpatialIndexSettings& settings)
+{
+  Clear();
+
+  m_Settings = settings;
+  m_Settings.m_uiFramesPerWindow = nsMath::Max(m_Settings.m_uiFramesPerWindow, 1u);
+  m_Settings.m_uiMaxLeafSize = nsMath::Max(m_Settings.m_uiMaxLeafSize, 1u);
+
+  const nsUInt32 uiFrameCount = frames.GetCount();
+  if (uiFrameCount == 0)
+    return;
+
+  m_FrameIndices.SetCountUninitialized(uiFrameCount);
+  m_Timestamps.SetCount(uiFrameCount);
+  for (nsUInt32 i = 0; i < uiFrameCount; ++i)
+  {
+    m_FrameIndices[i] = frames[i].m_uiFrameIndex;
+    m_Timestamps[i] = frames[i].m_Timestamp;
+  }
+
+  const nsUInt32 uiFramesPerWindow = m_Settings.m_uiFramesPerWindow;
+  m_Windows.SetCount((uiFrameCount + uiFramesPerWindow - 1) / uiFramesPerWindow);
+
+  nsParallelForParams params;
+  params.m_uiBinSize = 1;
+
+  nsTaskSystem::ParallelForIndexed(0u, m_Windows.GetCount(), [this, frames](nsUInt32 uiStart, nsUInt32 uiEnd)
+    {
+      const nsUInt32 uiFramesPerWindow = m_Settings.m_uiFramesPerWindow;
+      for (nsUInt32 w = uiStart; w < uiEnd; ++w)
+      {
+        const nsUInt32 uiFirst = w * uiFramesPerWindow;
+        const nsUInt32 uiCount = nsMath::Min(uiFramesPerWindow, frames.GetCount() - uiFirst);
+        BuildWindow(frames.GetSubArray(uiFirst, uiCount), uiFirst, m_Settings.m_uiMaxLeafSize, m_Windows[w]);
+      }
+    },
+    "JVD Spatial Index", nsTaskNesting::Never, params);
+
+  for (const Window& window : m_Windows)
+  {
+    if (!window.m_Nodes.IsEmpty())
+    {
+      m_Bounds.ExpandToInclude(window.m_Nodes[0].m_Bounds);
+    }
+  }
+}
+
+nsTaskGroupID nsJvdSpatialIndex::BuildAsync(const nsJvdClip& clip, const nsJvdSpatialIndexSettings& settings)
+{
+  nsSharedPtr<nsJvdSpatialIndexBuildTask> pTask = NS_DEFAULT_NEW(nsJvdSpatialIndexBuildTask);
+  pTask->m_pIndex = this;
+  pTask->m_Frames = clip.GetFrames();
+  pTask->m_Settings = settings;
+  pTask->ConfigureTask("JVD Spatial Index Build", nsTaskNesting::Maybe); // waits for the window tasks
+
+  return nsTaskSystem::StartSingleTask(pTask, nsTaskPriority::LongRunning);
+}
+
+void nsJvdSpatialIndex::BuildWindow(nsArrayPtr<const nsJvdFrame> frames, nsUInt32 uiFirstFramePosition, nsUInt32 uiMaxLeafSize, Window& out_window)
+{
+  nsDynamicArray<Path>& paths = out_window.m_Paths;
+  nsDynamicArray<Sample>& samples = out_window.m_Samples;
+  nsDynamicArray<Node>& nodes = out_window.m_Nodes;
+
+  // first pass: one path per body, count its samples
+  nsHashTable<nsUInt64, nsUInt32> pathIndices;
+  nsUInt32 uiSampleCount = 0;
+
+  for (const nsJvdFrame& frame : frames)
+  {
+    for (const nsJvdBodyState& state : frame.m_Bodies)
+    {
+      // broken bodies would make the bounds useless
+      if (!state.m_vPosition.IsValid())
+        continue;
+
+      bool bExisted = false;
+      nsUInt32& uiPath = pathIndices.FindOrAdd(state.m_uiBodyId, &bExisted);
+      if (!bExisted)
+      {
+        uiPath = paths.GetCount();
+
+        Path& path = paths.ExpandAndGetRef();
+        path.m_Bounds = nsBoundingBox::MakeInvalid();
+        path.m_uiBodyId = state.m_uiBodyId;
+        path.m_uiFirstSample = 0;
+        path.m_uiSampleCount = 0;
+      }
+
+      ++paths[uiPath].m_uiSampleCount;
+      ++uiSampleCount;
+    }
+  }
+
+  if (paths.IsEmpty())
+    return;
+
+  for (nsUInt32 i = 1; i < paths.GetCount(); ++i)
+  {
+    paths[i].m_uiFirstSample = paths[i - 1].m_uiFirstSample + paths[i - 1].m_uiSampleCount;
+  }
+
+  for (Path& path : paths)
+  {
+    path.m_uiSampleCount = 0;
+  }
+
+  // second pass: store the samples grouped by path
+  samples.SetCountUninitialized(uiSampleCount);
+
+  for (nsUInt32 f = 0; f < frames.GetCount(); ++f)
+  {
+    for (const nsJvdBodyState& state : frames[f].m_Bodies)
+    {
+      if (!state.m_vPosition.IsValid())
+        continue;
+
+      Path& path = paths[pathIndices[state.m_uiBodyId]];
+      path.m_Bounds.ExpandToInclude(state.m_vPosition);
+
+      Sample& sample = samples[path.m_uiFirstSample + path.m_uiSampleCount];
+      sample.m_vPosition = state.m_vPosition;
+      sample.m_uiFramePosition = uiFirstFramePosition + f;
+      ++path.m_uiSampleCount;
+    }
+  }
+
+  // top-down BVH, every node is split at the median path along the longest axis of the path centers
+  nodes.Reserve(2 * (paths.GetCount() / uiMaxLeafSize) + 1);
+
+  Node& root = nodes.ExpandAndGetRef();
+  root.m_uiFirst = 0;
+  root.m_uiCount = paths.GetCount();
+
+  nsHybridArray<nsUInt32, 64> stack;
+  stack.PushBack(0);
+
+  while (!stack.IsEmpty())
+  {
+    const nsUInt32 uiNode = stack.PeekBack();
+    stack.PopBack();
+
+    const nsUInt32 uiFirst = nodes[uiNode].m_uiFirst;
+    const nsUInt32 uiCount = nodes[uiNode].m_uiCount;
+
+    nsBoundingBox bounds = nsBoundingBox::MakeInvalid();
+    nsBoundingBox centers = nsBoundingBox::MakeInvalid();
+    for (nsUInt32 i = uiFirst; i < uiFirst + uiCount; ++i)
+    {
+      bounds.ExpandToInclude(paths[i].m_Bounds);
+      centers.ExpandToInclude(paths[i].m_Bounds.GetCenter());
+    }
+
+    nodes[uiNode].m_Bounds = bounds;
+
+    if (uiCount <= uiMaxLeafSize)
+      continue;
+
+    const nsVec3 vExtents = centers.GetExtents();
+    const nsUInt32 uiAxis = (vExtents.x >= vExtents.y && vExtents.x >= vExtents.z) ? 0 : (vExtents.y >= vExtents.z ? 1 : 2);
+
+    nsArrayPtr<Path> range = paths.GetArrayPtr().GetSubArray(uiFirst, uiCount);
+    nsSorting::QuickSort(range, [uiAxis](const Path& a, const Path& b)
+      { return a.m_Bounds.GetCenter().GetData()[uiAxis] < b.m_Bounds.GetCenter().GetData()[uiAxis]; });
+
+    const nsUInt32 uiLeftCount = uiCount / 2;
+    const nsUInt32 uiLeft = nodes.GetCount();
+
+    Node& left = nodes.ExpandAndGetRef();
+    left.m_uiFirst = uiFirst;
+    left.m_uiCount = uiLeftCount;
+
+    Node& right = nodes.ExpandAndGetRef();
+    right.m_uiFirst = uiFirst + uiLeftCount;
+    right.m_uiCount = uiCount - uiLeftCount;
+
+    nodes[uiNode].m_uiFirst = uiLeft;
+    nodes[uiNode].m_uiCount = 0;
+
+    stack.PushBack(uiLeft);
+    stack.PushBack(uiLeft + 1);
+  }
+}
+
+nsResult nsJvdSpatialIndex::FindFrameRange(nsTime startTime, nsTime endTime, nsUInt64& out_uiFirstFrameIndex, nsUInt64& out_uiLastFrameIndex) const
+{
+  // timestamps are ascending, see nsJvdClip::AddFrame()
+  nsUInt32 uiFirst = 0;
+  nsUInt32 uiHigh = m_Timestamps.GetCount();
+  while (uiFirst < uiHigh)
+  {
+    const nsUInt32 uiMid = (uiFirst + uiHigh) / 2;
+    if (m_Timestamps[uiMid] < startTime)
+      uiFirst = uiMid + 1;
+    else
+      uiHigh = uiMid;
+  }
+
+  nsUInt32 uiEnd = uiFirst;
+  uiHigh = m_Timestamps.GetCount();
+  while (uiEnd < uiHigh)
+  {
+    const nsUInt32 uiMid = (uiEnd + uiHigh) / 2;
+    if (m_Timestamps[uiMid] <= endTime)
+      uiEnd = uiMid + 1;
+    else
+      uiHigh = uiMid;
+  }
+
+  if (uiFirst >= uiEnd)
+    return NS_FAILURE;
+
+  out_uiFirstFrameIndex = m_FrameIndices[uiFirst];
+  out_uiLastFrameIndex = m_FrameIndices[uiEnd - 1];
+  return NS_SUCCESS;
+}
+
+template <typename NodeTest, typename SampleTest>
+nsUInt32 nsJvdSpatialIndex::Query(nsUInt64 uiFirstFrameIndex, nsUInt64 uiLastFrameIndex, NodeTest nodeTest, SampleTest sampleTest, nsDynamicArray<nsJvdSpatialHit>& out_hits) const
+{
+  out_hits.Clear();
+
+  if (IsEmpty() || uiFirstFrameIndex > uiLastFrameIndex)
+    return 0;
+
+  // translate the frame indices into frame positions [uiFirst, uiEnd)
+  nsUInt32 uiFirst = 0;
+  nsUInt32 uiHigh = m_FrameIndices.GetCount();
+  while (uiFirst < uiHigh)
+  {
+    const nsUInt32 uiMid = (uiFirst + uiHigh) / 2;
+    if (m_FrameIndices[uiMid] < uiFirstFrameIndex)
+      uiFirst = uiMid + 1;
+    else
+      uiHigh = uiMid;
+  }
+
+  nsUInt32 uiEnd = uiFirst;
+  uiHigh = m_FrameIndices.GetCount();
+  while (uiEnd < uiHigh)
+  {
+    const nsUInt32 uiMid = (uiEnd + uiHigh) / 2;
+    if (m_FrameIndices[uiMid] <= uiLastFrameIndex)
+      uiEnd = uiMid + 1;
+    else
+      uiHigh = uiMid;
+  }
+
+  if (uiFirst >= uiEnd)
+    return 0;
+
+  const nsUInt32 uiFramesPerWindow = m_Settings.m_uiFramesPerWindow;
+  nsHybridArray<nsUInt32, 64> stack;
+
+  for (nsUInt32 w = uiFirst / uiFramesPerWindow; w <= (uiEnd - 1) / uiFramesPerWindow; ++w)
+  {
+    const Window& window = m_Windows[w];
+    if (window.m_Nodes.IsEmpty())
+      continue;
+
+    // windows in the middle of the range need no per-sample frame check
+    const bool bWholeWindow = w * uiFramesPerWindow >= uiFirst && (w + 1) * uiFramesPerWindow <= uiEnd;
+
+    stack.Clear();
+    stack.PushBack(0);
+
+    while (!stack.IsEmpty())
+    {
+      const Node& node = window.m_Nodes[stack.PeekBack()];
+      stack.PopBack();
+
+      if (!nodeTest(node.m_Bounds))
+        continue;
+
+      if (node.m_uiCount == 0)
+      {
+        stack.PushBack(node.m_uiFirst);
+        stack.PushBack(node.m_uiFirst + 1);
+        continue;
+      }
+
+      for (nsUInt32 p = node.m_uiFirst; p < node.m_uiFirst + node.m_uiCount; ++p)
+      {
+        const Path& path = window.m_Paths[p];
+        if (node.m_uiCount > 1 && !nodeTest(path.m_Bounds))
+          continue;
+
+        for (nsUInt32 s = path.m_uiFirstSample; s < path.m_uiFirstSample + path.m_uiSampleCount; ++s)
+        {
+          const Sample& sample = window.m_Samples[s];
+          if (!bWholeWindow && (sample.m_uiFramePosition < uiFirst || sample.m_uiFramePosition >= uiEnd))
+            continue;
+
+          float fDistance = 0.0f;
+          if (!sampleTest(sample.m_vPosition, fDistance))
+            continue;
+
+          nsJvdSpatialHit& hit = out_hits.ExpandAndGetRef();
+          hit.m_uiBodyId = path.m_uiBodyId;
+          hit.m_uiFrameIndex = m_FrameIndices[sample.m_uiFramePosition];
+          hit.m_vPosition = sample.m_vPosition;
+          hit.m_fDistance = fDistance;
+        }
+      }
+    }
+  }
+
+  return out_hits.GetCount();
+}
+
+namespace
+{
+  void SortHitsByFrame(nsDynamicArray<nsJvdSpatialHit>& inout_hits)
+  {
+    inout_hits.Sort([](const nsJvdSpatialHit& a, const nsJvdSpatialHit& b)
+      {
+        if (a.m_uiFrameIndex != b.m_uiFrameIndex)
+          return a.m_uiFrameIndex < b.m_uiFrameIndex;
+        return a.m_uiBodyId < b.m_uiBodyId;
+      });
+  }
+} // namespace
+
+nsUInt32 nsJvdSpatialIndex::QueryBox(const nsBoundingBox& box, nsUInt64 uiFirstFrameIndex, nsUInt64 uiLastFrameIndex, nsDynamicArray<nsJvdSpatialHit>& out_hits) const
+{
+  Query(
+    uiFirstFrameIndex, uiLastFrameIndex, [&box](const nsBoundingBox& bounds)
+    { return box.Overlaps(bounds); },
+    [&box](const nsVec3& vPosition, float&)
+    { return box.Contains(vPosition); },
+    out_hits);
+
+  SortHitsByFrame(out_hits);
+  return out_hits.GetCount();
+}
+
+nsUInt32 nsJvdSpatialIndex::QuerySphere(const nsBoundingSphere& sphere, nsUInt64 uiFirstFrameIndex, nsUInt64 uiLastFrameIndex, nsDynamicArray<nsJvdSpatialHit>& out_hits) const
+{
+  Query(
+    uiFirstFrameIndex, uiLastFrameIndex, [&sphere](const nsBoundingBox& bounds)
+    { return bounds.Overlaps(sphere); },
+    [&sphere](const nsVec3& vPosition, float&)
+    { return sphere.Contains(vPosition); },
+    out_hits);
+
+  SortHitsByFrame(out_hits);
+  return out_hits.GetCount();
+}
+
+nsUInt32 nsJvdSpatialIndex::QueryRay(const nsVec3& vStart, const nsVec3& vDirection, float fMaxDistance, float fRadius, nsUInt64 uiFirstFrameIndex, nsUInt64 uiLastFrameIndex, nsDynamicArray<nsJvdSpatialHit>& out_hits) const
+{
+  NS_ASSERT_DEV(vDirection.IsNormalized(), "The ray direction must be normalized.");
+
+  const nsVec3 vEnd = vStart + vDirection * fMaxDistance;
+  const float fRadiusSqr = fRadius * fRadius;
+
+  Query(
+    uiFirstFrameIndex, uiLastFrameIndex, [&](const nsBoundingBox& bounds)
+    {
+      nsBoundingBox grown = bounds;
+      grown.Grow(nsVec3(fRadius));
+      return grown.Contains(vStart) || grown.GetLineSegmentIntersection(vStart, vEnd);
+    },
+    [&](const nsVec3& vPosition, float& out_fDistance)
+    {
+      out_fDistance = nsMath::Clamp((vPosition - vStart).Dot(vDirection), 0.0f, fMaxDistance);
+      return (vStart + vDirection * out_fDistance - vPosition).GetLengthSquared() <= fRadiusSqr;
+    },
+    out_hits);
+
+  out_hits.Sort([](const nsJvdSpatialHit& a, const nsJvdSpatialHit& b)
+    {
+      if (a.m_fDistance != b.m_fDistance)
+        return a.m_fDistance < b.m_fDistance;
+      if (a.m_uiFrameIndex != b.m_uiFrameIndex)
+        return a.m_uiFrameIndex < b.m_uiFrameIndex;
+      return a.m_uiBodyId < b.m_uiBodyId;
+    });
+
+  return out_hits.GetCount();
+}
+
+void nsJvdSpatialIndex::KeepFirstHitPerBody(nsDynamicArray<nsJvdSpatialHit>& inout_hits)
+{
+  nsHashSet<nsUInt64> seenBodies;
+  nsUInt32 uiKept = 0;
+
+  for (nsUInt32 i = 0; i < inout_hits.GetCount(); ++i)
+  {
+    if (seenBodies.Insert(inout_hits[i].m_uiBodyId))
+      continue;
+
+    inout_hits[uiKept] = inout_hits[i];
+    ++uiKept;
+  }
+
+  inout_hits.SetCount(uiKept);
+}
+
+nsUInt64 nsJvdSpatialIndex::GetHeapMemoryUsage() const
+{
+  nsUInt64 uiBytes = m_FrameIndices.GetHeapMemoryUsage() + m_Timestamps.GetHeapMemoryUsage() + m_Windows.GetHeapMemoryUsage();
+  for (const Window& window : m_Windows)
+  {
+    uiBytes += window.m_Samples.GetHeapMemoryUsage() + window.m_Paths.GetHeapMemoryUsage() + window.m_Nodes.GetHeapMemoryUsage();
+  }
+  return uiBytes;
+}
+
+NS_STATICLINK_FILE(JVDSDK, Analysis_JvdSpatialIndex);
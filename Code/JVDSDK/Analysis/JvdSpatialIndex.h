@@ -0,0 +1,123 @@
+#pragma once
+
+#include <JVDSDK/Recording/JvdRecordingTypes.h>
+
+#include <Foundation/Math/BoundingBox.h>
+#include <Foundation/Math/BoundingSphere.h>
+#include <Foundation/Threading/TaskSystem.h>
+
+struct nsJvdSpatialIndexSettings
+{
+  /// The clip is split into windows of this many frames, every window gets its own BVH over the paths of the bodies within it.
+  /// Smaller windows make queries over short time ranges cheaper, larger windows need less memory.
+  nsUInt32 m_uiFramesPerWindow = 64;
+
+  /// How many body paths a BVH leaf may hold.
+  nsUInt32 m_uiMaxLeafSize = 4;
+};
+
+/// \brief One body position that matched a spatial query.
+struct nsJvdSpatialHit
+{
+  nsUInt64 m_uiBodyId = 0;
+  nsUInt64 m_uiFrameIndex = 0;
+  nsVec3 m_vPosition = nsVec3::MakeZero();
+  float m_fDistance = 0.0f; ///< Only set by ray queries, the distance along the ray.
+};
+
+/// \brief Spatio-temporal index over the body positions of a clip, for box, sphere and ray queries over frame ranges.
+///
+/// The index keeps its own copy of all finite body positions, grouped per window of frames and per body. Every window has a
+/// BVH over the bounds of the body paths, so a query only looks at the windows of its frame range and, within them, only at
+/// bodies whose path comes close to the query shape. Bodies are treated as points, query shapes need to account for their size.
+class NS_JVDSDK_DLL nsJvdSpatialIndex
+{
+public:
+  nsJvdSpatialIndex();
+  ~nsJvdSpatialIndex();
+
+  void Clear();
+
+  /// \brief Builds the index for the given frames, the windows are built in parallel. Expects ascending frame indices.
+  void Build(nsArrayPtr<const nsJvdFrame> frames, const nsJvdSpatialIndexSettings& settings = nsJvdSpatialIndexSettings());
+
+  /// \brief Builds the index on a long running task. The clip must not change and the index must not be accessed until the
+  /// returned task group has finished.
+  nsTaskGroupID BuildAsync(const nsJvdClip& clip, const nsJvdSpatialIndexSettings& settings = nsJvdSpatialIndexSettings());
+
+  bool IsEmpty() const { return m_FrameIndices.IsEmpty(); }
+  nsUInt32 GetFrameCount() const { return m_FrameIndices.GetCount(); }
+  nsUInt32 GetWindowCount() const { return m_Windows.GetCount(); }
+
+  /// \brief Bounds of all indexed positions.
+  const nsBoundingBox& GetBounds() const { return m_Bounds; }
+
+  /// \brief Finds the frame indices of the first and last indexed frame in [startTime, endTime]. Fails if there is no such frame.
+  nsResult FindFrameRange(nsTime startTime, nsTime endTime, nsUInt64& out_uiFirstFrameIndex, nsUInt64& out_uiLastFrameIndex) const;
+
+  /// \brief Reports every position inside the box in the frames [uiFirstFrameIndex, uiLastFrameIndex]. Returns the number of hits.
+  nsUInt32 QueryBox(const nsBoundingBox& box, nsUInt64 uiFirstFrameIndex, nsUInt64 uiLastFrameIndex, nsDynamicArray<nsJvdSpatialHit>& out_hits) const;
+
+  /// \brief Reports every position inside the sphere in the frames [uiFirstFrameIndex, uiLastFrameIndex]. Returns the number of hits.
+  nsUInt32 QuerySphere(const nsBoundingSphere& sphere, nsUInt64 uiFirstFrameIndex, nsUInt64 uiLastFrameIndex, nsDynamicArray<nsJvdSpatialHit>& out_hits) const;
+
+  /// \brief Reports every position closer than fRadius to the ray in the frames [uiFirstFrameIndex, uiLastFrameIndex], sorted by distance along the ray.
+  ///
+  /// vDirection must be normalized. Returns the number of hits.
+  nsUInt32 QueryRay(const nsVec3& vStart, const nsVec3& vDirection, float fMaxDistance, float fRadius, nsUInt64 uiFirstFrameIndex, nsUInt64 uiLastFrameIndex, nsDynamicArray<nsJvdSpatialHit>& out_hits) const;
+
+  /// \brief Removes all but the first hit of every body, e.g. to answer which bodies entered a region at all. Keeps the order.
+  static void KeepFirstHitPerBody(nsDynamicArray<nsJvdSpatialHit>& inout_hits);
+
+  nsUInt64 GetHeapMemoryUsage() const;
+
+private:
+  struct Sample
+  {
+    NS_DECLARE_POD_TYPE();
+
+    nsVec3 m_vPosition;
+    nsUInt32 m_uiFramePosition; ///< Position of the frame in the clip.
+  };
+
+  /// The positions of one body within one window.
+  struct Path
+  {
+    NS_DECLARE_POD_TYPE();
+
+    nsBoundingBox m_Bounds;
+    nsUInt64 m_uiBodyId;
+    nsUInt32 m_uiFirstSample;
+    nsUInt32 m_uiSampleCount;
+  };
+
+  struct Node
+  {
+    NS_DECLARE_POD_TYPE();
+
+    nsBoundingBox m_Bounds;
+    nsUInt32 m_uiFirst; ///< First path of a leaf, or the first of the two children of an inner node.
+    nsUInt32 m_uiCount; ///< Number of paths of a leaf, zero for inner nodes.
+  };
+
+  struct Window
+  {
+    nsDynamicArray<Sample> m_Samples;
+    nsDynamicArray<Path> m_Paths;
+    nsDynamicArray<Node> m_Nodes;
+  };
+
+  class nsJvdSpatialIndexBuildTask;
+
+  static void BuildWindow(nsArrayPtr<const nsJvdFrame> frames, nsUInt32 uiFirstFramePosition, nsUInt32 uiMaxLeafSize, Window& out_window);
+
+  /// Calls the node and sample tests for all windows overlapping the frame range and collects the matching samples.
+  template <typename NodeTest, typename SampleTest>
+  nsUInt32 Query(nsUInt64 uiFirstFrameIndex, nsUInt64 uiLastFrameIndex, NodeTest nodeTest, SampleTest sampleTest, nsDynamicArray<nsJvdSpatialHit>& out_hits) const;
+
+  nsJvdSpatialIndexSettings m_Settings;
+  nsDynamicArray<nsUInt64> m_FrameIndices;
+  nsDynamicArray<nsTime> m_Timestamps;
+  nsDynamicArray<Window> m_Windows;
+  nsBoundingBox m_Bounds = nsBoundingBox::MakeInvalid();
+};
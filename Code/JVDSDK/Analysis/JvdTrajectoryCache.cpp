@@ -0,0 +1,326 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Analysis/JvdTrajectoryCache.h>
+#include <JVDSDK/Serialization/JvdFileIO.h>
+
+#include <Foundation/IO/Stream.h>
+#include <Foundation/Threading/TaskSystem.h>
+
+void nsJvdBodyTrajectory::Clear()
+{
+  m_FrameIndices.Clear();
+  m_Timestamps.Clear();
+  m_Positions.Clear();
+  m_Rotations.Clear();
+  m_LinearVelocities.Clear();
+  m_AngularVelocities.Clear();
+  m_Sleeping.Clear();
+}
+
+void nsJvdBodyTrajectory::Reserve(nsUInt32 uiSampleCount)
+{
+  m_FrameIndices.Reserve(uiSampleCount);
+  m_Timestamps.Reserve(uiSampleCount);
+  m_Positions.Reserve(uiSampleCount);
+  m_Rotations.Reserve(uiSampleCount);
+  m_LinearVelocities.Reserve(uiSampleCount);
+  m_AngularVelocities.Reserve(uiSampleCount);
+}
+
+void nsJvdBodyTrajectory::AddSample(const nsJvdFrame& frame, const nsJvdBodyState& state)
+{
+  const nsUInt32 uiSample = m_FrameIndices.GetCount();
+
+  m_FrameIndices.PushBack(frame.m_uiFrameIndex);
+  m_Timestamps.PushBack(frame.m_Timestamp);
+  m_Positions.PushBack(state.m_vPosition);
+  m_Rotations.PushBack(state.m_qRotation);
+  m_LinearVelocities.PushBack(state.m_vLinearVelocity);
+  m_AngularVelocities.PushBack(state.m_vAngularVelocity);
+
+  m_Sleeping.SetCount(uiSample + 1);
+  m_Sleeping.SetBitValue(uiSample, state.m_bIsSleeping);
+}
+
+nsUInt64 nsJvdBodyTrajectory::GetHeapMemoryUsage() const
+{
+  return m_FrameIndices.GetHeapMemoryUsage() + m_Timestamps.GetHeapMemoryUsage() + m_Positions.GetHeapMemoryUsage() + m_Rotations.GetHeapMemoryUsage() +
+         m_LinearVelocities.GetHeapMemoryUsage() + m_AngularVelocities.GetHeapMemoryUsage() + (m_Sleeping.GetCount() + 31) / 32 * sizeof(nsUInt32);
+}
+
+nsResult nsJvdBodyTrajectory::WriteCsvHeader(nsStreamWriter& inout_stream)
+{
+  const nsStringView sHeader = "Body,Frame,Seconds,PosX,PosY,PosZ,RotX,RotY,RotZ,RotW,LinVelX,LinVelY,LinVelZ,AngVelX,AngVelY,AngVelZ,Sleeping\n";
+  return inout_stream.WriteBytes(sHeader.GetStartPointer(), sHeader.GetElementCount());
+}
+
+nsResult nsJvdBodyTrajectory::WriteCsv(nsStreamWriter& inout_stream) const
+{
+  nsStringBuilder line;
+
+  for (nsUInt32 i = 0; i < GetSampleCount(); ++i)
+  {
+    const nsVec3& p = m_Positions[i];
+    const nsQuat& q = m_Rotations[i];
+    const nsVec3& v = m_LinearVelocities[i];
+    const nsVec3& w = m_AngularVelocities[i];
+
+    line.SetFormat("{},{},{},{},{},{},", m_uiBodyId, m_FrameIndices[i], m_Timestamps[i].GetSeconds(), p.x, p.y, p.z);
+    line.AppendFormat("{},{},{},{},", q.x, q.y, q.z, q.w);
+    line.AppendFormat("{},{},{},{},{},{},{}\n", v.x, v.y, v.z, w.x, w.y, w.z, m_Sleeping.IsBitSet(i) ? 1 : 0);
+    NS_SUCCEED_OR_RETURN(inout_stream.WriteBytes(line.GetData(), line.GetElementCount()));
+  }
+
+  return NS_SUCCESS;
+}
+
+namespace
+{
+  /// Bodies mostly keep their place in the body array from one frame to the next, so the previous position is checked first.
+  const nsJvdBodyState* FindBodyWithHint(const nsJvdFrame& frame, nsUInt64 uiBodyId, nsUInt32& inout_uiHint)
+  {
+    const nsUInt32 uiBodyCount = frame.m_Bodies.GetCount();
+    if (inout_uiHint < uiBodyCount && frame.m_Bodies[inout_uiHint].m_uiBodyId == uiBodyId)
+      return &frame.m_Bodies[inout_uiHint];
+
+    for (nsUInt32 i = 0; i < uiBodyCount; ++i)
+    {
+      if (frame.m_Bodies[i].m_uiBodyId == uiBodyId)
+      {
+        inout_uiHint = i;
+        return &frame.m_Bodies[i];
+      }
+    }
+
+    return nullptr;
+  }
+
+  void BuildTrajectory(nsArrayPtr<const nsJvdFrame> frames, nsJvdBodyTrajectory& inout_trajectory)
+  {
+    inout_trajectory.Clear();
+
+    // count first, so that every array is allocated exactly once
+    nsUInt32 uiHint = 0;
+    nsUInt32 uiSampleCount = 0;
+    for (const nsJvdFrame& frame : frames)
+    {
+      uiSampleCount += FindBodyWithHint(frame, inout_trajectory.m_uiBodyId, uiHint) != nullptr ? 1 : 0;
+    }
+
+    inout_trajectory.Reserve(uiSampleCount);
+
+    for (const nsJvdFrame& frame : frames)
+    {
+      if (const nsJvdBodyState* pState = FindBodyWithHint(frame, inout_trajectory.m_uiBodyId, uiHint))
+      {
+        inout_trajectory.AddSample(frame, *pState);
+      }
+    }
+  }
+} // namespace
+
+void nsJvdTrajectoryCache::BuildTrajectories(nsArrayPtr<const nsJvdFrame> frames, nsArrayPtr<nsJvdBodyTrajectory> inout_trajectories)
+{
+  nsParallelForParams params;
+  params.m_uiBinSize = 1;
+
+  nsJvdBodyTrajectory* pTrajectories = inout_trajectories.GetPtr();
+  nsTaskSystem::ParallelForIndexed(0u, inout_trajectories.GetCount(), [frames, pTrajectories](nsUInt32 uiStart, nsUInt32 uiEnd)
+    {
+      for (nsUInt32 i = uiStart; i < uiEnd; ++i)
+      {
+        BuildTrajectory(frames, pTrajectories[i]);
+      }
+    },
+    "JVD Trajectories", nsTaskNesting::Never, params);
+}
+
+nsResult nsJvdTrajectoryCache::BuildTrajectories(nsStringView sFilePath, nsArrayPtr<nsJvdBodyTrajectory> inout_trajectories)
+{
+  nsHashTable<nsUInt64, nsUInt32> trajectoryIndices;
+  for (nsUInt32 i = 0; i < inout_trajectories.GetCount(); ++i)
+  {
+    inout_trajectories[i].Clear();
+    trajectoryIndices.Insert(inout_trajectories[i].m_uiBodyId, i);
+  }
+
+  nsJvdClipReader reader;
+  if (reader.Open(sFilePath).Failed())
+    return NS_FAILURE;
+
+  nsJvdFrame frame;
+  while (reader.HasMoreFrames())
+  {
+    if (reader.ReadNextFrame(frame).Failed())
+    {
+      nsLog::Error("Failed to read the frames of '{0}'.", sFilePath);
+      return NS_FAILURE;
+    }
+
+    for (const nsJvdBodyState& state : frame.m_Bodies)
+    {
+      nsUInt32 uiTrajectory = 0;
+      if (trajectoryIndices.TryGetValue(state.m_uiBodyId, uiTrajectory))
+      {
+        inout_trajectories[uiTrajectory].AddSample(frame, state);
+      }
+    }
+  }
+
+  // the sample count is not known up front, drop the excess capacity of the grown arrays
+  for (nsJvdBodyTrajectory& trajectory : inout_trajectories)
+  {
+    trajectory.m_FrameIndices.Compact();
+    trajectory.m_Timestamps.Compact();
+    trajectory.m_Positions.Compact();
+    trajectory.m_Rotations.Compact();
+    trajectory.m_LinearVelocities.Compact();
+    trajectory.m_AngularVelocities.Compact();
+  }
+
+  return NS_SUCCESS;
+}
+
+nsJvdTrajectoryCache::nsJvdTrajectoryCache() = default;
+nsJvdTrajectoryCache::~nsJvdTrajectoryCache() = default;
+
+void nsJvdTrajectoryCache::SetClip(const nsJvdClip* pClip)
+{
+  Clear();
+  m_pClip = pClip;
+  m_sFilePath.Clear();
+}
+
+void nsJvdTrajectoryCache::SetClipFile(nsStringView sFilePath)
+{
+  Clear();
+  m_pClip = nullptr;
+  m_sFilePath = sFilePath;
+}
+
+void nsJvdTrajectoryCache::Clear()
+{
+  m_Entries.Clear();
+  m_LastUses.Clear();
+  m_uiMemoryUsage = 0;
+}
+
+void nsJvdTrajectoryCache::SetMemoryBudget(nsUInt64 uiBytes)
+{
+  m_uiMemoryBudget = uiBytes;
+  EvictOverBudget();
+}
+
+nsSharedPtr<const nsJvdBodyTrajectory> nsJvdTrajectoryCache::GetTrajectory(nsUInt64 uiBodyId)
+{
+  nsDynamicArray<nsSharedPtr<const nsJvdBodyTrajectory>> trajectories;
+  if (GetTrajectories(nsMakeArrayPtr(&uiBodyId, 1), trajectories).Failed())
+    return nullptr;
+
+  return trajectories[0];
+}
+
+nsResult nsJvdTrajectoryCache::GetTrajectories(nsArrayPtr<const nsUInt64> bodyIds, nsDynamicArray<nsSharedPtr<const nsJvdBodyTrajectory>>& out_trajectories)
+{
+  out_trajectories.Clear();
+  out_trajectories.SetCount(bodyIds.GetCount());
+
+  nsDynamicArray<nsJvdBodyTrajectory> missing;
+  nsHashTable<nsUInt64, nsUInt32> missingIndices;
+  for (nsUInt32 i = 0; i < bodyIds.GetCount(); ++i)
+  {
+    if (Entry* pEntry = m_Entries.GetValue(bodyIds[i]))
+    {
+      MarkUsed(*pEntry);
+      out_trajectories[i] = pEntry->m_pTrajectory;
+      continue;
+    }
+
+    bool bRequested = false;
+    nsUInt32& uiMissing = missingIndices.FindOrAdd(bodyIds[i], &bRequested);
+    if (!bRequested)
+    {
+      uiMissing = missing.GetCount();
+      missing.ExpandAndGetRef().m_uiBodyId = bodyIds[i];
+    }
+  }
+
+  if (!missing.IsEmpty())
+  {
+    if (m_pClip != nullptr)
+    {
+      BuildTrajectories(m_pClip->GetFrames(), missing);
+    }
+    else if (!m_sFilePath.IsEmpty())
+    {
+      if (BuildTrajectories(m_sFilePath, missing).Failed())
+      {
+        out_trajectories.Clear();
+        return NS_FAILURE;
+      }
+    }
+
+    m_uiBuildCount += missing.GetCount();
+
+    nsDynamicArray<nsSharedPtr<const nsJvdBodyTrajectory>> built;
+    built.Reserve(missing.GetCount());
+    for (nsJvdBodyTrajectory& trajectory : missing)
+    {
+      nsSharedPtr<nsJvdBodyTrajectory> pTrajectory = NS_DEFAULT_NEW(nsJvdBodyTrajectory);
+      *pTrajectory = std::move(trajectory);
+
+      built.PushBack(pTrajectory);
+      AddEntry(pTrajectory);
+    }
+
+    for (nsUInt32 i = 0; i < bodyIds.GetCount(); ++i)
+    {
+      nsUInt32 uiMissing = 0;
+      if (out_trajectories[i] == nullptr && missingIndices.TryGetValue(bodyIds[i], uiMissing))
+      {
+        out_trajectories[i] = built[uiMissing];
+      }
+    }
+
+    // the new trajectories are the most recently used ones, older ones are evicted first
+    EvictOverBudget();
+  }
+
+  return NS_SUCCESS;
+}
+
+void nsJvdTrajectoryCache::AddEntry(nsSharedPtr<const nsJvdBodyTrajectory> pTrajectory)
+{
+  const nsUInt64 uiBodyId = pTrajectory->m_uiBodyId;
+
+  Entry entry;
+  entry.m_uiMemoryUsage = pTrajectory->GetHeapMemoryUsage() + sizeof(nsJvdBodyTrajectory);
+  entry.m_uiLastUse = ++m_uiUseCounter;
+  entry.m_pTrajectory = std::move(pTrajectory);
+
+  m_uiMemoryUsage += entry.m_uiMemoryUsage;
+  m_LastUses.Insert(entry.m_uiLastUse, uiBodyId);
+  m_Entries.Insert(uiBodyId, std::move(entry));
+}
+
+void nsJvdTrajectoryCache::MarkUsed(Entry& inout_entry)
+{
+  m_LastUses.Remove(inout_entry.m_uiLastUse);
+  inout_entry.m_uiLastUse = ++m_uiUseCounter;
+  m_LastUses.Insert(inout_entry.m_uiLastUse, inout_entry.m_pTrajectory->m_uiBodyId);
+}
+
+void nsJvdTrajectoryCache::EvictOverBudget()
+{
+  while (m_uiMemoryUsage > m_uiMemoryBudget && !m_LastUses.IsEmpty())
+  {
+    auto oldest = m_LastUses.GetIterator();
+
+    Entry entry;
+    m_Entries.Remove(oldest.Value(), &entry);
+    m_uiMemoryUsage -= entry.m_uiMemoryUsage;
+    m_LastUses.Remove(oldest);
+  }
+}
+
+NS_STATICLINK_FILE(JVDSDK, Analysis_JvdTrajectoryCache);
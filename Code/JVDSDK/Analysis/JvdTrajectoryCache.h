@@ -0,0 +1,105 @@
+#pragma once
+
+#include <JVDSDK/Recording/JvdRecordingTypes.h>
+
+#include <Foundation/Containers/Bitfield.h>
+#include <Foundation/Containers/HashTable.h>
+#include <Foundation/Containers/Map.h>
+#include <Foundation/Types/RefCounted.h>
+#include <Foundation/Types/SharedPtr.h>
+
+class nsStreamWriter;
+
+/// \brief All recorded states of one body, one array per property, so that plots and exports read them sequentially.
+///
+/// Sample i of every array belongs to the same frame. Frames in which the body was not recorded have no sample.
+struct NS_JVDSDK_DLL nsJvdBodyTrajectory : public nsRefCounted
+{
+  nsUInt64 m_uiBodyId = 0;
+
+  nsDynamicArray<nsUInt64> m_FrameIndices;
+  nsDynamicArray<nsTime> m_Timestamps;
+  nsDynamicArray<nsVec3> m_Positions;
+  nsDynamicArray<nsQuat> m_Rotations;
+  nsDynamicArray<nsVec3> m_LinearVelocities;
+  nsDynamicArray<nsVec3> m_AngularVelocities;
+  nsDynamicBitfield m_Sleeping;
+
+  nsUInt32 GetSampleCount() const { return m_FrameIndices.GetCount(); }
+  bool IsEmpty() const { return m_FrameIndices.IsEmpty(); }
+
+  void Clear();
+  void Reserve(nsUInt32 uiSampleCount);
+  void AddSample(const nsJvdFrame& frame, const nsJvdBodyState& state);
+
+  nsUInt64 GetHeapMemoryUsage() const;
+
+  /// \brief Writes the header line used by WriteCsv().
+  static nsResult WriteCsvHeader(nsStreamWriter& inout_stream);
+
+  /// \brief Writes one line per sample, see WriteCsvHeader() for the columns.
+  nsResult WriteCsv(nsStreamWriter& inout_stream) const;
+};
+
+/// \brief Builds nsJvdBodyTrajectory objects on demand from a clip or a .jvdrec file and keeps the recently used ones.
+///
+/// Trajectories are handed out as shared pointers, so they stay valid after they were evicted. When the memory budget is
+/// exceeded, the least recently requested trajectories are dropped first. Not thread-safe.
+class NS_JVDSDK_DLL nsJvdTrajectoryCache
+{
+public:
+  nsJvdTrajectoryCache();
+  ~nsJvdTrajectoryCache();
+
+  /// \brief Builds the trajectories from the frames of the clip, which must stay alive and unchanged while it is set.
+  void SetClip(const nsJvdClip* pClip);
+
+  /// \brief Builds the trajectories by decoding the frame blocks of the file. Every build reads the file once, so request
+  /// all bodies of interest with one call to GetTrajectories().
+  void SetClipFile(nsStringView sFilePath);
+
+  /// \brief Drops all cached trajectories.
+  void Clear();
+
+  void SetMemoryBudget(nsUInt64 uiBytes);
+  nsUInt64 GetMemoryBudget() const { return m_uiMemoryBudget; }
+  nsUInt64 GetMemoryUsage() const { return m_uiMemoryUsage; }
+  nsUInt32 GetCachedCount() const { return m_Entries.GetCount(); }
+
+  /// \brief How often trajectories had to be built, e.g. to verify that a plot does not rebuild them every frame.
+  nsUInt32 GetBuildCount() const { return m_uiBuildCount; }
+
+  /// \brief Returns the trajectory of the body, building it if it is not cached. Returns nullptr if the file can't be read.
+  nsSharedPtr<const nsJvdBodyTrajectory> GetTrajectory(nsUInt64 uiBodyId);
+
+  /// \brief Like GetTrajectory() for several bodies, all missing trajectories are built within one pass over the frames.
+  nsResult GetTrajectories(nsArrayPtr<const nsUInt64> bodyIds, nsDynamicArray<nsSharedPtr<const nsJvdBodyTrajectory>>& out_trajectories);
+
+  /// \brief Builds the trajectories of the given bodies from the frames, in parallel.
+  static void BuildTrajectories(nsArrayPtr<const nsJvdFrame> frames, nsArrayPtr<nsJvdBodyTrajectory> inout_trajectories);
+
+  /// \brief Builds the trajectories of the given bodies in one pass over the frame blocks of a file.
+  static nsResult BuildTrajectories(nsStringView sFilePath, nsArrayPtr<nsJvdBodyTrajectory> inout_trajectories);
+
+private:
+  struct Entry
+  {
+    nsSharedPtr<const nsJvdBodyTrajectory> m_pTrajectory;
+    nsUInt64 m_uiMemoryUsage = 0;
+    nsUInt64 m_uiLastUse = 0; ///< Key in m_LastUses.
+  };
+
+  void AddEntry(nsSharedPtr<const nsJvdBodyTrajectory> pTrajectory);
+  void MarkUsed(Entry& inout_entry);
+  void EvictOverBudget();
+
+  const nsJvdClip* m_pClip = nullptr;
+  nsString m_sFilePath;
+
+  nsHashTable<nsUInt64, Entry> m_Entries;
+  nsMap<nsUInt64, nsUInt64> m_LastUses; ///< Body ids ordered by last use, the first one is evicted first.
+  nsUInt64 m_uiMemoryBudget = 64 * 1024 * 1024;
+  nsUInt64 m_uiMemoryUsage = 0;
+  nsUInt64 m_uiUseCounter = 0;
+  nsUInt32 m_uiBuildCount = 0;
+};
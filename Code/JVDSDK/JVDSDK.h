@@ -2,11 +2,29 @@
 
 #include <JVDSDK/JVDSDKDLL.h>
 
+#include <JVDSDK/Analysis/JvdClipDiff.h>
+#include <JVDSDK/Analysis/JvdSpatialIndex.h>
+#include <JVDSDK/Analysis/JvdTrajectoryCache.h>
+#include <JVDSDK/Recording/JvdAnomalyDetector.h>
+#include <JVDSDK/Recording/JvdBodyCapture.h>
 #include <JVDSDK/Recording/JvdConversion.h>
+#include <JVDSDK/Recording/JvdCustomChannels.h>
+#include <JVDSDK/Recording/JvdFrameQueue.h>
+#include <JVDSDK/Recording/JvdLogQueue.h>
+#include <JVDSDK/Recording/JvdProfilingCapture.h>
+#include <JVDSDK/Recording/JvdProfilingData.h>
 #include <JVDSDK/Recording/JvdRecorder.h>
+#include <JVDSDK/Recording/JvdRecordingSession.h>
 #include <JVDSDK/Recording/JvdRecordingTypes.h>
+#include <JVDSDK/Recording/JvdTimelineSummary.h>
+#include <JVDSDK/Serialization/JvdClipSimplification.h>
 #include <JVDSDK/Serialization/JvdStreamSerializer.h>
 #include <JVDSDK/Serialization/JvdFileIO.h>
+#include <JVDSDK/Networking/JvdDictionaryCompressor.h>
 #include <JVDSDK/Networking/JvdSession.h>
+#include <JVDSDK/Networking/JvdSharedMemoryRing.h>
 #include <JVDSDK/Networking/JvdTelemetryBridge.h>
+#include <JVDSDK/Playback/JvdBodyCulling.h>
+#include <JVDSDK/Playback/JvdBodyPicking.h>
+#include <JVDSDK/Playback/JvdMotionHistory.h>
 #include <JVDSDK/Playback/JvdPlaybackController.h>
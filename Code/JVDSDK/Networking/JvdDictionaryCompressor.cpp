@@ -0,0 +1,167 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Networking/JvdDictionaryCompressor.h>
+
+#include <Foundation/Algorithm/HashingUtils.h>
+#include <Foundation/Logging/Log.h>
+
+#ifdef BUILDSYSTEM_ENABLE_ZSTD_SUPPORT
+#  include <zstd/zstd.h>
+#endif
+
+nsJvdDictionaryCompressor::nsJvdDictionaryCompressor() = default;
+
+nsJvdDictionaryCompressor::~nsJvdDictionaryCompressor()
+{
+  Clear();
+}
+
+bool nsJvdDictionaryCompressor::IsSupported()
+{
+#ifdef BUILDSYSTEM_ENABLE_ZSTD_SUPPORT
+  return true;
+#else
+  return false;
+#endif
+}
+
+void nsJvdDictionaryCompressor::StartTraining(nsUInt32 uiTrainingSamples, nsUInt32 uiMaxDictionarySize, nsInt32 iCompressionLevel)
+{
+  Clear();
+
+  m_uiTrainingSamples = nsMath::Max(uiTrainingSamples, 1u);
+  m_uiMaxDictionarySize = nsMath::Max(uiMaxDictionarySize, 1024u);
+  m_iCompressionLevel = iCompressionLevel;
+}
+
+bool nsJvdDictionaryCompressor::AddTrainingSample(nsArrayPtr<const nsUInt8> data)
+{
+  if (!IsSupported() || HasDictionary() || m_uiTrainingSamples == 0)
+    return false;
+
+  m_Dictionary.PushBackRange(data);
+  ++m_uiNumSamples;
+
+  if (m_uiNumSamples < m_uiTrainingSamples)
+    return false;
+
+  // zstd prefers matches close to the end of a raw dictionary, so the newest samples are kept
+  if (m_Dictionary.GetCount() > m_uiMaxDictionarySize)
+  {
+    m_Dictionary.RemoveAtAndCopy(0, m_Dictionary.GetCount() - m_uiMaxDictionarySize);
+  }
+
+  m_uiDictionaryId = nsMath::Max(nsHashingUtils::xxHash32(m_Dictionary.GetData(), m_Dictionary.GetCount()), 1u);
+  CreateDictionaries();
+  return true;
+}
+
+nsResult nsJvdDictionaryCompressor::Compress(nsArrayPtr<const nsUInt8> data, nsDynamicArray<nsUInt8>& out_compressed)
+{
+  NS_ASSERT_DEV(HasDictionary(), "Compress() requires a dictionary.");
+
+#ifdef BUILDSYSTEM_ENABLE_ZSTD_SUPPORT
+  if (m_pCompressionDictionary == nullptr)
+    return NS_FAILURE;
+
+  out_compressed.SetCountUninitialized(static_cast<nsUInt32>(ZSTD_compressBound(data.GetCount())));
+
+  const size_t uiCompressedSize = ZSTD_compress_usingCDict(m_pCompressionContext, out_compressed.GetData(), out_compressed.GetCount(), data.GetPtr(), data.GetCount(), m_pCompressionDictionary);
+  if (ZSTD_isError(uiCompressedSize))
+  {
+    nsLog::Error("Failed to compress a message with a dictionary: '{0}'.", ZSTD_getErrorName(uiCompressedSize));
+    out_compressed.Clear();
+    return NS_FAILURE;
+  }
+
+  out_compressed.SetCountUninitialized(static_cast<nsUInt32>(uiCompressedSize));
+  return NS_SUCCESS;
+#else
+  NS_IGNORE_UNUSED(data);
+  NS_IGNORE_UNUSED(out_compressed);
+  return NS_FAILURE;
+#endif
+}
+
+nsResult nsJvdDictionaryCompressor::SetDictionary(nsUInt32 uiDictionaryId, nsArrayPtr<const nsUInt8> dictionary)
+{
+  Clear();
+
+  if (!IsSupported() || uiDictionaryId == 0)
+    return NS_FAILURE;
+
+  m_Dictionary = dictionary;
+  m_uiDictionaryId = uiDictionaryId;
+  CreateDictionaries();
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdDictionaryCompressor::Decompress(nsUInt32 uiDictionaryId, nsArrayPtr<const nsUInt8> compressed, nsUInt32 uiUncompressedSize, nsDynamicArray<nsUInt8>& out_data)
+{
+  if (uiDictionaryId != m_uiDictionaryId || uiDictionaryId == 0)
+    return NS_FAILURE;
+
+#ifdef BUILDSYSTEM_ENABLE_ZSTD_SUPPORT
+  if (m_pDecompressionDictionary == nullptr)
+    return NS_FAILURE;
+
+  // the frame header carries the content size, a message that claims something else is rejected before allocating
+  const unsigned long long uiContentSize = ZSTD_getFrameContentSize(compressed.GetPtr(), compressed.GetCount());
+  if (uiUncompressedSize > MaxMessageSize || uiContentSize != uiUncompressedSize)
+  {
+    nsLog::Error("Failed to decompress a message with a dictionary: invalid size {0}.", uiUncompressedSize);
+    out_data.Clear();
+    return NS_FAILURE;
+  }
+
+  out_data.SetCountUninitialized(uiUncompressedSize);
+
+  const size_t uiActualSize = ZSTD_decompress_usingDDict(m_pDecompressionContext, out_data.GetData(), uiUncompressedSize, compressed.GetPtr(), compressed.GetCount(), m_pDecompressionDictionary);
+  if (ZSTD_isError(uiActualSize) || uiActualSize != uiUncompressedSize)
+  {
+    nsLog::Error("Failed to decompress a message with a dictionary: '{0}'.", ZSTD_isError(uiActualSize) ? ZSTD_getErrorName(uiActualSize) : "size mismatch");
+    out_data.Clear();
+    return NS_FAILURE;
+  }
+
+  return NS_SUCCESS;
+#else
+  NS_IGNORE_UNUSED(compressed);
+  NS_IGNORE_UNUSED(uiUncompressedSize);
+  NS_IGNORE_UNUSED(out_data);
+  return NS_FAILURE;
+#endif
+}
+
+void nsJvdDictionaryCompressor::Clear()
+{
+#ifdef BUILDSYSTEM_ENABLE_ZSTD_SUPPORT
+  ZSTD_freeCDict(m_pCompressionDictionary);
+  ZSTD_freeCCtx(m_pCompressionContext);
+  ZSTD_freeDDict(m_pDecompressionDictionary);
+  ZSTD_freeDCtx(m_pDecompressionContext);
+#endif
+
+  m_pCompressionDictionary = nullptr;
+  m_pCompressionContext = nullptr;
+  m_pDecompressionDictionary = nullptr;
+  m_pDecompressionContext = nullptr;
+
+  m_Dictionary.Clear();
+  m_uiDictionaryId = 0;
+  m_uiTrainingSamples = 0;
+  m_uiNumSamples = 0;
+}
+
+void nsJvdDictionaryCompressor::CreateDictionaries()
+{
+#ifdef BUILDSYSTEM_ENABLE_ZSTD_SUPPORT
+  // the dictionary has no zstd header, so both sides load it as raw content
+  m_pCompressionContext = ZSTD_createCCtx();
+  m_pCompressionDictionary = ZSTD_createCDict(m_Dictionary.GetData(), m_Dictionary.GetCount(), m_iCompressionLevel);
+  m_pDecompressionContext = ZSTD_createDCtx();
+  m_pDecompressionDictionary = ZSTD_createDDict(m_Dictionary.GetData(), m_Dictionary.GetCount());
+#endif
+}
+
+NS_STATICLINK_FILE(JVDSDK, Networking_JvdDictionaryCompressor);
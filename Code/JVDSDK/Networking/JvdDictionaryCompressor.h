@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JVDSDK/JVDSDKDLL.h>
+
+#include <Foundation/Containers/DynamicArray.h>
+
+struct ZSTD_CCtx_s;
+struct ZSTD_CDict_s;
+struct ZSTD_DCtx_s;
+struct ZSTD_DDict_s;
+
+/// \brief zstd compression of many small, similar messages, such as live frames, with a shared dictionary.
+///
+/// Generic compression of a single frame finds little to work with, but consecutive frames repeat most of their
+/// bytes. The compressing side collects the first messages of a session as training samples and uses their content
+/// as a raw zstd dictionary. The dictionary is sent to the other side once, after that every message only encodes
+/// what differs from it.
+///
+/// The dictionary id is a hash of its content, so a receiver never decodes with the dictionary of an older session.
+class NS_JVDSDK_DLL nsJvdDictionaryCompressor
+{
+  NS_DISALLOW_COPY_AND_ASSIGN(nsJvdDictionaryCompressor);
+
+public:
+  nsJvdDictionaryCompressor();
+  ~nsJvdDictionaryCompressor();
+
+  /// \brief Decompress() rejects larger messages before allocating, the size comes from the other side of a connection.
+  static constexpr nsUInt32 MaxMessageSize = 64 * 1024 * 1024;
+
+  /// \brief Whether the build has zstd support. Without it training never completes.
+  static bool IsSupported();
+
+  /// \brief Compressing side. Drops the current dictionary and collects uiTrainingSamples messages for a new one.
+  void StartTraining(nsUInt32 uiTrainingSamples, nsUInt32 uiMaxDictionarySize = 64 * 1024, nsInt32 iCompressionLevel = 3);
+
+  /// \brief Compressing side. Returns true when this sample completed the dictionary.
+  bool AddTrainingSample(nsArrayPtr<const nsUInt8> data);
+
+  bool HasDictionary() const { return m_uiDictionaryId != 0; }
+  nsUInt32 GetDictionaryId() const { return m_uiDictionaryId; }
+  nsArrayPtr<const nsUInt8> GetDictionary() const { return m_Dictionary; }
+
+  /// \brief Compressing side. Requires a dictionary.
+  nsResult Compress(nsArrayPtr<const nsUInt8> data, nsDynamicArray<nsUInt8>& out_compressed);
+
+  /// \brief Decompressing side. Replaces the dictionary with one received from the compressing side.
+  nsResult SetDictionary(nsUInt32 uiDictionaryId, nsArrayPtr<const nsUInt8> dictionary);
+
+  /// \brief Decompressing side. Fails if the message was compressed with another dictionary or does not decode to uiUncompressedSize bytes.
+  nsResult Decompress(nsUInt32 uiDictionaryId, nsArrayPtr<const nsUInt8> compressed, nsUInt32 uiUncompressedSize, nsDynamicArray<nsUInt8>& out_data);
+
+  /// \brief Releases the dictionary and all zstd contexts.
+  void Clear();
+
+private:
+  void CreateDictionaries();
+
+  nsDynamicArray<nsUInt8> m_Dictionary;
+  nsUInt32 m_uiDictionaryId = 0;
+
+  nsUInt32 m_uiTrainingSamples = 0;
+  nsUInt32 m_uiNumSamples = 0;
+  nsUInt32 m_uiMaxDictionarySize = 0;
+  nsInt32 m_iCompressionLevel = 3;
+
+  ZSTD_CCtx_s* m_pCompressionContext = nullptr;
+  ZSTD_CDict_s* m_pCompressionDictionary = nullptr;
+  ZSTD_DCtx_s* m_pDecompressionContext = nullptr;
+  ZSTD_DDict_s* m_pDecompressionDictionary = nullptr;
+};
@@ -2,8 +2,17 @@
 
 #include <JVDSDK/Networking/JvdSession.h>
 
+#include <Foundation/IO/MemoryStream.h>
 #include <Foundation/Logging/Log.h>
 
+namespace
+{
+  void GetSharedMemoryName(nsUInt16 uiPort, nsStringBuilder& out_sName)
+  {
+    out_sName.SetFormat("/nsJvdSession{0}", uiPort);
+  }
+} // namespace
+
 nsJvdSession::nsJvdSession() = default;
 
 nsJvdSession::~nsJvdSession()
@@ -20,9 +29,26 @@ nsResult nsJvdSession::Initialize(const nsJvdSessionConfiguration& config)
 
   m_Config = config;
 
+  if (config.m_Transport == nsJvdTransport::SharedMemory)
+  {
+    nsStringBuilder sName;
+    GetSharedMemoryName(config.m_uiPort, sName);
+
+    const nsResult result = config.m_bStartAsServer ? m_SharedMemory.CreateWriter(sName, config.m_uiSharedMemorySize) : m_SharedMemory.OpenReader(sName, config.m_uiSharedMemorySize);
+    if (result.Failed())
+    {
+      nsLog::Error("nsJvdSession failed to open the shared-memory transport.");
+      return result;
+    }
+
+    m_bInitialized = true;
+    return NS_SUCCESS;
+  }
+
   nsResult result = NS_FAILURE;
   if (config.m_bStartAsServer)
   {
+    m_Telemetry.SetFrameCompression(config.m_bCompressFrames);
     result = m_Telemetry.StartServer(config.m_uiPort, config.m_sSessionName);
   }
   else
@@ -51,6 +77,17 @@ void nsJvdSession::Shutdown()
   if (!m_bInitialized)
     return;
 
+  if (m_SharedMemory.IsOpen())
+  {
+    m_SharedMemory.Close();
+
+    m_FrameEvent.Clear();
+    m_ClipEvent.Clear();
+
+    m_bInitialized = false;
+    return;
+  }
+
   m_Telemetry.OnFrameReceived().RemoveEventHandler(m_TelemetryFrameHandler);
   m_Telemetry.OnClipReceived().RemoveEventHandler(m_TelemetryClipHandler);
 
@@ -67,6 +104,16 @@ void nsJvdSession::Update()
   if (!m_bInitialized)
     return;
 
+  if (m_SharedMemory.IsOpen())
+  {
+    if (!m_SharedMemory.IsWriter())
+    {
+      ReceiveSharedMemoryMessages();
+    }
+
+    return;
+  }
+
   m_Telemetry.Update();
 }
 
@@ -75,6 +122,15 @@ void nsJvdSession::BroadcastFrame(const nsJvdFrame& frame)
   if (!m_bInitialized)
     return;
 
+  if (m_SharedMemory.IsOpen())
+  {
+    // like unreliable telemetry messages, frames that don't fit are dropped and counted by the ring
+    m_SharedMemory.WriteMessage(nsJvdIds::g_uiTelemetryFrameMessageId, [&](nsStreamWriter& inout_writer)
+                    { return nsJvdSerialization::WriteFrame(inout_writer, frame); })
+      .IgnoreResult();
+    return;
+  }
+
   m_Telemetry.SendFrame(frame);
 }
 
@@ -83,9 +139,67 @@ void nsJvdSession::BroadcastClip(const nsJvdClip& clip)
   if (!m_bInitialized)
     return;
 
+  if (m_SharedMemory.IsOpen())
+  {
+    if (m_SharedMemory.WriteMessage(nsJvdIds::g_uiTelemetryClipMessageId, [&](nsStreamWriter& inout_writer)
+                          { return nsJvdSerialization::WriteClip(inout_writer, clip); })
+          .Failed())
+    {
+      nsLog::Error("Failed to send the clip, it doesn't fit into the free part of the shared-memory ring.");
+    }
+    return;
+  }
+
   m_Telemetry.SendClip(clip);
 }
 
+void nsJvdSession::ReceiveSharedMemoryMessages()
+{
+  nsUInt32 uiMessageId = 0;
+  nsArrayPtr<const nsUInt8> data;
+
+  while (m_SharedMemory.PeekMessage(uiMessageId, data))
+  {
+    // decoded in place, the message stays in the ring until it is popped
+    nsRawMemoryStreamReader reader(data.GetPtr(), data.GetCount());
+
+    switch (uiMessageId)
+    {
+      case nsJvdIds::g_uiTelemetryFrameMessageId:
+      {
+        if (nsJvdSerialization::ReadFrame(reader, m_ReceivedFrame).Succeeded())
+        {
+          m_FrameEvent.Broadcast(m_ReceivedFrame);
+        }
+        else
+        {
+          nsLog::Warning("nsJvdSession: Failed to deserialize a shared-memory frame message.");
+        }
+        break;
+      }
+
+      case nsJvdIds::g_uiTelemetryClipMessageId:
+      {
+        nsJvdClip clip;
+        if (nsJvdSerialization::ReadClip(reader, clip).Succeeded())
+        {
+          m_ClipEvent.Broadcast(clip);
+        }
+        else
+        {
+          nsLog::Warning("nsJvdSession: Failed to deserialize a shared-memory clip message.");
+        }
+        break;
+      }
+
+      default:
+        break;
+    }
+
+    m_SharedMemory.PopMessage();
+  }
+}
+
 void nsJvdSession::ForwardFrame(const nsJvdFrame& frame)
 {
   m_FrameEvent.Broadcast(frame);
@@ -1,16 +1,40 @@
 #pragma once
 
+#include <JVDSDK/Networking/JvdSharedMemoryRing.h>
 #include <JVDSDK/Networking/JvdTelemetryBridge.h>
 
 #include <Foundation/Strings/String.h>
 #include <Foundation/Types/Delegate.h>
 
+/// \brief How frames travel between the game and the viewer.
+struct nsJvdTransport
+{
+  using StorageType = nsUInt8;
+
+  enum Enum : nsUInt8
+  {
+    Telemetry,    ///< Through nsTelemetry, works across machines.
+    SharedMemory, ///< Through an nsJvdSharedMemoryRing, only on the same machine but without network overhead.
+
+    Default = Telemetry
+  };
+};
+
 struct NS_JVDSDK_DLL nsJvdSessionConfiguration
 {
   nsString m_sEndpoint;
   nsString m_sSessionName;
   nsUInt16 m_uiPort = 1040;
   bool m_bStartAsServer = true;
+
+  /// With SharedMemory the server writes and the client reads. Both find the ring through the port.
+  nsJvdTransport::Enum m_Transport = nsJvdTransport::Default;
+
+  /// Telemetry only: the server compresses frames with a zstd dictionary trained on the first frames of the session.
+  bool m_bCompressFrames = false;
+
+  /// Size of the shared-memory ring, must be the same in the game and the viewer.
+  nsUInt64 m_uiSharedMemorySize = 64 * 1024 * 1024;
 };
 
 class NS_JVDSDK_DLL nsJvdSession
@@ -33,11 +57,17 @@ public:
   const nsJvdSessionConfiguration& GetConfiguration() const { return m_Config; }
   bool IsRunning() const { return m_bInitialized; }
 
+  /// \brief Frames and clips the server could not send because the shared-memory ring was full.
+  nsUInt64 GetNumDroppedMessages() const { return m_SharedMemory.GetNumDroppedMessages(); }
+
 private:
   void ForwardFrame(const nsJvdFrame& frame);
   void ForwardClip(const nsJvdClip& clip);
+  void ReceiveSharedMemoryMessages();
 
   nsJvdTelemetryBridge m_Telemetry;
+  nsJvdSharedMemoryRing m_SharedMemory;
+  nsJvdFrame m_ReceivedFrame;
   nsJvdSessionConfiguration m_Config;
   bool m_bInitialized = false;
 
@@ -0,0 +1,355 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Networking/JvdSharedMemoryRing.h>
+
+#include <Foundation/IO/MemoryStream.h>
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Threading/AtomicUtils.h>
+
+/// Lives at the start of the shared memory. The offsets only grow, the position in the ring is the offset modulo the
+/// capacity. Each offset is written by one side only and sits in its own cache line.
+struct nsJvdSharedRingHeader
+{
+  nsInt32 m_iMagic; ///< Written last when the writer (re)initializes the ring.
+  nsInt32 m_iVersion;
+  nsInt64 m_iCapacity;
+  nsInt64 m_iResetCount; ///< Incremented whenever the writer resets the offsets, a message peeked before is not popped.
+
+  alignas(64) nsInt64 m_iWriteOffset;
+  nsInt64 m_iDroppedMessages;
+
+  alignas(64) nsInt64 m_iReadOffset;
+};
+
+namespace
+{
+  constexpr nsInt32 g_iSharedRingMagic = 0x4A565252; // 'JVRR'
+  constexpr nsInt32 g_iSharedRingVersion = 2;
+
+  /// Message ids are never zero, a record with this id tells the reader to continue at the front of the ring.
+  constexpr nsUInt32 g_uiWrapMarker = 0;
+
+  struct RecordHeader
+  {
+    nsUInt32 m_uiSize;
+    nsUInt32 m_uiMessageId;
+  };
+
+  constexpr nsUInt64 g_uiRecordAlignment = sizeof(RecordHeader);
+
+  nsUInt64 GetRecordSize(nsUInt64 uiPayloadSize)
+  {
+    return nsMemoryUtils::AlignSize<nsUInt64>(sizeof(RecordHeader) + uiPayloadSize, g_uiRecordAlignment);
+  }
+} // namespace
+
+nsJvdSharedMemoryRing::nsJvdSharedMemoryRing() = default;
+
+nsJvdSharedMemoryRing::~nsJvdSharedMemoryRing()
+{
+  Close();
+}
+
+nsResult nsJvdSharedMemoryRing::CreateWriter(nsStringView sName, nsUInt64 uiCapacity)
+{
+  NS_SUCCEED_OR_RETURN(OpenInternal(sName, uiCapacity));
+
+  m_bWriter = true;
+  ResetWriter();
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdSharedMemoryRing::OpenReader(nsStringView sName, nsUInt64 uiCapacity)
+{
+  NS_SUCCEED_OR_RETURN(OpenInternal(sName, uiCapacity));
+
+  m_bWriter = false;
+
+  if (IsReady())
+  {
+    // skip everything that was written before this reader showed up, a writer that comes later starts at zero anyway
+    nsAtomicUtils::Set(m_pHeader->m_iReadOffset, nsAtomicUtils::Read(m_pHeader->m_iWriteOffset));
+  }
+
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdSharedMemoryRing::OpenInternal(nsStringView sName, nsUInt64 uiCapacity)
+{
+  Close();
+
+#if NS_ENABLED(NS_SUPPORTS_SHARED_MEMORY)
+  m_uiCapacity = nsMemoryUtils::AlignSize<nsUInt64>(nsMath::Max<nsUInt64>(uiCapacity, 1024), g_uiRecordAlignment);
+
+  if (m_Memory.OpenShared(sName, sizeof(nsJvdSharedRingHeader) + m_uiCapacity, nsMemoryMappedFile::Mode::ReadWrite).Failed())
+  {
+    nsLog::Error("nsJvdSharedMemoryRing: Failed to map the shared memory '{0}'.", sName);
+    Close();
+    return NS_FAILURE;
+  }
+
+  // whichever side comes first creates the doorbell
+  nsStringBuilder sDoorbell = sName;
+  sDoorbell.Append("_bell");
+
+  m_pDoorbell = NS_DEFAULT_NEW(nsSemaphore);
+  if (m_pDoorbell->Create(0, sDoorbell).Failed())
+  {
+    m_pDoorbell = NS_DEFAULT_NEW(nsSemaphore);
+    if (m_pDoorbell->Open(sDoorbell).Failed())
+    {
+      nsLog::Error("nsJvdSharedMemoryRing: Failed to open the doorbell '{0}'.", sDoorbell);
+      Close();
+      return NS_FAILURE;
+    }
+  }
+
+  m_pHeader = static_cast<nsJvdSharedRingHeader*>(m_Memory.GetWritePointer());
+  m_pData = static_cast<nsUInt8*>(m_Memory.GetWritePointer(sizeof(nsJvdSharedRingHeader)));
+  return NS_SUCCESS;
+#else
+  NS_IGNORE_UNUSED(uiCapacity);
+  nsLog::Error("nsJvdSharedMemoryRing: '{0}' can't be opened, this platform has no shared memory.", sName);
+  return NS_FAILURE;
+#endif
+}
+
+void nsJvdSharedMemoryRing::Close()
+{
+  m_Memory.Close();
+  m_pDoorbell.Clear();
+
+  m_pHeader = nullptr;
+  m_pData = nullptr;
+  m_uiCapacity = 0;
+  m_bWriter = false;
+  m_uiPeekedSize = 0;
+  m_bWakeRequested = false;
+}
+
+void nsJvdSharedMemoryRing::ResetWriter()
+{
+  nsAtomicUtils::Set(m_pHeader->m_iMagic, 0);
+  nsAtomicUtils::Increment(m_pHeader->m_iResetCount);
+
+  m_pHeader->m_iVersion = g_iSharedRingVersion;
+  m_pHeader->m_iCapacity = static_cast<nsInt64>(m_uiCapacity);
+  nsAtomicUtils::Set(m_pHeader->m_iWriteOffset, 0);
+  nsAtomicUtils::Set(m_pHeader->m_iReadOffset, 0);
+  nsAtomicUtils::Set(m_pHeader->m_iDroppedMessages, 0);
+
+  nsAtomicUtils::Set(m_pHeader->m_iMagic, g_iSharedRingMagic);
+}
+
+void nsJvdSharedMemoryRing::SkipUnreadMessages()
+{
+  // a reader that still holds a peeked message must not pop it into the resynced ring
+  nsAtomicUtils::Increment(m_pHeader->m_iResetCount);
+  nsAtomicUtils::Set(m_pHeader->m_iReadOffset, nsAtomicUtils::Read(m_pHeader->m_iWriteOffset));
+}
+
+bool nsJvdSharedMemoryRing::IsReady() const
+{
+  if (nsAtomicUtils::Read(m_pHeader->m_iMagic) != g_iSharedRingMagic || m_pHeader->m_iVersion != g_iSharedRingVersion)
+    return false;
+
+  if (m_pHeader->m_iCapacity != static_cast<nsInt64>(m_uiCapacity))
+  {
+    // the mapping of this side doesn't cover the ring of the writer
+    return false;
+  }
+
+  return true;
+}
+
+nsResult nsJvdSharedMemoryRing::WriteMessage(nsUInt32 uiMessageId, nsDelegate<nsResult(nsStreamWriter&)> writeFunc)
+{
+  NS_ASSERT_DEV(m_bWriter, "Only the writer may write messages.");
+  NS_ASSERT_DEV(uiMessageId != g_uiWrapMarker, "Message id 0 is reserved.");
+
+  const nsInt64 iWriteOffset = m_pHeader->m_iWriteOffset;
+  const nsInt64 iReadOffset = nsAtomicUtils::Read(m_pHeader->m_iReadOffset);
+
+  if (iReadOffset > iWriteOffset || iWriteOffset - iReadOffset > static_cast<nsInt64>(m_uiCapacity))
+  {
+    // the offsets don't belong together, e.g. a reader popped a message it peeked before the last reset
+    SkipUnreadMessages();
+    nsAtomicUtils::Increment(m_pHeader->m_iDroppedMessages);
+    return NS_FAILURE;
+  }
+
+  const nsUInt64 uiFree = m_uiCapacity - static_cast<nsUInt64>(iWriteOffset - iReadOffset);
+  const nsUInt64 uiPosition = static_cast<nsUInt64>(iWriteOffset) % m_uiCapacity;
+  const nsUInt64 uiToEnd = m_uiCapacity - uiPosition;
+
+  // encodes the message right into the shared memory, returns the size of the record or 0 if it didn't fit
+  auto TryWrite = [&](nsUInt64 uiStart, nsUInt64 uiAvailable) -> nsUInt64
+  {
+    if (uiAvailable <= sizeof(RecordHeader))
+      return 0;
+
+    nsRawMemoryStreamWriter writer(m_pData + uiStart + sizeof(RecordHeader), uiAvailable - sizeof(RecordHeader));
+    if (writeFunc(writer).Failed())
+      return 0;
+
+    RecordHeader* pRecord = reinterpret_cast<RecordHeader*>(m_pData + uiStart);
+    pRecord->m_uiSize = static_cast<nsUInt32>(writer.GetNumWrittenBytes());
+    pRecord->m_uiMessageId = uiMessageId;
+    return GetRecordSize(pRecord->m_uiSize);
+  };
+
+  nsUInt64 uiAdvance = TryWrite(uiPosition, nsMath::Min(uiFree, uiToEnd));
+
+  if (uiAdvance == 0 && uiFree > uiToEnd)
+  {
+    // start over at the front of the ring, the reader skips the rest
+    const nsUInt64 uiRecordSize = TryWrite(0, uiFree - uiToEnd);
+    if (uiRecordSize > 0)
+    {
+      RecordHeader* pMarker = reinterpret_cast<RecordHeader*>(m_pData + uiPosition);
+      pMarker->m_uiSize = 0;
+      pMarker->m_uiMessageId = g_uiWrapMarker;
+
+      uiAdvance = uiToEnd + uiRecordSize;
+    }
+  }
+
+  if (uiAdvance == 0)
+  {
+    nsAtomicUtils::Increment(m_pHeader->m_iDroppedMessages);
+    return NS_FAILURE;
+  }
+
+  nsAtomicUtils::Set(m_pHeader->m_iWriteOffset, iWriteOffset + static_cast<nsInt64>(uiAdvance));
+
+  // only ring if the reader had caught up, it may be about to sleep
+  if (nsAtomicUtils::Read(m_pHeader->m_iReadOffset) == iWriteOffset)
+  {
+    m_pDoorbell->ReturnToken();
+  }
+
+  return NS_SUCCESS;
+}
+
+bool nsJvdSharedMemoryRing::PeekMessage(nsUInt32& out_uiMessageId, nsArrayPtr<const nsUInt8>& out_data)
+{
+  NS_ASSERT_DEV(IsOpen() && !m_bWriter, "Only the reader may read messages.");
+
+  if (!IsReady())
+    return false;
+
+  while (true)
+  {
+    const nsInt64 iResetCount = nsAtomicUtils::Read(m_pHeader->m_iResetCount);
+    const nsInt64 iReadOffset = m_pHeader->m_iReadOffset;
+    nsInt64 iWriteOffset = nsAtomicUtils::Read(m_pHeader->m_iWriteOffset);
+
+    if (iReadOffset == iWriteOffset)
+    {
+      // swallow stale rings, every message written from now on rings again
+      while (m_pDoorbell->TryAcquireToken().Succeeded())
+      {
+      }
+
+      iWriteOffset = nsAtomicUtils::Read(m_pHeader->m_iWriteOffset);
+      if (iReadOffset == iWriteOffset)
+        return false;
+    }
+
+    if (iReadOffset > iWriteOffset || iWriteOffset - iReadOffset > static_cast<nsInt64>(m_uiCapacity))
+    {
+      // the writer was reset in between
+      nsAtomicUtils::Set(m_pHeader->m_iReadOffset, iWriteOffset);
+      return false;
+    }
+
+    // everything in the record comes from the other process, it must stay within the written part of the ring
+    const nsUInt64 uiAvailable = static_cast<nsUInt64>(iWriteOffset - iReadOffset);
+    const nsUInt64 uiPosition = static_cast<nsUInt64>(iReadOffset) % m_uiCapacity;
+    const nsUInt64 uiToEnd = m_uiCapacity - uiPosition;
+    const RecordHeader* pRecord = reinterpret_cast<const RecordHeader*>(m_pData + uiPosition);
+
+    if (uiAvailable < sizeof(RecordHeader) || uiToEnd < sizeof(RecordHeader))
+    {
+      nsAtomicUtils::Set(m_pHeader->m_iReadOffset, iWriteOffset);
+      return false;
+    }
+
+    const nsUInt32 uiMessageId = pRecord->m_uiMessageId;
+    const nsUInt32 uiSize = pRecord->m_uiSize;
+
+    if (uiMessageId == g_uiWrapMarker)
+    {
+      if (uiToEnd > uiAvailable)
+      {
+        nsAtomicUtils::Set(m_pHeader->m_iReadOffset, iWriteOffset);
+        return false;
+      }
+
+      nsAtomicUtils::Set(m_pHeader->m_iReadOffset, iReadOffset + static_cast<nsInt64>(uiToEnd));
+      continue;
+    }
+
+    const nsUInt64 uiRecordSize = GetRecordSize(uiSize);
+    if (uiRecordSize > nsMath::Min(uiAvailable, uiToEnd))
+    {
+      nsAtomicUtils::Set(m_pHeader->m_iReadOffset, iWriteOffset);
+      return false;
+    }
+
+    out_uiMessageId = uiMessageId;
+    out_data = nsArrayPtr<const nsUInt8>(m_pData + uiPosition + sizeof(RecordHeader), uiSize);
+    m_uiPeekedSize = static_cast<nsUInt32>(uiRecordSize);
+    m_iPeekedReadOffset = iReadOffset;
+    m_iPeekedResetCount = iResetCount;
+    return true;
+  }
+}
+
+void nsJvdSharedMemoryRing::PopMessage()
+{
+  NS_ASSERT_DEV(m_uiPeekedSize > 0, "PeekMessage() must return a message before it can be popped.");
+
+  // if the writer reset the ring since the message was peeked, the message is gone already
+  if (nsAtomicUtils::Read(m_pHeader->m_iResetCount) == m_iPeekedResetCount)
+  {
+    nsAtomicUtils::TestAndSet(m_pHeader->m_iReadOffset, m_iPeekedReadOffset, m_iPeekedReadOffset + m_uiPeekedSize);
+  }
+
+  m_uiPeekedSize = 0;
+}
+
+void nsJvdSharedMemoryRing::WaitForMessage()
+{
+  nsUInt32 uiMessageId = 0;
+  nsArrayPtr<const nsUInt8> data;
+
+  // PeekMessage() swallows the tokens of an empty ring, so Wake() also raises a flag that survives that
+  while (!PeekMessage(uiMessageId, data))
+  {
+    if (m_bWakeRequested.Set(false))
+      return;
+
+    // a message may have arrived in between, then the token is already there
+    m_pDoorbell->AcquireToken();
+  }
+}
+
+void nsJvdSharedMemoryRing::Wake()
+{
+  if (m_pDoorbell)
+  {
+    m_bWakeRequested = true;
+    m_pDoorbell->ReturnToken();
+  }
+}
+
+nsUInt64 nsJvdSharedMemoryRing::GetNumDroppedMessages() const
+{
+  if (m_pHeader == nullptr)
+    return 0;
+
+  return static_cast<nsUInt64>(nsAtomicUtils::Read(m_pHeader->m_iDroppedMessages));
+}
+
+NS_STATICLINK_FILE(JVDSDK, Networking_JvdSharedMemoryRing);
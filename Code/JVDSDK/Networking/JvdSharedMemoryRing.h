@@ -0,0 +1,85 @@
+#pragma once
+
+#include <JVDSDK/JVDSDKDLL.h>
+
+#include <Foundation/IO/MemoryMappedFile.h>
+#include <Foundation/IO/Stream.h>
+#include <Foundation/Threading/AtomicInteger.h>
+#include <Foundation/Threading/Semaphore.h>
+#include <Foundation/Types/Delegate.h>
+#include <Foundation/Types/UniquePtr.h>
+
+struct nsJvdSharedRingHeader;
+
+/// \brief Byte ring buffer in shared memory that carries messages from one process to another on the same machine.
+///
+/// The writer encodes every message directly into the shared memory and the reader decodes it in place, so a message
+/// is never copied. Each message is stored contiguously: if it doesn't fit before the end of the ring, it starts
+/// over at the front. Messages that don't fit at all are dropped, the writer never waits for the reader.
+///
+/// A named semaphore serves as doorbell: the writer rings it when a message arrives in an empty ring, so a reader
+/// that waits in WaitForMessage() sleeps instead of polling. nsJvdSession doesn't wait, it drains the ring in Update().
+///
+/// Both processes must use the same name and capacity. Readers only receive the messages written after they opened
+/// the ring.
+class NS_JVDSDK_DLL nsJvdSharedMemoryRing
+{
+  NS_DISALLOW_COPY_AND_ASSIGN(nsJvdSharedMemoryRing);
+
+public:
+  nsJvdSharedMemoryRing();
+  ~nsJvdSharedMemoryRing();
+
+  /// \brief Creates the ring as the writing side, or resets it if it already exists.
+  nsResult CreateWriter(nsStringView sName, nsUInt64 uiCapacity);
+
+  /// \brief Opens the ring as the reading side. The writer may create it later.
+  nsResult OpenReader(nsStringView sName, nsUInt64 uiCapacity);
+
+  void Close();
+
+  bool IsOpen() const { return m_pHeader != nullptr; }
+  bool IsWriter() const { return m_bWriter; }
+
+  /// \brief Writer only. Calls writeFunc with a stream that writes into the ring and publishes the message if it succeeds.
+  ///
+  /// Fails if the message doesn't fit into the free part of the ring. Nothing is published in that case.
+  /// writeFunc may be called a second time if the message did not fit before the end of the ring.
+  nsResult WriteMessage(nsUInt32 uiMessageId, nsDelegate<nsResult(nsStreamWriter&)> writeFunc);
+
+  /// \brief Reader only. Returns the oldest message without removing it, the data points into the shared memory.
+  ///
+  /// The data stays valid until PopMessage() is called.
+  bool PeekMessage(nsUInt32& out_uiMessageId, nsArrayPtr<const nsUInt8>& out_data);
+
+  /// \brief Reader only. Releases the message returned by PeekMessage(), so the writer can reuse its space.
+  void PopMessage();
+
+  /// \brief Reader only. Sleeps until a message arrives.
+  void WaitForMessage();
+
+  /// \brief Wakes up a thread blocked in WaitForMessage(), e.g. before shutting down.
+  void Wake();
+
+  /// \brief Messages the writer dropped because the ring was full.
+  nsUInt64 GetNumDroppedMessages() const;
+
+private:
+  nsResult OpenInternal(nsStringView sName, nsUInt64 uiCapacity);
+  bool IsReady() const;
+  void ResetWriter();
+  void SkipUnreadMessages();
+
+  nsMemoryMappedFile m_Memory;
+  nsUniquePtr<nsSemaphore> m_pDoorbell;
+
+  nsJvdSharedRingHeader* m_pHeader = nullptr;
+  nsUInt8* m_pData = nullptr;
+  nsUInt64 m_uiCapacity = 0;
+  bool m_bWriter = false;
+
+  nsUInt32 m_uiPeekedSize = 0;
+  nsInt64 m_iPeekedReadOffset = 0;
+  nsInt64 m_iPeekedResetCount = 0;
+  nsAtomicBool m_bWakeRequested;
+};
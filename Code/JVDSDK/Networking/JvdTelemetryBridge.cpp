@@ -5,6 +5,8 @@
 #include <Foundation/Communication/Telemetry.h>
 #include <Foundation/IO/MemoryStream.h>
 #include <Foundation/Logging/Log.h>
+#include <Foundation/Time/Stopwatch.h>
+#include <Foundation/Utilities/Stats.h>
 
 nsJvdTelemetryBridge::nsJvdTelemetryBridge() = default;
 
@@ -62,6 +64,18 @@ void nsJvdTelemetryBridge::Shutdown()
 
   m_bConnected = false;
   m_uiPort = 0;
+
+  // the next session trains its own dictionary
+  m_bResendDictionary = false;
+  m_Stats = {};
+  if (m_bCompressFrames)
+  {
+    m_Compressor.StartTraining(m_uiTrainingFrames);
+  }
+  else
+  {
+    m_Compressor.Clear();
+  }
 }
 
 void nsJvdTelemetryBridge::Update()
@@ -72,6 +86,29 @@ void nsJvdTelemetryBridge::Update()
   nsTelemetry::UpdateNetwork();
   nsTelemetry::PerFrameUpdate();
   ProcessIncomingMessages();
+  UpdateStats();
+}
+
+void nsJvdTelemetryBridge::SetFrameCompression(bool bEnable, nsUInt32 uiTrainingFrames)
+{
+  if (bEnable && !nsJvdDictionaryCompressor::IsSupported())
+  {
+    nsLog::Warning("nsJvdTelemetryBridge: Frame compression requires zstd support, frames are sent uncompressed.");
+    bEnable = false;
+  }
+
+  m_bCompressFrames = bEnable;
+  m_uiTrainingFrames = uiTrainingFrames;
+  m_bResendDictionary = false;
+
+  if (bEnable)
+  {
+    m_Compressor.StartTraining(uiTrainingFrames);
+  }
+  else
+  {
+    m_Compressor.Clear();
+  }
 }
 
 void nsJvdTelemetryBridge::SendFrame(const nsJvdFrame& frame)
@@ -79,16 +116,87 @@ void nsJvdTelemetryBridge::SendFrame(const nsJvdFrame& frame)
   if (nsTelemetry::GetConnectionMode() == nsTelemetry::ConnectionMode::None)
     return;
 
-  nsTelemetryMessage message;
-  message.SetMessageID(nsJvdIds::g_uiTelemetrySystemId, nsJvdIds::g_uiTelemetryFrameMessageId);
+  if (!m_bCompressFrames)
+  {
+    nsTelemetryMessage message;
+    message.SetMessageID(nsJvdIds::g_uiTelemetrySystemId, nsJvdIds::g_uiTelemetryFrameMessageId);
+
+    if (nsJvdSerialization::WriteFrame(message.GetWriter(), frame).Failed())
+    {
+      nsLog::Error("Failed to serialize frame for telemetry broadcast.");
+      return;
+    }
+
+    nsTelemetry::Broadcast(nsTelemetry::TransmitMode::Unreliable, message);
+    return;
+  }
+
+  m_FrameData.Clear();
+  {
+    nsMemoryStreamContainerWrapperStorage<nsDynamicArray<nsUInt8>> storage(&m_FrameData);
+    nsMemoryStreamWriter writer(&storage);
 
-  if (nsJvdSerialization::WriteFrame(message.GetWriter(), frame).Failed())
+    if (nsJvdSerialization::WriteFrame(writer, frame).Failed())
+    {
+      nsLog::Error("Failed to serialize frame for telemetry broadcast.");
+      return;
+    }
+  }
+
+  m_Stats.m_uiFramesSent++;
+  m_Stats.m_uiUncompressedBytes += m_FrameData.GetCount();
+  m_Stats.m_bChanged = true;
+
+  if (!m_Compressor.HasDictionary())
   {
-    nsLog::Error("Failed to serialize frame for telemetry broadcast.");
+    // the training frames are sent as they are
+    nsTelemetry::Broadcast(nsTelemetry::TransmitMode::Unreliable, nsJvdIds::g_uiTelemetrySystemId, nsJvdIds::g_uiTelemetryFrameMessageId, m_FrameData.GetData(), m_FrameData.GetCount());
+    m_Stats.m_uiSentBytes += m_FrameData.GetCount();
+
+    if (m_Compressor.AddTrainingSample(m_FrameData))
+    {
+      nsLog::Info("nsJvdTelemetryBridge: Trained a {0} byte dictionary from {1} frames.", m_Compressor.GetDictionary().GetCount(), m_uiTrainingFrames);
+      SendDictionary();
+    }
+
     return;
   }
 
+  if (m_bResendDictionary)
+  {
+    SendDictionary();
+  }
+
+  nsStopwatch sw;
+  if (m_Compressor.Compress(m_FrameData, m_CompressedData).Failed())
+    return;
+
+  m_Stats.m_CompressionTime += sw.GetRunningTotal();
+
+  nsTelemetryMessage message;
+  message.SetMessageID(nsJvdIds::g_uiTelemetrySystemId, nsJvdIds::g_uiTelemetryCompressedFrameMessageId);
+  message.GetWriter() << m_Compressor.GetDictionaryId();
+  message.GetWriter() << m_FrameData.GetCount();
+  message.GetWriter().WriteBytes(m_CompressedData.GetData(), m_CompressedData.GetCount()).AssertSuccess();
+
   nsTelemetry::Broadcast(nsTelemetry::TransmitMode::Unreliable, message);
+  m_Stats.m_uiSentBytes += sizeof(nsUInt32) * 2 + m_CompressedData.GetCount();
+}
+
+void nsJvdTelemetryBridge::SendDictionary()
+{
+  m_bResendDictionary = false;
+
+  const nsArrayPtr<const nsUInt8> dictionary = m_Compressor.GetDictionary();
+
+  nsTelemetryMessage message;
+  message.SetMessageID(nsJvdIds::g_uiTelemetrySystemId, nsJvdIds::g_uiTelemetryDictionaryMessageId);
+  message.GetWriter() << m_Compressor.GetDictionaryId();
+  message.GetWriter() << dictionary.GetCount();
+  message.GetWriter().WriteBytes(dictionary.GetPtr(), dictionary.GetCount()).AssertSuccess();
+
+  nsTelemetry::Broadcast(nsTelemetry::TransmitMode::Reliable, message);
+  m_Stats.m_uiSentBytes += sizeof(nsUInt32) * 2 + dictionary.GetCount();
 }
 
 void nsJvdTelemetryBridge::SendClip(const nsJvdClip& clip)
@@ -122,6 +230,11 @@ void nsJvdTelemetryBridge::OnTelemetryEvent(const nsTelemetry::TelemetryEventDat
   switch (data.m_EventType)
   {
     case nsTelemetry::TelemetryEventData::ConnectedToClient:
+      // the new client missed the dictionary
+      m_bResendDictionary = m_Compressor.HasDictionary() && m_bCompressFrames;
+      m_bConnected = true;
+      break;
+
     case nsTelemetry::TelemetryEventData::ConnectedToServer:
       m_bConnected = true;
       break;
@@ -160,6 +273,14 @@ void nsJvdTelemetryBridge::ProcessIncomingMessages()
         break;
       }
 
+      case nsJvdIds::g_uiTelemetryDictionaryMessageId:
+        ReceiveDictionary(reader);
+        break;
+
+      case nsJvdIds::g_uiTelemetryCompressedFrameMessageId:
+        ReceiveCompressedFrame(reader);
+        break;
+
       case nsJvdIds::g_uiTelemetryClipMessageId:
       {
         nsJvdClip clip;
@@ -180,6 +301,94 @@ void nsJvdTelemetryBridge::ProcessIncomingMessages()
   }
 }
 
+void nsJvdTelemetryBridge::ReceiveDictionary(nsMemoryStreamReader& inout_reader)
+{
+  nsUInt32 uiDictionaryId = 0;
+  nsUInt32 uiSize = 0;
+  inout_reader >> uiDictionaryId;
+  inout_reader >> uiSize;
+
+  // the dictionary is part of the message, a larger size is corrupt
+  if (uiSize > inout_reader.GetByteCount32() - static_cast<nsUInt32>(inout_reader.GetReadPosition()))
+  {
+    nsLog::Warning("nsJvdTelemetryBridge: Failed to receive the frame compression dictionary.");
+    return;
+  }
+
+  nsDynamicArray<nsUInt8> dictionary;
+  dictionary.SetCountUninitialized(uiSize);
+  if (inout_reader.ReadBytes(dictionary.GetData(), uiSize) != uiSize || m_Compressor.SetDictionary(uiDictionaryId, dictionary).Failed())
+  {
+    nsLog::Warning("nsJvdTelemetryBridge: Failed to receive the frame compression dictionary.");
+  }
+}
+
+void nsJvdTelemetryBridge::ReceiveCompressedFrame(nsMemoryStreamReader& inout_reader)
+{
+  nsUInt32 uiDictionaryId = 0;
+  nsUInt32 uiUncompressedSize = 0;
+  inout_reader >> uiDictionaryId;
+  inout_reader >> uiUncompressedSize;
+
+  if (uiUncompressedSize > nsJvdDictionaryCompressor::MaxMessageSize)
+  {
+    nsLog::Warning("nsJvdTelemetryBridge: Compressed frame of {0} bytes exceeds the maximum message size.", uiUncompressedSize);
+    return;
+  }
+
+  // the rest of the message is the compressed frame
+  m_CompressedData.SetCountUninitialized(inout_reader.GetByteCount32() - static_cast<nsUInt32>(inout_reader.GetReadPosition()));
+  inout_reader.ReadBytes(m_CompressedData.GetData(), m_CompressedData.GetCount());
+
+  if (uiDictionaryId != m_Compressor.GetDictionaryId())
+  {
+    // frames that overtook the reliable dictionary message
+    return;
+  }
+
+  nsStopwatch sw;
+  if (m_Compressor.Decompress(uiDictionaryId, m_CompressedData, uiUncompressedSize, m_FrameData).Failed())
+    return;
+
+  m_Stats.m_DecompressionTime += sw.GetRunningTotal();
+  m_Stats.m_uiFramesReceived++;
+  m_Stats.m_bChanged = true;
+
+  nsRawMemoryStreamReader frameReader(m_FrameData);
+  nsJvdFrame frame;
+  if (nsJvdSerialization::ReadFrame(frameReader, frame).Succeeded())
+  {
+    m_FrameEvent.Broadcast(frame);
+  }
+  else
+  {
+    nsLog::Warning("nsJvdTelemetryBridge: Failed to deserialize compressed telemetry frame message.");
+  }
+}
+
+void nsJvdTelemetryBridge::UpdateStats()
+{
+  if (!m_Stats.m_bChanged)
+    return;
+
+  m_Stats.m_bChanged = false;
+
+  if (m_Stats.m_uiFramesSent > 0)
+  {
+    nsStats::SetStat("JVD/Telemetry/Frames Sent", m_Stats.m_uiFramesSent);
+    nsStats::SetStat("JVD/Telemetry/Bytes Uncompressed", m_Stats.m_uiUncompressedBytes);
+    nsStats::SetStat("JVD/Telemetry/Bytes Sent", m_Stats.m_uiSentBytes);
+    nsStats::SetStat("JVD/Telemetry/Compression Ratio", m_Stats.m_uiUncompressedBytes / nsMath::Max(static_cast<double>(m_Stats.m_uiSentBytes), 1.0));
+    nsStats::SetStat("JVD/Telemetry/Compression Time", m_Stats.m_CompressionTime);
+  }
+
+  if (m_Stats.m_uiFramesReceived > 0)
+  {
+    nsStats::SetStat("JVD/Telemetry/Compressed Frames Received", m_Stats.m_uiFramesReceived);
+    nsStats::SetStat("JVD/Telemetry/Decompression Time", m_Stats.m_DecompressionTime);
+  }
+}
+
 void nsJvdTelemetryBridge::RegisterCallbacks()
 {
   if (m_bCallbackRegistered)
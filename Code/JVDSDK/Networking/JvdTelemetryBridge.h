@@ -1,5 +1,6 @@
 #pragma once
 
+#include <JVDSDK/Networking/JvdDictionaryCompressor.h>
 #include <JVDSDK/Recording/JvdRecordingTypes.h>
 #include <JVDSDK/Serialization/JvdStreamSerializer.h>
 
@@ -7,6 +8,8 @@
 #include <Foundation/Communication/Telemetry.h>
 #include <Foundation/Strings/String.h>
 
+class nsMemoryStreamReader;
+
 class NS_JVDSDK_DLL nsJvdTelemetryBridge
 {
 public:
@@ -19,6 +22,13 @@ public:
 
   bool IsConnected() const { return m_bConnected; }
 
+  /// \brief Compresses the sent frames with a zstd dictionary made from the first uiTrainingFrames frames.
+  ///
+  /// The dictionary is sent once as a reliable message (again when a client connects), after that every frame only
+  /// carries what differs from it. Receivers decode compressed frames automatically. Sizes and timings are reported
+  /// as 'JVD/Telemetry/...' stats.
+  void SetFrameCompression(bool bEnable, nsUInt32 uiTrainingFrames = 32);
+
   void Update();
 
   void SendFrame(const nsJvdFrame& frame);
@@ -35,6 +45,11 @@ private:
   void RegisterCallbacks();
   void UnregisterCallbacks();
 
+  void SendDictionary();
+  void ReceiveDictionary(nsMemoryStreamReader& inout_reader);
+  void ReceiveCompressedFrame(nsMemoryStreamReader& inout_reader);
+  void UpdateStats();
+
   nsEvent<const nsJvdFrame&, nsMutex> m_FrameEvent;
   nsEvent<const nsJvdClip&, nsMutex> m_ClipEvent;
 
@@ -42,4 +57,24 @@ private:
   bool m_bConnected = false;
   nsUInt16 m_uiPort = 0;
   nsTelemetry::nsEventTelemetry::Handler m_TelemetryEventHandler;
+
+  bool m_bCompressFrames = false;
+  bool m_bResendDictionary = false;
+  nsUInt32 m_uiTrainingFrames = 32;
+  nsJvdDictionaryCompressor m_Compressor;
+  nsDynamicArray<nsUInt8> m_FrameData;
+  nsDynamicArray<nsUInt8> m_CompressedData;
+
+  struct Stats
+  {
+    nsUInt64 m_uiFramesSent = 0;
+    nsUInt64 m_uiUncompressedBytes = 0;
+    nsUInt64 m_uiSentBytes = 0;
+    nsTime m_CompressionTime;
+    nsUInt64 m_uiFramesReceived = 0;
+    nsTime m_DecompressionTime;
+    bool m_bChanged = false;
+  };
+
+  Stats m_Stats;
 };
@@ -0,0 +1,165 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Playback/JvdBodyCulling.h>
+
+#include <Foundation/Profiling/Profiling.h>
+#include <Foundation/SimdMath/SimdMat4f.h>
+#include <Foundation/Threading/TaskSystem.h>
+
+namespace
+{
+  /// Below this many bodies the task overhead is larger than the culling itself.
+  constexpr nsUInt32 g_uiParallelCullingThreshold = 4096;
+  constexpr nsUInt32 g_uiCullingBatchSize = 1024;
+
+  /// The six frustum planes in structure-of-arrays layout, plane 5 is repeated to fill the second set of four.
+  struct TransposedPlanes
+  {
+    nsSimdVec4f m_x[2];
+    nsSimdVec4f m_y[2];
+    nsSimdVec4f m_z[2];
+    nsSimdVec4f m_d[2];
+  };
+
+  TransposedPlanes TransposePlanes(const nsFrustum& frustum)
+  {
+    const nsUInt8 planeIndices[2][4] = {{0, 1, 2, 3}, {4, 5, 5, 5}};
+
+    TransposedPlanes planes;
+    for (nsUInt32 set = 0; set < 2; ++set)
+    {
+      nsSimdVec4f rows[4];
+      for (nsUInt32 i = 0; i < 4; ++i)
+      {
+        // the normal is only three floats, the distance is not guaranteed to follow it in memory
+        const nsPlane& plane = frustum.GetPlane(planeIndices[set][i]);
+        rows[i].Load<3>(plane.m_vNormal.GetData());
+        rows[i].SetW(plane.m_fNegDistance);
+      }
+
+      // same convention as nsFrustum::Overlaps(), the planes point outwards
+      nsSimdMat4f tmp;
+      tmp.SetRows(rows[0], rows[1], rows[2], rows[3]);
+      planes.m_x[set] = -tmp.m_col0;
+      planes.m_y[set] = -tmp.m_col1;
+      planes.m_z[set] = -tmp.m_col2;
+      planes.m_d[set] = -tmp.m_col3;
+    }
+
+    return planes;
+  }
+
+  NS_FORCE_INLINE bool OverlapsFrustum(const TransposedPlanes& planes, const nsSimdVec4f& vCenter, const nsSimdFloat& fRadius)
+  {
+    const nsSimdFloat x = vCenter.x();
+    const nsSimdFloat y = vCenter.y();
+    const nsSimdFloat z = vCenter.z();
+
+    nsSimdVec4f minDist0 = planes.m_d[0] + planes.m_x[0] * x;
+    minDist0 += planes.m_y[0] * y;
+    minDist0 += planes.m_z[0] * z;
+
+    nsSimdVec4f minDist1 = planes.m_d[1] + planes.m_x[1] * x;
+    minDist1 += planes.m_y[1] * y;
+    minDist1 += planes.m_z[1] * z;
+
+    const nsSimdVec4f minDist = minDist0.CompMin(minDist1) + nsSimdVec4f(fRadius);
+    return (minDist < nsSimdVec4f::MakeZero()).NoneSet();
+  }
+
+  void ClassifyBodies(const nsJvdCullingView& view, const TransposedPlanes& planes, const nsJvdBodyState* pBodies, nsJvdBodyLod::StorageType* pOut, nsUInt32 uiCount)
+  {
+    const nsSimdVec4f vEye(view.m_vEyePosition.x, view.m_vEyePosition.y, view.m_vEyePosition.z);
+
+    // compare squared sizes, diameter * scale / distance >= size  <=>  (diameter * scale)^2 >= size^2 * distance^2
+    const nsSimdFloat fScaleSqr = view.m_fProjectionScale * view.m_fProjectionScale * 4.0f;
+    const nsSimdFloat fMinSizeSqr = view.m_fMinProjectedSize * view.m_fMinProjectedSize;
+    const nsSimdFloat fFullSizeSqr = view.m_fFullDetailSize * view.m_fFullDetailSize;
+
+    for (nsUInt32 i = 0; i < uiCount; ++i)
+    {
+      const nsJvdBodyState& body = pBodies[i];
+      const nsSimdVec4f vCenter(body.m_vPosition.x, body.m_vPosition.y, body.m_vPosition.z);
+      const nsSimdFloat fRadius = nsJvdBodyCulling::GetBodyRadius(body);
+
+      if (!OverlapsFrustum(planes, vCenter, fRadius))
+      {
+        pOut[i] = nsJvdBodyLod::Culled;
+        continue;
+      }
+
+      const nsSimdFloat fProjectedSqr = fRadius * fRadius * fScaleSqr;
+      const nsSimdFloat fDistanceSqr = (vCenter - vEye).GetLengthSquared<3>();
+
+      if (fProjectedSqr < fMinSizeSqr * fDistanceSqr)
+      {
+        pOut[i] = nsJvdBodyLod::Culled;
+      }
+      else
+      {
+        pOut[i] = fProjectedSqr < fFullSizeSqr * fDistanceSqr ? nsJvdBodyLod::Reduced : nsJvdBodyLod::Full;
+      }
+    }
+  }
+} // namespace
+
+void nsJvdCullingView::SetPerspective(const nsVec3& vPosition, const nsVec3& vForwards, const nsVec3& vUp, nsAngle fovX, nsAngle fovY, float fNearPlane, float fFarPlane, nsUInt32 uiViewportHeight)
+{
+  m_Frustum = nsFrustum::MakeFromFOV(vPosition, vForwards, vUp, fovX, fovY, fNearPlane, fFarPlane);
+  m_vEyePosition = vPosition;
+  m_fProjectionScale = static_cast<float>(uiViewportHeight) / (2.0f * nsMath::Tan(fovY * 0.5f));
+}
+
+nsUInt32 nsJvdBodyCulling::Cull(const nsJvdCullingView& view, nsArrayPtr<const nsJvdBodyState> bodies, nsDynamicArray<nsJvdVisibleBody>& out_visible)
+{
+  out_visible.Clear();
+
+  const nsUInt32 uiCount = bodies.GetCount();
+  if (uiCount == 0)
+    return 0;
+
+  NS_PROFILE_SCOPE("JVD Cull Bodies");
+
+  const TransposedPlanes planes = TransposePlanes(view.m_Frustum);
+  m_Classification.SetCountUninitialized(uiCount);
+
+  const nsJvdBodyState* pBodies = bodies.GetPtr();
+  nsJvdBodyLod::StorageType* pClassification = m_Classification.GetData();
+
+  if (uiCount < g_uiParallelCullingThreshold)
+  {
+    ClassifyBodies(view, planes, pBodies, pClassification, uiCount);
+  }
+  else
+  {
+    nsParallelForParams params;
+    params.m_uiBinSize = 1;
+
+    const nsUInt32 uiBatches = (uiCount + g_uiCullingBatchSize - 1) / g_uiCullingBatchSize;
+    nsTaskSystem::ParallelForIndexed(0u, uiBatches, [&view, &planes, pBodies, pClassification, uiCount](nsUInt32 uiStart, nsUInt32 uiEnd)
+      {
+        for (nsUInt32 b = uiStart; b < uiEnd; ++b)
+        {
+          const nsUInt32 uiFirst = b * g_uiCullingBatchSize;
+          ClassifyBodies(view, planes, pBodies + uiFirst, pClassification + uiFirst, nsMath::Min(g_uiCullingBatchSize, uiCount - uiFirst));
+        }
+      },
+      "JVD Cull Bodies", nsTaskNesting::Never, params);
+  }
+
+  // compacting serially keeps the original order, it only touches one byte per body
+  out_visible.Reserve(uiCount);
+  for (nsUInt32 i = 0; i < uiCount; ++i)
+  {
+    if (pClassification[i] != nsJvdBodyLod::Culled)
+    {
+      nsJvdVisibleBody& visible = out_visible.ExpandAndGetRef();
+      visible.m_uiBodyIndex = i;
+      visible.m_Lod = static_cast<nsJvdBodyLod::Enum>(pClassification[i]);
+    }
+  }
+
+  return out_visible.GetCount();
+}
+
+NS_STATICLINK_FILE(JVDSDK, Playback_JvdBodyCulling);
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <JVDSDK/Recording/JvdRecordingTypes.h>
+
+#include <Foundation/Math/Frustum.h>
+
+/// \brief The camera a frame is culled for, see nsJvdBodyCulling.
+struct NS_JVDSDK_DLL nsJvdCullingView
+{
+  /// \brief Sets up the view for a perspective camera. The projection scale is derived from the vertical field of view.
+  void SetPerspective(const nsVec3& vPosition, const nsVec3& vForwards, const nsVec3& vUp, nsAngle fovX, nsAngle fovY, float fNearPlane, float fFarPlane, nsUInt32 uiViewportHeight);
+
+  nsFrustum m_Frustum;
+  nsVec3 m_vEyePosition = nsVec3::MakeZero();
+
+  /// Pixels covered by one unit at a distance of one unit.
+  float m_fProjectionScale = 1.0f;
+
+  /// Bodies that cover fewer pixels than this are culled.
+  float m_fMinProjectedSize = 1.0f;
+
+  /// Bodies that cover fewer pixels than this use nsJvdBodyLod::Reduced.
+  float m_fFullDetailSize = 6.0f;
+};
+
+/// \brief How much detail a visible body needs.
+struct nsJvdBodyLod
+{
+  using StorageType = nsUInt8;
+
+  enum Enum : nsUInt8
+  {
+    Full,    ///< Rotated and scaled like the body.
+    Reduced, ///< A few pixels wide, an axis-aligned cube of the body's size is indistinguishable.
+    Culled,
+
+    Default = Full
+  };
+};
+
+/// \brief A body that passed culling.
+struct nsJvdVisibleBody
+{
+  nsUInt32 m_uiBodyIndex = 0; ///< Index into nsJvdFrame::m_Bodies.
+  nsJvdBodyLod::Enum m_Lod = nsJvdBodyLod::Full;
+};
+
+/// \brief Frustum and projected-size culling of the bodies of a frame, so that only visible bodies are converted and uploaded.
+///
+/// Every body is bounded by the sphere around its box, which does not depend on the rotation. The frustum planes are
+/// transposed once per call and the spheres are tested four planes at a time. Large frames are classified in parallel.
+class NS_JVDSDK_DLL nsJvdBodyCulling
+{
+public:
+  /// \brief Bounding sphere radius of a body as the viewers draw it: a box of the body's scale, at least 0.1 units wide.
+  static float GetBodyRadius(const nsJvdBodyState& body) { return body.m_vScale.CompMax(nsVec3(0.1f)).GetLength() * 0.5f; }
+
+  /// \brief Writes the visible bodies in their original order. Returns the number of visible bodies.
+  nsUInt32 Cull(const nsJvdCullingView& view, nsArrayPtr<const nsJvdBodyState> bodies, nsDynamicArray<nsJvdVisibleBody>& out_visible);
+
+private:
+  nsDynamicArray<nsJvdBodyLod::StorageType> m_Classification;
+};
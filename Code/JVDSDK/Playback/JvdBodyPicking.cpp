@@ -0,0 +1,334 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Playback/JvdBodyPicking.h>
+
+#include <Foundation/Profiling/Profiling.h>
+#include <Foundation/SimdMath/SimdConversion.h>
+
+namespace
+{
+  constexpr nsUInt32 g_uiMaxLeafSize = 4;
+
+  /// A refit tree that costs this much more than it did when it was built is rebuilt.
+  constexpr float g_fMaxRefitCostRatio = 1.5f;
+
+  /// Replaces direction components of zero, so the slab test does not compute 0 * inf.
+  constexpr float g_fMinDirection = 1e-20f;
+
+  struct StackEntry
+  {
+    NS_DECLARE_POD_TYPE();
+
+    nsUInt32 m_uiNode;
+    float m_fDistance; ///< Where the ray enters the node.
+  };
+
+  /// Half the surface area of the box, only used relative to other boxes.
+  NS_FORCE_INLINE float GetArea(const nsSimdBBox& box)
+  {
+    const nsSimdVec4f vExtents = box.GetHalfExtents();
+    return vExtents.CompMul(vExtents.Get<nsSwizzle::YZXW>()).HorizontalSum<3>();
+  }
+
+  NS_FORCE_INLINE nsSimdVec4f GetSafeInverse(const nsSimdVec4f& vDirection)
+  {
+    const nsSimdVec4f vMin(g_fMinDirection);
+    const nsSimdVec4f vSafe = nsSimdVec4f::Select(vDirection.Abs() < vMin, nsSimdVec4f::Select(vDirection < nsSimdVec4f::MakeZero(), -vMin, vMin), vDirection);
+    return vSafe.GetReciprocal();
+  }
+
+  /// Slab test, out_fDistance is where the ray enters the box, 0 if it starts inside.
+  NS_FORCE_INLINE bool IntersectBox(const nsSimdVec4f& vMin, const nsSimdVec4f& vMax, const nsSimdVec4f& vOrigin, const nsSimdVec4f& vInvDirection, const nsSimdFloat& fMaxDistance, nsSimdFloat& out_fDistance)
+  {
+    const nsSimdVec4f t0 = (vMin - vOrigin).CompMul(vInvDirection);
+    const nsSimdVec4f t1 = (vMax - vOrigin).CompMul(vInvDirection);
+
+    const nsSimdFloat fNear = t0.CompMin(t1).HorizontalMax<3>().Max(nsSimdFloat::MakeZero());
+    const nsSimdFloat fFar = t0.CompMax(t1).HorizontalMin<3>().Min(fMaxDistance);
+
+    out_fDistance = fNear;
+    return fNear <= fFar;
+  }
+} // namespace
+
+void nsJvdBodyPicking::Update(nsArrayPtr<const nsJvdBodyState> bodies)
+{
+  NS_PROFILE_SCOPE("JVD Picking Update");
+
+  const nsUInt32 uiCount = bodies.GetCount();
+  bool bSameBodies = !m_Nodes.IsEmpty() && m_BodyIds.GetCount() == uiCount;
+
+  m_Boxes.SetCountUninitialized(uiCount);
+  m_BodyBounds.SetCountUninitialized(uiCount);
+
+  for (nsUInt32 i = 0; i < uiCount; ++i)
+  {
+    const nsJvdBodyState& body = bodies[i];
+    bSameBodies = bSameBodies && m_BodyIds[i] == body.m_uiBodyId;
+
+    // the same box the viewers draw, at least 0.1 units wide
+    const nsSimdVec4f vHalfExtents = nsSimdConversion::ToVec3(body.m_vScale.CompMax(nsVec3(0.1f)) * 0.5f);
+    const nsSimdQuat qRotation = nsSimdConversion::ToQuat(body.m_qRotation);
+
+    PickBox& box = m_Boxes[i];
+    box.m_vCenter = nsSimdConversion::ToVec3(body.m_vPosition);
+    box.m_qInvRotation = -qRotation;
+    box.m_vHalfExtents = vHalfExtents;
+
+    // world space extents of the rotated box
+    const nsSimdVec4f vAxisX = qRotation * nsSimdVec4f(vHalfExtents.x(), 0.0f, 0.0f);
+    const nsSimdVec4f vAxisY = qRotation * nsSimdVec4f(0.0f, vHalfExtents.y(), 0.0f);
+    const nsSimdVec4f vAxisZ = qRotation * nsSimdVec4f(0.0f, 0.0f, vHalfExtents.z());
+    const nsSimdVec4f vExtents = vAxisX.Abs() + vAxisY.Abs() + vAxisZ.Abs();
+
+    // a body at NaN or infinity would poison the min / max of every node above it, it stays out of the tree
+    const bool bWasInTree = bSameBodies && m_BodyBounds[i].IsValid();
+    const bool bFinite = box.m_vCenter.IsValid<3>() && vExtents.IsValid<3>();
+    bSameBodies = bSameBodies && bWasInTree == bFinite;
+
+    m_BodyBounds[i] = bFinite ? nsSimdBBox::MakeFromCenterAndHalfExtents(box.m_vCenter, vExtents) : nsSimdBBox::MakeInvalid();
+  }
+
+  if (bSameBodies)
+  {
+    const float fCost = Refit();
+    ++m_uiRefits;
+
+    if (fCost <= m_fBuildCost * g_fMaxRefitCostRatio)
+      return;
+  }
+
+  m_BodyIds.SetCountUninitialized(uiCount);
+  for (nsUInt32 i = 0; i < uiCount; ++i)
+  {
+    m_BodyIds[i] = bodies[i].m_uiBodyId;
+  }
+
+  Rebuild();
+}
+
+void nsJvdBodyPicking::Clear()
+{
+  m_BodyIds.Clear();
+  m_Boxes.Clear();
+  m_BodyBounds.Clear();
+  m_BodyOrder.Clear();
+  m_Nodes.Clear();
+  m_fBuildCost = 0.0f;
+}
+
+bool nsJvdBodyPicking::CastRay(const nsVec3& vOrigin, const nsVec3& vDirection, nsJvdPickResult& out_result, float fMaxDistance) const
+{
+  if (m_Nodes.IsEmpty())
+    return false;
+
+  const nsSimdVec4f vRayOrigin = nsSimdConversion::ToVec3(vOrigin);
+  const nsSimdVec4f vRayDirection = nsSimdConversion::ToVec3(vDirection);
+  const nsSimdVec4f vInvDirection = GetSafeInverse(vRayDirection);
+
+  nsSimdFloat fClosest = fMaxDistance;
+  nsUInt32 uiClosestBody = nsInvalidIndex;
+
+  nsSimdFloat fDistance;
+  if (!IntersectBox(m_Nodes[0].m_Bounds.m_Min, m_Nodes[0].m_Bounds.m_Max, vRayOrigin, vInvDirection, fClosest, fDistance))
+    return false;
+
+  nsHybridArray<StackEntry, 64> stack;
+  stack.PushBack({0, fDistance});
+
+  while (!stack.IsEmpty())
+  {
+    const StackEntry entry = stack.PeekBack();
+    stack.PopBack();
+
+    // a closer hit was found since the node was pushed
+    if (entry.m_fDistance > fClosest)
+      continue;
+
+    const Node& node = m_Nodes[entry.m_uiNode];
+    if (node.m_uiCount > 0)
+    {
+      for (nsUInt32 i = node.m_uiFirst; i < node.m_uiFirst + node.m_uiCount; ++i)
+      {
+        const nsUInt32 uiBody = m_BodyOrder[i];
+        const PickBox& box = m_Boxes[uiBody];
+
+        // the box is axis-aligned in its local space, the rotation keeps distances along the ray
+        const nsSimdVec4f vLocalOrigin = box.m_qInvRotation * (vRayOrigin - box.m_vCenter);
+        const nsSimdVec4f vLocalInvDirection = GetSafeInverse(box.m_qInvRotation * vRayDirection);
+
+        if (IntersectBox(-box.m_vHalfExtents, box.m_vHalfExtents, vLocalOrigin, vLocalInvDirection, fClosest, fDistance) && fDistance < fClosest)
+        {
+          fClosest = fDistance;
+          uiClosestBody = uiBody;
+        }
+      }
+
+      continue;
+    }
+
+    const nsUInt32 uiChildren[2] = {node.m_uiFirst, node.m_uiFirst + 1};
+    nsSimdFloat fChildDistance[2];
+    bool bHit[2];
+    for (nsUInt32 c = 0; c < 2; ++c)
+    {
+      const nsSimdBBox& bounds = m_Nodes[uiChildren[c]].m_Bounds;
+      bHit[c] = IntersectBox(bounds.m_Min, bounds.m_Max, vRayOrigin, vInvDirection, fClosest, fChildDistance[c]);
+    }
+
+    // the closer child is popped first, its hits prune the other one
+    const nsUInt32 uiFirst = (bHit[0] && bHit[1] && fChildDistance[1] < fChildDistance[0]) ? 1 : 0;
+    const nsUInt32 uiSecond = 1 - uiFirst;
+
+    if (bHit[uiSecond])
+    {
+      stack.PushBack({uiChildren[uiSecond], fChildDistance[uiSecond]});
+    }
+
+    if (bHit[uiFirst])
+    {
+      stack.PushBack({uiChildren[uiFirst], fChildDistance[uiFirst]});
+    }
+  }
+
+  if (uiClosestBody == nsInvalidIndex)
+    return false;
+
+  out_result.m_uiBodyIndex = uiClosestBody;
+  out_result.m_fDistance = fClosest;
+  return true;
+}
+
+void nsJvdBodyPicking::Rebuild()
+{
+  NS_PROFILE_SCOPE("JVD Picking Rebuild");
+
+  ++m_uiRebuilds;
+
+  m_Nodes.Clear();
+  m_BodyOrder.Clear();
+  m_BodyOrder.Reserve(m_BodyBounds.GetCount());
+  for (nsUInt32 i = 0; i < m_BodyBounds.GetCount(); ++i)
+  {
+    if (m_BodyBounds[i].IsValid())
+    {
+      m_BodyOrder.PushBack(i);
+    }
+  }
+
+  const nsUInt32 uiCount = m_BodyOrder.GetCount();
+
+  m_fBuildCost = 0.0f;
+  if (uiCount == 0)
+    return;
+
+  // top-down, every node is split at the middle of the longest axis of the body centers
+  m_Nodes.Reserve(2 * (uiCount / g_uiMaxLeafSize) + 1);
+
+  Node& root = m_Nodes.ExpandAndGetRef();
+  root.m_uiFirst = 0;
+  root.m_uiCount = uiCount;
+
+  nsHybridArray<nsUInt32, 64> stack;
+  stack.PushBack(0);
+
+  while (!stack.IsEmpty())
+  {
+    const nsUInt32 uiNode = stack.PeekBack();
+    stack.PopBack();
+
+    const nsUInt32 uiFirst = m_Nodes[uiNode].m_uiFirst;
+    const nsUInt32 uiNodeCount = m_Nodes[uiNode].m_uiCount;
+
+    nsSimdBBox bounds = nsSimdBBox::MakeInvalid();
+    nsSimdBBox centers = nsSimdBBox::MakeInvalid();
+    for (nsUInt32 i = uiFirst; i < uiFirst + uiNodeCount; ++i)
+    {
+      const nsUInt32 uiBody = m_BodyOrder[i];
+      bounds.ExpandToInclude(m_BodyBounds[uiBody]);
+      centers.ExpandToInclude(m_Boxes[uiBody].m_vCenter);
+    }
+
+    m_Nodes[uiNode].m_Bounds = bounds;
+    m_fBuildCost += GetArea(bounds);
+
+    if (uiNodeCount <= g_uiMaxLeafSize)
+      continue;
+
+    const nsVec3 vExtents = nsSimdConversion::ToVec3(centers.GetHalfExtents());
+    const int iAxis = (vExtents.x >= vExtents.y && vExtents.x >= vExtents.z) ? 0 : (vExtents.y >= vExtents.z ? 1 : 2);
+    const nsSimdFloat fSplit = centers.GetCenter().GetComponent(iAxis);
+
+    // partitioning is linear, a median split would have to sort
+    nsUInt32 uiLeftEnd = uiFirst;
+    nsUInt32 uiRightBegin = uiFirst + uiNodeCount;
+    while (uiLeftEnd < uiRightBegin)
+    {
+      if (m_Boxes[m_BodyOrder[uiLeftEnd]].m_vCenter.GetComponent(iAxis) < fSplit)
+      {
+        ++uiLeftEnd;
+      }
+      else
+      {
+        nsMath::Swap(m_BodyOrder[uiLeftEnd], m_BodyOrder[--uiRightBegin]);
+      }
+    }
+
+    // all centers on one side, e.g. bodies stacked at the same spot
+    nsUInt32 uiLeftCount = uiLeftEnd - uiFirst;
+    if (uiLeftCount == 0 || uiLeftCount == uiNodeCount)
+    {
+      uiLeftCount = uiNodeCount / 2;
+    }
+
+    const nsUInt32 uiLeft = m_Nodes.GetCount();
+
+    Node& left = m_Nodes.ExpandAndGetRef();
+    left.m_uiFirst = uiFirst;
+    left.m_uiCount = uiLeftCount;
+
+    Node& right = m_Nodes.ExpandAndGetRef();
+    right.m_uiFirst = uiFirst + uiLeftCount;
+    right.m_uiCount = uiNodeCount - uiLeftCount;
+
+    m_Nodes[uiNode].m_uiFirst = uiLeft;
+    m_Nodes[uiNode].m_uiCount = 0;
+
+    stack.PushBack(uiLeft);
+    stack.PushBack(uiLeft + 1);
+  }
+
+  m_fBuildCost /= nsMath::Max(GetArea(m_Nodes[0].m_Bounds), nsMath::SmallEpsilon<float>());
+}
+
+float nsJvdBodyPicking::Refit()
+{
+  NS_PROFILE_SCOPE("JVD Picking Refit");
+
+  // children always come after their parent
+  float fCost = 0.0f;
+  for (nsUInt32 i = m_Nodes.GetCount(); i-- > 0;)
+  {
+    Node& node = m_Nodes[i];
+
+    if (node.m_uiCount > 0)
+    {
+      node.m_Bounds = m_BodyBounds[m_BodyOrder[node.m_uiFirst]];
+      for (nsUInt32 b = node.m_uiFirst + 1; b < node.m_uiFirst + node.m_uiCount; ++b)
+      {
+        node.m_Bounds.ExpandToInclude(m_BodyBounds[m_BodyOrder[b]]);
+      }
+    }
+    else
+    {
+      node.m_Bounds = m_Nodes[node.m_uiFirst].m_Bounds;
+      node.m_Bounds.ExpandToInclude(m_Nodes[node.m_uiFirst + 1].m_Bounds);
+    }
+
+    fCost += GetArea(node.m_Bounds);
+  }
+
+  return fCost / nsMath::Max(GetArea(m_Nodes[0].m_Bounds), nsMath::SmallEpsilon<float>());
+}
+
+NS_STATICLINK_FILE(JVDSDK, Playback_JvdBodyPicking);
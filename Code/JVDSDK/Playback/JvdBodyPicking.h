@@ -0,0 +1,70 @@
+#pragma once
+
+#include <JVDSDK/Recording/JvdRecordingTypes.h>
+
+#include <Foundation/SimdMath/SimdBBox.h>
+#include <Foundation/SimdMath/SimdQuat.h>
+
+/// \brief The closest body hit by a ray, see nsJvdBodyPicking::CastRay().
+struct nsJvdPickResult
+{
+  nsUInt32 m_uiBodyIndex = nsInvalidIndex; ///< Index into nsJvdFrame::m_Bodies.
+  float m_fDistance = 0.0f;                ///< Along the ray, in multiples of the ray direction's length.
+};
+
+/// \brief Ray picking of the bodies of a frame through a bounding volume hierarchy.
+///
+/// Bodies are hit as the boxes the viewers draw. As long as a frame holds the same bodies in the same order as the frame the
+/// tree was built for, which is the normal case during playback, the tree is only refit to the new positions. It is rebuilt
+/// when the bodies change or when refitting made it considerably worse than a fresh tree, e.g. after bodies swapped places.
+class NS_JVDSDK_DLL nsJvdBodyPicking
+{
+public:
+  /// \brief Brings the tree up to date with the bodies of a frame. The bodies are copied, they do not have to stay alive.
+  void Update(nsArrayPtr<const nsJvdBodyState> bodies);
+
+  void Clear();
+
+  /// \brief Finds the closest body in front of vOrigin. Returns false if the ray hits nothing closer than fMaxDistance.
+  bool CastRay(const nsVec3& vOrigin, const nsVec3& vDirection, nsJvdPickResult& out_result, float fMaxDistance = nsMath::MaxValue<float>()) const;
+
+  /// \brief How often Update() built the tree from scratch.
+  nsUInt32 GetRebuildCount() const { return m_uiRebuilds; }
+
+  /// \brief How often Update() only moved the bounds of the existing tree.
+  nsUInt32 GetRefitCount() const { return m_uiRefits; }
+
+private:
+  struct Node
+  {
+    NS_DECLARE_POD_TYPE();
+
+    nsSimdBBox m_Bounds;
+    nsUInt32 m_uiFirst; ///< Leaves: first entry in m_BodyOrder. Inner nodes: the first of the two children.
+    nsUInt32 m_uiCount; ///< Bodies in a leaf, 0 for inner nodes.
+  };
+
+  /// The box of one body, in the form the ray test needs it.
+  struct PickBox
+  {
+    NS_DECLARE_POD_TYPE();
+
+    nsSimdVec4f m_vCenter;
+    nsSimdQuat m_qInvRotation;
+    nsSimdVec4f m_vHalfExtents;
+  };
+
+  void Rebuild();
+
+  /// Recomputes all node bounds bottom-up and returns the cost of the resulting tree.
+  float Refit();
+
+  nsDynamicArray<nsUInt64> m_BodyIds;
+  nsDynamicArray<PickBox> m_Boxes;
+  nsDynamicArray<nsSimdBBox> m_BodyBounds;
+  nsDynamicArray<nsUInt32> m_BodyOrder;
+  nsDynamicArray<Node> m_Nodes;
+  float m_fBuildCost = 0.0f;
+  nsUInt32 m_uiRebuilds = 0;
+  nsUInt32 m_uiRefits = 0;
+};
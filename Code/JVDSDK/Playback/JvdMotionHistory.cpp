@@ -0,0 +1,87 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Playback/JvdMotionHistory.h>
+
+namespace
+{
+  constexpr nsUInt32 g_uiMinBodyCapacity = 64;
+} // namespace
+
+void nsJvdMotionHistory::SetFrameCapacity(nsUInt32 uiFrameCapacity)
+{
+  NS_ASSERT_DEV(uiFrameCapacity > 0, "The motion history needs at least one frame.");
+
+  if (m_uiFrameCapacity != uiFrameCapacity)
+  {
+    m_uiFrameCapacity = uiFrameCapacity;
+    ++m_uiLayoutVersion;
+  }
+
+  Clear();
+}
+
+void nsJvdMotionHistory::Clear()
+{
+  m_uiFrameCount = 0;
+  m_uiHeadRow = 0;
+  m_uiHeadFrameIndex = 0;
+}
+
+nsUInt32 nsJvdMotionHistory::AddFrame(const nsJvdFrame& frame, nsUInt32* out_pSkippedRows)
+{
+  if (out_pSkippedRows != nullptr)
+  {
+    *out_pSkippedRows = 0;
+  }
+
+  nsUInt32 uiMaxBodyIndex = 0;
+  bool bHasBodies = false;
+  for (const nsJvdBodyState& body : frame.m_Bodies)
+  {
+    if (body.m_uiBodyIndex != nsInvalidIndex)
+    {
+      uiMaxBodyIndex = nsMath::Max(uiMaxBodyIndex, body.m_uiBodyIndex);
+      bHasBodies = true;
+    }
+  }
+
+  if (bHasBodies && uiMaxBodyIndex >= m_uiBodyCapacity)
+  {
+    // the rows are reallocated, previous frames are lost
+    m_uiBodyCapacity = nsMath::Max(g_uiMinBodyCapacity, nsMath::PowerOfTwo_Ceil(uiMaxBodyIndex + 1));
+    ++m_uiLayoutVersion;
+    Clear();
+  }
+
+  // showing the same frame again, e.g. while paused, keeps the trails
+  if (m_uiFrameCount > 0 && frame.m_uiFrameIndex == m_uiHeadFrameIndex)
+    return m_uiHeadRow;
+
+  if (m_uiFrameCount > 0 && frame.m_uiFrameIndex > m_uiHeadFrameIndex && frame.m_uiFrameIndex - m_uiHeadFrameIndex < m_uiFrameCapacity)
+  {
+    const nsUInt32 uiStep = static_cast<nsUInt32>(frame.m_uiFrameIndex - m_uiHeadFrameIndex);
+    m_uiHeadRow = (m_uiHeadRow + uiStep) % m_uiFrameCapacity;
+    m_uiFrameCount = nsMath::Min(m_uiFrameCount + uiStep, m_uiFrameCapacity);
+
+    if (out_pSkippedRows != nullptr)
+    {
+      *out_pSkippedRows = uiStep - 1;
+    }
+  }
+  else
+  {
+    m_uiHeadRow = 0;
+    m_uiFrameCount = 1;
+  }
+
+  m_uiHeadFrameIndex = frame.m_uiFrameIndex;
+  return m_uiHeadRow;
+}
+
+nsUInt32 nsJvdMotionHistory::GetRow(nsUInt32 uiAge) const
+{
+  NS_ASSERT_DEBUG(uiAge < m_uiFrameCount, "Frame {} is not part of the history ({} frames).", uiAge, m_uiFrameCount);
+  return (m_uiHeadRow + m_uiFrameCapacity - uiAge) % m_uiFrameCapacity;
+}
+
+NS_STATICLINK_FILE(JVDSDK, Playback_JvdMotionHistory);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <JVDSDK/Recording/JvdRecordingTypes.h>
+
+/// \brief Bookkeeping for a rolling window over the most recent frames, e.g. a GPU ring buffer that motion trails are drawn from.
+///
+/// Each frame occupies one row of a ring with GetFrameCapacity() rows. A row has one column per body, the column is the body's
+/// dense clip index (nsJvdBodyState::m_uiBodyIndex), so a body keeps its column for the whole clip. Bodies without an index are
+/// not tracked. Only the bookkeeping lives here, the owner stores the rows, so advancing the history costs the same no matter how
+/// many frames it keeps.
+class NS_JVDSDK_DLL nsJvdMotionHistory
+{
+public:
+  /// \brief Sets how many frames are kept. Clears the history.
+  void SetFrameCapacity(nsUInt32 uiFrameCapacity);
+  nsUInt32 GetFrameCapacity() const { return m_uiFrameCapacity; }
+
+  /// \brief Columns per row. Grows in powers of two when a frame contains a higher body index, see GetLayoutVersion().
+  nsUInt32 GetBodyCapacity() const { return m_uiBodyCapacity; }
+
+  /// \brief Changes whenever GetFrameCapacity() or GetBodyCapacity() changed and the rows have to be reallocated.
+  nsUInt32 GetLayoutVersion() const { return m_uiLayoutVersion; }
+
+  /// \brief Forgets all frames, the next frame starts a new history.
+  void Clear();
+
+  /// \brief Makes the frame the newest entry and returns the row its body states go to.
+  ///
+  /// A frame less than GetFrameCapacity() frames after the previous one continues the history, e.g. when playback skips
+  /// frames. The rows of the skipped frames are GetRow(1) to GetRow(*out_pSkippedRows), they hold no data and should be
+  /// cleared by the owner. The history starts over for any other frame, for example after seeking backwards or far ahead.
+  /// Growing the body capacity also starts over. Adding the newest frame again returns its row and changes nothing else.
+  nsUInt32 AddFrame(const nsJvdFrame& frame, nsUInt32* out_pSkippedRows = nullptr);
+
+  /// \brief Number of rows that hold frames, at most GetFrameCapacity().
+  nsUInt32 GetFrameCount() const { return m_uiFrameCount; }
+
+  /// \brief The row of the newest frame. Only valid if GetFrameCount() > 0.
+  nsUInt32 GetHeadRow() const { return m_uiHeadRow; }
+
+  /// \brief The row of the frame uiAge frames before the newest one, uiAge must be smaller than GetFrameCount().
+  nsUInt32 GetRow(nsUInt32 uiAge) const;
+
+  /// \brief The frame index of the newest frame. Only valid if GetFrameCount() > 0.
+  nsUInt64 GetHeadFrameIndex() const { return m_uiHeadFrameIndex; }
+
+private:
+  nsUInt32 m_uiFrameCapacity = 64;
+  nsUInt32 m_uiBodyCapacity = 0;
+  nsUInt32 m_uiLayoutVersion = 0;
+  nsUInt32 m_uiFrameCount = 0;
+  nsUInt32 m_uiHeadRow = 0;
+  nsUInt64 m_uiHeadFrameIndex = 0;
+};
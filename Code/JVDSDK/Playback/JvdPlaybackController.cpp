@@ -2,17 +2,25 @@
 
 #include <JVDSDK/Playback/JvdPlaybackController.h>
 
+namespace
+{
+  /// A stalled UI or a debugger break should not fast-forward the clip.
+  constexpr double g_fMaxPresentStepSeconds = 0.25;
+} // namespace
+
 nsJvdPlaybackController::nsJvdPlaybackController() = default;
 
 void nsJvdPlaybackController::LoadClip(const nsJvdClip& clip)
 {
   m_pClip = &clip;
   m_CurrentTime = nsTime::MakeZero();
+  m_uiLastPresentedFrame = nsInvalidIndex;
 }
 
 void nsJvdPlaybackController::Reset()
 {
   m_CurrentTime = nsTime::MakeZero();
+  m_uiLastPresentedFrame = nsInvalidIndex;
 }
 
 bool nsJvdPlaybackController::Step(nsTime deltaTime, nsJvdFrame& outFrame)
@@ -20,6 +28,89 @@ bool nsJvdPlaybackController::Step(nsTime deltaTime, nsJvdFrame& outFrame)
   if (m_pClip == nullptr || m_pClip->IsEmpty())
     return false;
 
+  AdvanceTime(deltaTime);
+
+  const nsJvdFrame* pFrame = m_pClip->FindFrameByTime(m_CurrentTime);
+  if (pFrame == nullptr)
+    return false;
+
+  outFrame = *pFrame;
+  outFrame.m_Timestamp = m_CurrentTime;
+  return true;
+}
+
+void nsJvdPlaybackController::StartPresenting()
+{
+  m_WallClock.StopAndReset();
+  m_WallClock.Resume();
+  m_uiLastPresentedFrame = nsInvalidIndex;
+  m_Stats = nsJvdPlaybackStats();
+}
+
+const nsJvdFrame* nsJvdPlaybackController::Present()
+{
+  const nsTime elapsed = m_WallClock.Checkpoint();
+
+  m_Stats.m_MaxTickInterval = nsMath::Max(m_Stats.m_MaxTickInterval, elapsed);
+  m_Stats.m_AverageTickInterval = m_Stats.m_AverageTickInterval.IsZero() ? elapsed : m_Stats.m_AverageTickInterval * 0.9 + elapsed * 0.1;
+
+  if (m_pClip == nullptr || m_pClip->IsEmpty())
+    return nullptr;
+
+  AdvanceTime(nsMath::Min(elapsed, nsTime::MakeFromSeconds(g_fMaxPresentStepSeconds)));
+
+  const nsJvdFrame* pFrame = m_pClip->FindFrameByTime(m_CurrentTime);
+  if (pFrame == nullptr)
+    return nullptr;
+
+  // show the frame that was current at this time, not the next one
+  nsUInt32 uiFrame = static_cast<nsUInt32>(pFrame - m_pClip->GetFrames().GetData());
+  if (uiFrame > 0 && pFrame->m_Timestamp > m_CurrentTime)
+  {
+    --uiFrame;
+    --pFrame;
+  }
+
+  if (uiFrame == m_uiLastPresentedFrame)
+  {
+    ++m_Stats.m_uiIdleTicks;
+    return nullptr;
+  }
+
+  if (m_uiLastPresentedFrame != nsInvalidIndex)
+  {
+    if (uiFrame > m_uiLastPresentedFrame)
+    {
+      m_Stats.m_uiDroppedFrames += uiFrame - m_uiLastPresentedFrame - 1;
+    }
+    else
+    {
+      // wrapped around while looping
+      m_Stats.m_uiDroppedFrames += (m_pClip->GetFrames().GetCount() - 1 - m_uiLastPresentedFrame) + uiFrame;
+    }
+  }
+
+  m_uiLastPresentedFrame = uiFrame;
+  ++m_Stats.m_uiPresentedFrames;
+  return pFrame;
+}
+
+bool nsJvdPlaybackController::IsAtEnd() const
+{
+  if (m_bLoop || m_pClip == nullptr || m_pClip->IsEmpty())
+    return false;
+
+  return m_CurrentTime >= m_pClip->GetDuration();
+}
+
+void nsJvdPlaybackController::SetPlaybackPosition(nsTime time)
+{
+  m_CurrentTime = time;
+  m_uiLastPresentedFrame = nsInvalidIndex;
+}
+
+void nsJvdPlaybackController::AdvanceTime(nsTime deltaTime)
+{
   m_CurrentTime += deltaTime;
 
   const nsTime duration = m_pClip->GetDuration();
@@ -37,14 +128,6 @@ bool nsJvdPlaybackController::Step(nsTime deltaTime, nsJvdFrame& outFrame)
       m_CurrentTime = duration;
     }
   }
-
-  const nsJvdFrame* pFrame = m_pClip->FindFrameByTime(m_CurrentTime);
-  if (pFrame == nullptr)
-    return false;
-
-  outFrame = *pFrame;
-  outFrame.m_Timestamp = m_CurrentTime;
-  return true;
 }
 
 NS_STATICLINK_FILE(JVDSDK, Playback_JvdPlaybackController);
@@ -2,6 +2,18 @@
 
 #include <JVDSDK/Recording/JvdRecordingTypes.h>
 
+#include <Foundation/Time/Stopwatch.h>
+
+/// \brief Frame-time statistics of wall-clock playback, see nsJvdPlaybackController::Present().
+struct NS_JVDSDK_DLL nsJvdPlaybackStats
+{
+  nsUInt64 m_uiPresentedFrames = 0; ///< Clip frames that were handed to the view.
+  nsUInt64 m_uiDroppedFrames = 0;   ///< Clip frames that were skipped to keep up with the wall clock.
+  nsUInt64 m_uiIdleTicks = 0;       ///< Ticks that did not reach the next clip frame and presented nothing.
+  nsTime m_AverageTickInterval;     ///< Smoothed wall-clock time between two calls to Present().
+  nsTime m_MaxTickInterval;
+};
+
 class NS_JVDSDK_DLL nsJvdPlaybackController
 {
 public:
@@ -14,14 +26,35 @@ public:
   /// Returns false when playback has reached the end of the clip.
   bool Step(nsTime deltaTime, nsJvdFrame& outFrame);
 
+  /// \brief Restarts the wall clock and the statistics. Call this when playback starts or resumes.
+  void StartPresenting();
+
+  /// \brief Advances playback by the wall-clock time since the previous call.
+  ///
+  /// Returns the clip frame to show, or nullptr if it is still the frame returned last time. Frames that were passed over
+  /// because the caller ticks slower than the clip's sample rate are counted as dropped, so playback keeps real speed
+  /// however long a tick takes.
+  const nsJvdFrame* Present();
+
+  /// \brief True once a non-looping playback has reached the last frame.
+  bool IsAtEnd() const;
+
+  const nsJvdPlaybackStats& GetStats() const { return m_Stats; }
+
   void SetLoop(bool bLoop) { m_bLoop = bLoop; }
   bool GetLoop() const { return m_bLoop; }
 
   nsTime GetPlaybackPosition() const { return m_CurrentTime; }
-  void SetPlaybackPosition(nsTime time) { m_CurrentTime = time; }
+  void SetPlaybackPosition(nsTime time);
 
 private:
+  void AdvanceTime(nsTime deltaTime);
+
   const nsJvdClip* m_pClip = nullptr;
   nsTime m_CurrentTime = nsTime::MakeZero();
   bool m_bLoop = false;
+
+  nsStopwatch m_WallClock;
+  nsUInt32 m_uiLastPresentedFrame = nsInvalidIndex;
+  nsJvdPlaybackStats m_Stats;
 };
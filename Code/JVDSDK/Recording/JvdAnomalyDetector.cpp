@@ -0,0 +1,390 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Recording/JvdAnomalyDetector.h>
+
+#include <Foundation/Memory/MemoryUtils.h>
+#include <Foundation/SimdMath/SimdVec4b.h>
+#include <Foundation/SimdMath/SimdVec4f.h>
+
+namespace
+{
+  struct nsJvdAnomalyHit
+  {
+    nsUInt32 m_uiCount = 0;
+    float m_fWorstValue = 0.0f;
+    nsUInt64 m_uiWorstBodyId = 0;
+    bool m_bSquaredValue = false;
+  };
+
+  NS_ALWAYS_INLINE nsSimdVec4f SoaLengthSquared(const nsSimdVec4f& x, const nsSimdVec4f& y, const nsSimdVec4f& z)
+  {
+    return nsSimdVec4f::MulAdd(x, x, nsSimdVec4f::MulAdd(y, y, z.CompMul(z)));
+  }
+
+  /// Only called for the rare batches that contain a hit, so the scalar lane loop does not matter.
+  void RecordAnomalyHits(const nsSimdVec4b& mask, const nsSimdVec4f& metric, bool bSquaredMetric, nsUInt32 uiFirstBody, const nsJvdFrame& frame, nsJvdAnomalyHit& inout_hit)
+  {
+    if (!mask.AnySet())
+      return;
+
+    float values[4];
+    float flags[4];
+    metric.Store<4>(values);
+    nsSimdVec4f::Select(mask, nsSimdVec4f(1.0f), nsSimdVec4f::MakeZero()).Store<4>(flags);
+
+    const nsUInt32 uiBodyCount = frame.m_Bodies.GetCount();
+    for (nsUInt32 uiLane = 0; uiLane < 4 && uiFirstBody + uiLane < uiBodyCount; ++uiLane)
+    {
+      if (flags[uiLane] == 0.0f)
+        continue;
+
+      if (inout_hit.m_uiCount == 0 || values[uiLane] > inout_hit.m_fWorstValue)
+      {
+        inout_hit.m_fWorstValue = values[uiLane];
+        inout_hit.m_uiWorstBodyId = frame.m_Bodies[uiFirstBody + uiLane].m_uiBodyId;
+      }
+
+      inout_hit.m_bSquaredValue = bSquaredMetric;
+      ++inout_hit.m_uiCount;
+    }
+  }
+} // namespace
+
+nsJvdAnomalyDetector::nsJvdAnomalyDetector() = default;
+nsJvdAnomalyDetector::~nsJvdAnomalyDetector() = default;
+
+void nsJvdAnomalyDetector::Configure(const nsJvdAnomalyDetectionSettings& settings)
+{
+  m_Settings = settings;
+}
+
+void nsJvdAnomalyDetector::Reset()
+{
+  m_bHasPrevious = false;
+  m_PrevTimestamp = nsTime::MakeZero();
+  m_PrevBodyIds.Clear();
+  m_PrevBodyIndices.Clear();
+  m_bPrevIndexed = false;
+  m_PrevColumns.Clear();
+  m_uiPrevStride = 0;
+}
+
+nsUInt32 nsJvdAnomalyDetector::ProcessFrame(const nsJvdFrame& frame, nsDynamicArray<nsJvdBookmark>& inout_bookmarks)
+{
+  m_uiStride = nsMemoryUtils::AlignSize(frame.m_Bodies.GetCount(), 4u);
+  m_Columns.SetCountUninitialized(m_uiStride * ColumnCount);
+
+  TransposeFrame(frame);
+  GatherPrevious(frame);
+
+  const float fDeltaTime = m_bHasPrevious ? static_cast<float>((frame.m_Timestamp - m_PrevTimestamp).GetSeconds()) : 0.0f;
+
+  const nsSimdVec4f vZero = nsSimdVec4f::MakeZero();
+  const nsSimdVec4f vOne(1.0f);
+  const nsSimdVec4f vHalf(0.5f);
+  const nsSimdVec4f vDeltaTime(fDeltaTime);
+  const nsSimdVec4f vMaxLinearChangeSqr(nsMath::Square(m_Settings.m_fMaxLinearVelocityChange));
+  const nsSimdVec4f vMaxAngularChangeSqr(nsMath::Square(m_Settings.m_fMaxAngularVelocityChange));
+  const nsSimdVec4f vTeleportDistance(m_Settings.m_fTeleportDistance);
+  const nsSimdVec4f vMaxEnergyGain(m_Settings.m_fMaxEnergyGain);
+  const nsSimdVec4f vMaxRelativeEnergyGain(m_Settings.m_fMaxRelativeEnergyGain);
+  const nsSimdVec4f vGravityX(m_Settings.m_vGravity.x);
+  const nsSimdVec4f vGravityY(m_Settings.m_vGravity.y);
+  const nsSimdVec4f vGravityZ(m_Settings.m_vGravity.z);
+  const nsSimdVec4f vMinX(m_Settings.m_vWorldBoundsMin.x);
+  const nsSimdVec4f vMinY(m_Settings.m_vWorldBoundsMin.y);
+  const nsSimdVec4f vMinZ(m_Settings.m_vWorldBoundsMin.z);
+  const nsSimdVec4f vMaxX(m_Settings.m_vWorldBoundsMax.x);
+  const nsSimdVec4f vMaxY(m_Settings.m_vWorldBoundsMax.y);
+  const nsSimdVec4f vMaxZ(m_Settings.m_vWorldBoundsMax.z);
+
+  nsJvdAnomalyHit hits[nsJvdBookmarkKind::ENUM_COUNT];
+
+  for (nsUInt32 i = 0; i < m_uiStride; i += 4)
+  {
+    auto Load = [&](Column column)
+    {
+      nsSimdVec4f v;
+      v.Load<4>(GetColumn(column) + i);
+      return v;
+    };
+
+    const nsSimdVec4f px = Load(PosX);
+    const nsSimdVec4f py = Load(PosY);
+    const nsSimdVec4f pz = Load(PosZ);
+    const nsSimdVec4f lx = Load(LinX);
+    const nsSimdVec4f ly = Load(LinY);
+    const nsSimdVec4f lz = Load(LinZ);
+    const nsSimdVec4f ax = Load(AngX);
+    const nsSimdVec4f ay = Load(AngY);
+    const nsSimdVec4f az = Load(AngZ);
+
+    const nsSimdVec4f ppx = Load(PrevPosX);
+    const nsSimdVec4f ppy = Load(PrevPosY);
+    const nsSimdVec4f ppz = Load(PrevPosZ);
+    const nsSimdVec4f plx = Load(PrevLinX);
+    const nsSimdVec4f ply = Load(PrevLinY);
+    const nsSimdVec4f plz = Load(PrevLinZ);
+
+    const nsSimdVec4b prevValid = Load(PrevValid) > vHalf;
+    const nsSimdVec4b prevFinite = Load(PrevFinite) > vHalf;
+
+    // x - x is zero for finite values and NaN for both NaN and Inf
+    nsSimdVec4f vFiniteTest = (px - px) + (py - py) + (pz - pz);
+    {
+      const nsSimdVec4f qx = Load(RotX);
+      const nsSimdVec4f qy = Load(RotY);
+      const nsSimdVec4f qz = Load(RotZ);
+      const nsSimdVec4f qw = Load(RotW);
+      vFiniteTest += (qx - qx) + (qy - qy) + (qz - qz) + (qw - qw);
+    }
+
+    const nsSimdVec4b finite = vFiniteTest == vZero;
+    nsSimdVec4f::Select(finite, vOne, vZero).Store<4>(GetColumn(Finite) + i);
+
+    if (m_Settings.m_bDetectNonFiniteTransforms)
+    {
+      RecordAnomalyHits(!finite && prevFinite, vZero, false, i, frame, hits[nsJvdBookmarkKind::NonFiniteTransform]);
+    }
+
+    // motion is only compared between finite states, broken transforms already got their own bookmark
+    const nsSimdVec4b compare = prevValid && finite && prevFinite;
+
+    const nsSimdVec4f linearSqr = SoaLengthSquared(lx, ly, lz);
+    const nsSimdVec4f prevLinearSqr = SoaLengthSquared(plx, ply, plz);
+
+    if (m_Settings.m_bDetectVelocitySpikes)
+    {
+      const nsSimdVec4f linearChangeSqr = SoaLengthSquared(lx - plx, ly - ply, lz - plz);
+      RecordAnomalyHits(compare && linearChangeSqr > vMaxLinearChangeSqr, linearChangeSqr, true, i, frame, hits[nsJvdBookmarkKind::VelocitySpike]);
+
+      const nsSimdVec4f angularChangeSqr = SoaLengthSquared(ax - Load(PrevAngX), ay - Load(PrevAngY), az - Load(PrevAngZ));
+      RecordAnomalyHits(compare && angularChangeSqr > vMaxAngularChangeSqr, angularChangeSqr, true, i, frame, hits[nsJvdBookmarkKind::AngularVelocitySpike]);
+    }
+
+    if (m_Settings.m_bDetectTeleports)
+    {
+      const nsSimdVec4f distanceSqr = SoaLengthSquared(px - ppx, py - ppy, pz - ppz);
+      const nsSimdVec4f allowedDistance = nsSimdVec4f::MulAdd(linearSqr.CompMax(prevLinearSqr).GetSqrt(), vDeltaTime, vTeleportDistance);
+      RecordAnomalyHits(compare && distanceSqr > allowedDistance.CompMul(allowedDistance), distanceSqr, true, i, frame, hits[nsJvdBookmarkKind::Teleport]);
+    }
+
+    if (m_Settings.m_bDetectEnergyGain)
+    {
+      const nsSimdVec4f angularSqr = SoaLengthSquared(ax, ay, az);
+      const nsSimdVec4f prevAngularSqr = SoaLengthSquared(Load(PrevAngX), Load(PrevAngY), Load(PrevAngZ));
+
+      // kinetic energy minus the work gravity can do, per unit mass and inertia
+      const nsSimdVec4f potential = nsSimdVec4f::MulAdd(vGravityX, px, nsSimdVec4f::MulAdd(vGravityY, py, vGravityZ.CompMul(pz)));
+      const nsSimdVec4f prevPotential = nsSimdVec4f::MulAdd(vGravityX, ppx, nsSimdVec4f::MulAdd(vGravityY, ppy, vGravityZ.CompMul(ppz)));
+      const nsSimdVec4f energy = nsSimdVec4f::MulSub(vHalf, linearSqr + angularSqr, potential);
+      const nsSimdVec4f prevEnergy = nsSimdVec4f::MulSub(vHalf, prevLinearSqr + prevAngularSqr, prevPotential);
+
+      const nsSimdVec4f gain = energy - prevEnergy;
+      const nsSimdVec4f allowedGain = vMaxEnergyGain.CompMax(vMaxRelativeEnergyGain.CompMul(prevEnergy.Abs()));
+      RecordAnomalyHits(compare && gain > allowedGain, gain, false, i, frame, hits[nsJvdBookmarkKind::EnergyGain]);
+    }
+
+    const nsSimdVec4b inside = (px >= vMinX) && (px <= vMaxX) && (py >= vMinY) && (py <= vMaxY) && (pz >= vMinZ) && (pz <= vMaxZ);
+    nsSimdVec4f::Select(inside, vOne, vZero).Store<4>(GetColumn(Inside) + i);
+
+    if (m_Settings.m_bDetectOutOfBounds)
+    {
+      RecordAnomalyHits(!inside && finite && (Load(PrevInside) > vHalf), vZero, false, i, frame, hits[nsJvdBookmarkKind::OutOfBounds]);
+    }
+  }
+
+  nsUInt32 uiNumBookmarks = 0;
+  for (nsUInt32 uiKind = 0; uiKind < nsJvdBookmarkKind::ENUM_COUNT; ++uiKind)
+  {
+    const nsJvdAnomalyHit& hit = hits[uiKind];
+    if (hit.m_uiCount == 0)
+      continue;
+
+    nsJvdBookmark& bookmark = inout_bookmarks.ExpandAndGetRef();
+    bookmark.m_uiFrameIndex = frame.m_uiFrameIndex;
+    bookmark.m_Timestamp = frame.m_Timestamp;
+    bookmark.m_Kind = static_cast<nsJvdBookmarkKind::Enum>(uiKind);
+    bookmark.m_uiBodyId = hit.m_uiWorstBodyId;
+    bookmark.m_uiBodyCount = hit.m_uiCount;
+    bookmark.m_fValue = hit.m_bSquaredValue ? nsMath::Sqrt(hit.m_fWorstValue) : hit.m_fWorstValue;
+    ++uiNumBookmarks;
+  }
+
+  KeepAsPrevious(frame);
+  return uiNumBookmarks;
+}
+
+void nsJvdAnomalyDetector::TransposeFrame(const nsJvdFrame& frame)
+{
+  const nsUInt32 uiBodyCount = frame.m_Bodies.GetCount();
+
+  float* pPosX = GetColumn(PosX);
+  float* pPosY = GetColumn(PosY);
+  float* pPosZ = GetColumn(PosZ);
+  float* pRotX = GetColumn(RotX);
+  float* pRotY = GetColumn(RotY);
+  float* pRotZ = GetColumn(RotZ);
+  float* pRotW = GetColumn(RotW);
+  float* pLinX = GetColumn(LinX);
+  float* pLinY = GetColumn(LinY);
+  float* pLinZ = GetColumn(LinZ);
+  float* pAngX = GetColumn(AngX);
+  float* pAngY = GetColumn(AngY);
+  float* pAngZ = GetColumn(AngZ);
+
+  for (nsUInt32 i = 0; i < uiBodyCount; ++i)
+  {
+    const nsJvdBodyState& state = frame.m_Bodies[i];
+    pPosX[i] = state.m_vPosition.x;
+    pPosY[i] = state.m_vPosition.y;
+    pPosZ[i] = state.m_vPosition.z;
+    pRotX[i] = state.m_qRotation.x;
+    pRotY[i] = state.m_qRotation.y;
+    pRotZ[i] = state.m_qRotation.z;
+    pRotW[i] = state.m_qRotation.w;
+    pLinX[i] = state.m_vLinearVelocity.x;
+    pLinY[i] = state.m_vLinearVelocity.y;
+    pLinZ[i] = state.m_vLinearVelocity.z;
+    pAngX[i] = state.m_vAngularVelocity.x;
+    pAngY[i] = state.m_vAngularVelocity.y;
+    pAngZ[i] = state.m_vAngularVelocity.z;
+  }
+
+  // padding lanes are all zero and have no valid previous state, so they never report anything
+  for (nsUInt32 uiColumn = 0; uiColumn < ColumnCount; ++uiColumn)
+  {
+    float* pColumn = GetColumn(static_cast<Column>(uiColumn));
+    for (nsUInt32 i = uiBodyCount; i < m_uiStride; ++i)
+    {
+      pColumn[i] = 0.0f;
+    }
+  }
+}
+
+void nsJvdAnomalyDetector::GatherPrevious(const nsJvdFrame& frame)
+{
+  // PrevPosX to PrevInside mirror these kept columns
+  static constexpr Column s_PrevSources[] = {PosX, PosY, PosZ, LinX, LinY, LinZ, AngX, AngY, AngZ, Finite, Inside};
+  static_assert(NS_ARRAY_SIZE(s_PrevSources) == PrevValid - PrevPosX);
+
+  const nsUInt32 uiBodyCount = frame.m_Bodies.GetCount();
+  bool bSlotsBuilt = false;
+  bool bLookupBuilt = false;
+
+  float* pPrevValid = GetColumn(PrevValid);
+  float* pPrevFinite = GetColumn(PrevFinite);
+  float* pPrevInside = GetColumn(PrevInside);
+
+  for (nsUInt32 i = 0; i < uiBodyCount; ++i)
+  {
+    const nsJvdBodyState& state = frame.m_Bodies[i];
+    nsUInt32 uiPrev = nsInvalidIndex;
+
+    if (m_bHasPrevious)
+    {
+      // body order rarely changes between frames, only fall back to the lookup table if it does
+      if (i < m_PrevBodyIds.GetCount() && m_PrevBodyIds[i] == state.m_uiBodyId)
+      {
+        uiPrev = i;
+      }
+      else
+      {
+        uiPrev = FindPrevious(state, bSlotsBuilt, bLookupBuilt);
+      }
+    }
+
+    if (uiPrev == nsInvalidIndex)
+    {
+      for (nsUInt32 k = 0; k < NS_ARRAY_SIZE(s_PrevSources); ++k)
+      {
+        GetColumn(static_cast<Column>(PrevPosX + k))[i] = 0.0f;
+      }
+
+      // new bodies report non-finite transforms and out-of-bounds positions right away
+      pPrevFinite[i] = 1.0f;
+      pPrevInside[i] = 1.0f;
+      pPrevValid[i] = 0.0f;
+      continue;
+    }
+
+    for (nsUInt32 k = 0; k < NS_ARRAY_SIZE(s_PrevSources); ++k)
+    {
+      GetColumn(static_cast<Column>(PrevPosX + k))[i] = GetPrevColumn(s_PrevSources[k])[uiPrev];
+    }
+
+    pPrevValid[i] = state.m_bWasTeleported ? 0.0f : 1.0f;
+  }
+}
+
+nsUInt32 nsJvdAnomalyDetector::FindPrevious(const nsJvdBodyState& state, bool& inout_bSlotsBuilt, bool& inout_bLookupBuilt)
+{
+  if (m_bPrevIndexed && state.m_uiBodyIndex != nsInvalidIndex)
+  {
+    // recorded frames carry dense body indices, so the lookup is a plain array
+    if (!inout_bSlotsBuilt)
+    {
+      m_PrevSlots.Clear();
+      for (nsUInt32 j = 0; j < m_PrevBodyIndices.GetCount(); ++j)
+      {
+        const nsUInt32 uiBodyIndex = m_PrevBodyIndices[j];
+        if (uiBodyIndex >= m_PrevSlots.GetCount())
+        {
+          m_PrevSlots.SetCount(uiBodyIndex + 1, nsInvalidIndex);
+        }
+
+        m_PrevSlots[uiBodyIndex] = j;
+      }
+      inout_bSlotsBuilt = true;
+    }
+
+    if (state.m_uiBodyIndex >= m_PrevSlots.GetCount())
+      return nsInvalidIndex;
+
+    // indices of different clips may refer to different bodies
+    const nsUInt32 uiPrev = m_PrevSlots[state.m_uiBodyIndex];
+    if (uiPrev != nsInvalidIndex && m_PrevBodyIds[uiPrev] == state.m_uiBodyId)
+      return uiPrev;
+
+    return nsInvalidIndex;
+  }
+
+  if (!inout_bLookupBuilt)
+  {
+    m_PrevLookup.Clear();
+    m_PrevLookup.Reserve(m_PrevBodyIds.GetCount());
+    for (nsUInt32 j = 0; j < m_PrevBodyIds.GetCount(); ++j)
+    {
+      m_PrevLookup.Insert(m_PrevBodyIds[j], j);
+    }
+    inout_bLookupBuilt = true;
+  }
+
+  nsUInt32 uiPrev = nsInvalidIndex;
+  m_PrevLookup.TryGetValue(state.m_uiBodyId, uiPrev);
+  return uiPrev;
+}
+
+void nsJvdAnomalyDetector::KeepAsPrevious(const nsJvdFrame& frame)
+{
+  const nsUInt32 uiBodyCount = frame.m_Bodies.GetCount();
+
+  m_uiPrevStride = m_uiStride;
+  m_PrevColumns.SetCountUninitialized(KeptColumnCount * m_uiStride);
+  nsMemoryUtils::Copy(m_PrevColumns.GetData(), m_Columns.GetData(), KeptColumnCount * m_uiStride);
+
+  m_PrevBodyIds.SetCountUninitialized(uiBodyCount);
+  m_PrevBodyIndices.SetCountUninitialized(uiBodyCount);
+  m_bPrevIndexed = true;
+  for (nsUInt32 i = 0; i < uiBodyCount; ++i)
+  {
+    m_PrevBodyIds[i] = frame.m_Bodies[i].m_uiBodyId;
+    m_PrevBodyIndices[i] = frame.m_Bodies[i].m_uiBodyIndex;
+    m_bPrevIndexed &= frame.m_Bodies[i].m_uiBodyIndex != nsInvalidIndex;
+  }
+
+  m_PrevTimestamp = frame.m_Timestamp;
+  m_bHasPrevious = true;
+}
+
+NS_STATICLINK_FILE(JVDSDK, Recording_JvdAnomalyDetector);
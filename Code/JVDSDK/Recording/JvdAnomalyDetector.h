@@ -0,0 +1,90 @@
+#pragma once
+
+#include <JVDSDK/Recording/JvdRecordingTypes.h>
+
+#include <Foundation/Containers/HashTable.h>
+
+/// \brief Compares consecutive frames for simulation anomalies and emits at most one bookmark per anomaly kind and frame.
+///
+/// Body states are transposed into SoA columns and evaluated four bodies at a time with nsSimdVec4f. Bodies are matched
+/// against the previous frame by id. Bodies flagged as teleported are only checked for non-finite transforms and bounds.
+/// Non-finite transforms and out-of-bounds bodies are only reported in the frame where they first occur.
+class NS_JVDSDK_DLL nsJvdAnomalyDetector
+{
+public:
+  nsJvdAnomalyDetector();
+  ~nsJvdAnomalyDetector();
+
+  void Configure(const nsJvdAnomalyDetectionSettings& settings);
+  const nsJvdAnomalyDetectionSettings& GetSettings() const { return m_Settings; }
+
+  /// \brief Forgets the previous frame, e.g. when a new recording starts.
+  void Reset();
+
+  /// \brief Checks the frame against the previously processed one and appends bookmarks for all detected anomalies.
+  ///
+  /// Returns the number of appended bookmarks.
+  nsUInt32 ProcessFrame(const nsJvdFrame& frame, nsDynamicArray<nsJvdBookmark>& inout_bookmarks);
+
+private:
+  enum Column
+  {
+    PosX,
+    PosY,
+    PosZ,
+    RotX,
+    RotY,
+    RotZ,
+    RotW,
+    LinX,
+    LinY,
+    LinZ,
+    AngX,
+    AngY,
+    AngZ,
+    Finite,
+    Inside,
+
+    // values of the matching body in the previous frame
+    PrevPosX,
+    PrevPosY,
+    PrevPosZ,
+    PrevLinX,
+    PrevLinY,
+    PrevLinZ,
+    PrevAngX,
+    PrevAngY,
+    PrevAngZ,
+    PrevFinite,
+    PrevInside,
+    PrevValid,
+
+    ColumnCount
+  };
+
+  /// The first columns are kept for the next frame, everything up to (and including) Inside is copied.
+  static constexpr nsUInt32 KeptColumnCount = Inside + 1;
+
+  float* GetColumn(Column column) { return m_Columns.GetData() + column * m_uiStride; }
+  const float* GetPrevColumn(Column column) const { return m_PrevColumns.GetData() + column * m_uiPrevStride; }
+
+  void TransposeFrame(const nsJvdFrame& frame);
+  void GatherPrevious(const nsJvdFrame& frame);
+  void KeepAsPrevious(const nsJvdFrame& frame);
+  nsUInt32 FindPrevious(const nsJvdBodyState& state, bool& inout_bSlotsBuilt, bool& inout_bLookupBuilt);
+
+  nsJvdAnomalyDetectionSettings m_Settings;
+
+  nsUInt32 m_uiStride = 0;
+  nsDynamicArray<float> m_Columns;
+
+  bool m_bHasPrevious = false;
+  nsTime m_PrevTimestamp;
+  nsUInt32 m_uiPrevStride = 0;
+  nsDynamicArray<float> m_PrevColumns;
+  nsDynamicArray<nsUInt64> m_PrevBodyIds;
+  nsDynamicArray<nsUInt32> m_PrevBodyIndices;
+  bool m_bPrevIndexed = false;                  ///< Whether all previous bodies have a body index.
+  nsDynamicArray<nsUInt32> m_PrevSlots;         ///< Previous position by body index.
+  nsHashTable<nsUInt64, nsUInt32> m_PrevLookup; ///< Previous position by body id, for bodies without a body index.
+};
@@ -0,0 +1,97 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Recording/JvdBodyCapture.h>
+#include <JVDSDK/Recording/JvdConversion.h>
+
+#include <Foundation/Strings/StringBuilder.h>
+
+using namespace nsJvdConversion;
+
+nsUInt64 nsJvdBodyCapture::MakeBodyKey(const JPH::BodyID& bodyId)
+{
+  return static_cast<nsUInt64>(bodyId.GetIndexAndSequenceNumber());
+}
+
+bool nsJvdBodyCapture::ShouldCaptureBody(const nsJvdRecordingSettings& settings, nsUInt64 uiBodyId, bool bIsSleeping)
+{
+  if (!settings.m_IncludedBodies.IsEmpty())
+  {
+    bool bFound = false;
+    for (nsUInt64 includeId : settings.m_IncludedBodies)
+    {
+      if (includeId == uiBodyId)
+      {
+        bFound = true;
+        break;
+      }
+    }
+
+    if (!bFound)
+      return false;
+  }
+
+  for (nsUInt64 excludeId : settings.m_ExcludedBodies)
+  {
+    if (excludeId == uiBodyId)
+      return false;
+  }
+
+  if (!settings.m_bCaptureSleepingBodies && bIsSleeping)
+    return false;
+
+  return true;
+}
+
+void nsJvdBodyCapture::CaptureState(const nsJvdRecordingSettings& settings, const JPH::BodyInterface& bodyInterface, const JPH::BodyID& bodyId, bool bIsActive, nsJvdBodyState& out_state)
+{
+  out_state.m_uiBodyId = MakeBodyKey(bodyId);
+  out_state.m_vPosition = ToVec3(bodyInterface.GetPosition(bodyId));
+  out_state.m_qRotation = ToQuat(bodyInterface.GetRotation(bodyId));
+  out_state.m_vScale.Set(1.0f);
+
+  if (settings.m_bRecordVelocities)
+  {
+    out_state.m_vLinearVelocity = ToVec3(bodyInterface.GetLinearVelocity(bodyId));
+    out_state.m_vAngularVelocity = ToVec3(bodyInterface.GetAngularVelocity(bodyId));
+  }
+
+  out_state.m_fFriction = bodyInterface.GetFriction(bodyId);
+  out_state.m_fRestitution = bodyInterface.GetRestitution(bodyId);
+  out_state.m_bIsSleeping = !bIsActive;
+  out_state.m_bWasTeleported = false;
+}
+
+void nsJvdBodyCapture::UpdateMetadata(const JPH::BodyInterface& bodyInterface, const JPH::BodyID& bodyId, nsJvdBodyMetadata& inout_metadata)
+{
+  const nsUInt64 uiBodyKey = MakeBodyKey(bodyId);
+
+  if (!inout_metadata.m_BodyGuid.IsValid())
+  {
+    inout_metadata.Reset();
+    inout_metadata.m_uiBodyId = uiBodyKey;
+    inout_metadata.m_BodyGuid = nsUuid::MakeUuid();
+
+    nsStringBuilder tmp;
+    tmp.SetFormat("Body_{0}", uiBodyKey);
+    inout_metadata.m_sName = tmp;
+  }
+
+  inout_metadata.m_uiSceneInstanceId = bodyInterface.GetUserData(bodyId);
+
+  nsStringBuilder layerName;
+  layerName.SetFormat("Layer_{0}", static_cast<nsUInt32>(bodyInterface.GetObjectLayer(bodyId)));
+  inout_metadata.m_sLayer = layerName;
+
+  inout_metadata.m_bKinematic = (bodyInterface.GetMotionType(bodyId) == JPH::EMotionType::Kinematic);
+
+  if (auto shape = bodyInterface.GetShape(bodyId))
+  {
+    const JPH::EShapeSubType subType = shape->GetSubType();
+    if (static_cast<nsUInt32>(subType) < JPH::NumSubShapeTypes)
+    {
+      inout_metadata.m_sShape = JPH::sSubShapeTypeNames[static_cast<nsUInt32>(subType)];
+    }
+  }
+}
+
+NS_STATICLINK_FILE(JVDSDK, Recording_JvdBodyCapture);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <JVDSDK/Recording/JvdRecordingTypes.h>
+
+namespace JPH
+{
+  class BodyInterface;
+  class BodyID;
+} // namespace JPH
+
+/// \brief Turns Jolt bodies into body states and body metadata. Shared by nsJvdRecorder and nsJvdRecordingTrack.
+namespace nsJvdBodyCapture
+{
+  /// \brief The body id stored in recordings, the index and sequence number of the Jolt body id.
+  NS_JVDSDK_DLL nsUInt64 MakeBodyKey(const JPH::BodyID& bodyId);
+
+  /// \brief Applies the body filters of the recording settings.
+  NS_JVDSDK_DLL bool ShouldCaptureBody(const nsJvdRecordingSettings& settings, nsUInt64 uiBodyId, bool bIsSleeping);
+
+  /// \brief Fills everything but the body index. Velocities are only read if the settings record them.
+  NS_JVDSDK_DLL void CaptureState(const nsJvdRecordingSettings& settings, const JPH::BodyInterface& bodyInterface, const JPH::BodyID& bodyId, bool bIsActive, nsJvdBodyState& out_state);
+
+  /// \brief Refreshes the metadata of a body. Metadata with an invalid guid is initialized first.
+  NS_JVDSDK_DLL void UpdateMetadata(const JPH::BodyInterface& bodyInterface, const JPH::BodyID& bodyId, nsJvdBodyMetadata& inout_metadata);
+} // namespace nsJvdBodyCapture
@@ -0,0 +1,32 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Recording/JvdBodyIndexMap.h>
+
+void nsJvdBodyIndexMap::Clear()
+{
+  m_BodyIds.Clear();
+  m_Indices.Clear();
+}
+
+nsUInt32 nsJvdBodyIndexMap::GetOrAddIndex(nsUInt64 uiBodyId)
+{
+  bool bExisted = false;
+  nsUInt32& uiIndex = m_Indices.FindOrAdd(uiBodyId, &bExisted);
+
+  if (!bExisted)
+  {
+    uiIndex = m_BodyIds.GetCount();
+    m_BodyIds.PushBack(uiBodyId);
+  }
+
+  return uiIndex;
+}
+
+nsUInt32 nsJvdBodyIndexMap::FindIndex(nsUInt64 uiBodyId) const
+{
+  nsUInt32 uiIndex = nsInvalidIndex;
+  m_Indices.TryGetValue(uiBodyId, uiIndex);
+  return uiIndex;
+}
+
+NS_STATICLINK_FILE(JVDSDK, Recording_JvdBodyIndexMap);
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <JVDSDK/JVDSDKDLL.h>
+
+#include <Foundation/Containers/DynamicArray.h>
+#include <Foundation/Containers/HashTable.h>
+#include <Foundation/Types/ArrayPtr.h>
+
+/// \brief Assigns dense clip-local indices to the 64-bit body ids of a recording, in the order the bodies are first seen.
+///
+/// Consumers that keep per-body data can store it in arrays indexed by nsJvdBodyState::m_uiBodyIndex instead of maps
+/// keyed by body id. The id to index lookup is the only hash lookup left, and it is only needed once per new body.
+class NS_JVDSDK_DLL nsJvdBodyIndexMap
+{
+public:
+  void Clear();
+
+  /// \brief Returns the index of the body, assigning the next free one if the body was not seen before.
+  nsUInt32 GetOrAddIndex(nsUInt64 uiBodyId);
+
+  /// \brief Returns nsInvalidIndex for unknown bodies.
+  nsUInt32 FindIndex(nsUInt64 uiBodyId) const;
+
+  /// \brief Returns the index of the body, trusting uiIndexHint if it already maps to the body. Avoids the hash lookup
+  /// for states that carry an index of this map.
+  nsUInt32 GetOrAddIndex(nsUInt64 uiBodyId, nsUInt32 uiIndexHint)
+  {
+    if (uiIndexHint < m_BodyIds.GetCount() && m_BodyIds[uiIndexHint] == uiBodyId)
+      return uiIndexHint;
+
+    return GetOrAddIndex(uiBodyId);
+  }
+
+  nsUInt64 GetBodyId(nsUInt32 uiIndex) const { return m_BodyIds[uiIndex]; }
+
+  /// \brief The body ids, indexed by body index.
+  nsArrayPtr<const nsUInt64> GetBodyIds() const { return m_BodyIds; }
+
+  nsUInt32 GetCount() const { return m_BodyIds.GetCount(); }
+
+private:
+  nsDynamicArray<nsUInt64> m_BodyIds;
+  nsHashTable<nsUInt64, nsUInt32> m_Indices;
+};
@@ -0,0 +1,174 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Recording/JvdCustomChannels.h>
+
+#include <Foundation/Memory/MemoryUtils.h>
+
+NS_BEGIN_STATIC_REFLECTED_ENUM(nsJvdCustomChannelType, 1)
+  NS_ENUM_CONSTANT(nsJvdCustomChannelType::Float),
+  NS_ENUM_CONSTANT(nsJvdCustomChannelType::Vec3),
+  NS_ENUM_CONSTANT(nsJvdCustomChannelType::Quat),
+  NS_ENUM_CONSTANT(nsJvdCustomChannelType::Int),
+  NS_ENUM_CONSTANT(nsJvdCustomChannelType::Bool)
+NS_END_STATIC_REFLECTED_ENUM;
+
+NS_BEGIN_STATIC_REFLECTED_TYPE(nsJvdCustomChannelDesc, nsNoBase, 1, nsRTTIDefaultAllocator<nsJvdCustomChannelDesc>)
+{
+  NS_BEGIN_PROPERTIES
+  {
+    NS_MEMBER_PROPERTY("Name", m_sName),
+    NS_ENUM_MEMBER_PROPERTY("Type", nsJvdCustomChannelType, m_Type),
+  }
+  NS_END_PROPERTIES;
+}
+NS_END_STATIC_REFLECTED_TYPE;
+
+nsUInt32 nsJvdCustomChannelType::GetComponentCount(Enum type)
+{
+  switch (type)
+  {
+    case Vec3:
+      return 3;
+    case Quat:
+      return 4;
+    default:
+      return 1;
+  }
+}
+
+void nsJvdCustomChannelColumn::Reset(nsJvdCustomChannelType::Enum type, nsUInt32 uiBodyCount)
+{
+  m_Type = type;
+  m_Values.SetCount(uiBodyCount * nsJvdCustomChannelType::GetComponentCount(type));
+  m_PresenceMask.SetCount((uiBodyCount + 31) / 32);
+
+  for (nsUInt32& uiWord : m_PresenceMask)
+  {
+    uiWord = 0;
+  }
+}
+
+nsUInt32 nsJvdCustomChannelColumn::GetBodyCount() const
+{
+  return m_Values.GetCount() / GetStride();
+}
+
+bool nsJvdCustomChannelColumn::HasValue(nsUInt32 uiBodyIndex) const
+{
+  const nsUInt32 uiWord = uiBodyIndex / 32;
+  if (uiWord >= m_PresenceMask.GetCount())
+    return false;
+
+  return (m_PresenceMask[uiWord] & (1u << (uiBodyIndex % 32))) != 0;
+}
+
+bool nsJvdCustomChannelColumn::IsEmpty() const
+{
+  for (nsUInt32 uiWord : m_PresenceMask)
+  {
+    if (uiWord != 0)
+      return false;
+  }
+
+  return true;
+}
+
+nsUInt32* nsJvdCustomChannelColumn::MarkPresent(nsUInt32 uiBodyIndex, nsJvdCustomChannelType::Enum type)
+{
+  NS_ASSERT_DEBUG(m_Type == type, "Custom channel value type mismatch (channel is {0}, value is {1}).", m_Type.GetValue(), type);
+  NS_ASSERT_DEBUG(uiBodyIndex < GetBodyCount(), "Body index {0} is out of range ({1} bodies).", uiBodyIndex, GetBodyCount());
+  NS_IGNORE_UNUSED(type);
+
+  m_PresenceMask[uiBodyIndex / 32] |= (1u << (uiBodyIndex % 32));
+  return &m_Values[uiBodyIndex * GetStride()];
+}
+
+const nsUInt32* nsJvdCustomChannelColumn::GetPresent(nsUInt32 uiBodyIndex, nsJvdCustomChannelType::Enum type) const
+{
+  if (m_Type != type || !HasValue(uiBodyIndex))
+    return nullptr;
+
+  return &m_Values[uiBodyIndex * GetStride()];
+}
+
+void nsJvdCustomChannelColumn::SetValue(nsUInt32 uiBodyIndex, float fValue)
+{
+  nsMemoryUtils::Copy(MarkPresent(uiBodyIndex, nsJvdCustomChannelType::Float), reinterpret_cast<const nsUInt32*>(&fValue), 1);
+}
+
+void nsJvdCustomChannelColumn::SetValue(nsUInt32 uiBodyIndex, const nsVec3& vValue)
+{
+  nsMemoryUtils::Copy(MarkPresent(uiBodyIndex, nsJvdCustomChannelType::Vec3), reinterpret_cast<const nsUInt32*>(&vValue), 3);
+}
+
+void nsJvdCustomChannelColumn::SetValue(nsUInt32 uiBodyIndex, const nsQuat& qValue)
+{
+  nsMemoryUtils::Copy(MarkPresent(uiBodyIndex, nsJvdCustomChannelType::Quat), reinterpret_cast<const nsUInt32*>(&qValue), 4);
+}
+
+void nsJvdCustomChannelColumn::SetValue(nsUInt32 uiBodyIndex, nsInt32 iValue)
+{
+  *MarkPresent(uiBodyIndex, nsJvdCustomChannelType::Int) = static_cast<nsUInt32>(iValue);
+}
+
+void nsJvdCustomChannelColumn::SetValue(nsUInt32 uiBodyIndex, bool bValue)
+{
+  *MarkPresent(uiBodyIndex, nsJvdCustomChannelType::Bool) = bValue ? 1u : 0u;
+}
+
+void nsJvdCustomChannelColumn::SetRawValue(nsUInt32 uiBodyIndex, const nsUInt32* pWords)
+{
+  nsMemoryUtils::Copy(MarkPresent(uiBodyIndex, m_Type), pWords, GetStride());
+}
+
+bool nsJvdCustomChannelColumn::TryGetValue(nsUInt32 uiBodyIndex, float& out_fValue) const
+{
+  const nsUInt32* pWords = GetPresent(uiBodyIndex, nsJvdCustomChannelType::Float);
+  if (pWords == nullptr)
+    return false;
+
+  nsMemoryUtils::Copy(reinterpret_cast<nsUInt32*>(&out_fValue), pWords, 1);
+  return true;
+}
+
+bool nsJvdCustomChannelColumn::TryGetValue(nsUInt32 uiBodyIndex, nsVec3& out_vValue) const
+{
+  const nsUInt32* pWords = GetPresent(uiBodyIndex, nsJvdCustomChannelType::Vec3);
+  if (pWords == nullptr)
+    return false;
+
+  nsMemoryUtils::Copy(reinterpret_cast<nsUInt32*>(&out_vValue), pWords, 3);
+  return true;
+}
+
+bool nsJvdCustomChannelColumn::TryGetValue(nsUInt32 uiBodyIndex, nsQuat& out_qValue) const
+{
+  const nsUInt32* pWords = GetPresent(uiBodyIndex, nsJvdCustomChannelType::Quat);
+  if (pWords == nullptr)
+    return false;
+
+  nsMemoryUtils::Copy(reinterpret_cast<nsUInt32*>(&out_qValue), pWords, 4);
+  return true;
+}
+
+bool nsJvdCustomChannelColumn::TryGetValue(nsUInt32 uiBodyIndex, nsInt32& out_iValue) const
+{
+  const nsUInt32* pWords = GetPresent(uiBodyIndex, nsJvdCustomChannelType::Int);
+  if (pWords == nullptr)
+    return false;
+
+  out_iValue = static_cast<nsInt32>(*pWords);
+  return true;
+}
+
+bool nsJvdCustomChannelColumn::TryGetValue(nsUInt32 uiBodyIndex, bool& out_bValue) const
+{
+  const nsUInt32* pWords = GetPresent(uiBodyIndex, nsJvdCustomChannelType::Bool);
+  if (pWords == nullptr)
+    return false;
+
+  out_bValue = (*pWords != 0);
+  return true;
+}
+
+NS_STATICLINK_FILE(JVDSDK, Recording_JvdCustomChannels);
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <JVDSDK/JVDSDKDLL.h>
+
+#include <Foundation/Containers/DynamicArray.h>
+#include <Foundation/Math/Quat.h>
+#include <Foundation/Math/Vec3.h>
+#include <Foundation/Reflection/Reflection.h>
+#include <Foundation/Strings/String.h>
+#include <Foundation/Types/Enum.h>
+
+/// \brief Value type of a clip-level custom channel.
+struct NS_JVDSDK_DLL nsJvdCustomChannelType
+{
+  using StorageType = nsUInt8;
+
+  enum Enum
+  {
+    Float,
+    Vec3,
+    Quat,
+    Int,
+    Bool,
+
+    ENUM_COUNT,
+
+    Default = Float,
+  };
+
+  /// \brief Returns how many 32-bit words one value of the given type occupies inside a column.
+  static nsUInt32 GetComponentCount(Enum type);
+};
+
+NS_DECLARE_REFLECTABLE_TYPE(NS_JVDSDK_DLL, nsJvdCustomChannelType);
+
+/// \brief Index of a custom channel, as returned by nsJvdRecordingSettings::AddCustomChannel().
+using nsJvdCustomChannelIndex = nsUInt16;
+
+/// \brief Declares a custom channel once per clip. Frames only store the values, never the name.
+struct NS_JVDSDK_DLL nsJvdCustomChannelDesc
+{
+  nsString m_sName;
+  nsEnum<nsJvdCustomChannelType> m_Type;
+};
+
+NS_DECLARE_REFLECTABLE_TYPE(NS_JVDSDK_DLL, nsJvdCustomChannelDesc);
+
+/// \brief Dense per-frame storage for one custom channel.
+///
+/// Values are stored as raw 32-bit words, one slot per body of the owning frame (same order as nsJvdFrame::m_Bodies).
+/// A presence bitmask records which bodies actually provided a value in this frame.
+struct NS_JVDSDK_DLL nsJvdCustomChannelColumn
+{
+  nsEnum<nsJvdCustomChannelType> m_Type;
+  nsDynamicArray<nsUInt32> m_Values;
+  nsDynamicArray<nsUInt32> m_PresenceMask;
+
+  /// \brief Resizes the column to uiBodyCount slots and marks all of them as not present.
+  void Reset(nsJvdCustomChannelType::Enum type, nsUInt32 uiBodyCount);
+
+  nsUInt32 GetBodyCount() const;
+  nsUInt32 GetStride() const { return nsJvdCustomChannelType::GetComponentCount(m_Type); }
+  bool HasValue(nsUInt32 uiBodyIndex) const;
+  bool IsEmpty() const;
+
+  void SetValue(nsUInt32 uiBodyIndex, float fValue);
+  void SetValue(nsUInt32 uiBodyIndex, const nsVec3& vValue);
+  void SetValue(nsUInt32 uiBodyIndex, const nsQuat& qValue);
+  void SetValue(nsUInt32 uiBodyIndex, nsInt32 iValue);
+  void SetValue(nsUInt32 uiBodyIndex, bool bValue);
+
+  /// \brief Copies the raw words of one value into the given slot. pWords must hold GetStride() words.
+  void SetRawValue(nsUInt32 uiBodyIndex, const nsUInt32* pWords);
+
+  bool TryGetValue(nsUInt32 uiBodyIndex, float& out_fValue) const;
+  bool TryGetValue(nsUInt32 uiBodyIndex, nsVec3& out_vValue) const;
+  bool TryGetValue(nsUInt32 uiBodyIndex, nsQuat& out_qValue) const;
+  bool TryGetValue(nsUInt32 uiBodyIndex, nsInt32& out_iValue) const;
+  bool TryGetValue(nsUInt32 uiBodyIndex, bool& out_bValue) const;
+
+  nsUInt64 GetHeapMemoryUsage() const { return m_Values.GetHeapMemoryUsage() + m_PresenceMask.GetHeapMemoryUsage(); }
+
+private:
+  nsUInt32* MarkPresent(nsUInt32 uiBodyIndex, nsJvdCustomChannelType::Enum type);
+  const nsUInt32* GetPresent(nsUInt32 uiBodyIndex, nsJvdCustomChannelType::Enum type) const;
+};
@@ -0,0 +1,52 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Recording/JvdFrameQueue.h>
+
+nsJvdFrameQueue::nsJvdFrameQueue() = default;
+nsJvdFrameQueue::~nsJvdFrameQueue() = default;
+
+void nsJvdFrameQueue::Initialize(nsUInt32 uiCapacity)
+{
+  NS_ASSERT_DEV(uiCapacity > 0, "The frame queue needs at least one slot.");
+
+  m_Slots.Clear();
+  m_Slots.SetCount(uiCapacity);
+  m_uiWriteIndex = 0;
+  m_uiReadIndex = 0;
+}
+
+bool nsJvdFrameQueue::TryPush(nsJvdFrame& inout_frame)
+{
+  const nsUInt32 uiWriteIndex = m_uiWriteIndex;
+
+  // the atomic read orders the consumer's last swap before our access to the slot
+  if (uiWriteIndex - m_uiReadIndex >= m_Slots.GetCount())
+    return false;
+
+  std::swap(m_Slots[uiWriteIndex % m_Slots.GetCount()], inout_frame);
+
+  // publishes the slot to the consumer
+  m_uiWriteIndex = uiWriteIndex + 1;
+  return true;
+}
+
+bool nsJvdFrameQueue::TryPop(nsJvdFrame& inout_frame)
+{
+  const nsUInt32 uiReadIndex = m_uiReadIndex;
+  if (uiReadIndex == m_uiWriteIndex)
+    return false;
+
+  std::swap(m_Slots[uiReadIndex % m_Slots.GetCount()], inout_frame);
+
+  // hands the slot back to the producer
+  m_uiReadIndex = uiReadIndex + 1;
+  return true;
+}
+
+nsUInt32 nsJvdFrameQueue::GetCount() const
+{
+  const nsUInt32 uiReadIndex = m_uiReadIndex;
+  return m_uiWriteIndex - uiReadIndex;
+}
+
+NS_STATICLINK_FILE(JVDSDK, Recording_JvdFrameQueue);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <JVDSDK/Recording/JvdRecordingTypes.h>
+
+#include <Foundation/Containers/DynamicArray.h>
+#include <Foundation/Threading/AtomicInteger.h>
+
+/// \brief Bounded lock-free queue of frames between exactly one producer and one consumer thread.
+///
+/// Used by nsJvdRecordingTrack to hand captured frames to nsJvdRecordingSession without a shared lock. Frames are
+/// swapped in and out of preallocated slots, so neither side copies the body states.
+class NS_JVDSDK_DLL nsJvdFrameQueue
+{
+  NS_DISALLOW_COPY_AND_ASSIGN(nsJvdFrameQueue);
+
+public:
+  nsJvdFrameQueue();
+  ~nsJvdFrameQueue();
+
+  /// \brief Allocates the slots and drops all queued frames. Neither side may access the queue concurrently.
+  void Initialize(nsUInt32 uiCapacity);
+
+  /// \brief Producer only. Swaps the frame into the queue, inout_frame receives whatever the slot held before.
+  ///
+  /// Returns false without touching the frame if the queue is full.
+  bool TryPush(nsJvdFrame& inout_frame);
+
+  /// \brief Consumer only. Swaps the oldest frame into inout_frame. Returns false if the queue is empty.
+  bool TryPop(nsJvdFrame& inout_frame);
+
+  /// \brief The number of queued frames. Only a snapshot while the other side is active.
+  nsUInt32 GetCount() const;
+
+  nsUInt32 GetCapacity() const { return m_Slots.GetCount(); }
+
+private:
+  nsDynamicArray<nsJvdFrame> m_Slots;
+
+  // both indices only grow (and wrap around), each is written by one side only
+  nsAtomicInteger<nsUInt32> m_uiWriteIndex;
+  nsAtomicInteger<nsUInt32> m_uiReadIndex;
+};
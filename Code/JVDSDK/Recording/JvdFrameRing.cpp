@@ -0,0 +1,153 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Recording/JvdFrameRing.h>
+#include <JVDSDK/Serialization/JvdStreamSerializer.h>
+
+#include <Foundation/IO/MemoryStream.h>
+
+namespace
+{
+  /// Only counts the bytes, used to find out how much ring space a frame needs before encoding it.
+  class nsJvdByteCountingWriter final : public nsStreamWriter
+  {
+  public:
+    virtual nsResult WriteBytes(const void* pWriteBuffer, nsUInt64 uiBytesToWrite) override
+    {
+      NS_IGNORE_UNUSED(pWriteBuffer);
+      m_uiBytes += uiBytesToWrite;
+      return NS_SUCCESS;
+    }
+
+    nsUInt64 m_uiBytes = 0;
+  };
+} // namespace
+
+nsJvdFrameRing::nsJvdFrameRing() = default;
+nsJvdFrameRing::~nsJvdFrameRing() = default;
+
+void nsJvdFrameRing::Initialize(nsUInt32 uiByteCapacity, nsUInt32 uiMaxFrames)
+{
+  Clear();
+
+  m_Data.SetCountUninitialized(uiByteCapacity);
+  m_Entries.SetCount(nsMath::Max(uiMaxFrames, 1u));
+}
+
+void nsJvdFrameRing::Clear()
+{
+  m_uiFirstEntry = 0;
+  m_uiEntryCount = 0;
+}
+
+void nsJvdFrameRing::Deallocate()
+{
+  Clear();
+  m_Data.Clear();
+  m_Data.Compact();
+  m_Entries.Clear();
+  m_Entries.Compact();
+}
+
+nsResult nsJvdFrameRing::PushFrame(const nsJvdFrame& frame)
+{
+  nsJvdByteCountingWriter counter;
+  if (nsJvdSerialization::WriteFrame(counter, frame).Failed())
+    return NS_FAILURE;
+
+  if (counter.m_uiBytes > m_Data.GetCount() || m_Entries.IsEmpty())
+    return NS_FAILURE;
+
+  const nsUInt32 uiSize = static_cast<nsUInt32>(counter.m_uiBytes);
+  const nsUInt32 uiOffset = FindWriteOffset(uiSize);
+
+  nsRawMemoryStreamWriter writer(m_Data.GetData() + uiOffset, uiSize);
+  if (nsJvdSerialization::WriteFrame(writer, frame).Failed())
+    return NS_FAILURE;
+
+  Entry& entry = m_Entries[(m_uiFirstEntry + m_uiEntryCount) % m_Entries.GetCount()];
+  entry.m_uiOffset = uiOffset;
+  entry.m_uiSize = uiSize;
+  entry.m_Timestamp = frame.m_Timestamp;
+  ++m_uiEntryCount;
+
+  return NS_SUCCESS;
+}
+
+nsUInt32 nsJvdFrameRing::FindWriteOffset(nsUInt32 uiSize)
+{
+  if (m_uiEntryCount == m_Entries.GetCount())
+  {
+    DropOldest();
+  }
+
+  while (m_uiEntryCount > 0)
+  {
+    const nsUInt32 uiOldestStart = GetOldest().m_uiOffset;
+    const nsUInt32 uiNewestEnd = GetNewest().m_uiOffset + GetNewest().m_uiSize;
+
+    if (uiOldestStart < uiNewestEnd)
+    {
+      // occupied range is [oldest, newest), free space is behind the newest frame and in front of the oldest one
+      if (m_Data.GetCount() - uiNewestEnd >= uiSize)
+        return uiNewestEnd;
+
+      if (uiOldestStart >= uiSize)
+        return 0;
+    }
+    else
+    {
+      // occupied range wraps around, free space is between the newest and the oldest frame
+      if (uiOldestStart - uiNewestEnd >= uiSize)
+        return uiNewestEnd;
+    }
+
+    DropOldest();
+  }
+
+  return 0;
+}
+
+void nsJvdFrameRing::DropOldest()
+{
+  NS_ASSERT_DEBUG(m_uiEntryCount > 0, "Frame ring is empty.");
+
+  m_uiFirstEntry = (m_uiFirstEntry + 1) % m_Entries.GetCount();
+  --m_uiEntryCount;
+
+  if (m_uiEntryCount == 0)
+  {
+    m_uiFirstEntry = 0;
+  }
+}
+
+void nsJvdFrameRing::DropFramesBefore(nsTime timestamp)
+{
+  while (m_uiEntryCount > 0 && GetOldest().m_Timestamp < timestamp)
+  {
+    DropOldest();
+  }
+}
+
+nsUInt32 nsJvdFrameRing::GetUsedBytes() const
+{
+  nsUInt32 uiBytes = 0;
+  for (nsUInt32 i = 0; i < m_uiEntryCount; ++i)
+  {
+    uiBytes += m_Entries[(m_uiFirstEntry + i) % m_Entries.GetCount()].m_uiSize;
+  }
+
+  return uiBytes;
+}
+
+void nsJvdFrameRing::CopyFrames(nsDynamicArray<nsUInt8>& out_data) const
+{
+  out_data.Reserve(out_data.GetCount() + GetUsedBytes());
+
+  for (nsUInt32 i = 0; i < m_uiEntryCount; ++i)
+  {
+    const Entry& entry = m_Entries[(m_uiFirstEntry + i) % m_Entries.GetCount()];
+    out_data.PushBackRange(m_Data.GetArrayPtr().GetSubArray(entry.m_uiOffset, entry.m_uiSize));
+  }
+}
+
+NS_STATICLINK_FILE(JVDSDK, Recording_JvdFrameRing);
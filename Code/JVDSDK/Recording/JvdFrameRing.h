@@ -0,0 +1,58 @@
+#pragma once
+
+#include <JVDSDK/Recording/JvdRecordingTypes.h>
+
+#include <Foundation/Containers/DynamicArray.h>
+
+/// \brief Fixed-capacity ring of serialized frames, used by the flight-recorder mode of nsJvdRecorder.
+///
+/// All memory is allocated in Initialize(). Pushing a frame encodes it in place with nsJvdSerialization::WriteFrame()
+/// and evicts the oldest frames once either the byte or the frame capacity is exhausted.
+class NS_JVDSDK_DLL nsJvdFrameRing
+{
+public:
+  nsJvdFrameRing();
+  ~nsJvdFrameRing();
+
+  /// \brief Allocates the ring. Keeps the existing allocation if it is already large enough.
+  void Initialize(nsUInt32 uiByteCapacity, nsUInt32 uiMaxFrames);
+
+  /// \brief Drops all frames but keeps the memory.
+  void Clear();
+
+  /// \brief Drops all frames and releases the memory.
+  void Deallocate();
+
+  /// \brief Encodes the frame into the ring. Fails if the frame does not fit into the ring at all.
+  nsResult PushFrame(const nsJvdFrame& frame);
+
+  /// \brief Evicts all frames with a timestamp older than the given one.
+  void DropFramesBefore(nsTime timestamp);
+
+  nsUInt32 GetFrameCount() const { return m_uiEntryCount; }
+  nsUInt32 GetByteCapacity() const { return m_Data.GetCount(); }
+
+  /// \brief Returns the number of bytes currently occupied by encoded frames.
+  nsUInt32 GetUsedBytes() const;
+
+  /// \brief Appends all encoded frames, oldest first, to out_data. The result can be decoded with nsJvdSerialization::ReadFrame().
+  void CopyFrames(nsDynamicArray<nsUInt8>& out_data) const;
+
+private:
+  struct Entry
+  {
+    nsUInt32 m_uiOffset = 0;
+    nsUInt32 m_uiSize = 0;
+    nsTime m_Timestamp;
+  };
+
+  const Entry& GetOldest() const { return m_Entries[m_uiFirstEntry]; }
+  const Entry& GetNewest() const { return m_Entries[(m_uiFirstEntry + m_uiEntryCount - 1) % m_Entries.GetCount()]; }
+  void DropOldest();
+  nsUInt32 FindWriteOffset(nsUInt32 uiSize);
+
+  nsDynamicArray<nsUInt8> m_Data;
+  nsDynamicArray<Entry> m_Entries;
+  nsUInt32 m_uiFirstEntry = 0;
+  nsUInt32 m_uiEntryCount = 0;
+};
@@ -0,0 +1,101 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Recording/JvdLogQueue.h>
+
+nsJvdLogQueue::nsJvdLogQueue() = default;
+nsJvdLogQueue::~nsJvdLogQueue() = default;
+
+void nsJvdLogQueue::Initialize(nsUInt32 uiCapacity)
+{
+  NS_ASSERT_DEV(uiCapacity > 0, "The log queue needs at least one slot.");
+
+  // positions wrap around at 2^32, which only maps onto the slots consistently for power of two counts
+  const nsUInt32 uiSlotCount = nsMath::PowerOfTwo_Ceil(uiCapacity);
+
+  m_Slots.Clear();
+  m_Slots.SetCount(uiSlotCount);
+  for (nsUInt32 i = 0; i < uiSlotCount; ++i)
+  {
+    m_Slots[i].m_uiSequence = i;
+  }
+
+  m_uiMask = uiSlotCount - 1;
+  m_uiWritePosition = 0;
+  m_uiReadPosition = 0;
+  m_uiDropped = 0;
+}
+
+bool nsJvdLogQueue::TryPush(nsLogMsgType::Enum type, nsUInt32 uiIndentation, nsStringView sTag, nsStringView sText)
+{
+  if (m_Slots.IsEmpty())
+    return false;
+
+  nsUInt32 uiPosition = m_uiWritePosition;
+  Slot* pSlot = nullptr;
+
+  while (true)
+  {
+    pSlot = &m_Slots[uiPosition & m_uiMask];
+    const nsInt32 iDifference = static_cast<nsInt32>(pSlot->m_uiSequence - uiPosition);
+
+    if (iDifference == 0)
+    {
+      // the slot is free, whoever moves the write position past it owns it
+      const nsUInt32 uiSeen = m_uiWritePosition.CompareAndSwap(uiPosition, uiPosition + 1);
+      if (uiSeen == uiPosition)
+        break;
+
+      uiPosition = uiSeen;
+    }
+    else if (iDifference < 0)
+    {
+      // the consumer has not read the message a whole lap ago yet
+      m_uiDropped.Increment();
+      return false;
+    }
+    else
+    {
+      // another producer claimed this position in the meantime
+      uiPosition = m_uiWritePosition;
+    }
+  }
+
+  nsJvdLogEntry& entry = pSlot->m_Entry;
+  entry.m_Type = type;
+  entry.m_uiIndentation = uiIndentation;
+  entry.m_sTag = sTag;
+  entry.m_sText = sText;
+
+  // publishes the message to the consumer
+  pSlot->m_uiSequence = uiPosition + 1;
+  return true;
+}
+
+nsUInt32 nsJvdLogQueue::Drain(nsDynamicArray<nsJvdLogEntry>& out_entries, nsUInt32 uiMaxEntries)
+{
+  nsUInt32 uiDrained = 0;
+
+  while (uiDrained < uiMaxEntries && !m_Slots.IsEmpty())
+  {
+    Slot& slot = m_Slots[m_uiReadPosition & m_uiMask];
+
+    // a claimed slot whose message is still being written ends the batch, it is picked up by the next drain
+    if (slot.m_uiSequence != m_uiReadPosition + 1)
+      break;
+
+    nsJvdLogEntry& entry = out_entries.ExpandAndGetRef();
+    entry.m_Type = slot.m_Entry.m_Type;
+    entry.m_uiIndentation = slot.m_Entry.m_uiIndentation;
+    std::swap(entry.m_sTag, slot.m_Entry.m_sTag);
+    std::swap(entry.m_sText, slot.m_Entry.m_sText);
+
+    // hands the slot to the producers of the next lap
+    slot.m_uiSequence = m_uiReadPosition + m_Slots.GetCount();
+    ++m_uiReadPosition;
+    ++uiDrained;
+  }
+
+  return uiDrained;
+}
+
+NS_STATICLINK_FILE(JVDSDK, Recording_JvdLogQueue);
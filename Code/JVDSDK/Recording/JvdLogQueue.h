@@ -0,0 +1,61 @@
+#pragma once
+
+#include <JVDSDK/JVDSDKDLL.h>
+
+#include <Foundation/Containers/DynamicArray.h>
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Strings/String.h>
+#include <Foundation/Threading/AtomicInteger.h>
+
+/// \brief One message taken out of an nsJvdLogQueue.
+struct nsJvdLogEntry
+{
+  nsLogMsgType::Enum m_Type = nsLogMsgType::None;
+  nsUInt32 m_uiIndentation = 0;
+  nsString m_sTag;
+  nsString m_sText;
+};
+
+/// \brief Bounded lock-free queue of log messages from any number of threads to one consumer thread.
+///
+/// Lets log writers hand messages to the UI without taking a lock or waking it up per message. Every slot carries a
+/// sequence number that tells producers and the consumer whose turn it is, so producers only contend on claiming a
+/// slot. When the queue is full new messages are dropped and counted instead of blocking the thread that logs.
+class NS_JVDSDK_DLL nsJvdLogQueue
+{
+  NS_DISALLOW_COPY_AND_ASSIGN(nsJvdLogQueue);
+
+public:
+  nsJvdLogQueue();
+  ~nsJvdLogQueue();
+
+  /// \brief Allocates the slots, rounded up to a power of two, and drops all queued messages. No thread may access the
+  /// queue concurrently.
+  void Initialize(nsUInt32 uiCapacity);
+
+  /// \brief Any thread. Copies the message into the queue, returns false if it was dropped because the queue is full.
+  bool TryPush(nsLogMsgType::Enum type, nsUInt32 uiIndentation, nsStringView sTag, nsStringView sText);
+
+  /// \brief Consumer only. Appends up to uiMaxEntries of the oldest messages to out_entries and returns how many.
+  nsUInt32 Drain(nsDynamicArray<nsJvdLogEntry>& out_entries, nsUInt32 uiMaxEntries = nsInvalidIndex);
+
+  /// \brief Returns the number of messages dropped since the last call and resets it.
+  nsUInt32 TakeDroppedCount() { return m_uiDropped.Set(0); }
+
+  nsUInt32 GetCapacity() const { return m_Slots.GetCount(); }
+
+private:
+  struct Slot
+  {
+    /// Equal to the write position while the slot is free, one past it once the message is readable.
+    nsAtomicInteger<nsUInt32> m_uiSequence;
+    nsJvdLogEntry m_Entry;
+  };
+
+  nsDynamicArray<Slot> m_Slots;
+  nsUInt32 m_uiMask = 0;
+
+  nsAtomicInteger<nsUInt32> m_uiWritePosition; ///< Claimed by the producers with a compare-and-swap.
+  nsUInt32 m_uiReadPosition = 0;               ///< Only touched by the consumer.
+  nsAtomicInteger<nsUInt32> m_uiDropped;
+};
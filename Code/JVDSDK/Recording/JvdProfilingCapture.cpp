@@ -0,0 +1,199 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Recording/JvdProfilingCapture.h>
+
+#include <Foundation/Strings/StringBuilder.h>
+#include <Foundation/Utilities/Stats.h>
+
+namespace
+{
+  /// How often the profiler's buffers are copied. The main thread buffer has to hold twice this long.
+  constexpr double g_fCollectIntervalSeconds = 0.5;
+} // namespace
+
+nsJvdProfilingCapture::nsJvdProfilingCapture() = default;
+nsJvdProfilingCapture::~nsJvdProfilingCapture() = default;
+
+void nsJvdProfilingCapture::Start(nsTime minScopeDuration)
+{
+  m_Data.Clear();
+  m_PendingFrames.Clear();
+  m_ThreadIndices.Clear();
+
+  m_MinScopeDuration = minScopeDuration;
+  m_uiFirstKeptFrame = 0;
+  m_RecordingStartTime = nsTime::Now();
+  m_LastFrameEndTime = m_RecordingStartTime;
+  m_LastCollectionTime = m_RecordingStartTime;
+}
+
+void nsJvdProfilingCapture::AddFrame(nsUInt64 uiFrameIndex)
+{
+  const nsTime now = nsTime::Now();
+
+  PendingFrame& frame = m_PendingFrames.ExpandAndGetRef();
+  frame.m_uiFrameIndex = uiFrameIndex;
+  frame.m_StartTime = m_LastFrameEndTime;
+  frame.m_EndTime = now;
+  m_LastFrameEndTime = now;
+
+  const nsTime interval = nsTime::MakeFromSeconds(g_fCollectIntervalSeconds);
+  if (now - m_LastCollectionTime >= interval)
+  {
+    m_LastCollectionTime = now;
+    Collect(now - interval);
+  }
+
+  m_Data.SetCaptureOverhead(m_Data.GetCaptureOverhead() + (nsTime::Now() - now));
+}
+
+void nsJvdProfilingCapture::Finish(nsJvdProfilingData& out_data)
+{
+  const nsTime now = nsTime::Now();
+  Collect(now);
+  m_Data.SetCaptureOverhead(m_Data.GetCaptureOverhead() + (nsTime::Now() - now));
+
+  out_data = std::move(m_Data);
+  m_Data.Clear();
+  m_PendingFrames.Clear();
+  m_ThreadIndices.Clear();
+}
+
+void nsJvdProfilingCapture::DropFramesBefore(nsUInt64 uiFrameIndex)
+{
+  // pending frames still have to be collected, their windows are needed to place the scopes of later frames
+  m_uiFirstKeptFrame = nsMath::Max(m_uiFirstKeptFrame, uiFrameIndex);
+  m_Data.RemoveFramesBefore(m_uiFirstKeptFrame);
+}
+
+void nsJvdProfilingCapture::Collect(nsTime finalizeBefore)
+{
+  nsUInt32 uiFinalFrames = 0;
+  while (uiFinalFrames < m_PendingFrames.GetCount() && m_PendingFrames[uiFinalFrames].m_EndTime <= finalizeBefore)
+  {
+    ++uiFinalFrames;
+  }
+
+  if (uiFinalFrames == 0)
+    return;
+
+  NS_PROFILE_SCOPE("JVD Collect Profiling Scopes");
+
+  const nsArrayPtr<const PendingFrame> finalFrames = m_PendingFrames.GetArrayPtr().GetSubArray(0, uiFinalFrames);
+  const nsUInt32 uiFirstProfile = m_Data.GetFrames().GetCount();
+
+  for (const PendingFrame& pending : finalFrames)
+  {
+    nsJvdFrameProfile& profile = m_Data.AddFrame(pending.m_uiFrameIndex);
+    profile.m_StartTime = pending.m_StartTime - m_RecordingStartTime;
+    profile.m_Duration = pending.m_EndTime - pending.m_StartTime;
+  }
+
+  nsProfilingSystem::Capture(m_Snapshot);
+
+  const nsTime windowStart = finalFrames[0].m_StartTime;
+  const nsTime windowEnd = finalFrames[uiFinalFrames - 1].m_EndTime;
+
+  for (const nsProfilingSystem::CPUScopesBufferFlat& buffer : m_Snapshot.m_AllEventBuffers)
+  {
+    nsUInt16 uiThreadIndex = 0xFFFF;
+
+    for (const nsProfilingSystem::CPUScope& scope : buffer.m_Data)
+    {
+      if (scope.m_BeginTime < windowStart || scope.m_BeginTime >= windowEnd || scope.m_EndTime - scope.m_BeginTime < m_MinScopeDuration)
+        continue;
+
+      // the frame windows are contiguous, find the last one that starts before the scope
+      nsUInt32 uiLow = 0;
+      nsUInt32 uiHigh = uiFinalFrames;
+      while (uiHigh - uiLow > 1)
+      {
+        const nsUInt32 uiMid = (uiLow + uiHigh) / 2;
+        if (finalFrames[uiMid].m_StartTime <= scope.m_BeginTime)
+          uiLow = uiMid;
+        else
+          uiHigh = uiMid;
+      }
+
+      if (uiThreadIndex == 0xFFFF)
+      {
+        uiThreadIndex = GetThreadIndex(buffer.m_uiThreadId);
+      }
+
+      nsJvdFrameProfile& profile = m_Data.GetFrames()[uiFirstProfile + uiLow];
+      nsJvdProfileScope& record = profile.m_Scopes.ExpandAndGetRef();
+      // the name buffer is fixed size, a string view of the array would include the bytes after the terminator
+      record.m_uiNameIndex = m_Data.InternScopeName(static_cast<const char*>(scope.m_szName));
+      record.m_uiThreadIndex = uiThreadIndex;
+      record.m_BeginTime = scope.m_BeginTime - finalFrames[uiLow].m_StartTime;
+      record.m_Duration = scope.m_EndTime - scope.m_BeginTime;
+    }
+  }
+
+  // the profiler stores scopes when they end, sort parents before their children to compute the nesting
+  nsDynamicArray<nsTime> openScopeEnds;
+  for (nsUInt32 i = uiFirstProfile; i < m_Data.GetFrames().GetCount(); ++i)
+  {
+    nsDynamicArray<nsJvdProfileScope>& scopes = m_Data.GetFrames()[i].m_Scopes;
+    scopes.Sort([](const nsJvdProfileScope& a, const nsJvdProfileScope& b)
+      {
+        if (a.m_uiThreadIndex != b.m_uiThreadIndex)
+          return a.m_uiThreadIndex < b.m_uiThreadIndex;
+        if (a.m_BeginTime != b.m_BeginTime)
+          return a.m_BeginTime < b.m_BeginTime;
+        return a.m_Duration > b.m_Duration; });
+
+    openScopeEnds.Clear();
+    for (nsUInt32 s = 0; s < scopes.GetCount(); ++s)
+    {
+      nsJvdProfileScope& scope = scopes[s];
+      if (s > 0 && scopes[s - 1].m_uiThreadIndex != scope.m_uiThreadIndex)
+      {
+        openScopeEnds.Clear();
+      }
+
+      while (!openScopeEnds.IsEmpty() && openScopeEnds.PeekBack() <= scope.m_BeginTime)
+      {
+        openScopeEnds.PopBack();
+      }
+
+      scope.m_uiDepth = static_cast<nsUInt16>(nsMath::Min(openScopeEnds.GetCount(), 0xFFFFu));
+      openScopeEnds.PushBack(scope.m_BeginTime + scope.m_Duration);
+    }
+  }
+
+  m_PendingFrames.RemoveAtAndCopy(0, uiFinalFrames);
+  m_Snapshot.Clear();
+  m_Data.RemoveFramesBefore(m_uiFirstKeptFrame);
+
+  nsStats::SetStat("JVD/Recorder/Profiling Overhead", m_Data.GetCaptureOverhead());
+  nsStats::SetStat("JVD/Recorder/Profiled Frames", m_Data.GetFrames().GetCount());
+}
+
+nsUInt16 nsJvdProfilingCapture::GetThreadIndex(nsUInt64 uiThreadId)
+{
+  nsUInt16 uiIndex = 0;
+  if (m_ThreadIndices.TryGetValue(uiThreadId, uiIndex))
+    return uiIndex;
+
+  nsStringBuilder sName;
+  for (const nsProfilingSystem::ThreadInfo& info : m_Snapshot.m_ThreadInfos)
+  {
+    if (info.m_uiThreadId == uiThreadId)
+    {
+      sName = info.m_sName;
+      break;
+    }
+  }
+
+  if (sName.IsEmpty())
+  {
+    sName.SetFormat("Thread {0}", uiThreadId);
+  }
+
+  uiIndex = m_Data.InternThreadName(sName);
+  m_ThreadIndices.Insert(uiThreadId, uiIndex);
+  return uiIndex;
+}
+
+NS_STATICLINK_FILE(JVDSDK, Recording_JvdProfilingCapture);
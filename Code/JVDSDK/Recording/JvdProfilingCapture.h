@@ -0,0 +1,61 @@
+#pragma once
+
+#include <JVDSDK/Recording/JvdProfilingData.h>
+
+#include <Foundation/Profiling/Profiling.h>
+
+/// \brief Collects the CPU scopes of nsProfilingSystem for the frames of a recording.
+///
+/// Copying the profiler's per-thread buffers is far too expensive to do for every frame. Instead AddFrame() only
+/// remembers the wall-clock window of each frame, and the buffers are copied a few times per second. Every scope is
+/// assigned to the frame in which it began. Frames stay pending for one more collection, so that scopes that were still
+/// running during a collection are not lost.
+///
+/// Scopes are only recorded if the profiler keeps them, see the 'Profiling.DiscardThresholdMS' cvar.
+class NS_JVDSDK_DLL nsJvdProfilingCapture
+{
+  NS_DISALLOW_COPY_AND_ASSIGN(nsJvdProfilingCapture);
+
+public:
+  nsJvdProfilingCapture();
+  ~nsJvdProfilingCapture();
+
+  /// \brief Drops all collected data, the first frame starts now. Scopes shorter than minScopeDuration are skipped.
+  void Start(nsTime minScopeDuration);
+
+  /// \brief Ends the current frame. Call this right after the frame was captured.
+  void AddFrame(nsUInt64 uiFrameIndex);
+
+  /// \brief Collects the scopes of all pending frames and moves the data out.
+  void Finish(nsJvdProfilingData& out_data);
+
+  /// \brief Discards the profiles of frames that were removed from the recording.
+  void DropFramesBefore(nsUInt64 uiFrameIndex);
+
+  const nsJvdProfilingData& GetData() const { return m_Data; }
+
+  /// \brief Total time spent in AddFrame() and Finish().
+  nsTime GetOverhead() const { return m_Data.GetCaptureOverhead(); }
+
+private:
+  struct PendingFrame
+  {
+    nsUInt64 m_uiFrameIndex = 0;
+    nsTime m_StartTime;
+    nsTime m_EndTime;
+  };
+
+  void Collect(nsTime finalizeBefore);
+  nsUInt16 GetThreadIndex(nsUInt64 uiThreadId);
+
+  nsTime m_RecordingStartTime;
+  nsTime m_LastFrameEndTime;
+  nsTime m_LastCollectionTime;
+  nsTime m_MinScopeDuration;
+  nsUInt64 m_uiFirstKeptFrame = 0;
+
+  nsDynamicArray<PendingFrame> m_PendingFrames;
+  nsHashTable<nsUInt64, nsUInt16> m_ThreadIndices;
+  nsProfilingSystem::ProfilingData m_Snapshot;
+  nsJvdProfilingData m_Data;
+};
@@ -0,0 +1,95 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Recording/JvdProfilingData.h>
+
+void nsJvdProfilingData::Clear()
+{
+  m_ScopeNames.Clear();
+  m_ThreadNames.Clear();
+  m_ScopeNameLookup.Clear();
+  m_Frames.Clear();
+  m_CaptureOverhead = nsTime::MakeZero();
+}
+
+nsUInt32 nsJvdProfilingData::InternScopeName(nsStringView sName)
+{
+  nsUInt32 uiIndex = 0;
+  if (m_ScopeNameLookup.TryGetValue(sName, uiIndex))
+    return uiIndex;
+
+  uiIndex = m_ScopeNames.GetCount();
+  m_ScopeNames.PushBack(sName);
+  m_ScopeNameLookup.Insert(sName, uiIndex);
+  return uiIndex;
+}
+
+nsUInt16 nsJvdProfilingData::InternThreadName(nsStringView sName)
+{
+  // a handful of threads, not worth a lookup table
+  for (nsUInt32 i = 0; i < m_ThreadNames.GetCount(); ++i)
+  {
+    if (m_ThreadNames[i] == sName)
+      return static_cast<nsUInt16>(i);
+  }
+
+  NS_ASSERT_DEV(m_ThreadNames.GetCount() < 0xFFFF, "Too many profiled threads.");
+  m_ThreadNames.PushBack(sName);
+  return static_cast<nsUInt16>(m_ThreadNames.GetCount() - 1);
+}
+
+nsJvdFrameProfile& nsJvdProfilingData::AddFrame(nsUInt64 uiFrameIndex)
+{
+  NS_ASSERT_DEV(m_Frames.IsEmpty() || m_Frames.PeekBack().m_uiFrameIndex < uiFrameIndex, "Frame profiles have to be added in order.");
+
+  nsJvdFrameProfile& frame = m_Frames.ExpandAndGetRef();
+  frame.m_uiFrameIndex = uiFrameIndex;
+  return frame;
+}
+
+const nsJvdFrameProfile* nsJvdProfilingData::FindFrame(nsUInt64 uiFrameIndex) const
+{
+  nsUInt32 uiLow = 0;
+  nsUInt32 uiHigh = m_Frames.GetCount();
+
+  while (uiLow < uiHigh)
+  {
+    const nsUInt32 uiMid = (uiLow + uiHigh) / 2;
+    if (m_Frames[uiMid].m_uiFrameIndex < uiFrameIndex)
+      uiLow = uiMid + 1;
+    else
+      uiHigh = uiMid;
+  }
+
+  if (uiLow < m_Frames.GetCount() && m_Frames[uiLow].m_uiFrameIndex == uiFrameIndex)
+    return &m_Frames[uiLow];
+
+  return nullptr;
+}
+
+void nsJvdProfilingData::RemoveFramesBefore(nsUInt64 uiFrameIndex)
+{
+  nsUInt32 uiExpiredFrames = 0;
+  while (uiExpiredFrames < m_Frames.GetCount() && m_Frames[uiExpiredFrames].m_uiFrameIndex < uiFrameIndex)
+  {
+    ++uiExpiredFrames;
+  }
+
+  if (uiExpiredFrames > 0)
+  {
+    m_Frames.RemoveAtAndCopy(0, uiExpiredFrames);
+  }
+}
+
+nsUInt64 nsJvdProfilingData::GetHeapMemoryUsage() const
+{
+  nsUInt64 uiBytes = m_Frames.GetHeapMemoryUsage() + m_ScopeNames.GetHeapMemoryUsage() + m_ThreadNames.GetHeapMemoryUsage() + m_ScopeNameLookup.GetHeapMemoryUsage();
+
+  for (const nsJvdFrameProfile& frame : m_Frames)
+  {
+    uiBytes += frame.m_Scopes.GetHeapMemoryUsage();
+  }
+
+  return uiBytes;
+}
+
+NS_STATICLINK_FILE(JVDSDK, Recording_JvdProfilingData);
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <JVDSDK/JVDSDKDLL.h>
+
+#include <Foundation/Containers/DynamicArray.h>
+#include <Foundation/Containers/HashTable.h>
+#include <Foundation/Strings/String.h>
+#include <Foundation/Time/Time.h>
+
+/// \brief A CPU profiling scope that started while a frame was captured.
+struct NS_JVDSDK_DLL nsJvdProfileScope
+{
+  nsUInt32 m_uiNameIndex = 0;   ///< Index into nsJvdProfilingData::GetScopeNames().
+  nsUInt16 m_uiThreadIndex = 0; ///< Index into nsJvdProfilingData::GetThreadNames().
+  nsUInt16 m_uiDepth = 0;       ///< Nesting level within its thread, scopes that started before the frame are not counted.
+  nsTime m_BeginTime;           ///< Relative to nsJvdFrameProfile::m_StartTime.
+  nsTime m_Duration;
+};
+
+/// \brief The profiling scopes of one captured frame.
+///
+/// A frame covers the wall-clock time since the previous captured frame. Scopes are sorted by thread, then by begin time.
+struct NS_JVDSDK_DLL nsJvdFrameProfile
+{
+  nsUInt64 m_uiFrameIndex = 0;
+  nsTime m_StartTime; ///< Wall-clock time since the recording started.
+  nsTime m_Duration;
+  nsDynamicArray<nsJvdProfileScope> m_Scopes;
+};
+
+/// \brief CPU profiling side-channel of a clip, see nsJvdRecordingSettings::m_bCaptureProfiling.
+///
+/// Scope and thread names are interned into tables, so that every scope only stores indices. On disk the begin times of a
+/// thread are delta-encoded.
+class NS_JVDSDK_DLL nsJvdProfilingData
+{
+public:
+  void Clear();
+  bool IsEmpty() const { return m_Frames.IsEmpty(); }
+
+  /// \brief Returns the index of the name, adds it to the table if it is new.
+  nsUInt32 InternScopeName(nsStringView sName);
+  nsUInt16 InternThreadName(nsStringView sName);
+
+  const nsDynamicArray<nsString>& GetScopeNames() const { return m_ScopeNames; }
+  const nsDynamicArray<nsString>& GetThreadNames() const { return m_ThreadNames; }
+
+  /// \brief Frames have to be added in order of their frame index.
+  nsJvdFrameProfile& AddFrame(nsUInt64 uiFrameIndex);
+
+  const nsDynamicArray<nsJvdFrameProfile>& GetFrames() const { return m_Frames; }
+  nsDynamicArray<nsJvdFrameProfile>& GetFrames() { return m_Frames; }
+
+  /// \brief Returns nullptr if no profile was captured for the frame.
+  const nsJvdFrameProfile* FindFrame(nsUInt64 uiFrameIndex) const;
+
+  /// \brief Drops the profiles of frames that are not part of the clip anymore. The name tables are kept.
+  void RemoveFramesBefore(nsUInt64 uiFrameIndex);
+
+  /// \brief Time the recorder spent collecting the scopes, on the thread that captured the frames.
+  nsTime GetCaptureOverhead() const { return m_CaptureOverhead; }
+  void SetCaptureOverhead(nsTime overhead) { m_CaptureOverhead = overhead; }
+
+  nsUInt64 GetHeapMemoryUsage() const;
+
+private:
+  nsDynamicArray<nsString> m_ScopeNames;
+  nsDynamicArray<nsString> m_ThreadNames;
+  nsHashTable<nsString, nsUInt32> m_ScopeNameLookup;
+  nsDynamicArray<nsJvdFrameProfile> m_Frames;
+  nsTime m_CaptureOverhead;
+};
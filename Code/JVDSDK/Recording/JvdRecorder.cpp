@@ -1,17 +1,22 @@
 #include <JVDSDK/JVDSDKPCH.h>
 
+#include <JVDSDK/Recording/JvdBodyCapture.h>
 #include <JVDSDK/Recording/JvdRecorder.h>
 
 #include <JVDSDK/Serialization/JvdFileIO.h>
+#include <JVDSDK/Serialization/JvdStreamSerializer.h>
 
+#include <Foundation/Containers/HashSet.h>
+#include <Foundation/IO/MemoryStream.h>
 #include <Foundation/Strings/StringBuilder.h>
 
 #include <Jolt/Physics/PhysicsSystem.h>
 
-using namespace nsJvdConversion;
-
 namespace
 {
+  constexpr nsUInt32 g_uiFramesPerCompactedBlock = 64;
+  constexpr nsUInt32 g_uiMaxRateShift = 4; ///< Compacted history is thinned down to 1/16 of the recorded frame rate.
+
   nsTime MakeRelative(nsTime baseTime, nsTime timestamp)
   {
     if (baseTime.IsZero())
@@ -24,11 +29,73 @@ namespace
     return relative;
   }
 
-  nsUInt64 MakeBodyKey(const JPH::BodyID& bodyId)
+  /// Decodes frames copied out of an nsJvdFrameRing and rebases them and their bookmarks, so that the clip starts at frame 0 and time 0.
+  nsResult DecodeFlightFrames(nsArrayPtr<const nsUInt8> data, nsUInt32 uiFrameCount, nsArrayPtr<const nsJvdBookmark> bookmarks, nsJvdClip& inout_clip)
   {
-    return static_cast<nsUInt64>(bodyId.GetIndexAndSequenceNumber());
+    nsRawMemoryStreamReader reader(data.GetPtr(), data.GetCount());
+    nsUInt64 uiFirstFrameIndex = 0;
+    nsTime firstTimestamp = nsTime::MakeZero();
+
+    for (nsUInt32 i = 0; i < uiFrameCount; ++i)
+    {
+      nsJvdFrame frame;
+      if (nsJvdSerialization::ReadFrame(reader, frame).Failed())
+        return NS_FAILURE;
+
+      if (i == 0)
+      {
+        uiFirstFrameIndex = frame.m_uiFrameIndex;
+        firstTimestamp = frame.m_Timestamp;
+      }
+
+      frame.m_uiFrameIndex = i;
+      frame.m_Timestamp -= firstTimestamp;
+      inout_clip.AddFrame(std::move(frame));
+    }
+
+    for (nsJvdBookmark bookmark : bookmarks)
+    {
+      if (bookmark.m_uiFrameIndex < uiFirstFrameIndex)
+        continue;
+
+      bookmark.m_uiFrameIndex -= uiFirstFrameIndex;
+      bookmark.m_Timestamp -= firstTimestamp;
+      inout_clip.AddBookmark(bookmark);
+    }
+
+    return NS_SUCCESS;
   }
-}
+
+  class nsJvdFlightRecorderDumpTask final : public nsTask
+  {
+  public:
+    nsString m_sFilePath;
+    nsJvdClipMetadata m_Metadata;
+    nsDynamicArray<nsJvdBodyMetadata> m_Bodies;
+    nsDynamicArray<nsUInt8> m_EncodedFrames;
+    nsDynamicArray<nsJvdBookmark> m_Bookmarks;
+    nsUInt32 m_uiFrameCount = 0;
+
+  private:
+    virtual void Execute() override
+    {
+      nsJvdClip clip;
+      clip.SetMetadata(m_Metadata);
+      clip.SetBodyMetadata(m_Bodies);
+
+      if (DecodeFlightFrames(m_EncodedFrames, m_uiFrameCount, m_Bookmarks, clip).Failed())
+      {
+        nsLog::Error("Failed to decode flight recording for '{0}'.", m_sFilePath);
+        return;
+      }
+
+      if (nsJvdSerialization::SaveClipToFile(m_sFilePath, clip).Succeeded())
+      {
+        nsLog::Info("Flight recording saved to '{0}' ({1} frames).", m_sFilePath, m_uiFrameCount);
+      }
+    }
+  };
+} // namespace
 
 nsJvdRecorder::nsJvdRecorder()
 {
@@ -52,12 +119,50 @@ void nsJvdRecorder::StartRecording(const nsJvdRecordingSettings& settings, const
 
   EnsureClipMetadata();
   m_Metadata.m_SampleInterval = m_Settings.m_TargetFrameInterval;
+  m_Metadata.m_CustomChannels.Clear();
+  if (m_Settings.m_bRecordCustomProperties)
+  {
+    m_Metadata.m_CustomChannels = m_Settings.m_CustomChannels;
+  }
 
   m_Clip.Clear();
   m_Clip.SetMetadata(m_Metadata);
   m_BodyMetadata.Clear();
+  m_StagedCustomValues.Clear();
+  m_Bookmarks.Clear();
+  m_AnomalyDetector.Configure(m_Settings.m_AnomalyDetection);
+  m_AnomalyDetector.Reset();
+
+  m_uiLiveFrameBytes = 0;
+  m_uiCompactedBytes = 0;
+  m_CompactedBlocks.Clear();
+  m_MemoryStats = nsJvdRecorderMemoryStats();
+  m_bMaximumCaptureTimeReached = false;
+  m_bFullFidelityWindowExceeded = false;
+
+  m_bFlightRecorder = m_Settings.m_FlightRecorderWindow.IsPositive();
+  m_bCaptureProfiling = m_Settings.m_bCaptureProfiling && !m_bFlightRecorder;
+  m_ProfilingCapture.Start(m_Settings.m_MinProfilingScopeDuration);
+
+  if (m_bFlightRecorder)
+  {
+    // without a target interval every frame is kept, so the frame count can only be bounded by the buffer size
+    nsUInt32 uiMaxFrames = m_Settings.m_uiFlightRecorderBufferSize / 256;
+    if (m_Settings.m_TargetFrameInterval.IsPositive())
+    {
+      // frames are sampled at most every half interval, see AppendFrameInternal()
+      uiMaxFrames = static_cast<nsUInt32>(2.0 * m_Settings.m_FlightRecorderWindow.GetSeconds() / m_Settings.m_TargetFrameInterval.GetSeconds()) + 2;
+    }
+
+    m_FlightRing.Initialize(m_Settings.m_uiFlightRecorderBufferSize, uiMaxFrames);
+  }
+  else
+  {
+    m_FlightRing.Deallocate();
+  }
 
   m_bRecording = true;
+  m_uiNumRecordedFrames = 0;
   m_StartTime = nsTime::MakeZero();
   m_LastSampleTime = nsTime::MakeZero();
 }
@@ -70,9 +175,45 @@ nsResult nsJvdRecorder::StopRecording(nsJvdClip& out_clip)
     return NS_FAILURE;
 
   m_bRecording = false;
+
+  nsResult result = NS_SUCCESS;
+  if (m_bFlightRecorder)
+  {
+    nsDynamicArray<nsUInt8> encodedFrames;
+    m_FlightRing.CopyFrames(encodedFrames);
+    result = DecodeFlightFrames(encodedFrames, m_FlightRing.GetFrameCount(), m_Bookmarks, m_Clip);
+    m_FlightRing.Clear();
+  }
+  else
+  {
+    m_Clip.SetBookmarks(m_Bookmarks);
+
+    if (m_bCaptureProfiling)
+    {
+      nsJvdProfilingData profiling;
+      m_ProfilingCapture.Finish(profiling);
+      m_Clip.SetProfiling(std::move(profiling));
+    }
+
+    if (RestoreCompactedFrames(m_Clip).Failed())
+    {
+      nsLog::Error("Failed to decode the compacted history of the recording, only the last {0} frames are kept.", m_Clip.GetFrames().GetCount());
+      result = NS_FAILURE;
+    }
+  }
+
+  m_Bookmarks.Clear();
+  m_CompactedBlocks.Clear();
+  m_uiCompactedBytes = 0;
+  m_uiLiveFrameBytes = 0;
+
+  nsDynamicArray<nsJvdBodyMetadata> bodies;
+  CollectBodyMetadata(bodies);
+  m_Clip.SetBodyMetadata(bodies);
+
   out_clip = std::move(m_Clip);
   m_Clip.Clear();
-  return NS_SUCCESS;
+  return result;
 }
 
 void nsJvdRecorder::CancelRecording()
@@ -81,6 +222,13 @@ void nsJvdRecorder::CancelRecording()
   m_bRecording = false;
   m_Clip.Clear();
   m_BodyMetadata.Clear();
+  m_StagedCustomValues.Clear();
+  m_Bookmarks.Clear();
+  m_ProfilingCapture.Start(nsTime::MakeZero());
+  m_FlightRing.Clear();
+  m_CompactedBlocks.Clear();
+  m_uiCompactedBytes = 0;
+  m_uiLiveFrameBytes = 0;
 }
 
 void nsJvdRecorder::SetMetadata(const nsJvdClipMetadata& metadata)
@@ -94,10 +242,63 @@ void nsJvdRecorder::SetMetadata(const nsJvdClipMetadata& metadata)
 void nsJvdRecorder::AppendFrame(nsTime timestamp, nsArrayPtr<const nsJvdBodyState> states)
 {
   NS_LOCK(m_Mutex);
+  AppendStates(timestamp, states);
+}
+
+void nsJvdRecorder::AppendStates(nsTime timestamp, nsArrayPtr<const nsJvdBodyState> states)
+{
+  if (m_bFlightRecorder)
+  {
+    ResetFlightScratchFrame(timestamp);
+    m_FlightScratchFrame.m_Bodies.PushBackRange(states);
+    AppendFrameInternal(m_FlightScratchFrame);
+    return;
+  }
+
+  nsJvdFrame frame;
+  frame.m_Timestamp = timestamp;
+  frame.m_Bodies.PushBackRange(states);
+  AppendFrameInternal(frame);
+}
+
+void nsJvdRecorder::AppendFrame(const nsJvdFrame& frame)
+{
+  NS_LOCK(m_Mutex);
+
+  if (m_bFlightRecorder)
+  {
+    ResetFlightScratchFrame(frame.m_Timestamp);
+    m_FlightScratchFrame.m_Bodies = frame.m_Bodies;
+    m_FlightScratchFrame.m_CustomChannels = frame.m_CustomChannels;
+    AppendFrameInternal(m_FlightScratchFrame);
+    return;
+  }
+
+  nsJvdFrame copy = frame;
+  AppendFrameInternal(copy);
+}
+
+void nsJvdRecorder::ResetFlightScratchFrame(nsTime timestamp)
+{
+  m_FlightScratchFrame.m_uiFrameIndex = 0;
+  m_FlightScratchFrame.m_Timestamp = timestamp;
+  m_FlightScratchFrame.m_Bodies.Clear();
+
+  for (nsJvdCustomChannelColumn& column : m_FlightScratchFrame.m_CustomChannels)
+  {
+    // empty columns are recreated on demand, Clear() keeps the allocation around
+    column.m_Values.Clear();
+    column.m_PresenceMask.Clear();
+  }
+}
 
+void nsJvdRecorder::AppendFrameInternal(nsJvdFrame& frame)
+{
   if (!m_bRecording)
     return;
 
+  const nsTime timestamp = frame.m_Timestamp;
+
   if (m_StartTime.IsZero())
   {
     m_StartTime = timestamp;
@@ -106,147 +307,506 @@ void nsJvdRecorder::AppendFrame(nsTime timestamp, nsArrayPtr<const nsJvdBodyStat
 
   const nsTime relative = MakeRelative(m_StartTime, timestamp);
 
-  if (m_Settings.m_MaximumCaptureTime.IsPositive() && relative > m_Settings.m_MaximumCaptureTime)
+  if (!m_bFlightRecorder && m_Settings.m_MaximumCaptureTime.IsPositive() && relative > m_Settings.m_MaximumCaptureTime)
   {
-    nsLog::Warning("nsJvdRecorder::AppendFrame() - Maximum capture time reached. Frame discarded.");
+    if (!m_bMaximumCaptureTimeReached)
+    {
+      nsLog::Warning("nsJvdRecorder::AppendFrame() - Maximum capture time reached. Further frames are discarded.");
+      m_bMaximumCaptureTimeReached = true;
+    }
+
+    m_StagedCustomValues.Clear();
     return;
   }
 
-  if (!m_Clip.IsEmpty() && m_Settings.m_TargetFrameInterval.IsPositive())
+  if (m_uiNumRecordedFrames > 0 && m_Settings.m_TargetFrameInterval.IsPositive())
   {
     const nsTime delta = relative - m_LastSampleTime;
     if (delta < m_Settings.m_TargetFrameInterval * 0.5)
     {
+      m_StagedCustomValues.Clear();
       return;
     }
   }
 
-  nsJvdFrame frame;
-  frame.m_uiFrameIndex = m_Clip.GetFrames().GetCount();
+  frame.m_uiFrameIndex = m_uiNumRecordedFrames;
   frame.m_Timestamp = relative;
-  frame.m_Bodies.PushBackRange(states);
 
-  m_Clip.AddFrame(std::move(frame));
+  m_Clip.AssignBodyIndices(frame);
+
+  if (!m_Settings.m_bRecordCustomProperties)
+  {
+    frame.m_CustomChannels.Clear();
+  }
+  else if (!m_StagedCustomValues.IsEmpty())
+  {
+    ApplyStagedCustomValues(frame);
+  }
+
+  if (m_bFlightRecorder && m_FlightRing.PushFrame(frame).Failed())
+  {
+    nsLog::Warning("nsJvdRecorder::AppendFrame() - Frame does not fit into the flight recorder buffer. Frame discarded.");
+    return;
+  }
+
+  if (m_Settings.m_bDetectAnomalies)
+  {
+    m_AnomalyDetector.ProcessFrame(frame, m_Bookmarks);
+  }
+
+  if (m_bFlightRecorder)
+  {
+    const nsTime oldestTimestamp = relative - m_Settings.m_FlightRecorderWindow;
+    m_FlightRing.DropFramesBefore(oldestTimestamp);
+
+    nsUInt32 uiExpiredBookmarks = 0;
+    while (uiExpiredBookmarks < m_Bookmarks.GetCount() && m_Bookmarks[uiExpiredBookmarks].m_Timestamp < oldestTimestamp)
+    {
+      ++uiExpiredBookmarks;
+    }
+
+    if (uiExpiredBookmarks > 0)
+    {
+      m_Bookmarks.RemoveAtAndCopy(0, uiExpiredBookmarks);
+    }
+  }
+  else
+  {
+    m_Clip.AddFrame(std::move(frame));
+    m_uiLiveFrameBytes += m_Clip.GetFrames().PeekBack().GetHeapMemoryUsage();
+
+    if (m_bCaptureProfiling)
+    {
+      m_ProfilingCapture.AddFrame(m_Clip.GetFrames().PeekBack().m_uiFrameIndex);
+    }
+
+    if (m_Settings.m_uiMemoryBudget > 0)
+    {
+      EnforceMemoryBudget(relative);
+    }
+  }
+
+  ++m_uiNumRecordedFrames;
   m_LastSampleTime = relative;
 }
 
-nsResult nsJvdRecorder::CapturePhysicsSystem(const JPH::PhysicsSystem& physicsSystem, nsTime timestamp)
+nsJvdRecorderMemoryStats nsJvdRecorder::GetMemoryStats() const
 {
-  const JPH::BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
-  JPH::BodyIDVector bodyIds;
-  physicsSystem.GetBodies(bodyIds);
+  NS_LOCK(m_Mutex);
 
-  return CaptureBodies(bodyInterface, nsArrayPtr<const JPH::BodyID>(bodyIds.data(), static_cast<nsUInt32>(bodyIds.size())), timestamp);
+  nsJvdRecorderMemoryStats stats = m_MemoryStats;
+  stats.m_uiMemoryUsage = GetMemoryUsage();
+  stats.m_uiLiveFrames = m_Clip.GetFrames().GetCount();
+  stats.m_uiCompactedBytes = m_uiCompactedBytes;
+
+  for (const CompactedBlock& block : m_CompactedBlocks)
+  {
+    stats.m_uiCompactedFrames += block.m_uiFrameCount;
+  }
+
+  return stats;
 }
 
-nsResult nsJvdRecorder::CaptureBodies(const JPH::BodyInterface& bodyInterface, nsArrayPtr<const JPH::BodyID> bodyIds, nsTime timestamp)
+nsTime nsJvdRecorder::GetProfilingOverhead() const
 {
-  nsHybridArray<nsJvdBodyState, 64> states;
-  states.Reserve(bodyIds.GetCount());
+  NS_LOCK(m_Mutex);
+  return m_ProfilingCapture.GetOverhead();
+}
 
-  for (const JPH::BodyID& bodyId : bodyIds)
+nsUInt64 nsJvdRecorder::GetMemoryUsage() const
+{
+  return m_Clip.GetFrames().GetHeapMemoryUsage() + m_uiLiveFrameBytes + m_Clip.GetTimelineSummary().GetHeapMemoryUsage() + m_uiCompactedBytes;
+}
+
+void nsJvdRecorder::EnforceMemoryBudget(nsTime now)
+{
+  const nsUInt64 uiBudget = m_Settings.m_uiMemoryBudget;
+  if (GetMemoryUsage() <= uiBudget)
+    return;
+
+  // compact a bit more than necessary, so that this does not run again for the next frame
+  const nsUInt64 uiTargetUsage = uiBudget - uiBudget / 8;
+
+  // compress the history outside of the full fidelity window
+  const nsDynamicArray<nsJvdFrame>& liveFrames = m_Clip.GetFrames();
+  const nsTime windowStart = now - m_Settings.m_FullFidelityWindow;
+
+  nsUInt32 uiOldFrames = 0;
+  while (uiOldFrames < liveFrames.GetCount() && liveFrames[uiOldFrames].m_Timestamp < windowStart)
   {
-    if (bodyId.IsInvalid())
-      continue;
+    ++uiOldFrames;
+  }
 
-    const nsUInt64 uiBodyKey = MakeBodyKey(bodyId);
+  CompactLiveFrames(uiOldFrames);
 
-    const bool bIsActive = bodyInterface.IsActive(bodyId);
-    if (!ShouldCaptureBody(uiBodyKey, !bIsActive))
-      continue;
+  // halve the frame rate of the compressed history, the oldest history first
+  for (nsUInt32 uiRateShift = 0; uiRateShift < g_uiMaxRateShift && GetMemoryUsage() > uiTargetUsage; ++uiRateShift)
+  {
+    if (ThinCompactedBlocks(uiRateShift, uiTargetUsage).Failed())
+    {
+      nsLog::Error("nsJvdRecorder: Failed to thin the compacted history.");
+      break;
+    }
+  }
+
+  while (GetMemoryUsage() > uiTargetUsage && !m_CompactedBlocks.IsEmpty())
+  {
+    DropCompactedBlock();
+  }
+
+  if (GetMemoryUsage() <= uiBudget)
+    return;
+
+  // the full fidelity window itself does not fit, drop its oldest frames but keep the newest one
+  if (!m_bFullFidelityWindowExceeded)
+  {
+    nsLog::Warning("nsJvdRecorder: The memory budget of {0} bytes does not fit the full fidelity window, recent frames are dropped.", uiBudget);
+    m_bFullFidelityWindowExceeded = true;
+  }
+
+  nsUInt64 uiUsage = GetMemoryUsage();
+  nsUInt32 uiDropFrames = 0;
+  while (uiDropFrames + 1 < liveFrames.GetCount() && uiUsage > uiTargetUsage)
+  {
+    const nsUInt64 uiFrameBytes = liveFrames[uiDropFrames].GetHeapMemoryUsage();
+    uiUsage -= uiFrameBytes;
+    m_uiLiveFrameBytes -= uiFrameBytes;
+    ++uiDropFrames;
+  }
+
+  if (uiDropFrames > 0)
+  {
+    m_Clip.GetFrames().RemoveAtAndCopy(0, uiDropFrames);
+    m_Clip.UpdateTimelineSummary();
+    m_MemoryStats.m_uiDroppedFrames += uiDropFrames;
+    DropBookmarksBefore(liveFrames[0].m_uiFrameIndex);
+    m_ProfilingCapture.DropFramesBefore(liveFrames[0].m_uiFrameIndex);
+  }
+}
 
-    UpdateBodyMetadata(bodyInterface, bodyId);
+void nsJvdRecorder::CompactLiveFrames(nsUInt32 uiFrameCount)
+{
+  nsDynamicArray<nsJvdFrame>& liveFrames = m_Clip.GetFrames();
 
-    nsJvdBodyState state;
-    state.m_uiBodyId = uiBodyKey;
-    state.m_vPosition = ToVec3(bodyInterface.GetPosition(bodyId));
-    state.m_qRotation = ToQuat(bodyInterface.GetRotation(bodyId));
-    state.m_vScale.Set(1.0f);
+  nsUInt32 uiCompacted = 0;
+  while (uiCompacted < uiFrameCount)
+  {
+    // the last block may be short, ThinCompactedBlocks() merges it with its neighbor
+    const nsUInt32 uiBlockFrames = nsMath::Min(uiFrameCount - uiCompacted, g_uiFramesPerCompactedBlock);
 
-    if (m_Settings.m_bRecordVelocities)
+    CompactedBlock block;
+    if (EncodeCompactedBlock(liveFrames.GetArrayPtr().GetSubArray(uiCompacted, uiBlockFrames), 0, block).Failed())
     {
-      state.m_vLinearVelocity = ToVec3(bodyInterface.GetLinearVelocity(bodyId));
-      state.m_vAngularVelocity = ToVec3(bodyInterface.GetAngularVelocity(bodyId));
+      nsLog::Error("nsJvdRecorder: Failed to compact the recorded history.");
+      break;
     }
 
-    state.m_fFriction = bodyInterface.GetFriction(bodyId);
-    state.m_fRestitution = bodyInterface.GetRestitution(bodyId);
-    state.m_bIsSleeping = !bIsActive;
-    state.m_bWasTeleported = false;
+    m_CompactedBlocks.PushBack(std::move(block));
+    uiCompacted += uiBlockFrames;
+  }
+
+  if (uiCompacted == 0)
+    return;
 
-    states.PushBack(std::move(state));
+  for (nsUInt32 i = 0; i < uiCompacted; ++i)
+  {
+    m_uiLiveFrameBytes -= liveFrames[i].GetHeapMemoryUsage();
   }
 
-  if (states.IsEmpty())
-    return NS_SUCCESS;
+  liveFrames.RemoveAtAndCopy(0, uiCompacted);
+  m_Clip.UpdateTimelineSummary();
+}
+
+nsResult nsJvdRecorder::EncodeCompactedBlock(nsArrayPtr<nsJvdFrame> frames, nsUInt32 uiRateShift, CompactedBlock& out_block)
+{
+  // sleeping bodies don't move, their velocities are only solver noise
+  for (nsJvdFrame& frame : frames)
+  {
+    for (nsJvdBodyState& state : frame.m_Bodies)
+    {
+      if (state.m_bIsSleeping && (!state.m_vLinearVelocity.IsZero() || !state.m_vAngularVelocity.IsZero()))
+      {
+        state.m_vLinearVelocity.SetZero();
+        state.m_vAngularVelocity.SetZero();
+        ++m_MemoryStats.m_uiStrippedVelocities;
+      }
+    }
+  }
+
+  NS_SUCCEED_OR_RETURN(nsJvdSerialization::EncodeFrameBlock(frames, nsJvdClipWriteSettings(), out_block.m_Data));
+  out_block.m_Data.Compact();
+  out_block.m_uiFrameCount = frames.GetCount();
+  out_block.m_uiRateShift = uiRateShift;
+  out_block.m_uiLastFrameIndex = frames[frames.GetCount() - 1].m_uiFrameIndex;
+
+  m_uiCompactedBytes += out_block.m_Data.GetHeapMemoryUsage();
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdRecorder::DecodeCompactedBlock(const CompactedBlock& block, nsDynamicArray<nsJvdFrame>& out_frames) const
+{
+  nsRawMemoryStreamReader blockReader(block.m_Data);
+
+  nsUInt32 uiFrameCount = 0;
+  nsDynamicArray<nsUInt8> frameData;
+  NS_SUCCEED_OR_RETURN(nsJvdSerialization::ReadFrameBlock(blockReader, uiFrameCount, frameData));
+
+  if (uiFrameCount != block.m_uiFrameCount)
+    return NS_FAILURE;
+
+  nsRawMemoryStreamReader frameReader(frameData);
+  nsJvdBodyIndexMap blockBodies;
+
+  out_frames.Reserve(out_frames.GetCount() + uiFrameCount);
+  for (nsUInt32 i = 0; i < uiFrameCount; ++i)
+  {
+    NS_SUCCEED_OR_RETURN(nsJvdSerialization::ReadFrame(frameReader, out_frames.ExpandAndGetRef(), nsJvdSerialization::g_uiFormatVersion, &blockBodies));
+  }
 
-  AppendFrame(timestamp, states.GetArrayPtr());
   return NS_SUCCESS;
 }
 
-bool nsJvdRecorder::ShouldCaptureBody(nsUInt64 uiBodyId, bool bIsSleeping) const
+nsResult nsJvdRecorder::ThinCompactedBlocks(nsUInt32 uiRateShift, nsUInt64 uiTargetUsage)
 {
-  if (!m_Settings.m_IncludedBodies.IsEmpty())
+  // bookmarked frames are kept, like the decimate command of the jvd tool does
+  nsHashSet<nsUInt64> bookmarkedFrames;
+  for (const nsJvdBookmark& bookmark : m_Bookmarks)
   {
-    bool bFound = false;
-    for (nsUInt64 includeId : m_Settings.m_IncludedBodies)
+    bookmarkedFrames.Insert(bookmark.m_uiFrameIndex);
+  }
+
+  nsDynamicArray<nsJvdFrame> frames;
+
+  for (nsUInt32 uiBlock = 0; uiBlock < m_CompactedBlocks.GetCount() && GetMemoryUsage() > uiTargetUsage; ++uiBlock)
+  {
+    if (m_CompactedBlocks[uiBlock].m_uiRateShift != uiRateShift)
+      continue;
+
+    // thinned blocks are merged with their neighbor, so that the blocks don't get too small to compress well
+    const nsUInt32 uiMergedBlocks = (uiBlock + 1 < m_CompactedBlocks.GetCount() && m_CompactedBlocks[uiBlock + 1].m_uiRateShift == uiRateShift) ? 2 : 1;
+
+    frames.Clear();
+    for (nsUInt32 i = 0; i < uiMergedBlocks; ++i)
+    {
+      NS_SUCCEED_OR_RETURN(DecodeCompactedBlock(m_CompactedBlocks[uiBlock + i], frames));
+    }
+
+    nsUInt32 uiKeptFrames = 0;
+    for (nsUInt32 i = 0; i < frames.GetCount(); ++i)
     {
-      if (includeId == uiBodyId)
+      if (i % 2 == 0 || bookmarkedFrames.Contains(frames[i].m_uiFrameIndex))
       {
-        bFound = true;
-        break;
+        if (uiKeptFrames != i)
+        {
+          frames[uiKeptFrames] = std::move(frames[i]);
+        }
+
+        ++uiKeptFrames;
       }
     }
 
-    if (!bFound)
-      return false;
+    m_MemoryStats.m_uiThinnedFrames += frames.GetCount() - uiKeptFrames;
+    frames.SetCount(uiKeptFrames);
+
+    CompactedBlock thinned;
+    NS_SUCCEED_OR_RETURN(EncodeCompactedBlock(frames, uiRateShift + 1, thinned));
+
+    for (nsUInt32 i = 0; i < uiMergedBlocks; ++i)
+    {
+      m_uiCompactedBytes -= m_CompactedBlocks[uiBlock + i].m_Data.GetHeapMemoryUsage();
+    }
+
+    m_CompactedBlocks[uiBlock] = std::move(thinned);
+    m_CompactedBlocks.RemoveAtAndCopy(uiBlock + 1, uiMergedBlocks - 1);
+  }
+
+  return NS_SUCCESS;
+}
+
+void nsJvdRecorder::DropCompactedBlock()
+{
+  const CompactedBlock& block = m_CompactedBlocks[0];
+  m_MemoryStats.m_uiDroppedFrames += block.m_uiFrameCount;
+  m_uiCompactedBytes -= block.m_Data.GetHeapMemoryUsage();
+
+  DropBookmarksBefore(block.m_uiLastFrameIndex + 1);
+  m_ProfilingCapture.DropFramesBefore(block.m_uiLastFrameIndex + 1);
+  m_CompactedBlocks.RemoveAtAndCopy(0);
+}
+
+void nsJvdRecorder::DropBookmarksBefore(nsUInt64 uiFrameIndex)
+{
+  nsUInt32 uiExpiredBookmarks = 0;
+  while (uiExpiredBookmarks < m_Bookmarks.GetCount() && m_Bookmarks[uiExpiredBookmarks].m_uiFrameIndex < uiFrameIndex)
+  {
+    ++uiExpiredBookmarks;
+  }
+
+  if (uiExpiredBookmarks > 0)
+  {
+    m_Bookmarks.RemoveAtAndCopy(0, uiExpiredBookmarks);
+  }
+}
+
+nsResult nsJvdRecorder::RestoreCompactedFrames(nsJvdClip& inout_clip) const
+{
+  if (m_CompactedBlocks.IsEmpty())
+    return NS_SUCCESS;
+
+  nsDynamicArray<nsJvdFrame> frames;
+  for (const CompactedBlock& block : m_CompactedBlocks)
+  {
+    NS_SUCCEED_OR_RETURN(DecodeCompactedBlock(block, frames));
+  }
+
+  // the decoded states carry slots of their block table
+  for (nsJvdFrame& frame : frames)
+  {
+    inout_clip.AssignBodyIndices(frame);
   }
 
-  for (nsUInt64 excludeId : m_Settings.m_ExcludedBodies)
+  frames.Reserve(frames.GetCount() + inout_clip.GetFrames().GetCount());
+  for (nsJvdFrame& frame : inout_clip.GetFrames())
   {
-    if (excludeId == uiBodyId)
-      return false;
+    frames.PushBack(std::move(frame));
   }
 
-  if (!m_Settings.m_bCaptureSleepingBodies && bIsSleeping)
-    return false;
+  inout_clip.GetFrames().Swap(frames);
+  inout_clip.UpdateTimelineSummary();
+  return NS_SUCCESS;
+}
+
+void nsJvdRecorder::SetCustomValue(nsJvdCustomChannelIndex channel, nsUInt64 uiBodyId, float fValue)
+{
+  StageCustomValue(channel, nsJvdCustomChannelType::Float, uiBodyId, &fValue);
+}
 
-  return true;
+void nsJvdRecorder::SetCustomValue(nsJvdCustomChannelIndex channel, nsUInt64 uiBodyId, const nsVec3& vValue)
+{
+  StageCustomValue(channel, nsJvdCustomChannelType::Vec3, uiBodyId, &vValue);
 }
 
-void nsJvdRecorder::UpdateBodyMetadata(const JPH::BodyInterface& bodyInterface, const JPH::BodyID& bodyId)
+void nsJvdRecorder::SetCustomValue(nsJvdCustomChannelIndex channel, nsUInt64 uiBodyId, const nsQuat& qValue)
 {
-  const nsUInt64 uiBodyKey = MakeBodyKey(bodyId);
+  StageCustomValue(channel, nsJvdCustomChannelType::Quat, uiBodyId, &qValue);
+}
 
-  bool bExisted = false;
-  auto it = m_BodyMetadata.FindOrAdd(uiBodyKey, &bExisted);
-  nsJvdBodyMetadata& metadata = it.Value();
+void nsJvdRecorder::SetCustomValue(nsJvdCustomChannelIndex channel, nsUInt64 uiBodyId, nsInt32 iValue)
+{
+  StageCustomValue(channel, nsJvdCustomChannelType::Int, uiBodyId, &iValue);
+}
 
-  if (!bExisted)
+void nsJvdRecorder::SetCustomValue(nsJvdCustomChannelIndex channel, nsUInt64 uiBodyId, bool bValue)
+{
+  const nsUInt32 uiValue = bValue ? 1u : 0u;
+  StageCustomValue(channel, nsJvdCustomChannelType::Bool, uiBodyId, &uiValue);
+}
+
+void nsJvdRecorder::StageCustomValue(nsJvdCustomChannelIndex channel, nsJvdCustomChannelType::Enum type, nsUInt64 uiBodyId, const void* pValue)
+{
+  NS_LOCK(m_Mutex);
+
+  if (!m_bRecording || !m_Settings.m_bRecordCustomProperties)
+    return;
+
+  if (channel >= m_Settings.m_CustomChannels.GetCount() || m_Settings.m_CustomChannels[channel].m_Type != type)
+  {
+    NS_ASSERT_DEBUG(false, "Custom channel {0} is not declared or has a different type.", channel);
+    return;
+  }
+
+  StagedCustomValue& staged = m_StagedCustomValues.ExpandAndGetRef();
+  staged.m_uiBodyId = uiBodyId;
+  staged.m_uiChannel = channel;
+  nsMemoryUtils::RawByteCopy(staged.m_Words, pValue, sizeof(nsUInt32) * nsJvdCustomChannelType::GetComponentCount(type));
+}
+
+void nsJvdRecorder::ApplyStagedCustomValues(nsJvdFrame& frame)
+{
+  m_StagedBodyLookup.Clear();
+  m_StagedBodyLookup.Reserve(frame.m_Bodies.GetCount());
+  for (nsUInt32 i = 0; i < frame.m_Bodies.GetCount(); ++i)
+  {
+    m_StagedBodyLookup.Insert(frame.m_Bodies[i].m_uiBodyId, i);
+  }
+
+  for (const StagedCustomValue& staged : m_StagedCustomValues)
   {
-    metadata.Reset();
-    metadata.m_uiBodyId = uiBodyKey;
-  metadata.m_BodyGuid = nsUuid::MakeUuid();
+    nsUInt32 uiBodyIndex = 0;
+    if (!m_StagedBodyLookup.TryGetValue(staged.m_uiBodyId, uiBodyIndex))
+      continue;
 
-  nsStringBuilder tmp;
-  tmp.SetFormat("Body_{0}", uiBodyKey);
-    metadata.m_sName = tmp;
+    const nsJvdCustomChannelType::Enum type = m_Settings.m_CustomChannels[staged.m_uiChannel].m_Type;
+    frame.GetOrCreateCustomChannel(staged.m_uiChannel, type).SetRawValue(uiBodyIndex, staged.m_Words);
   }
 
-  metadata.m_uiSceneInstanceId = bodyInterface.GetUserData(bodyId);
+  m_StagedCustomValues.Clear();
+}
+
+nsResult nsJvdRecorder::CapturePhysicsSystem(const JPH::PhysicsSystem& physicsSystem, nsTime timestamp)
+{
+  const JPH::BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
+  JPH::BodyIDVector bodyIds;
+  physicsSystem.GetBodies(bodyIds);
 
-  nsStringBuilder layerName;
-  layerName.SetFormat("Layer_{0}", static_cast<nsUInt32>(bodyInterface.GetObjectLayer(bodyId)));
-  metadata.m_sLayer = layerName;
+  return CaptureBodies(bodyInterface, nsArrayPtr<const JPH::BodyID>(bodyIds.data(), static_cast<nsUInt32>(bodyIds.size())), timestamp);
+}
+
+nsResult nsJvdRecorder::CaptureBodies(const JPH::BodyInterface& bodyInterface, nsArrayPtr<const JPH::BodyID> bodyIds, nsTime timestamp)
+{
+  nsDynamicArray<nsJvdBodyState> states;
+  states.Reserve(bodyIds.GetCount());
 
-  metadata.m_bKinematic = (bodyInterface.GetMotionType(bodyId) == JPH::EMotionType::Kinematic);
+  nsDynamicArray<JPH::BodyID> capturedIds;
+  capturedIds.Reserve(bodyIds.GetCount());
 
-  if (auto shape = bodyInterface.GetShape(bodyId))
+  for (const JPH::BodyID& bodyId : bodyIds)
   {
-    const JPH::EShapeSubType subType = shape->GetSubType();
-    if (static_cast<nsUInt32>(subType) < JPH::NumSubShapeTypes)
+    if (bodyId.IsInvalid())
+      continue;
+
+    const bool bIsActive = bodyInterface.IsActive(bodyId);
+    if (!nsJvdBodyCapture::ShouldCaptureBody(m_Settings, nsJvdBodyCapture::MakeBodyKey(bodyId), !bIsActive))
+      continue;
+
+    nsJvdBodyCapture::CaptureState(m_Settings, bodyInterface, bodyId, bIsActive, states.ExpandAndGetRef());
+    capturedIds.PushBack(bodyId);
+  }
+
+  if (states.IsEmpty())
+    return NS_SUCCESS;
+
+  // the body index map and the metadata are read by StopRecording() and the flight-recorder dump, so they are only touched under the lock
+  NS_LOCK(m_Mutex);
+
+  for (nsUInt32 i = 0; i < states.GetCount(); ++i)
+  {
+    states[i].m_uiBodyIndex = m_Clip.GetOrAddBodyIndex(states[i].m_uiBodyId);
+    UpdateBodyMetadata(bodyInterface, capturedIds[i], states[i].m_uiBodyIndex);
+  }
+
+  AppendStates(timestamp, states.GetArrayPtr());
+  return NS_SUCCESS;
+}
+
+void nsJvdRecorder::UpdateBodyMetadata(const JPH::BodyInterface& bodyInterface, const JPH::BodyID& bodyId, nsUInt32 uiBodyIndex)
+{
+  if (uiBodyIndex >= m_BodyMetadata.GetCount())
+  {
+    m_BodyMetadata.SetCount(uiBodyIndex + 1);
+  }
+
+  nsJvdBodyCapture::UpdateMetadata(bodyInterface, bodyId, m_BodyMetadata[uiBodyIndex]);
+}
+
+void nsJvdRecorder::CollectBodyMetadata(nsDynamicArray<nsJvdBodyMetadata>& out_bodies) const
+{
+  out_bodies.Reserve(m_BodyMetadata.GetCount());
+  for (const nsJvdBodyMetadata& metadata : m_BodyMetadata)
+  {
+    if (metadata.m_BodyGuid.IsValid())
     {
-      metadata.m_sShape = JPH::sSubShapeTypeNames[static_cast<nsUInt32>(subType)];
+      out_bodies.PushBack(metadata);
     }
   }
 }
@@ -280,7 +840,51 @@ nsResult nsJvdRecorder::SaveClipToFile(nsStringView sFilePath) const
     return NS_FAILURE;
   }
 
-  return nsJvdSerialization::SaveClipToFile(sFilePath, m_Clip);
+  if (m_CompactedBlocks.IsEmpty() && !m_bCaptureProfiling)
+    return nsJvdSerialization::SaveClipToFile(sFilePath, m_Clip);
+
+  nsJvdClip clip = m_Clip;
+  if (m_bCaptureProfiling)
+  {
+    // frames that are still pending in the capture are not part of the file
+    clip.GetProfiling() = m_ProfilingCapture.GetData();
+  }
+
+  if (RestoreCompactedFrames(clip).Failed())
+  {
+    nsLog::Error("Failed to decode the compacted history for '{0}'.", sFilePath);
+    return NS_FAILURE;
+  }
+
+  return nsJvdSerialization::SaveClipToFile(sFilePath, clip);
+}
+
+nsTaskGroupID nsJvdRecorder::DumpFlightRecorder(nsStringView sFilePath)
+{
+  nsSharedPtr<nsJvdFlightRecorderDumpTask> pTask;
+
+  {
+    NS_LOCK(m_Mutex);
+
+    if (!m_bRecording || !m_bFlightRecorder || m_FlightRing.GetFrameCount() == 0)
+    {
+      nsLog::Warning("No flight recording available, '{0}' is not written.", sFilePath);
+      return {};
+    }
+
+    pTask = NS_DEFAULT_NEW(nsJvdFlightRecorderDumpTask);
+    pTask->m_Metadata = m_Metadata;
+    pTask->m_uiFrameCount = m_FlightRing.GetFrameCount();
+    pTask->m_Bookmarks = m_Bookmarks;
+    m_FlightRing.CopyFrames(pTask->m_EncodedFrames);
+    CollectBodyMetadata(pTask->m_Bodies);
+  }
+
+  pTask->m_sFilePath = sFilePath;
+  pTask->ConfigureTask("JVD Flight Recorder Dump", nsTaskNesting::Maybe); // the clip writer waits for its block encoding tasks
+
+  // 'LongRunning' instead of 'FileAccess', so that dumping does not block resource loading
+  return nsTaskSystem::StartSingleTask(pTask, nsTaskPriority::LongRunning);
 }
 
 NS_STATICLINK_FILE(JVDSDK, Recording_JvdRecorder);
@@ -1,12 +1,16 @@
 #pragma once
 
+#include <JVDSDK/Recording/JvdAnomalyDetector.h>
 #include <JVDSDK/Recording/JvdConversion.h>
+#include <JVDSDK/Recording/JvdFrameRing.h>
+#include <JVDSDK/Recording/JvdProfilingCapture.h>
 #include <JVDSDK/Recording/JvdRecordingTypes.h>
 
 #include <Foundation/Types/ArrayPtr.h>
-#include <Foundation/Containers/Map.h>
+#include <Foundation/Containers/HashTable.h>
 #include <Foundation/Strings/StringView.h>
 #include <Foundation/Threading/Mutex.h>
+#include <Foundation/Threading/TaskSystem.h>
 
 namespace JPH
 {
@@ -15,6 +19,18 @@ namespace JPH
   class BodyID;
 } // namespace JPH
 
+/// \brief How much history nsJvdRecorder compacted to stay within nsJvdRecordingSettings::m_uiMemoryBudget.
+struct nsJvdRecorderMemoryStats
+{
+  nsUInt64 m_uiMemoryUsage = 0;        ///< Bytes held by the live frames, their timeline summary and the compacted history.
+  nsUInt32 m_uiLiveFrames = 0;         ///< Frames at full fidelity, see nsJvdRecorder::PeekClip().
+  nsUInt32 m_uiCompactedFrames = 0;    ///< Frames stored in compressed blocks.
+  nsUInt64 m_uiCompactedBytes = 0;     ///< Size of the compressed blocks.
+  nsUInt64 m_uiThinnedFrames = 0;      ///< Frames removed to lower the frame rate of old history.
+  nsUInt64 m_uiDroppedFrames = 0;      ///< Frames removed because the budget could not be met otherwise.
+  nsUInt64 m_uiStrippedVelocities = 0; ///< States of sleeping bodies whose velocities were discarded.
+};
+
 class NS_JVDSDK_DLL nsJvdRecorder
 {
 public:
@@ -27,6 +43,9 @@ public:
 
   bool IsRecording() const { return m_bRecording; }
 
+  /// \brief Whether the current recording only keeps the last nsJvdRecordingSettings::m_FlightRecorderWindow in a ring buffer.
+  bool IsFlightRecorderActive() const { return m_bFlightRecorder; }
+
   const nsJvdRecordingSettings& GetSettings() const { return m_Settings; }
   const nsJvdClipMetadata& GetMetadata() const { return m_Metadata; }
 
@@ -35,6 +54,19 @@ public:
   /// brief Appends a new frame constructed from the provided body states.
   void AppendFrame(nsTime timestamp, nsArrayPtr<const nsJvdBodyState> states);
 
+  /// \brief Appends a copy of an already assembled frame, including its custom channel columns.
+  void AppendFrame(const nsJvdFrame& frame);
+
+  /// \brief Stages a custom channel value for a body. Staged values are attached to the next appended or captured frame.
+  ///
+  /// The channel index is the one returned by nsJvdRecordingSettings::AddCustomChannel(). Values for bodies
+  /// that are not part of the next frame are dropped.
+  void SetCustomValue(nsJvdCustomChannelIndex channel, nsUInt64 uiBodyId, float fValue);
+  void SetCustomValue(nsJvdCustomChannelIndex channel, nsUInt64 uiBodyId, const nsVec3& vValue);
+  void SetCustomValue(nsJvdCustomChannelIndex channel, nsUInt64 uiBodyId, const nsQuat& qValue);
+  void SetCustomValue(nsJvdCustomChannelIndex channel, nsUInt64 uiBodyId, nsInt32 iValue);
+  void SetCustomValue(nsJvdCustomChannelIndex channel, nsUInt64 uiBodyId, bool bValue);
+
   /// brief Captures the state of all bodies currently in the provided Jolt physics system.
   nsResult CapturePhysicsSystem(const JPH::PhysicsSystem& physicsSystem, nsTime timestamp);
 
@@ -42,23 +74,99 @@ public:
   nsResult CaptureBodies(const JPH::BodyInterface& bodyInterface, nsArrayPtr<const JPH::BodyID> bodyIds, nsTime timestamp);
 
   /// brief Returns the currently accumulated clip without stopping the recording.
+  ///
+  /// With a memory budget this only contains the frames that were not compacted yet. StopRecording() and
+  /// SaveClipToFile() include the compacted history.
   const nsJvdClip& PeekClip() const { return m_Clip; }
-  const nsMap<nsUInt64, nsJvdBodyMetadata>& GetBodyMetadata() const { return m_BodyMetadata; }
+
+  /// \brief Returns the memory use of the recording and how much of it was compacted, see nsJvdRecordingSettings::m_uiMemoryBudget.
+  nsJvdRecorderMemoryStats GetMemoryStats() const;
+
+  /// \brief Metadata of the captured bodies, indexed by body index (see nsJvdClip::GetBodyIndexMap()).
+  ///
+  /// Bodies that were only appended as states have no metadata, their entries have an invalid guid.
+  const nsDynamicArray<nsJvdBodyMetadata>& GetBodyMetadata() const { return m_BodyMetadata; }
+
+  /// \brief Time spent collecting CPU profiling scopes so far, see nsJvdRecordingSettings::m_bCaptureProfiling.
+  nsTime GetProfilingOverhead() const;
+
+  /// \brief Returns the bookmarks emitted by the anomaly detectors so far, see nsJvdRecordingSettings::m_bDetectAnomalies.
+  const nsDynamicArray<nsJvdBookmark>& GetBookmarks() const { return m_Bookmarks; }
 
   /// \brief Saves the currently recorded clip to a .jvdrec file.
   nsResult SaveClipToFile(nsStringView sFilePath) const;
 
+  /// \brief Writes the current content of the flight-recorder ring to a .jvdrec file without stopping the recording.
+  ///
+  /// The ring is copied on the calling thread, encoding and file access happen on a task. Crash handlers that need
+  /// the file on disk before the process goes down should wait on the returned group.
+  /// Returns an invalid group if flight-recorder mode is not active or no frames were recorded yet.
+  nsTaskGroupID DumpFlightRecorder(nsStringView sFilePath);
+
 private:
-  bool ShouldCaptureBody(nsUInt64 uiBodyId, bool bIsSleeping) const;
-  void UpdateBodyMetadata(const JPH::BodyInterface& bodyInterface, const JPH::BodyID& bodyId);
+  struct StagedCustomValue
+  {
+    nsUInt64 m_uiBodyId = 0;
+    nsJvdCustomChannelIndex m_uiChannel = 0;
+    nsUInt32 m_Words[4] = {};
+  };
+
+  /// A run of compacted frames, encoded with nsJvdSerialization::EncodeFrameBlock().
+  struct CompactedBlock
+  {
+    nsDynamicArray<nsUInt8> m_Data;
+    nsUInt32 m_uiFrameCount = 0;
+    nsUInt32 m_uiRateShift = 0; ///< The block keeps one in 2^m_uiRateShift of the recorded frames.
+    nsUInt64 m_uiLastFrameIndex = 0;
+  };
+
+  void AppendStates(nsTime timestamp, nsArrayPtr<const nsJvdBodyState> states);
+  void AppendFrameInternal(nsJvdFrame& frame);
+  nsUInt64 GetMemoryUsage() const;
+  void EnforceMemoryBudget(nsTime now);
+  void CompactLiveFrames(nsUInt32 uiFrameCount);
+  nsResult EncodeCompactedBlock(nsArrayPtr<nsJvdFrame> frames, nsUInt32 uiRateShift, CompactedBlock& out_block);
+  nsResult DecodeCompactedBlock(const CompactedBlock& block, nsDynamicArray<nsJvdFrame>& out_frames) const;
+  nsResult ThinCompactedBlocks(nsUInt32 uiRateShift, nsUInt64 uiTargetUsage);
+  void DropCompactedBlock();
+  void DropBookmarksBefore(nsUInt64 uiFrameIndex);
+  nsResult RestoreCompactedFrames(nsJvdClip& inout_clip) const;
+  void ResetFlightScratchFrame(nsTime timestamp);
+  void StageCustomValue(nsJvdCustomChannelIndex channel, nsJvdCustomChannelType::Enum type, nsUInt64 uiBodyId, const void* pValue);
+  void ApplyStagedCustomValues(nsJvdFrame& frame);
+  void UpdateBodyMetadata(const JPH::BodyInterface& bodyInterface, const JPH::BodyID& bodyId, nsUInt32 uiBodyIndex);
   void EnsureClipMetadata();
+  void CollectBodyMetadata(nsDynamicArray<nsJvdBodyMetadata>& out_bodies) const;
 
   mutable nsMutex m_Mutex;
   bool m_bRecording = false;
+  bool m_bFlightRecorder = false;
+  nsUInt64 m_uiNumRecordedFrames = 0;
   nsTime m_StartTime = nsTime::MakeZero();
   nsTime m_LastSampleTime = nsTime::MakeZero();
   nsJvdRecordingSettings m_Settings;
   nsJvdClipMetadata m_Metadata;
-  nsJvdClip m_Clip;
-  nsMap<nsUInt64, nsJvdBodyMetadata> m_BodyMetadata;
+  nsJvdClip m_Clip; ///< Owns the body index map, also in flight-recorder mode.
+  nsDynamicArray<nsJvdBodyMetadata> m_BodyMetadata;
+
+  nsDynamicArray<StagedCustomValue> m_StagedCustomValues;
+  nsHashTable<nsUInt64, nsUInt32> m_StagedBodyLookup;
+
+  nsJvdAnomalyDetector m_AnomalyDetector;
+  nsDynamicArray<nsJvdBookmark> m_Bookmarks;
+
+  bool m_bCaptureProfiling = false;
+  nsJvdProfilingCapture m_ProfilingCapture;
+
+  // memory budget, the live frame bytes are tracked incrementally to avoid walking all frames for every appended one
+  nsUInt64 m_uiLiveFrameBytes = 0;
+  nsUInt64 m_uiCompactedBytes = 0;
+  nsDynamicArray<CompactedBlock> m_CompactedBlocks;
+  nsJvdRecorderMemoryStats m_MemoryStats;
+  bool m_bMaximumCaptureTimeReached = false;
+  bool m_bFullFidelityWindowExceeded = false;
+
+  // flight-recorder mode, the scratch containers keep their capacity so that steady-state recording does not allocate
+  nsJvdFrameRing m_FlightRing;
+  nsJvdFrame m_FlightScratchFrame;
 };
@@ -0,0 +1,302 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Recording/JvdBodyCapture.h>
+#include <JVDSDK/Recording/JvdRecordingSession.h>
+#include <JVDSDK/Serialization/JvdFileIO.h>
+
+#include <Jolt/Physics/PhysicsSystem.h>
+
+nsJvdRecordingTrack::nsJvdRecordingTrack(const nsJvdRecordingSettings& settings, const nsJvdClipMetadata& metadata, nsTime startTime, nsUInt32 uiTrackIndex, nsUInt32 uiQueueCapacity)
+  : m_Settings(settings)
+  , m_Metadata(metadata)
+  , m_StartTime(startTime)
+  , m_uiTrackIndex(uiTrackIndex)
+  , m_bRecording(true)
+{
+  m_Queue.Initialize(uiQueueCapacity);
+
+  m_Clip.SetMetadata(m_Metadata);
+  m_AnomalyDetector.Configure(m_Settings.m_AnomalyDetection);
+}
+
+nsJvdRecordingTrack::~nsJvdRecordingTrack() = default;
+
+void nsJvdRecordingTrack::AppendFrame(nsTime timestamp, nsArrayPtr<const nsJvdBodyState> states)
+{
+  ResetScratchFrame(timestamp);
+  m_ScratchFrame.m_Bodies.PushBackRange(states);
+  AppendFrameInternal();
+}
+
+void nsJvdRecordingTrack::AppendFrame(const nsJvdFrame& frame)
+{
+  ResetScratchFrame(frame.m_Timestamp);
+  m_ScratchFrame.m_Bodies = frame.m_Bodies;
+  m_ScratchFrame.m_CustomChannels = frame.m_CustomChannels;
+  AppendFrameInternal();
+}
+
+void nsJvdRecordingTrack::ResetScratchFrame(nsTime timestamp)
+{
+  m_ScratchFrame.m_uiFrameIndex = 0;
+  m_ScratchFrame.m_Timestamp = timestamp;
+  m_ScratchFrame.m_Bodies.Clear();
+  m_ScratchFrame.m_CustomChannels.Clear();
+}
+
+void nsJvdRecordingTrack::AppendFrameInternal()
+{
+  if (!m_bRecording)
+    return;
+
+  // all tracks share the clock of the session, so the first frame of a track does not start at zero
+  nsTime relative = m_ScratchFrame.m_Timestamp - m_StartTime;
+  if (relative.IsNegative())
+  {
+    relative = nsTime::MakeZero();
+  }
+
+  if (m_Settings.m_MaximumCaptureTime.IsPositive() && relative > m_Settings.m_MaximumCaptureTime)
+  {
+    if (!m_bMaximumCaptureTimeReached)
+    {
+      nsLog::Warning("nsJvdRecordingTrack::AppendFrame() - Maximum capture time reached for track '{0}'. Further frames are discarded.", m_Metadata.m_sClipName);
+      m_bMaximumCaptureTimeReached = true;
+    }
+
+    return;
+  }
+
+  if (m_uiNumCapturedFrames > 0 && m_Settings.m_TargetFrameInterval.IsPositive() && relative - m_LastSampleTime < m_Settings.m_TargetFrameInterval * 0.5)
+    return;
+
+  m_ScratchFrame.m_uiFrameIndex = m_uiNumCapturedFrames;
+  m_ScratchFrame.m_Timestamp = relative;
+
+  if (!m_Settings.m_bRecordCustomProperties)
+  {
+    m_ScratchFrame.m_CustomChannels.Clear();
+  }
+
+  // the indices of the capture thread become hints, which saves the session the hash lookups
+  for (nsJvdBodyState& state : m_ScratchFrame.m_Bodies)
+  {
+    state.m_uiBodyIndex = m_CaptureBodies.GetOrAddIndex(state.m_uiBodyId, state.m_uiBodyIndex);
+  }
+
+  if (!m_Queue.TryPush(m_ScratchFrame))
+  {
+    m_iDroppedFrames.Increment();
+    return;
+  }
+
+  ++m_uiNumCapturedFrames;
+  m_LastSampleTime = relative;
+}
+
+nsResult nsJvdRecordingTrack::CapturePhysicsSystem(const JPH::PhysicsSystem& physicsSystem, nsTime timestamp)
+{
+  const JPH::BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
+  JPH::BodyIDVector bodyIds;
+  physicsSystem.GetBodies(bodyIds);
+
+  return CaptureBodies(bodyInterface, nsArrayPtr<const JPH::BodyID>(bodyIds.data(), static_cast<nsUInt32>(bodyIds.size())), timestamp);
+}
+
+nsResult nsJvdRecordingTrack::CaptureBodies(const JPH::BodyInterface& bodyInterface, nsArrayPtr<const JPH::BodyID> bodyIds, nsTime timestamp)
+{
+  nsDynamicArray<nsJvdBodyState>& states = m_CaptureScratch;
+  states.Clear();
+  states.Reserve(bodyIds.GetCount());
+
+  for (const JPH::BodyID& bodyId : bodyIds)
+  {
+    if (bodyId.IsInvalid())
+      continue;
+
+    const bool bIsActive = bodyInterface.IsActive(bodyId);
+    if (!nsJvdBodyCapture::ShouldCaptureBody(m_Settings, nsJvdBodyCapture::MakeBodyKey(bodyId), !bIsActive))
+      continue;
+
+    nsJvdBodyState& state = states.ExpandAndGetRef();
+    nsJvdBodyCapture::CaptureState(m_Settings, bodyInterface, bodyId, bIsActive, state);
+    state.m_uiBodyIndex = m_CaptureBodies.GetOrAddIndex(state.m_uiBodyId);
+
+    if (state.m_uiBodyIndex >= m_BodyMetadata.GetCount())
+    {
+      m_BodyMetadata.SetCount(state.m_uiBodyIndex + 1);
+    }
+
+    nsJvdBodyCapture::UpdateMetadata(bodyInterface, bodyId, m_BodyMetadata[state.m_uiBodyIndex]);
+  }
+
+  if (states.IsEmpty())
+    return NS_SUCCESS;
+
+  AppendFrame(timestamp, states.GetArrayPtr());
+  return NS_SUCCESS;
+}
+
+void nsJvdRecordingTrack::DrainQueue()
+{
+  while (m_Queue.TryPop(m_DrainFrame))
+  {
+    if (m_Settings.m_bDetectAnomalies)
+    {
+      m_Clip.AssignBodyIndices(m_DrainFrame);
+      m_AnomalyDetector.ProcessFrame(m_DrainFrame, m_Bookmarks);
+    }
+
+    m_Clip.AddFrame(std::move(m_DrainFrame));
+  }
+}
+
+void nsJvdRecordingTrack::FinishClip(nsJvdClip& out_clip)
+{
+  DrainQueue();
+
+  nsDynamicArray<nsJvdBodyMetadata> bodies;
+  for (const nsJvdBodyMetadata& metadata : m_BodyMetadata)
+  {
+    if (metadata.m_BodyGuid.IsValid())
+    {
+      bodies.PushBack(metadata);
+    }
+  }
+
+  m_Clip.SetBookmarks(m_Bookmarks);
+  m_Clip.SetBodyMetadata(bodies);
+
+  out_clip = std::move(m_Clip);
+  m_Clip.Clear();
+  m_Bookmarks.Clear();
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+nsJvdRecordingSession::nsJvdRecordingSession()
+{
+  m_Metadata.Reset();
+}
+
+nsJvdRecordingSession::~nsJvdRecordingSession() = default;
+
+void nsJvdRecordingSession::StartRecording(const nsJvdRecordingSettings& settings, nsTime startTime, const nsJvdClipMetadata& metadata)
+{
+  NS_LOCK(m_Mutex);
+
+  // the tracks reference the settings
+  m_Tracks.Clear();
+
+  m_Settings = settings;
+  m_StartTime = startTime;
+
+  if (m_Settings.m_FlightRecorderWindow.IsPositive() || m_Settings.m_uiMemoryBudget > 0)
+  {
+    nsLog::Warning("nsJvdRecordingSession: Flight-recorder mode and memory budgets are not supported by sessions and are ignored.");
+  }
+
+  m_Metadata = metadata;
+  m_Metadata.m_SampleInterval = m_Settings.m_TargetFrameInterval;
+  m_Metadata.m_CustomChannels.Clear();
+  if (m_Settings.m_bRecordCustomProperties)
+  {
+    m_Metadata.m_CustomChannels = m_Settings.m_CustomChannels;
+  }
+
+  m_bRecording = true;
+}
+
+nsJvdRecordingTrack* nsJvdRecordingSession::AddTrack(nsStringView sName, nsUInt32 uiQueueCapacity)
+{
+  NS_LOCK(m_Mutex);
+
+  if (!m_bRecording)
+  {
+    nsLog::Warning("nsJvdRecordingSession::AddTrack() - Track '{0}' can't be added, the session is not recording.", sName);
+    return nullptr;
+  }
+
+  nsJvdClipMetadata metadata = m_Metadata;
+  metadata.m_ClipGuid = nsUuid::MakeUuid();
+  metadata.m_sClipName = sName;
+
+  nsUniquePtr<nsJvdRecordingTrack>& pTrack = m_Tracks.ExpandAndGetRef();
+  pTrack = NS_DEFAULT_NEW(nsJvdRecordingTrack, m_Settings, metadata, m_StartTime, m_Tracks.GetCount() - 1, nsMath::Max(uiQueueCapacity, 1u));
+  return pTrack.Borrow();
+}
+
+void nsJvdRecordingSession::Update()
+{
+  NS_LOCK(m_Mutex);
+
+  if (!m_bRecording)
+    return;
+
+  for (nsUniquePtr<nsJvdRecordingTrack>& pTrack : m_Tracks)
+  {
+    pTrack->DrainQueue();
+  }
+}
+
+nsResult nsJvdRecordingSession::StopRecording(nsDynamicArray<nsJvdClip>& out_tracks)
+{
+  NS_LOCK(m_Mutex);
+
+  if (!m_bRecording)
+    return NS_FAILURE;
+
+  m_bRecording = false;
+
+  out_tracks.Clear();
+  out_tracks.SetCount(m_Tracks.GetCount());
+
+  for (nsUInt32 i = 0; i < m_Tracks.GetCount(); ++i)
+  {
+    m_Tracks[i]->m_bRecording = false;
+    m_Tracks[i]->FinishClip(out_tracks[i]);
+
+    if (m_Tracks[i]->GetNumDroppedFrames() > 0)
+    {
+      nsLog::Warning("Track '{0}' dropped {1} frames because its queue was full, call nsJvdRecordingSession::Update() more often.", m_Tracks[i]->GetName(), m_Tracks[i]->GetNumDroppedFrames());
+    }
+  }
+
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdRecordingSession::StopRecording(nsStringView sFilePath)
+{
+  nsDynamicArray<nsJvdClip> tracks;
+  NS_SUCCEED_OR_RETURN(StopRecording(tracks));
+
+  return nsJvdSerialization::SaveSessionToFile(sFilePath, tracks);
+}
+
+void nsJvdRecordingSession::CancelRecording()
+{
+  NS_LOCK(m_Mutex);
+
+  m_bRecording = false;
+
+  for (nsUniquePtr<nsJvdRecordingTrack>& pTrack : m_Tracks)
+  {
+    pTrack->m_bRecording = false;
+    pTrack->m_Clip.Clear();
+    pTrack->m_Bookmarks.Clear();
+  }
+}
+
+nsUInt32 nsJvdRecordingSession::GetTrackCount() const
+{
+  NS_LOCK(m_Mutex);
+  return m_Tracks.GetCount();
+}
+
+nsJvdRecordingTrack* nsJvdRecordingSession::GetTrack(nsUInt32 uiTrackIndex)
+{
+  NS_LOCK(m_Mutex);
+  return m_Tracks[uiTrackIndex].Borrow();
+}
+
+NS_STATICLINK_FILE(JVDSDK, Recording_JvdRecordingSession);
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <JVDSDK/Recording/JvdAnomalyDetector.h>
+#include <JVDSDK/Recording/JvdFrameQueue.h>
+#include <JVDSDK/Recording/JvdRecordingTypes.h>
+
+#include <Foundation/Threading/AtomicInteger.h>
+#include <Foundation/Threading/Mutex.h>
+#include <Foundation/Types/UniquePtr.h>
+
+namespace JPH
+{
+  class PhysicsSystem;
+  class BodyInterface;
+  class BodyID;
+} // namespace JPH
+
+class nsJvdRecordingSession;
+
+/// \brief The recording of one physics system within an nsJvdRecordingSession.
+///
+/// The capture functions may only be called from one thread at a time, usually the thread that steps the physics
+/// system. They never lock: captured frames go into a lock-free queue, which the session drains in Update().
+/// Frames that don't fit into the queue are dropped and counted.
+class NS_JVDSDK_DLL nsJvdRecordingTrack
+{
+  NS_DISALLOW_COPY_AND_ASSIGN(nsJvdRecordingTrack);
+
+public:
+  /// \brief Tracks are created by nsJvdRecordingSession::AddTrack().
+  nsJvdRecordingTrack(const nsJvdRecordingSettings& settings, const nsJvdClipMetadata& metadata, nsTime startTime, nsUInt32 uiTrackIndex, nsUInt32 uiQueueCapacity);
+  ~nsJvdRecordingTrack();
+
+  nsUInt32 GetTrackIndex() const { return m_uiTrackIndex; }
+  nsStringView GetName() const { return m_Metadata.m_sClipName; }
+
+  /// \brief Appends a new frame constructed from the provided body states. The timestamp uses the clock of the session.
+  void AppendFrame(nsTime timestamp, nsArrayPtr<const nsJvdBodyState> states);
+
+  /// \brief Appends a copy of an already assembled frame, including its custom channel columns.
+  void AppendFrame(const nsJvdFrame& frame);
+
+  /// \brief Captures the state of all bodies currently in the provided Jolt physics system.
+  nsResult CapturePhysicsSystem(const JPH::PhysicsSystem& physicsSystem, nsTime timestamp);
+
+  /// \brief Captures the state of a list of bodies fetched through the supplied body interface.
+  nsResult CaptureBodies(const JPH::BodyInterface& bodyInterface, nsArrayPtr<const JPH::BodyID> bodyIds, nsTime timestamp);
+
+  /// \brief Frames that were discarded because the session did not drain the queue in time.
+  nsUInt64 GetNumDroppedFrames() const { return static_cast<nsUInt64>(m_iDroppedFrames); }
+
+private:
+  friend class nsJvdRecordingSession;
+
+  void AppendFrameInternal();
+  void ResetScratchFrame(nsTime timestamp);
+
+  /// Consumer side, called by the session under its lock.
+  void DrainQueue();
+  void FinishClip(nsJvdClip& out_clip);
+
+  const nsJvdRecordingSettings& m_Settings; ///< Owned by the session, constant while recording.
+  nsJvdClipMetadata m_Metadata;
+  nsTime m_StartTime;
+  nsUInt32 m_uiTrackIndex = 0;
+  nsAtomicBool m_bRecording;
+
+  // capture side, only touched by the capture thread
+  nsUInt64 m_uiNumCapturedFrames = 0;
+  nsTime m_LastSampleTime = nsTime::MakeZero();
+  bool m_bMaximumCaptureTimeReached = false;
+  nsJvdFrame m_ScratchFrame;
+  nsDynamicArray<nsJvdBodyState> m_CaptureScratch;
+  nsJvdBodyIndexMap m_CaptureBodies;
+  nsDynamicArray<nsJvdBodyMetadata> m_BodyMetadata; ///< Indexed like m_CaptureBodies, read by the session once capturing stopped.
+
+  nsJvdFrameQueue m_Queue;
+  nsAtomicInteger64 m_iDroppedFrames;
+
+  // consumer side
+  nsJvdFrame m_DrainFrame;
+  nsJvdClip m_Clip;
+  nsJvdAnomalyDetector m_AnomalyDetector;
+  nsDynamicArray<nsJvdBookmark> m_Bookmarks;
+};
+
+/// \brief Records several physics systems, each stepped on its own thread, into one session with a shared clock.
+///
+/// Every physics system gets an nsJvdRecordingTrack. The capture threads only touch their own track, so they never
+/// contend with each other or with the session. One thread (e.g. the main thread) calls Update() regularly to move
+/// the queued frames into the per-track clips. All timestamps are relative to the start time of the session, so the
+/// tracks can be overlaid or compared frame by frame. nsJvdSerialization::SaveSessionToFile() interleaves the tracks
+/// into one .jvdses file.
+///
+/// The flight-recorder mode and the memory budget of nsJvdRecordingSettings are not supported by sessions.
+class NS_JVDSDK_DLL nsJvdRecordingSession
+{
+  NS_DISALLOW_COPY_AND_ASSIGN(nsJvdRecordingSession);
+
+public:
+  nsJvdRecordingSession();
+  ~nsJvdRecordingSession();
+
+  /// \brief Removes all tracks and starts a new session. The timestamps passed to the tracks must use the same clock as startTime.
+  void StartRecording(const nsJvdRecordingSettings& settings, nsTime startTime = nsTime::Now(), const nsJvdClipMetadata& metadata = {});
+
+  /// \brief Adds a track for one physics system. The track stays valid until the next StartRecording(). Thread-safe.
+  ///
+  /// uiQueueCapacity is the number of frames the track can queue between two calls to Update().
+  nsJvdRecordingTrack* AddTrack(nsStringView sName, nsUInt32 uiQueueCapacity = 256);
+
+  /// \brief Moves the frames queued by the capture threads into the track clips.
+  void Update();
+
+  /// \brief Stops the session and returns one clip per track, in the order the tracks were added.
+  ///
+  /// Must only be called once the capture threads stopped using their tracks.
+  nsResult StopRecording(nsDynamicArray<nsJvdClip>& out_tracks);
+
+  /// \brief Stops the session and writes it to a .jvdses file, see StopRecording().
+  nsResult StopRecording(nsStringView sFilePath);
+
+  void CancelRecording();
+
+  bool IsRecording() const { return m_bRecording; }
+  nsTime GetStartTime() const { return m_StartTime; }
+
+  nsUInt32 GetTrackCount() const;
+  nsJvdRecordingTrack* GetTrack(nsUInt32 uiTrackIndex);
+
+private:
+  mutable nsMutex m_Mutex; ///< Guards the track list and the consumer side of the tracks, never taken by capture threads.
+  bool m_bRecording = false;
+  nsTime m_StartTime = nsTime::MakeZero();
+  nsJvdRecordingSettings m_Settings;
+  nsJvdClipMetadata m_Metadata;
+  nsDynamicArray<nsUniquePtr<nsJvdRecordingTrack>> m_Tracks;
+};
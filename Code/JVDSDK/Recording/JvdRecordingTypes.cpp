@@ -20,6 +20,7 @@ void nsJvdBodyMetadata::Reset()
 void nsJvdBodyState::Reset()
 {
   m_uiBodyId = 0;
+  m_uiBodyIndex = nsInvalidIndex;
   m_vPosition.SetZero();
   m_qRotation.SetIdentity();
   m_vScale.Set(1.0f);
@@ -29,7 +30,6 @@ void nsJvdBodyState::Reset()
   m_fRestitution = 0.0f;
   m_bIsSleeping = false;
   m_bWasTeleported = false;
-  m_CustomProperties.Clear();
 }
 
 const nsJvdBodyState* nsJvdFrame::FindBody(nsUInt64 uiBodyId) const
@@ -65,6 +65,46 @@ void nsJvdFrame::AddOrUpdateBody(const nsJvdBodyState& state)
   m_Bodies.PushBack(state);
 }
 
+nsJvdCustomChannelColumn& nsJvdFrame::GetOrCreateCustomChannel(nsJvdCustomChannelIndex channel, nsJvdCustomChannelType::Enum type)
+{
+  if (channel >= m_CustomChannels.GetCount())
+  {
+    m_CustomChannels.SetCount(channel + 1);
+  }
+
+  nsJvdCustomChannelColumn& column = m_CustomChannels[channel];
+  if (column.m_Values.IsEmpty() || column.m_Type != type)
+  {
+    column.Reset(type, m_Bodies.GetCount());
+  }
+  else if (column.GetBodyCount() < m_Bodies.GetCount())
+  {
+    column.m_Values.SetCount(m_Bodies.GetCount() * column.GetStride());
+    column.m_PresenceMask.SetCount((m_Bodies.GetCount() + 31) / 32, 0u);
+  }
+
+  return column;
+}
+
+const nsJvdCustomChannelColumn* nsJvdFrame::GetCustomChannel(nsJvdCustomChannelIndex channel) const
+{
+  if (channel >= m_CustomChannels.GetCount() || m_CustomChannels[channel].m_Values.IsEmpty())
+    return nullptr;
+
+  return &m_CustomChannels[channel];
+}
+
+nsUInt64 nsJvdFrame::GetHeapMemoryUsage() const
+{
+  nsUInt64 uiBytes = m_Bodies.GetHeapMemoryUsage() + m_CustomChannels.GetHeapMemoryUsage();
+  for (const nsJvdCustomChannelColumn& column : m_CustomChannels)
+  {
+    uiBytes += column.GetHeapMemoryUsage();
+  }
+
+  return uiBytes;
+}
+
 void nsJvdClipMetadata::Reset()
 {
   m_ClipGuid = nsUuid::MakeInvalid();
@@ -74,6 +114,7 @@ void nsJvdClipMetadata::Reset()
   m_Tags.Clear();
   m_CreationTimeUtc = nsTime::Now();
   m_SampleInterval = nsTime::MakeZero();
+  m_CustomChannels.Clear();
 }
 
 nsJvdClip::nsJvdClip()
@@ -84,15 +125,33 @@ nsJvdClip::nsJvdClip()
 nsJvdClip::nsJvdClip(const nsJvdClip& other)
   : m_Metadata(other.m_Metadata)
   , m_Frames(other.m_Frames)
+  , m_BodyMetadata(other.m_BodyMetadata)
+  , m_Bookmarks(other.m_Bookmarks)
+  , m_TimelineSummary(other.m_TimelineSummary)
+  , m_BodyIndexMap(other.m_BodyIndexMap)
+  , m_BodyMetadataSlots(other.m_BodyMetadataSlots)
+  , m_Profiling(other.m_Profiling)
 {
 }
 
 nsJvdClip::nsJvdClip(nsJvdClip&& other) noexcept
   : m_Metadata(std::move(other.m_Metadata))
   , m_Frames(std::move(other.m_Frames))
+  , m_BodyMetadata(std::move(other.m_BodyMetadata))
+  , m_Bookmarks(std::move(other.m_Bookmarks))
+  , m_TimelineSummary(std::move(other.m_TimelineSummary))
+  , m_BodyIndexMap(std::move(other.m_BodyIndexMap))
+  , m_BodyMetadataSlots(std::move(other.m_BodyMetadataSlots))
+  , m_Profiling(std::move(other.m_Profiling))
 {
   other.m_Metadata.Reset();
   other.m_Frames.Clear();
+  other.m_BodyMetadata.Clear();
+  other.m_Bookmarks.Clear();
+  other.m_TimelineSummary.Clear();
+  other.m_BodyIndexMap.Clear();
+  other.m_BodyMetadataSlots.Clear();
+  other.m_Profiling.Clear();
 }
 
 nsJvdClip::~nsJvdClip() = default;
@@ -104,6 +163,12 @@ nsJvdClip& nsJvdClip::operator=(const nsJvdClip& other)
 
   m_Metadata = other.m_Metadata;
   m_Frames = other.m_Frames;
+  m_BodyMetadata = other.m_BodyMetadata;
+  m_Bookmarks = other.m_Bookmarks;
+  m_TimelineSummary = other.m_TimelineSummary;
+  m_BodyIndexMap = other.m_BodyIndexMap;
+  m_BodyMetadataSlots = other.m_BodyMetadataSlots;
+  m_Profiling = other.m_Profiling;
   return *this;
 }
 
@@ -114,8 +179,20 @@ nsJvdClip& nsJvdClip::operator=(nsJvdClip&& other) noexcept
 
   m_Metadata = std::move(other.m_Metadata);
   m_Frames = std::move(other.m_Frames);
+  m_BodyMetadata = std::move(other.m_BodyMetadata);
+  m_Bookmarks = std::move(other.m_Bookmarks);
+  m_TimelineSummary = std::move(other.m_TimelineSummary);
+  m_BodyIndexMap = std::move(other.m_BodyIndexMap);
+  m_BodyMetadataSlots = std::move(other.m_BodyMetadataSlots);
+  m_Profiling = std::move(other.m_Profiling);
   other.m_Metadata.Reset();
   other.m_Frames.Clear();
+  other.m_BodyMetadata.Clear();
+  other.m_Bookmarks.Clear();
+  other.m_TimelineSummary.Clear();
+  other.m_BodyIndexMap.Clear();
+  other.m_BodyMetadataSlots.Clear();
+  other.m_Profiling.Clear();
   return *this;
 }
 
@@ -123,6 +200,12 @@ void nsJvdClip::Clear()
 {
   m_Metadata.Reset();
   m_Frames.Clear();
+  m_BodyMetadata.Clear();
+  m_Bookmarks.Clear();
+  m_TimelineSummary.Clear();
+  m_BodyIndexMap.Clear();
+  m_BodyMetadataSlots.Clear();
+  m_Profiling.Clear();
 }
 
 void nsJvdClip::SetMetadata(const nsJvdClipMetadata& metadata)
@@ -139,8 +222,10 @@ const nsJvdClipMetadata& nsJvdClip::GetMetadata() const
   return m_Metadata;
 }
 
-nsUInt64 nsJvdClip::AddFrame(nsJvdFrame&& frame)
+nsUInt64 nsJvdClip::AddFrame(nsJvdFrame&& frame, bool bUpdateTimelineSummary)
 {
+  bUpdateTimelineSummary = bUpdateTimelineSummary && IsTimelineSummaryUpToDate();
+
   if (frame.m_uiFrameIndex == 0)
   {
     frame.m_uiFrameIndex = m_Frames.GetCount();
@@ -156,7 +241,15 @@ nsUInt64 nsJvdClip::AddFrame(nsJvdFrame&& frame)
     }
   }
 
+  AssignBodyIndices(frame);
+
   m_Frames.PushBack(std::move(frame));
+
+  if (bUpdateTimelineSummary)
+  {
+    m_TimelineSummary.AppendFrame(m_Frames.PeekBack());
+  }
+
   return m_Frames.PeekBack().m_uiFrameIndex;
 }
 
@@ -200,6 +293,86 @@ const nsJvdFrame* nsJvdClip::FindFrame(nsUInt64 uiFrameIndex) const
   return nullptr;
 }
 
+void nsJvdClip::SetBodyMetadata(nsArrayPtr<const nsJvdBodyMetadata> bodies)
+{
+  m_BodyMetadata = bodies;
+
+  m_BodyMetadataSlots.Clear();
+  for (nsUInt32 i = 0; i < m_BodyMetadata.GetCount(); ++i)
+  {
+    const nsUInt32 uiBodyIndex = m_BodyIndexMap.GetOrAddIndex(m_BodyMetadata[i].m_uiBodyId);
+    if (uiBodyIndex >= m_BodyMetadataSlots.GetCount())
+    {
+      m_BodyMetadataSlots.SetCount(uiBodyIndex + 1, nsInvalidIndex);
+    }
+
+    m_BodyMetadataSlots[uiBodyIndex] = i;
+  }
+}
+
+const nsJvdBodyMetadata* nsJvdClip::FindBodyMetadata(nsUInt64 uiBodyId) const
+{
+  return GetBodyMetadataByIndex(m_BodyIndexMap.FindIndex(uiBodyId));
+}
+
+const nsJvdBodyMetadata* nsJvdClip::GetBodyMetadataByIndex(nsUInt32 uiBodyIndex) const
+{
+  if (uiBodyIndex >= m_BodyMetadataSlots.GetCount() || m_BodyMetadataSlots[uiBodyIndex] == nsInvalidIndex)
+    return nullptr;
+
+  return &m_BodyMetadata[m_BodyMetadataSlots[uiBodyIndex]];
+}
+
+void nsJvdClip::AssignBodyIndices(nsJvdFrame& inout_frame)
+{
+  for (nsJvdBodyState& state : inout_frame.m_Bodies)
+  {
+    state.m_uiBodyIndex = m_BodyIndexMap.GetOrAddIndex(state.m_uiBodyId, state.m_uiBodyIndex);
+  }
+}
+
+void nsJvdClip::AddBookmark(const nsJvdBookmark& bookmark)
+{
+  if (IsTimelineSummaryUpToDate())
+  {
+    // bookmarks are usually added for the frame that was just recorded
+    nsUInt32 uiPosition = nsInvalidIndex;
+    if (!m_Frames.IsEmpty() && m_Frames.PeekBack().m_uiFrameIndex == bookmark.m_uiFrameIndex)
+    {
+      uiPosition = m_Frames.GetCount() - 1;
+    }
+    else
+    {
+      uiPosition = nsJvdTimelineSummary::FindFramePosition(m_Frames, bookmark.m_uiFrameIndex);
+    }
+
+    m_TimelineSummary.AddBookmark(uiPosition, bookmark);
+  }
+
+  m_Bookmarks.PushBack(bookmark);
+}
+
+void nsJvdClip::SetBookmarks(nsArrayPtr<const nsJvdBookmark> bookmarks)
+{
+  m_Bookmarks = bookmarks;
+
+  // rebuilt on demand
+  m_TimelineSummary.Clear();
+}
+
+bool nsJvdClip::IsTimelineSummaryUpToDate() const
+{
+  return m_TimelineSummary.GetFrameCount() == m_Frames.GetCount() && m_TimelineSummary.GetBookmarkCount() == m_Bookmarks.GetCount();
+}
+
+void nsJvdClip::UpdateTimelineSummary()
+{
+  if (!IsTimelineSummaryUpToDate())
+  {
+    m_TimelineSummary.Build(m_Frames, m_Bookmarks);
+  }
+}
+
 nsTime nsJvdClip::GetDuration() const
 {
   if (m_Frames.IsEmpty())
@@ -220,6 +393,11 @@ nsTime nsJvdClip::GetSampleInterval() const
   return nsTime::MakeFromSeconds(total.GetSeconds() / (m_Frames.GetCount() - 1));
 }
 
+void nsJvdAnomalyDetectionSettings::Reset()
+{
+  *this = nsJvdAnomalyDetectionSettings();
+}
+
 void nsJvdRecordingSettings::Reset()
 {
   m_sSessionName.Clear();
@@ -230,6 +408,33 @@ void nsJvdRecordingSettings::Reset()
   m_bCaptureSleepingBodies = false;
   m_bRecordVelocities = true;
   m_bRecordCustomProperties = false;
+  m_CustomChannels.Clear();
+  m_FlightRecorderWindow = nsTime::MakeZero();
+  m_uiFlightRecorderBufferSize = 32 * 1024 * 1024;
+  m_bDetectAnomalies = false;
+  m_AnomalyDetection.Reset();
+  m_uiMemoryBudget = 0;
+  m_FullFidelityWindow = nsTime::MakeFromSeconds(10.0);
+  m_bCaptureProfiling = false;
+  m_MinProfilingScopeDuration = nsTime::MakeFromMicroseconds(20.0);
+}
+
+nsJvdCustomChannelIndex nsJvdRecordingSettings::AddCustomChannel(nsStringView sName, nsJvdCustomChannelType::Enum type)
+{
+  for (nsUInt32 i = 0; i < m_CustomChannels.GetCount(); ++i)
+  {
+    if (m_CustomChannels[i].m_sName == sName)
+    {
+      NS_ASSERT_DEV(m_CustomChannels[i].m_Type == type, "Custom channel '{0}' was already declared with a different type.", sName);
+      return static_cast<nsJvdCustomChannelIndex>(i);
+    }
+  }
+
+  nsJvdCustomChannelDesc& desc = m_CustomChannels.ExpandAndGetRef();
+  desc.m_sName = sName;
+  desc.m_Type = type;
+  m_bRecordCustomProperties = true;
+  return static_cast<nsJvdCustomChannelIndex>(m_CustomChannels.GetCount() - 1);
 }
 
 NS_BEGIN_STATIC_REFLECTED_TYPE(nsJvdBodyMetadata, nsNoBase, 1, nsRTTIDefaultAllocator<nsJvdBodyMetadata>)
@@ -264,7 +469,6 @@ NS_BEGIN_STATIC_REFLECTED_TYPE(nsJvdBodyState, nsNoBase, 1, nsRTTIDefaultAllocat
     NS_MEMBER_PROPERTY("Restitution", m_fRestitution),
     NS_MEMBER_PROPERTY("Sleeping", m_bIsSleeping),
     NS_MEMBER_PROPERTY("Teleported", m_bWasTeleported),
-    NS_MEMBER_PROPERTY("Custom", m_CustomProperties),
   }
   NS_END_PROPERTIES;
 }
@@ -282,6 +486,30 @@ NS_BEGIN_STATIC_REFLECTED_TYPE(nsJvdFrame, nsNoBase, 1, nsRTTIDefaultAllocator<n
 }
 NS_END_STATIC_REFLECTED_TYPE;
 
+NS_BEGIN_STATIC_REFLECTED_ENUM(nsJvdBookmarkKind, 1)
+  NS_ENUM_CONSTANT(nsJvdBookmarkKind::NonFiniteTransform),
+  NS_ENUM_CONSTANT(nsJvdBookmarkKind::VelocitySpike),
+  NS_ENUM_CONSTANT(nsJvdBookmarkKind::AngularVelocitySpike),
+  NS_ENUM_CONSTANT(nsJvdBookmarkKind::Teleport),
+  NS_ENUM_CONSTANT(nsJvdBookmarkKind::EnergyGain),
+  NS_ENUM_CONSTANT(nsJvdBookmarkKind::OutOfBounds)
+NS_END_STATIC_REFLECTED_ENUM;
+
+NS_BEGIN_STATIC_REFLECTED_TYPE(nsJvdBookmark, nsNoBase, 1, nsRTTIDefaultAllocator<nsJvdBookmark>)
+{
+  NS_BEGIN_PROPERTIES
+  {
+    NS_MEMBER_PROPERTY("FrameIndex", m_uiFrameIndex),
+    NS_MEMBER_PROPERTY("Timestamp", m_Timestamp),
+    NS_ENUM_MEMBER_PROPERTY("Kind", nsJvdBookmarkKind, m_Kind),
+    NS_MEMBER_PROPERTY("BodyId", m_uiBodyId),
+    NS_MEMBER_PROPERTY("BodyCount", m_uiBodyCount),
+    NS_MEMBER_PROPERTY("Value", m_fValue),
+  }
+  NS_END_PROPERTIES;
+}
+NS_END_STATIC_REFLECTED_TYPE;
+
 NS_BEGIN_STATIC_REFLECTED_TYPE(nsJvdClipMetadata, nsNoBase, 1, nsRTTIDefaultAllocator<nsJvdClipMetadata>)
 {
   NS_BEGIN_PROPERTIES
@@ -293,6 +521,7 @@ NS_BEGIN_STATIC_REFLECTED_TYPE(nsJvdClipMetadata, nsNoBase, 1, nsRTTIDefaultAllo
     NS_ARRAY_MEMBER_PROPERTY("Tags", m_Tags),
     NS_MEMBER_PROPERTY("CreationTimeUtc", m_CreationTimeUtc),
     NS_MEMBER_PROPERTY("SampleInterval", m_SampleInterval),
+    NS_ARRAY_MEMBER_PROPERTY("CustomChannels", m_CustomChannels),
   }
   NS_END_PROPERTIES;
 }
@@ -304,6 +533,30 @@ NS_BEGIN_STATIC_REFLECTED_TYPE(nsJvdClip, nsNoBase, 1, nsRTTIDefaultAllocator<ns
   {
     NS_ACCESSOR_PROPERTY("Metadata", GetMetadata, SetMetadata),
     NS_ARRAY_MEMBER_PROPERTY("Frames", m_Frames),
+    NS_ARRAY_MEMBER_PROPERTY("BodyMetadata", m_BodyMetadata),
+    NS_ARRAY_MEMBER_PROPERTY("Bookmarks", m_Bookmarks),
+  }
+  NS_END_PROPERTIES;
+}
+NS_END_STATIC_REFLECTED_TYPE;
+
+NS_BEGIN_STATIC_REFLECTED_TYPE(nsJvdAnomalyDetectionSettings, nsNoBase, 1, nsRTTIDefaultAllocator<nsJvdAnomalyDetectionSettings>)
+{
+  NS_BEGIN_PROPERTIES
+  {
+    NS_MEMBER_PROPERTY("DetectNonFiniteTransforms", m_bDetectNonFiniteTransforms),
+    NS_MEMBER_PROPERTY("DetectVelocitySpikes", m_bDetectVelocitySpikes),
+    NS_MEMBER_PROPERTY("DetectTeleports", m_bDetectTeleports),
+    NS_MEMBER_PROPERTY("DetectEnergyGain", m_bDetectEnergyGain),
+    NS_MEMBER_PROPERTY("DetectOutOfBounds", m_bDetectOutOfBounds),
+    NS_MEMBER_PROPERTY("MaxLinearVelocityChange", m_fMaxLinearVelocityChange),
+    NS_MEMBER_PROPERTY("MaxAngularVelocityChange", m_fMaxAngularVelocityChange),
+    NS_MEMBER_PROPERTY("TeleportDistance", m_fTeleportDistance),
+    NS_MEMBER_PROPERTY("MaxEnergyGain", m_fMaxEnergyGain),
+    NS_MEMBER_PROPERTY("MaxRelativeEnergyGain", m_fMaxRelativeEnergyGain),
+    NS_MEMBER_PROPERTY("Gravity", m_vGravity),
+    NS_MEMBER_PROPERTY("WorldBoundsMin", m_vWorldBoundsMin),
+    NS_MEMBER_PROPERTY("WorldBoundsMax", m_vWorldBoundsMax),
   }
   NS_END_PROPERTIES;
 }
@@ -321,6 +574,15 @@ NS_BEGIN_STATIC_REFLECTED_TYPE(nsJvdRecordingSettings, nsNoBase, 1, nsRTTIDefaul
     NS_MEMBER_PROPERTY("CaptureSleepingBodies", m_bCaptureSleepingBodies),
     NS_MEMBER_PROPERTY("RecordVelocities", m_bRecordVelocities),
     NS_MEMBER_PROPERTY("RecordCustomProperties", m_bRecordCustomProperties),
+    NS_ARRAY_MEMBER_PROPERTY("CustomChannels", m_CustomChannels),
+    NS_MEMBER_PROPERTY("FlightRecorderWindow", m_FlightRecorderWindow),
+    NS_MEMBER_PROPERTY("FlightRecorderBufferSize", m_uiFlightRecorderBufferSize),
+    NS_MEMBER_PROPERTY("DetectAnomalies", m_bDetectAnomalies),
+    NS_MEMBER_PROPERTY("AnomalyDetection", m_AnomalyDetection),
+    NS_MEMBER_PROPERTY("MemoryBudget", m_uiMemoryBudget),
+    NS_MEMBER_PROPERTY("FullFidelityWindow", m_FullFidelityWindow),
+    NS_MEMBER_PROPERTY("CaptureProfiling", m_bCaptureProfiling),
+    NS_MEMBER_PROPERTY("MinProfilingScopeDuration", m_MinProfilingScopeDuration),
   }
   NS_END_PROPERTIES;
 }
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <JVDSDK/JVDSDKDLL.h>
+#include <JVDSDK/Recording/JvdBodyIndexMap.h>
+#include <JVDSDK/Recording/JvdCustomChannels.h>
+#include <JVDSDK/Recording/JvdProfilingData.h>
+#include <JVDSDK/Recording/JvdTimelineSummary.h>
 
 #include <Foundation/Containers/DynamicArray.h>
 #include <Foundation/Containers/HybridArray.h>
@@ -8,8 +12,8 @@
 #include <Foundation/Math/Vec3.h>
 #include <Foundation/Strings/String.h>
 #include <Foundation/Time/Time.h>
+#include <Foundation/Types/Enum.h>
 #include <Foundation/Types/Uuid.h>
-#include <Foundation/Types/Variant.h>
 
 
 namespace nsJvdIds
@@ -18,6 +22,8 @@ namespace nsJvdIds
   constexpr nsUInt32 g_uiTelemetryFrameMessageId = 0x6672616D; // 'fram'
   constexpr nsUInt32 g_uiTelemetryCommandMessageId = 0x636D6473; // 'cmds'
   constexpr nsUInt32 g_uiTelemetryClipMessageId = 0x636C6970;   // 'clip'
+  constexpr nsUInt32 g_uiTelemetryDictionaryMessageId = 0x64696374;      // 'dict'
+  constexpr nsUInt32 g_uiTelemetryCompressedFrameMessageId = 0x66726D7A; // 'frmz'
 }
 
 struct NS_JVDSDK_DLL nsJvdBodyMetadata
@@ -42,6 +48,7 @@ NS_DECLARE_REFLECTABLE_TYPE(NS_JVDSDK_DLL, nsJvdBodyMetadata);
 struct NS_JVDSDK_DLL nsJvdBodyState
 {
   nsUInt64 m_uiBodyId = 0;
+  nsUInt32 m_uiBodyIndex = nsInvalidIndex; ///< Dense clip-local index, see nsJvdClip::GetBodyIndexMap(). Assigned by nsJvdClip::AddFrame().
   nsVec3 m_vPosition = nsVec3::MakeZero();
   nsQuat m_qRotation = nsQuat::MakeIdentity();
   nsVec3 m_vScale = nsVec3(1.0f);
@@ -51,7 +58,6 @@ struct NS_JVDSDK_DLL nsJvdBodyState
   float m_fRestitution = 0.0f;
   bool m_bIsSleeping = false;
   bool m_bWasTeleported = false;
-  nsVariantDictionary m_CustomProperties;
 
   void Reset();
 };
@@ -63,12 +69,58 @@ struct NS_JVDSDK_DLL nsJvdFrame
   nsTime m_Timestamp = nsTime::MakeZero();
   nsDynamicArray<nsJvdBodyState> m_Bodies;
 
+  /// \brief One column per declared custom channel (indexed by nsJvdCustomChannelIndex). May be shorter than the channel list.
+  nsHybridArray<nsJvdCustomChannelColumn, 2> m_CustomChannels;
+
   const nsJvdBodyState* FindBody(nsUInt64 uiBodyId) const;
   nsJvdBodyState* FindBody(nsUInt64 uiBodyId);
   void AddOrUpdateBody(const nsJvdBodyState& state);
+
+  /// \brief Returns the column of the given channel, sized to the current body count. Creates missing columns on demand.
+  nsJvdCustomChannelColumn& GetOrCreateCustomChannel(nsJvdCustomChannelIndex channel, nsJvdCustomChannelType::Enum type);
+
+  /// \brief Returns the column of the given channel or nullptr if this frame has no values for it.
+  const nsJvdCustomChannelColumn* GetCustomChannel(nsJvdCustomChannelIndex channel) const;
+
+  /// \brief Bytes allocated by the body states and the custom channel columns, not including the frame itself.
+  nsUInt64 GetHeapMemoryUsage() const;
 };
 NS_DECLARE_REFLECTABLE_TYPE(NS_JVDSDK_DLL, nsJvdFrame);
 
+/// \brief What a clip bookmark points at.
+struct NS_JVDSDK_DLL nsJvdBookmarkKind
+{
+  using StorageType = nsUInt8;
+
+  enum Enum
+  {
+    NonFiniteTransform,   ///< A position or rotation became NaN or Inf.
+    VelocitySpike,        ///< The linear velocity changed more than plausible within one step.
+    AngularVelocitySpike, ///< The angular velocity changed more than plausible within one step.
+    Teleport,             ///< A body moved further than its velocity allows without being flagged as teleported.
+    EnergyGain,           ///< The kinetic plus potential energy of a body grew across one step.
+    OutOfBounds,          ///< A body left the configured world bounds.
+
+    ENUM_COUNT,
+
+    Default = NonFiniteTransform,
+  };
+};
+
+NS_DECLARE_REFLECTABLE_TYPE(NS_JVDSDK_DLL, nsJvdBookmarkKind);
+
+/// \brief Marks a frame of interest inside a clip, e.g. emitted by nsJvdAnomalyDetector during capture.
+struct NS_JVDSDK_DLL nsJvdBookmark
+{
+  nsUInt64 m_uiFrameIndex = 0;
+  nsTime m_Timestamp = nsTime::MakeZero();
+  nsEnum<nsJvdBookmarkKind> m_Kind;
+  nsUInt64 m_uiBodyId = 0;    ///< The worst offending body.
+  nsUInt32 m_uiBodyCount = 0; ///< How many bodies triggered this kind of bookmark in the frame.
+  float m_fValue = 0.0f;      ///< Magnitude for the worst body, the unit depends on the kind.
+};
+NS_DECLARE_REFLECTABLE_TYPE(NS_JVDSDK_DLL, nsJvdBookmark);
+
 struct NS_JVDSDK_DLL nsJvdClipMetadata
 {
   nsUuid m_ClipGuid;
@@ -78,6 +130,7 @@ struct NS_JVDSDK_DLL nsJvdClipMetadata
   nsHybridArray<nsString, 8> m_Tags;
   nsTime m_CreationTimeUtc = nsTime::MakeZero();
   nsTime m_SampleInterval = nsTime::MakeZero();
+  nsHybridArray<nsJvdCustomChannelDesc, 4> m_CustomChannels;
 
   void Reset();
 };
@@ -99,15 +152,60 @@ public:
   void SetMetadata(const nsJvdClipMetadata& metadata);
   const nsJvdClipMetadata& GetMetadata() const;
 
-  nsUInt64 AddFrame(nsJvdFrame&& frame);
+  /// \brief Appends a frame. Pass false for bUpdateTimelineSummary when adding many frames at once and call
+  /// UpdateTimelineSummary() afterwards, which builds the summary in parallel.
+  nsUInt64 AddFrame(nsJvdFrame&& frame, bool bUpdateTimelineSummary = true);
   const nsDynamicArray<nsJvdFrame>& GetFrames() const { return m_Frames; }
   nsDynamicArray<nsJvdFrame>& GetFrames() { return m_Frames; }
 
   const nsJvdFrame* FindFrameByTime(nsTime timestamp) const;
   const nsJvdFrame* FindFrame(nsUInt64 uiFrameIndex) const;
 
+  /// \brief Names, layers and shapes of the recorded bodies, so that a clip can be viewed without the original scene.
+  void SetBodyMetadata(nsArrayPtr<const nsJvdBodyMetadata> bodies);
+  const nsDynamicArray<nsJvdBodyMetadata>& GetBodyMetadata() const { return m_BodyMetadata; }
+  const nsJvdBodyMetadata* FindBodyMetadata(nsUInt64 uiBodyId) const;
+  const nsJvdBodyMetadata* GetBodyMetadataByIndex(nsUInt32 uiBodyIndex) const;
+
+  /// \brief Maps the ids of all bodies of the frames and the body metadata to dense indices.
+  ///
+  /// AddFrame() and SetBodyMetadata() extend it. After modifying body ids through GetFrames(), call AssignBodyIndices().
+  const nsJvdBodyIndexMap& GetBodyIndexMap() const { return m_BodyIndexMap; }
+
+  /// \brief Returns the index of a body of this clip's frames, without a hash lookup if the state's index is current.
+  nsUInt32 GetBodyIndex(const nsJvdBodyState& state) const
+  {
+    if (state.m_uiBodyIndex < m_BodyIndexMap.GetCount() && m_BodyIndexMap.GetBodyId(state.m_uiBodyIndex) == state.m_uiBodyId)
+      return state.m_uiBodyIndex;
+
+    return m_BodyIndexMap.FindIndex(state.m_uiBodyId);
+  }
+
+  /// \brief Returns the index of the body, adding it to the index map if the clip has not seen it yet.
+  nsUInt32 GetOrAddBodyIndex(nsUInt64 uiBodyId) { return m_BodyIndexMap.GetOrAddIndex(uiBodyId); }
+
+  /// \brief Sets nsJvdBodyState::m_uiBodyIndex of all bodies of the frame. Indices that already match are kept without a hash lookup.
+  void AssignBodyIndices(nsJvdFrame& inout_frame);
+
+  void AddBookmark(const nsJvdBookmark& bookmark);
+  void SetBookmarks(nsArrayPtr<const nsJvdBookmark> bookmarks);
+  const nsDynamicArray<nsJvdBookmark>& GetBookmarks() const { return m_Bookmarks; }
+
+  /// \brief CPU profiling scopes of the frames, empty unless the recording captured them.
+  const nsJvdProfilingData& GetProfiling() const { return m_Profiling; }
+  nsJvdProfilingData& GetProfiling() { return m_Profiling; }
+  void SetProfiling(nsJvdProfilingData&& profiling) { m_Profiling = std::move(profiling); }
+
   bool IsEmpty() const { return m_Frames.IsEmpty(); }
 
+  /// \brief Statistics pyramid over all frames for zoomed-out timeline views. Kept up to date by AddFrame() and
+  /// AddBookmark(), after other modifications (e.g. through GetFrames()) call UpdateTimelineSummary().
+  const nsJvdTimelineSummary& GetTimelineSummary() const { return m_TimelineSummary; }
+  bool IsTimelineSummaryUpToDate() const;
+
+  /// \brief Rebuilds the timeline summary if it does not cover all frames and bookmarks.
+  void UpdateTimelineSummary();
+
   nsTime GetDuration() const;
   nsTime GetSampleInterval() const;
 
@@ -116,9 +214,39 @@ private:
 
   nsJvdClipMetadata m_Metadata;
   nsDynamicArray<nsJvdFrame> m_Frames;
+  nsDynamicArray<nsJvdBodyMetadata> m_BodyMetadata;
+  nsDynamicArray<nsJvdBookmark> m_Bookmarks;
+  nsJvdTimelineSummary m_TimelineSummary;
+  nsJvdBodyIndexMap m_BodyIndexMap;
+  nsDynamicArray<nsUInt32> m_BodyMetadataSlots; ///< Position in m_BodyMetadata by body index, nsInvalidIndex for bodies without metadata.
+  nsJvdProfilingData m_Profiling;
 };
 NS_DECLARE_REFLECTABLE_TYPE(NS_JVDSDK_DLL, nsJvdClip);
 
+/// \brief Thresholds of the anomaly detectors that run during capture, see nsJvdAnomalyDetector.
+///
+/// Energies are tracked per unit mass and unit inertia, since the recording does not know body masses.
+struct NS_JVDSDK_DLL nsJvdAnomalyDetectionSettings
+{
+  bool m_bDetectNonFiniteTransforms = true;
+  bool m_bDetectVelocitySpikes = true;
+  bool m_bDetectTeleports = true;
+  bool m_bDetectEnergyGain = true;
+  bool m_bDetectOutOfBounds = false;
+
+  float m_fMaxLinearVelocityChange = 50.0f;   ///< m/s per step
+  float m_fMaxAngularVelocityChange = 100.0f; ///< rad/s per step
+  float m_fTeleportDistance = 2.0f;           ///< How much further than its velocity explains a body may move within one step.
+  float m_fMaxEnergyGain = 25.0f;             ///< J/kg per step
+  float m_fMaxRelativeEnergyGain = 0.25f;     ///< Fraction of the previous energy that may be gained within one step.
+  nsVec3 m_vGravity = nsVec3(0.0f, -9.81f, 0.0f);
+  nsVec3 m_vWorldBoundsMin = nsVec3(-10000.0f);
+  nsVec3 m_vWorldBoundsMax = nsVec3(10000.0f);
+
+  void Reset();
+};
+NS_DECLARE_REFLECTABLE_TYPE(NS_JVDSDK_DLL, nsJvdAnomalyDetectionSettings);
+
 struct NS_JVDSDK_DLL nsJvdRecordingSettings
 {
   nsString m_sSessionName;
@@ -129,6 +257,39 @@ struct NS_JVDSDK_DLL nsJvdRecordingSettings
   bool m_bCaptureSleepingBodies = false;
   bool m_bRecordVelocities = true;
   bool m_bRecordCustomProperties = false;
+  nsHybridArray<nsJvdCustomChannelDesc, 4> m_CustomChannels;
+
+  /// \brief If positive, the recorder runs in flight-recorder mode and only keeps this much history, see nsJvdRecorder::DumpFlightRecorder().
+  nsTime m_FlightRecorderWindow = nsTime::MakeZero();
+
+  /// \brief Size of the preallocated flight-recorder ring in bytes. Older frames are evicted early if the window does not fit.
+  nsUInt32 m_uiFlightRecorderBufferSize = 32 * 1024 * 1024;
+
+  /// \brief Runs nsJvdAnomalyDetector over every recorded frame and adds its bookmarks to the clip.
+  bool m_bDetectAnomalies = false;
+  nsJvdAnomalyDetectionSettings m_AnomalyDetection;
+
+  /// \brief If non-zero, the recorder keeps the frames it holds below this many bytes. Ignored in flight-recorder mode.
+  ///
+  /// Once the budget is reached, history older than m_FullFidelityWindow is compacted step by step: it is compressed,
+  /// sleeping bodies lose their velocities and its frame rate is halved down to 1/16. The oldest history is dropped
+  /// when that is not enough. See nsJvdRecorder::GetMemoryStats().
+  nsUInt64 m_uiMemoryBudget = 0;
+
+  /// \brief The most recent history, which is kept at full fidelity as long as it fits into the memory budget.
+  nsTime m_FullFidelityWindow = nsTime::MakeFromSeconds(10.0);
+
+  /// \brief Stores the CPU scopes of nsProfilingSystem that ran during each recorded frame, see nsJvdClip::GetProfiling().
+  ///
+  /// Opt-in, because the profiler's buffers are copied a few times per second. The cost is reported by
+  /// nsJvdRecorder::GetProfilingOverhead(). Ignored in flight-recorder mode.
+  bool m_bCaptureProfiling = false;
+
+  /// \brief Shorter scopes are not stored.
+  nsTime m_MinProfilingScopeDuration = nsTime::MakeFromMicroseconds(20.0);
+
+  /// \brief Declares a custom channel for the clip and returns the index used to push values for it.
+  nsJvdCustomChannelIndex AddCustomChannel(nsStringView sName, nsJvdCustomChannelType::Enum type);
 
   void Reset();
 };
@@ -0,0 +1,267 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Recording/JvdRecordingTypes.h>
+#include <JVDSDK/Recording/JvdTimelineSummary.h>
+
+#include <Foundation/SimdMath/SimdConversion.h>
+#include <Foundation/Threading/TaskSystem.h>
+
+void nsJvdTimelineBucket::Merge(const nsJvdTimelineBucket& other)
+{
+  m_uiMaxActiveBodies = nsMath::Max(m_uiMaxActiveBodies, other.m_uiMaxActiveBodies);
+  m_uiAnomalyMask |= other.m_uiAnomalyMask;
+  m_fMaxLinearSpeed = nsMath::Max(m_fMaxLinearSpeed, other.m_fMaxLinearSpeed);
+  m_fMaxAngularSpeed = nsMath::Max(m_fMaxAngularSpeed, other.m_fMaxAngularSpeed);
+  m_fMaxKineticEnergy = nsMath::Max(m_fMaxKineticEnergy, other.m_fMaxKineticEnergy);
+
+  // invalid boxes are inverted, so they drop out of the min / max without a branch
+  m_Bounds.m_vMin = m_Bounds.m_vMin.CompMin(other.m_Bounds.m_vMin);
+  m_Bounds.m_vMax = m_Bounds.m_vMax.CompMax(other.m_Bounds.m_vMax);
+}
+
+nsJvdTimelineBucket nsJvdTimelineBucket::MakeFromFrame(const nsJvdFrame& frame)
+{
+  nsJvdTimelineBucket bucket;
+
+  float fMaxLinearSqr = 0.0f;
+  float fMaxAngularSqr = 0.0f;
+  float fEnergy = 0.0f;
+
+  const nsSimdVec4f vHalf(0.5f);
+  nsSimdVec4f vBoundsMin(nsMath::MaxValue<float>());
+  nsSimdVec4f vBoundsMax(-nsMath::MaxValue<float>());
+
+  for (const nsJvdBodyState& state : frame.m_Bodies)
+  {
+    bucket.m_uiMaxActiveBodies += state.m_bIsSleeping ? 0 : 1;
+
+    const nsSimdVec4f vPosition = nsSimdConversion::ToVec3(state.m_vPosition);
+    const nsSimdVec4f vHalfExtents = nsSimdConversion::ToVec3(state.m_vScale).Abs().CompMul(vHalf);
+    const nsSimdVec4f vMin = vPosition - vHalfExtents;
+    const nsSimdVec4f vMax = vPosition + vHalfExtents;
+
+    // a single body at infinity would make the bounds useless for framing the scene
+    if (vMin.IsValid<3>() && vMax.IsValid<3>())
+    {
+      vBoundsMin = vBoundsMin.CompMin(vMin);
+      vBoundsMax = vBoundsMax.CompMax(vMax);
+    }
+
+    const float fLinearSqr = state.m_vLinearVelocity.GetLengthSquared();
+    const float fAngularSqr = state.m_vAngularVelocity.GetLengthSquared();
+
+    // broken bodies are reported through bookmarks, they would only flatten the overview
+    if (!nsMath::IsFinite(fLinearSqr) || !nsMath::IsFinite(fAngularSqr))
+      continue;
+
+    fMaxLinearSqr = nsMath::Max(fMaxLinearSqr, fLinearSqr);
+    fMaxAngularSqr = nsMath::Max(fMaxAngularSqr, fAngularSqr);
+    fEnergy += 0.5f * (fLinearSqr + fAngularSqr);
+  }
+
+  bucket.m_fMaxLinearSpeed = nsMath::Sqrt(fMaxLinearSqr);
+  bucket.m_fMaxAngularSpeed = nsMath::Sqrt(fMaxAngularSqr);
+  bucket.m_fMaxKineticEnergy = fEnergy;
+  bucket.m_Bounds = nsBoundingBox::MakeFromMinMax(nsSimdConversion::ToVec3(vBoundsMin), nsSimdConversion::ToVec3(vBoundsMax));
+  return bucket;
+}
+
+void nsJvdTimelineSummary::Clear()
+{
+  m_Levels.Clear();
+  m_uiBookmarkCount = 0;
+}
+
+void nsJvdTimelineSummary::Build(nsArrayPtr<const nsJvdFrame> frames, nsArrayPtr<const nsJvdBookmark> bookmarks)
+{
+  Clear();
+
+  if (!frames.IsEmpty())
+  {
+    nsDynamicArray<nsJvdTimelineBucket>& level0 = m_Levels.ExpandAndGetRef();
+    level0.SetCountUninitialized(frames.GetCount());
+
+    nsParallelForParams params;
+    params.m_uiBinSize = 64;
+
+    nsJvdTimelineBucket* pBuckets = level0.GetData();
+    nsTaskSystem::ParallelForIndexed(0u, frames.GetCount(), [pBuckets, frames](nsUInt32 uiStart, nsUInt32 uiEnd)
+      {
+        for (nsUInt32 i = uiStart; i < uiEnd; ++i)
+        {
+          pBuckets[i] = nsJvdTimelineBucket::MakeFromFrame(frames[i]);
+        }
+      },
+      "JVD Timeline Summary", nsTaskNesting::Never, params);
+  }
+
+  for (const nsJvdBookmark& bookmark : bookmarks)
+  {
+    const nsUInt32 uiPosition = FindFramePosition(frames, bookmark.m_uiFrameIndex);
+    if (uiPosition != nsInvalidIndex && bookmark.m_Kind.GetValue() < 32)
+    {
+      m_Levels[0][uiPosition].m_uiAnomalyMask |= (1u << bookmark.m_Kind.GetValue());
+    }
+
+    ++m_uiBookmarkCount;
+  }
+
+  while (!m_Levels.IsEmpty() && m_Levels.PeekBack().GetCount() > 1)
+  {
+    BuildLevel(m_Levels.GetCount());
+  }
+}
+
+void nsJvdTimelineSummary::BuildLevel(nsUInt32 uiLevel)
+{
+  NS_ASSERT_DEV(uiLevel == m_Levels.GetCount() && uiLevel > 0, "Levels must be built bottom up.");
+
+  m_Levels.ExpandAndGetRef();
+
+  const nsDynamicArray<nsJvdTimelineBucket>& source = m_Levels[uiLevel - 1];
+  nsDynamicArray<nsJvdTimelineBucket>& target = m_Levels[uiLevel];
+  target.SetCountUninitialized((source.GetCount() + 1) / 2);
+
+  nsParallelForParams params;
+  params.m_uiBinSize = 1024;
+
+  const nsJvdTimelineBucket* pSource = source.GetData();
+  nsJvdTimelineBucket* pTarget = target.GetData();
+  const nsUInt32 uiSourceCount = source.GetCount();
+
+  nsTaskSystem::ParallelForIndexed(0u, target.GetCount(), [pSource, pTarget, uiSourceCount](nsUInt32 uiStart, nsUInt32 uiEnd)
+    {
+      for (nsUInt32 i = uiStart; i < uiEnd; ++i)
+      {
+        pTarget[i] = pSource[2 * i];
+        if (2 * i + 1 < uiSourceCount)
+        {
+          pTarget[i].Merge(pSource[2 * i + 1]);
+        }
+      }
+    },
+    "JVD Timeline Summary Level", nsTaskNesting::Never, params);
+}
+
+void nsJvdTimelineSummary::AppendFrame(const nsJvdFrame& frame)
+{
+  if (m_Levels.IsEmpty())
+  {
+    m_Levels.ExpandAndGetRef();
+  }
+
+  m_Levels[0].PushBack(nsJvdTimelineBucket::MakeFromFrame(frame));
+
+  nsUInt32 uiPosition = m_Levels[0].GetCount() - 1;
+  for (nsUInt32 uiLevel = 0; m_Levels[uiLevel].GetCount() > 1; ++uiLevel)
+  {
+    if (uiLevel + 1 == m_Levels.GetCount())
+    {
+      // the level just got its second bucket, its parent level covers both
+      BuildLevel(uiLevel + 1);
+      break;
+    }
+
+    const nsJvdTimelineBucket& child = m_Levels[uiLevel][uiPosition];
+    nsDynamicArray<nsJvdTimelineBucket>& parents = m_Levels[uiLevel + 1];
+
+    uiPosition /= 2;
+    if (uiPosition == parents.GetCount())
+    {
+      parents.PushBack(child);
+    }
+    else
+    {
+      parents[uiPosition].Merge(child);
+    }
+  }
+}
+
+void nsJvdTimelineSummary::AddBookmark(nsUInt32 uiFramePosition, const nsJvdBookmark& bookmark)
+{
+  ++m_uiBookmarkCount;
+
+  if (uiFramePosition >= GetFrameCount() || bookmark.m_Kind.GetValue() >= 32)
+    return;
+
+  const nsUInt32 uiBit = 1u << bookmark.m_Kind.GetValue();
+  for (nsUInt32 uiLevel = 0; uiLevel < m_Levels.GetCount(); ++uiLevel)
+  {
+    m_Levels[uiLevel][uiFramePosition >> uiLevel].m_uiAnomalyMask |= uiBit;
+  }
+}
+
+nsJvdTimelineBucket nsJvdTimelineSummary::Query(nsUInt32 uiFirstFrame, nsUInt32 uiFrameCount) const
+{
+  nsJvdTimelineBucket result;
+
+  const nsUInt32 uiTotalFrames = GetFrameCount();
+  if (uiFirstFrame >= uiTotalFrames || uiFrameCount == 0)
+    return result;
+
+  uiFrameCount = nsMath::Min(uiFrameCount, uiTotalFrames - uiFirstFrame);
+
+  // the largest buckets that are not larger than the range, it then overlaps at most three of them
+  const nsUInt32 uiLevel = nsMath::Min(nsMath::FirstBitHigh(uiFrameCount), m_Levels.GetCount() - 1);
+  const nsDynamicArray<nsJvdTimelineBucket>& buckets = m_Levels[uiLevel];
+
+  const nsUInt32 uiFirstBucket = uiFirstFrame >> uiLevel;
+  const nsUInt32 uiLastBucket = nsMath::Min((uiFirstFrame + uiFrameCount - 1) >> uiLevel, buckets.GetCount() - 1);
+
+  for (nsUInt32 i = uiFirstBucket; i <= uiLastBucket; ++i)
+  {
+    result.Merge(buckets[i]);
+  }
+
+  return result;
+}
+
+void nsJvdTimelineSummary::Sample(nsUInt32 uiFirstFrame, nsUInt32 uiFrameCount, nsArrayPtr<nsJvdTimelineBucket> out_samples) const
+{
+  const nsUInt64 uiSampleCount = out_samples.GetCount();
+
+  for (nsUInt32 i = 0; i < out_samples.GetCount(); ++i)
+  {
+    const nsUInt32 uiStart = uiFirstFrame + static_cast<nsUInt32>(uiFrameCount * i / uiSampleCount);
+    const nsUInt32 uiEnd = uiFirstFrame + static_cast<nsUInt32>(uiFrameCount * (i + 1ull) / uiSampleCount);
+
+    // with more samples than frames, neighboring samples show the same frame
+    out_samples[i] = Query(uiStart, nsMath::Max(uiEnd - uiStart, 1u));
+  }
+}
+
+nsUInt64 nsJvdTimelineSummary::GetHeapMemoryUsage() const
+{
+  nsUInt64 uiBytes = m_Levels.GetHeapMemoryUsage();
+  for (const nsDynamicArray<nsJvdTimelineBucket>& level : m_Levels)
+  {
+    uiBytes += level.GetHeapMemoryUsage();
+  }
+  return uiBytes;
+}
+
+nsUInt32 nsJvdTimelineSummary::FindFramePosition(nsArrayPtr<const nsJvdFrame> frames, nsUInt64 uiFrameIndex)
+{
+  nsUInt32 uiLow = 0;
+  nsUInt32 uiHigh = frames.GetCount();
+
+  while (uiLow < uiHigh)
+  {
+    const nsUInt32 uiMid = (uiLow + uiHigh) / 2;
+    if (frames[uiMid].m_uiFrameIndex < uiFrameIndex)
+    {
+      uiLow = uiMid + 1;
+    }
+    else
+    {
+      uiHigh = uiMid;
+    }
+  }
+
+  if (uiLow < frames.GetCount() && frames[uiLow].m_uiFrameIndex == uiFrameIndex)
+    return uiLow;
+
+  return nsInvalidIndex;
+}
+
+NS_STATICLINK_FILE(JVDSDK, Recording_JvdTimelineSummary);
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <JVDSDK/JVDSDKDLL.h>
+
+#include <Foundation/Containers/DynamicArray.h>
+#include <Foundation/Math/BoundingBox.h>
+#include <Foundation/Types/ArrayPtr.h>
+
+struct nsJvdFrame;
+struct nsJvdBookmark;
+
+/// \brief Aggregated statistics of a range of frames, one entry of an nsJvdTimelineSummary level.
+///
+/// Energies are per unit mass and unit inertia, like the ones tracked by nsJvdAnomalyDetector.
+struct NS_JVDSDK_DLL nsJvdTimelineBucket
+{
+  NS_DECLARE_POD_TYPE();
+
+  nsUInt32 m_uiMaxActiveBodies = 0; ///< Highest number of bodies that were awake in any frame of the range.
+  nsUInt32 m_uiAnomalyMask = 0;     ///< One bit per nsJvdBookmarkKind that was bookmarked in the range.
+  float m_fMaxLinearSpeed = 0.0f;
+  float m_fMaxAngularSpeed = 0.0f;
+  float m_fMaxKineticEnergy = 0.0f; ///< Highest summed kinetic energy of all bodies in any frame of the range.
+  nsBoundingBox m_Bounds = nsBoundingBox::MakeInvalid(); ///< Encloses the unrotated boxes of all bodies in the range, invalid without bodies.
+
+  void Merge(const nsJvdTimelineBucket& other);
+
+  /// \brief Computes the statistics of a single frame. Bodies with non-finite velocities or positions are ignored.
+  static nsJvdTimelineBucket MakeFromFrame(const nsJvdFrame& frame);
+};
+
+/// \brief Mipmap-style pyramid of frame statistics, so that a timeline can show an overview of any clip length.
+///
+/// Level 0 holds one bucket per frame (addressed by the frame's position in the clip, not by its frame index), every
+/// further level merges two buckets of the level below. Query() therefore merges at most three buckets, no matter how
+/// many frames the range covers.
+class NS_JVDSDK_DLL nsJvdTimelineSummary
+{
+public:
+  void Clear();
+
+  /// \brief Rebuilds all levels, the per-frame statistics are computed in parallel.
+  void Build(nsArrayPtr<const nsJvdFrame> frames, nsArrayPtr<const nsJvdBookmark> bookmarks);
+
+  /// \brief Adds the next frame and updates the levels above it.
+  void AppendFrame(const nsJvdFrame& frame);
+
+  /// \brief Marks the frame at the given position with the kind of the bookmark.
+  void AddBookmark(nsUInt32 uiFramePosition, const nsJvdBookmark& bookmark);
+
+  /// \brief Counts a bookmark that did not match any frame, so that GetBookmarkCount() stays in sync with the clip.
+  void SkipBookmark() { ++m_uiBookmarkCount; }
+
+  nsUInt32 GetFrameCount() const { return m_Levels.IsEmpty() ? 0 : m_Levels[0].GetCount(); }
+  nsUInt32 GetBookmarkCount() const { return m_uiBookmarkCount; }
+
+  nsUInt32 GetLevelCount() const { return m_Levels.GetCount(); }
+  nsArrayPtr<const nsJvdTimelineBucket> GetLevel(nsUInt32 uiLevel) const { return m_Levels[uiLevel]; }
+
+  /// \brief Returns the statistics of the frames [uiFirstFrame, uiFirstFrame + uiFrameCount) in constant time.
+  ///
+  /// Ranges that are not aligned to the buckets of the chosen level include up to one bucket of neighboring frames, like
+  /// a texture mipmap. Ranges of a single frame are exact.
+  nsJvdTimelineBucket Query(nsUInt32 uiFirstFrame, nsUInt32 uiFrameCount) const;
+
+  /// \brief Splits the frames [uiFirstFrame, uiFirstFrame + uiFrameCount) evenly into out_samples.GetCount() ranges and queries each.
+  void Sample(nsUInt32 uiFirstFrame, nsUInt32 uiFrameCount, nsArrayPtr<nsJvdTimelineBucket> out_samples) const;
+
+  nsUInt64 GetHeapMemoryUsage() const;
+
+  /// \brief Returns the position of the frame with the given frame index or nsInvalidIndex. Expects ascending frame indices.
+  static nsUInt32 FindFramePosition(nsArrayPtr<const nsJvdFrame> frames, nsUInt64 uiFrameIndex);
+
+private:
+  void BuildLevel(nsUInt32 uiLevel);
+
+  nsDynamicArray<nsDynamicArray<nsJvdTimelineBucket>> m_Levels;
+  nsUInt32 m_uiBookmarkCount = 0;
+};
@@ -0,0 +1,899 @@
+#include <JVDSDK/JVDSDKPCH.h>
+
+#include <JVDSDK/Serialization/JvdClipSimplification.h>
+#include <JVDSDK/Serialization/JvdStreamSerializer.h>
+
+#include <Foundation/Containers/Bitfield.h>
+#include <Foundation/Containers/HashTable.h>
+#include <Foundation/IO/FileSystem/FileReader.h>
+#include <Foundation/IO/FileSystem/FileWriter.h>
+#include <Foundation/IO/MemoryStream.h>
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Memory/MemoryUtils.h>
+#include <Foundation/Threading/TaskSystem.h>
+
+namespace
+{
+  constexpr nsUInt8 g_szJvdSimMagic[] = {'J', 'V', 'D', 'S', 'I', 'M'};
+
+  /// \brief Version of the .jvdsim layout.
+  ///
+  /// 1: Initial layout.
+  constexpr nsUInt32 g_uiSimplifiedFormatVersion = 1;
+
+  constexpr nsUInt32 g_uiMaxGroupComponents = 6;
+
+  struct BodySamples
+  {
+    nsUInt64 m_uiBodyId = 0;
+    nsDynamicArray<nsUInt32> m_Frames;
+    nsDynamicArray<nsJvdBodyState> m_States;
+  };
+
+  /// The input of fitting one group of curves that share their keys.
+  struct GroupFit
+  {
+    nsUInt32 m_uiComponents = 0;
+    const double* m_pFrames = nullptr;
+    const double* m_pSeconds = nullptr;
+    const float* m_pValues = nullptr;      ///< m_uiComponents per sample.
+    const float* m_pDerivatives = nullptr; ///< Change per second, if set Hermite segments are tried before linear ones.
+    const nsDynamicBitfield* m_pForcedKeys = nullptr;
+    const nsUInt32* m_pSleepEnds = nullptr; ///< For the first sample of a sleeping run the last one, otherwise the sample itself.
+    nsUInt32 m_uiMaxSegmentFrames = 0;
+  };
+
+  /// The segment to the next key is either linear or a Hermite spline through the recorded velocities.
+  struct SegmentKey
+  {
+    NS_DECLARE_POD_TYPE();
+
+    nsUInt32 m_uiSample;
+    bool m_bHermite;
+  };
+
+  /// The tangents are always a third of the segment long along x, which makes the curve parameter linear in x.
+  double EvaluateSegment(const nsCurve1D::ControlPoint& cp0, const nsCurve1D::ControlPoint& cp1, double fX)
+  {
+    const double fLength = cp1.m_Position.x - cp0.m_Position.x;
+    const double t = fLength > 0.0 ? nsMath::Clamp((fX - cp0.m_Position.x) / fLength, 0.0, 1.0) : 0.0;
+
+    return nsMath::EvaluateBnsierCurve(t, cp0.m_Position.y, cp0.m_Position.y + cp0.m_RightTangent.y, cp1.m_Position.y + cp1.m_LeftTangent.y, cp1.m_Position.y);
+  }
+
+  /// All curves of a group have the same keys, so the segment is only searched in the first one.
+  void EvaluateGroup(const nsCurve1D* pCurves, nsUInt32 uiComponents, double fX, double* out_pValues)
+  {
+    const nsCurve1D& first = pCurves[0];
+    const nsUInt32 uiCount = first.GetNumControlPoints();
+
+    if (uiCount == 0)
+    {
+      for (nsUInt32 k = 0; k < uiComponents; ++k)
+        out_pValues[k] = 0.0;
+      return;
+    }
+
+    nsUInt32 uiLow = 0;
+    nsUInt32 uiHigh = uiCount;
+    while (uiLow + 1 < uiHigh)
+    {
+      const nsUInt32 uiMid = (uiLow + uiHigh) / 2;
+      if (first.GetControlPoint(uiMid).m_Position.x <= fX)
+        uiLow = uiMid;
+      else
+        uiHigh = uiMid;
+    }
+
+    for (nsUInt32 k = 0; k < uiComponents; ++k)
+    {
+      if (uiLow + 1 < uiCount)
+        out_pValues[k] = EvaluateSegment(pCurves[k].GetControlPoint(uiLow), pCurves[k].GetControlPoint(uiLow + 1), fX);
+      else
+        out_pValues[k] = pCurves[k].GetControlPoint(uiLow).m_Position.y;
+    }
+  }
+
+  void MakeSegment(const GroupFit& group, nsUInt32 a, nsUInt32 c, bool bHermite, nsCurve1D::ControlPoint* pStart, nsCurve1D::ControlPoint* pEnd)
+  {
+    const nsUInt32 n = group.m_uiComponents;
+    const double fLength = group.m_pFrames[c] - group.m_pFrames[a];
+    const double fDuration = group.m_pSeconds[c] - group.m_pSeconds[a];
+
+    for (nsUInt32 k = 0; k < n; ++k)
+    {
+      const double y0 = group.m_pValues[a * n + k];
+      const double y1 = group.m_pValues[c * n + k];
+
+      double fOut = y1 - y0;
+      double fIn = y1 - y0;
+      if (bHermite)
+      {
+        fOut = group.m_pDerivatives[a * n + k] * fDuration;
+        fIn = group.m_pDerivatives[c * n + k] * fDuration;
+      }
+
+      pStart[k].m_Position.Set(group.m_pFrames[a], y0);
+      pStart[k].m_RightTangent.Set(static_cast<float>(fLength / 3.0), static_cast<float>(fOut / 3.0));
+      pEnd[k].m_Position.Set(group.m_pFrames[c], y1);
+      pEnd[k].m_LeftTangent.Set(static_cast<float>(-fLength / 3.0), static_cast<float>(-fIn / 3.0));
+    }
+  }
+
+  /// Greedily extends every segment for as long as all samples it spans are reconstructed within the tolerance.
+  template <typename WithinTolerance>
+  void FitGroup(const GroupFit& group, nsUInt32 uiSampleCount, WithinTolerance withinTolerance, nsCurve1D* const* pCurves)
+  {
+    const nsUInt32 n = group.m_uiComponents;
+
+    auto Fits = [&](nsUInt32 a, nsUInt32 c, bool bHermite) -> bool
+    {
+      nsCurve1D::ControlPoint start[g_uiMaxGroupComponents];
+      nsCurve1D::ControlPoint end[g_uiMaxGroupComponents];
+      MakeSegment(group, a, c, bHermite, start, end);
+
+      double values[g_uiMaxGroupComponents];
+      for (nsUInt32 s = a + 1; s < c; ++s)
+      {
+        for (nsUInt32 k = 0; k < n; ++k)
+        {
+          values[k] = EvaluateSegment(start[k], end[k], group.m_pFrames[s]);
+        }
+
+        if (!withinTolerance(values, s))
+          return false;
+      }
+
+      return true;
+    };
+
+    nsDynamicArray<SegmentKey> keys;
+
+    nsUInt32 a = 0;
+    while (true)
+    {
+      keys.PushBack({a, false});
+
+      if (a + 1 >= uiSampleCount)
+        break;
+
+      // neighboring samples always fit, there is nothing in between
+      nsUInt32 uiEnd = a + 1;
+      bool bHermite = false;
+
+      // sleeping bodies don't move, one constant segment of any length avoids the quadratic search
+      const nsUInt32 uiSleepEnd = group.m_pSleepEnds[a];
+      const bool bConstant = uiSleepEnd > a + 1 && Fits(a, uiSleepEnd, false);
+      if (bConstant)
+      {
+        uiEnd = uiSleepEnd;
+      }
+
+      for (nsUInt32 c = a + 2; !bConstant && c < uiSampleCount && c - a <= group.m_uiMaxSegmentFrames && !group.m_pForcedKeys->IsBitSet(c - 1); ++c)
+      {
+        if (group.m_pDerivatives != nullptr && Fits(a, c, true))
+        {
+          bHermite = true;
+        }
+        else if (Fits(a, c, false))
+        {
+          bHermite = false;
+        }
+        else
+        {
+          break;
+        }
+
+        uiEnd = c;
+      }
+
+      keys.PeekBack().m_bHermite = bHermite;
+      a = uiEnd;
+    }
+
+    for (nsUInt32 k = 0; k < n; ++k)
+    {
+      pCurves[k]->Clear();
+
+      for (const SegmentKey& key : keys)
+      {
+        nsCurve1D::ControlPoint& cp = pCurves[k]->AddControlPoint(group.m_pFrames[key.m_uiSample]);
+        cp.m_Position.y = group.m_pValues[key.m_uiSample * n + k];
+        cp.m_TangentModeLeft = nsCurveTangentMode::Bnsier;
+        cp.m_TangentModeRight = nsCurveTangentMode::Bnsier;
+      }
+
+      pCurves[k]->RecomputeExtents();
+    }
+
+    for (nsUInt32 i = 0; i + 1 < keys.GetCount(); ++i)
+    {
+      nsCurve1D::ControlPoint start[g_uiMaxGroupComponents];
+      nsCurve1D::ControlPoint end[g_uiMaxGroupComponents];
+      MakeSegment(group, keys[i].m_uiSample, keys[i + 1].m_uiSample, keys[i].m_bHermite, start, end);
+
+      for (nsUInt32 k = 0; k < n; ++k)
+      {
+        pCurves[k]->ModifyControlPoint(i).m_RightTangent = start[k].m_RightTangent;
+        pCurves[k]->ModifyControlPoint(i + 1).m_LeftTangent = end[k].m_LeftTangent;
+      }
+    }
+  }
+
+  void SimplifyBody(const BodySamples& samples, const nsTime* pTimestamps, const nsJvdSimplificationSettings& settings, nsJvdSimplifiedBody& out_body)
+  {
+    const nsUInt32 uiSampleCount = samples.m_Frames.GetCount();
+    out_body.m_uiBodyId = samples.m_uiBodyId;
+
+    // keys must be placed where the body appears, disappears, falls asleep, wakes up or teleports
+    nsDynamicBitfield forcedKeys;
+    forcedKeys.SetCount(uiSampleCount);
+
+    auto ForceKeysAround = [&](nsUInt32 i)
+    {
+      forcedKeys.SetBit(i);
+      if (i > 0)
+        forcedKeys.SetBit(i - 1);
+    };
+
+    for (nsUInt32 i = 0; i < uiSampleCount; ++i)
+    {
+      const nsUInt32 uiFrame = samples.m_Frames[i];
+      const nsJvdBodyState& state = samples.m_States[i];
+      const nsJvdBodyState* pPrevious = i > 0 ? &samples.m_States[i - 1] : nullptr;
+      const bool bContinues = i > 0 && samples.m_Frames[i - 1] + 1 == uiFrame;
+
+      if (bContinues)
+      {
+        out_body.m_Present.PeekBack().m_uiLastFrame = uiFrame;
+      }
+      else
+      {
+        out_body.m_Present.PushBack({uiFrame, uiFrame});
+        ForceKeysAround(i);
+      }
+
+      if (state.m_bIsSleeping)
+      {
+        if (bContinues && pPrevious->m_bIsSleeping)
+          out_body.m_Sleeping.PeekBack().m_uiLastFrame = uiFrame;
+        else
+          out_body.m_Sleeping.PushBack({uiFrame, uiFrame});
+      }
+
+      if (pPrevious != nullptr && pPrevious->m_bIsSleeping != state.m_bIsSleeping)
+      {
+        ForceKeysAround(i);
+      }
+
+      if (state.m_bWasTeleported)
+      {
+        out_body.m_Teleported.PushBack(uiFrame);
+        ForceKeysAround(i);
+      }
+
+      if (pPrevious == nullptr || pPrevious->m_vScale != state.m_vScale || pPrevious->m_fFriction != state.m_fFriction || pPrevious->m_fRestitution != state.m_fRestitution)
+      {
+        out_body.m_PropertyChanges.PushBack({uiFrame, state.m_vScale, state.m_fFriction, state.m_fRestitution});
+      }
+    }
+
+    nsDynamicArray<nsUInt32> sleepEnds;
+    sleepEnds.SetCountUninitialized(uiSampleCount);
+    for (nsUInt32 i = uiSampleCount; i-- > 0;)
+    {
+      sleepEnds[i] = i;
+
+      if (i + 1 < uiSampleCount && samples.m_States[i].m_bIsSleeping && samples.m_States[i + 1].m_bIsSleeping && samples.m_Frames[i] + 1 == samples.m_Frames[i + 1])
+        sleepEnds[i] = sleepEnds[i + 1];
+    }
+
+    nsDynamicArray<double> frames;
+    nsDynamicArray<double> seconds;
+    nsDynamicArray<float> positions;
+    nsDynamicArray<float> linearVelocities;
+    nsDynamicArray<float> rotations;
+    nsDynamicArray<float> velocities;
+    frames.SetCountUninitialized(uiSampleCount);
+    seconds.SetCountUninitialized(uiSampleCount);
+    positions.SetCountUninitialized(uiSampleCount * 3);
+    linearVelocities.SetCountUninitialized(uiSampleCount * 3);
+    rotations.SetCountUninitialized(uiSampleCount * 4);
+    velocities.SetCountUninitialized(uiSampleCount * 6);
+
+    nsQuat qPrevious = nsQuat::MakeIdentity();
+    for (nsUInt32 i = 0; i < uiSampleCount; ++i)
+    {
+      const nsJvdBodyState& state = samples.m_States[i];
+      frames[i] = samples.m_Frames[i];
+      seconds[i] = pTimestamps[samples.m_Frames[i]].GetSeconds();
+
+      // q and -q are the same rotation, interpolating between them must not take the long way around
+      nsQuat q = state.m_qRotation;
+      if (i > 0 && q.Dot(qPrevious) < 0.0f)
+      {
+        q = nsQuat(-q.x, -q.y, -q.z, -q.w);
+      }
+      qPrevious = q;
+
+      for (nsUInt32 k = 0; k < 3; ++k)
+      {
+        positions[i * 3 + k] = state.m_vPosition.GetData()[k];
+        linearVelocities[i * 3 + k] = state.m_vLinearVelocity.GetData()[k];
+        velocities[i * 6 + k] = state.m_vLinearVelocity.GetData()[k];
+        velocities[i * 6 + 3 + k] = state.m_vAngularVelocity.GetData()[k];
+      }
+
+      rotations[i * 4 + 0] = q.x;
+      rotations[i * 4 + 1] = q.y;
+      rotations[i * 4 + 2] = q.z;
+      rotations[i * 4 + 3] = q.w;
+    }
+
+    GroupFit group;
+    group.m_pFrames = frames.GetData();
+    group.m_pSeconds = seconds.GetData();
+    group.m_pForcedKeys = &forcedKeys;
+    group.m_pSleepEnds = sleepEnds.GetData();
+    group.m_uiMaxSegmentFrames = nsMath::Max(settings.m_uiMaxSegmentFrames, 2u);
+
+    {
+      group.m_uiComponents = 3;
+      group.m_pValues = positions.GetData();
+      group.m_pDerivatives = linearVelocities.GetData();
+
+      const float fToleranceSqr = nsMath::Square(settings.m_fPositionTolerance);
+      nsCurve1D* curves[] = {&out_body.m_Position[0], &out_body.m_Position[1], &out_body.m_Position[2]};
+
+      FitGroup(group, uiSampleCount, [&](const double* pValues, nsUInt32 s)
+        {
+          const nsVec3 vPosition(static_cast<float>(pValues[0]), static_cast<float>(pValues[1]), static_cast<float>(pValues[2]));
+          return (vPosition - samples.m_States[s].m_vPosition).GetLengthSquared() <= fToleranceSqr; },
+        curves);
+    }
+
+    {
+      group.m_uiComponents = 4;
+      group.m_pValues = rotations.GetData();
+      group.m_pDerivatives = nullptr;
+
+      // the angle between two rotations is 2 * acos(|dot|), compare sin^2 of the half angle to stay precise for small tolerances
+      const double fMaxSinSqr = nsMath::Square(static_cast<double>(nsMath::Sin(nsAngle::MakeFromRadian(settings.m_fRotationTolerance * 0.5f))));
+      const float* pRotations = rotations.GetData();
+      nsCurve1D* curves[] = {&out_body.m_Rotation[0], &out_body.m_Rotation[1], &out_body.m_Rotation[2], &out_body.m_Rotation[3]};
+
+      FitGroup(group, uiSampleCount, [&](const double* pValues, nsUInt32 s)
+        {
+          const double fLength = nsMath::Sqrt(pValues[0] * pValues[0] + pValues[1] * pValues[1] + pValues[2] * pValues[2] + pValues[3] * pValues[3]);
+          if (!(fLength > 0.0))
+            return false;
+
+          const float* pSample = pRotations + s * 4;
+          const double fDot = (pValues[0] * pSample[0] + pValues[1] * pSample[1] + pValues[2] * pSample[2] + pValues[3] * pSample[3]) / fLength;
+          return 1.0 - fDot * fDot <= fMaxSinSqr; },
+        curves);
+    }
+
+    {
+      group.m_uiComponents = 6;
+      group.m_pValues = velocities.GetData();
+      group.m_pDerivatives = nullptr;
+
+      const float fLinearToleranceSqr = nsMath::Square(settings.m_fLinearVelocityTolerance);
+      const float fAngularToleranceSqr = nsMath::Square(settings.m_fAngularVelocityTolerance);
+      nsCurve1D* curves[] = {&out_body.m_LinearVelocity[0], &out_body.m_LinearVelocity[1], &out_body.m_LinearVelocity[2], &out_body.m_AngularVelocity[0], &out_body.m_AngularVelocity[1], &out_body.m_AngularVelocity[2]};
+
+      FitGroup(group, uiSampleCount, [&](const double* pValues, nsUInt32 s)
+        {
+          const nsJvdBodyState& state = samples.m_States[s];
+          const nsVec3 vLinear(static_cast<float>(pValues[0]), static_cast<float>(pValues[1]), static_cast<float>(pValues[2]));
+          const nsVec3 vAngular(static_cast<float>(pValues[3]), static_cast<float>(pValues[4]), static_cast<float>(pValues[5]));
+          return (vLinear - state.m_vLinearVelocity).GetLengthSquared() <= fLinearToleranceSqr && (vAngular - state.m_vAngularVelocity).GetLengthSquared() <= fAngularToleranceSqr; },
+        curves);
+    }
+  }
+
+  /// Returns the span that contains the frame or nullptr. The spans must be sorted.
+  const nsJvdSimplifiedBody::Span* FindSpan(const nsDynamicArray<nsJvdSimplifiedBody::Span>& spans, nsUInt32 uiFrame)
+  {
+    nsUInt32 uiLow = 0;
+    nsUInt32 uiHigh = spans.GetCount();
+    while (uiLow < uiHigh)
+    {
+      const nsUInt32 uiMid = (uiLow + uiHigh) / 2;
+      if (spans[uiMid].m_uiLastFrame < uiFrame)
+        uiLow = uiMid + 1;
+      else
+        uiHigh = uiMid;
+    }
+
+    if (uiLow < spans.GetCount() && spans[uiLow].m_uiFirstFrame <= uiFrame)
+      return &spans[uiLow];
+
+    return nullptr;
+  }
+
+  nsResult WriteSpans(nsStreamWriter& inout_stream, const nsDynamicArray<nsJvdSimplifiedBody::Span>& spans)
+  {
+    const nsUInt32 uiCount = spans.GetCount();
+    NS_SUCCEED_OR_RETURN(inout_stream.WriteDWordValue(&uiCount));
+
+    for (const nsJvdSimplifiedBody::Span& span : spans)
+    {
+      NS_SUCCEED_OR_RETURN(inout_stream.WriteDWordValue(&span.m_uiFirstFrame));
+      NS_SUCCEED_OR_RETURN(inout_stream.WriteDWordValue(&span.m_uiLastFrame));
+    }
+
+    return NS_SUCCESS;
+  }
+
+  nsResult ReadSpans(nsStreamReader& inout_stream, nsDynamicArray<nsJvdSimplifiedBody::Span>& out_spans)
+  {
+    nsUInt32 uiCount = 0;
+    NS_SUCCEED_OR_RETURN(inout_stream.ReadDWordValue(&uiCount));
+
+    out_spans.SetCountUninitialized(uiCount);
+    for (nsJvdSimplifiedBody::Span& span : out_spans)
+    {
+      NS_SUCCEED_OR_RETURN(inout_stream.ReadDWordValue(&span.m_uiFirstFrame));
+      NS_SUCCEED_OR_RETURN(inout_stream.ReadDWordValue(&span.m_uiLastFrame));
+    }
+
+    return NS_SUCCESS;
+  }
+
+  nsResult WritePropertyChanges(nsStreamWriter& inout_stream, const nsDynamicArray<nsJvdSimplifiedBody::PropertyChange>& changes)
+  {
+    const nsUInt32 uiCount = changes.GetCount();
+    NS_SUCCEED_OR_RETURN(inout_stream.WriteDWordValue(&uiCount));
+
+    for (const nsJvdSimplifiedBody::PropertyChange& change : changes)
+    {
+      NS_SUCCEED_OR_RETURN(inout_stream.WriteDWordValue(&change.m_uiFrame));
+      inout_stream << change.m_vScale;
+      NS_SUCCEED_OR_RETURN(inout_stream.WriteDWordValue(&change.m_fFriction));
+      NS_SUCCEED_OR_RETURN(inout_stream.WriteDWordValue(&change.m_fRestitution));
+    }
+
+    return NS_SUCCESS;
+  }
+
+  nsResult ReadPropertyChanges(nsStreamReader& inout_stream, nsDynamicArray<nsJvdSimplifiedBody::PropertyChange>& out_changes)
+  {
+    nsUInt32 uiCount = 0;
+    NS_SUCCEED_OR_RETURN(inout_stream.ReadDWordValue(&uiCount));
+
+    out_changes.SetCountUninitialized(uiCount);
+    for (nsJvdSimplifiedBody::PropertyChange& change : out_changes)
+    {
+      NS_SUCCEED_OR_RETURN(inout_stream.ReadDWordValue(&change.m_uiFrame));
+      inout_stream >> change.m_vScale;
+      NS_SUCCEED_OR_RETURN(inout_stream.ReadDWordValue(&change.m_fFriction));
+      NS_SUCCEED_OR_RETURN(inout_stream.ReadDWordValue(&change.m_fRestitution));
+    }
+
+    return NS_SUCCESS;
+  }
+
+  nsResult WriteCurves(nsStreamWriter& inout_stream, const nsCurve1D* pCurves, nsUInt32 uiCount)
+  {
+    for (nsUInt32 i = 0; i < uiCount; ++i)
+    {
+      pCurves[i].Save(inout_stream);
+    }
+
+    return NS_SUCCESS;
+  }
+
+  nsResult ReadCurves(nsStreamReader& inout_stream, nsCurve1D* pCurves, nsUInt32 uiCount)
+  {
+    for (nsUInt32 i = 0; i < uiCount; ++i)
+    {
+      pCurves[i].Load(inout_stream);
+
+      if (pCurves[i].GetNumControlPoints() != pCurves[0].GetNumControlPoints())
+        return NS_FAILURE;
+
+      pCurves[i].RecomputeExtents();
+    }
+
+    return NS_SUCCESS;
+  }
+} // namespace
+
+bool nsJvdSimplifiedBody::IsPresent(nsUInt32 uiFrame) const
+{
+  return FindSpan(m_Present, uiFrame) != nullptr;
+}
+
+void nsJvdSimplifiedBody::Evaluate(nsUInt32 uiFrame, nsJvdBodyState& out_state) const
+{
+  const double fX = uiFrame;
+  double values[4];
+
+  out_state.m_uiBodyId = m_uiBodyId;
+
+  EvaluateGroup(m_Position, 3, fX, values);
+  out_state.m_vPosition.Set(static_cast<float>(values[0]), static_cast<float>(values[1]), static_cast<float>(values[2]));
+
+  EvaluateGroup(m_Rotation, 4, fX, values);
+  out_state.m_qRotation = nsQuat(static_cast<float>(values[0]), static_cast<float>(values[1]), static_cast<float>(values[2]), static_cast<float>(values[3]));
+  out_state.m_qRotation.Normalize();
+
+  EvaluateGroup(m_LinearVelocity, 3, fX, values);
+  out_state.m_vLinearVelocity.Set(static_cast<float>(values[0]), static_cast<float>(values[1]), static_cast<float>(values[2]));
+
+  EvaluateGroup(m_AngularVelocity, 3, fX, values);
+  out_state.m_vAngularVelocity.Set(static_cast<float>(values[0]), static_cast<float>(values[1]), static_cast<float>(values[2]));
+
+  // the last change at or before the frame
+  nsUInt32 uiLow = 0;
+  nsUInt32 uiHigh = m_PropertyChanges.GetCount();
+  while (uiLow + 1 < uiHigh)
+  {
+    const nsUInt32 uiMid = (uiLow + uiHigh) / 2;
+    if (m_PropertyChanges[uiMid].m_uiFrame <= uiFrame)
+      uiLow = uiMid;
+    else
+      uiHigh = uiMid;
+  }
+
+  if (!m_PropertyChanges.IsEmpty())
+  {
+    const PropertyChange& change = m_PropertyChanges[uiLow];
+    out_state.m_vScale = change.m_vScale;
+    out_state.m_fFriction = change.m_fFriction;
+    out_state.m_fRestitution = change.m_fRestitution;
+  }
+
+  out_state.m_bIsSleeping = FindSpan(m_Sleeping, uiFrame) != nullptr;
+  out_state.m_bWasTeleported = m_Teleported.Contains(uiFrame);
+}
+
+nsUInt32 nsJvdSimplifiedBody::GetKeyCount() const
+{
+  return m_Position[0].GetNumControlPoints() + m_Rotation[0].GetNumControlPoints() + m_LinearVelocity[0].GetNumControlPoints();
+}
+
+nsJvdSimplifiedClip::nsJvdSimplifiedClip() = default;
+nsJvdSimplifiedClip::~nsJvdSimplifiedClip() = default;
+
+void nsJvdSimplifiedClip::Clear()
+{
+  m_Metadata.Reset();
+  m_BodyMetadata.Clear();
+  m_Bookmarks.Clear();
+  m_FrameIndices.Clear();
+  m_Timestamps.Clear();
+  m_Bodies.Clear();
+  m_uiSampleCount = 0;
+}
+
+void nsJvdSimplifiedClip::Simplify(const nsJvdClip& clip, const nsJvdSimplificationSettings& settings)
+{
+  Clear();
+
+  m_Settings = settings;
+  m_Metadata = clip.GetMetadata();
+  m_Metadata.m_CustomChannels.Clear();
+  m_BodyMetadata = clip.GetBodyMetadata();
+  m_Bookmarks = clip.GetBookmarks();
+
+  const nsArrayPtr<const nsJvdFrame> frames = clip.GetFrames();
+  m_FrameIndices.SetCountUninitialized(frames.GetCount());
+  m_Timestamps.SetCount(frames.GetCount());
+
+  // transpose the frames into one sample array per body, found through the dense body indices of the clip
+  nsDynamicArray<nsUInt32> sampleSlots;
+  sampleSlots.SetCount(clip.GetBodyIndexMap().GetCount(), nsInvalidIndex);
+  nsDynamicArray<BodySamples> samples;
+
+  for (nsUInt32 f = 0; f < frames.GetCount(); ++f)
+  {
+    const nsJvdFrame& frame = frames[f];
+    m_FrameIndices[f] = frame.m_uiFrameIndex;
+    m_Timestamps[f] = frame.m_Timestamp;
+
+    for (const nsJvdBodyState& state : frame.m_Bodies)
+    {
+      const nsUInt32 uiBodyIndex = clip.GetBodyIndex(state);
+      NS_ASSERT_DEV(uiBodyIndex != nsInvalidIndex, "Body {} has no index, frames modified through GetFrames() need nsJvdClip::AssignBodyIndices()", state.m_uiBodyId);
+
+      nsUInt32& uiBody = sampleSlots[uiBodyIndex];
+      if (uiBody == nsInvalidIndex)
+      {
+        uiBody = samples.GetCount();
+        samples.ExpandAndGetRef().m_uiBodyId = state.m_uiBodyId;
+      }
+
+      BodySamples& body = samples[uiBody];
+
+      // a body that was added to a frame twice keeps its first state
+      if (!body.m_Frames.IsEmpty() && body.m_Frames.PeekBack() == f)
+        continue;
+
+      body.m_Frames.PushBack(f);
+      body.m_States.PushBack(state);
+      ++m_uiSampleCount;
+    }
+  }
+
+  m_Bodies.SetCount(samples.GetCount());
+
+  nsParallelForParams params;
+  params.m_uiBinSize = 1;
+
+  const BodySamples* pSamples = samples.GetData();
+  nsJvdSimplifiedBody* pBodies = m_Bodies.GetData();
+  nsTaskSystem::ParallelForIndexed(0u, samples.GetCount(), [this, pSamples, pBodies](nsUInt32 uiStart, nsUInt32 uiEnd)
+    {
+      for (nsUInt32 i = uiStart; i < uiEnd; ++i)
+      {
+        SimplifyBody(pSamples[i], m_Timestamps.GetData(), m_Settings, pBodies[i]);
+      }
+    },
+    "JVD Simplify", nsTaskNesting::Never, params);
+}
+
+nsUInt64 nsJvdSimplifiedClip::GetKeyCount() const
+{
+  nsUInt64 uiKeyCount = 0;
+  for (const nsJvdSimplifiedBody& body : m_Bodies)
+  {
+    uiKeyCount += body.GetKeyCount();
+  }
+  return uiKeyCount;
+}
+
+void nsJvdSimplifiedClip::ReconstructFrame(nsUInt32 uiFrame, nsJvdFrame& out_frame) const
+{
+  ReconstructFrame(uiFrame, {}, out_frame);
+}
+
+void nsJvdSimplifiedClip::ReconstructFrame(nsUInt32 uiFrame, nsArrayPtr<const nsUInt32> bodyIndices, nsJvdFrame& out_frame) const
+{
+  out_frame.m_uiFrameIndex = m_FrameIndices[uiFrame];
+  out_frame.m_Timestamp = m_Timestamps[uiFrame];
+  out_frame.m_Bodies.Clear();
+  out_frame.m_CustomChannels.Clear();
+
+  for (nsUInt32 b = 0; b < m_Bodies.GetCount(); ++b)
+  {
+    if (m_Bodies[b].IsPresent(uiFrame))
+    {
+      nsJvdBodyState& state = out_frame.m_Bodies.ExpandAndGetRef();
+      m_Bodies[b].Evaluate(uiFrame, state);
+
+      if (!bodyIndices.IsEmpty())
+      {
+        state.m_uiBodyIndex = bodyIndices[b];
+      }
+    }
+  }
+}
+
+void nsJvdSimplifiedClip::Reconstruct(nsJvdClip& out_clip) const
+{
+  out_clip.Clear();
+  out_clip.SetMetadata(m_Metadata);
+  out_clip.SetBodyMetadata(m_BodyMetadata);
+  out_clip.SetBookmarks(m_Bookmarks);
+
+  // the frames are filled in place, so the body indices are assigned upfront
+  nsDynamicArray<nsUInt32> bodyIndices;
+  bodyIndices.SetCountUninitialized(m_Bodies.GetCount());
+  for (nsUInt32 b = 0; b < m_Bodies.GetCount(); ++b)
+  {
+    bodyIndices[b] = out_clip.GetOrAddBodyIndex(m_Bodies[b].m_uiBodyId);
+  }
+
+  nsDynamicArray<nsJvdFrame>& frames = out_clip.GetFrames();
+  frames.SetCount(m_FrameIndices.GetCount());
+
+  nsJvdFrame* pFrames = frames.GetData();
+  const nsArrayPtr<const nsUInt32> indices = bodyIndices;
+  nsTaskSystem::ParallelForIndexed(0u, frames.GetCount(), [this, pFrames, indices](nsUInt32 uiStart, nsUInt32 uiEnd)
+    {
+      for (nsUInt32 i = uiStart; i < uiEnd; ++i)
+      {
+        ReconstructFrame(i, indices, pFrames[i]);
+      }
+    },
+    "JVD Reconstruct", nsTaskNesting::Never);
+
+  out_clip.UpdateTimelineSummary();
+}
+
+nsResult nsJvdSimplifiedClip::Save(nsStreamWriter& inout_stream) const
+{
+  // the embedded clip header may change with the .jvdrec format
+  nsUInt32 uiClipVersion = nsJvdSerialization::g_uiFormatVersion;
+  NS_SUCCEED_OR_RETURN(inout_stream.WriteDWordValue(&uiClipVersion));
+  NS_SUCCEED_OR_RETURN(nsJvdSerialization::WriteClipHeader(inout_stream, m_Metadata, m_BodyMetadata, m_Bookmarks, m_FrameIndices.GetCount()));
+
+  NS_SUCCEED_OR_RETURN(inout_stream.WriteArray(m_FrameIndices));
+
+  for (const nsTime& timestamp : m_Timestamps)
+  {
+    nsUInt64 uiMicroseconds = static_cast<nsUInt64>(timestamp.GetMicroseconds());
+    NS_SUCCEED_OR_RETURN(inout_stream.WriteQWordValue(&uiMicroseconds));
+  }
+
+  inout_stream << m_Settings.m_fPositionTolerance;
+  inout_stream << m_Settings.m_fRotationTolerance;
+  inout_stream << m_Settings.m_fLinearVelocityTolerance;
+  inout_stream << m_Settings.m_fAngularVelocityTolerance;
+  inout_stream << m_Settings.m_uiMaxSegmentFrames;
+  inout_stream << m_uiSampleCount;
+
+  const nsUInt32 uiBodyCount = m_Bodies.GetCount();
+  NS_SUCCEED_OR_RETURN(inout_stream.WriteDWordValue(&uiBodyCount));
+
+  for (const nsJvdSimplifiedBody& body : m_Bodies)
+  {
+    NS_SUCCEED_OR_RETURN(inout_stream.WriteQWordValue(&body.m_uiBodyId));
+    NS_SUCCEED_OR_RETURN(WriteSpans(inout_stream, body.m_Present));
+    NS_SUCCEED_OR_RETURN(WriteSpans(inout_stream, body.m_Sleeping));
+    NS_SUCCEED_OR_RETURN(inout_stream.WriteArray(body.m_Teleported));
+    NS_SUCCEED_OR_RETURN(WritePropertyChanges(inout_stream, body.m_PropertyChanges));
+
+    NS_SUCCEED_OR_RETURN(WriteCurves(inout_stream, body.m_Position, 3));
+    NS_SUCCEED_OR_RETURN(WriteCurves(inout_stream, body.m_Rotation, 4));
+    NS_SUCCEED_OR_RETURN(WriteCurves(inout_stream, body.m_LinearVelocity, 3));
+    NS_SUCCEED_OR_RETURN(WriteCurves(inout_stream, body.m_AngularVelocity, 3));
+  }
+
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdSimplifiedClip::Load(nsStreamReader& inout_stream)
+{
+  Clear();
+
+  nsUInt32 uiClipVersion = 0;
+  NS_SUCCEED_OR_RETURN(inout_stream.ReadDWordValue(&uiClipVersion));
+  if (uiClipVersion == 0 || uiClipVersion > nsJvdSerialization::g_uiFormatVersion)
+    return NS_FAILURE;
+
+  nsUInt64 uiFrameCount = 0;
+  NS_SUCCEED_OR_RETURN(nsJvdSerialization::ReadClipHeader(inout_stream, m_Metadata, m_BodyMetadata, m_Bookmarks, uiFrameCount, uiClipVersion));
+
+  NS_SUCCEED_OR_RETURN(inout_stream.ReadArray(m_FrameIndices));
+  if (m_FrameIndices.GetCount() != uiFrameCount)
+    return NS_FAILURE;
+
+  m_Timestamps.SetCount(m_FrameIndices.GetCount());
+  for (nsTime& timestamp : m_Timestamps)
+  {
+    nsUInt64 uiMicroseconds = 0;
+    NS_SUCCEED_OR_RETURN(inout_stream.ReadQWordValue(&uiMicroseconds));
+    timestamp = nsTime::MakeFromMicroseconds(static_cast<double>(uiMicroseconds));
+  }
+
+  inout_stream >> m_Settings.m_fPositionTolerance;
+  inout_stream >> m_Settings.m_fRotationTolerance;
+  inout_stream >> m_Settings.m_fLinearVelocityTolerance;
+  inout_stream >> m_Settings.m_fAngularVelocityTolerance;
+  inout_stream >> m_Settings.m_uiMaxSegmentFrames;
+  inout_stream >> m_uiSampleCount;
+
+  nsUInt32 uiBodyCount = 0;
+  NS_SUCCEED_OR_RETURN(inout_stream.ReadDWordValue(&uiBodyCount));
+
+  m_Bodies.SetCount(uiBodyCount);
+  for (nsJvdSimplifiedBody& body : m_Bodies)
+  {
+    NS_SUCCEED_OR_RETURN(inout_stream.ReadQWordValue(&body.m_uiBodyId));
+    NS_SUCCEED_OR_RETURN(ReadSpans(inout_stream, body.m_Present));
+    NS_SUCCEED_OR_RETURN(ReadSpans(inout_stream, body.m_Sleeping));
+    NS_SUCCEED_OR_RETURN(inout_stream.ReadArray(body.m_Teleported));
+    NS_SUCCEED_OR_RETURN(ReadPropertyChanges(inout_stream, body.m_PropertyChanges));
+
+    NS_SUCCEED_OR_RETURN(ReadCurves(inout_stream, body.m_Position, 3));
+    NS_SUCCEED_OR_RETURN(ReadCurves(inout_stream, body.m_Rotation, 4));
+    NS_SUCCEED_OR_RETURN(ReadCurves(inout_stream, body.m_LinearVelocity, 3));
+    NS_SUCCEED_OR_RETURN(ReadCurves(inout_stream, body.m_AngularVelocity, 3));
+
+    if (body.m_LinearVelocity[0].GetNumControlPoints() != body.m_AngularVelocity[0].GetNumControlPoints())
+      return NS_FAILURE;
+  }
+
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdSimplifiedClip::SaveToFile(nsStringView sFilePath, const nsJvdClipWriteSettings& settings) const
+{
+  nsFileWriter file;
+  if (file.Open(sFilePath).Failed())
+  {
+    nsLog::Error("Failed to open '{0}' for writing .jvdsim clip.", sFilePath);
+    return NS_FAILURE;
+  }
+
+  // the payload is stored as a single block in the layout of the .jvdrec frame blocks, so it is compressed the same way
+  nsDynamicArray<nsUInt8> payload;
+  {
+    nsMemoryStreamContainerWrapperStorage<nsDynamicArray<nsUInt8>> storage(&payload);
+    nsMemoryStreamWriter writer(&storage);
+
+    if (Save(writer).Failed())
+    {
+      nsLog::Error("Failed to serialize .jvdsim clip for '{0}'.", sFilePath);
+      return NS_FAILURE;
+    }
+  }
+
+  nsDynamicArray<nsUInt8> block;
+  if (nsJvdSerialization::EncodeBlock(payload, 1, settings, block).Failed())
+  {
+    nsLog::Error("Failed to compress .jvdsim clip for '{0}'.", sFilePath);
+    return NS_FAILURE;
+  }
+
+  nsUInt32 uiVersion = g_uiSimplifiedFormatVersion;
+  if (file.WriteBytes(g_szJvdSimMagic, sizeof(g_szJvdSimMagic)).Failed() ||
+      file.WriteDWordValue(&uiVersion).Failed() ||
+      file.WriteBytes(block.GetData(), block.GetCount()).Failed())
+  {
+    nsLog::Error("Failed to write .jvdsim clip to '{0}'.", sFilePath);
+    return NS_FAILURE;
+  }
+
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdSimplifiedClip::LoadFromFile(nsStringView sFilePath)
+{
+  Clear();
+
+  nsFileReader file;
+  if (file.Open(sFilePath).Failed())
+  {
+    nsLog::Error("Failed to open '{0}' for reading .jvdsim clip.", sFilePath);
+    return NS_FAILURE;
+  }
+
+  nsUInt8 header[sizeof(g_szJvdSimMagic)] = {};
+  nsUInt32 uiVersion = 0;
+  if (file.ReadBytes(header, sizeof(header)) != sizeof(header) || !nsMemoryUtils::IsEqual(header, g_szJvdSimMagic, sizeof(g_szJvdSimMagic)))
+  {
+    nsLog::Error("File '{0}' has invalid .jvdsim header.", sFilePath);
+    return NS_FAILURE;
+  }
+
+  if (file.ReadDWordValue(&uiVersion).Failed() || uiVersion == 0 || uiVersion > g_uiSimplifiedFormatVersion)
+  {
+    nsLog::Error("Unsupported .jvdsim version {0} in '{1}'.", uiVersion, sFilePath);
+    return NS_FAILURE;
+  }
+
+  nsUInt32 uiBlockCount = 0;
+  nsDynamicArray<nsUInt8> payload;
+  if (nsJvdSerialization::ReadFrameBlock(file, uiBlockCount, payload).Failed() || uiBlockCount != 1)
+  {
+    nsLog::Error("Failed to read .jvdsim payload from '{0}'.", sFilePath);
+    return NS_FAILURE;
+  }
+
+  nsRawMemoryStreamReader reader(payload);
+  if (Load(reader).Failed())
+  {
+    nsLog::Error("Failed to deserialize .jvdsim clip from '{0}'.", sFilePath);
+    Clear();
+    return NS_FAILURE;
+  }
+
+  return NS_SUCCESS;
+}
+
+bool nsJvdSimplifiedClip::IsSimplifiedClipFile(nsStringView sFilePath)
+{
+  nsFileReader file;
+  if (file.Open(sFilePath).Failed())
+    return false;
+
+  nsUInt8 header[sizeof(g_szJvdSimMagic)] = {};
+  return file.ReadBytes(header, sizeof(header)) == sizeof(header) && nsMemoryUtils::IsEqual(header, g_szJvdSimMagic, sizeof(g_szJvdSimMagic));
+}
+
+NS_STATICLINK_FILE(JVDSDK, Serialization_JvdClipSimplification);
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <JVDSDK/Serialization/JvdStreamSerializer.h>
+
+#include <Foundation/Tracks/Curve1D.h>
+
+struct NS_JVDSDK_DLL nsJvdSimplificationSettings
+{
+  float m_fPositionTolerance = 1e-3f;        ///< Maximum distance (in meters) between a recorded and a reconstructed position.
+  float m_fRotationTolerance = 1e-3f;        ///< Maximum angle (in radians) between a recorded and a reconstructed rotation.
+  float m_fLinearVelocityTolerance = 1e-2f;  ///< m/s
+  float m_fAngularVelocityTolerance = 1e-2f; ///< rad/s
+
+  /// Longer segments are split. Bounds the cost of fitting, which is quadratic in the segment length.
+  nsUInt32 m_uiMaxSegmentFrames = 256;
+};
+
+/// \brief The states of one body in an nsJvdSimplifiedClip.
+///
+/// Frames are addressed by their position in the clip. Each curve has one control point per key at x = frame position.
+/// Position, rotation and velocity have separate keys, the components of one group share them. Segments between two keys
+/// are linear or, for positions, Hermite splines through the recorded velocities.
+struct NS_JVDSDK_DLL nsJvdSimplifiedBody
+{
+  /// \brief A range of consecutive frames, both ends inclusive.
+  struct Span
+  {
+    NS_DECLARE_POD_TYPE();
+
+    nsUInt32 m_uiFirstFrame;
+    nsUInt32 m_uiLastFrame;
+  };
+
+  struct PropertyChange
+  {
+    NS_DECLARE_POD_TYPE();
+
+    nsUInt32 m_uiFrame;
+    nsVec3 m_vScale;
+    float m_fFriction;
+    float m_fRestitution;
+  };
+
+  nsUInt64 m_uiBodyId = 0;
+  nsDynamicArray<Span> m_Present;  ///< The frames in which the body was recorded.
+  nsDynamicArray<Span> m_Sleeping; ///< Keys are placed at both ends, so the body is exactly constant in between.
+  nsDynamicArray<nsUInt32> m_Teleported;
+  nsDynamicArray<PropertyChange> m_PropertyChanges; ///< Scale and material, which rarely change, are stored as steps.
+
+  nsCurve1D m_Position[3];
+  nsCurve1D m_Rotation[4]; ///< Normalized after interpolation.
+  nsCurve1D m_LinearVelocity[3];
+  nsCurve1D m_AngularVelocity[3];
+
+  bool IsPresent(nsUInt32 uiFrame) const;
+
+  /// \brief Reconstructs the state in a frame in which the body is present.
+  void Evaluate(nsUInt32 uiFrame, nsJvdBodyState& out_state) const;
+
+  /// \brief The number of keys of all three groups.
+  nsUInt32 GetKeyCount() const;
+};
+
+/// \brief Lossy archival form of a clip that replaces the per-frame body states with piecewise curves.
+///
+/// Every reconstructed position, rotation and velocity is within the tolerances of the settings. The segments are
+/// evaluated exactly, not through the linear approximation of nsCurve1D. Custom channels are not kept.
+/// nsJvdSerialization::LoadClipFromFile() reconstructs .jvdsim files transparently.
+class NS_JVDSDK_DLL nsJvdSimplifiedClip
+{
+public:
+  nsJvdSimplifiedClip();
+  ~nsJvdSimplifiedClip();
+
+  void Clear();
+
+  /// \brief Fits the curves of all bodies of the clip, in parallel across bodies.
+  void Simplify(const nsJvdClip& clip, const nsJvdSimplificationSettings& settings = nsJvdSimplificationSettings());
+
+  const nsJvdSimplificationSettings& GetSettings() const { return m_Settings; }
+  const nsJvdClipMetadata& GetMetadata() const { return m_Metadata; }
+  const nsDynamicArray<nsJvdSimplifiedBody>& GetBodies() const { return m_Bodies; }
+
+  nsUInt32 GetFrameCount() const { return m_FrameIndices.GetCount(); }
+
+  /// \brief How many body states the source clip had, to compare against GetKeyCount().
+  nsUInt64 GetSampleCount() const { return m_uiSampleCount; }
+  nsUInt64 GetKeyCount() const;
+
+  /// \brief Reconstructs one frame. The bodies are ordered by their first appearance in the clip.
+  void ReconstructFrame(nsUInt32 uiFrame, nsJvdFrame& out_frame) const;
+
+  /// \brief Reconstructs all frames in parallel.
+  void Reconstruct(nsJvdClip& out_clip) const;
+
+  nsResult Save(nsStreamWriter& inout_stream) const;
+  nsResult Load(nsStreamReader& inout_stream);
+
+  /// \brief Only the compression of the settings is used.
+  nsResult SaveToFile(nsStringView sFilePath, const nsJvdClipWriteSettings& settings = nsJvdClipWriteSettings()) const;
+  nsResult LoadFromFile(nsStringView sFilePath);
+
+  /// \brief Checks the file header, without logging errors.
+  static bool IsSimplifiedClipFile(nsStringView sFilePath);
+
+private:
+  /// bodyIndices maps the positions in m_Bodies to the body indices of the target clip, may be empty.
+  void ReconstructFrame(nsUInt32 uiFrame, nsArrayPtr<const nsUInt32> bodyIndices, nsJvdFrame& out_frame) const;
+
+  nsJvdSimplificationSettings m_Settings;
+  nsJvdClipMetadata m_Metadata;
+  nsDynamicArray<nsJvdBodyMetadata> m_BodyMetadata;
+  nsDynamicArray<nsJvdBookmark> m_Bookmarks;
+  nsDynamicArray<nsUInt64> m_FrameIndices;
+  nsDynamicArray<nsTime> m_Timestamps;
+  nsDynamicArray<nsJvdSimplifiedBody> m_Bodies;
+  nsUInt64 m_uiSampleCount = 0;
+};
@@ -1,85 +1,1004 @@
 #include <JVDSDK/JVDSDKPCH.h>
 
+#include <JVDSDK/Serialization/JvdClipSimplification.h>
 #include <JVDSDK/Serialization/JvdFileIO.h>
 #include <JVDSDK/Serialization/JvdStreamSerializer.h>
 
 #include <Foundation/IO/FileSystem/FileReader.h>
+#include <Foundation/IO/FileSystem/FileSystem.h>
 #include <Foundation/IO/FileSystem/FileWriter.h>
 #include <Foundation/Logging/Log.h>
 #include <Foundation/Memory/MemoryUtils.h>
+#include <Foundation/Strings/PathUtils.h>
+#include <Foundation/Utilities/Progress.h>
 
 namespace
 {
   constexpr nsUInt8 g_szJvdMagic[] = {'J', 'V', 'D', 'R', 'E', 'C'};
-  constexpr nsUInt32 g_uiJvdVersion = 1;
+  constexpr nsUInt8 g_szJvdSessionMagic[] = {'J', 'V', 'D', 'S', 'E', 'S'};
+
+  /// More tracks than any session records, the count comes from the file and sizes an array before anything else is read.
+  constexpr nsUInt32 g_uiMaxSessionTracks = 4096;
+
+  /// Precedes every frame block of a session file, the end of the blocks is marked with nsInvalidIndex.
+  using SessionTrackIndex = nsUInt32;
+
+  struct SessionBlock
+  {
+    nsUInt32 m_uiTrack = 0;
+    nsUInt32 m_uiFirstFrame = 0;
+    nsUInt32 m_uiFrameCount = 0;
+    nsTime m_FirstTimestamp;
+    nsDynamicArray<nsUInt8> m_Data;
+  };
+
+  /// Reads the magic and the version that start every .jvdrec file and logs what is wrong with them.
+  nsResult ReadClipFileVersion(nsStreamReader& stream, nsStringView sFilePath, nsUInt32& out_uiVersion)
+  {
+    nsUInt8 header[sizeof(g_szJvdMagic)] = {};
+    if (stream.ReadBytes(header, sizeof(header)) != sizeof(header))
+    {
+      nsLog::Error("File '{0}' is too small to be a valid .jvdrec.", sFilePath);
+      return NS_FAILURE;
+    }
+
+    if (!nsMemoryUtils::IsEqual(header, g_szJvdMagic, sizeof(g_szJvdMagic)))
+    {
+      nsLog::Error("File '{0}' has invalid .jvdrec header.", sFilePath);
+      return NS_FAILURE;
+    }
+
+    if (stream.ReadDWordValue(&out_uiVersion).Failed())
+    {
+      nsLog::Error("File '{0}' missing version information.", sFilePath);
+      return NS_FAILURE;
+    }
+
+    if (out_uiVersion == 0 || out_uiVersion > nsJvdSerialization::g_uiFormatVersion)
+    {
+      nsLog::Error("File '{0}' uses .jvdrec version {1}, only versions up to {2} are supported.", sFilePath, out_uiVersion, nsJvdSerialization::g_uiFormatVersion);
+      return NS_FAILURE;
+    }
+
+    return NS_SUCCESS;
+  }
+} // namespace
+
+nsResult nsJvdSerialization::SaveClipToFile(nsStringView sFilePath, const nsJvdClip& clip, const nsJvdClipWriteSettings& settings)
+{
+  nsJvdClipWriter writer;
+  if (writer.Open(sFilePath, clip.GetMetadata(), clip.GetBodyMetadata(), clip.GetBookmarks(), settings, clip.GetFrames().GetCount()).Failed())
+    return NS_FAILURE;
+
+  writer.SetProfiling(clip.GetProfiling());
+
+  for (const nsJvdFrame& frame : clip.GetFrames())
+  {
+    if (writer.WriteFrame(frame).Failed())
+      break;
+  }
+
+  return writer.Close();
+}
+
+nsResult nsJvdSerialization::LoadClipFromFile(nsStringView sFilePath, nsJvdClip& outClip)
+{
+  outClip.Clear();
+
+  if (IsSessionFile(sFilePath))
+  {
+    nsLog::Error("'{0}' is a recording session with several tracks, load it with nsJvdSerialization::LoadSessionFromFile().", sFilePath);
+    return NS_FAILURE;
+  }
+
+  if (nsJvdSimplifiedClip::IsSimplifiedClipFile(sFilePath))
+  {
+    nsJvdSimplifiedClip simplifiedClip;
+    if (simplifiedClip.LoadFromFile(sFilePath).Failed())
+      return NS_FAILURE;
+
+    simplifiedClip.Reconstruct(outClip);
+    return NS_SUCCESS;
+  }
+
+  nsJvdClipReader reader;
+  if (reader.Open(sFilePath).Failed())
+    return NS_FAILURE;
+
+  outClip.SetMetadata(reader.GetMetadata());
+  outClip.SetBodyMetadata(reader.GetBodyMetadata());
+  outClip.SetBookmarks(reader.GetBookmarks());
+
+  if (reader.GetFrameCount() != nsJvdSerialization::g_uiUnknownFrameCount)
+  {
+    outClip.GetFrames().Reserve(static_cast<nsUInt32>(nsMath::Min<nsUInt64>(reader.GetFrameCount(), 1024 * 1024)));
+  }
+
+  while (reader.HasMoreFrames())
+  {
+    nsJvdFrame frame;
+    if (reader.ReadNextFrame(frame).Failed())
+    {
+      nsLog::Error("Failed to deserialize clip from '{0}'.", sFilePath);
+      return NS_FAILURE;
+    }
+
+    outClip.AddFrame(std::move(frame), false);
+  }
+
+  outClip.GetProfiling() = reader.GetProfiling();
+  outClip.UpdateTimelineSummary();
+  return NS_SUCCESS;
 }
 
-nsResult nsJvdSerialization::SaveClipToFile(nsStringView sFilePath, const nsJvdClip& clip)
+nsResult nsJvdSerialization::SaveSessionToFile(nsStringView sFilePath, nsArrayPtr<const nsJvdClip> tracks, const nsJvdClipWriteSettings& settings)
 {
+  const nsUInt32 uiFramesPerBlock = nsMath::Max(settings.m_uiFramesPerBlock, 1u);
+
+  nsDynamicArray<SessionBlock> blocks;
+  for (nsUInt32 uiTrack = 0; uiTrack < tracks.GetCount(); ++uiTrack)
+  {
+    const nsDynamicArray<nsJvdFrame>& frames = tracks[uiTrack].GetFrames();
+    for (nsUInt32 uiFirstFrame = 0; uiFirstFrame < frames.GetCount(); uiFirstFrame += uiFramesPerBlock)
+    {
+      SessionBlock& block = blocks.ExpandAndGetRef();
+      block.m_uiTrack = uiTrack;
+      block.m_uiFirstFrame = uiFirstFrame;
+      block.m_uiFrameCount = nsMath::Min(uiFramesPerBlock, frames.GetCount() - uiFirstFrame);
+      block.m_FirstTimestamp = frames[uiFirstFrame].m_Timestamp;
+    }
+  }
+
+  // the tracks share one clock, ordering the blocks by time keeps the file readable as one stream
+  blocks.Sort([](const SessionBlock& a, const SessionBlock& b)
+    {
+      if (a.m_FirstTimestamp != b.m_FirstTimestamp)
+        return a.m_FirstTimestamp < b.m_FirstTimestamp;
+      return a.m_uiTrack < b.m_uiTrack; });
+
+  nsAtomicBool bEncodingFailed = false;
+
+  nsParallelForParams params;
+  params.m_uiBinSize = 1;
+
+  SessionBlock* pBlocks = blocks.GetData();
+  nsTaskSystem::ParallelForIndexed(0u, blocks.GetCount(), [pBlocks, tracks, &settings, &bEncodingFailed](nsUInt32 uiStart, nsUInt32 uiEnd)
+    {
+      for (nsUInt32 i = uiStart; i < uiEnd; ++i)
+      {
+        SessionBlock& block = pBlocks[i];
+        const nsArrayPtr<const nsJvdFrame> frames = tracks[block.m_uiTrack].GetFrames().GetArrayPtr().GetSubArray(block.m_uiFirstFrame, block.m_uiFrameCount);
+        if (nsJvdSerialization::EncodeFrameBlock(frames, settings, block.m_Data).Failed())
+        {
+          bEncodingFailed = true;
+        }
+      }
+    },
+    "JVD Session Blocks", nsTaskNesting::Never, params);
+
+  if (bEncodingFailed)
+  {
+    nsLog::Error("Failed to encode the frames of session '{0}'.", sFilePath);
+    return NS_FAILURE;
+  }
+
   nsFileWriter file;
   if (file.Open(sFilePath).Failed())
   {
-    nsLog::Error("Failed to open '{0}' for writing .jvdrec clip.", sFilePath);
+    nsLog::Error("Failed to open '{0}' for writing .jvdses session.", sFilePath);
     return NS_FAILURE;
   }
 
-  if (file.WriteBytes(g_szJvdMagic, sizeof(g_szJvdMagic)).Failed())
+  const nsUInt32 uiVersion = g_uiFormatVersion;
+  const nsUInt32 uiTrackCount = tracks.GetCount();
+  if (file.WriteBytes(g_szJvdSessionMagic, sizeof(g_szJvdSessionMagic)).Failed() || file.WriteDWordValue(&uiVersion).Failed() || file.WriteDWordValue(&uiTrackCount).Failed())
+  {
+    nsLog::Error("Failed to serialize session to '{0}'.", sFilePath);
     return NS_FAILURE;
+  }
 
-  nsUInt32 uiVersion = g_uiJvdVersion;
-  if (file.WriteDWordValue(&uiVersion).Failed())
+  for (const nsJvdClip& track : tracks)
+  {
+    if (WriteClipHeader(file, track.GetMetadata(), track.GetBodyMetadata(), track.GetBookmarks(), track.GetFrames().GetCount()).Failed())
+    {
+      nsLog::Error("Failed to serialize session to '{0}'.", sFilePath);
+      return NS_FAILURE;
+    }
+  }
+
+  for (const SessionBlock& block : blocks)
+  {
+    const SessionTrackIndex uiTrack = block.m_uiTrack;
+    if (file.WriteDWordValue(&uiTrack).Failed() || file.WriteBytes(block.m_Data.GetData(), block.m_Data.GetCount()).Failed())
+    {
+      nsLog::Error("Failed to serialize session to '{0}'.", sFilePath);
+      return NS_FAILURE;
+    }
+  }
+
+  const SessionTrackIndex uiEndOfBlocks = nsInvalidIndex;
+  if (file.WriteDWordValue(&uiEndOfBlocks).Failed())
+  {
+    nsLog::Error("Failed to serialize session to '{0}'.", sFilePath);
     return NS_FAILURE;
+  }
 
-  if (WriteClip(file, clip).Failed())
+  for (const nsJvdClip& track : tracks)
   {
-    nsLog::Error("Failed to serialize clip to '{0}'.", sFilePath);
+    if (WriteProfilingData(file, track.GetProfiling()).Failed())
+    {
+      nsLog::Error("Failed to serialize session to '{0}'.", sFilePath);
+      return NS_FAILURE;
+    }
+  }
+
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdSerialization::LoadSessionFromFile(nsStringView sFilePath, nsDynamicArray<nsJvdClip>& out_tracks)
+{
+  out_tracks.Clear();
+
+  nsFileReader file;
+  if (file.Open(sFilePath).Failed())
+  {
+    nsLog::Error("Failed to open '{0}' for reading .jvdses session.", sFilePath);
+    return NS_FAILURE;
+  }
+
+  nsUInt8 header[sizeof(g_szJvdSessionMagic)] = {};
+  if (file.ReadBytes(header, sizeof(header)) != sizeof(header) || !nsMemoryUtils::IsEqual(header, g_szJvdSessionMagic, sizeof(g_szJvdSessionMagic)))
+  {
+    nsLog::Error("File '{0}' has invalid .jvdses header.", sFilePath);
+    return NS_FAILURE;
+  }
+
+  nsUInt32 uiVersion = 0;
+  nsUInt32 uiTrackCount = 0;
+  if (file.ReadDWordValue(&uiVersion).Failed() || file.ReadDWordValue(&uiTrackCount).Failed())
+  {
+    nsLog::Error("File '{0}' missing version information.", sFilePath);
+    return NS_FAILURE;
+  }
+
+  // sessions were introduced with version 6
+  if (uiVersion < 6 || uiVersion > g_uiFormatVersion)
+  {
+    nsLog::Error("File '{0}' uses .jvdses version {1}, only versions 6 to {2} are supported.", sFilePath, uiVersion, g_uiFormatVersion);
     return NS_FAILURE;
   }
 
-  file.Flush().IgnoreResult();
+  // every track header ends with its 8 byte frame count, a count that doesn't fit into the file is broken
+  const nsUInt64 uiRemainingBytes = file.GetFileSize() - sizeof(g_szJvdSessionMagic) - 2 * sizeof(nsUInt32);
+  if (uiTrackCount > g_uiMaxSessionTracks || uiTrackCount > uiRemainingBytes / sizeof(nsUInt64))
+  {
+    nsLog::Error("Session '{0}' claims an invalid number of tracks ({1}).", sFilePath, uiTrackCount);
+    return NS_FAILURE;
+  }
+
+  out_tracks.SetCount(uiTrackCount);
+  for (nsJvdClip& track : out_tracks)
+  {
+    nsJvdClipMetadata metadata;
+    nsDynamicArray<nsJvdBodyMetadata> bodies;
+    nsDynamicArray<nsJvdBookmark> bookmarks;
+    nsUInt64 uiFrameCount = 0;
+    if (ReadClipHeader(file, metadata, bodies, bookmarks, uiFrameCount, uiVersion).Failed())
+    {
+      nsLog::Error("Failed to deserialize session from '{0}'.", sFilePath);
+      return NS_FAILURE;
+    }
+
+    track.SetMetadata(metadata);
+    track.SetBodyMetadata(bodies);
+    track.SetBookmarks(bookmarks);
+    track.GetFrames().Reserve(static_cast<nsUInt32>(nsMath::Min<nsUInt64>(uiFrameCount, 1024 * 1024)));
+  }
+
+  nsDynamicArray<nsUInt8> blockData;
+  nsJvdBodyIndexMap blockBodies;
+
+  while (true)
+  {
+    SessionTrackIndex uiTrack = 0;
+    if (file.ReadDWordValue(&uiTrack).Failed())
+    {
+      nsLog::Error("Session '{0}' is truncated.", sFilePath);
+      return NS_FAILURE;
+    }
+
+    if (uiTrack == nsInvalidIndex)
+      break;
+
+    nsUInt32 uiFrameCount = 0;
+    if (uiTrack >= uiTrackCount || ReadFrameBlock(file, uiFrameCount, blockData).Failed())
+    {
+      nsLog::Error("Failed to read frame block of session '{0}'.", sFilePath);
+      return NS_FAILURE;
+    }
+
+    nsRawMemoryStreamReader blockReader(blockData);
+    blockBodies.Clear();
+
+    for (nsUInt32 i = 0; i < uiFrameCount; ++i)
+    {
+      nsJvdFrame frame;
+      if (ReadFrame(blockReader, frame, uiVersion, &blockBodies).Failed())
+      {
+        nsLog::Error("Failed to deserialize session from '{0}'.", sFilePath);
+        return NS_FAILURE;
+      }
+
+      out_tracks[uiTrack].AddFrame(std::move(frame), false);
+    }
+  }
+
+  for (nsJvdClip& track : out_tracks)
+  {
+    if (uiVersion >= 7 && ReadProfilingData(file, track.GetProfiling()).Failed())
+    {
+      nsLog::Error("Failed to read the profiling data of session '{0}'.", sFilePath);
+      return NS_FAILURE;
+    }
+
+    track.UpdateTimelineSummary();
+  }
+
   return NS_SUCCESS;
 }
 
-nsResult nsJvdSerialization::LoadClipFromFile(nsStringView sFilePath, nsJvdClip& outClip)
+bool nsJvdSerialization::IsSessionFile(nsStringView sFilePath)
 {
   nsFileReader file;
   if (file.Open(sFilePath).Failed())
+    return false;
+
+  nsUInt8 header[sizeof(g_szJvdSessionMagic)] = {};
+  return file.ReadBytes(header, sizeof(header)) == sizeof(header) && nsMemoryUtils::IsEqual(header, g_szJvdSessionMagic, sizeof(g_szJvdSessionMagic));
+}
+
+nsJvdClipReader::nsJvdClipReader() = default;
+nsJvdClipReader::~nsJvdClipReader() = default;
+
+nsResult nsJvdClipReader::Open(nsStringView sFilePath, nsUInt32 uiCacheSize)
+{
+  Close();
+
+  if (m_File.Open(sFilePath, uiCacheSize).Failed())
   {
     nsLog::Error("Failed to open '{0}' for reading .jvdrec clip.", sFilePath);
     return NS_FAILURE;
   }
 
-  nsUInt8 header[sizeof(g_szJvdMagic)] = {};
-  if (file.ReadBytes(header, sizeof(header)) != sizeof(header))
+  m_sFilePath = sFilePath;
+
+  if (ReadClipFileVersion(m_File, sFilePath, m_uiVersion).Failed())
   {
-    nsLog::Error("File '{0}' is too small to be a valid .jvdrec.", sFilePath);
+    Close();
     return NS_FAILURE;
   }
 
-  if (!nsMemoryUtils::IsEqual(header, g_szJvdMagic, sizeof(g_szJvdMagic)))
+  if (nsJvdSerialization::ReadClipHeader(m_File, m_Metadata, m_BodyMetadata, m_Bookmarks, m_uiFrameCount, m_uiVersion).Failed())
   {
-    nsLog::Error("File '{0}' has invalid .jvdrec header.", sFilePath);
+    nsLog::Error("Failed to deserialize clip from '{0}'.", sFilePath);
+    Close();
     return NS_FAILURE;
   }
 
-  nsUInt32 uiVersion = 0;
-  if (file.ReadDWordValue(&uiVersion).Failed())
+  if (m_uiVersion >= 5 && ReadNextBlock().Failed())
   {
-    nsLog::Error("File '{0}' missing version information.", sFilePath);
+    Close();
     return NS_FAILURE;
   }
 
-  if (uiVersion != g_uiJvdVersion)
+  return NS_SUCCESS;
+}
+
+void nsJvdClipReader::Close()
+{
+  m_File.Close();
+  m_sFilePath.Clear();
+  m_uiVersion = 0;
+  m_Metadata.Reset();
+  m_BodyMetadata.Clear();
+  m_Bookmarks.Clear();
+  m_Profiling.Clear();
+  m_uiFrameCount = 0;
+  m_uiFramesRead = 0;
+  m_uiUncompressedBytesRead = 0;
+  m_BlockData.Clear();
+  m_BlockReader.Reset(nullptr, 0);
+  m_BlockBodies.Clear();
+  m_uiBlockFramesLeft = 0;
+}
+
+nsResult nsJvdClipReader::ReadNextBlock()
+{
+  if (nsJvdSerialization::ReadFrameBlock(m_File, m_uiBlockFramesLeft, m_BlockData).Failed())
   {
-    nsLog::Warning("Loading .jvdrec version {0}, expected {1}. Attempting to continue.", uiVersion, g_uiJvdVersion);
+    nsLog::Error("Failed to read frame block after frame {0} of '{1}'.", m_uiFramesRead, m_sFilePath);
+    m_uiBlockFramesLeft = 0;
+    return NS_FAILURE;
   }
 
-  if (ReadClip(file, outClip).Failed())
+  m_BlockReader.Reset(m_BlockData);
+  m_BlockBodies.Clear();
+  m_uiUncompressedBytesRead += m_BlockData.GetCount();
+
+  if (m_uiBlockFramesLeft == 0 && m_uiVersion >= 7 && nsJvdSerialization::ReadProfilingData(m_File, m_Profiling).Failed())
   {
-    nsLog::Error("Failed to deserialize clip from '{0}'.", sFilePath);
+    // the frames are complete, only the side-channel is lost
+    nsLog::Warning("Failed to read the profiling data of '{0}'.", m_sFilePath);
+    m_Profiling.Clear();
+  }
+
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdClipReader::ReadNextFrame(nsJvdFrame& out_frame)
+{
+  if (!HasMoreFrames())
+    return NS_FAILURE;
+
+  if (m_uiVersion >= 5)
+  {
+    if (nsJvdSerialization::ReadFrame(m_BlockReader, out_frame, m_uiVersion, &m_BlockBodies).Failed())
+    {
+      nsLog::Error("Failed to read frame {0} of '{1}'.", m_uiFramesRead, m_sFilePath);
+      m_uiBlockFramesLeft = 0;
+      return NS_FAILURE;
+    }
+
+    ++m_uiFramesRead;
+
+    if (--m_uiBlockFramesLeft == 0)
+    {
+      // the frame itself is fine, a broken next block only ends the clip early
+      ReadNextBlock().IgnoreResult();
+    }
+
+    return NS_SUCCESS;
+  }
+
+  if (nsJvdSerialization::ReadFrame(m_File, out_frame, m_uiVersion).Failed())
+  {
+    nsLog::Error("Failed to read frame {0} of '{1}'.", m_uiFramesRead, m_sFilePath);
+
+    // a truncated file has no more frames to offer
+    m_uiFrameCount = m_uiFramesRead;
+    return NS_FAILURE;
+  }
+
+  ++m_uiFramesRead;
+  return NS_SUCCESS;
+}
+
+class nsJvdFrameBlockTask final : public nsTask
+{
+public:
+  nsDynamicArray<nsJvdFrame> m_Frames;
+  nsJvdClipWriteSettings m_Settings;
+
+  nsDynamicArray<nsUInt8> m_Block;
+  nsResult m_Result = NS_FAILURE;
+
+private:
+  virtual void Execute() override
+  {
+    m_Result = nsJvdSerialization::EncodeFrameBlock(m_Frames, m_Settings, m_Block);
+
+    // the frames are not needed anymore, free them before the block is written
+    m_Frames.Clear();
+    m_Frames.Compact();
+  }
+};
+
+nsJvdClipWriter::nsJvdClipWriter() = default;
+
+nsJvdClipWriter::~nsJvdClipWriter()
+{
+  Close().IgnoreResult();
+}
+
+nsResult nsJvdClipWriter::Open(nsStringView sFilePath, const nsJvdClipMetadata& metadata, nsArrayPtr<const nsJvdBodyMetadata> bodies, nsArrayPtr<const nsJvdBookmark> bookmarks, const nsJvdClipWriteSettings& settings, nsUInt64 uiFrameCount)
+{
+  Close().IgnoreResult();
+
+  if (m_File.Open(sFilePath).Failed())
+  {
+    nsLog::Error("Failed to open '{0}' for writing .jvdrec clip.", sFilePath);
+    return NS_FAILURE;
+  }
+
+  m_sFilePath = sFilePath;
+  m_Settings = settings;
+  m_Settings.m_uiFramesPerBlock = nsMath::Max(m_Settings.m_uiFramesPerBlock, 1u);
+  m_Settings.m_uiMaxBlocksInFlight = nsMath::Max(m_Settings.m_uiMaxBlocksInFlight, 1u);
+  m_uiExpectedFrameCount = uiFrameCount;
+  m_uiFramesWritten = 0;
+  m_bFailed = false;
+
+  const nsUInt32 uiVersion = nsJvdSerialization::g_uiFormatVersion;
+  if (m_File.WriteBytes(g_szJvdMagic, sizeof(g_szJvdMagic)).Failed() ||
+      m_File.WriteDWordValue(&uiVersion).Failed() ||
+      nsJvdSerialization::WriteClipHeader(m_File, metadata, bodies, bookmarks, uiFrameCount).Failed())
+  {
+    nsLog::Error("Failed to serialize clip to '{0}'.", sFilePath);
+    m_File.Close();
+    return NS_FAILURE;
+  }
+
+  m_BlockFrames.Reserve(m_Settings.m_uiFramesPerBlock);
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdClipWriter::WriteFrame(const nsJvdFrame& frame)
+{
+  return WriteFrame(nsJvdFrame(frame));
+}
+
+nsResult nsJvdClipWriter::WriteFrame(nsJvdFrame&& frame)
+{
+  if (!IsOpen() || m_bFailed)
+    return NS_FAILURE;
+
+  m_BlockFrames.PushBack(std::move(frame));
+  ++m_uiFramesWritten;
+
+  if (m_BlockFrames.GetCount() >= m_Settings.m_uiFramesPerBlock)
+  {
+    SubmitBlock();
+  }
+
+  return m_bFailed ? NS_FAILURE : NS_SUCCESS;
+}
+
+nsResult nsJvdClipWriter::Close()
+{
+  if (!IsOpen())
+    return NS_SUCCESS;
+
+  if (!m_BlockFrames.IsEmpty())
+  {
+    SubmitBlock();
+  }
+
+  while (!m_PendingBlocks.IsEmpty())
+  {
+    WriteOldestBlock();
+  }
+
+  if (!m_bFailed && (nsJvdSerialization::WriteEndOfFrames(m_File).Failed() || nsJvdSerialization::WriteProfilingData(m_File, m_Profiling).Failed()))
+  {
+    nsLog::Error("Failed to serialize clip to '{0}'.", m_sFilePath);
+    m_bFailed = true;
+  }
+
+  if (!m_bFailed && m_uiExpectedFrameCount != nsJvdSerialization::g_uiUnknownFrameCount && m_uiExpectedFrameCount != m_uiFramesWritten)
+  {
+    nsLog::Error("Clip '{0}' announced {1} frames but {2} were written.", m_sFilePath, m_uiExpectedFrameCount, m_uiFramesWritten);
+    m_bFailed = true;
+  }
+
+  if (m_File.Flush().Failed())
+  {
+    m_bFailed = true;
+  }
+
+  m_File.Close();
+  m_sFilePath.Clear();
+  m_BlockFrames.Clear();
+  m_Profiling.Clear();
+
+  return m_bFailed ? NS_FAILURE : NS_SUCCESS;
+}
+
+void nsJvdClipWriter::SubmitBlock()
+{
+  if (m_PendingBlocks.GetCount() >= m_Settings.m_uiMaxBlocksInFlight)
+  {
+    WriteOldestBlock();
+  }
+
+  nsSharedPtr<nsJvdFrameBlockTask> pTask = NS_DEFAULT_NEW(nsJvdFrameBlockTask);
+  pTask->m_Frames.Swap(m_BlockFrames);
+  pTask->m_Settings = m_Settings;
+  pTask->ConfigureTask("JVD Encode Frame Block", nsTaskNesting::Never);
+
+  PendingBlock& block = m_PendingBlocks.ExpandAndGetRef();
+  block.m_pTask = pTask;
+  block.m_TaskGroup = nsTaskSystem::StartSingleTask(pTask, nsTaskPriority::LongRunning);
+
+  m_BlockFrames.Reserve(m_Settings.m_uiFramesPerBlock);
+}
+
+void nsJvdClipWriter::WriteOldestBlock()
+{
+  PendingBlock& block = m_PendingBlocks.PeekFront();
+  nsTaskSystem::WaitForGroup(block.m_TaskGroup);
+
+  if (!m_bFailed)
+  {
+    const nsDynamicArray<nsUInt8>& data = block.m_pTask->m_Block;
+    if (block.m_pTask->m_Result.Failed() || m_File.WriteBytes(data.GetData(), data.GetCount()).Failed())
+    {
+      nsLog::Error("Failed to serialize clip to '{0}'.", m_sFilePath);
+      m_bFailed = true;
+    }
+  }
+
+  m_PendingBlocks.PopFront();
+}
+
+class nsJvdFrameBlockDecodeTask final : public nsTask
+{
+public:
+  nsDynamicArray<nsUInt8> m_Block;
+  nsUInt32 m_uiFrameCount = 0;
+  nsUInt32 m_uiVersion = 0;
+  const nsAtomicBool* m_pCancel = nullptr;
+
+  nsDynamicArray<nsJvdFrame> m_Frames;
+  nsUInt64 m_uiStoredSize = 0;
+  nsResult m_Result = NS_FAILURE;
+
+private:
+  virtual void Execute() override
+  {
+    m_uiStoredSize = m_Block.GetCount();
+
+    if (!*m_pCancel)
+    {
+      m_Result = Decode();
+    }
+
+    m_Block.Clear();
+    m_Block.Compact();
+  }
+
+  nsResult Decode()
+  {
+    nsDynamicArray<nsUInt8> frameData;
+    NS_SUCCEED_OR_RETURN(nsJvdSerialization::DecompressFrameBlock(m_Block, frameData));
+
+    nsRawMemoryStreamReader reader(frameData);
+    nsJvdBodyIndexMap blockBodies;
+
+    m_Frames.SetCount(m_uiFrameCount);
+    for (nsJvdFrame& frame : m_Frames)
+    {
+      NS_SUCCEED_OR_RETURN(nsJvdSerialization::ReadFrame(reader, frame, m_uiVersion, &blockBodies));
+    }
+
+    return NS_SUCCESS;
+  }
+};
+
+class nsJvdClipLoader::nsJvdClipReadTask final : public nsTask
+{
+public:
+  nsJvdClipLoader* m_pLoader = nullptr;
+
+private:
+  virtual void Execute() override
+  {
+    const nsResult result = m_pLoader->ReadFile();
+
+    NS_LOCK(m_pLoader->m_Mutex);
+    m_pLoader->m_ReadResult = result;
+    m_pLoader->m_bReadingDone = true;
+  }
+};
+
+nsJvdClipLoader::nsJvdClipLoader() = default;
+
+nsJvdClipLoader::~nsJvdClipLoader()
+{
+  Cancel();
+
+  nsTaskSystem::WaitForGroup(m_ReadTaskGroup);
+  for (const PendingBlock& block : m_PendingBlocks)
+  {
+    nsTaskSystem::WaitForGroup(block.m_TaskGroup);
+  }
+}
+
+nsResult nsJvdClipLoader::Start(nsStringView sFilePath, nsProgress* pProgress)
+{
+  if (IsLoading())
+  {
+    nsLog::Error("Cannot load '{0}' while '{1}' is still loading.", sFilePath, m_sFilePath);
+    return NS_FAILURE;
+  }
+
+  if (!nsFileSystem::ExistsFile(sFilePath))
+  {
+    nsLog::Error("Failed to open '{0}' for reading .jvdrec clip.", sFilePath);
+    return NS_FAILURE;
+  }
+
+  if (nsJvdSerialization::IsSessionFile(sFilePath))
+  {
+    nsLog::Error("'{0}' is a recording session with several tracks, load it with nsJvdSerialization::LoadSessionFromFile().", sFilePath);
+    return NS_FAILURE;
+  }
+
+  // the last reading task may still be returning after it reported that it is done
+  nsTaskSystem::WaitForGroup(m_ReadTaskGroup);
+
+  m_sFilePath = sFilePath;
+  m_State = nsJvdClipLoadState::Loading;
+  m_bCancel.Set(false);
+  m_uiMaxBlocksDecoding = 2 * nsMath::Max(nsTaskSystem::GetWorkerThreadCount(nsWorkerThreadType::LongTasks), 1u);
+
+  m_bHeaderApplied = false;
+  m_bDecodeFailed = false;
+  m_uiFileSize = 0;
+  m_uiBytesTaken = 0;
+  m_pProgressRange.Clear();
+
+  m_bHeaderRead = false;
+  m_bReadingDone = false;
+  m_ReadResult = NS_SUCCESS;
+  m_Metadata.Reset();
+  m_BodyMetadata.Clear();
+  m_Bookmarks.Clear();
+  m_Profiling.Clear();
+  m_WholeClip.Clear();
+  m_bWholeClip = false;
+
+  if (pProgress != nullptr)
+  {
+    nsStringBuilder sText;
+    sText.SetFormat("Loading '{0}'", nsPathUtils::GetFileNameAndExtension(sFilePath));
+    m_pProgressRange = NS_DEFAULT_NEW(nsProgressRange, sText, true, pProgress);
+  }
+
+  nsSharedPtr<nsJvdClipReadTask> pTask = NS_DEFAULT_NEW(nsJvdClipReadTask);
+  pTask->m_pLoader = this;
+  pTask->ConfigureTask("JVD Read Clip", nsTaskNesting::Maybe); // waits for the decode tasks
+
+  m_ReadTaskGroup = nsTaskSystem::StartSingleTask(pTask, nsTaskPriority::LongRunning);
+  return NS_SUCCESS;
+}
+
+void nsJvdClipLoader::Cancel()
+{
+  m_bCancel.Set(true);
+}
+
+nsUInt32 nsJvdClipLoader::Update(nsJvdClip& inout_clip)
+{
+  if (!IsLoading())
+    return 0;
+
+  if (m_pProgressRange != nullptr && m_pProgressRange->WasCanceled())
+  {
+    Cancel();
+  }
+
+  nsHybridArray<nsSharedPtr<nsJvdFrameBlockDecodeTask>, 16> decodedBlocks;
+  bool bDone = false;
+  {
+    NS_LOCK(m_Mutex);
+
+    if (m_bHeaderRead && !m_bHeaderApplied)
+    {
+      m_bHeaderApplied = true;
+      inout_clip.Clear();
+      inout_clip.SetMetadata(m_Metadata);
+      inout_clip.SetBodyMetadata(m_BodyMetadata);
+    }
+
+    while (!m_PendingBlocks.IsEmpty() && nsTaskSystem::IsTaskGroupFinished(m_PendingBlocks.PeekFront().m_TaskGroup))
+    {
+      decodedBlocks.PushBack(std::move(m_PendingBlocks.PeekFront().m_pTask));
+      m_PendingBlocks.PopFront();
+    }
+
+    bDone = m_bReadingDone && m_PendingBlocks.IsEmpty();
+  }
+
+  nsUInt32 uiFramesAdded = 0;
+
+  for (nsSharedPtr<nsJvdFrameBlockDecodeTask>& pBlock : decodedBlocks)
+  {
+    // everything after a broken block would be missing frames in the middle of the clip
+    if (m_bCancel || m_bDecodeFailed)
+      break;
+
+    if (pBlock->m_Result.Failed())
+    {
+      nsLog::Error("Failed to decode frame block after frame {0} of '{1}'.", inout_clip.GetFrames().GetCount(), m_sFilePath);
+      m_bDecodeFailed = true;
+      Cancel();
+      break;
+    }
+
+    for (nsJvdFrame& frame : pBlock->m_Frames)
+    {
+      inout_clip.AddFrame(std::move(frame));
+    }
+
+    uiFramesAdded += pBlock->m_Frames.GetCount();
+    m_uiBytesTaken += pBlock->m_uiStoredSize;
+  }
+
+  if (!bDone)
+  {
+    if (m_pProgressRange != nullptr && m_uiFileSize > 0)
+    {
+      m_pProgressRange->SetCompletion(nsMath::Min(static_cast<double>(m_uiBytesTaken) / static_cast<double>(m_uiFileSize), 1.0));
+    }
+
+    return uiFramesAdded;
+  }
+
+  // the reading task is done, nothing else touches the shared state anymore
+  if (m_bWholeClip && !m_bCancel)
+  {
+    uiFramesAdded += m_WholeClip.GetFrames().GetCount();
+    inout_clip = std::move(m_WholeClip);
+  }
+  else
+  {
+    // added once their frames are there, this keeps the timeline summary up to date without rebuilding it
+    for (const nsJvdBookmark& bookmark : m_Bookmarks)
+    {
+      inout_clip.AddBookmark(bookmark);
+    }
+
+    inout_clip.SetProfiling(std::move(m_Profiling));
+  }
+
+  if (m_bDecodeFailed || m_ReadResult.Failed())
+  {
+    m_State = nsJvdClipLoadState::Failed;
+  }
+  else if (m_bCancel)
+  {
+    m_State = nsJvdClipLoadState::Canceled;
+  }
+  else
+  {
+    m_State = nsJvdClipLoadState::Succeeded;
+  }
+
+  m_WholeClip.Clear();
+  m_pProgressRange.Clear();
+  return uiFramesAdded;
+}
+
+nsResult nsJvdClipLoader::Wait(nsJvdClip& inout_clip)
+{
+  Update(inout_clip);
+
+  while (IsLoading())
+  {
+    nsTaskGroupID group;
+    {
+      NS_LOCK(m_Mutex);
+      group = m_PendingBlocks.IsEmpty() ? m_ReadTaskGroup : m_PendingBlocks.PeekFront().m_TaskGroup;
+    }
+
+    nsTaskSystem::WaitForGroup(group);
+    Update(inout_clip);
+  }
+
+  return m_State == nsJvdClipLoadState::Succeeded ? NS_SUCCESS : NS_FAILURE;
+}
+
+nsResult nsJvdClipLoader::ReadFile()
+{
+  if (nsJvdSimplifiedClip::IsSimplifiedClipFile(m_sFilePath))
+  {
+    nsJvdClip clip;
+    const nsResult result = nsJvdSerialization::LoadClipFromFile(m_sFilePath, clip);
+
+    NS_LOCK(m_Mutex);
+    m_WholeClip = std::move(clip);
+    m_bWholeClip = true;
+    return result;
+  }
+
+  nsFileReader file;
+  if (file.Open(m_sFilePath, 1024 * 1024).Failed())
+  {
+    nsLog::Error("Failed to open '{0}' for reading .jvdrec clip.", m_sFilePath);
     return NS_FAILURE;
   }
 
+  nsUInt32 uiVersion = 0;
+  if (ReadClipFileVersion(file, m_sFilePath, uiVersion).Failed())
+  {
+    return NS_FAILURE;
+  }
+
+  // older files store the frames back to back, there are no blocks to decode in parallel
+  if (uiVersion < 5)
+  {
+    file.Close();
+
+    nsJvdClip clip;
+    const nsResult result = nsJvdSerialization::LoadClipFromFile(m_sFilePath, clip);
+
+    NS_LOCK(m_Mutex);
+    m_WholeClip = std::move(clip);
+    m_bWholeClip = true;
+    return result;
+  }
+
+  {
+    nsJvdClipMetadata metadata;
+    nsDynamicArray<nsJvdBodyMetadata> bodies;
+    nsDynamicArray<nsJvdBookmark> bookmarks;
+    nsUInt64 uiFrameCount = 0;
+    if (nsJvdSerialization::ReadClipHeader(file, metadata, bodies, bookmarks, uiFrameCount, uiVersion).Failed())
+    {
+      nsLog::Error("Failed to deserialize clip from '{0}'.", m_sFilePath);
+      return NS_FAILURE;
+    }
+
+    NS_LOCK(m_Mutex);
+    m_Metadata = metadata;
+    m_BodyMetadata.Swap(bodies);
+    m_Bookmarks.Swap(bookmarks);
+    m_uiFileSize = file.GetFileSize();
+    m_bHeaderRead = true;
+  }
+
+  // there is no block index, the blocks are found by following their stored sizes
+  nsDeque<nsTaskGroupID> decoding;
+  nsUInt64 uiBlocksRead = 0;
+
+  while (!m_bCancel)
+  {
+    nsSharedPtr<nsJvdFrameBlockDecodeTask> pTask = NS_DEFAULT_NEW(nsJvdFrameBlockDecodeTask);
+    if (nsJvdSerialization::ReadStoredFrameBlock(file, pTask->m_uiFrameCount, pTask->m_Block).Failed())
+    {
+      nsLog::Error("Failed to read frame block {0} of '{1}'.", uiBlocksRead, m_sFilePath);
+
+      // like nsJvdClipReader, a broken block after the first one only ends the clip early
+      return uiBlocksRead == 0 ? NS_FAILURE : NS_SUCCESS;
+    }
+
+    if (pTask->m_uiFrameCount == 0)
+      break;
+
+    ++uiBlocksRead;
+
+    pTask->m_uiVersion = uiVersion;
+    pTask->m_pCancel = &m_bCancel;
+    pTask->ConfigureTask("JVD Decode Frame Block", nsTaskNesting::Never);
+
+    // bounds the memory of blocks that were read but not decoded yet
+    if (decoding.GetCount() >= m_uiMaxBlocksDecoding)
+    {
+      nsTaskSystem::WaitForGroup(decoding.PeekFront());
+      decoding.PopFront();
+    }
+
+    NS_LOCK(m_Mutex);
+    PendingBlock& block = m_PendingBlocks.ExpandAndGetRef();
+    block.m_pTask = pTask;
+    block.m_TaskGroup = nsTaskSystem::StartSingleTask(pTask, nsTaskPriority::LongRunning);
+    decoding.PushBack(block.m_TaskGroup);
+  }
+
+  if (!m_bCancel && uiVersion >= 7)
+  {
+    nsJvdProfilingData profiling;
+    if (nsJvdSerialization::ReadProfilingData(file, profiling).Failed())
+    {
+      // the frames are complete, only the side-channel is lost
+      nsLog::Warning("Failed to read the profiling data of '{0}'.", m_sFilePath);
+      profiling.Clear();
+    }
+
+    NS_LOCK(m_Mutex);
+    m_Profiling = std::move(profiling);
+  }
+
   return NS_SUCCESS;
 }
 
@@ -1,9 +1,236 @@
 #pragma once
 
-#include <JVDSDK/Recording/JvdRecordingTypes.h>
+#include <JVDSDK/Serialization/JvdStreamSerializer.h>
+
+#include <Foundation/Containers/Deque.h>
+#include <Foundation/IO/FileSystem/FileReader.h>
+#include <Foundation/IO/FileSystem/FileWriter.h>
+#include <Foundation/IO/MemoryStream.h>
+#include <Foundation/Threading/AtomicInteger.h>
+#include <Foundation/Threading/Mutex.h>
+#include <Foundation/Threading/TaskSystem.h>
+#include <Foundation/Types/UniquePtr.h>
+
+class nsProgress;
+class nsProgressRange;
 
 namespace nsJvdSerialization
 {
-  NS_JVDSDK_DLL nsResult SaveClipToFile(nsStringView sFilePath, const nsJvdClip& clip);
+  NS_JVDSDK_DLL nsResult SaveClipToFile(nsStringView sFilePath, const nsJvdClip& clip, const nsJvdClipWriteSettings& settings = nsJvdClipWriteSettings());
+
+  /// \brief Loads a .jvdrec file, or reconstructs all frames of a .jvdsim file (see nsJvdSimplifiedClip).
   NS_JVDSDK_DLL nsResult LoadClipFromFile(nsStringView sFilePath, nsJvdClip& outClip);
+
+  /// \brief Writes the tracks of an nsJvdRecordingSession into one .jvdses file.
+  ///
+  /// Each track keeps its own clip header. The frame blocks of all tracks are interleaved by the timestamp of their
+  /// first frame, so that a reader can follow all tracks at once.
+  NS_JVDSDK_DLL nsResult SaveSessionToFile(nsStringView sFilePath, nsArrayPtr<const nsJvdClip> tracks, const nsJvdClipWriteSettings& settings = nsJvdClipWriteSettings());
+
+  /// \brief Loads all tracks of a .jvdses file, one clip per track.
+  NS_JVDSDK_DLL nsResult LoadSessionFromFile(nsStringView sFilePath, nsDynamicArray<nsJvdClip>& out_tracks);
+
+  NS_JVDSDK_DLL bool IsSessionFile(nsStringView sFilePath);
 }
+
+/// \brief Reads a .jvdrec file frame by frame instead of loading the whole clip into memory.
+///
+/// Open() reads the header, the clip metadata, the body metadata and the bookmarks. Frames are then decoded one at a
+/// time with ReadNextFrame(). For version 5+ files only the current frame block is held in memory.
+class NS_JVDSDK_DLL nsJvdClipReader
+{
+public:
+  nsJvdClipReader();
+  ~nsJvdClipReader();
+
+  nsResult Open(nsStringView sFilePath, nsUInt32 uiCacheSize = 1024 * 1024);
+  void Close();
+
+  bool IsOpen() const { return m_File.IsOpen(); }
+  nsUInt32 GetVersion() const { return m_uiVersion; }
+  nsUInt64 GetFileSize() const { return m_File.GetFileSize(); }
+
+  const nsJvdClipMetadata& GetMetadata() const { return m_Metadata; }
+  const nsDynamicArray<nsJvdBodyMetadata>& GetBodyMetadata() const { return m_BodyMetadata; }
+  const nsDynamicArray<nsJvdBookmark>& GetBookmarks() const { return m_Bookmarks; }
+
+  /// \brief The frame count stored in the header, nsJvdSerialization::g_uiUnknownFrameCount if the writer did not know it.
+  nsUInt64 GetFrameCount() const { return m_uiFrameCount; }
+  nsUInt64 GetNumFramesRead() const { return m_uiFramesRead; }
+  bool HasMoreFrames() const { return m_uiVersion >= 5 ? m_uiBlockFramesLeft > 0 : m_uiFramesRead < m_uiFrameCount; }
+
+  /// \brief The size of all frames read so far before compression.
+  nsUInt64 GetNumUncompressedBytesRead() const { return m_uiUncompressedBytesRead; }
+
+  /// \brief Decodes the next frame into out_frame. Reusing the same frame object avoids reallocating its body array.
+  nsResult ReadNextFrame(nsJvdFrame& out_frame);
+
+  /// \brief The profiling data stored after the frames (version 7+). Only available once HasMoreFrames() returned false.
+  const nsJvdProfilingData& GetProfiling() const { return m_Profiling; }
+
+private:
+  nsResult ReadNextBlock();
+
+  nsFileReader m_File;
+  nsString m_sFilePath;
+  nsUInt32 m_uiVersion = 0;
+  nsJvdClipMetadata m_Metadata;
+  nsDynamicArray<nsJvdBodyMetadata> m_BodyMetadata;
+  nsDynamicArray<nsJvdBookmark> m_Bookmarks;
+  nsJvdProfilingData m_Profiling;
+  nsUInt64 m_uiFrameCount = 0;
+  nsUInt64 m_uiFramesRead = 0;
+  nsUInt64 m_uiUncompressedBytesRead = 0;
+
+  nsDynamicArray<nsUInt8> m_BlockData;
+  nsRawMemoryStreamReader m_BlockReader;
+  nsJvdBodyIndexMap m_BlockBodies;
+  nsUInt32 m_uiBlockFramesLeft = 0;
+};
+
+class nsJvdFrameBlockTask;
+
+/// \brief Writes a .jvdrec file frame by frame, so that clips of any length can be written in bounded memory.
+///
+/// Frames are collected into blocks of nsJvdClipWriteSettings::m_uiFramesPerBlock frames. Each full block is encoded and
+/// compressed on the task system while the next one is filled; finished blocks are written in order. At most
+/// m_uiMaxBlocksInFlight blocks are pending at a time.
+class NS_JVDSDK_DLL nsJvdClipWriter
+{
+  NS_DISALLOW_COPY_AND_ASSIGN(nsJvdClipWriter);
+
+public:
+  nsJvdClipWriter();
+  ~nsJvdClipWriter();
+
+  /// \brief Pass the frame count if it is known upfront, readers can then preallocate.
+  nsResult Open(nsStringView sFilePath, const nsJvdClipMetadata& metadata, nsArrayPtr<const nsJvdBodyMetadata> bodies, nsArrayPtr<const nsJvdBookmark> bookmarks, const nsJvdClipWriteSettings& settings = nsJvdClipWriteSettings(), nsUInt64 uiFrameCount = nsJvdSerialization::g_uiUnknownFrameCount);
+
+  /// \brief Waits for all pending blocks and terminates the file. Fails if any block failed or the announced frame count was not met.
+  nsResult Close();
+
+  bool IsOpen() const { return m_File.IsOpen(); }
+  nsUInt64 GetNumFramesWritten() const { return m_uiFramesWritten; }
+
+  nsResult WriteFrame(const nsJvdFrame& frame);
+  nsResult WriteFrame(nsJvdFrame&& frame);
+
+  /// \brief Profiling data that Close() writes after the frames. Call after Open().
+  void SetProfiling(const nsJvdProfilingData& profiling) { m_Profiling = profiling; }
+
+private:
+  struct PendingBlock
+  {
+    nsSharedPtr<nsJvdFrameBlockTask> m_pTask;
+    nsTaskGroupID m_TaskGroup;
+  };
+
+  void SubmitBlock();
+  void WriteOldestBlock();
+
+  nsFileWriter m_File;
+  nsString m_sFilePath;
+  nsJvdClipWriteSettings m_Settings;
+  nsUInt64 m_uiExpectedFrameCount = 0;
+  nsUInt64 m_uiFramesWritten = 0;
+  bool m_bFailed = false;
+  nsJvdProfilingData m_Profiling;
+
+  nsDynamicArray<nsJvdFrame> m_BlockFrames;
+  nsDeque<PendingBlock> m_PendingBlocks;
+};
+
+/// \brief The state of an nsJvdClipLoader, as seen by the thread that calls nsJvdClipLoader::Update().
+struct nsJvdClipLoadState
+{
+  using StorageType = nsUInt8;
+
+  enum Enum : StorageType
+  {
+    Idle,
+    Loading,
+    Succeeded,
+    Failed,
+    Canceled,
+
+    Default = Idle
+  };
+};
+
+class nsJvdFrameBlockDecodeTask;
+
+/// \brief Loads a clip in the background, so that it can be shown while the rest of it is still loading.
+///
+/// A reading task follows the file and starts one task per frame block, which decompresses and decodes it. Blocks are
+/// independent, so decoding scales with the worker threads while the file is read. Update() moves the frames of all
+/// decoded blocks into the clip in file order. Files without frame blocks (version 4 and older, .jvdsim) are loaded in
+/// one piece by the reading task.
+class NS_JVDSDK_DLL nsJvdClipLoader
+{
+  NS_DISALLOW_COPY_AND_ASSIGN(nsJvdClipLoader);
+
+public:
+  nsJvdClipLoader();
+  ~nsJvdClipLoader(); ///< Cancels a running load and waits for its tasks.
+
+  /// \brief Starts loading the file. Fails right away for missing files, session files and while another load is running.
+  ///
+  /// With pProgress the load opens a progress range on it that Update() advances. Canceling that progress cancels the
+  /// load. Start(), Update() and the progress have to be used from the same thread.
+  nsResult Start(nsStringView sFilePath, nsProgress* pProgress = nullptr);
+
+  /// \brief Stops reading and decoding. Update() still has to be called until the state is no longer Loading.
+  void Cancel();
+
+  /// \brief Moves the frames of all decoded blocks into inout_clip and returns how many were added.
+  ///
+  /// Pass the same clip every time. The first call after the header was read clears the clip and sets the metadata and
+  /// the body metadata. The last call adds the bookmarks and the profiling data and sets the final state. Frames of a
+  /// canceled or failed load that were handed out before stay in the clip.
+  nsUInt32 Update(nsJvdClip& inout_clip);
+
+  /// \brief Blocks until the load is done, moves all frames into inout_clip and returns whether it succeeded.
+  nsResult Wait(nsJvdClip& inout_clip);
+
+  nsJvdClipLoadState::Enum GetState() const { return m_State; }
+  bool IsLoading() const { return m_State == nsJvdClipLoadState::Loading; }
+  const nsString& GetFilePath() const { return m_sFilePath; }
+
+private:
+  class nsJvdClipReadTask;
+
+  struct PendingBlock
+  {
+    nsSharedPtr<nsJvdFrameBlockDecodeTask> m_pTask;
+    nsTaskGroupID m_TaskGroup;
+  };
+
+  /// Runs on the reading task.
+  nsResult ReadFile();
+
+  nsString m_sFilePath;
+  nsJvdClipLoadState::Enum m_State = nsJvdClipLoadState::Idle;
+  nsTaskGroupID m_ReadTaskGroup;
+  nsAtomicBool m_bCancel;
+  nsUInt32 m_uiMaxBlocksDecoding = 0;
+
+  // consumer side
+  bool m_bHeaderApplied = false;
+  bool m_bDecodeFailed = false;
+  nsUInt64 m_uiBytesTaken = 0;
+  nsUniquePtr<nsProgressRange> m_pProgressRange;
+
+  // written by the reading task, guarded by m_Mutex
+  nsMutex m_Mutex;
+  bool m_bHeaderRead = false;
+  nsUInt64 m_uiFileSize = 0;
+  bool m_bReadingDone = false;
+  nsResult m_ReadResult = NS_SUCCESS;
+  nsJvdClipMetadata m_Metadata;
+  nsDynamicArray<nsJvdBodyMetadata> m_BodyMetadata;
+  nsDynamicArray<nsJvdBookmark> m_Bookmarks;
+  nsJvdProfilingData m_Profiling;
+  nsDeque<PendingBlock> m_PendingBlocks;
+  nsJvdClip m_WholeClip; ///< Used for files without frame blocks.
+  bool m_bWholeClip = false;
+};
@@ -3,9 +3,17 @@
 #include <JVDSDK/Serialization/JvdStreamSerializer.h>
 
 #include <Foundation/IO/MemoryStream.h>
+#include <Foundation/Logging/Log.h>
+
+#ifdef BUILDSYSTEM_ENABLE_ZSTD_SUPPORT
+#  include <zstd/zstd.h>
+#endif
 
 namespace
 {
+  /// Frame count, compression, uncompressed size and stored size of a frame block.
+  constexpr nsUInt32 g_uiBlockHeaderSize = sizeof(nsUInt32) + sizeof(nsUInt8) + sizeof(nsUInt32) + sizeof(nsUInt32);
+
   NS_FORCE_INLINE nsResult WriteUuid(nsStreamWriter& stream, const nsUuid& guid)
   {
     nsUInt64 low = 0;
@@ -30,6 +38,98 @@ namespace
     return NS_SUCCESS;
   }
 
+  NS_FORCE_INLINE nsResult WriteVarUInt(nsStreamWriter& stream, nsUInt64 uiValue)
+  {
+    nsUInt8 bytes[10];
+    nsUInt32 uiCount = 0;
+
+    do
+    {
+      bytes[uiCount] = static_cast<nsUInt8>(uiValue & 0x7F);
+      uiValue >>= 7;
+      if (uiValue != 0)
+        bytes[uiCount] |= 0x80;
+      ++uiCount;
+    } while (uiValue != 0);
+
+    return stream.WriteBytes(bytes, uiCount);
+  }
+
+  NS_FORCE_INLINE nsResult ReadVarUInt(nsStreamReader& stream, nsUInt64& out_uiValue)
+  {
+    out_uiValue = 0;
+
+    for (nsUInt32 uiShift = 0; uiShift < 64; uiShift += 7)
+    {
+      nsUInt8 byte = 0;
+      if (stream.ReadBytes(&byte, sizeof(byte)) != sizeof(byte))
+        return NS_FAILURE;
+
+      out_uiValue |= static_cast<nsUInt64>(byte & 0x7F) << uiShift;
+      if ((byte & 0x80) == 0)
+        return NS_SUCCESS;
+    }
+
+    return NS_FAILURE;
+  }
+
+  /// Profiling times are stored in ticks of 100 ns, fine enough for a flame graph and two bytes shorter than nanoseconds.
+  NS_FORCE_INLINE nsUInt64 ToProfilingTicks(nsTime time)
+  {
+    return static_cast<nsUInt64>(nsMath::Max(time.GetNanoseconds(), 0.0) / 100.0 + 0.5);
+  }
+
+  NS_FORCE_INLINE nsTime FromProfilingTicks(nsUInt64 uiTicks)
+  {
+    return nsTime::MakeFromNanoseconds(uiTicks * 100.0);
+  }
+
+  /// Since version 6 bodies of a block start with a varint key. Bodies that are new to the block have the key 1 and their
+  /// 64-bit id follows, they get the next slot of the block's table. The key of all other bodies is their slot shifted left
+  /// by one. Frames outside of blocks store the plain id.
+  nsResult WriteBodyKey(nsStreamWriter& stream, nsUInt64 uiBodyId, nsJvdBodyIndexMap* pBlockBodies)
+  {
+    if (pBlockBodies != nullptr)
+    {
+      const nsUInt32 uiNewSlot = pBlockBodies->GetCount();
+      const nsUInt32 uiSlot = pBlockBodies->GetOrAddIndex(uiBodyId);
+      if (uiSlot != uiNewSlot)
+        return WriteVarUInt(stream, static_cast<nsUInt64>(uiSlot) << 1);
+
+      const nsUInt8 uiKey = 1;
+      if (stream.WriteBytes(&uiKey, sizeof(uiKey)).Failed())
+        return NS_FAILURE;
+    }
+
+    return stream.WriteQWordValue(&uiBodyId);
+  }
+
+  nsResult ReadBodyKey(nsStreamReader& stream, nsUInt64& out_uiBodyId, nsJvdBodyIndexMap* pBlockBodies)
+  {
+    if (pBlockBodies == nullptr)
+      return stream.ReadQWordValue(&out_uiBodyId);
+
+    nsUInt64 uiKey = 0;
+    if (ReadVarUInt(stream, uiKey).Failed())
+      return NS_FAILURE;
+
+    if (uiKey == 1)
+    {
+      if (stream.ReadQWordValue(&out_uiBodyId).Failed())
+        return NS_FAILURE;
+
+      pBlockBodies->GetOrAddIndex(out_uiBodyId);
+      return NS_SUCCESS;
+    }
+
+    const nsUInt64 uiSlot = uiKey >> 1;
+    if ((uiKey & 1) != 0 || uiSlot >= pBlockBodies->GetCount())
+      return NS_FAILURE;
+
+    out_uiBodyId = pBlockBodies->GetBodyId(static_cast<nsUInt32>(uiSlot));
+    return NS_SUCCESS;
+  }
+
   NS_FORCE_INLINE nsResult WriteVec3(nsStreamWriter& stream, const nsVec3& value)
   {
     return stream.WriteBytes(&value, sizeof(nsVec3));
@@ -53,6 +153,85 @@ namespace
       return NS_FAILURE;
     return NS_SUCCESS;
   }
+
+  /// Columns are stored with exactly one value slot per body of the frame, like nsJvdCustomChannelColumn::Reset() creates
+  /// them. Columns that were filled before more bodies were added are padded, unused channels are stored empty.
+  nsResult WriteCustomChannelColumn(nsStreamWriter& stream, const nsJvdCustomChannelColumn& column, nsUInt32 uiBodyCount)
+  {
+    nsUInt8 type = static_cast<nsUInt8>(column.m_Type.GetValue());
+    if (stream.WriteBytes(&type, sizeof(type)).Failed())
+      return NS_FAILURE;
+
+    const bool bEmpty = column.m_Values.IsEmpty();
+    const nsUInt32 uiZero = 0;
+
+    nsUInt32 uiMaskWords = bEmpty ? 0 : (uiBodyCount + 31) / 32;
+    const nsUInt32 uiStoredMaskWords = nsMath::Min(uiMaskWords, column.m_PresenceMask.GetCount());
+    if (stream.WriteDWordValue(&uiMaskWords).Failed())
+      return NS_FAILURE;
+    for (nsUInt32 i = 0; i < uiMaskWords; ++i)
+    {
+      nsUInt32 uiWord = i < uiStoredMaskWords ? column.m_PresenceMask[i] : 0;
+
+      // bodies past the end of the frame have no value
+      if (i == uiMaskWords - 1 && (uiBodyCount % 32) != 0)
+      {
+        uiWord &= (1u << (uiBodyCount % 32)) - 1;
+      }
+
+      if (stream.WriteDWordValue(&uiWord).Failed())
+        return NS_FAILURE;
+    }
+
+    nsUInt32 uiValueWords = bEmpty ? 0 : uiBodyCount * column.GetStride();
+    const nsUInt32 uiStoredValueWords = nsMath::Min(uiValueWords, column.m_Values.GetCount());
+    if (stream.WriteDWordValue(&uiValueWords).Failed())
+      return NS_FAILURE;
+    if (stream.WriteBytes(column.m_Values.GetData(), sizeof(nsUInt32) * uiStoredValueWords).Failed())
+      return NS_FAILURE;
+    for (nsUInt32 i = uiStoredValueWords; i < uiValueWords; ++i)
+    {
+      if (stream.WriteDWordValue(&uiZero).Failed())
+        return NS_FAILURE;
+    }
+
+    return NS_SUCCESS;
+  }
+
+  nsResult ReadCustomChannelColumn(nsStreamReader& stream, nsJvdCustomChannelColumn& column, nsUInt32 uiBodyCount)
+  {
+    nsUInt8 type = 0;
+    if (stream.ReadBytes(&type, sizeof(type)) != sizeof(type) || type >= nsJvdCustomChannelType::ENUM_COUNT)
+      return NS_FAILURE;
+    column.m_Type = static_cast<nsJvdCustomChannelType::Enum>(type);
+
+    nsUInt32 uiMaskWords = 0;
+    if (stream.ReadDWordValue(&uiMaskWords).Failed())
+      return NS_FAILURE;
+
+    // anything but an empty column or one value slot per body would let lookups read past the values
+    const bool bEmpty = uiMaskWords == 0;
+    if (!bEmpty && uiMaskWords != (uiBodyCount + 31) / 32)
+      return NS_FAILURE;
+
+    column.m_PresenceMask.SetCountUninitialized(uiMaskWords);
+    if (stream.ReadBytes(column.m_PresenceMask.GetData(), sizeof(nsUInt32) * uiMaskWords) != sizeof(nsUInt32) * uiMaskWords)
+      return NS_FAILURE;
+
+    if (!bEmpty && (uiBodyCount % 32) != 0)
+    {
+      column.m_PresenceMask.PeekBack() &= (1u << (uiBodyCount % 32)) - 1;
+    }
+
+    nsUInt32 uiValueWords = 0;
+    if (stream.ReadDWordValue(&uiValueWords).Failed() || uiValueWords != (bEmpty ? 0 : uiBodyCount * column.GetStride()))
+      return NS_FAILURE;
+    column.m_Values.SetCountUninitialized(uiValueWords);
+    if (stream.ReadBytes(column.m_Values.GetData(), sizeof(nsUInt32) * uiValueWords) != sizeof(nsUInt32) * uiValueWords)
+      return NS_FAILURE;
+
+    return NS_SUCCESS;
+  }
 }
 
 nsResult nsJvdSerialization::WriteMetadata(nsStreamWriter& stream, const nsJvdClipMetadata& metadata)
@@ -84,10 +263,23 @@ nsResult nsJvdSerialization::WriteMetadata(nsStreamWriter& stream, const nsJvdCl
   if (stream.WriteQWordValue(&sampleInterval).Failed())
     return NS_FAILURE;
 
+  nsUInt32 uiChannelCount = metadata.m_CustomChannels.GetCount();
+  if (stream.WriteDWordValue(&uiChannelCount).Failed())
+    return NS_FAILURE;
+  for (const nsJvdCustomChannelDesc& channel : metadata.m_CustomChannels)
+  {
+    if (stream.WriteString(channel.m_sName).Failed())
+      return NS_FAILURE;
+
+    nsUInt8 type = static_cast<nsUInt8>(channel.m_Type.GetValue());
+    if (stream.WriteBytes(&type, sizeof(type)).Failed())
+      return NS_FAILURE;
+  }
+
   return NS_SUCCESS;
 }
 
-nsResult nsJvdSerialization::ReadMetadata(nsStreamReader& stream, nsJvdClipMetadata& metadata)
+nsResult nsJvdSerialization::ReadMetadata(nsStreamReader& stream, nsJvdClipMetadata& metadata, nsUInt32 uiVersion)
 {
   metadata.Reset();
 
@@ -121,10 +313,168 @@ nsResult nsJvdSerialization::ReadMetadata(nsStreamReader& stream, nsJvdClipMetad
     return NS_FAILURE;
   metadata.m_SampleInterval = nsTime::MakeFromMicroseconds(static_cast<double>(sampleInterval));
 
+  if (uiVersion >= 2)
+  {
+    nsUInt32 uiChannelCount = 0;
+    if (stream.ReadDWordValue(&uiChannelCount).Failed())
+      return NS_FAILURE;
+    metadata.m_CustomChannels.SetCount(uiChannelCount);
+    for (nsJvdCustomChannelDesc& channel : metadata.m_CustomChannels)
+    {
+      if (stream.ReadString(channel.m_sName).Failed())
+        return NS_FAILURE;
+
+      nsUInt8 type = 0;
+      if (stream.ReadBytes(&type, sizeof(type)) != sizeof(type) || type >= nsJvdCustomChannelType::ENUM_COUNT)
+        return NS_FAILURE;
+      channel.m_Type = static_cast<nsJvdCustomChannelType::Enum>(type);
+    }
+  }
+
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdSerialization::WriteBodyMetadata(nsStreamWriter& stream, nsArrayPtr<const nsJvdBodyMetadata> bodies)
+{
+  nsUInt32 uiBodyCount = bodies.GetCount();
+  if (stream.WriteDWordValue(&uiBodyCount).Failed())
+    return NS_FAILURE;
+
+  for (const nsJvdBodyMetadata& body : bodies)
+  {
+    if (WriteUuid(stream, body.m_BodyGuid).Failed())
+      return NS_FAILURE;
+
+    nsUInt64 bodyId = body.m_uiBodyId;
+    if (stream.WriteQWordValue(&bodyId).Failed())
+      return NS_FAILURE;
+    nsUInt64 sceneInstanceId = body.m_uiSceneInstanceId;
+    if (stream.WriteQWordValue(&sceneInstanceId).Failed())
+      return NS_FAILURE;
+
+    if (stream.WriteString(body.m_sName).Failed())
+      return NS_FAILURE;
+    if (stream.WriteString(body.m_sLayer).Failed())
+      return NS_FAILURE;
+    if (stream.WriteString(body.m_sShape).Failed())
+      return NS_FAILURE;
+    if (stream.WriteString(body.m_sMaterial).Failed())
+      return NS_FAILURE;
+
+    nsUInt8 flags = 0;
+    if (body.m_bKinematic)
+      flags |= 0x01;
+    if (body.m_bTrigger)
+      flags |= 0x02;
+    if (stream.WriteBytes(&flags, sizeof(flags)).Failed())
+      return NS_FAILURE;
+  }
+
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdSerialization::ReadBodyMetadata(nsStreamReader& stream, nsDynamicArray<nsJvdBodyMetadata>& out_bodies)
+{
+  nsUInt32 uiBodyCount = 0;
+  if (stream.ReadDWordValue(&uiBodyCount).Failed())
+    return NS_FAILURE;
+
+  out_bodies.SetCount(uiBodyCount);
+  for (nsJvdBodyMetadata& body : out_bodies)
+  {
+    if (ReadUuid(stream, body.m_BodyGuid).Failed())
+      return NS_FAILURE;
+
+    if (stream.ReadQWordValue(&body.m_uiBodyId).Failed())
+      return NS_FAILURE;
+    if (stream.ReadQWordValue(&body.m_uiSceneInstanceId).Failed())
+      return NS_FAILURE;
+
+    if (stream.ReadString(body.m_sName).Failed())
+      return NS_FAILURE;
+    if (stream.ReadString(body.m_sLayer).Failed())
+      return NS_FAILURE;
+    if (stream.ReadString(body.m_sShape).Failed())
+      return NS_FAILURE;
+    if (stream.ReadString(body.m_sMaterial).Failed())
+      return NS_FAILURE;
+
+    nsUInt8 flags = 0;
+    if (stream.ReadBytes(&flags, sizeof(flags)) != sizeof(flags))
+      return NS_FAILURE;
+    body.m_bKinematic = (flags & 0x01) != 0;
+    body.m_bTrigger = (flags & 0x02) != 0;
+  }
+
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdSerialization::WriteBookmarks(nsStreamWriter& stream, nsArrayPtr<const nsJvdBookmark> bookmarks)
+{
+  nsUInt32 uiBookmarkCount = bookmarks.GetCount();
+  if (stream.WriteDWordValue(&uiBookmarkCount).Failed())
+    return NS_FAILURE;
+
+  for (const nsJvdBookmark& bookmark : bookmarks)
+  {
+    nsUInt64 frameIndex = bookmark.m_uiFrameIndex;
+    if (stream.WriteQWordValue(&frameIndex).Failed())
+      return NS_FAILURE;
+
+    nsUInt64 timestamp = static_cast<nsUInt64>(bookmark.m_Timestamp.GetMicroseconds());
+    if (stream.WriteQWordValue(&timestamp).Failed())
+      return NS_FAILURE;
+
+    nsUInt8 kind = static_cast<nsUInt8>(bookmark.m_Kind.GetValue());
+    if (stream.WriteBytes(&kind, sizeof(kind)).Failed())
+      return NS_FAILURE;
+
+    nsUInt64 bodyId = bookmark.m_uiBodyId;
+    if (stream.WriteQWordValue(&bodyId).Failed())
+      return NS_FAILURE;
+    if (stream.WriteDWordValue(&bookmark.m_uiBodyCount).Failed())
+      return NS_FAILURE;
+    if (stream.WriteDWordValue(&bookmark.m_fValue).Failed())
+      return NS_FAILURE;
+  }
+
   return NS_SUCCESS;
 }
 
-nsResult nsJvdSerialization::WriteFrame(nsStreamWriter& stream, const nsJvdFrame& frame)
+nsResult nsJvdSerialization::ReadBookmarks(nsStreamReader& stream, nsDynamicArray<nsJvdBookmark>& out_bookmarks)
+{
+  nsUInt32 uiBookmarkCount = 0;
+  if (stream.ReadDWordValue(&uiBookmarkCount).Failed())
+    return NS_FAILURE;
+
+  out_bookmarks.SetCount(uiBookmarkCount);
+  for (nsJvdBookmark& bookmark : out_bookmarks)
+  {
+    if (stream.ReadQWordValue(&bookmark.m_uiFrameIndex).Failed())
+      return NS_FAILURE;
+
+    nsUInt64 timestamp = 0;
+    if (stream.ReadQWordValue(&timestamp).Failed())
+      return NS_FAILURE;
+    bookmark.m_Timestamp = nsTime::MakeFromMicroseconds(static_cast<double>(timestamp));
+
+    nsUInt8 kind = 0;
+    if (stream.ReadBytes(&kind, sizeof(kind)) != sizeof(kind) || kind >= nsJvdBookmarkKind::ENUM_COUNT)
+      return NS_FAILURE;
+    bookmark.m_Kind = static_cast<nsJvdBookmarkKind::Enum>(kind);
+
+    if (stream.ReadQWordValue(&bookmark.m_uiBodyId).Failed())
+      return NS_FAILURE;
+    if (stream.ReadDWordValue(&bookmark.m_uiBodyCount).Failed())
+      return NS_FAILURE;
+    if (stream.ReadDWordValue(&bookmark.m_fValue).Failed())
+      return NS_FAILURE;
+  }
+
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdSerialization::WriteFrame(nsStreamWriter& stream, const nsJvdFrame& frame, nsJvdBodyIndexMap* pBlockBodies)
 {
   nsUInt64 frameIndex = frame.m_uiFrameIndex;
   if (stream.WriteQWordValue(&frameIndex).Failed())
@@ -140,8 +490,7 @@ nsResult nsJvdSerialization::WriteFrame(nsStreamWriter& stream, const nsJvdFrame
 
   for (const nsJvdBodyState& state : frame.m_Bodies)
   {
-    nsUInt64 bodyId = state.m_uiBodyId;
-    if (stream.WriteQWordValue(&bodyId).Failed())
+    if (WriteBodyKey(stream, state.m_uiBodyId, pBlockBodies).Failed())
       return NS_FAILURE;
 
     if (WriteVec3(stream, state.m_vPosition).Failed())
@@ -167,18 +516,25 @@ nsResult nsJvdSerialization::WriteFrame(nsStreamWriter& stream, const nsJvdFrame
       flags |= 0x02;
     if (stream.WriteBytes(&flags, sizeof(flags)).Failed())
       return NS_FAILURE;
+  }
 
-    nsUInt32 customCount = 0;
-    if (stream.WriteDWordValue(&customCount).Failed())
+  nsUInt16 uiChannelCount = static_cast<nsUInt16>(frame.m_CustomChannels.GetCount());
+  if (stream.WriteWordValue(&uiChannelCount).Failed())
+    return NS_FAILURE;
+
+  for (const nsJvdCustomChannelColumn& column : frame.m_CustomChannels)
+  {
+    if (WriteCustomChannelColumn(stream, column, frame.m_Bodies.GetCount()).Failed())
       return NS_FAILURE;
   }
 
   return NS_SUCCESS;
 }
 
-nsResult nsJvdSerialization::ReadFrame(nsStreamReader& stream, nsJvdFrame& frame)
+nsResult nsJvdSerialization::ReadFrame(nsStreamReader& stream, nsJvdFrame& frame, nsUInt32 uiVersion, nsJvdBodyIndexMap* pBlockBodies)
 {
   frame.m_Bodies.Clear();
+  frame.m_CustomChannels.Clear();
 
   nsUInt64 frameIndex = 0;
   if (stream.ReadQWordValue(&frameIndex).Failed())
@@ -199,10 +555,8 @@ nsResult nsJvdSerialization::ReadFrame(nsStreamReader& stream, nsJvdFrame& frame
   {
     nsJvdBodyState state;
 
-    nsUInt64 bodyId = 0;
-    if (stream.ReadQWordValue(&bodyId).Failed())
+    if (ReadBodyKey(stream, state.m_uiBodyId, uiVersion >= 6 ? pBlockBodies : nullptr).Failed())
       return NS_FAILURE;
-    state.m_uiBodyId = bodyId;
 
     if (ReadVec3(stream, state.m_vPosition).Failed())
       return NS_FAILURE;
@@ -226,57 +580,486 @@ nsResult nsJvdSerialization::ReadFrame(nsStreamReader& stream, nsJvdFrame& frame
     state.m_bIsSleeping = (flags & 0x01) != 0;
     state.m_bWasTeleported = (flags & 0x02) != 0;
 
-    nsUInt32 customCount = 0;
-    if (stream.ReadDWordValue(&customCount).Failed())
-      return NS_FAILURE;
-    NS_ASSERT_DEV(customCount == 0, "Custom property serialization not implemented yet");
+    if (uiVersion < 2)
+    {
+      // version 1 wrote a per-body custom property count that was always zero
+      nsUInt32 customCount = 0;
+      if (stream.ReadDWordValue(&customCount).Failed() || customCount != 0)
+        return NS_FAILURE;
+    }
 
     frame.m_Bodies.PushBack(std::move(state));
   }
 
+  if (uiVersion >= 2)
+  {
+    nsUInt16 uiChannelCount = 0;
+    if (stream.ReadWordValue(&uiChannelCount).Failed())
+      return NS_FAILURE;
+
+    frame.m_CustomChannels.SetCount(uiChannelCount);
+    for (nsJvdCustomChannelColumn& column : frame.m_CustomChannels)
+    {
+      if (ReadCustomChannelColumn(stream, column, bodyCount).Failed())
+        return NS_FAILURE;
+    }
+  }
+
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdSerialization::WriteClipHeader(nsStreamWriter& stream, const nsJvdClipMetadata& metadata, nsArrayPtr<const nsJvdBodyMetadata> bodies, nsArrayPtr<const nsJvdBookmark> bookmarks, nsUInt64 uiFrameCount)
+{
+  if (WriteMetadata(stream, metadata).Failed())
+    return NS_FAILURE;
+
+  if (WriteBodyMetadata(stream, bodies).Failed())
+    return NS_FAILURE;
+
+  if (WriteBookmarks(stream, bookmarks).Failed())
+    return NS_FAILURE;
+
+  if (stream.WriteQWordValue(&uiFrameCount).Failed())
+    return NS_FAILURE;
+
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdSerialization::ReadClipHeader(nsStreamReader& stream, nsJvdClipMetadata& out_metadata, nsDynamicArray<nsJvdBodyMetadata>& out_bodies, nsDynamicArray<nsJvdBookmark>& out_bookmarks, nsUInt64& out_uiFrameCount, nsUInt32 uiVersion)
+{
+  out_bodies.Clear();
+  out_bookmarks.Clear();
+
+  if (ReadMetadata(stream, out_metadata, uiVersion).Failed())
+    return NS_FAILURE;
+
+  if (uiVersion >= 3)
+  {
+    if (ReadBodyMetadata(stream, out_bodies).Failed())
+      return NS_FAILURE;
+  }
+
+  if (uiVersion >= 4)
+  {
+    if (ReadBookmarks(stream, out_bookmarks).Failed())
+      return NS_FAILURE;
+  }
+
+  if (stream.ReadQWordValue(&out_uiFrameCount).Failed())
+    return NS_FAILURE;
+
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdSerialization::EncodeFrameBlock(nsArrayPtr<const nsJvdFrame> frames, const nsJvdClipWriteSettings& settings, nsDynamicArray<nsUInt8>& out_block)
+{
+  out_block.Clear();
+
+  nsDynamicArray<nsUInt8> frameData;
+  {
+    nsMemoryStreamContainerWrapperStorage<nsDynamicArray<nsUInt8>> storage(&frameData);
+    nsMemoryStreamWriter writer(&storage);
+
+    nsJvdBodyIndexMap blockBodies;
+    for (const nsJvdFrame& frame : frames)
+    {
+      if (WriteFrame(writer, frame, &blockBodies).Failed())
+        return NS_FAILURE;
+    }
+  }
+
+  return EncodeBlock(frameData, frames.GetCount(), settings, out_block);
+}
+
+nsResult nsJvdSerialization::EncodeBlock(nsArrayPtr<const nsUInt8> frameData, nsUInt32 uiFrameCount, const nsJvdClipWriteSettings& settings, nsDynamicArray<nsUInt8>& out_block)
+{
+  NS_ASSERT_DEV(uiFrameCount > 0, "A block without frames marks the end of the blocks");
+
+  out_block.Clear();
+
+  nsUInt8 uiCompression = nsJvdCompression::None;
+  nsUInt32 uiStoredSize = frameData.GetCount();
+
+  out_block.SetCountUninitialized(g_uiBlockHeaderSize + frameData.GetCount());
+
+#ifdef BUILDSYSTEM_ENABLE_ZSTD_SUPPORT
+  if (settings.m_Compression == nsJvdCompression::Zstd && !frameData.IsEmpty())
+  {
+    nsDynamicArray<nsUInt8> compressed;
+    compressed.SetCountUninitialized(static_cast<nsUInt32>(ZSTD_compressBound(frameData.GetCount())));
+
+    const size_t uiCompressedSize = ZSTD_compress(compressed.GetData(), compressed.GetCount(), frameData.GetPtr(), frameData.GetCount(), settings.m_iCompressionLevel);
+    if (ZSTD_isError(uiCompressedSize))
+    {
+      nsLog::Error("Failed to compress .jvdrec frame block: '{0}'.", ZSTD_getErrorName(uiCompressedSize));
+      return NS_FAILURE;
+    }
+
+    // blocks that do not shrink are stored uncompressed, they decode faster
+    if (uiCompressedSize < frameData.GetCount())
+    {
+      uiCompression = nsJvdCompression::Zstd;
+      uiStoredSize = static_cast<nsUInt32>(uiCompressedSize);
+      nsMemoryUtils::Copy(out_block.GetData() + g_uiBlockHeaderSize, compressed.GetData(), uiStoredSize);
+    }
+  }
+#else
+  NS_IGNORE_UNUSED(settings);
+#endif
+
+  if (uiCompression == nsJvdCompression::None)
+  {
+    nsMemoryUtils::Copy(out_block.GetData() + g_uiBlockHeaderSize, frameData.GetPtr(), frameData.GetCount());
+  }
+
+  out_block.SetCount(g_uiBlockHeaderSize + uiStoredSize);
+
+  nsRawMemoryStreamWriter header(out_block.GetData(), g_uiBlockHeaderSize);
+  const nsUInt32 uiUncompressedSize = frameData.GetCount();
+  header.WriteDWordValue(&uiFrameCount).AssertSuccess();
+  header.WriteBytes(&uiCompression, sizeof(uiCompression)).AssertSuccess();
+  header.WriteDWordValue(&uiUncompressedSize).AssertSuccess();
+  header.WriteDWordValue(&uiStoredSize).AssertSuccess();
+
   return NS_SUCCESS;
 }
 
-nsResult nsJvdSerialization::WriteClip(nsStreamWriter& stream, const nsJvdClip& clip)
+nsResult nsJvdSerialization::ReadFrameBlock(nsStreamReader& stream, nsUInt32& out_uiFrameCount, nsDynamicArray<nsUInt8>& out_frameData)
 {
-  if (WriteMetadata(stream, clip.GetMetadata()).Failed())
+  out_frameData.Clear();
+
+  nsDynamicArray<nsUInt8> block;
+  NS_SUCCEED_OR_RETURN(ReadStoredFrameBlock(stream, out_uiFrameCount, block));
+
+  if (out_uiFrameCount == 0)
+    return NS_SUCCESS;
+
+  return DecompressFrameBlock(block, out_frameData);
+}
+
+nsResult nsJvdSerialization::ReadStoredFrameBlock(nsStreamReader& stream, nsUInt32& out_uiFrameCount, nsDynamicArray<nsUInt8>& out_block)
+{
+  out_block.Clear();
+
+  if (stream.ReadDWordValue(&out_uiFrameCount).Failed())
     return NS_FAILURE;
 
-  nsUInt64 frameCount = clip.GetFrames().GetCount();
-  if (stream.WriteQWordValue(&frameCount).Failed())
+  if (out_uiFrameCount == 0)
+    return NS_SUCCESS;
+
+  nsUInt8 uiCompression = 0;
+  nsUInt32 uiUncompressedSize = 0;
+  nsUInt32 uiStoredSize = 0;
+  if (stream.ReadBytes(&uiCompression, sizeof(uiCompression)) != sizeof(uiCompression))
+    return NS_FAILURE;
+  if (stream.ReadDWordValue(&uiUncompressedSize).Failed())
+    return NS_FAILURE;
+  if (stream.ReadDWordValue(&uiStoredSize).Failed())
+    return NS_FAILURE;
+
+  out_block.SetCountUninitialized(g_uiBlockHeaderSize + uiStoredSize);
+
+  nsRawMemoryStreamWriter header(out_block.GetData(), g_uiBlockHeaderSize);
+  header.WriteDWordValue(&out_uiFrameCount).AssertSuccess();
+  header.WriteBytes(&uiCompression, sizeof(uiCompression)).AssertSuccess();
+  header.WriteDWordValue(&uiUncompressedSize).AssertSuccess();
+  header.WriteDWordValue(&uiStoredSize).AssertSuccess();
+
+  if (stream.ReadBytes(out_block.GetData() + g_uiBlockHeaderSize, uiStoredSize) != uiStoredSize)
+    return NS_FAILURE;
+
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdSerialization::DecompressFrameBlock(nsArrayPtr<const nsUInt8> block, nsDynamicArray<nsUInt8>& out_frameData)
+{
+  out_frameData.Clear();
+
+  if (block.GetCount() < g_uiBlockHeaderSize)
+    return NS_FAILURE;
+
+  nsRawMemoryStreamReader header(block.GetPtr(), g_uiBlockHeaderSize);
+  nsUInt32 uiFrameCount = 0;
+  nsUInt8 uiCompression = 0;
+  nsUInt32 uiUncompressedSize = 0;
+  nsUInt32 uiStoredSize = 0;
+  header.ReadDWordValue(&uiFrameCount).AssertSuccess();
+  header.ReadBytes(&uiCompression, sizeof(uiCompression));
+  header.ReadDWordValue(&uiUncompressedSize).AssertSuccess();
+  header.ReadDWordValue(&uiStoredSize).AssertSuccess();
+
+  const nsArrayPtr<const nsUInt8> payload = block.GetSubArray(g_uiBlockHeaderSize);
+  if (payload.GetCount() != uiStoredSize)
+    return NS_FAILURE;
+
+  if (uiCompression == nsJvdCompression::None)
+  {
+    if (uiStoredSize != uiUncompressedSize)
+      return NS_FAILURE;
+
+    out_frameData = payload;
+    return NS_SUCCESS;
+  }
+
+#ifdef BUILDSYSTEM_ENABLE_ZSTD_SUPPORT
+  if (uiCompression == nsJvdCompression::Zstd)
+  {
+    out_frameData.SetCountUninitialized(uiUncompressedSize);
+    const size_t uiActualSize = ZSTD_decompress(out_frameData.GetData(), uiUncompressedSize, payload.GetPtr(), uiStoredSize);
+    if (uiActualSize != uiUncompressedSize)
+    {
+      nsLog::Error("Failed to decompress .jvdrec frame block: '{0}'.", ZSTD_isError(uiActualSize) ? ZSTD_getErrorName(uiActualSize) : "size mismatch");
+      return NS_FAILURE;
+    }
+
+    return NS_SUCCESS;
+  }
+#endif
+
+  nsLog::Error("Unsupported .jvdrec frame block compression {0}.", uiCompression);
+  return NS_FAILURE;
+}
+
+nsResult nsJvdSerialization::WriteEndOfFrames(nsStreamWriter& stream)
+{
+  const nsUInt32 uiEndMarker = 0;
+  return stream.WriteDWordValue(&uiEndMarker);
+}
+
+nsResult nsJvdSerialization::WriteProfilingData(nsStreamWriter& stream, const nsJvdProfilingData& profiling)
+{
+  for (const nsDynamicArray<nsString>* pNames : {&profiling.GetScopeNames(), &profiling.GetThreadNames()})
+  {
+    NS_SUCCEED_OR_RETURN(WriteVarUInt(stream, pNames->GetCount()));
+    for (const nsString& sName : *pNames)
+    {
+      NS_SUCCEED_OR_RETURN(stream.WriteString(sName));
+    }
+  }
+
+  NS_SUCCEED_OR_RETURN(WriteVarUInt(stream, ToProfilingTicks(profiling.GetCaptureOverhead())));
+
+  const nsDynamicArray<nsJvdFrameProfile>& frames = profiling.GetFrames();
+  NS_SUCCEED_OR_RETURN(WriteVarUInt(stream, frames.GetCount()));
+
+  // frame indices and start times only grow, scopes are sorted by thread and begin time, so all of them are stored as deltas
+  nsUInt64 uiPrevFrameIndex = 0;
+  nsUInt64 uiPrevFrameStart = 0;
+  for (const nsJvdFrameProfile& frame : frames)
+  {
+    const nsUInt64 uiFrameStart = nsMath::Max(ToProfilingTicks(frame.m_StartTime), uiPrevFrameStart);
+
+    NS_SUCCEED_OR_RETURN(WriteVarUInt(stream, frame.m_uiFrameIndex - uiPrevFrameIndex));
+    NS_SUCCEED_OR_RETURN(WriteVarUInt(stream, uiFrameStart - uiPrevFrameStart));
+    NS_SUCCEED_OR_RETURN(WriteVarUInt(stream, ToProfilingTicks(frame.m_Duration)));
+    NS_SUCCEED_OR_RETURN(WriteVarUInt(stream, frame.m_Scopes.GetCount()));
+
+    uiPrevFrameIndex = frame.m_uiFrameIndex;
+    uiPrevFrameStart = uiFrameStart;
+
+    nsUInt32 uiPrevThread = 0;
+    nsUInt64 uiPrevBegin = 0;
+    for (const nsJvdProfileScope& scope : frame.m_Scopes)
+    {
+      if (scope.m_uiThreadIndex != uiPrevThread)
+      {
+        uiPrevThread = scope.m_uiThreadIndex;
+        uiPrevBegin = 0;
+      }
+
+      const nsUInt64 uiBegin = nsMath::Max(ToProfilingTicks(scope.m_BeginTime), uiPrevBegin);
+
+      NS_SUCCEED_OR_RETURN(WriteVarUInt(stream, scope.m_uiThreadIndex));
+      NS_SUCCEED_OR_RETURN(WriteVarUInt(stream, scope.m_uiNameIndex));
+      NS_SUCCEED_OR_RETURN(WriteVarUInt(stream, scope.m_uiDepth));
+      NS_SUCCEED_OR_RETURN(WriteVarUInt(stream, uiBegin - uiPrevBegin));
+      NS_SUCCEED_OR_RETURN(WriteVarUInt(stream, ToProfilingTicks(scope.m_Duration)));
+
+      uiPrevBegin = uiBegin;
+    }
+  }
+
+  return NS_SUCCESS;
+}
+
+nsResult nsJvdSerialization::ReadProfilingData(nsStreamReader& stream, nsJvdProfilingData& out_profiling)
+{
+  out_profiling.Clear();
+
+  nsUInt64 uiCount = 0;
+  nsString sName;
+
+  NS_SUCCEED_OR_RETURN(ReadVarUInt(stream, uiCount));
+  for (nsUInt64 i = 0; i < uiCount; ++i)
+  {
+    NS_SUCCEED_OR_RETURN(stream.ReadString(sName));
+    if (out_profiling.InternScopeName(sName) != i)
+      return NS_FAILURE;
+  }
+
+  const nsUInt64 uiScopeNameCount = uiCount;
+
+  NS_SUCCEED_OR_RETURN(ReadVarUInt(stream, uiCount));
+  if (uiCount > 0xFFFF)
     return NS_FAILURE;
 
-  for (const nsJvdFrame& frame : clip.GetFrames())
+  for (nsUInt64 i = 0; i < uiCount; ++i)
+  {
+    NS_SUCCEED_OR_RETURN(stream.ReadString(sName));
+    if (out_profiling.InternThreadName(sName) != i)
+      return NS_FAILURE;
+  }
+
+  const nsUInt64 uiThreadCount = uiCount;
+
+  nsUInt64 uiValue = 0;
+  NS_SUCCEED_OR_RETURN(ReadVarUInt(stream, uiValue));
+  out_profiling.SetCaptureOverhead(FromProfilingTicks(uiValue));
+
+  nsUInt64 uiFrameCount = 0;
+  NS_SUCCEED_OR_RETURN(ReadVarUInt(stream, uiFrameCount));
+
+  nsUInt64 uiFrameIndex = 0;
+  nsUInt64 uiFrameStart = 0;
+  for (nsUInt64 f = 0; f < uiFrameCount; ++f)
   {
-    if (WriteFrame(stream, frame).Failed())
+    NS_SUCCEED_OR_RETURN(ReadVarUInt(stream, uiValue));
+    if (f > 0 && uiValue == 0)
+      return NS_FAILURE;
+
+    uiFrameIndex += uiValue;
+    nsJvdFrameProfile& frame = out_profiling.AddFrame(uiFrameIndex);
+
+    NS_SUCCEED_OR_RETURN(ReadVarUInt(stream, uiValue));
+    uiFrameStart += uiValue;
+    frame.m_StartTime = FromProfilingTicks(uiFrameStart);
+
+    NS_SUCCEED_OR_RETURN(ReadVarUInt(stream, uiValue));
+    frame.m_Duration = FromProfilingTicks(uiValue);
+
+    nsUInt64 uiScopeCount = 0;
+    NS_SUCCEED_OR_RETURN(ReadVarUInt(stream, uiScopeCount));
+    frame.m_Scopes.SetCount(static_cast<nsUInt32>(nsMath::Min<nsUInt64>(uiScopeCount, 1024 * 1024)));
+    if (frame.m_Scopes.GetCount() != uiScopeCount)
       return NS_FAILURE;
+
+    nsUInt64 uiPrevThread = 0;
+    nsUInt64 uiBegin = 0;
+    for (nsJvdProfileScope& scope : frame.m_Scopes)
+    {
+      nsUInt64 uiThread = 0;
+      nsUInt64 uiNameIndex = 0;
+      nsUInt64 uiDepth = 0;
+      NS_SUCCEED_OR_RETURN(ReadVarUInt(stream, uiThread));
+      NS_SUCCEED_OR_RETURN(ReadVarUInt(stream, uiNameIndex));
+      NS_SUCCEED_OR_RETURN(ReadVarUInt(stream, uiDepth));
+      if (uiThread >= uiThreadCount || uiNameIndex >= uiScopeNameCount || uiDepth > 0xFFFF)
+        return NS_FAILURE;
+
+      if (uiThread != uiPrevThread)
+      {
+        uiPrevThread = uiThread;
+        uiBegin = 0;
+      }
+
+      NS_SUCCEED_OR_RETURN(ReadVarUInt(stream, uiValue));
+      uiBegin += uiValue;
+
+      scope.m_uiThreadIndex = static_cast<nsUInt16>(uiThread);
+      scope.m_uiNameIndex = static_cast<nsUInt32>(uiNameIndex);
+      scope.m_uiDepth = static_cast<nsUInt16>(uiDepth);
+      scope.m_BeginTime = FromProfilingTicks(uiBegin);
+
+      NS_SUCCEED_OR_RETURN(ReadVarUInt(stream, uiValue));
+      scope.m_Duration = FromProfilingTicks(uiValue);
+    }
   }
 
   return NS_SUCCESS;
 }
 
-nsResult nsJvdSerialization::ReadClip(nsStreamReader& stream, nsJvdClip& clip)
+nsResult nsJvdSerialization::WriteClip(nsStreamWriter& stream, const nsJvdClip& clip, const nsJvdClipWriteSettings& settings)
+{
+  const nsArrayPtr<const nsJvdFrame> frames = clip.GetFrames();
+
+  if (WriteClipHeader(stream, clip.GetMetadata(), clip.GetBodyMetadata(), clip.GetBookmarks(), frames.GetCount()).Failed())
+    return NS_FAILURE;
+
+  const nsUInt32 uiFramesPerBlock = nsMath::Max(settings.m_uiFramesPerBlock, 1u);
+
+  nsDynamicArray<nsUInt8> block;
+  for (nsUInt32 uiFirst = 0; uiFirst < frames.GetCount(); uiFirst += uiFramesPerBlock)
+  {
+    const nsUInt32 uiCount = nsMath::Min(uiFramesPerBlock, frames.GetCount() - uiFirst);
+
+    if (EncodeFrameBlock(frames.GetSubArray(uiFirst, uiCount), settings, block).Failed())
+      return NS_FAILURE;
+
+    if (stream.WriteBytes(block.GetData(), block.GetCount()).Failed())
+      return NS_FAILURE;
+  }
+
+  if (WriteEndOfFrames(stream).Failed())
+    return NS_FAILURE;
+
+  return WriteProfilingData(stream, clip.GetProfiling());
+}
+
+nsResult nsJvdSerialization::ReadClip(nsStreamReader& stream, nsJvdClip& clip, nsUInt32 uiVersion)
 {
   clip.Clear();
 
   nsJvdClipMetadata metadata;
-  if (ReadMetadata(stream, metadata).Failed())
+  nsDynamicArray<nsJvdBodyMetadata> bodies;
+  nsDynamicArray<nsJvdBookmark> bookmarks;
+  nsUInt64 frameCount = 0;
+  if (ReadClipHeader(stream, metadata, bodies, bookmarks, frameCount, uiVersion).Failed())
     return NS_FAILURE;
 
   clip.SetMetadata(metadata);
+  clip.SetBodyMetadata(bodies);
+  clip.SetBookmarks(bookmarks);
 
-  nsUInt64 frameCount = 0;
-  if (stream.ReadQWordValue(&frameCount).Failed())
-    return NS_FAILURE;
+  if (uiVersion < 5)
+  {
+    for (nsUInt64 i = 0; i < frameCount; ++i)
+    {
+      nsJvdFrame frame;
+      if (ReadFrame(stream, frame, uiVersion).Failed())
+        return NS_FAILURE;
+      clip.AddFrame(std::move(frame), false);
+    }
+
+    clip.UpdateTimelineSummary();
+    return NS_SUCCESS;
+  }
 
-  for (nsUInt64 i = 0; i < frameCount; ++i)
+  nsDynamicArray<nsUInt8> frameData;
+  nsJvdBodyIndexMap blockBodies;
+  while (true)
   {
-    nsJvdFrame frame;
-    if (ReadFrame(stream, frame).Failed())
+    nsUInt32 uiBlockFrameCount = 0;
+    if (ReadFrameBlock(stream, uiBlockFrameCount, frameData).Failed())
       return NS_FAILURE;
-    clip.AddFrame(std::move(frame));
+
+    if (uiBlockFrameCount == 0)
+      break;
+
+    nsRawMemoryStreamReader blockReader(frameData);
+    blockBodies.Clear();
+    for (nsUInt32 i = 0; i < uiBlockFrameCount; ++i)
+    {
+      nsJvdFrame frame;
+      if (ReadFrame(blockReader, frame, uiVersion, &blockBodies).Failed())
+        return NS_FAILURE;
+      clip.AddFrame(std::move(frame), false);
+    }
   }
 
+  if (uiVersion >= 7 && ReadProfilingData(stream, clip.GetProfiling()).Failed())
+    return NS_FAILURE;
+
+  clip.UpdateTimelineSummary();
   return NS_SUCCESS;
 }
 
@@ -4,14 +4,95 @@
 
 #include <Foundation/IO/Stream.h>
 
+/// \brief How the frame blocks of a .jvdrec clip are compressed.
+struct nsJvdCompression
+{
+  using StorageType = nsUInt8;
+
+  enum Enum : nsUInt8
+  {
+    None,
+    Zstd, ///< Falls back to None if the build has no zstd support.
+
+    Default = Zstd
+  };
+};
+
+struct NS_JVDSDK_DLL nsJvdClipWriteSettings
+{
+  nsEnum<nsJvdCompression> m_Compression;
+  nsInt32 m_iCompressionLevel = 3; ///< zstd level, higher levels compress better but slower.
+
+  nsUInt32 m_uiFramesPerBlock = 64;
+
+  /// How many blocks nsJvdClipWriter encodes in parallel before it waits for the oldest one. Bounds its memory use.
+  nsUInt32 m_uiMaxBlocksInFlight = 8;
+};
+
 namespace nsJvdSerialization
 {
+  /// \brief Version of the binary metadata / frame / clip layout written by this module.
+  ///
+  /// 1: Initial layout with a (always empty) per-body custom property count.
+  /// 2: Custom channel declarations in the metadata, custom channel columns per frame.
+  /// 3: Body metadata table between the clip metadata and the frames.
+  /// 4: Bookmarks after the body metadata table.
+  /// 5: Frames are stored in blocks that may be compressed, the frame count may be unknown.
+  /// 6: Bodies are stored as varint slots of a per-block table, only their first occurrence in a block carries the body id.
+  /// 7: CPU profiling data of the clip after the end-of-frames marker.
+  constexpr nsUInt32 g_uiFormatVersion = 7;
+
+  /// \brief Frame count stored by writers that stream frames without knowing their number upfront (version 5+).
+  constexpr nsUInt64 g_uiUnknownFrameCount = 0xFFFFFFFFFFFFFFFFull;
+
   NS_JVDSDK_DLL nsResult WriteMetadata(nsStreamWriter& stream, const nsJvdClipMetadata& metadata);
-  NS_JVDSDK_DLL nsResult ReadMetadata(nsStreamReader& stream, nsJvdClipMetadata& metadata);
+  NS_JVDSDK_DLL nsResult ReadMetadata(nsStreamReader& stream, nsJvdClipMetadata& metadata, nsUInt32 uiVersion = g_uiFormatVersion);
+
+  NS_JVDSDK_DLL nsResult WriteBodyMetadata(nsStreamWriter& stream, nsArrayPtr<const nsJvdBodyMetadata> bodies);
+  NS_JVDSDK_DLL nsResult ReadBodyMetadata(nsStreamReader& stream, nsDynamicArray<nsJvdBodyMetadata>& out_bodies);
+
+  NS_JVDSDK_DLL nsResult WriteBookmarks(nsStreamWriter& stream, nsArrayPtr<const nsJvdBookmark> bookmarks);
+  NS_JVDSDK_DLL nsResult ReadBookmarks(nsStreamReader& stream, nsDynamicArray<nsJvdBookmark>& out_bookmarks);
+
+  /// \brief Writes a frame. Frames of one block share pBlockBodies, so that each body id is only stored once per block.
+  ///
+  /// Without a table the frame is self-contained and stores the id of every body, it must be read without a table.
+  NS_JVDSDK_DLL nsResult WriteFrame(nsStreamWriter& stream, const nsJvdFrame& frame, nsJvdBodyIndexMap* pBlockBodies = nullptr);
+
+  /// \brief Reads a frame. pBlockBodies must match the table used for writing, i.e. be cleared at the start of every block.
+  NS_JVDSDK_DLL nsResult ReadFrame(nsStreamReader& stream, nsJvdFrame& frame, nsUInt32 uiVersion = g_uiFormatVersion, nsJvdBodyIndexMap* pBlockBodies = nullptr);
+
+  /// \brief Writes everything that precedes the frames: clip metadata, body metadata, bookmarks and the frame count.
+  NS_JVDSDK_DLL nsResult WriteClipHeader(nsStreamWriter& stream, const nsJvdClipMetadata& metadata, nsArrayPtr<const nsJvdBodyMetadata> bodies, nsArrayPtr<const nsJvdBookmark> bookmarks, nsUInt64 uiFrameCount);
+  NS_JVDSDK_DLL nsResult ReadClipHeader(nsStreamReader& stream, nsJvdClipMetadata& out_metadata, nsDynamicArray<nsJvdBodyMetadata>& out_bodies, nsDynamicArray<nsJvdBookmark>& out_bookmarks, nsUInt64& out_uiFrameCount, nsUInt32 uiVersion = g_uiFormatVersion);
+
+  /// \brief Encodes frames into a complete block (block header plus payload) that can be written as is. Thread-safe.
+  NS_JVDSDK_DLL nsResult EncodeFrameBlock(nsArrayPtr<const nsJvdFrame> frames, const nsJvdClipWriteSettings& settings, nsDynamicArray<nsUInt8>& out_block);
+
+  /// \brief Like EncodeFrameBlock() for data that was already serialized, e.g. by other file types that reuse the block layout.
+  NS_JVDSDK_DLL nsResult EncodeBlock(nsArrayPtr<const nsUInt8> frameData, nsUInt32 uiFrameCount, const nsJvdClipWriteSettings& settings, nsDynamicArray<nsUInt8>& out_block);
+
+  /// \brief Reads the next block and returns its decompressed frames, which can be decoded with ReadFrame().
+  ///
+  /// out_uiFrameCount is zero once the end-of-frames marker is reached.
+  NS_JVDSDK_DLL nsResult ReadFrameBlock(nsStreamReader& stream, nsUInt32& out_uiFrameCount, nsDynamicArray<nsUInt8>& out_frameData);
+
+  /// \brief Reads the next block as stored (block header plus payload) without decompressing it.
+  ///
+  /// Together with DecompressFrameBlock() this splits ReadFrameBlock() into the part that has to follow the file and the
+  /// part that can run on any thread. out_uiFrameCount is zero once the end-of-frames marker is reached.
+  NS_JVDSDK_DLL nsResult ReadStoredFrameBlock(nsStreamReader& stream, nsUInt32& out_uiFrameCount, nsDynamicArray<nsUInt8>& out_block);
+
+  /// \brief Returns the decompressed frames of a block read with ReadStoredFrameBlock(). Thread-safe.
+  NS_JVDSDK_DLL nsResult DecompressFrameBlock(nsArrayPtr<const nsUInt8> block, nsDynamicArray<nsUInt8>& out_frameData);
+
+  /// \brief Terminates the block sequence started after WriteClipHeader().
+  NS_JVDSDK_DLL nsResult WriteEndOfFrames(nsStreamWriter& stream);
 
-  NS_JVDSDK_DLL nsResult WriteFrame(nsStreamWriter& stream, const nsJvdFrame& frame);
-  NS_JVDSDK_DLL nsResult ReadFrame(nsStreamReader& stream, nsJvdFrame& frame);
+  /// \brief Writes the profiling side-channel of a clip (version 7+), which follows the end-of-frames marker.
+  NS_JVDSDK_DLL nsResult WriteProfilingData(nsStreamWriter& stream, const nsJvdProfilingData& profiling);
+  NS_JVDSDK_DLL nsResult ReadProfilingData(nsStreamReader& stream, nsJvdProfilingData& out_profiling);
 
-  NS_JVDSDK_DLL nsResult WriteClip(nsStreamWriter& stream, const nsJvdClip& clip);
-  NS_JVDSDK_DLL nsResult ReadClip(nsStreamReader& stream, nsJvdClip& clip);
+  NS_JVDSDK_DLL nsResult WriteClip(nsStreamWriter& stream, const nsJvdClip& clip, const nsJvdClipWriteSettings& settings = nsJvdClipWriteSettings());
+  NS_JVDSDK_DLL nsResult ReadClip(nsStreamReader& stream, nsJvdClip& clip, nsUInt32 uiVersion = g_uiFormatVersion);
 }
@@ -131,6 +131,15 @@ void nsPvdBodyComponent::SetBodyId(nsUInt64 uiBodyId)
   MarkRenderDataDirty();
 }
 
+void nsPvdBodyComponent::SetBodyIndex(nsUInt32 uiBodyIndex)
+{
+  if (m_uiBodyIndex == uiBodyIndex)
+    return;
+
+  m_uiBodyIndex = uiBodyIndex;
+  MarkRenderDataDirty();
+}
+
 void nsPvdBodyComponent::SetMass(float fMass)
 {
   if (nsMath::IsEqual(m_fMass, fMass, 0.0001f))
@@ -167,10 +176,11 @@ void nsPvdBodyComponent::SetAngularVelocity(const nsVec3& vVelocity)
   MarkRenderDataDirty();
 }
 
-void nsPvdBodyComponent::SetPvdState(nsUInt64 uiBodyId, nsEnum<nsJvdShapeType> shape, const nsVec3& vDimensions, const nsVec3& vLinearVelocity,
+void nsPvdBodyComponent::SetPvdState(nsUInt64 uiBodyId, nsUInt32 uiBodyIndex, nsEnum<nsJvdShapeType> shape, const nsVec3& vDimensions, const nsVec3& vLinearVelocity,
   const nsVec3& vAngularVelocity, float fMass, bool bSleeping, const nsColor& color)
 {
   SetBodyId(uiBodyId);
+  SetBodyIndex(uiBodyIndex);
   SetShape(shape);
   SetDimensions(vDimensions);
   SetLinearVelocity(vLinearVelocity);
@@ -216,6 +226,7 @@ void nsPvdBodyComponent::OnMsgExtractRenderData(nsMsgExtractRenderData& msg) con
     pRenderData->m_uiSubMeshIndex = 0;
     pRenderData->m_uiUniqueID = GetUniqueIdForRendering();
     pRenderData->m_uiBodyId = m_uiBodyId;
+    pRenderData->m_uiBodyIndex = m_uiBodyIndex;
     pRenderData->m_vLinearVelocity = m_vLinearVelocity;
     pRenderData->m_vAngularVelocity = m_vAngularVelocity;
     pRenderData->m_fMass = m_fMass;
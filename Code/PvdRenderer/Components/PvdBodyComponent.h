@@ -49,6 +49,10 @@ public:
   void SetBodyId(nsUInt64 uiBodyId);                      // [ property ]
   nsUInt64 GetBodyId() const { return m_uiBodyId; }
 
+  /// The dense index of the body in the clip that is shown, see nsJvdBodyState::m_uiBodyIndex. Not serialized.
+  void SetBodyIndex(nsUInt32 uiBodyIndex);
+  nsUInt32 GetBodyIndex() const { return m_uiBodyIndex; }
+
   void SetMass(float fMass);                              // [ property ]
   float GetMass() const { return m_fMass; }
 
@@ -62,7 +66,7 @@ public:
   const nsVec3& GetAngularVelocity() const { return m_vAngularVelocity; }
 
   /// Temporary helper to push state in bulk once we hook into JVDSDK.
-  void SetPvdState(nsUInt64 uiBodyId, nsEnum<nsJvdShapeType> shape, const nsVec3& vDimensions, const nsVec3& vLinearVelocity,
+  void SetPvdState(nsUInt64 uiBodyId, nsUInt32 uiBodyIndex, nsEnum<nsJvdShapeType> shape, const nsVec3& vDimensions, const nsVec3& vLinearVelocity,
     const nsVec3& vAngularVelocity, float fMass, bool bSleeping, const nsColor& color);
 
 protected:
@@ -80,6 +84,7 @@ protected:
   nsVec3 m_vLinearVelocity = nsVec3::MakeZero();
   nsVec3 m_vAngularVelocity = nsVec3::MakeZero();
   nsUInt64 m_uiBodyId = 0;
+  nsUInt32 m_uiBodyIndex = nsInvalidIndex;
   bool m_bSleeping = false;
 
   mutable nsBoundingBoxSphere m_CachedLocalBounds = nsBoundingBoxSphere::MakeInvalid();
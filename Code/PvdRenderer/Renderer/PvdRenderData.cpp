@@ -41,6 +41,6 @@ void nsPvdBodyRenderData::FillBatchIdAndSortingKey()
 {
   FillBatchIdAndSortingKeyInternal(static_cast<nsUInt32>(m_Shape.GetValue()));
 
-  const nsUInt32 uiBodyHash = nsHashingUtils::xxHash32(&m_uiBodyId, sizeof(m_uiBodyId));
-  m_uiSortingKey = uiBodyHash;
+  // the clip-local index is already a small unique number, only bodies that were never indexed fall back to the id hash
+  m_uiSortingKey = m_uiBodyIndex != nsInvalidIndex ? m_uiBodyIndex : nsHashingUtils::xxHash32(&m_uiBodyId, sizeof(m_uiBodyId));
 }
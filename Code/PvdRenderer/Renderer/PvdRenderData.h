@@ -28,6 +28,7 @@ public:
   nsVec3 m_vShapeDimensions = nsVec3::MakeZero();
 
   nsUInt64 m_uiBodyId = 0;
+  nsUInt32 m_uiBodyIndex = nsInvalidIndex; ///< Dense index in the clip, doubles as the sorting key.
   nsVec3 m_vLinearVelocity = nsVec3::MakeZero();
   nsVec3 m_vAngularVelocity = nsVec3::MakeZero();
   float m_fMass = 0.0f;
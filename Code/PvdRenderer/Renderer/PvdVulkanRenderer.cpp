@@ -53,7 +53,12 @@ void nsPvdVulkanRenderer::Deinitialize()
     m_pRenderer.Clear();
   }
 
-  m_Instances.Clear();
+  m_pFrame = nullptr;
+  m_VisibleBodies.Clear();
+  m_History.Clear();
+  m_uiHistoryLayoutVersion = nsInvalidIndex;
+  m_bHasCullingView = false;
+  m_bInstancesDirty = false;
 }
 
 bool nsPvdVulkanRenderer::IsInitialized() const
@@ -71,7 +76,29 @@ void nsPvdVulkanRenderer::SetBackBufferSize(nsUInt32 uiWidth, nsUInt32 uiHeight)
 
 void nsPvdVulkanRenderer::UpdateFrame(const nsJvdFrame& frame)
 {
-  ConvertFrameToInstances(frame);
+  // conversion waits for Render(), the camera decides which bodies are needed
+  m_pFrame = &frame;
+  m_bInstancesDirty = true;
+
+  if (!m_pRenderer)
+    return;
+
+  const nsUInt64 uiHeadFrameIndex = m_History.GetHeadFrameIndex();
+  const bool bContinuesHistory = m_History.GetFrameCount() > 0 && frame.m_uiFrameIndex >= uiHeadFrameIndex && frame.m_uiFrameIndex - uiHeadFrameIndex < m_History.GetFrameCapacity();
+  if (m_pHistoryClip != nullptr)
+  {
+    // playback that falls behind skips frames, only those are added. After a seek the frames leading up to this one are filled in.
+    const nsUInt64 uiFirst = bContinuesHistory ? uiHeadFrameIndex + 1 : frame.m_uiFrameIndex - nsMath::Min<nsUInt64>(frame.m_uiFrameIndex, m_History.GetFrameCapacity() - 1);
+    for (nsUInt64 uiFrameIndex = uiFirst; uiFrameIndex < frame.m_uiFrameIndex; ++uiFrameIndex)
+    {
+      if (const nsJvdFrame* pFrame = m_pHistoryClip->FindFrame(uiFrameIndex))
+      {
+        AddHistoryFrame(*pFrame);
+      }
+    }
+  }
+
+  AddHistoryFrame(frame);
 }
 
 nsResult nsPvdVulkanRenderer::Render(const nsMat4& mViewProjection)
@@ -81,8 +108,13 @@ nsResult nsPvdVulkanRenderer::Render(const nsMat4& mViewProjection)
     return NS_FAILURE;
   }
 
-  nsArrayPtr<const nsVulkanInstanceData> instances(m_Instances.GetData(), m_Instances.GetCount());
-  m_pRenderer->UpdateScene(mViewProjection, instances);
+  if (m_bInstancesDirty)
+  {
+    ConvertBodiesToInstances();
+    m_bInstancesDirty = false;
+  }
+
+  m_pRenderer->SetViewProjection(mViewProjection);
   return m_pRenderer->RenderFrame();
 }
 
@@ -90,29 +122,131 @@ void nsPvdVulkanRenderer::SetBodyColorPalette(const nsColor& activeColor, const
 {
   m_ColorActive = activeColor;
   m_ColorSleeping = sleepingColor;
+  m_bInstancesDirty = true;
 }
 
-void nsPvdVulkanRenderer::ConvertFrameToInstances(const nsJvdFrame& frame)
+void nsPvdVulkanRenderer::SetCullingView(const nsJvdCullingView& view)
 {
-  m_Instances.SetCount(frame.m_Bodies.GetCount());
+  m_CullingView = view;
+  m_bHasCullingView = true;
+  m_bInstancesDirty = true;
+}
 
-  for (nsUInt32 i = 0; i < frame.m_Bodies.GetCount(); ++i)
+void nsPvdVulkanRenderer::SetOverlays(nsBitflags<nsVulkanOverlay> overlays, float fVelocityScale)
+{
+  if (m_pRenderer)
   {
-    const nsJvdBodyState& body = frame.m_Bodies[i];
-    nsVulkanInstanceData& instance = m_Instances[i];
+    m_pRenderer->SetOverlays(overlays, fVelocityScale);
+  }
+}
 
-    const nsVec3 vDimensions = body.m_vScale.CompMax(nsVec3(0.1f));
+void nsPvdVulkanRenderer::SetHistorySource(const nsJvdClip* pClip)
+{
+  m_pHistoryClip = pClip;
+  m_History.Clear();
+}
+
+void nsPvdVulkanRenderer::AddHistoryFrame(const nsJvdFrame& frame)
+{
+  nsUInt32 uiSkippedRows = 0;
+  const nsUInt32 uiRow = m_History.AddFrame(frame, &uiSkippedRows);
+
+  if (m_History.GetLayoutVersion() != m_uiHistoryLayoutVersion)
+  {
+    if (m_History.GetBodyCapacity() == 0 || m_pRenderer->ConfigureHistory(m_History.GetFrameCapacity(), m_History.GetBodyCapacity()).Failed())
+      return;
+
+    m_uiHistoryLayoutVersion = m_History.GetLayoutVersion();
+  }
 
-    nsTransform transform;
-    transform.SetIdentity();
-    transform.m_vPosition = body.m_vPosition;
-    transform.m_qRotation = body.m_qRotation;
-    transform.m_vScale = vDimensions;
+  // frames that are missing from the source leave rows without valid samples
+  for (nsUInt32 uiAge = 1; uiAge <= uiSkippedRows; ++uiAge)
+  {
+    nsArrayPtr<nsVulkanHistorySample> skipped = m_pRenderer->WriteHistoryRow(m_History.GetRow(uiAge));
+    nsMemoryUtils::ZeroFill(skipped.GetPtr(), skipped.GetCount());
+  }
+
+  // one row per frame, the cost does not depend on how many frames the overlays show
+  nsArrayPtr<nsVulkanHistorySample> row = m_pRenderer->WriteHistoryRow(uiRow);
+  if (row.IsEmpty())
+    return;
+
+  // every sample of the row has to be written
+  nsMemoryUtils::ZeroFill(row.GetPtr(), row.GetCount());
+
+  for (const nsJvdBodyState& body : frame.m_Bodies)
+  {
+    if (body.m_uiBodyIndex >= row.GetCount())
+      continue;
 
-    instance.m_ModelMatrix = transform.GetAsMat4();
-    instance.m_Color = body.m_bIsSleeping ? m_ColorSleeping : m_ColorActive;
-    instance.m_bSleeping = body.m_bIsSleeping;
+    nsVulkanHistorySample& sample = row[body.m_uiBodyIndex];
+    sample.m_vPosition = body.m_vPosition;
+    sample.m_fValid = 1.0f;
+    sample.m_vLinearVelocity = body.m_vLinearVelocity;
   }
+
+  m_pRenderer->SetHistoryRange(m_History.GetHeadRow(), m_History.GetFrameCount());
+}
+
+void nsPvdVulkanRenderer::ConvertBodiesToInstances()
+{
+  const nsArrayPtr<const nsJvdBodyState> bodies = m_pFrame != nullptr ? m_pFrame->m_Bodies.GetArrayPtr() : nsArrayPtr<const nsJvdBodyState>();
+
+  if (m_bHasCullingView)
+  {
+    m_uiVisibleBodies = m_Culling.Cull(m_CullingView, bodies, m_VisibleBodies);
+  }
+  else
+  {
+    m_VisibleBodies.SetCount(bodies.GetCount());
+    for (nsUInt32 i = 0; i < bodies.GetCount(); ++i)
+    {
+      m_VisibleBodies[i].m_uiBodyIndex = i;
+      m_VisibleBodies[i].m_Lod = nsJvdBodyLod::Full;
+    }
+    m_uiVisibleBodies = bodies.GetCount();
+  }
+
+  // written straight into GPU visible memory, so only write and never read back from target
+  nsArrayPtr<nsVulkanGpuInstance> target = m_pRenderer->BeginInstances(m_VisibleBodies.GetCount());
+  if (target.IsEmpty() && !m_VisibleBodies.IsEmpty())
+    return;
+
+  nsUInt32 uiWritten = 0;
+  for (const nsJvdVisibleBody& visible : m_VisibleBodies)
+  {
+    const nsJvdBodyState& body = bodies[visible.m_uiBodyIndex];
+
+    // sleeping bodies are not drawn, skipping them here keeps the buffer dense
+    if (body.m_bIsSleeping)
+      continue;
+
+    const nsVec3 vDimensions = body.m_vScale.CompMax(nsVec3(0.1f));
+    nsMat4 mModel;
+
+    if (visible.m_Lod == nsJvdBodyLod::Full)
+    {
+      nsTransform transform;
+      transform.SetIdentity();
+      transform.m_vPosition = body.m_vPosition;
+      transform.m_qRotation = body.m_qRotation;
+      transform.m_vScale = vDimensions;
+
+      mModel = transform.GetAsMat4();
+    }
+    else
+    {
+      // a few pixels wide, the rotation is not visible
+      mModel = nsMat4::MakeScaling(vDimensions);
+      mModel.SetTranslationVector(body.m_vPosition);
+    }
+
+    nsVulkanGpuInstance& instance = target[uiWritten++];
+    instance.m_ModelMatrix = mModel;
+    instance.m_Color = m_ColorActive;
+  }
+
+  m_pRenderer->EndInstances(uiWritten);
 }
 
 NS_STATICLINK_FILE(PvdRenderer, PvdRenderer_Renderer_PvdVulkanRenderer);
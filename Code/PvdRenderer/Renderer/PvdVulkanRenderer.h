@@ -7,10 +7,12 @@
 #include <Foundation/Math/Color.h>
 #include <Foundation/Math/Mat4.h>
 #include <Foundation/Types/UniquePtr.h>
+#include <JVDSDK/Playback/JvdBodyCulling.h>
+#include <JVDSDK/Playback/JvdMotionHistory.h>
 #include <JVDSDK/Recording/JvdRecordingTypes.h>
 #include <VulkanRenderer/VulkanRendererModule.h>
 
-/// \brief Lightweight facade that converts JVD frame data into Vulkan instance buffers and drives the Vulkan renderer.
+/// \brief Lightweight facade that writes JVD frame data directly into the Vulkan renderer's instance buffers and drives the renderer.
 class NS_PVDRENDERER_DLL nsPvdVulkanRenderer : public nsPvdRendererInterface
 {
 public:
@@ -24,15 +26,44 @@ public:
   virtual void Deinitialize() override;
   virtual bool IsInitialized() const override;
   virtual void SetBackBufferSize(nsUInt32 uiWidth, nsUInt32 uiHeight) override;
+
+  /// \brief The frame is referenced, not copied. It must stay alive and at the same address until the next UpdateFrame() or Deinitialize().
   virtual void UpdateFrame(const nsJvdFrame& frame) override;
+
   virtual nsResult Render(const nsMat4& mViewProjection) override;
   virtual void SetBodyColorPalette(const nsColor& activeColor, const nsColor& sleepingColor) override;
 
+  /// \brief Enables culling: only bodies inside the view's frustum and large enough on screen are converted and uploaded.
+  ///
+  /// Must be set again whenever the camera or the viewport size changes. Without a view every body is drawn.
+  void SetCullingView(const nsJvdCullingView& view);
+
+  /// \brief Number of bodies that passed culling in the last conversion.
+  nsUInt32 GetVisibleBodyCount() const { return m_uiVisibleBodies; }
+
+  /// \brief Selects the motion overlays drawn from the last frames, see nsVulkanOverlay.
+  void SetOverlays(nsBitflags<nsVulkanOverlay> overlays, float fVelocityScale = 0.25f);
+
+  /// \brief The clip the displayed frames come from. After a seek the history is filled from it, so trails do not start empty.
+  ///
+  /// The clip has to outlive the renderer or be reset with nullptr.
+  void SetHistorySource(const nsJvdClip* pClip);
+
 private:
-  void ConvertFrameToInstances(const nsJvdFrame& frame);
+  void ConvertBodiesToInstances();
+  void AddHistoryFrame(const nsJvdFrame& frame);
 
   nsUniquePtr<nsVulkanRenderer> m_pRenderer;
-  nsDynamicArray<nsVulkanInstanceData> m_Instances;
+  const nsJvdFrame* m_pFrame = nullptr;
+  nsJvdBodyCulling m_Culling;
+  nsJvdCullingView m_CullingView;
+  nsDynamicArray<nsJvdVisibleBody> m_VisibleBodies;
+  nsUInt32 m_uiVisibleBodies = 0;
+  nsJvdMotionHistory m_History;
+  nsUInt32 m_uiHistoryLayoutVersion = nsInvalidIndex;
+  const nsJvdClip* m_pHistoryClip = nullptr;
+  bool m_bHasCullingView = false;
+  bool m_bInstancesDirty = false;
   nsColor m_ColorActive;
   nsColor m_ColorSleeping;
 };
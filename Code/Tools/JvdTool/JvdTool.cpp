@@ -0,0 +1,1363 @@
+#include <Foundation/Application/Application.h>
+#include <Foundation/Containers/HashSet.h>
+#include <Foundation/Containers/HashTable.h>
+#include <Foundation/IO/FileSystem/FileSystem.h>
+#include <Foundation/IO/FileSystem/FileWriter.h>
+#include <Foundation/Logging/ConsoleWriter.h>
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Logging/VisualStudioWriter.h>
+#include <Foundation/Reflection/ReflectionUtils.h>
+#include <Foundation/Strings/StringBuilder.h>
+#include <Foundation/Time/Stopwatch.h>
+#include <Foundation/Utilities/CommandLineOptions.h>
+#include <Foundation/Utilities/ConversionUtils.h>
+
+#include <JVDSDK/JVDSDK.h>
+
+/* JvdTool usage:
+
+nsJvdTool.exe <command> <arguments> [options]
+
+Commands:
+    convert <in.jvdrec>... -out <file or folder>
+        Rewrites clips in the current format version with the given compression settings.
+        With several inputs, -out is a folder and the file names are kept.
+
+    cut <in.jvdrec> -out <file> [-start <seconds>] [-end <seconds>]
+        Keeps the frames between start and end, measured from the first frame.
+        The result starts at frame 0 and time 0, bookmarks outside the range are dropped.
+
+    decimate <in.jvdrec> -out <file> -fps <rate>
+        Drops frames to reduce the frame rate. Frames with bookmarks are always kept.
+
+    merge <a.jvdrec> <b.jvdrec>... -out <file> [-remapIds]
+        Combines clips of several physics systems, recorded side by side, into one clip.
+        Frames are paired up by frame index, clips without a frame at an index keep their last state.
+
+    stats <in.jvdrec>...
+        Prints frame, body, bookmark and size statistics of each clip.
+
+    diff <a.jvdrec> <b.jvdrec>
+        Compares two recordings of the same scenario and reports where they diverge.
+        Returns 0 if the clips match, 3 if they diverge.
+
+    query <in.jvdrec> -box "<minX minY minZ maxX maxY maxZ>" | -sphere "<x y z radius>" [-start <seconds>] [-end <seconds>]
+        Lists the bodies that were inside the region between start and end, with the first frame they were seen in it.
+
+    trajectory <in.jvdrec> -bodies "<id id ...>" -out <file.csv>
+        Writes every recorded state of the given bodies to a CSV file, one line per body and frame, e.g. for plotting.
+
+    simplify <in.jvdrec> -out <file.jvdsim> [-posTolerance <meters>] [-rotTolerance <radians>]
+        Replaces the per-frame body states with curves that stay within the tolerances, for archiving.
+        JDebug opens .jvdsim files directly, 'convert' turns them back into .jvdrec files.
+
+    tracks <in.jvdses> -out <folder>
+        Writes every track of a recording session to its own clip, named after the track.
+        The clips share the clock of the session, 'merge' overlays them again.
+
+All commands except query, simplify and tracks stream the clips, only a few frame blocks per file are held in memory.
+
+Examples:
+    nsJvdTool.exe convert "C:/Nightly/Old.jvdrec" -out "C:/Nightly/New.jvdrec" -level 9
+      Upgrades a clip to the current version with stronger zstd compression.
+
+    nsJvdTool.exe cut "C:/Capture.jvdrec" -out "C:/Crash.jvdrec" -start 61.5 -end 64
+      Extracts 2.5 seconds around an incident.
+
+    nsJvdTool.exe merge "C:/Ragdolls.jvdrec" "C:/Vehicles.jvdrec" -out "C:/All.jvdrec" -remapIds
+      Combines two physics worlds whose body ids overlap.
+
+    nsJvdTool.exe diff "C:/Runs/Win64.jvdrec" "C:/Runs/Linux.jvdrec"
+      Reports the first divergent frame and the ten worst bodies.
+
+    nsJvdTool.exe diff "C:/A.jvdrec" "C:/B.jvdrec" -align time -curve "C:/Errors.csv"
+      Pairs frames by timestamp and writes the error over time to a CSV file.
+
+    nsJvdTool.exe stats "C:/Nightly/*.jvdrec"
+      Prints statistics for every nightly capture (wildcards are expanded by the shell).
+
+    nsJvdTool.exe query "C:/Capture.jvdrec" -box "-2 0 -2 2 3 2" -start 10 -end 12
+      Lists the bodies that passed through a trigger volume within two seconds.
+
+    nsJvdTool.exe trajectory "C:/Capture.jvdrec" -bodies "17 42" -out "C:/Bodies.csv"
+      Exports the position, rotation and velocity curves of two bodies.
+
+    nsJvdTool.exe simplify "C:/Nightly/Soak.jvdrec" -out "C:/Archive/Soak.jvdsim" -posTolerance 0.001
+      Archives a long capture with at most a millimeter of position error.
+
+    nsJvdTool.exe tracks "C:/Capture.jvdses" -out "C:/Tracks"
+      Splits a session with several physics worlds into one clip per world.
+*/
+
+nsCommandLineOptionDoc opt_Commands("_JvdTool", "Commands:", "", "\
+convert <in.jvdrec>... -out <file or folder>\n\
+    Rewrites clips in the current format version with the given compression settings.\n\
+    With several inputs, -out is a folder and the file names are kept.\n\
+\n\
+cut <in.jvdrec> -out <file> [-start <seconds>] [-end <seconds>]\n\
+    Keeps the frames between start and end, measured from the first frame.\n\
+\n\
+decimate <in.jvdrec> -out <file> -fps <rate>\n\
+    Drops frames to reduce the frame rate. Frames with bookmarks are always kept.\n\
+\n\
+merge <a.jvdrec> <b.jvdrec>... -out <file> [-remapIds]\n\
+    Combines clips of several physics systems, recorded side by side, into one clip.\n\
+\n\
+stats <in.jvdrec>...\n\
+    Prints frame, body, bookmark and size statistics of each clip.\n\
+\n\
+diff <a.jvdrec> <b.jvdrec>\n\
+    Compares two recordings of the same scenario and reports where they diverge.\n\
+    Returns 0 if the clips match, 3 if they diverge.\n\
+\n\
+query <in.jvdrec> -box \"<minX minY minZ maxX maxY maxZ>\" | -sphere \"<x y z radius>\" [-start <seconds>] [-end <seconds>]\n\
+    Lists the bodies that were inside the region between start and end, with the first frame they were seen in it.\n\
+\n\
+trajectory <in.jvdrec> -bodies \"<id id ...>\" -out <file.csv>\n\
+    Writes every recorded state of the given bodies to a CSV file, one line per body and frame.\n\
+\n\
+simplify <in.jvdrec> -out <file.jvdsim> [-posTolerance <meters>] [-rotTolerance <radians>]\n\
+    Replaces the per-frame body states with curves that stay within the tolerances, for archiving.\n\
+\n\
+tracks <in.jvdses> -out <folder>\n\
+    Writes every track of a recording session to its own clip, named after the track.\n\
+",
+  "");
+
+nsCommandLineOptionPath opt_Out("_JvdTool", "-out", "The file (or folder, when converting several clips) to write.", "");
+
+nsCommandLineOptionEnum opt_Compression("_JvdTool", "-compression", "How written frame blocks are compressed.", "none = 0 | zstd = 1", 1);
+
+nsCommandLineOptionInt opt_Level("_JvdTool", "-level", "The zstd compression level.", 3, 1, 19);
+
+nsCommandLineOptionInt opt_BlockFrames("_JvdTool", "-blockFrames", "How many frames are encoded and compressed together.", 64, 1);
+
+nsCommandLineOptionFloat opt_Start("_JvdTool", "-start", "Start of the range kept by 'cut' or searched by 'query', in seconds after the first frame.", 0.0f, 0.0f);
+
+nsCommandLineOptionFloat opt_End("_JvdTool", "-end", "End of the range kept by 'cut' or searched by 'query', in seconds after the first frame. Defaults to the end of the clip.", 0.0f, 0.0f);
+
+nsCommandLineOptionFloat opt_Fps("_JvdTool", "-fps", "The frame rate 'decimate' reduces the clip to.", 30.0f, 0.001f);
+
+nsCommandLineOptionBool opt_RemapIds("_JvdTool", "-remapIds", "Stores the input index in the top 8 bits of the body ids, so that 'merge' can combine clips whose body ids overlap.", false);
+
+nsCommandLineOptionEnum opt_Align("_JvdTool", "-align", "How the frames of the two clips are paired up.", "index = 0 | time = 1", 0);
+
+nsCommandLineOptionFloat opt_TimeTolerance("_JvdTool", "-timeTolerance", "Maximum timestamp difference in milliseconds for '-align time'.", 0.5f, 0.0f);
+
+nsCommandLineOptionFloat opt_PositionTolerance("_JvdTool", "-posTolerance", "Bodies further apart than this many meters diverge. For 'simplify' the maximum position error, 0.001 by default.", 1e-4f, 0.0f);
+
+nsCommandLineOptionFloat opt_RotationTolerance("_JvdTool", "-rotTolerance", "Bodies rotated further apart than this many radians diverge. For 'simplify' the maximum rotation error, 0.001 by default.", 1e-4f, 0.0f);
+
+nsCommandLineOptionInt opt_Top("_JvdTool", "-top", "How many of the worst bodies are reported.", 10, 0);
+
+nsCommandLineOptionInt opt_Batch("_JvdTool", "-batch", "How many frames per file are decoded and compared at once.", 256, 1);
+
+nsCommandLineOptionPath opt_Curve("_JvdTool", "-curve", "Writes the error of every compared frame to this CSV file.", "");
+
+nsCommandLineOptionString opt_Box("_JvdTool", "-box", "The box searched by 'query', as six numbers: minimum and maximum corner.", "");
+
+nsCommandLineOptionString opt_Sphere("_JvdTool", "-sphere", "The sphere searched by 'query', as four numbers: center and radius.", "");
+
+nsCommandLineOptionString opt_Bodies("_JvdTool", "-bodies", "The body ids exported by 'trajectory', separated by spaces or commas.", "");
+
+nsCommandLineOptionDoc opt_Examples("_JvdTool", "Examples:", "", "\
+nsJvdTool.exe convert \"C:/Nightly/Old.jvdrec\" -out \"C:/Nightly/New.jvdrec\" -level 9\n\
+  Upgrades a clip to the current version with stronger zstd compression.\n\
+\n\
+nsJvdTool.exe cut \"C:/Capture.jvdrec\" -out \"C:/Crash.jvdrec\" -start 61.5 -end 64\n\
+  Extracts 2.5 seconds around an incident.\n\
+\n\
+nsJvdTool.exe merge \"C:/Ragdolls.jvdrec\" \"C:/Vehicles.jvdrec\" -out \"C:/All.jvdrec\" -remapIds\n\
+  Combines two physics worlds whose body ids overlap.\n\
+\n\
+nsJvdTool.exe diff \"C:/Runs/Win64.jvdrec\" \"C:/Runs/Linux.jvdrec\"\n\
+  Reports the first divergent frame and the ten worst bodies.\n\
+\n\
+nsJvdTool.exe diff \"C:/A.jvdrec\" \"C:/B.jvdrec\" -align time -curve \"C:/Errors.csv\"\n\
+  Pairs frames by timestamp and writes the error over time to a CSV file.\n\
+\n\
+nsJvdTool.exe query \"C:/Capture.jvdrec\" -box \"-2 0 -2 2 3 2\" -start 10 -end 12\n\
+  Lists the bodies that passed through a trigger volume within two seconds.\n\
+\n\
+nsJvdTool.exe trajectory \"C:/Capture.jvdrec\" -bodies \"17 42\" -out \"C:/Bodies.csv\"\n\
+  Exports the position, rotation and velocity curves of two bodies.\n\
+\n\
+nsJvdTool.exe simplify \"C:/Nightly/Soak.jvdrec\" -out \"C:/Archive/Soak.jvdsim\" -posTolerance 0.001\n\
+  Archives a long capture with at most a millimeter of position error.\n\
+\n\
+nsJvdTool.exe tracks \"C:/Capture.jvdses\" -out \"C:/Tracks\"\n\
+  Splits a session with several physics worlds into one clip per world.\n\
+",
+  "");
+
+namespace
+{
+  /// Number of bits of a merged body id that hold the index of the input clip with '-remapIds'.
+  constexpr nsUInt32 g_uiMergeInputBits = 8;
+  constexpr nsUInt64 g_uiMergeIdMask = (nsUInt64(1) << (64 - g_uiMergeInputBits)) - 1;
+
+  nsUInt64 RemapBodyId(nsUInt64 uiBodyId, nsUInt32 uiInput)
+  {
+    return (nsUInt64(uiInput) << (64 - g_uiMergeInputBits)) | (uiBodyId & g_uiMergeIdMask);
+  }
+
+  /// Registers uiInput as the owner of the body id, returns false if another input owns it already.
+  bool IsBodyOwner(nsHashTable<nsUInt64, nsUInt32>& ref_owners, nsUInt64 uiBodyId, nsUInt32 uiInput)
+  {
+    bool bExisted = false;
+    nsUInt32& uiOwner = ref_owners.FindOrAdd(uiBodyId, &bExisted);
+    if (!bExisted)
+    {
+      uiOwner = uiInput;
+    }
+
+    return uiOwner == uiInput;
+  }
+
+  struct MergeInput
+  {
+    nsJvdClipReader m_Reader;
+    nsJvdFrame m_Current;
+    nsJvdFrame m_Next;
+    bool m_bHasCurrent = false;
+    bool m_bHasNext = false;
+
+    /// For every custom channel of this input, the index of the channel in the merged clip.
+    nsHybridArray<nsUInt16, 4> m_ChannelRemap;
+
+    void Advance()
+    {
+      nsMath::Swap(m_Current, m_Next);
+      m_bHasCurrent = true;
+      m_bHasNext = m_Reader.HasMoreFrames() && m_Reader.ReadNextFrame(m_Next).Succeeded();
+    }
+  };
+
+  struct ClipStats
+  {
+    nsUInt32 m_uiVersion = 0;
+    nsUInt64 m_uiFileSize = 0;
+    nsUInt64 m_uiUncompressedSize = 0;
+
+    nsUInt64 m_uiFrameCount = 0;
+    nsUInt64 m_uiFirstFrameIndex = 0;
+    nsUInt64 m_uiLastFrameIndex = 0;
+    nsTime m_FirstTimestamp;
+    nsTime m_LastTimestamp;
+
+    nsUInt32 m_uiMinBodies = nsMath::MaxValue<nsUInt32>();
+    nsUInt32 m_uiMaxBodies = 0;
+    nsUInt64 m_uiBodyStates = 0;
+    nsUInt64 m_uiSleepingStates = 0;
+    nsUInt64 m_uiTeleports = 0;
+    nsHashSet<nsUInt64> m_UniqueBodies;
+
+    nsUInt32 m_uiCustomChannelCount = 0;
+    nsUInt32 m_uiProfiledFrames = 0;
+    nsUInt64 m_uiProfilingScopes = 0;
+    nsTime m_ProfilingOverhead;
+    nsUInt32 m_uiBookmarksPerKind[nsJvdBookmarkKind::ENUM_COUNT] = {};
+
+    nsStringBuilder m_sError;
+  };
+
+  nsResult GatherClipStats(nsStringView sFile, ClipStats& out_stats)
+  {
+    nsJvdClipReader reader;
+    if (reader.Open(sFile).Failed())
+    {
+      out_stats.m_sError = "Failed to open the clip.";
+      return NS_FAILURE;
+    }
+
+    out_stats.m_uiVersion = reader.GetVersion();
+    out_stats.m_uiFileSize = reader.GetFileSize();
+    out_stats.m_uiCustomChannelCount = reader.GetMetadata().m_CustomChannels.GetCount();
+
+    for (const nsJvdBookmark& bookmark : reader.GetBookmarks())
+    {
+      if (bookmark.m_Kind.GetValue() < nsJvdBookmarkKind::ENUM_COUNT)
+      {
+        ++out_stats.m_uiBookmarksPerKind[bookmark.m_Kind.GetValue()];
+      }
+    }
+
+    nsJvdFrame frame;
+    while (reader.HasMoreFrames())
+    {
+      if (reader.ReadNextFrame(frame).Failed())
+      {
+        out_stats.m_sError.SetFormat("The clip is truncated after {} frames.", out_stats.m_uiFrameCount);
+        break;
+      }
+
+      if (out_stats.m_uiFrameCount == 0)
+      {
+        out_stats.m_uiFirstFrameIndex = frame.m_uiFrameIndex;
+        out_stats.m_FirstTimestamp = frame.m_Timestamp;
+      }
+
+      ++out_stats.m_uiFrameCount;
+      out_stats.m_uiLastFrameIndex = frame.m_uiFrameIndex;
+      out_stats.m_LastTimestamp = frame.m_Timestamp;
+
+      out_stats.m_uiMinBodies = nsMath::Min(out_stats.m_uiMinBodies, frame.m_Bodies.GetCount());
+      out_stats.m_uiMaxBodies = nsMath::Max(out_stats.m_uiMaxBodies, frame.m_Bodies.GetCount());
+      out_stats.m_uiBodyStates += frame.m_Bodies.GetCount();
+
+      for (const nsJvdBodyState& state : frame.m_Bodies)
+      {
+        out_stats.m_uiSleepingStates += state.m_bIsSleeping ? 1 : 0;
+        out_stats.m_uiTeleports += state.m_bWasTeleported ? 1 : 0;
+        out_stats.m_UniqueBodies.Insert(state.m_uiBodyId);
+      }
+    }
+
+    const nsJvdProfilingData& profiling = reader.GetProfiling();
+    out_stats.m_uiProfiledFrames = profiling.GetFrames().GetCount();
+    out_stats.m_ProfilingOverhead = profiling.GetCaptureOverhead();
+    for (const nsJvdFrameProfile& profile : profiling.GetFrames())
+    {
+      out_stats.m_uiProfilingScopes += profile.m_Scopes.GetCount();
+    }
+
+    // versions before 5 store the frames uncompressed, there is nothing to compare against
+    out_stats.m_uiUncompressedSize = reader.GetVersion() >= 5 ? reader.GetNumUncompressedBytesRead() : 0;
+    return out_stats.m_sError.IsEmpty() ? NS_SUCCESS : NS_FAILURE;
+  }
+
+  void PrintClipStats(nsStringView sFile, const ClipStats& stats)
+  {
+    nsLog::Info("'{}'", sFile);
+
+    if (stats.m_uiVersion == 0)
+    {
+      nsLog::Error("  {}", stats.m_sError);
+      return;
+    }
+
+    if (stats.m_uiUncompressedSize > 0)
+    {
+      nsLog::Info("  Version {}, {}, frames compressed {}x", stats.m_uiVersion, nsArgFileSize(stats.m_uiFileSize), nsArgF(static_cast<double>(stats.m_uiUncompressedSize) / stats.m_uiFileSize, 2));
+    }
+    else
+    {
+      nsLog::Info("  Version {}, {}", stats.m_uiVersion, nsArgFileSize(stats.m_uiFileSize));
+    }
+
+    if (stats.m_uiFrameCount == 0)
+    {
+      nsLog::Info("  No frames");
+    }
+    else
+    {
+      const nsTime duration = stats.m_LastTimestamp - stats.m_FirstTimestamp;
+      const double fRate = duration.IsPositive() ? (stats.m_uiFrameCount - 1) / duration.GetSeconds() : 0.0;
+
+      nsLog::Info("  Frames: {} (index {} - {}), {} s, {} Hz, {} bytes per frame", stats.m_uiFrameCount, stats.m_uiFirstFrameIndex, stats.m_uiLastFrameIndex, nsArgF(duration.GetSeconds(), 3), nsArgF(fRate, 1), stats.m_uiFileSize / stats.m_uiFrameCount);
+      nsLog::Info("  Bodies: {} unique, {} - {} per frame (average {}), sleeping ratio {}, {} teleports", stats.m_UniqueBodies.GetCount(), stats.m_uiMinBodies, stats.m_uiMaxBodies, nsArgF(static_cast<double>(stats.m_uiBodyStates) / stats.m_uiFrameCount, 1), nsArgF(stats.m_uiBodyStates > 0 ? static_cast<double>(stats.m_uiSleepingStates) / stats.m_uiBodyStates : 0.0, 2), stats.m_uiTeleports);
+    }
+
+    if (stats.m_uiCustomChannelCount > 0)
+    {
+      nsLog::Info("  Custom channels: {}", stats.m_uiCustomChannelCount);
+    }
+
+    nsStringBuilder sBookmarks, sKind;
+    nsUInt32 uiBookmarkCount = 0;
+    for (nsUInt32 kind = 0; kind < nsJvdBookmarkKind::ENUM_COUNT; ++kind)
+    {
+      if (stats.m_uiBookmarksPerKind[kind] == 0)
+        continue;
+
+      uiBookmarkCount += stats.m_uiBookmarksPerKind[kind];
+      nsReflectionUtils::EnumerationToString(nsGetStaticRTTI<nsJvdBookmarkKind>(), kind, sKind, nsReflectionUtils::EnumConversionMode::ValueNameOnly);
+      sBookmarks.AppendWithSeparator(", ", sKind);
+      sBookmarks.AppendFormat(": {}", stats.m_uiBookmarksPerKind[kind]);
+    }
+
+    if (uiBookmarkCount > 0)
+    {
+      nsLog::Info("  Bookmarks: {} ({})", uiBookmarkCount, sBookmarks);
+    }
+
+    if (stats.m_uiProfiledFrames > 0)
+    {
+      nsLog::Info("  Profiling: {} frames, {} scopes, captured in {} ms", stats.m_uiProfiledFrames, stats.m_uiProfilingScopes, nsArgF(stats.m_ProfilingOverhead.GetMilliseconds(), 2));
+    }
+
+    if (!stats.m_sError.IsEmpty())
+    {
+      nsLog::Error("  {}", stats.m_sError);
+    }
+  }
+} // namespace
+
+class nsJvdTool : public nsApplication
+{
+public:
+  using SUPER = nsApplication;
+
+  enum ReturnCode
+  {
+    Success = 0,
+    InvalidArguments = 1,
+    ReadFailed = 2,
+    ClipsDiverge = 3,
+    WriteFailed = 4,
+  };
+
+  nsJvdTool()
+    : nsApplication("JvdTool")
+  {
+  }
+
+  virtual void AfterCoreSystemsStartup() override
+  {
+    // Add the empty data directory to access files via absolute paths
+    nsFileSystem::AddDataDirectory("", "App", ":", nsDataDirUsage::AllowWrites).IgnoreResult();
+
+    nsGlobalLog::AddLogWriter(nsLogWriter::Console::LogMessageHandler);
+    nsGlobalLog::AddLogWriter(nsLogWriter::VisualStudio::LogMessageHandler);
+  }
+
+  virtual void BeforeCoreSystemsShutdown() override
+  {
+    // prevent further output during shutdown
+    nsGlobalLog::RemoveLogWriter(nsLogWriter::Console::LogMessageHandler);
+    nsGlobalLog::RemoveLogWriter(nsLogWriter::VisualStudio::LogMessageHandler);
+
+    SUPER::BeforeCoreSystemsShutdown();
+  }
+
+  nsResult WriteErrorCurve(nsStringView sFile, const nsJvdClipDiffResult& result)
+  {
+    nsFileWriter file;
+    if (file.Open(sFile).Failed())
+    {
+      nsLog::Error("Failed to open '{}' for writing.", sFile);
+      return NS_FAILURE;
+    }
+
+    nsStringBuilder line = "FrameA,FrameB,Seconds,Matched,Missing,Divergent,MaxPosition,MeanPosition,MaxRotation\n";
+    NS_SUCCEED_OR_RETURN(file.WriteBytes(line.GetData(), line.GetElementCount()));
+
+    for (const nsJvdClipDiffFrameError& error : result.m_ErrorCurve)
+    {
+      line.SetFormat("{},{},{},{},{},{},{},{},{}\n", error.m_uiFrameIndexA, error.m_uiFrameIndexB, error.m_Timestamp.GetSeconds(), error.m_uiMatchedBodyCount, error.m_uiMissingBodyCount, error.m_uiDivergentBodyCount, error.m_fMaxPositionError, error.m_fMeanPositionError, error.m_fMaxRotationError);
+      NS_SUCCEED_OR_RETURN(file.WriteBytes(line.GetData(), line.GetElementCount()));
+    }
+
+    return NS_SUCCESS;
+  }
+
+  /// Collects the file arguments that follow the command, up to the first option.
+  void GetInputFiles(nsDynamicArray<nsString>& out_files) const
+  {
+    for (nsUInt32 i = 2; i < GetArgumentCount(); ++i)
+    {
+      const nsStringView sArg = GetArgument(i);
+      if (sArg.StartsWith("-"))
+        break;
+
+      out_files.PushBack(nsOSFile::MakePathAbsoluteWithCWD(sArg));
+    }
+  }
+
+  nsString GetOutputFile() const
+  {
+    const nsString sOut = opt_Out.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified);
+    if (sOut.IsEmpty())
+      return sOut;
+
+    return nsOSFile::MakePathAbsoluteWithCWD(sOut);
+  }
+
+  nsJvdClipWriteSettings GetWriteSettings() const
+  {
+    nsJvdClipWriteSettings settings;
+    settings.m_Compression = opt_Compression.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified) == 0 ? nsJvdCompression::None : nsJvdCompression::Zstd;
+    settings.m_iCompressionLevel = opt_Level.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified);
+    settings.m_uiFramesPerBlock = static_cast<nsUInt32>(opt_BlockFrames.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified));
+    return settings;
+  }
+
+  /// Opens the single input and the output of the commands that transform one clip into another.
+  ReturnCode OpenSingleInput(nsStringView sCommand, nsJvdClipReader& ref_reader, nsString& out_sOutput) const
+  {
+    nsDynamicArray<nsString> inputs;
+    GetInputFiles(inputs);
+
+    out_sOutput = GetOutputFile();
+    if (inputs.GetCount() != 1 || out_sOutput.IsEmpty())
+    {
+      nsLog::Error("'{}' expects one .jvdrec file and an -out file.", sCommand);
+      return InvalidArguments;
+    }
+
+    if (ref_reader.Open(inputs[0]).Failed())
+      return ReadFailed;
+
+    nsLog::Info("Reading '{}'", inputs[0]);
+    return Success;
+  }
+
+  ReturnCode ConvertFile(nsStringView sInput, nsStringView sOutput, const nsJvdClipWriteSettings& settings)
+  {
+    if (nsJvdSimplifiedClip::IsSimplifiedClipFile(sInput))
+    {
+      // simplified clips can't be streamed, all frames are reconstructed at once
+      nsJvdClip clip;
+      if (nsJvdSerialization::LoadClipFromFile(sInput, clip).Failed())
+        return ReadFailed;
+
+      if (nsJvdSerialization::SaveClipToFile(sOutput, clip, settings).Failed())
+        return WriteFailed;
+
+      nsLog::Info("Reconstructed '{}' into '{}', {} frames", sInput, sOutput, clip.GetFrames().GetCount());
+      return Success;
+    }
+
+    nsJvdClipReader reader;
+    if (reader.Open(sInput).Failed())
+      return ReadFailed;
+
+    nsJvdClipWriter writer;
+    if (writer.Open(sOutput, reader.GetMetadata(), reader.GetBodyMetadata(), reader.GetBookmarks(), settings, reader.GetFrameCount()).Failed())
+      return WriteFailed;
+
+    nsJvdFrame frame;
+    while (reader.HasMoreFrames())
+    {
+      if (reader.ReadNextFrame(frame).Failed())
+      {
+        // a truncated clip is converted as far as it goes
+        writer.Close().IgnoreResult();
+        return ReadFailed;
+      }
+
+      if (writer.WriteFrame(std::move(frame)).Failed())
+        break;
+    }
+
+    writer.SetProfiling(reader.GetProfiling());
+    if (writer.Close().Failed())
+      return WriteFailed;
+
+    nsLog::Info("Converted '{}' (version {}) to '{}', {} frames", sInput, reader.GetVersion(), sOutput, writer.GetNumFramesWritten());
+    return Success;
+  }
+
+  ReturnCode RunConvert()
+  {
+    nsDynamicArray<nsString> inputs;
+    GetInputFiles(inputs);
+
+    const nsString sOutput = GetOutputFile();
+    if (inputs.IsEmpty() || sOutput.IsEmpty())
+    {
+      nsLog::Error("'convert' expects at least one .jvdrec file and an -out file or folder.");
+      return InvalidArguments;
+    }
+
+    const nsJvdClipWriteSettings settings = GetWriteSettings();
+
+    if (inputs.GetCount() == 1)
+      return ConvertFile(inputs[0], sOutput, settings);
+
+    if (nsOSFile::CreateDirectoryStructure(sOutput).Failed())
+    {
+      nsLog::Error("Failed to create the output folder '{}'.", sOutput);
+      return WriteFailed;
+    }
+
+    // keep going after failures, so that one broken capture does not stop a nightly batch
+    ReturnCode result = Success;
+    for (const nsString& sInput : inputs)
+    {
+      nsStringBuilder sTarget = sOutput;
+      sTarget.AppendPath(sInput.GetFileNameAndExtension());
+
+      const ReturnCode fileResult = ConvertFile(sInput, sTarget, settings);
+      if (fileResult != Success)
+      {
+        result = fileResult;
+      }
+    }
+
+    return result;
+  }
+
+  ReturnCode RunCut()
+  {
+    nsJvdClipReader reader;
+    nsString sOutput;
+    const ReturnCode openResult = OpenSingleInput("cut", reader, sOutput);
+    if (openResult != Success)
+      return openResult;
+
+    const nsTime start = nsTime::MakeFromSeconds(opt_Start.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified));
+    const nsTime end = opt_End.IsOptionSpecified() ? nsTime::MakeFromSeconds(opt_End.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified)) : nsTime::MakeFromHours(1000000);
+    if (end < start)
+    {
+      nsLog::Error("-end must not be before -start.");
+      return InvalidArguments;
+    }
+
+    const nsJvdClipWriteSettings settings = GetWriteSettings();
+    nsJvdClipWriter writer;
+
+    nsJvdFrame frame;
+    nsTime clipStart;
+    nsTime firstTimestamp;
+    nsUInt64 uiFirstFrameIndex = 0;
+    nsUInt64 uiFramesRead = 0;
+
+    while (reader.HasMoreFrames())
+    {
+      if (reader.ReadNextFrame(frame).Failed())
+        break;
+
+      if (uiFramesRead++ == 0)
+      {
+        clipStart = frame.m_Timestamp;
+      }
+
+      const nsTime offset = frame.m_Timestamp - clipStart;
+      if (offset < start)
+        continue;
+      if (offset > end)
+        break;
+
+      if (!writer.IsOpen())
+      {
+        // the header can only be written once the first kept frame is known, since everything is rebased to it
+        uiFirstFrameIndex = frame.m_uiFrameIndex;
+        firstTimestamp = frame.m_Timestamp;
+
+        nsDynamicArray<nsJvdBookmark> bookmarks;
+        for (nsJvdBookmark bookmark : reader.GetBookmarks())
+        {
+          const nsTime bookmarkOffset = bookmark.m_Timestamp - clipStart;
+          if (bookmark.m_uiFrameIndex < uiFirstFrameIndex || bookmarkOffset < start || bookmarkOffset > end)
+            continue;
+
+          bookmark.m_uiFrameIndex -= uiFirstFrameIndex;
+          bookmark.m_Timestamp -= firstTimestamp;
+          bookmarks.PushBack(bookmark);
+        }
+
+        if (writer.Open(sOutput, reader.GetMetadata(), reader.GetBodyMetadata(), bookmarks, settings).Failed())
+          return WriteFailed;
+      }
+
+      frame.m_uiFrameIndex -= uiFirstFrameIndex;
+      frame.m_Timestamp -= firstTimestamp;
+
+      if (writer.WriteFrame(std::move(frame)).Failed())
+        break;
+    }
+
+    if (!writer.IsOpen())
+    {
+      nsLog::Warning("No frames between {} s and {} s, writing an empty clip.", start.GetSeconds(), end.GetSeconds());
+      if (writer.Open(sOutput, reader.GetMetadata(), reader.GetBodyMetadata(), {}, settings, 0).Failed())
+        return WriteFailed;
+    }
+
+    const nsUInt64 uiFramesWritten = writer.GetNumFramesWritten();
+    if (writer.Close().Failed())
+      return WriteFailed;
+
+    nsLog::Info("Wrote {} frames to '{}'", uiFramesWritten, sOutput);
+    return Success;
+  }
+
+  ReturnCode RunDecimate()
+  {
+    nsJvdClipReader reader;
+    nsString sOutput;
+    const ReturnCode openResult = OpenSingleInput("decimate", reader, sOutput);
+    if (openResult != Success)
+      return openResult;
+
+    const nsTime interval = nsTime::MakeFromSeconds(1.0 / opt_Fps.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified));
+
+    nsHashSet<nsUInt64> bookmarkedFrames;
+    for (const nsJvdBookmark& bookmark : reader.GetBookmarks())
+    {
+      bookmarkedFrames.Insert(bookmark.m_uiFrameIndex);
+    }
+
+    nsJvdClipMetadata metadata = reader.GetMetadata();
+    metadata.m_SampleInterval = nsMath::Max(metadata.m_SampleInterval, interval);
+
+    nsJvdClipWriter writer;
+    if (writer.Open(sOutput, metadata, reader.GetBodyMetadata(), reader.GetBookmarks(), GetWriteSettings()).Failed())
+      return WriteFailed;
+
+    nsJvdFrame frame;
+    nsTime nextSample;
+    nsUInt64 uiFramesRead = 0;
+
+    while (reader.HasMoreFrames())
+    {
+      if (reader.ReadNextFrame(frame).Failed())
+        break;
+
+      if (uiFramesRead++ == 0)
+      {
+        nextSample = frame.m_Timestamp;
+      }
+
+      if (frame.m_Timestamp < nextSample && !bookmarkedFrames.Contains(frame.m_uiFrameIndex))
+        continue;
+
+      // advance on a fixed grid, so that jitter in the recorded timestamps does not accumulate
+      while (nextSample <= frame.m_Timestamp)
+      {
+        nextSample += interval;
+      }
+
+      if (writer.WriteFrame(std::move(frame)).Failed())
+        break;
+    }
+
+    // the frame indices are kept, so the profiles of the kept frames stay valid
+    writer.SetProfiling(reader.GetProfiling());
+
+    const nsUInt64 uiFramesWritten = writer.GetNumFramesWritten();
+    if (writer.Close().Failed())
+      return WriteFailed;
+
+    nsLog::Info("Kept {} of {} frames in '{}'", uiFramesWritten, uiFramesRead, sOutput);
+    return Success;
+  }
+
+  ReturnCode RunMerge()
+  {
+    nsDynamicArray<nsString> inputFiles;
+    GetInputFiles(inputFiles);
+
+    const nsString sOutput = GetOutputFile();
+    if (inputFiles.GetCount() < 2 || sOutput.IsEmpty())
+    {
+      nsLog::Error("'merge' expects at least two .jvdrec files and an -out file.");
+      return InvalidArguments;
+    }
+
+    const bool bRemapIds = opt_RemapIds.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified);
+    if (bRemapIds && inputFiles.GetCount() > (1u << g_uiMergeInputBits))
+    {
+      nsLog::Error("'-remapIds' supports at most {} inputs.", 1u << g_uiMergeInputBits);
+      return InvalidArguments;
+    }
+
+    nsDynamicArray<nsUniquePtr<MergeInput>> inputs;
+    for (const nsString& sFile : inputFiles)
+    {
+      nsUniquePtr<MergeInput>& pInput = inputs.ExpandAndGetRef();
+      pInput = NS_DEFAULT_NEW(MergeInput);
+      if (pInput->m_Reader.Open(sFile).Failed())
+        return ReadFailed;
+    }
+
+    // the merged header: metadata of the first clip, the union of all custom channels, bodies and bookmarks
+    nsJvdClipMetadata metadata = inputs[0]->m_Reader.GetMetadata();
+    metadata.m_ClipGuid = nsUuid::MakeUuid();
+    metadata.m_CustomChannels.Clear();
+
+    nsDynamicArray<nsJvdBodyMetadata> bodies;
+    nsDynamicArray<nsJvdBookmark> bookmarks;
+    nsHashSet<nsUInt64> bodyIds;
+
+    for (nsUInt32 i = 0; i < inputs.GetCount(); ++i)
+    {
+      MergeInput& input = *inputs[i];
+
+      for (const nsJvdCustomChannelDesc& channel : input.m_Reader.GetMetadata().m_CustomChannels)
+      {
+        nsUInt32 uiMerged = 0;
+        while (uiMerged < metadata.m_CustomChannels.GetCount() && metadata.m_CustomChannels[uiMerged].m_sName != channel.m_sName)
+        {
+          ++uiMerged;
+        }
+
+        if (uiMerged == metadata.m_CustomChannels.GetCount())
+        {
+          metadata.m_CustomChannels.PushBack(channel);
+        }
+        else if (metadata.m_CustomChannels[uiMerged].m_Type != channel.m_Type)
+        {
+          nsLog::Error("Custom channel '{}' has different types in '{}' and an earlier clip.", channel.m_sName, inputFiles[i]);
+          return InvalidArguments;
+        }
+
+        input.m_ChannelRemap.PushBack(static_cast<nsUInt16>(uiMerged));
+      }
+
+      for (nsJvdBodyMetadata body : input.m_Reader.GetBodyMetadata())
+      {
+        if (bRemapIds)
+        {
+          body.m_uiBodyId = RemapBodyId(body.m_uiBodyId, i);
+        }
+
+        if (bodyIds.Insert(body.m_uiBodyId))
+        {
+          nsLog::Error("Body id {} of '{}' is already used by an earlier clip. Use -remapIds to keep the bodies apart.", body.m_uiBodyId, inputFiles[i]);
+          return InvalidArguments;
+        }
+
+        bodies.PushBack(body);
+      }
+
+      for (nsJvdBookmark bookmark : input.m_Reader.GetBookmarks())
+      {
+        if (bRemapIds)
+        {
+          bookmark.m_uiBodyId = RemapBodyId(bookmark.m_uiBodyId, i);
+        }
+
+        bookmarks.PushBack(bookmark);
+      }
+    }
+
+    bookmarks.Sort([](const nsJvdBookmark& a, const nsJvdBookmark& b)
+      { return a.m_uiFrameIndex < b.m_uiFrameIndex; });
+
+    nsJvdClipWriter writer;
+    if (writer.Open(sOutput, metadata, bodies, bookmarks, GetWriteSettings()).Failed())
+      return WriteFailed;
+
+    for (nsUniquePtr<MergeInput>& pInput : inputs)
+    {
+      pInput->m_bHasNext = pInput->m_Reader.HasMoreFrames() && pInput->m_Reader.ReadNextFrame(pInput->m_Next).Succeeded();
+    }
+
+    // clips without body metadata can still collide, so the ids are checked as the frames go by
+    nsHashTable<nsUInt64, nsUInt32> bodyOwners;
+
+    nsJvdFrame merged;
+    while (true)
+    {
+      // merge join on the frame index, the clips of one application step in lockstep
+      nsUInt64 uiFrameIndex = nsMath::MaxValue<nsUInt64>();
+      for (const nsUniquePtr<MergeInput>& pInput : inputs)
+      {
+        if (pInput->m_bHasNext)
+        {
+          uiFrameIndex = nsMath::Min(uiFrameIndex, pInput->m_Next.m_uiFrameIndex);
+        }
+      }
+
+      if (uiFrameIndex == nsMath::MaxValue<nsUInt64>())
+        break;
+
+      merged.m_uiFrameIndex = uiFrameIndex;
+      merged.m_Timestamp = nsTime::MakeFromHours(1000000);
+      merged.m_Bodies.Clear();
+
+      for (nsUniquePtr<MergeInput>& pInput : inputs)
+      {
+        if (pInput->m_bHasNext && pInput->m_Next.m_uiFrameIndex == uiFrameIndex)
+        {
+          pInput->Advance();
+          merged.m_Timestamp = nsMath::Min(merged.m_Timestamp, pInput->m_Current.m_Timestamp);
+        }
+      }
+
+      // inputs that skipped this frame index hold their last state, inputs that ended drop out
+      nsHybridArray<nsUInt32, 8> firstBody;
+      for (nsUInt32 i = 0; i < inputs.GetCount(); ++i)
+      {
+        MergeInput& input = *inputs[i];
+        firstBody.PushBack(merged.m_Bodies.GetCount());
+
+        if (!input.m_bHasCurrent || (!input.m_bHasNext && input.m_Current.m_uiFrameIndex != uiFrameIndex))
+          continue;
+
+        for (const nsJvdBodyState& state : input.m_Current.m_Bodies)
+        {
+          nsJvdBodyState& target = merged.m_Bodies.ExpandAndGetRef();
+          target = state;
+          if (bRemapIds)
+          {
+            target.m_uiBodyId = RemapBodyId(state.m_uiBodyId, i);
+          }
+          else if (!IsBodyOwner(bodyOwners, target.m_uiBodyId, i))
+          {
+            nsLog::Error("Body id {} of '{}' is already used by an earlier clip. Use -remapIds to keep the bodies apart.", target.m_uiBodyId, inputFiles[i]);
+            writer.Close().IgnoreResult();
+            return InvalidArguments;
+          }
+        }
+      }
+
+      merged.m_CustomChannels.SetCount(metadata.m_CustomChannels.GetCount());
+      for (nsUInt32 c = 0; c < metadata.m_CustomChannels.GetCount(); ++c)
+      {
+        merged.m_CustomChannels[c].Reset(metadata.m_CustomChannels[c].m_Type, merged.m_Bodies.GetCount());
+      }
+
+      for (nsUInt32 i = 0; i < inputs.GetCount(); ++i)
+      {
+        const MergeInput& input = *inputs[i];
+        const nsUInt32 uiBodyCount = (i + 1 < inputs.GetCount() ? firstBody[i + 1] : merged.m_Bodies.GetCount()) - firstBody[i];
+        if (uiBodyCount == 0)
+          continue;
+
+        for (nsUInt32 c = 0; c < nsMath::Min(input.m_Current.m_CustomChannels.GetCount(), input.m_ChannelRemap.GetCount()); ++c)
+        {
+          const nsJvdCustomChannelColumn& column = input.m_Current.m_CustomChannels[c];
+          nsJvdCustomChannelColumn& target = merged.m_CustomChannels[input.m_ChannelRemap[c]];
+          const nsUInt32 uiStride = column.GetStride();
+
+          for (nsUInt32 b = 0; b < nsMath::Min(column.GetBodyCount(), uiBodyCount); ++b)
+          {
+            if (column.HasValue(b))
+            {
+              target.SetRawValue(firstBody[i] + b, column.m_Values.GetData() + b * uiStride);
+            }
+          }
+        }
+      }
+
+      if (writer.WriteFrame(merged).Failed())
+        break;
+    }
+
+    const nsUInt64 uiFramesWritten = writer.GetNumFramesWritten();
+    if (writer.Close().Failed())
+      return WriteFailed;
+
+    nsLog::Info("Merged {} clips into '{}', {} frames", inputs.GetCount(), sOutput, uiFramesWritten);
+    return Success;
+  }
+
+  ReturnCode RunStats()
+  {
+    nsDynamicArray<nsString> inputs;
+    GetInputFiles(inputs);
+
+    if (inputs.IsEmpty())
+    {
+      nsLog::Error("'stats' expects at least one .jvdrec file.");
+      return InvalidArguments;
+    }
+
+    // every clip is read by its own task, the results are printed in order afterwards
+    nsDynamicArray<ClipStats> stats;
+    stats.SetCount(inputs.GetCount());
+
+    nsParallelForParams params;
+    params.m_uiBinSize = 1;
+
+    nsTaskSystem::ParallelForIndexed(0u, inputs.GetCount(), [&](nsUInt32 uiStart, nsUInt32 uiEnd)
+      {
+        for (nsUInt32 i = uiStart; i < uiEnd; ++i)
+        {
+          GatherClipStats(inputs[i], stats[i]).IgnoreResult();
+        }
+      },
+      "JvdTool Stats", nsTaskNesting::Never, params);
+
+    ReturnCode result = Success;
+    for (nsUInt32 i = 0; i < inputs.GetCount(); ++i)
+    {
+      PrintClipStats(inputs[i], stats[i]);
+
+      if (!stats[i].m_sError.IsEmpty())
+      {
+        result = ReadFailed;
+      }
+    }
+
+    return result;
+  }
+
+  ReturnCode RunDiff()
+  {
+    if (GetArgumentCount() < 4)
+    {
+      nsLog::Error("'diff' expects two .jvdrec files.");
+      return InvalidArguments;
+    }
+
+    const nsString sFileA = nsOSFile::MakePathAbsoluteWithCWD(GetArgument(2));
+    const nsString sFileB = nsOSFile::MakePathAbsoluteWithCWD(GetArgument(3));
+
+    nsJvdClipDiffSettings settings;
+    settings.m_Alignment = opt_Align.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified) == 1 ? nsJvdClipDiffAlignment::Timestamp : nsJvdClipDiffAlignment::FrameIndex;
+    settings.m_TimeTolerance = nsTime::MakeFromMilliseconds(opt_TimeTolerance.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified));
+    settings.m_fPositionTolerance = opt_PositionTolerance.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified);
+    settings.m_fRotationTolerance = opt_RotationTolerance.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified);
+    settings.m_uiNumWorstBodies = static_cast<nsUInt32>(opt_Top.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified));
+    settings.m_uiFramesPerBatch = static_cast<nsUInt32>(opt_Batch.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified));
+
+    nsLog::Info("Comparing '{}'", sFileA);
+    nsLog::Info("     with '{}'", sFileB);
+
+    nsJvdClipDiffResult result;
+    if (nsJvdClipDiff::CompareFiles(sFileA, sFileB, settings, result).Failed())
+      return ReadFailed;
+
+    nsLog::Info("Compared frames: {}", result.m_uiComparedFrameCount);
+
+    if (result.m_uiUnmatchedFrameCountA > 0 || result.m_uiUnmatchedFrameCountB > 0)
+    {
+      nsLog::Warning("Frames without a partner: {} in the first clip, {} in the second clip", result.m_uiUnmatchedFrameCountA, result.m_uiUnmatchedFrameCountB);
+    }
+
+    nsLog::Info("Max position error: {} m", result.m_fMaxPositionError);
+    nsLog::Info("Max rotation error: {} rad", result.m_fMaxRotationError);
+
+    if (result.m_bDiverged)
+    {
+      nsLog::Warning("First divergent frame: {} ({})", result.m_uiFirstDivergentFrameIndex, result.m_FirstDivergentTimestamp);
+    }
+
+    if (!result.m_WorstBodies.IsEmpty())
+    {
+      nsLog::Info("Worst bodies:");
+      for (const nsJvdClipDiffBodyError& body : result.m_WorstBodies)
+      {
+        nsLog::Info("  Body {}: position {} m, rotation {} rad, worst in frame {}, divergent in {} frames", body.m_uiBodyId, body.m_fMaxPositionError, body.m_fMaxRotationError, body.m_uiWorstFrameIndex, body.m_uiDivergentFrameCount);
+      }
+    }
+
+    const nsString sCurveFile = opt_Curve.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified);
+    if (!sCurveFile.IsEmpty())
+    {
+      if (WriteErrorCurve(sCurveFile, result).Failed())
+        return ReadFailed;
+
+      nsLog::Info("Wrote error curve to '{}'", sCurveFile);
+    }
+
+    if (!result.IsIdentical())
+    {
+      nsLog::Warning("Clips diverge");
+      return ClipsDiverge;
+    }
+
+    nsLog::Success("Clips match");
+    return Success;
+  }
+
+  /// The region options usually start with a negative number, which the option parser takes for the next option.
+  nsStringView GetRegionArgument(nsStringView sOption) const
+  {
+    for (nsUInt32 i = 2; i + 1 < GetArgumentCount(); ++i)
+    {
+      if (sOption.IsEqual_NoCase(GetArgument(i)))
+        return GetArgument(i + 1);
+    }
+
+    return {};
+  }
+
+  ReturnCode RunQuery()
+  {
+    nsDynamicArray<nsString> inputs;
+    GetInputFiles(inputs);
+
+    const nsStringView sBox = GetRegionArgument("-box");
+    const nsStringView sSphere = GetRegionArgument("-sphere");
+
+    float values[6] = {};
+    bool bValidRegion = false;
+    if (!sBox.IsEmpty() && sSphere.IsEmpty())
+    {
+      bValidRegion = nsConversionUtils::ExtractFloatsFromString(sBox, 6, values) == 6;
+    }
+    else if (sBox.IsEmpty() && !sSphere.IsEmpty())
+    {
+      bValidRegion = nsConversionUtils::ExtractFloatsFromString(sSphere, 4, values) == 4 && values[3] >= 0.0f;
+    }
+
+    if (inputs.GetCount() != 1 || !bValidRegion)
+    {
+      nsLog::Error("'query' expects one .jvdrec file and either a -box with six or a -sphere with four numbers.");
+      return InvalidArguments;
+    }
+
+    nsJvdClip clip;
+    if (nsJvdSerialization::LoadClipFromFile(inputs[0], clip).Failed())
+      return ReadFailed;
+
+    if (clip.IsEmpty())
+    {
+      nsLog::Warning("'{}' has no frames", inputs[0]);
+      return Success;
+    }
+
+    nsJvdSpatialIndex index;
+    index.Build(clip.GetFrames());
+
+    const nsTime firstTimestamp = clip.GetFrames()[0].m_Timestamp;
+    const nsTime start = firstTimestamp + nsTime::MakeFromSeconds(opt_Start.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified));
+    const nsTime end = opt_End.IsOptionSpecified() ? firstTimestamp + nsTime::MakeFromSeconds(opt_End.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified)) : nsTime::MakeFromHours(1000000);
+
+    nsUInt64 uiFirstFrameIndex = 0;
+    nsUInt64 uiLastFrameIndex = 0;
+    if (index.FindFrameRange(start, end, uiFirstFrameIndex, uiLastFrameIndex).Failed())
+    {
+      nsLog::Warning("No frames between {} and {}", start - firstTimestamp, end - firstTimestamp);
+      return Success;
+    }
+
+    nsDynamicArray<nsJvdSpatialHit> hits;
+    if (!sBox.IsEmpty())
+    {
+      nsBoundingBox box = nsBoundingBox::MakeInvalid();
+      box.ExpandToInclude(nsVec3(values[0], values[1], values[2]));
+      box.ExpandToInclude(nsVec3(values[3], values[4], values[5]));
+      index.QueryBox(box, uiFirstFrameIndex, uiLastFrameIndex, hits);
+    }
+    else
+    {
+      index.QuerySphere(nsBoundingSphere::MakeFromCenterAndRadius(nsVec3(values[0], values[1], values[2]), values[3]), uiFirstFrameIndex, uiLastFrameIndex, hits);
+    }
+
+    const nsUInt32 uiSampleCount = hits.GetCount();
+    nsJvdSpatialIndex::KeepFirstHitPerBody(hits);
+
+    nsLog::Info("{} bodies inside the region in frames {} to {} ({} positions)", hits.GetCount(), uiFirstFrameIndex, uiLastFrameIndex, uiSampleCount);
+
+    for (const nsJvdSpatialHit& hit : hits)
+    {
+      nsLog::Info("  body {}: first seen in frame {} at ({}, {}, {})", hit.m_uiBodyId, hit.m_uiFrameIndex, nsArgF(hit.m_vPosition.x, 2), nsArgF(hit.m_vPosition.y, 2), nsArgF(hit.m_vPosition.z, 2));
+    }
+
+    return Success;
+  }
+
+  ReturnCode RunSimplify()
+  {
+    nsDynamicArray<nsString> inputs;
+    GetInputFiles(inputs);
+
+    const nsString sOutput = GetOutputFile();
+    if (inputs.GetCount() != 1 || sOutput.IsEmpty())
+    {
+      nsLog::Error("'simplify' expects one .jvdrec file and an -out file.");
+      return InvalidArguments;
+    }
+
+    nsJvdSimplificationSettings settings;
+    if (opt_PositionTolerance.IsOptionSpecified())
+      settings.m_fPositionTolerance = opt_PositionTolerance.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified);
+    if (opt_RotationTolerance.IsOptionSpecified())
+      settings.m_fRotationTolerance = opt_RotationTolerance.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified);
+
+    nsJvdClip clip;
+    if (nsJvdSerialization::LoadClipFromFile(inputs[0], clip).Failed())
+      return ReadFailed;
+
+    nsJvdSimplifiedClip simplified;
+    simplified.Simplify(clip, settings);
+
+    if (simplified.SaveToFile(sOutput).Failed())
+      return WriteFailed;
+
+    const nsUInt64 uiSampleCount = nsMath::Max<nsUInt64>(simplified.GetSampleCount(), 1);
+    nsLog::Success("Wrote '{}': {} keys for {} body states ({} keys per 100 states)", sOutput, simplified.GetKeyCount(), simplified.GetSampleCount(), nsArgF(simplified.GetKeyCount() * 100.0 / uiSampleCount, 1));
+
+    if (!clip.GetMetadata().m_CustomChannels.IsEmpty())
+    {
+      nsLog::Warning("The {} custom channels of the clip are not kept", clip.GetMetadata().m_CustomChannels.GetCount());
+    }
+
+    return Success;
+  }
+
+  ReturnCode RunTrajectory()
+  {
+    nsDynamicArray<nsString> inputs;
+    GetInputFiles(inputs);
+
+    const nsString sOutput = GetOutputFile();
+
+    nsHybridArray<nsUInt64, 16> bodyIds;
+    {
+      const nsStringBuilder sBodies = opt_Bodies.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified);
+
+      nsHybridArray<nsStringView, 16> parts;
+      sBodies.Split(false, parts, " ", ",", ";");
+
+      for (nsStringView sPart : parts)
+      {
+        nsInt64 iBodyId = 0;
+        if (nsConversionUtils::StringToInt64(sPart, iBodyId).Failed() || iBodyId < 0)
+        {
+          nsLog::Error("'{}' is not a valid body id.", sPart);
+          return InvalidArguments;
+        }
+
+        bodyIds.PushBack(static_cast<nsUInt64>(iBodyId));
+      }
+    }
+
+    if (inputs.GetCount() != 1 || sOutput.IsEmpty() || bodyIds.IsEmpty())
+    {
+      nsLog::Error("'trajectory' expects one .jvdrec file, -bodies and -out.");
+      return InvalidArguments;
+    }
+
+    nsDynamicArray<nsJvdBodyTrajectory> trajectories;
+    trajectories.SetCount(bodyIds.GetCount());
+    for (nsUInt32 i = 0; i < bodyIds.GetCount(); ++i)
+    {
+      trajectories[i].m_uiBodyId = bodyIds[i];
+    }
+
+    if (nsJvdTrajectoryCache::BuildTrajectories(inputs[0], trajectories).Failed())
+      return ReadFailed;
+
+    nsFileWriter file;
+    if (file.Open(sOutput).Failed())
+    {
+      nsLog::Error("Failed to open '{}' for writing.", sOutput);
+      return WriteFailed;
+    }
+
+    if (nsJvdBodyTrajectory::WriteCsvHeader(file).Failed())
+      return WriteFailed;
+
+    nsUInt64 uiSampleCount = 0;
+    for (const nsJvdBodyTrajectory& trajectory : trajectories)
+    {
+      if (trajectory.IsEmpty())
+      {
+        nsLog::Warning("Body {} was not recorded in '{}'", trajectory.m_uiBodyId, inputs[0]);
+      }
+
+      if (trajectory.WriteCsv(file).Failed())
+        return WriteFailed;
+
+      uiSampleCount += trajectory.GetSampleCount();
+    }
+
+    nsLog::Success("Wrote {} samples of {} bodies to '{}'", uiSampleCount, trajectories.GetCount(), sOutput);
+    return Success;
+  }
+
+  ReturnCode RunTracks()
+  {
+    nsDynamicArray<nsString> inputs;
+    GetInputFiles(inputs);
+
+    const nsString sOutput = GetOutputFile();
+    if (inputs.GetCount() != 1 || sOutput.IsEmpty())
+    {
+      nsLog::Error("'tracks' expects one .jvdses file and an -out folder.");
+      return InvalidArguments;
+    }
+
+    nsDynamicArray<nsJvdClip> tracks;
+    if (nsJvdSerialization::LoadSessionFromFile(inputs[0], tracks).Failed())
+      return ReadFailed;
+
+    if (nsOSFile::CreateDirectoryStructure(sOutput).Failed())
+    {
+      nsLog::Error("Failed to create the output folder '{}'.", sOutput);
+      return WriteFailed;
+    }
+
+    const nsJvdClipWriteSettings settings = GetWriteSettings();
+
+    for (nsUInt32 i = 0; i < tracks.GetCount(); ++i)
+    {
+      // track names come from the application, they may not be valid file names
+      nsStringBuilder sName = tracks[i].GetMetadata().m_sClipName;
+      sName.ReplaceAll("/", "_");
+      sName.ReplaceAll("\\", "_");
+      sName.ReplaceAll(":", "_");
+      if (sName.IsEmpty())
+      {
+        sName.SetFormat("Track{}", i);
+      }
+
+      nsStringBuilder sTarget = sOutput;
+      sTarget.AppendPath(sName);
+      sTarget.Append(".jvdrec");
+
+      if (nsJvdSerialization::SaveClipToFile(sTarget, tracks[i], settings).Failed())
+        return WriteFailed;
+
+      nsLog::Info("Wrote track '{}' to '{}', {} frames", tracks[i].GetMetadata().m_sClipName, sTarget, tracks[i].GetFrames().GetCount());
+    }
+
+    nsLog::Success("Split '{}' into {} clips", inputs[0], tracks.GetCount());
+    return Success;
+  }
+
+  virtual void Run() override
+  {
+    {
+      nsStringBuilder cmdHelp;
+      if (nsCommandLineOption::LogAvailableOptionsToBuffer(cmdHelp, nsCommandLineOption::LogAvailableModes::IfHelpRequested, "_JvdTool"))
+      {
+        nsLog::Print(cmdHelp);
+        RequestApplicationQuit();
+        return;
+      }
+    }
+
+    nsStopwatch sw;
+
+    const nsStringView sCommand = GetArgumentCount() > 1 ? GetArgument(1) : nsStringView();
+
+    if (sCommand.IsEqual_NoCase("convert"))
+    {
+      SetReturnCode(RunConvert());
+    }
+    else if (sCommand.IsEqual_NoCase("cut"))
+    {
+      SetReturnCode(RunCut());
+    }
+    else if (sCommand.IsEqual_NoCase("decimate"))
+    {
+      SetReturnCode(RunDecimate());
+    }
+    else if (sCommand.IsEqual_NoCase("merge"))
+    {
+      SetReturnCode(RunMerge());
+    }
+    else if (sCommand.IsEqual_NoCase("stats"))
+    {
+      SetReturnCode(RunStats());
+    }
+    else if (sCommand.IsEqual_NoCase("diff"))
+    {
+      SetReturnCode(RunDiff());
+    }
+    else if (sCommand.IsEqual_NoCase("query"))
+    {
+      SetReturnCode(RunQuery());
+    }
+    else if (sCommand.IsEqual_NoCase("simplify"))
+    {
+      SetReturnCode(RunSimplify());
+    }
+    else if (sCommand.IsEqual_NoCase("trajectory"))
+    {
+      SetReturnCode(RunTrajectory());
+    }
+    else if (sCommand.IsEqual_NoCase("tracks"))
+    {
+      SetReturnCode(RunTracks());
+    }
+    else
+    {
+      nsLog::Error("Unknown command '{}'. Use -help to list the available commands.", sCommand);
+      SetReturnCode(InvalidArguments);
+    }
+
+    nsLog::Info("Finished in {}", sw.GetRunningTotal());
+    RequestApplicationQuit();
+  }
+};
+
+NS_APPLICATION_ENTRY_POINT(nsJvdTool);
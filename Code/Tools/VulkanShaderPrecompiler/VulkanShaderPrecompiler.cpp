@@ -0,0 +1,95 @@
+#include <Foundation/Application/Application.h>
+#include <Foundation/IO/FileSystem/FileSystem.h>
+#include <Foundation/Logging/ConsoleWriter.h>
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Logging/VisualStudioWriter.h>
+#include <Foundation/Strings/StringBuilder.h>
+#include <Foundation/Utilities/CommandLineOptions.h>
+
+#include <VulkanRenderer/Core/VkShaderCache.h>
+#include <VulkanRenderer/DxcSupport.h>
+#include <VulkanRenderer/VulkanRendererModule.h>
+
+/* VulkanShaderPrecompiler usage:
+
+nsVulkanShaderPrecompiler.exe [-out <folder>]
+
+Compiles every shader of the Vulkan viewport to SPIR-V and stores it where the viewer looks for precompiled shaders.
+Runs automatically after the tool is built. Without DXC nothing is written and the viewer compiles on its first start.
+*/
+
+nsCommandLineOptionPath opt_Out("_VulkanShaderPrecompiler", "-out", "The folder to write the SPIR-V files to. Defaults to 'VulkanShaders' next to the executable.", "");
+
+class nsVulkanShaderPrecompiler : public nsApplication
+{
+public:
+  using SUPER = nsApplication;
+
+  enum ReturnCode
+  {
+    Success = 0,
+    CompileFailed = 1,
+  };
+
+  nsVulkanShaderPrecompiler()
+    : nsApplication("VulkanShaderPrecompiler")
+  {
+  }
+
+  virtual void AfterCoreSystemsStartup() override
+  {
+    // Add the empty data directory to access files via absolute paths
+    nsFileSystem::AddDataDirectory("", "App", ":", nsDataDirUsage::AllowWrites).IgnoreResult();
+
+    nsGlobalLog::AddLogWriter(nsLogWriter::Console::LogMessageHandler);
+    nsGlobalLog::AddLogWriter(nsLogWriter::VisualStudio::LogMessageHandler);
+  }
+
+  virtual void BeforeCoreSystemsShutdown() override
+  {
+    // prevent further output during shutdown
+    nsGlobalLog::RemoveLogWriter(nsLogWriter::Console::LogMessageHandler);
+    nsGlobalLog::RemoveLogWriter(nsLogWriter::VisualStudio::LogMessageHandler);
+
+    SUPER::BeforeCoreSystemsShutdown();
+  }
+
+  virtual void Run() override
+  {
+    {
+      nsStringBuilder cmdHelp;
+      if (nsCommandLineOption::LogAvailableOptionsToBuffer(cmdHelp, nsCommandLineOption::LogAvailableModes::IfHelpRequested, "_VulkanShaderPrecompiler"))
+      {
+        nsLog::Print(cmdHelp);
+        RequestApplicationQuit();
+        return;
+      }
+    }
+
+    RequestApplicationQuit();
+
+    // a build machine without DXC still produces a working viewer, it only loses the faster first start
+    nsVulkanDxc::CreateInstanceProc pfnCreateInstance = nullptr;
+    if (nsVulkanDxc::ResolveCreateInstance(pfnCreateInstance).Failed())
+    {
+      nsLog::Warning("DXC is not available, skipping shader precompilation.");
+      return;
+    }
+
+    nsString sOutFolder = opt_Out.GetOptionValue(nsCommandLineOption::LogMode::AlwaysIfSpecified);
+    if (sOutFolder.IsEmpty())
+    {
+      sOutFolder = nsVkShaderCache::GetPrecompiledFolder();
+    }
+
+    for (const nsVkShaderDesc& desc : nsVulkanRenderer::GetShaderDescs())
+    {
+      if (nsVkShaderCache::Precompile(desc, sOutFolder).Failed())
+      {
+        SetReturnCode(CompileFailed);
+      }
+    }
+  }
+};
+
+NS_APPLICATION_ENTRY_POINT(nsVulkanShaderPrecompiler);
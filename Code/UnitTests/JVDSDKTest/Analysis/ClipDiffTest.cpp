@@ -0,0 +1,187 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+#include <Foundation/IO/FileSystem/FileSystem.h>
+#include <TestFramework/Utilities/TestLogInterface.h>
+
+NS_CREATE_SIMPLE_TEST_GROUP(Analysis);
+
+namespace
+{
+  nsJvdClip MakeDiffClip(nsUInt32 uiFrameCount, nsUInt32 uiBodyCount)
+  {
+    nsJvdClip clip;
+
+    for (nsUInt32 f = 0; f < uiFrameCount; ++f)
+    {
+      nsJvdFrame frame;
+      frame.m_uiFrameIndex = f;
+      frame.m_Timestamp = nsTime::MakeFromSeconds(f / 60.0);
+
+      for (nsUInt32 i = 0; i < uiBodyCount; ++i)
+      {
+        nsJvdBodyState& state = frame.m_Bodies.ExpandAndGetRef();
+        state.m_uiBodyId = 100 + i;
+        state.m_vPosition.Set(static_cast<float>(i), f * 0.1f, 0.0f);
+        state.m_qRotation = nsQuat::MakeFromAxisAndAngle(nsVec3(0, 1, 0), nsAngle::MakeFromDegree(static_cast<float>(f + i)));
+      }
+
+      clip.AddFrame(std::move(frame));
+    }
+
+    return clip;
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Analysis, ClipDiff)
+{
+  nsJvdClipDiffSettings settings;
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Identical clips")
+  {
+    const nsJvdClip clip = MakeDiffClip(50, 11);
+
+    nsJvdClipDiffResult result;
+    nsJvdClipDiff::CompareClips(clip, clip, settings, result);
+
+    NS_TEST_BOOL(result.IsIdentical());
+    NS_TEST_INT(result.m_uiComparedFrameCount, 50);
+    NS_TEST_INT(result.m_ErrorCurve.GetCount(), 50);
+    NS_TEST_BOOL(result.m_WorstBodies.IsEmpty());
+    NS_TEST_FLOAT(result.m_fMaxPositionError, 0.0f, 0.0f);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Divergent bodies")
+  {
+    const nsJvdClip clipA = MakeDiffClip(50, 11);
+    nsJvdClip clipB = MakeDiffClip(50, 11);
+
+    for (nsUInt32 f = 20; f < 50; ++f)
+    {
+      nsDynamicArray<nsJvdBodyState>& bodies = clipB.GetFrames()[f].m_Bodies;
+      bodies[3].m_vPosition.x += 0.01f * (f - 19);
+      bodies[7].m_qRotation = nsQuat::MakeFromAxisAndAngle(nsVec3(0, 1, 0), nsAngle::MakeFromDegree(static_cast<float>(f + 7) + 1.0f));
+
+      // a different body order must not matter
+      nsMath::Swap(bodies[0], bodies[10]);
+    }
+
+    settings.m_uiFramesPerBatch = 8;
+    settings.m_uiNumWorstBodies = 5;
+
+    nsJvdClipDiffResult result;
+    nsJvdClipDiff::CompareClips(clipA, clipB, settings, result);
+
+    NS_TEST_BOOL(result.m_bDiverged);
+    NS_TEST_INT(result.m_uiFirstDivergentFrameIndex, 20);
+    NS_TEST_INT(result.m_uiComparedFrameCount, 50);
+    NS_TEST_FLOAT(result.m_fMaxPositionError, 0.3f, 0.0001f);
+    NS_TEST_FLOAT(result.m_fMaxRotationError, nsAngle::MakeFromDegree(1.0f).GetRadian(), 0.0001f);
+
+    // 1 degree is 174 times the rotation tolerance, 30cm is 3000 times the position tolerance
+    NS_TEST_INT(result.m_WorstBodies.GetCount(), 2);
+    NS_TEST_INT(result.m_WorstBodies[0].m_uiBodyId, 103);
+    NS_TEST_INT(result.m_WorstBodies[0].m_uiFirstDivergentFrameIndex, 20);
+    NS_TEST_INT(result.m_WorstBodies[0].m_uiDivergentFrameCount, 30);
+    NS_TEST_INT(result.m_WorstBodies[0].m_uiWorstFrameIndex, 49);
+    NS_TEST_INT(result.m_WorstBodies[1].m_uiBodyId, 107);
+
+    NS_TEST_INT(result.m_ErrorCurve[19].m_uiDivergentBodyCount, 0);
+    NS_TEST_INT(result.m_ErrorCurve[20].m_uiDivergentBodyCount, 2);
+    NS_TEST_INT(result.m_ErrorCurve[20].m_uiMatchedBodyCount, 11);
+    NS_TEST_FLOAT(result.m_ErrorCurve[29].m_fMaxPositionError, 0.1f, 0.0001f);
+    NS_TEST_FLOAT(result.m_ErrorCurve[29].m_fMeanPositionError, 0.1f / 11.0f, 0.0001f);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Alignment")
+  {
+    const nsJvdClip clipA = MakeDiffClip(40, 5);
+
+    // the second clip misses some frames and one body, and runs on a slightly shifted clock
+    nsJvdClip clipB;
+    for (const nsJvdFrame& frame : clipA.GetFrames())
+    {
+      if (frame.m_uiFrameIndex % 10 == 5)
+        continue;
+
+      nsJvdFrame copy = frame;
+      copy.m_Timestamp += nsTime::MakeFromMicroseconds(100);
+      if (frame.m_uiFrameIndex == 30)
+      {
+        copy.m_Bodies.RemoveAtAndCopy(2);
+      }
+      clipB.AddFrame(std::move(copy));
+    }
+
+    settings = nsJvdClipDiffSettings();
+    settings.m_uiFramesPerBatch = 3;
+
+    nsJvdClipDiffResult result;
+    nsJvdClipDiff::CompareClips(clipA, clipB, settings, result);
+
+    NS_TEST_INT(result.m_uiComparedFrameCount, 36);
+    NS_TEST_INT(result.m_uiUnmatchedFrameCountA, 4);
+    NS_TEST_INT(result.m_uiUnmatchedFrameCountB, 0);
+    NS_TEST_BOOL(result.m_bDiverged);
+    NS_TEST_INT(result.m_uiFirstDivergentFrameIndex, 30);
+
+    settings.m_Alignment = nsJvdClipDiffAlignment::Timestamp;
+    nsJvdClipDiff::CompareClips(clipA, clipB, settings, result);
+    NS_TEST_INT(result.m_uiComparedFrameCount, 36);
+    NS_TEST_INT(result.m_uiUnmatchedFrameCountA, 4);
+
+    // the clocks do not agree within a tolerance of 50us
+    settings.m_TimeTolerance = nsTime::MakeFromMicroseconds(50);
+    nsJvdClipDiff::CompareClips(clipA, clipB, settings, result);
+    NS_TEST_INT(result.m_uiComparedFrameCount, 0);
+    NS_TEST_INT(result.m_uiUnmatchedFrameCountA, 40);
+    NS_TEST_INT(result.m_uiUnmatchedFrameCountB, 36);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Streaming from disk")
+  {
+    nsStringBuilder sWriteDir = nsTestFramework::GetInstance()->GetAbsOutputPath();
+    NS_TEST_BOOL(nsFileSystem::AddDataDirectory(sWriteDir, "ClipDiff", "output", nsDataDirUsage::AllowWrites) == NS_SUCCESS);
+
+    const nsJvdClip clipA = MakeDiffClip(100, 7);
+    nsJvdClip clipB = MakeDiffClip(100, 7);
+    clipB.GetFrames()[64].m_Bodies[2].m_vPosition.y = nsMath::NaN<float>();
+
+    NS_TEST_BOOL(nsJvdSerialization::SaveClipToFile(":output/DiffA.jvdrec", clipA).Succeeded());
+    NS_TEST_BOOL(nsJvdSerialization::SaveClipToFile(":output/DiffB.jvdrec", clipB).Succeeded());
+
+    nsJvdClipReader reader;
+    NS_TEST_BOOL(reader.Open(":output/DiffB.jvdrec").Succeeded());
+    NS_TEST_INT(reader.GetFrameCount(), 100);
+
+    nsJvdFrame frame;
+    NS_TEST_BOOL(reader.ReadNextFrame(frame).Succeeded());
+    NS_TEST_INT(reader.GetNumFramesRead(), 1);
+    NS_TEST_INT(frame.m_Bodies.GetCount(), 7);
+    reader.Close();
+
+    settings = nsJvdClipDiffSettings();
+    settings.m_uiFramesPerBatch = 16;
+
+    nsJvdClipDiffResult result;
+    NS_TEST_BOOL(nsJvdClipDiff::CompareFiles(":output/DiffA.jvdrec", ":output/DiffB.jvdrec", settings, result).Succeeded());
+
+    NS_TEST_INT(result.m_uiComparedFrameCount, 100);
+    NS_TEST_BOOL(result.m_bDiverged);
+    NS_TEST_INT(result.m_uiFirstDivergentFrameIndex, 64);
+    NS_TEST_INT(result.m_WorstBodies.GetCount(), 1);
+    NS_TEST_INT(result.m_WorstBodies[0].m_uiBodyId, 102);
+    NS_TEST_BOOL(!nsMath::IsFinite(result.m_fMaxPositionError));
+
+    {
+      nsTestLogInterface log;
+      nsTestLogSystemScope logSystemScope(&log);
+      log.ExpectMessage("Failed to open ':output/Missing.jvdrec'", nsLogMsgType::ErrorMsg);
+
+      NS_TEST_BOOL(nsJvdClipDiff::CompareFiles(":output/DiffA.jvdrec", ":output/Missing.jvdrec", settings, result).Failed());
+    }
+
+    nsFileSystem::DeleteFile(":output/DiffA.jvdrec");
+    nsFileSystem::DeleteFile(":output/DiffB.jvdrec");
+    nsFileSystem::RemoveDataDirectoryGroup("ClipDiff");
+  }
+}
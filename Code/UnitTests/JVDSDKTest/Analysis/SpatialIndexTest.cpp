@@ -0,0 +1,166 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+namespace
+{
+  /// Body i moves along +x with i m/s, starting at (0, i, 0). Body 999 sits at the origin and breaks in frame 40.
+  nsJvdClip MakeSpatialClip(nsUInt32 uiFrameCount, nsUInt32 uiBodyCount)
+  {
+    nsJvdClip clip;
+
+    for (nsUInt32 f = 0; f < uiFrameCount; ++f)
+    {
+      nsJvdFrame frame;
+      frame.m_uiFrameIndex = 10 + 2 * f; // gaps must not matter
+      frame.m_Timestamp = nsTime::MakeFromSeconds(f / 10.0);
+
+      for (nsUInt32 i = 0; i < uiBodyCount; ++i)
+      {
+        nsJvdBodyState& state = frame.m_Bodies.ExpandAndGetRef();
+        state.m_uiBodyId = i;
+        state.m_vPosition.Set(i * f / 10.0f, static_cast<float>(i), 0.0f);
+      }
+
+      nsJvdBodyState& broken = frame.m_Bodies.ExpandAndGetRef();
+      broken.m_uiBodyId = 999;
+      broken.m_vPosition = f == 40 ? nsVec3(nsMath::NaN<float>()) : nsVec3::MakeZero();
+
+      clip.AddFrame(std::move(frame));
+    }
+
+    return clip;
+  }
+
+  /// Brute force reference for the box queries.
+  nsUInt32 CountInBox(const nsJvdClip& clip, const nsBoundingBox& box, nsUInt64 uiFirstFrameIndex, nsUInt64 uiLastFrameIndex)
+  {
+    nsUInt32 uiCount = 0;
+    for (const nsJvdFrame& frame : clip.GetFrames())
+    {
+      if (frame.m_uiFrameIndex < uiFirstFrameIndex || frame.m_uiFrameIndex > uiLastFrameIndex)
+        continue;
+
+      for (const nsJvdBodyState& state : frame.m_Bodies)
+      {
+        uiCount += state.m_vPosition.IsValid() && box.Contains(state.m_vPosition) ? 1 : 0;
+      }
+    }
+    return uiCount;
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Analysis, SpatialIndex)
+{
+  const nsJvdClip clip = MakeSpatialClip(200, 50);
+
+  nsJvdSpatialIndexSettings settings;
+  settings.m_uiFramesPerWindow = 16;
+
+  nsJvdSpatialIndex index;
+  index.Build(clip.GetFrames(), settings);
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Build")
+  {
+    NS_TEST_INT(index.GetFrameCount(), 200);
+    NS_TEST_INT(index.GetWindowCount(), 13);
+    NS_TEST_BOOL(index.GetBounds().IsValid());
+    NS_TEST_FLOAT(index.GetBounds().m_vMax.x, 49 * 19.9f, 0.01f);
+    NS_TEST_FLOAT(index.GetBounds().m_vMax.y, 49.0f, 0.0f);
+    NS_TEST_BOOL(index.GetHeapMemoryUsage() > 200 * 51 * sizeof(nsVec3));
+
+    nsJvdSpatialIndex asyncIndex;
+    nsTaskSystem::WaitForGroup(asyncIndex.BuildAsync(clip, settings));
+    NS_TEST_INT(asyncIndex.GetWindowCount(), 13);
+    NS_TEST_BOOL(asyncIndex.GetBounds() == index.GetBounds());
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Box")
+  {
+    nsDynamicArray<nsJvdSpatialHit> hits;
+
+    // which bodies passed through a volume at x = 10, within the first 10 seconds (frame indices 10 to 208)
+    const nsBoundingBox trigger = nsBoundingBox::MakeFromMinMax(nsVec3(9.0f, 10.5f, -1.0f), nsVec3(11.0f, 20.5f, 1.0f));
+    NS_TEST_INT(index.QueryBox(trigger, 10, 208, hits), CountInBox(clip, trigger, 10, 208));
+
+    nsJvdSpatialIndex::KeepFirstHitPerBody(hits);
+
+    // body i is within the volume from frame 90 / i to 110 / i, so all of 11 to 20 are seen there
+    NS_TEST_INT(hits.GetCount(), 10);
+    for (const nsJvdSpatialHit& hit : hits)
+    {
+      NS_TEST_BOOL(hit.m_uiBodyId >= 11 && hit.m_uiBodyId <= 20);
+      NS_TEST_BOOL(trigger.Contains(hit.m_vPosition));
+    }
+
+    // the hits are sorted by frame and body, 18 to 20 all reach the volume in frame 5
+    NS_TEST_INT(hits[0].m_uiBodyId, 18);
+    NS_TEST_INT(hits[0].m_uiFrameIndex, 10 + 2 * 5);
+    NS_TEST_INT(hits[2].m_uiBodyId, 20);
+
+    // frame ranges that start and end inside of windows
+    for (nsUInt64 uiFirst : {10ull, 11ull, 41ull, 100ull})
+    {
+      for (nsUInt64 uiLast : {12ull, 73ull, 250ull, 408ull, 1000ull})
+      {
+        const nsBoundingBox box = nsBoundingBox::MakeFromMinMax(nsVec3(-1.0f, 2.5f, -1.0f), nsVec3(30.0f, 40.5f, 1.0f));
+        NS_TEST_INT(index.QueryBox(box, uiFirst, uiLast, hits), CountInBox(clip, box, uiFirst, uiLast));
+      }
+    }
+
+    NS_TEST_INT(index.QueryBox(trigger, 1000, 2000, hits), 0);
+    NS_TEST_INT(index.QueryBox(trigger, 50, 40, hits), 0);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Sphere")
+  {
+    nsDynamicArray<nsJvdSpatialHit> hits;
+
+    // what was near body 999 just before and when it broke in frame 40 (frame index 90)
+    index.QuerySphere(nsBoundingSphere::MakeFromCenterAndRadius(nsVec3::MakeZero(), 1.5f), 88, 90, hits);
+
+    NS_TEST_INT(hits.GetCount(), 3);
+    NS_TEST_INT(hits[0].m_uiBodyId, 0);
+    NS_TEST_INT(hits[0].m_uiFrameIndex, 88);
+    NS_TEST_INT(hits[1].m_uiBodyId, 999);
+    NS_TEST_INT(hits[2].m_uiBodyId, 0);
+    NS_TEST_INT(hits[2].m_uiFrameIndex, 90);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Ray")
+  {
+    nsDynamicArray<nsJvdSpatialHit> hits;
+
+    // a ray along +y at x = 0 passes every body in the first frame, sorted by distance
+    index.QueryRay(nsVec3(0.0f, -5.0f, 0.0f), nsVec3(0.0f, 1.0f, 0.0f), 100.0f, 0.01f, 10, 10, hits);
+    NS_TEST_INT(hits.GetCount(), 51);
+    NS_TEST_INT(hits[0].m_uiBodyId, 0);
+    NS_TEST_FLOAT(hits[0].m_fDistance, 5.0f, 0.0001f);
+    NS_TEST_INT(hits[50].m_uiBodyId, 49);
+
+    // too short to reach body 3
+    index.QueryRay(nsVec3(0.0f, -5.0f, 0.0f), nsVec3(0.0f, 1.0f, 0.0f), 7.5f, 0.01f, 10, 10, hits);
+    NS_TEST_INT(hits.GetCount(), 4);
+
+    // in the last frame only the bodies 0 and 999 are still at x = 0
+    index.QueryRay(nsVec3(0.0f, -5.0f, 0.0f), nsVec3(0.0f, 1.0f, 0.0f), 100.0f, 0.5f, 408, 408, hits);
+    NS_TEST_INT(hits.GetCount(), 2);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Time range")
+  {
+    nsUInt64 uiFirst = 0;
+    nsUInt64 uiLast = 0;
+    NS_TEST_BOOL(index.FindFrameRange(nsTime::MakeFromSeconds(1.0), nsTime::MakeFromSeconds(2.05), uiFirst, uiLast).Succeeded());
+    NS_TEST_INT(uiFirst, 30);
+    NS_TEST_INT(uiLast, 50);
+
+    NS_TEST_BOOL(index.FindFrameRange(nsTime::MakeFromSeconds(1.01), nsTime::MakeFromSeconds(1.05), uiFirst, uiLast).Failed());
+    NS_TEST_BOOL(index.FindFrameRange(nsTime::MakeFromSeconds(100.0), nsTime::MakeFromSeconds(200.0), uiFirst, uiLast).Failed());
+
+    nsJvdSpatialIndex empty;
+    empty.Build(nsArrayPtr<const nsJvdFrame>());
+    NS_TEST_BOOL(empty.IsEmpty());
+
+    nsDynamicArray<nsJvdSpatialHit> hits;
+    NS_TEST_INT(empty.QueryBox(nsBoundingBox::MakeFromMinMax(nsVec3(-1), nsVec3(1)), 0, 100, hits), 0);
+  }
+}
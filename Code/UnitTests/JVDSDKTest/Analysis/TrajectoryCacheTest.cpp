@@ -0,0 +1,166 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+#include <Foundation/IO/FileSystem/FileSystem.h>
+#include <Foundation/IO/MemoryStream.h>
+#include <TestFramework/Utilities/TestLogInterface.h>
+
+namespace
+{
+  /// Body i exists from frame i on, bodies swap their place in the body array every frame.
+  nsJvdClip MakeTrajectoryClip(nsUInt32 uiFrameCount, nsUInt32 uiBodyCount)
+  {
+    nsJvdClip clip;
+
+    for (nsUInt32 f = 0; f < uiFrameCount; ++f)
+    {
+      nsJvdFrame frame;
+      frame.m_uiFrameIndex = f;
+      frame.m_Timestamp = nsTime::MakeFromSeconds(f / 60.0);
+
+      for (nsUInt32 i = 0; i < nsMath::Min(f + 1, uiBodyCount); ++i)
+      {
+        nsJvdBodyState& state = frame.m_Bodies.ExpandAndGetRef();
+        state.m_uiBodyId = 100 + i;
+        state.m_vPosition.Set(static_cast<float>(f), static_cast<float>(i), 0.0f);
+        state.m_vLinearVelocity.Set(static_cast<float>(i), 0.0f, 0.0f);
+        state.m_bIsSleeping = (f % 10) == 0;
+      }
+
+      if (f % 2 == 1)
+      {
+        const nsUInt32 uiCount = frame.m_Bodies.GetCount();
+        for (nsUInt32 i = 0; i < uiCount / 2; ++i)
+        {
+          nsMath::Swap(frame.m_Bodies[i], frame.m_Bodies[uiCount - 1 - i]);
+        }
+      }
+
+      clip.AddFrame(std::move(frame));
+    }
+
+    return clip;
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Analysis, TrajectoryCache)
+{
+  const nsJvdClip clip = MakeTrajectoryClip(300, 20);
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "From clip")
+  {
+    nsJvdTrajectoryCache cache;
+    cache.SetClip(&clip);
+
+    nsSharedPtr<const nsJvdBodyTrajectory> pTrajectory = cache.GetTrajectory(105);
+    NS_TEST_BOOL(pTrajectory != nullptr);
+    NS_TEST_INT(pTrajectory->m_uiBodyId, 105);
+    NS_TEST_INT(pTrajectory->GetSampleCount(), 295);
+    NS_TEST_INT(pTrajectory->m_FrameIndices[0], 5);
+    NS_TEST_INT(pTrajectory->m_FrameIndices.PeekBack(), 299);
+    NS_TEST_BOOL(pTrajectory->m_Positions[10] == nsVec3(15.0f, 5.0f, 0.0f));
+    NS_TEST_BOOL(pTrajectory->m_Positions[11] == nsVec3(16.0f, 5.0f, 0.0f));
+    NS_TEST_BOOL(pTrajectory->m_LinearVelocities[0] == nsVec3(5.0f, 0.0f, 0.0f));
+    NS_TEST_BOOL(pTrajectory->m_Sleeping.IsBitSet(5));
+    NS_TEST_BOOL(!pTrajectory->m_Sleeping.IsBitSet(6));
+    NS_TEST_DOUBLE(pTrajectory->m_Timestamps[0].GetSeconds(), 5 / 60.0, 0.000001);
+
+    // cached
+    NS_TEST_INT(cache.GetBuildCount(), 1);
+    NS_TEST_BOOL(cache.GetTrajectory(105) == pTrajectory);
+    NS_TEST_INT(cache.GetBuildCount(), 1);
+
+    // a body that was never recorded
+    NS_TEST_BOOL(cache.GetTrajectory(7)->IsEmpty());
+
+    nsUInt64 bodyIds[] = {100, 105, 119, 100};
+    nsDynamicArray<nsSharedPtr<const nsJvdBodyTrajectory>> trajectories;
+    NS_TEST_BOOL(cache.GetTrajectories(bodyIds, trajectories).Succeeded());
+    NS_TEST_INT(trajectories.GetCount(), 4);
+    NS_TEST_INT(trajectories[0]->GetSampleCount(), 300);
+    NS_TEST_BOOL(trajectories[1] == pTrajectory);
+    NS_TEST_INT(trajectories[2]->GetSampleCount(), 281);
+    NS_TEST_BOOL(trajectories[3] == trajectories[0]);
+    NS_TEST_INT(cache.GetBuildCount(), 4);
+    NS_TEST_INT(cache.GetCachedCount(), 4);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Eviction")
+  {
+    nsJvdTrajectoryCache cache;
+    cache.SetClip(&clip);
+
+    nsSharedPtr<const nsJvdBodyTrajectory> pFirst = cache.GetTrajectory(100);
+    const nsUInt64 uiTrajectorySize = cache.GetMemoryUsage();
+    NS_TEST_BOOL(uiTrajectorySize > 300 * (sizeof(nsVec3) * 3 + sizeof(nsQuat)));
+
+    // room for about two trajectories
+    cache.SetMemoryBudget(uiTrajectorySize * 5 / 2);
+    cache.GetTrajectory(101);
+    cache.GetTrajectory(100);
+    cache.GetTrajectory(102);
+
+    // 101 was used least recently
+    NS_TEST_INT(cache.GetCachedCount(), 2);
+    NS_TEST_BOOL(cache.GetMemoryUsage() <= cache.GetMemoryBudget());
+    NS_TEST_INT(cache.GetBuildCount(), 3);
+
+    NS_TEST_BOOL(cache.GetTrajectory(100) == pFirst);
+    NS_TEST_INT(cache.GetBuildCount(), 3);
+    cache.GetTrajectory(101);
+    NS_TEST_INT(cache.GetBuildCount(), 4);
+
+    // evicted trajectories stay valid for their users
+    cache.SetMemoryBudget(0);
+    NS_TEST_INT(cache.GetCachedCount(), 0);
+    NS_TEST_INT(pFirst->GetSampleCount(), 300);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "From file")
+  {
+    nsStringBuilder sWriteDir = nsTestFramework::GetInstance()->GetAbsOutputPath();
+    NS_TEST_BOOL(nsFileSystem::AddDataDirectory(sWriteDir, "TrajectoryCache", "output", nsDataDirUsage::AllowWrites) == NS_SUCCESS);
+
+    NS_TEST_BOOL(nsJvdSerialization::SaveClipToFile(":output/Trajectories.jvdrec", clip).Succeeded());
+
+    nsJvdTrajectoryCache cache;
+    cache.SetClipFile(":output/Trajectories.jvdrec");
+
+    nsUInt64 bodyIds[] = {103, 110};
+    nsDynamicArray<nsSharedPtr<const nsJvdBodyTrajectory>> trajectories;
+    NS_TEST_BOOL(cache.GetTrajectories(bodyIds, trajectories).Succeeded());
+    NS_TEST_INT(trajectories[0]->GetSampleCount(), 297);
+    NS_TEST_INT(trajectories[1]->GetSampleCount(), 290);
+    NS_TEST_BOOL(trajectories[1]->m_Positions[0] == nsVec3(10.0f, 10.0f, 0.0f));
+
+    nsDefaultMemoryStreamStorage storage;
+    nsMemoryStreamWriter writer(&storage);
+    NS_TEST_BOOL(nsJvdBodyTrajectory::WriteCsvHeader(writer).Succeeded());
+    NS_TEST_BOOL(trajectories[0]->WriteCsv(writer).Succeeded());
+
+    nsDynamicArray<char> text;
+    text.SetCount(storage.GetStorageSize32() + 1);
+    nsMemoryStreamReader reader(&storage);
+    reader.ReadBytes(text.GetData(), storage.GetStorageSize32());
+
+    nsStringBuilder sCsv = text.GetData();
+
+    nsDynamicArray<nsStringView> lines;
+    sCsv.Split(false, lines, "\n");
+    NS_TEST_INT(lines.GetCount(), 298);
+    NS_TEST_BOOL(lines[1].StartsWith("103,3,0.05,3,3,0,"));
+    NS_TEST_BOOL(lines[1].EndsWith(",0"));
+
+    nsJvdTrajectoryCache missing;
+    missing.SetClipFile(":output/Missing.jvdrec");
+    {
+      nsTestLogInterface log;
+      nsTestLogSystemScope logSystemScope(&log);
+      log.ExpectMessage("Failed to open ':output/Missing.jvdrec'", nsLogMsgType::ErrorMsg);
+
+      NS_TEST_BOOL(missing.GetTrajectory(100) == nullptr);
+    }
+
+    nsFileSystem::DeleteFile(":output/Trajectories.jvdrec");
+    nsFileSystem::RemoveDataDirectoryGroup("TrajectoryCache");
+  }
+}
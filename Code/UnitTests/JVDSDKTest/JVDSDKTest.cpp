@@ -0,0 +1,6 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+#include <TestFramework/Framework/TestFramework.h>
+#include <TestFramework/Utilities/TestSetup.h>
+
+NS_TESTFRAMEWORK_ENTRY_POINT("JVDSDKTest", "JVD SDK Tests")
@@ -0,0 +1 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <TestFramework/Framework/TestFramework.h>
+
+#include <Foundation/Basics.h>
+#include <Foundation/Containers/DynamicArray.h>
+#include <Foundation/IO/MemoryStream.h>
+
+#include <JVDSDK/JVDSDK.h>
@@ -0,0 +1,99 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+#include <Foundation/IO/MemoryStream.h>
+#include <TestFramework/Utilities/TestLogInterface.h>
+
+namespace
+{
+  /// A typical scene: most bodies sleep, a few fall and spin.
+  void SerializeLiveFrame(nsUInt32 f, nsDynamicArray<nsUInt8>& out_data)
+  {
+    nsJvdFrame frame;
+    frame.m_uiFrameIndex = f;
+    frame.m_Timestamp = nsTime::MakeFromSeconds(f / 60.0);
+
+    for (nsUInt32 i = 0; i < 200; ++i)
+    {
+      nsJvdBodyState& state = frame.m_Bodies.ExpandAndGetRef();
+      state.m_uiBodyId = 0x10000 + i;
+      state.m_vPosition.Set(static_cast<float>(i % 20), 0.5f, static_cast<float>(i / 20));
+      state.m_bIsSleeping = i >= 20;
+
+      if (!state.m_bIsSleeping)
+      {
+        state.m_vPosition.y = 10.0f - 0.5f * 9.81f * (f / 60.0f) * (f / 60.0f);
+        state.m_vLinearVelocity.Set(0.0f, -9.81f * f / 60.0f, 0.0f);
+        state.m_qRotation = nsQuat::MakeFromAxisAndAngle(nsVec3(0, 1, 0), nsAngle::MakeFromDegree(static_cast<float>(f)));
+      }
+    }
+
+    out_data.Clear();
+    nsMemoryStreamContainerWrapperStorage<nsDynamicArray<nsUInt8>> storage(&out_data);
+    nsMemoryStreamWriter writer(&storage);
+    nsJvdSerialization::WriteFrame(writer, frame).AssertSuccess();
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Networking, DictionaryCompressor)
+{
+  if (!nsJvdDictionaryCompressor::IsSupported())
+    return;
+
+  nsJvdDictionaryCompressor sender;
+  sender.StartTraining(8);
+
+  nsDynamicArray<nsUInt8> frameData;
+  for (nsUInt32 f = 0; f < 8; ++f)
+  {
+    SerializeLiveFrame(f, frameData);
+    NS_TEST_BOOL(sender.AddTrainingSample(frameData) == (f == 7));
+  }
+
+  NS_TEST_BOOL(sender.HasDictionary());
+  NS_TEST_BOOL(sender.GetDictionary().GetCount() <= 64 * 1024);
+
+  nsJvdDictionaryCompressor receiver;
+  NS_TEST_BOOL(receiver.SetDictionary(sender.GetDictionaryId(), sender.GetDictionary()).Succeeded());
+
+  nsUInt64 uiUncompressedBytes = 0;
+  nsUInt64 uiCompressedBytes = 0;
+  bool bAllRoundTrip = true;
+
+  nsDynamicArray<nsUInt8> compressed;
+  nsDynamicArray<nsUInt8> decompressed;
+  for (nsUInt32 f = 8; f < 300; ++f)
+  {
+    SerializeLiveFrame(f, frameData);
+    NS_TEST_BOOL(sender.Compress(frameData, compressed).Succeeded());
+
+    uiUncompressedBytes += frameData.GetCount();
+    uiCompressedBytes += compressed.GetCount();
+
+    bAllRoundTrip = bAllRoundTrip && receiver.Decompress(sender.GetDictionaryId(), compressed, frameData.GetCount(), decompressed).Succeeded();
+    bAllRoundTrip = bAllRoundTrip && decompressed == frameData;
+  }
+
+  NS_TEST_BOOL(bAllRoundTrip);
+
+  // the dictionary has to beat compressing frames one by one by a wide margin
+  nsDynamicArray<nsUInt8> block;
+  nsJvdClipWriteSettings settings;
+  NS_TEST_BOOL(nsJvdSerialization::EncodeBlock(frameData, 1, settings, block).Succeeded());
+
+  NS_TEST_BOOL(uiCompressedBytes * 4 < uiUncompressedBytes);
+  NS_TEST_BOOL(compressed.GetCount() * 2 < block.GetCount());
+
+  // another dictionary is rejected
+  NS_TEST_BOOL(receiver.Decompress(sender.GetDictionaryId() + 1, compressed, frameData.GetCount(), decompressed).Failed());
+
+  // sizes that do not match the message are rejected before allocating
+  {
+    nsTestLogInterface log;
+    nsTestLogSystemScope logSystemScope(&log);
+    log.ExpectMessage("Failed to decompress a message with a dictionary: invalid size", nsLogMsgType::ErrorMsg, 2);
+
+    NS_TEST_BOOL(receiver.Decompress(sender.GetDictionaryId(), compressed, 0xFFFFFFFFu, decompressed).Failed());
+    NS_TEST_BOOL(receiver.Decompress(sender.GetDictionaryId(), compressed, frameData.GetCount() + 1, decompressed).Failed());
+    NS_TEST_BOOL(decompressed.IsEmpty());
+  }
+}
@@ -0,0 +1,195 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+NS_CREATE_SIMPLE_TEST_GROUP(Networking);
+
+namespace
+{
+  /// Writes uiSize bytes that all have the value uiValue.
+  nsResult WriteTestMessage(nsJvdSharedMemoryRing& ref_ring, nsUInt32 uiSize, nsUInt8 uiValue)
+  {
+    return ref_ring.WriteMessage(1, [&](nsStreamWriter& inout_writer) -> nsResult
+      {
+        for (nsUInt32 i = 0; i < uiSize; ++i)
+        {
+          NS_SUCCEED_OR_RETURN(inout_writer.WriteBytes(&uiValue, 1));
+        }
+        return NS_SUCCESS;
+      });
+  }
+
+  bool ReadTestMessage(nsJvdSharedMemoryRing& ref_ring, nsUInt32 uiSize, nsUInt8 uiValue)
+  {
+    nsUInt32 uiMessageId = 0;
+    nsArrayPtr<const nsUInt8> data;
+    if (!ref_ring.PeekMessage(uiMessageId, data))
+      return false;
+
+    bool bMatches = uiMessageId == 1 && data.GetCount() == uiSize;
+    for (nsUInt8 uiByte : data)
+    {
+      bMatches = bMatches && uiByte == uiValue;
+    }
+
+    ref_ring.PopMessage();
+    return bMatches;
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Networking, SharedMemoryTransport)
+{
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Ring")
+  {
+    nsJvdSharedMemoryRing writer;
+    nsJvdSharedMemoryRing reader;
+    NS_TEST_BOOL(writer.CreateWriter("/nsJvdRingTest", 1024).Succeeded());
+
+    // only the messages after the reader showed up arrive
+    NS_TEST_BOOL(WriteTestMessage(writer, 10, 0xFF).Succeeded());
+    NS_TEST_BOOL(reader.OpenReader("/nsJvdRingTest", 1024).Succeeded());
+
+    nsUInt32 uiMessageId = 0;
+    nsArrayPtr<const nsUInt8> data;
+    NS_TEST_BOOL(!reader.PeekMessage(uiMessageId, data));
+
+    // messages of odd sizes wrap around the end of the ring many times
+    bool bAllArrived = true;
+    for (nsUInt32 i = 0; i < 200; ++i)
+    {
+      const nsUInt32 uiSize = 50 + (i * 37) % 300;
+      bAllArrived = bAllArrived && WriteTestMessage(writer, uiSize, static_cast<nsUInt8>(i)).Succeeded();
+      bAllArrived = bAllArrived && ReadTestMessage(reader, uiSize, static_cast<nsUInt8>(i));
+    }
+
+    NS_TEST_BOOL(bAllArrived);
+    NS_TEST_BOOL(!reader.PeekMessage(uiMessageId, data));
+
+    // a full ring drops messages instead of waiting
+    nsUInt32 uiWritten = 0;
+    while (WriteTestMessage(writer, 200, static_cast<nsUInt8>(uiWritten)).Succeeded())
+    {
+      ++uiWritten;
+    }
+
+    NS_TEST_BOOL(uiWritten >= 3 && uiWritten <= 5);
+    NS_TEST_INT(writer.GetNumDroppedMessages(), 1);
+    NS_TEST_INT(reader.GetNumDroppedMessages(), 1);
+
+    for (nsUInt32 i = 0; i < uiWritten; ++i)
+    {
+      NS_TEST_BOOL(ReadTestMessage(reader, 200, static_cast<nsUInt8>(i)));
+    }
+
+    // larger than the whole ring
+    NS_TEST_BOOL(WriteTestMessage(writer, 2000, 0).Failed());
+    NS_TEST_BOOL(!reader.PeekMessage(uiMessageId, data));
+
+    // the message rang the doorbell
+    NS_TEST_BOOL(WriteTestMessage(writer, 8, 7).Succeeded());
+    reader.WaitForMessage();
+    NS_TEST_BOOL(ReadTestMessage(reader, 8, 7));
+
+    // waking up an empty ring must not be swallowed by the peek inside WaitForMessage()
+    reader.Wake();
+    reader.WaitForMessage();
+    NS_TEST_BOOL(!reader.PeekMessage(uiMessageId, data));
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Reset while reading")
+  {
+    nsJvdSharedMemoryRing writer;
+    nsJvdSharedMemoryRing reader;
+    NS_TEST_BOOL(writer.CreateWriter("/nsJvdRingResetTest", 1024).Succeeded());
+    NS_TEST_BOOL(reader.OpenReader("/nsJvdRingResetTest", 1024).Succeeded());
+
+    for (nsUInt32 i = 0; i < 3; ++i)
+    {
+      NS_TEST_BOOL(WriteTestMessage(writer, 100, static_cast<nsUInt8>(i)).Succeeded());
+    }
+
+    NS_TEST_BOOL(ReadTestMessage(reader, 100, 0));
+
+    nsUInt32 uiMessageId = 0;
+    nsArrayPtr<const nsUInt8> data;
+    NS_TEST_BOOL(reader.PeekMessage(uiMessageId, data));
+
+    // a restarted game resets the ring while the reader still holds a message
+    nsJvdSharedMemoryRing restartedWriter;
+    NS_TEST_BOOL(restartedWriter.CreateWriter("/nsJvdRingResetTest", 1024).Succeeded());
+    NS_TEST_BOOL(WriteTestMessage(restartedWriter, 20, 9).Succeeded());
+
+    reader.PopMessage();
+    NS_TEST_BOOL(ReadTestMessage(reader, 20, 9));
+    NS_TEST_BOOL(!reader.PeekMessage(uiMessageId, data));
+
+    // the ring keeps working across the end
+    bool bAllArrived = true;
+    for (nsUInt32 i = 0; i < 50; ++i)
+    {
+      bAllArrived = bAllArrived && WriteTestMessage(restartedWriter, 150, static_cast<nsUInt8>(i)).Succeeded();
+      bAllArrived = bAllArrived && ReadTestMessage(reader, 150, static_cast<nsUInt8>(i));
+    }
+
+    NS_TEST_BOOL(bAllArrived);
+    NS_TEST_INT(restartedWriter.GetNumDroppedMessages(), 0);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Session")
+  {
+    nsJvdSessionConfiguration config;
+    config.m_Transport = nsJvdTransport::SharedMemory;
+    config.m_uiPort = 41040;
+    config.m_uiSharedMemorySize = 1024 * 1024;
+
+    nsJvdSession game;
+    NS_TEST_BOOL(game.Initialize(config).Succeeded());
+
+    config.m_bStartAsServer = false;
+    nsJvdSession viewer;
+    NS_TEST_BOOL(viewer.Initialize(config).Succeeded());
+
+    nsDynamicArray<nsJvdFrame> received;
+    viewer.OnFrameReceived().AddEventHandler([&](const nsJvdFrame& frame)
+      { received.PushBack(frame); });
+
+    nsJvdClip receivedClip;
+    viewer.OnClipReceived().AddEventHandler([&](const nsJvdClip& clip)
+      { receivedClip = clip; });
+
+    // 500 bodies per frame, so the ring wraps around a few times
+    nsJvdClip clip;
+    for (nsUInt32 f = 0; f < 40; ++f)
+    {
+      nsJvdFrame frame;
+      frame.m_uiFrameIndex = f;
+      frame.m_Timestamp = nsTime::MakeFromSeconds(f / 60.0);
+
+      for (nsUInt32 i = 0; i < 500; ++i)
+      {
+        nsJvdBodyState& state = frame.m_Bodies.ExpandAndGetRef();
+        state.m_uiBodyId = i;
+        state.m_vPosition.Set(static_cast<float>(f), static_cast<float>(i), 0.0f);
+      }
+
+      game.BroadcastFrame(frame);
+      viewer.Update();
+
+      if (f < 5)
+      {
+        clip.AddFrame(std::move(frame));
+      }
+    }
+
+    game.BroadcastClip(clip);
+    viewer.Update();
+
+    NS_TEST_INT(game.GetNumDroppedMessages(), 0);
+    NS_TEST_INT(received.GetCount(), 40);
+    NS_TEST_INT(received.PeekBack().m_uiFrameIndex, 39);
+    NS_TEST_INT(received.PeekBack().m_Bodies.GetCount(), 500);
+    NS_TEST_FLOAT(received.PeekBack().m_Bodies[499].m_vPosition.y, 499.0f, 0.0f);
+    NS_TEST_INT(receivedClip.GetFrames().GetCount(), 5);
+
+    viewer.Shutdown();
+    game.Shutdown();
+  }
+}
@@ -0,0 +1,114 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+namespace
+{
+  /// Looks down +X from the origin, 90 degrees wide, 1000 pixels high.
+  nsJvdCullingView MakeView()
+  {
+    nsJvdCullingView view;
+    view.SetPerspective(nsVec3::MakeZero(), nsVec3(1, 0, 0), nsVec3(0, 0, 1), nsAngle::MakeFromDegree(90.0f), nsAngle::MakeFromDegree(90.0f), 0.1f, 1000.0f, 1000);
+    return view;
+  }
+
+  nsJvdBodyState MakeBody(const nsVec3& vPosition, float fSize)
+  {
+    nsJvdBodyState body;
+    body.m_vPosition = vPosition;
+    body.m_vScale.Set(fSize);
+    return body;
+  }
+
+  /// Bodies scattered in a cube around the camera, roughly one in six is in front of it.
+  void MakeScene(nsUInt32 uiCount, nsDynamicArray<nsJvdBodyState>& out_bodies)
+  {
+    out_bodies.SetCount(uiCount);
+    for (nsUInt32 i = 0; i < uiCount; ++i)
+    {
+      const float x = static_cast<float>((i * 7919u) % 2001u) - 1000.0f;
+      const float y = static_cast<float>((i * 104729u) % 2001u) - 1000.0f;
+      const float z = static_cast<float>((i * 1299709u) % 2001u) - 1000.0f;
+      out_bodies[i] = MakeBody(nsVec3(x, y, z) * 0.5f, 1.0f + (i % 4));
+    }
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Playback, BodyCulling)
+{
+  nsJvdBodyCulling culling;
+  const nsJvdCullingView view = MakeView();
+  nsDynamicArray<nsJvdVisibleBody> visible;
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Frustum and size")
+  {
+    nsDynamicArray<nsJvdBodyState> bodies;
+    bodies.PushBack(MakeBody(nsVec3(10, 0, 0), 1.0f));     // close, in front
+    bodies.PushBack(MakeBody(nsVec3(-10, 0, 0), 1.0f));    // behind the camera
+    bodies.PushBack(MakeBody(nsVec3(10, 10.5f, 0), 2.0f)); // center outside, box still overlaps the left plane
+    bodies.PushBack(MakeBody(nsVec3(10, 12, 0), 1.0f));    // outside the left plane
+    bodies.PushBack(MakeBody(nsVec3(500, 0, 0), 1.0f));    // a couple of pixels
+    bodies.PushBack(MakeBody(nsVec3(900, 0, 0), 0.1f));    // less than a pixel
+
+    NS_TEST_INT(culling.Cull(view, bodies, visible), 3);
+    if (NS_TEST_INT(visible.GetCount(), 3))
+    {
+      NS_TEST_INT(visible[0].m_uiBodyIndex, 0);
+      NS_TEST_BOOL(visible[0].m_Lod == nsJvdBodyLod::Full);
+      NS_TEST_INT(visible[1].m_uiBodyIndex, 2);
+      NS_TEST_INT(visible[2].m_uiBodyIndex, 4);
+      NS_TEST_BOOL(visible[2].m_Lod == nsJvdBodyLod::Reduced);
+    }
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Parallel matches serial")
+  {
+    nsDynamicArray<nsJvdBodyState> bodies;
+    MakeScene(20000, bodies);
+
+    // the first 4000 bodies are classified serially, compare them with the same bodies inside the large parallel run
+    nsDynamicArray<nsJvdVisibleBody> serial;
+    culling.Cull(view, bodies.GetArrayPtr().GetSubArray(0, 4000), serial);
+    culling.Cull(view, bodies, visible);
+
+    NS_TEST_BOOL(!serial.IsEmpty());
+    NS_TEST_BOOL(visible.GetCount() < bodies.GetCount() / 2);
+
+    bool bSame = visible.GetCount() >= serial.GetCount();
+    for (nsUInt32 i = 0; bSame && i < serial.GetCount(); ++i)
+    {
+      bSame = visible[i].m_uiBodyIndex == serial[i].m_uiBodyIndex && visible[i].m_Lod == serial[i].m_Lod;
+    }
+
+    NS_TEST_BOOL(bSame);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::DisabledNoWarning, "Performance")
+  {
+    nsDynamicArray<nsJvdBodyState> bodies;
+    MakeScene(100000, bodies);
+
+    constexpr nsUInt32 uiRuns = 20;
+
+    nsUInt32 uiNaiveVisible = 0;
+    const nsTime t0 = nsTime::Now();
+    for (nsUInt32 r = 0; r < uiRuns; ++r)
+    {
+      uiNaiveVisible = 0;
+      for (const nsJvdBodyState& body : bodies)
+      {
+        const nsBoundingSphere sphere = nsBoundingSphere::MakeFromCenterAndRadius(body.m_vPosition, nsJvdBodyCulling::GetBodyRadius(body));
+        uiNaiveVisible += view.m_Frustum.GetObjectPosition(sphere) != nsVolumePosition::Outside ? 1 : 0;
+      }
+    }
+    const nsTime t1 = nsTime::Now();
+
+    nsUInt32 uiVisible = 0;
+    for (nsUInt32 r = 0; r < uiRuns; ++r)
+    {
+      uiVisible = culling.Cull(view, bodies, visible);
+    }
+    const nsTime t2 = nsTime::Now();
+
+    nsLog::Info("[test]Culling 100k bodies: GetObjectPosition {0}ms ({1} visible), nsJvdBodyCulling {2}ms ({3} visible)",
+      nsArgF((t1 - t0).GetMilliseconds() / uiRuns, 3), uiNaiveVisible, nsArgF((t2 - t1).GetMilliseconds() / uiRuns, 3), uiVisible);
+  }
+}
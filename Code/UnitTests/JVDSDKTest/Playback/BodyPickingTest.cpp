@@ -0,0 +1,254 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+namespace
+{
+  nsJvdBodyState MakePickingBody(nsUInt64 uiBodyId, const nsVec3& vPosition, float fSize)
+  {
+    nsJvdBodyState body;
+    body.m_uiBodyId = uiBodyId;
+    body.m_vPosition = vPosition;
+    body.m_vScale.Set(fSize);
+    return body;
+  }
+
+  /// Unrotated bodies scattered in a cube of 1000 units.
+  void MakePickingScene(nsUInt32 uiCount, nsDynamicArray<nsJvdBodyState>& out_bodies)
+  {
+    out_bodies.SetCount(uiCount);
+    for (nsUInt32 i = 0; i < uiCount; ++i)
+    {
+      const float x = static_cast<float>((i * 7919u) % 2001u) - 1000.0f;
+      const float y = static_cast<float>((i * 104729u) % 2001u) - 1000.0f;
+      const float z = static_cast<float>((i * 1299709u) % 2001u) - 1000.0f;
+      out_bodies[i] = MakePickingBody(i, nsVec3(x, y, z) * 0.5f, 1.0f + (i % 4));
+    }
+  }
+
+  /// Tests every body, only correct for unrotated bodies.
+  nsUInt32 CastRayBruteForce(nsArrayPtr<const nsJvdBodyState> bodies, const nsVec3& vOrigin, const nsVec3& vDirection)
+  {
+    nsUInt32 uiClosest = nsInvalidIndex;
+    float fClosest = nsMath::MaxValue<float>();
+
+    for (nsUInt32 i = 0; i < bodies.GetCount(); ++i)
+    {
+      const nsVec3 vHalfExtents = bodies[i].m_vScale.CompMax(nsVec3(0.1f)) * 0.5f;
+      const nsBoundingBox box = nsBoundingBox::MakeFromCenterAndHalfExtents(bodies[i].m_vPosition, vHalfExtents);
+
+      float fDistance = 0.0f;
+      if (box.GetRayIntersection(vOrigin, vDirection, &fDistance) && fDistance < fClosest)
+      {
+        fClosest = fDistance;
+        uiClosest = i;
+      }
+    }
+
+    return uiClosest;
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Playback, BodyPicking)
+{
+  nsJvdBodyPicking picking;
+  nsJvdPickResult result;
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Closest hit")
+  {
+    nsDynamicArray<nsJvdBodyState> bodies;
+    bodies.PushBack(MakePickingBody(1, nsVec3(20, 0, 0), 2.0f));
+    bodies.PushBack(MakePickingBody(2, nsVec3(10, 0, 0), 2.0f));
+    bodies.PushBack(MakePickingBody(3, nsVec3(10, 5, 0), 2.0f));
+    bodies.PushBack(MakePickingBody(4, nsVec3(-10, 0, 0), 2.0f)); // behind the ray
+
+    picking.Update(bodies);
+
+    NS_TEST_BOOL(picking.CastRay(nsVec3::MakeZero(), nsVec3(1, 0, 0), result));
+    NS_TEST_INT(result.m_uiBodyIndex, 1);
+    NS_TEST_FLOAT(result.m_fDistance, 9.0f, 0.001f);
+
+    NS_TEST_BOOL(picking.CastRay(nsVec3(0, 5, 0), nsVec3(1, 0, 0), result));
+    NS_TEST_INT(result.m_uiBodyIndex, 2);
+
+    NS_TEST_BOOL(!picking.CastRay(nsVec3(0, 2.5f, 0), nsVec3(1, 0, 0), result));
+    NS_TEST_BOOL(!picking.CastRay(nsVec3::MakeZero(), nsVec3(1, 0, 0), result, 5.0f));
+
+    // starting inside a body hits it at distance 0
+    NS_TEST_BOOL(picking.CastRay(nsVec3(20, 0, 0), nsVec3(0, 0, 1), result));
+    NS_TEST_INT(result.m_uiBodyIndex, 0);
+    NS_TEST_FLOAT(result.m_fDistance, 0.0f, 0.001f);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Rotated bodies")
+  {
+    nsDynamicArray<nsJvdBodyState> bodies;
+    bodies.PushBack(MakePickingBody(1, nsVec3(10, 0, 0), 2.0f));
+    bodies[0].m_qRotation = nsQuat::MakeFromAxisAndAngle(nsVec3(0, 0, 1), nsAngle::MakeFromDegree(45.0f));
+
+    picking.Update(bodies);
+
+    // along the edge of the rotated box, through the corner of its axis-aligned bounds
+    const nsVec3 vAlongEdge = nsVec3(1, -1, 0).GetNormalized();
+    NS_TEST_BOOL(!picking.CastRay(nsVec3(0.8f, 10.8f, 0), vAlongEdge, result));
+    NS_TEST_BOOL(picking.CastRay(nsVec3(0.6f, 10.6f, 0), vAlongEdge, result));
+
+    // the rotated corner sticks out further than the unrotated box would
+    NS_TEST_BOOL(picking.CastRay(nsVec3(0, 0, 0), nsVec3(1, 0, 0), result));
+    NS_TEST_FLOAT(result.m_fDistance, 10.0f - nsMath::Sqrt(2.0f), 0.001f);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Matches brute force")
+  {
+    nsDynamicArray<nsJvdBodyState> bodies;
+    MakePickingScene(5000, bodies);
+    picking.Update(bodies);
+
+    nsUInt32 uiHits = 0;
+    bool bSame = true;
+    for (nsUInt32 i = 0; i < 200; ++i)
+    {
+      // rays from outside the scene towards random bodies, plus a slight offset so some of them miss
+      const nsVec3 vOrigin(-800.0f, static_cast<float>(i % 17) * 10.0f, static_cast<float>(i % 23) * -10.0f);
+      const nsVec3 vTarget = bodies[(i * 37) % bodies.GetCount()].m_vPosition + nsVec3(0, 0, (i % 3) * 1.5f);
+      const nsVec3 vDirection = (vTarget - vOrigin).GetNormalized();
+
+      const nsUInt32 uiExpected = CastRayBruteForce(bodies, vOrigin, vDirection);
+      const nsUInt32 uiPicked = picking.CastRay(vOrigin, vDirection, result) ? result.m_uiBodyIndex : nsInvalidIndex;
+
+      bSame = bSame && uiPicked == uiExpected;
+      uiHits += uiPicked != nsInvalidIndex ? 1 : 0;
+    }
+
+    NS_TEST_BOOL(bSame);
+    NS_TEST_BOOL(uiHits > 100);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Refit and rebuild")
+  {
+    nsDynamicArray<nsJvdBodyState> bodies;
+    MakePickingScene(1000, bodies);
+
+    nsJvdBodyPicking tree;
+    tree.Update(bodies);
+    NS_TEST_INT(tree.GetRebuildCount(), 1);
+
+    // playback, every body moves a little
+    for (nsUInt32 uiFrame = 0; uiFrame < 10; ++uiFrame)
+    {
+      for (nsJvdBodyState& body : bodies)
+      {
+        body.m_vPosition.z += 0.5f;
+      }
+      tree.Update(bodies);
+    }
+
+    NS_TEST_INT(tree.GetRebuildCount(), 1);
+    NS_TEST_INT(tree.GetRefitCount(), 10);
+
+    NS_TEST_BOOL(tree.CastRay(bodies[5].m_vPosition - nsVec3(0, 0, 1000), nsVec3(0, 0, 1), result));
+    NS_TEST_INT(result.m_uiBodyIndex, CastRayBruteForce(bodies, bodies[5].m_vPosition - nsVec3(0, 0, 1000), nsVec3(0, 0, 1)));
+
+    // the bodies swap places, refitting would leave a tree of huge overlapping nodes
+    for (nsUInt32 i = 0; i < bodies.GetCount() / 2; ++i)
+    {
+      nsMath::Swap(bodies[i].m_vPosition, bodies[bodies.GetCount() - 1 - i].m_vPosition);
+    }
+    tree.Update(bodies);
+    NS_TEST_INT(tree.GetRebuildCount(), 2);
+
+    // a different set of bodies
+    bodies.PopBack();
+    tree.Update(bodies);
+    NS_TEST_INT(tree.GetRebuildCount(), 3);
+
+    bodies[0].m_uiBodyId = 123456;
+    tree.Update(bodies);
+    NS_TEST_INT(tree.GetRebuildCount(), 4);
+
+    tree.Clear();
+    NS_TEST_BOOL(!tree.CastRay(nsVec3::MakeZero(), nsVec3(1, 0, 0), result));
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Non-finite bodies")
+  {
+    nsDynamicArray<nsJvdBodyState> bodies;
+    MakePickingScene(200, bodies);
+    bodies[3].m_vPosition.x = nsMath::NaN<float>();
+    bodies[50].m_vPosition.y = nsMath::Infinity<float>();
+    bodies[120].m_vScale.z = nsMath::NaN<float>();
+
+    nsJvdBodyPicking tree;
+    tree.Update(bodies);
+
+    // the other bodies are still found, the broken ones never are
+    nsDynamicArray<nsJvdBodyState> finiteBodies = bodies;
+    finiteBodies[3].m_vPosition.Set(10000.0f);
+    finiteBodies[50].m_vPosition.Set(10000.0f);
+    finiteBodies[120].m_vPosition.Set(10000.0f);
+
+    bool bSame = true;
+    for (nsUInt32 i = 0; i < bodies.GetCount(); ++i)
+    {
+      if (i == 3 || i == 50 || i == 120)
+        continue;
+
+      const nsVec3 vOrigin = bodies[i].m_vPosition - nsVec3(0, 0, 1000);
+      const nsUInt32 uiPicked = tree.CastRay(vOrigin, nsVec3(0, 0, 1), result) ? result.m_uiBodyIndex : nsInvalidIndex;
+      bSame = bSame && uiPicked == CastRayBruteForce(finiteBodies, vOrigin, nsVec3(0, 0, 1));
+    }
+
+    NS_TEST_BOOL(bSame);
+
+    // a body that becomes finite again joins the tree
+    bodies[3].m_vPosition.Set(5000.0f, 0.0f, 0.0f);
+    tree.Update(bodies);
+    NS_TEST_INT(tree.GetRebuildCount(), 2);
+    NS_TEST_BOOL(tree.CastRay(nsVec3(4000.0f, 0.0f, 0.0f), nsVec3(1, 0, 0), result));
+    NS_TEST_INT(result.m_uiBodyIndex, 3);
+
+    // and leaves it when it breaks again
+    bodies[3].m_vPosition.Set(nsMath::Infinity<float>(), 0.0f, 0.0f);
+    tree.Update(bodies);
+    NS_TEST_INT(tree.GetRebuildCount(), 3);
+    NS_TEST_BOOL(!tree.CastRay(nsVec3(4000.0f, 0.0f, 0.0f), nsVec3(1, 0, 0), result));
+
+    // nothing but broken bodies
+    for (nsJvdBodyState& body : bodies)
+    {
+      body.m_vPosition.x = nsMath::NaN<float>();
+    }
+    tree.Update(bodies);
+    tree.Update(bodies);
+    NS_TEST_BOOL(!tree.CastRay(nsVec3(-800, 0, 0), nsVec3(1, 0, 0), result));
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::DisabledNoWarning, "Performance")
+  {
+    nsDynamicArray<nsJvdBodyState> bodies;
+    MakePickingScene(100000, bodies);
+
+    nsJvdBodyPicking tree;
+
+    const nsTime t0 = nsTime::Now();
+    tree.Update(bodies);
+    const nsTime t1 = nsTime::Now();
+
+    for (nsJvdBodyState& body : bodies)
+    {
+      body.m_vPosition.x += 0.1f;
+    }
+    tree.Update(bodies);
+    const nsTime t2 = nsTime::Now();
+
+    constexpr nsUInt32 uiRays = 1000;
+    nsUInt32 uiHits = 0;
+    for (nsUInt32 i = 0; i < uiRays; ++i)
+    {
+      const nsVec3 vDirection = (bodies[(i * 37) % bodies.GetCount()].m_vPosition - nsVec3(-800, 0, 0)).GetNormalized();
+      uiHits += tree.CastRay(nsVec3(-800, 0, 0), vDirection, result) ? 1 : 0;
+    }
+    const nsTime t3 = nsTime::Now();
+
+    nsLog::Info("[test]Picking 100k bodies: build {0}ms, refit {1}ms, ray {2}us ({3} of {4} hit)", nsArgF(t1.GetMilliseconds() - t0.GetMilliseconds(), 3),
+      nsArgF(t2.GetMilliseconds() - t1.GetMilliseconds(), 3), nsArgF((t3 - t2).GetMicroseconds() / uiRays, 2), uiHits, uiRays);
+  }
+}
@@ -0,0 +1,130 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+namespace
+{
+  nsJvdFrame MakeFrame(nsUInt64 uiFrameIndex, nsUInt32 uiBodyCount)
+  {
+    nsJvdFrame frame;
+    frame.m_uiFrameIndex = uiFrameIndex;
+    frame.m_Bodies.SetCount(uiBodyCount);
+    for (nsUInt32 i = 0; i < uiBodyCount; ++i)
+    {
+      frame.m_Bodies[i].m_uiBodyId = 100 + i;
+      frame.m_Bodies[i].m_uiBodyIndex = i;
+    }
+    return frame;
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Playback, MotionHistory)
+{
+  nsJvdMotionHistory history;
+  history.SetFrameCapacity(4);
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Ring")
+  {
+    NS_TEST_INT(history.GetFrameCount(), 0);
+
+    const nsUInt32 uiLayout = history.GetLayoutVersion();
+    NS_TEST_INT(history.AddFrame(MakeFrame(10, 3)), 0);
+    NS_TEST_BOOL(history.GetLayoutVersion() != uiLayout);
+    NS_TEST_INT(history.GetBodyCapacity(), 64);
+
+    for (nsUInt64 i = 11; i < 16; ++i)
+    {
+      history.AddFrame(MakeFrame(i, 3));
+    }
+
+    // six frames went into four rows, the oldest two were overwritten
+    NS_TEST_INT(history.GetFrameCount(), 4);
+    NS_TEST_INT(history.GetHeadRow(), 1);
+    NS_TEST_INT(history.GetHeadFrameIndex(), 15);
+    NS_TEST_INT(history.GetRow(0), 1);
+    NS_TEST_INT(history.GetRow(1), 0);
+    NS_TEST_INT(history.GetRow(2), 3);
+    NS_TEST_INT(history.GetRow(3), 2);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Seeking starts over")
+  {
+    const nsUInt32 uiLayout = history.GetLayoutVersion();
+
+    NS_TEST_INT(history.AddFrame(MakeFrame(40, 3)), 0);
+    NS_TEST_INT(history.GetFrameCount(), 1);
+
+    // stepping backwards is a seek as well
+    history.AddFrame(MakeFrame(39, 3));
+    NS_TEST_INT(history.GetFrameCount(), 1);
+
+    history.AddFrame(MakeFrame(40, 3));
+    NS_TEST_INT(history.GetFrameCount(), 2);
+
+    // the same frame again is not a seek
+    NS_TEST_INT(history.AddFrame(MakeFrame(40, 3)), 1);
+    NS_TEST_INT(history.GetFrameCount(), 2);
+
+    NS_TEST_INT(history.GetLayoutVersion(), uiLayout);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Growing body capacity")
+  {
+    const nsUInt32 uiLayout = history.GetLayoutVersion();
+
+    nsJvdFrame frame = MakeFrame(41, 3);
+    frame.m_Bodies[2].m_uiBodyIndex = 200;
+    history.AddFrame(frame);
+
+    NS_TEST_INT(history.GetBodyCapacity(), 256);
+    NS_TEST_BOOL(history.GetLayoutVersion() != uiLayout);
+    NS_TEST_INT(history.GetFrameCount(), 1);
+
+    // bodies without an index are not tracked and never grow the rows
+    frame = MakeFrame(42, 3);
+    frame.m_Bodies[1].m_uiBodyIndex = nsInvalidIndex;
+    history.AddFrame(frame);
+    NS_TEST_INT(history.GetBodyCapacity(), 256);
+    NS_TEST_INT(history.GetFrameCount(), 2);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Frame capacity")
+  {
+    const nsUInt32 uiLayout = history.GetLayoutVersion();
+    history.SetFrameCapacity(4);
+    NS_TEST_INT(history.GetLayoutVersion(), uiLayout);
+    NS_TEST_INT(history.GetFrameCount(), 0);
+
+    history.SetFrameCapacity(1);
+    NS_TEST_BOOL(history.GetLayoutVersion() != uiLayout);
+
+    history.AddFrame(MakeFrame(1, 1));
+    history.AddFrame(MakeFrame(2, 1));
+    NS_TEST_INT(history.GetFrameCount(), 1);
+    NS_TEST_INT(history.GetHeadRow(), 0);
+    NS_TEST_INT(history.GetHeadFrameIndex(), 2);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Skipping frames")
+  {
+    history.SetFrameCapacity(8);
+    history.AddFrame(MakeFrame(20, 3));
+
+    // playback that falls behind skips a few frames, the history continues
+    nsUInt32 uiSkippedRows = 0;
+    NS_TEST_INT(history.AddFrame(MakeFrame(23, 3), &uiSkippedRows), 3);
+    NS_TEST_INT(uiSkippedRows, 2);
+    NS_TEST_INT(history.GetFrameCount(), 4);
+    NS_TEST_INT(history.GetRow(3), 0);
+
+    NS_TEST_INT(history.AddFrame(MakeFrame(24, 3), &uiSkippedRows), 4);
+    NS_TEST_INT(uiSkippedRows, 0);
+
+    NS_TEST_INT(history.AddFrame(MakeFrame(30, 3), &uiSkippedRows), 2);
+    NS_TEST_INT(uiSkippedRows, 5);
+    NS_TEST_INT(history.GetFrameCount(), 8);
+
+    // a jump of a whole capacity or more leaves nothing to continue
+    NS_TEST_INT(history.AddFrame(MakeFrame(38, 3), &uiSkippedRows), 0);
+    NS_TEST_INT(uiSkippedRows, 0);
+    NS_TEST_INT(history.GetFrameCount(), 1);
+  }
+}
@@ -0,0 +1,65 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+#include <Foundation/Threading/ThreadUtils.h>
+
+NS_CREATE_SIMPLE_TEST_GROUP(Playback);
+
+NS_CREATE_SIMPLE_TEST(Playback, WallClockPresentation)
+{
+  nsJvdClip clip;
+  for (nsUInt32 f = 0; f < 30; ++f)
+  {
+    nsJvdFrame frame;
+    frame.m_uiFrameIndex = f;
+    frame.m_Timestamp = nsTime::MakeFromSeconds(f / 60.0);
+    clip.AddFrame(std::move(frame));
+  }
+
+  nsJvdPlaybackController controller;
+  controller.LoadClip(clip);
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Idle ticks")
+  {
+    controller.StartPresenting();
+
+    const nsJvdFrame* pFirst = controller.Present();
+    if (NS_TEST_BOOL(pFirst != nullptr))
+    {
+      NS_TEST_INT(pFirst->m_uiFrameIndex, 0);
+    }
+
+    // far less than one sample interval passed, nothing new to show
+    NS_TEST_BOOL(controller.Present() == nullptr);
+    NS_TEST_INT(controller.GetStats().m_uiPresentedFrames, 1);
+    NS_TEST_INT(controller.GetStats().m_uiIdleTicks, 1);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Slow ticks drop frames")
+  {
+    controller.SetPlaybackPosition(nsTime::MakeZero());
+    controller.StartPresenting();
+
+    const nsTime start = nsTime::Now();
+    nsUInt64 uiLastFrame = 0;
+    while (!controller.IsAtEnd() && nsTime::Now() - start < nsTime::MakeFromSeconds(5.0))
+    {
+      // a tick that takes three sample intervals
+      nsThreadUtils::Sleep(nsTime::MakeFromMilliseconds(50.0));
+
+      if (const nsJvdFrame* pFrame = controller.Present())
+      {
+        uiLastFrame = pFrame->m_uiFrameIndex;
+      }
+    }
+
+    // the clip still plays at real speed and ends on its last frame
+    NS_TEST_BOOL(controller.IsAtEnd());
+    NS_TEST_INT(uiLastFrame, 29);
+    NS_TEST_BOOL(nsTime::Now() - start >= nsTime::MakeFromMilliseconds(450.0));
+
+    const nsJvdPlaybackStats& stats = controller.GetStats();
+    NS_TEST_BOOL(stats.m_uiDroppedFrames > 0);
+    NS_TEST_BOOL(stats.m_uiPresentedFrames < 30);
+    NS_TEST_BOOL(stats.m_AverageTickInterval >= nsTime::MakeFromMilliseconds(40.0));
+  }
+}
@@ -0,0 +1,181 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+namespace
+{
+  void MakeRestingFrame(nsJvdFrame& ref_frame, nsUInt64 uiFrameIndex, nsUInt32 uiBodyCount)
+  {
+    ref_frame.m_uiFrameIndex = uiFrameIndex;
+    ref_frame.m_Timestamp = nsTime::MakeFromSeconds(uiFrameIndex / 60.0);
+    ref_frame.m_Bodies.SetCount(uiBodyCount);
+
+    for (nsUInt32 i = 0; i < uiBodyCount; ++i)
+    {
+      nsJvdBodyState& state = ref_frame.m_Bodies[i];
+      state.Reset();
+      state.m_uiBodyId = 1000 + i;
+      state.m_vPosition.Set(static_cast<float>(i), 0.0f, 0.0f);
+    }
+  }
+
+  const nsJvdBookmark* FindBookmark(const nsDynamicArray<nsJvdBookmark>& bookmarks, nsJvdBookmarkKind::Enum kind)
+  {
+    for (const nsJvdBookmark& bookmark : bookmarks)
+    {
+      if (bookmark.m_Kind == kind)
+        return &bookmark;
+    }
+
+    return nullptr;
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Recording, AnomalyDetector)
+{
+  nsJvdAnomalyDetectionSettings settings;
+  settings.m_bDetectOutOfBounds = true;
+  settings.m_vWorldBoundsMin.Set(-100.0f);
+  settings.m_vWorldBoundsMax.Set(100.0f);
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Quiet frames")
+  {
+    nsJvdAnomalyDetector detector;
+    detector.Configure(settings);
+
+    nsDynamicArray<nsJvdBookmark> bookmarks;
+    nsJvdFrame frame;
+    for (nsUInt32 i = 0; i < 10; ++i)
+    {
+      MakeRestingFrame(frame, i, 37);
+      NS_TEST_INT(detector.ProcessFrame(frame, bookmarks), 0);
+    }
+
+    NS_TEST_BOOL(bookmarks.IsEmpty());
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Detect each kind")
+  {
+    nsJvdAnomalyDetector detector;
+    detector.Configure(settings);
+
+    nsDynamicArray<nsJvdBookmark> bookmarks;
+    nsJvdFrame frame;
+    MakeRestingFrame(frame, 0, 37);
+    detector.ProcessFrame(frame, bookmarks);
+
+    MakeRestingFrame(frame, 1, 37);
+    frame.m_Bodies[2].m_vPosition.y = nsMath::NaN<float>();
+    frame.m_Bodies[5].m_vLinearVelocity.Set(200.0f, 0.0f, 0.0f);
+    frame.m_Bodies[6].m_vAngularVelocity.Set(0.0f, 500.0f, 0.0f);
+    frame.m_Bodies[9].m_vPosition.z = 10.0f;
+    frame.m_Bodies[33].m_vPosition.x = 500.0f;
+    frame.m_Bodies[33].m_bWasTeleported = true;
+
+    // reversing the order exercises the id lookup
+    for (nsUInt32 i = 0; i < frame.m_Bodies.GetCount() / 2; ++i)
+    {
+      nsMath::Swap(frame.m_Bodies[i], frame.m_Bodies[frame.m_Bodies.GetCount() - 1 - i]);
+    }
+
+    detector.ProcessFrame(frame, bookmarks);
+
+    const nsJvdBookmark* pNaN = FindBookmark(bookmarks, nsJvdBookmarkKind::NonFiniteTransform);
+    NS_TEST_BOOL(pNaN != nullptr && pNaN->m_uiBodyId == 1002 && pNaN->m_uiBodyCount == 1 && pNaN->m_uiFrameIndex == 1);
+
+    const nsJvdBookmark* pSpike = FindBookmark(bookmarks, nsJvdBookmarkKind::VelocitySpike);
+    NS_TEST_BOOL(pSpike != nullptr && pSpike->m_uiBodyId == 1005);
+    NS_TEST_FLOAT(pSpike->m_fValue, 200.0f, 0.001f);
+
+    const nsJvdBookmark* pAngular = FindBookmark(bookmarks, nsJvdBookmarkKind::AngularVelocitySpike);
+    NS_TEST_BOOL(pAngular != nullptr && pAngular->m_uiBodyId == 1006);
+
+    // body 9 jumps 10m at zero velocity, the teleported body 33 is excused
+    const nsJvdBookmark* pTeleport = FindBookmark(bookmarks, nsJvdBookmarkKind::Teleport);
+    NS_TEST_BOOL(pTeleport != nullptr && pTeleport->m_uiBodyId == 1009 && pTeleport->m_uiBodyCount == 1);
+    NS_TEST_FLOAT(pTeleport->m_fValue, 10.0f, 0.001f);
+
+    // the velocity spikes also gain energy out of nowhere
+    const nsJvdBookmark* pEnergy = FindBookmark(bookmarks, nsJvdBookmarkKind::EnergyGain);
+    NS_TEST_BOOL(pEnergy != nullptr && pEnergy->m_uiBodyId == 1006 && pEnergy->m_uiBodyCount == 2);
+
+    const nsJvdBookmark* pBounds = FindBookmark(bookmarks, nsJvdBookmarkKind::OutOfBounds);
+    NS_TEST_BOOL(pBounds != nullptr && pBounds->m_uiBodyId == 1033);
+
+    // persistent states are only reported once, continuing velocities are not a spike
+    const nsUInt32 uiCount = bookmarks.GetCount();
+    frame.m_uiFrameIndex = 2;
+    frame.m_Timestamp = nsTime::MakeFromSeconds(2.0 / 60.0);
+    for (nsJvdBodyState& state : frame.m_Bodies)
+    {
+      state.m_bWasTeleported = false;
+      state.m_vPosition += state.m_vLinearVelocity / 60.0f;
+    }
+
+    NS_TEST_INT(detector.ProcessFrame(frame, bookmarks), 0);
+    NS_TEST_INT(bookmarks.GetCount(), uiCount);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Free fall keeps energy")
+  {
+    nsJvdAnomalyDetector detector;
+    detector.Configure(settings);
+
+    nsDynamicArray<nsJvdBookmark> bookmarks;
+    nsJvdFrame frame;
+    MakeRestingFrame(frame, 0, 5);
+
+    const float fDeltaTime = 1.0f / 60.0f;
+    for (nsUInt32 uiStep = 0; uiStep < 120; ++uiStep)
+    {
+      frame.m_uiFrameIndex = uiStep;
+      frame.m_Timestamp = nsTime::MakeFromSeconds(uiStep * fDeltaTime);
+      detector.ProcessFrame(frame, bookmarks);
+
+      for (nsJvdBodyState& state : frame.m_Bodies)
+      {
+        state.m_vLinearVelocity += settings.m_vGravity * fDeltaTime;
+        state.m_vPosition += state.m_vLinearVelocity * fDeltaTime;
+      }
+    }
+
+    NS_TEST_BOOL(bookmarks.IsEmpty());
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Recorder adds bookmarks to the clip")
+  {
+    nsJvdRecordingSettings recordSettings;
+    recordSettings.Reset();
+    recordSettings.m_TargetFrameInterval = nsTime::MakeZero();
+    recordSettings.m_bDetectAnomalies = true;
+
+    nsJvdRecorder recorder;
+    recorder.StartRecording(recordSettings);
+
+    nsJvdFrame frame;
+    for (nsUInt32 i = 1; i < 5; ++i)
+    {
+      MakeRestingFrame(frame, i, 3);
+      if (i == 3)
+      {
+        frame.m_Bodies[1].m_vPosition.x = nsMath::Infinity<float>();
+      }
+
+      recorder.AppendFrame(frame.m_Timestamp, frame.m_Bodies.GetArrayPtr());
+    }
+
+    nsJvdClip clip;
+    NS_TEST_BOOL(recorder.StopRecording(clip).Succeeded());
+    NS_TEST_INT(clip.GetBookmarks().GetCount(), 1);
+    NS_TEST_BOOL(clip.GetBookmarks()[0].m_Kind == nsJvdBookmarkKind::NonFiniteTransform);
+    NS_TEST_INT(clip.GetBookmarks()[0].m_uiFrameIndex, 2);
+
+    nsDefaultMemoryStreamStorage storage;
+    nsMemoryStreamWriter writer(&storage);
+    NS_TEST_BOOL(nsJvdSerialization::WriteClip(writer, clip).Succeeded());
+
+    nsMemoryStreamReader reader(&storage);
+    nsJvdClip loaded;
+    NS_TEST_BOOL(nsJvdSerialization::ReadClip(reader, loaded).Succeeded());
+    NS_TEST_INT(loaded.GetBookmarks().GetCount(), 1);
+    NS_TEST_INT(loaded.GetBookmarks()[0].m_uiBodyId, 1001);
+  }
+}
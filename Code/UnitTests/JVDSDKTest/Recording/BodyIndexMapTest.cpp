@@ -0,0 +1,143 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+#include <Foundation/IO/MemoryStream.h>
+
+namespace
+{
+  /// Frame f has the bodies 1000 + (f + i) % 40 for i < 30, so bodies enter and leave and their order changes every frame.
+  nsJvdFrame MakeIndexFrame(nsUInt32 f)
+  {
+    nsJvdFrame frame;
+    frame.m_uiFrameIndex = f;
+    frame.m_Timestamp = nsTime::MakeFromSeconds(f / 60.0);
+
+    for (nsUInt32 i = 0; i < 30; ++i)
+    {
+      nsJvdBodyState& state = frame.m_Bodies.ExpandAndGetRef();
+      state.m_uiBodyId = 1000 + (f + i) % 40;
+      state.m_vPosition.Set(static_cast<float>(f), static_cast<float>(i), 0.0f);
+    }
+
+    return frame;
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Recording, BodyIndexMap)
+{
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Map")
+  {
+    nsJvdBodyIndexMap map;
+    NS_TEST_INT(map.GetOrAddIndex(0xFFFF000000000005ull), 0);
+    NS_TEST_INT(map.GetOrAddIndex(3), 1);
+    NS_TEST_INT(map.GetOrAddIndex(0xFFFF000000000005ull), 0);
+    NS_TEST_INT(map.GetCount(), 2);
+    NS_TEST_INT(map.FindIndex(3), 1);
+    NS_TEST_INT(map.FindIndex(4), nsInvalidIndex);
+    NS_TEST_BOOL(map.GetBodyId(0) == 0xFFFF000000000005ull);
+
+    // a stale hint falls back to the lookup
+    NS_TEST_INT(map.GetOrAddIndex(3, 1), 1);
+    NS_TEST_INT(map.GetOrAddIndex(3, 0), 1);
+    NS_TEST_INT(map.GetOrAddIndex(8, 0), 2);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Clip")
+  {
+    nsJvdBodyMetadata metadata;
+    metadata.m_uiBodyId = 1039;
+    metadata.m_sName = "Last";
+
+    nsJvdClip clip;
+    clip.SetBodyMetadata(nsArrayPtr<const nsJvdBodyMetadata>(&metadata, 1));
+
+    for (nsUInt32 f = 0; f < 20; ++f)
+    {
+      clip.AddFrame(MakeIndexFrame(f));
+    }
+
+    // metadata bodies are indexed first, the others in the order they appear
+    const nsJvdBodyIndexMap& map = clip.GetBodyIndexMap();
+    NS_TEST_INT(map.GetCount(), 40);
+    NS_TEST_INT(map.GetBodyId(0), 1039);
+    NS_TEST_INT(map.GetBodyId(1), 1000);
+    NS_TEST_INT(map.GetBodyId(30), 1029);
+
+    for (const nsJvdFrame& frame : clip.GetFrames())
+    {
+      for (const nsJvdBodyState& state : frame.m_Bodies)
+      {
+        NS_TEST_BOOL(map.GetBodyId(state.m_uiBodyIndex) == state.m_uiBodyId);
+        NS_TEST_INT(clip.GetBodyIndex(state), state.m_uiBodyIndex);
+      }
+    }
+
+    NS_TEST_BOOL(clip.GetBodyMetadataByIndex(0) != nullptr && clip.GetBodyMetadataByIndex(0)->m_sName == "Last");
+    NS_TEST_BOOL(clip.FindBodyMetadata(1039) == clip.GetBodyMetadataByIndex(0));
+    NS_TEST_BOOL(clip.GetBodyMetadataByIndex(1) == nullptr);
+    NS_TEST_BOOL(clip.FindBodyMetadata(7) == nullptr);
+
+    // indices of another clip are replaced
+    nsJvdFrame frame = MakeIndexFrame(20);
+    for (nsJvdBodyState& state : frame.m_Bodies)
+    {
+      state.m_uiBodyIndex = 0;
+    }
+    clip.AddFrame(std::move(frame));
+
+    for (const nsJvdBodyState& state : clip.GetFrames().PeekBack().m_Bodies)
+    {
+      NS_TEST_BOOL(map.GetBodyId(state.m_uiBodyIndex) == state.m_uiBodyId);
+    }
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Serialization")
+  {
+    nsJvdClip clip;
+    for (nsUInt32 f = 0; f < 100; ++f)
+    {
+      clip.AddFrame(MakeIndexFrame(f));
+    }
+
+    nsJvdClipWriteSettings settings;
+    settings.m_Compression = nsJvdCompression::None;
+    settings.m_uiFramesPerBlock = 16;
+
+    nsDefaultMemoryStreamStorage storage;
+    nsMemoryStreamWriter writer(&storage);
+    NS_TEST_BOOL(nsJvdSerialization::WriteClip(writer, clip, settings).Succeeded());
+
+    // the ids are only stored once per block, the bodies refer to them with a single byte
+    const nsUInt32 uiStateSize = sizeof(nsVec3) * 4 + sizeof(nsQuat) + sizeof(float) * 2 + 1;
+    NS_TEST_BOOL(storage.GetStorageSize32() < 100 * (30 * (uiStateSize + 1) + 32) + 7 * 40 * 8 + 1024);
+
+    nsMemoryStreamReader reader(&storage);
+    nsJvdClip loaded;
+    NS_TEST_BOOL(nsJvdSerialization::ReadClip(reader, loaded).Succeeded());
+    NS_TEST_INT(loaded.GetFrames().GetCount(), 100);
+
+    for (nsUInt32 f = 0; f < 100; ++f)
+    {
+      const nsJvdFrame& expected = clip.GetFrames()[f];
+      const nsJvdFrame& actual = loaded.GetFrames()[f];
+      NS_TEST_INT(actual.m_Bodies.GetCount(), expected.m_Bodies.GetCount());
+
+      for (nsUInt32 i = 0; i < nsMath::Min(actual.m_Bodies.GetCount(), expected.m_Bodies.GetCount()); ++i)
+      {
+        NS_TEST_INT(actual.m_Bodies[i].m_uiBodyId, expected.m_Bodies[i].m_uiBodyId);
+        NS_TEST_BOOL(actual.m_Bodies[i].m_vPosition == expected.m_Bodies[i].m_vPosition);
+        NS_TEST_INT(actual.m_Bodies[i].m_uiBodyIndex, expected.m_Bodies[i].m_uiBodyIndex);
+      }
+    }
+
+    // frames outside of blocks keep their ids
+    nsDefaultMemoryStreamStorage frameStorage;
+    nsMemoryStreamWriter frameWriter(&frameStorage);
+    NS_TEST_BOOL(nsJvdSerialization::WriteFrame(frameWriter, clip.GetFrames()[50]).Succeeded());
+
+    nsMemoryStreamReader frameReader(&frameStorage);
+    nsJvdFrame frame;
+    NS_TEST_BOOL(nsJvdSerialization::ReadFrame(frameReader, frame).Succeeded());
+    NS_TEST_INT(frame.m_Bodies.GetCount(), 30);
+    NS_TEST_INT(frame.m_Bodies[29].m_uiBodyId, clip.GetFrames()[50].m_Bodies[29].m_uiBodyId);
+  }
+}
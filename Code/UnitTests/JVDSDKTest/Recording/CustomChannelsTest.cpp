@@ -0,0 +1,208 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+NS_CREATE_SIMPLE_TEST_GROUP(Recording);
+
+namespace
+{
+  nsJvdBodyState MakeBody(nsUInt64 uiBodyId, float fX)
+  {
+    nsJvdBodyState state;
+    state.m_uiBodyId = uiBodyId;
+    state.m_vPosition.Set(fX, 0.0f, 0.0f);
+    return state;
+  }
+
+  /// Serializes a two body frame whose only column (Float) is replaced by the given raw words.
+  nsDynamicArray<nsUInt8> MakeFrameWithColumn(nsUInt32 uiMaskWords, nsUInt32 uiMask, nsUInt32 uiValueWords)
+  {
+    nsJvdFrame frame;
+    frame.m_Bodies.PushBack(MakeBody(7, 1.0f));
+    frame.m_Bodies.PushBack(MakeBody(9, 2.0f));
+    frame.GetOrCreateCustomChannel(0, nsJvdCustomChannelType::Float).SetValue(1, 0.25f);
+
+    nsDynamicArray<nsUInt8> data;
+    nsMemoryStreamContainerWrapperStorage<nsDynamicArray<nsUInt8>> storage(&data);
+    nsMemoryStreamWriter writer(&storage);
+    nsJvdSerialization::WriteFrame(writer, frame).AssertSuccess();
+
+    // type, mask word count, one mask word, value word count, two values
+    data.SetCount(data.GetCount() - (1 + 4 + 4 + 4 + 2 * 4));
+    writer.SetWritePosition(data.GetCount());
+
+    const nsUInt8 uiType = nsJvdCustomChannelType::Float;
+    writer.WriteBytes(&uiType, sizeof(uiType)).AssertSuccess();
+    writer.WriteDWordValue(&uiMaskWords).AssertSuccess();
+    for (nsUInt32 i = 0; i < uiMaskWords; ++i)
+    {
+      writer.WriteDWordValue(&uiMask).AssertSuccess();
+    }
+    writer.WriteDWordValue(&uiValueWords).AssertSuccess();
+    for (nsUInt32 i = 0; i < uiValueWords; ++i)
+    {
+      writer.WriteDWordValue(&i).AssertSuccess();
+    }
+
+    return data;
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Recording, CustomChannels)
+{
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Column values and presence")
+  {
+    nsJvdCustomChannelColumn column;
+    column.Reset(nsJvdCustomChannelType::Vec3, 40);
+
+    NS_TEST_INT(column.GetBodyCount(), 40);
+    NS_TEST_BOOL(column.IsEmpty());
+
+    column.SetValue(33, nsVec3(1.0f, 2.0f, 3.0f));
+    NS_TEST_BOOL(!column.IsEmpty());
+    NS_TEST_BOOL(column.HasValue(33));
+    NS_TEST_BOOL(!column.HasValue(32));
+
+    nsVec3 vValue;
+    NS_TEST_BOOL(column.TryGetValue(33, vValue));
+    NS_TEST_VEC3(vValue, nsVec3(1.0f, 2.0f, 3.0f), 0.0f);
+    NS_TEST_BOOL(!column.TryGetValue(0, vValue));
+
+    float fWrongType = 0.0f;
+    NS_TEST_BOOL(!column.TryGetValue(33, fWrongType));
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Serialization round trip")
+  {
+    nsJvdClipMetadata metadata;
+    metadata.Reset();
+    metadata.m_sClipName = "Channels";
+    metadata.m_CustomChannels.ExpandAndGetRef() = {"Health", nsJvdCustomChannelType::Float};
+    metadata.m_CustomChannels.ExpandAndGetRef() = {"Grounded", nsJvdCustomChannelType::Bool};
+
+    nsJvdClip clip;
+    clip.SetMetadata(metadata);
+
+    nsJvdFrame frame;
+    frame.m_Bodies.PushBack(MakeBody(7, 1.0f));
+    frame.m_Bodies.PushBack(MakeBody(9, 2.0f));
+    frame.GetOrCreateCustomChannel(0, nsJvdCustomChannelType::Float).SetValue(1, 0.25f);
+    frame.GetOrCreateCustomChannel(1, nsJvdCustomChannelType::Bool).SetValue(0, true);
+    clip.AddFrame(std::move(frame));
+
+    nsDefaultMemoryStreamStorage storage;
+    nsMemoryStreamWriter writer(&storage);
+    NS_TEST_BOOL(nsJvdSerialization::WriteClip(writer, clip).Succeeded());
+
+    nsMemoryStreamReader reader(&storage);
+    nsJvdClip loaded;
+    NS_TEST_BOOL(nsJvdSerialization::ReadClip(reader, loaded).Succeeded());
+
+    NS_TEST_INT(loaded.GetMetadata().m_CustomChannels.GetCount(), 2);
+    NS_TEST_STRING(loaded.GetMetadata().m_CustomChannels[0].m_sName, "Health");
+    NS_TEST_BOOL(loaded.GetMetadata().m_CustomChannels[1].m_Type == nsJvdCustomChannelType::Bool);
+
+    const nsJvdFrame& loadedFrame = loaded.GetFrames()[0];
+    const nsJvdCustomChannelColumn* pHealth = loadedFrame.GetCustomChannel(0);
+    NS_TEST_BOOL(pHealth != nullptr);
+
+    float fHealth = 0.0f;
+    NS_TEST_BOOL(!pHealth->TryGetValue(0, fHealth));
+    NS_TEST_BOOL(pHealth->TryGetValue(1, fHealth));
+    NS_TEST_FLOAT(fHealth, 0.25f, 0.0f);
+
+    bool bGrounded = false;
+    NS_TEST_BOOL(loadedFrame.GetCustomChannel(1)->TryGetValue(0, bGrounded));
+    NS_TEST_BOOL(bGrounded);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Corrupt columns")
+  {
+    const auto ReadsBack = [](const nsDynamicArray<nsUInt8>& data)
+    {
+      nsRawMemoryStreamReader reader(data);
+      nsJvdFrame frame;
+      return nsJvdSerialization::ReadFrame(reader, frame).Succeeded();
+    };
+
+    NS_TEST_BOOL(ReadsBack(MakeFrameWithColumn(1, 0x2, 2)));
+    NS_TEST_BOOL(ReadsBack(MakeFrameWithColumn(0, 0, 0)));
+
+    // the presence mask claims values that were never stored
+    NS_TEST_BOOL(!ReadsBack(MakeFrameWithColumn(1, 0xFFFFFFFF, 0)));
+    NS_TEST_BOOL(!ReadsBack(MakeFrameWithColumn(1, 0x3, 1)));
+    NS_TEST_BOOL(!ReadsBack(MakeFrameWithColumn(1, 0x3, 3)));
+    NS_TEST_BOOL(!ReadsBack(MakeFrameWithColumn(2, 0x3, 2)));
+    NS_TEST_BOOL(!ReadsBack(MakeFrameWithColumn(0, 0, 2)));
+
+    // bits past the last body are dropped
+    nsDynamicArray<nsUInt8> data = MakeFrameWithColumn(1, 0xFFFFFFFF, 2);
+    nsRawMemoryStreamReader reader(data);
+    nsJvdFrame frame;
+    NS_TEST_BOOL(nsJvdSerialization::ReadFrame(reader, frame).Succeeded());
+    NS_TEST_BOOL(frame.GetCustomChannel(0)->HasValue(1));
+    NS_TEST_BOOL(!frame.GetCustomChannel(0)->HasValue(2));
+    float fValue = 0.0f;
+    NS_TEST_BOOL(!frame.GetCustomChannel(0)->TryGetValue(31, fValue));
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Bodies added after a value")
+  {
+    nsJvdFrame frame;
+    frame.m_Bodies.PushBack(MakeBody(7, 1.0f));
+    frame.GetOrCreateCustomChannel(0, nsJvdCustomChannelType::Vec3).SetValue(0, nsVec3(1.0f, 2.0f, 3.0f));
+    frame.m_Bodies.PushBack(MakeBody(9, 2.0f));
+
+    nsDynamicArray<nsUInt8> data;
+    nsMemoryStreamContainerWrapperStorage<nsDynamicArray<nsUInt8>> storage(&data);
+    nsMemoryStreamWriter writer(&storage);
+    NS_TEST_BOOL(nsJvdSerialization::WriteFrame(writer, frame).Succeeded());
+
+    // the column is padded to the bodies of the frame
+    nsRawMemoryStreamReader reader(data);
+    nsJvdFrame loaded;
+    NS_TEST_BOOL(nsJvdSerialization::ReadFrame(reader, loaded).Succeeded());
+
+    nsVec3 vValue;
+    NS_TEST_BOOL(loaded.GetCustomChannel(0)->TryGetValue(0, vValue));
+    NS_TEST_VEC3(vValue, nsVec3(1.0f, 2.0f, 3.0f), 0.0f);
+    NS_TEST_BOOL(!loaded.GetCustomChannel(0)->HasValue(1));
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Recorder staging")
+  {
+    nsJvdRecordingSettings settings;
+    settings.Reset();
+    settings.m_TargetFrameInterval = nsTime::MakeZero();
+    const nsJvdCustomChannelIndex health = settings.AddCustomChannel("Health", nsJvdCustomChannelType::Float);
+    const nsJvdCustomChannelIndex team = settings.AddCustomChannel("Team", nsJvdCustomChannelType::Int);
+    NS_TEST_INT(settings.AddCustomChannel("Health", nsJvdCustomChannelType::Float), health);
+
+    nsJvdRecorder recorder;
+    recorder.StartRecording(settings);
+
+    recorder.SetCustomValue(health, 9, 0.5f);
+    recorder.SetCustomValue(team, 7, 3);
+    recorder.SetCustomValue(team, 1234, 4); // not part of the frame, dropped
+
+    nsJvdBodyState states[] = {MakeBody(7, 1.0f), MakeBody(9, 2.0f)};
+    recorder.AppendFrame(nsTime::MakeFromSeconds(1.0), nsMakeArrayPtr(states));
+    recorder.AppendFrame(nsTime::MakeFromSeconds(2.0), nsMakeArrayPtr(states));
+
+    nsJvdClip clip;
+    NS_TEST_BOOL(recorder.StopRecording(clip).Succeeded());
+    NS_TEST_INT(clip.GetFrames().GetCount(), 2);
+    NS_TEST_INT(clip.GetMetadata().m_CustomChannels.GetCount(), 2);
+
+    const nsJvdFrame& first = clip.GetFrames()[0];
+    float fHealth = 0.0f;
+    NS_TEST_BOOL(first.GetCustomChannel(health)->TryGetValue(1, fHealth));
+    NS_TEST_FLOAT(fHealth, 0.5f, 0.0f);
+
+    nsInt32 iTeam = 0;
+    NS_TEST_BOOL(first.GetCustomChannel(team)->TryGetValue(0, iTeam));
+    NS_TEST_INT(iTeam, 3);
+    NS_TEST_BOOL(!first.GetCustomChannel(team)->HasValue(1));
+
+    // staged values only apply to a single frame
+    NS_TEST_BOOL(clip.GetFrames()[1].GetCustomChannel(health) == nullptr);
+  }
+}
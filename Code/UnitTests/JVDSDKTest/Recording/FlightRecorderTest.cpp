@@ -0,0 +1,186 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+#include <Foundation/IO/FileSystem/FileSystem.h>
+
+namespace
+{
+  nsJvdFrame MakeFlightFrame(nsUInt64 uiFrameIndex, nsUInt32 uiBodyCount)
+  {
+    nsJvdFrame frame;
+    frame.m_uiFrameIndex = uiFrameIndex;
+    frame.m_Timestamp = nsTime::MakeFromSeconds(static_cast<double>(uiFrameIndex));
+
+    for (nsUInt32 i = 0; i < uiBodyCount; ++i)
+    {
+      nsJvdBodyState& state = frame.m_Bodies.ExpandAndGetRef();
+      state.m_uiBodyId = i;
+      state.m_vPosition.Set(static_cast<float>(uiFrameIndex), 0.0f, 0.0f);
+    }
+
+    return frame;
+  }
+
+  nsJvdBodyState MakeFlightBody(float fX)
+  {
+    nsJvdBodyState state;
+    state.m_uiBodyId = 3;
+    state.m_vPosition.Set(fX, 0.0f, 0.0f);
+    return state;
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Recording, FlightRecorder)
+{
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Frame ring eviction")
+  {
+    nsDefaultMemoryStreamStorage storage;
+    nsMemoryStreamWriter writer(&storage);
+    NS_TEST_BOOL(nsJvdSerialization::WriteFrame(writer, MakeFlightFrame(0, 4)).Succeeded());
+    const nsUInt32 uiFrameSize = storage.GetStorageSize32();
+
+    // room for three and a half frames, the ring has to wrap around
+    nsJvdFrameRing ring;
+    ring.Initialize(uiFrameSize * 7 / 2, 16);
+
+    for (nsUInt64 i = 0; i < 10; ++i)
+    {
+      NS_TEST_BOOL(ring.PushFrame(MakeFlightFrame(i, 4)).Succeeded());
+      NS_TEST_BOOL(ring.GetFrameCount() <= 3);
+    }
+
+    NS_TEST_INT(ring.GetFrameCount(), 3);
+    NS_TEST_INT(ring.GetUsedBytes(), uiFrameSize * 3);
+
+    nsDynamicArray<nsUInt8> data;
+    ring.CopyFrames(data);
+
+    nsRawMemoryStreamReader reader(data);
+    for (nsUInt64 i = 7; i < 10; ++i)
+    {
+      nsJvdFrame frame;
+      NS_TEST_BOOL(nsJvdSerialization::ReadFrame(reader, frame).Succeeded());
+      NS_TEST_INT(frame.m_uiFrameIndex, i);
+      NS_TEST_FLOAT(frame.m_Bodies[3].m_vPosition.x, static_cast<float>(i), 0.0f);
+    }
+
+    ring.DropFramesBefore(nsTime::MakeFromSeconds(9.0));
+    NS_TEST_INT(ring.GetFrameCount(), 1);
+
+    NS_TEST_BOOL(ring.PushFrame(MakeFlightFrame(10, 100)).Failed());
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Frame ring respects frame capacity")
+  {
+    nsJvdFrameRing ring;
+    ring.Initialize(64 * 1024, 4);
+
+    for (nsUInt64 i = 0; i < 10; ++i)
+    {
+      NS_TEST_BOOL(ring.PushFrame(MakeFlightFrame(i, 1)).Succeeded());
+    }
+
+    NS_TEST_INT(ring.GetFrameCount(), 4);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Recorder keeps only the window")
+  {
+    nsJvdRecordingSettings settings;
+    settings.Reset();
+    settings.m_TargetFrameInterval = nsTime::MakeZero();
+    settings.m_FlightRecorderWindow = nsTime::MakeFromSeconds(1.0);
+    settings.m_uiFlightRecorderBufferSize = 64 * 1024;
+
+    nsJvdRecorder recorder;
+    recorder.StartRecording(settings);
+    NS_TEST_BOOL(recorder.IsFlightRecorderActive());
+
+    for (nsUInt32 i = 0; i < 50; ++i)
+    {
+      nsJvdBodyState body = MakeFlightBody(static_cast<float>(i));
+      recorder.AppendFrame(nsTime::MakeFromSeconds(1.0 + i * 0.1), nsMakeArrayPtr(&body, 1));
+    }
+
+    // nothing accumulates in the regular clip
+    NS_TEST_BOOL(recorder.PeekClip().IsEmpty());
+
+    nsJvdClip clip;
+    NS_TEST_BOOL(recorder.StopRecording(clip).Succeeded());
+
+    const nsUInt32 uiFrameCount = clip.GetFrames().GetCount();
+    NS_TEST_BOOL(uiFrameCount >= 10 && uiFrameCount <= 11);
+    NS_TEST_INT(clip.GetFrames()[0].m_uiFrameIndex, 0);
+    NS_TEST_FLOAT(clip.GetFrames()[0].m_Timestamp.GetSeconds(), 0.0, 0.0);
+    NS_TEST_FLOAT(clip.GetDuration().GetSeconds(), (uiFrameCount - 1) * 0.1, 0.0001);
+    NS_TEST_FLOAT(clip.GetFrames().PeekBack().m_Bodies[0].m_vPosition.x, 49.0f, 0.0f);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Body metadata round trip")
+  {
+    nsJvdBodyMetadata body;
+    body.Reset();
+    body.m_uiBodyId = 3;
+    body.m_BodyGuid = nsUuid::MakeUuid();
+    body.m_sName = "Crate";
+    body.m_sShape = "Box";
+    body.m_bKinematic = true;
+
+    nsJvdClip clip;
+    clip.SetBodyMetadata(nsMakeArrayPtr(&body, 1));
+    clip.AddFrame(MakeFlightFrame(0, 4));
+
+    nsDefaultMemoryStreamStorage storage;
+    nsMemoryStreamWriter writer(&storage);
+    NS_TEST_BOOL(nsJvdSerialization::WriteClip(writer, clip).Succeeded());
+
+    nsMemoryStreamReader reader(&storage);
+    nsJvdClip loaded;
+    NS_TEST_BOOL(nsJvdSerialization::ReadClip(reader, loaded).Succeeded());
+
+    const nsJvdBodyMetadata* pLoaded = loaded.FindBodyMetadata(3);
+    NS_TEST_BOOL(pLoaded != nullptr);
+    NS_TEST_BOOL(pLoaded->m_BodyGuid == body.m_BodyGuid);
+    NS_TEST_STRING(pLoaded->m_sName, "Crate");
+    NS_TEST_STRING(pLoaded->m_sShape, "Box");
+    NS_TEST_BOOL(pLoaded->m_bKinematic);
+    NS_TEST_BOOL(!pLoaded->m_bTrigger);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Dump to file")
+  {
+    nsStringBuilder sWriteDir = nsTestFramework::GetInstance()->GetAbsOutputPath();
+    NS_TEST_BOOL(nsFileSystem::AddDataDirectory(sWriteDir, "FlightRecorder", "output", nsDataDirUsage::AllowWrites) == NS_SUCCESS);
+
+    nsJvdRecordingSettings settings;
+    settings.Reset();
+    settings.m_sSessionName = "Flight";
+    settings.m_FlightRecorderWindow = nsTime::MakeFromSeconds(0.5);
+    settings.m_uiFlightRecorderBufferSize = 64 * 1024;
+
+    nsJvdRecorder recorder;
+    NS_TEST_BOOL(!recorder.DumpFlightRecorder(":output/JvdFlight.jvdrec").IsValid());
+
+    recorder.StartRecording(settings);
+    for (nsUInt32 i = 0; i < 120; ++i)
+    {
+      nsJvdBodyState body = MakeFlightBody(static_cast<float>(i));
+      recorder.AppendFrame(nsTime::MakeFromSeconds(1.0 + i / 60.0), nsMakeArrayPtr(&body, 1));
+    }
+
+    const nsTaskGroupID dumpGroup = recorder.DumpFlightRecorder(":output/JvdFlight.jvdrec");
+    NS_TEST_BOOL(dumpGroup.IsValid());
+    nsTaskSystem::WaitForGroup(dumpGroup);
+
+    // dumping does not stop the recording
+    NS_TEST_BOOL(recorder.IsRecording());
+    recorder.CancelRecording();
+
+    nsJvdClip loaded;
+    NS_TEST_BOOL(nsJvdSerialization::LoadClipFromFile(":output/JvdFlight.jvdrec", loaded).Succeeded());
+    NS_TEST_STRING(loaded.GetMetadata().m_sClipName, "Flight");
+    NS_TEST_BOOL(loaded.GetFrames().GetCount() >= 30 && loaded.GetFrames().GetCount() <= 31);
+    NS_TEST_FLOAT(loaded.GetFrames().PeekBack().m_Bodies[0].m_vPosition.x, 119.0f, 0.0f);
+
+    nsFileSystem::DeleteFile(":output/JvdFlight.jvdrec");
+    nsFileSystem::RemoveDataDirectoryGroup("FlightRecorder");
+  }
+}
@@ -0,0 +1,138 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+#include <Foundation/Threading/DelegateTask.h>
+#include <Foundation/Threading/TaskSystem.h>
+
+NS_CREATE_SIMPLE_TEST(Recording, LogQueue)
+{
+  nsJvdLogQueue queue;
+  nsDynamicArray<nsJvdLogEntry> entries;
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Push and drain")
+  {
+    queue.Initialize(5);
+    NS_TEST_INT(queue.GetCapacity(), 8);
+
+    NS_TEST_BOOL(queue.TryPush(nsLogMsgType::WarningMsg, 2, "Serializer", "Block 3 is corrupt"));
+    NS_TEST_BOOL(queue.TryPush(nsLogMsgType::InfoMsg, 0, {}, "Loaded"));
+
+    NS_TEST_INT(queue.Drain(entries), 2);
+    NS_TEST_INT(entries.GetCount(), 2);
+    NS_TEST_INT(entries[0].m_Type, nsLogMsgType::WarningMsg);
+    NS_TEST_INT(entries[0].m_uiIndentation, 2);
+    NS_TEST_STRING(entries[0].m_sTag, "Serializer");
+    NS_TEST_STRING(entries[0].m_sText, "Block 3 is corrupt");
+    NS_TEST_BOOL(entries[1].m_sTag.IsEmpty());
+    NS_TEST_STRING(entries[1].m_sText, "Loaded");
+
+    NS_TEST_INT(queue.Drain(entries), 0);
+    NS_TEST_INT(entries.GetCount(), 2);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Full queue drops")
+  {
+    queue.Initialize(4);
+    entries.Clear();
+
+    for (nsUInt32 i = 0; i < 6; ++i)
+    {
+      nsStringBuilder sText;
+      sText.SetFormat("Message {0}", i);
+      NS_TEST_BOOL(queue.TryPush(nsLogMsgType::InfoMsg, 0, {}, sText) == (i < 4));
+    }
+
+    NS_TEST_INT(queue.TakeDroppedCount(), 2);
+    NS_TEST_INT(queue.TakeDroppedCount(), 0);
+
+    // partial drains free exactly the drained slots
+    NS_TEST_INT(queue.Drain(entries, 3), 3);
+    NS_TEST_STRING(entries[2].m_sText, "Message 2");
+
+    NS_TEST_BOOL(queue.TryPush(nsLogMsgType::InfoMsg, 0, {}, "Message 6"));
+    NS_TEST_BOOL(queue.TryPush(nsLogMsgType::InfoMsg, 0, {}, "Message 7"));
+
+    NS_TEST_INT(queue.Drain(entries), 3);
+    NS_TEST_STRING(entries[3].m_sText, "Message 3");
+    NS_TEST_STRING(entries[5].m_sText, "Message 7");
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Wrap around")
+  {
+    queue.Initialize(4);
+
+    bool bInOrder = true;
+    for (nsUInt32 i = 0; i < 1000; ++i)
+    {
+      nsStringBuilder sText;
+      sText.SetFormat("{0}", i);
+      queue.TryPush(nsLogMsgType::InfoMsg, 0, {}, sText);
+
+      entries.Clear();
+      bInOrder = bInOrder && queue.Drain(entries) == 1 && entries[0].m_sText == sText;
+    }
+
+    NS_TEST_BOOL(bInOrder);
+    NS_TEST_INT(queue.TakeDroppedCount(), 0);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Concurrent producers")
+  {
+    constexpr nsUInt32 uiProducerCount = 4;
+    constexpr nsUInt32 uiMessageCount = 5000;
+
+    queue.Initialize(256);
+    entries.Clear();
+
+    nsTaskGroupID group = nsTaskSystem::CreateTaskGroup(nsTaskPriority::LongRunning);
+    for (nsUInt32 p = 0; p < uiProducerCount; ++p)
+    {
+      nsSharedPtr<nsTask> pTask = NS_DEFAULT_NEW(nsDelegateTask<void>, "JVD Log Queue Test Producer", nsTaskNesting::Never, [&queue, p]()
+        {
+          nsStringBuilder sText;
+          for (nsUInt32 i = 0; i < uiMessageCount; ++i)
+          {
+            sText.SetFormat("{0} {1}", p, i);
+            queue.TryPush(nsLogMsgType::InfoMsg, p, {}, sText);
+          }
+        });
+
+      nsTaskSystem::AddTaskToGroup(group, pTask);
+    }
+
+    nsTaskSystem::StartTaskGroup(group);
+
+    // the main thread drains while the producers log, like the UI thread does
+    while (!nsTaskSystem::IsTaskGroupFinished(group))
+    {
+      queue.Drain(entries);
+      nsThreadUtils::YieldTimeSlice();
+    }
+    queue.Drain(entries);
+
+    NS_TEST_INT(entries.GetCount() + queue.TakeDroppedCount(), uiProducerCount * uiMessageCount);
+
+    // messages of one producer keep their order, even when some of them were dropped
+    nsUInt32 uiLastMessage[uiProducerCount];
+    for (nsUInt32 p = 0; p < uiProducerCount; ++p)
+    {
+      uiLastMessage[p] = nsInvalidIndex;
+    }
+
+    bool bValid = true;
+    for (const nsJvdLogEntry& entry : entries)
+    {
+      nsUInt32 uiProducer = 0;
+      nsUInt32 uiMessage = 0;
+      bValid = bValid && entry.m_uiIndentation < uiProducerCount && sscanf(entry.m_sText.GetData(), "%u %u", &uiProducer, &uiMessage) == 2;
+      bValid = bValid && uiProducer == entry.m_uiIndentation;
+
+      if (bValid)
+      {
+        bValid = uiLastMessage[uiProducer] == nsInvalidIndex || uiLastMessage[uiProducer] < uiMessage;
+        uiLastMessage[uiProducer] = uiMessage;
+      }
+    }
+
+    NS_TEST_BOOL(bValid);
+  }
+}
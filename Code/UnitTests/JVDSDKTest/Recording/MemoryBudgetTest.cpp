@@ -0,0 +1,143 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+namespace
+{
+  /// Bodies 0 to 9 move, bodies 10 to 19 sleep but report some solver noise as velocity.
+  void MakeBudgetStates(nsUInt32 f, nsDynamicArray<nsJvdBodyState>& out_states)
+  {
+    out_states.Clear();
+
+    for (nsUInt32 i = 0; i < 20; ++i)
+    {
+      nsJvdBodyState& state = out_states.ExpandAndGetRef();
+      state.m_uiBodyId = 100 + i;
+      state.m_bIsSleeping = i >= 10;
+
+      if (state.m_bIsSleeping)
+      {
+        state.m_vPosition.Set(static_cast<float>(i), 0.0f, 0.0f);
+        state.m_vLinearVelocity.Set(0.0f, 0.001f * (f % 7), 0.0f);
+      }
+      else
+      {
+        state.m_vPosition.Set(static_cast<float>(i), f * 0.01f, 0.0f);
+        state.m_vLinearVelocity.Set(0.0f, 0.6f, 0.0f);
+      }
+    }
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Recording, MemoryBudget)
+{
+  nsDynamicArray<nsJvdBodyState> states;
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Compaction")
+  {
+    nsJvdRecordingSettings settings;
+    settings.Reset();
+    settings.m_uiMemoryBudget = 256 * 1024;
+    settings.m_FullFidelityWindow = nsTime::MakeFromSeconds(1.0);
+
+    nsJvdRecorder recorder;
+    recorder.StartRecording(settings);
+
+    bool bWithinBudget = true;
+    for (nsUInt32 f = 0; f < 3000; ++f)
+    {
+      MakeBudgetStates(f, states);
+      recorder.AppendFrame(nsTime::MakeFromSeconds(1.0 + f / 60.0), states);
+
+      bWithinBudget = bWithinBudget && recorder.GetMemoryStats().m_uiMemoryUsage <= settings.m_uiMemoryBudget;
+    }
+
+    NS_TEST_BOOL(bWithinBudget);
+
+    const nsJvdRecorderMemoryStats stats = recorder.GetMemoryStats();
+    NS_TEST_BOOL(stats.m_uiCompactedFrames > 0);
+    NS_TEST_BOOL(stats.m_uiCompactedBytes > 0);
+    NS_TEST_BOOL(stats.m_uiThinnedFrames > 0);
+    NS_TEST_BOOL(stats.m_uiStrippedVelocities > 0);
+    NS_TEST_INT(stats.m_uiLiveFrames, recorder.PeekClip().GetFrames().GetCount());
+
+    // the full fidelity window is untouched
+    const nsDynamicArray<nsJvdFrame>& liveFrames = recorder.PeekClip().GetFrames();
+    NS_TEST_BOOL(liveFrames.GetCount() >= 60);
+    NS_TEST_INT(liveFrames.PeekBack().m_uiFrameIndex, 2999);
+    NS_TEST_INT(liveFrames[liveFrames.GetCount() - 60].m_uiFrameIndex, 2940);
+    NS_TEST_FLOAT(liveFrames.PeekBack().m_Bodies[15].m_vLinearVelocity.y, 0.001f * (2999 % 7), 0.0f);
+
+    nsJvdClip clip;
+    NS_TEST_BOOL(recorder.StopRecording(clip).Succeeded());
+
+    const nsDynamicArray<nsJvdFrame>& frames = clip.GetFrames();
+    NS_TEST_INT(frames.GetCount(), stats.m_uiLiveFrames + stats.m_uiCompactedFrames);
+    NS_TEST_INT(frames.GetCount() + stats.m_uiThinnedFrames + stats.m_uiDroppedFrames, 3000);
+    NS_TEST_INT(frames.PeekBack().m_uiFrameIndex, 2999);
+    NS_TEST_BOOL(clip.IsTimelineSummaryUpToDate());
+
+    // the oldest history has the lowest rate
+    NS_TEST_BOOL(frames[1].m_uiFrameIndex - frames[0].m_uiFrameIndex > 1);
+
+    bool bAscending = true;
+    for (nsUInt32 i = 1; i < frames.GetCount(); ++i)
+    {
+      bAscending = bAscending && frames[i - 1].m_uiFrameIndex < frames[i].m_uiFrameIndex && frames[i - 1].m_Timestamp < frames[i].m_Timestamp;
+    }
+    NS_TEST_BOOL(bAscending);
+
+    // compacted frames keep their positions, sleeping bodies lose their velocities
+    const nsJvdFrame& oldFrame = frames[0];
+    NS_TEST_FLOAT(oldFrame.m_Bodies[5].m_vPosition.y, oldFrame.m_uiFrameIndex * 0.01f, 0.0f);
+    NS_TEST_FLOAT(oldFrame.m_Bodies[5].m_vLinearVelocity.y, 0.6f, 0.0f);
+    NS_TEST_BOOL(oldFrame.m_Bodies[15].m_vLinearVelocity.IsZero());
+
+    for (const nsJvdBodyState& state : oldFrame.m_Bodies)
+    {
+      NS_TEST_BOOL(clip.GetBodyIndexMap().GetBodyId(state.m_uiBodyIndex) == state.m_uiBodyId);
+    }
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Window larger than the budget")
+  {
+    nsJvdRecordingSettings settings;
+    settings.Reset();
+    settings.m_uiMemoryBudget = 64 * 1024;
+    settings.m_FullFidelityWindow = nsTime::MakeFromSeconds(60.0);
+
+    nsJvdRecorder recorder;
+    recorder.StartRecording(settings);
+
+    for (nsUInt32 f = 0; f < 600; ++f)
+    {
+      MakeBudgetStates(f, states);
+      recorder.AppendFrame(nsTime::MakeFromSeconds(1.0 + f / 60.0), states);
+    }
+
+    const nsJvdRecorderMemoryStats stats = recorder.GetMemoryStats();
+    NS_TEST_BOOL(stats.m_uiMemoryUsage <= settings.m_uiMemoryBudget);
+    NS_TEST_INT(stats.m_uiCompactedFrames, 0);
+    NS_TEST_BOOL(stats.m_uiDroppedFrames > 0);
+    NS_TEST_INT(recorder.PeekClip().GetFrames().PeekBack().m_uiFrameIndex, 599);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "No budget")
+  {
+    nsJvdRecordingSettings settings;
+    settings.Reset();
+
+    nsJvdRecorder recorder;
+    recorder.StartRecording(settings);
+
+    for (nsUInt32 f = 0; f < 300; ++f)
+    {
+      MakeBudgetStates(f, states);
+      recorder.AppendFrame(nsTime::MakeFromSeconds(1.0 + f / 60.0), states);
+    }
+
+    const nsJvdRecorderMemoryStats stats = recorder.GetMemoryStats();
+    NS_TEST_INT(stats.m_uiLiveFrames, 300);
+    NS_TEST_INT(stats.m_uiCompactedFrames, 0);
+    NS_TEST_INT(stats.m_uiThinnedFrames + stats.m_uiDroppedFrames + stats.m_uiStrippedVelocities, 0);
+    NS_TEST_BOOL(stats.m_uiMemoryUsage >= 300 * 20 * sizeof(nsJvdBodyState));
+  }
+}
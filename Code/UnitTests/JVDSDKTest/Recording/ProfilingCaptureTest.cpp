@@ -0,0 +1,210 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+#include <Foundation/IO/FileSystem/FileSystem.h>
+#include <Foundation/IO/MemoryStream.h>
+#include <Foundation/Strings/StringBuilder.h>
+
+namespace
+{
+  void BusyWait(nsTime duration)
+  {
+    const nsTime end = nsTime::Now() + duration;
+    while (nsTime::Now() < end)
+    {
+    }
+  }
+
+  /// Two threads with a few nested scopes per frame.
+  void FillProfilingData(nsJvdProfilingData& out_profiling)
+  {
+    const nsUInt32 uiStep = out_profiling.InternScopeName("Step");
+    const nsUInt32 uiSolve = out_profiling.InternScopeName("Solve");
+    const nsUInt32 uiBroadphase = out_profiling.InternScopeName("Broadphase");
+    const nsUInt16 uiMain = out_profiling.InternThreadName("Main Thread");
+    const nsUInt16 uiWorker = out_profiling.InternThreadName("Worker 0");
+
+    for (nsUInt32 f = 0; f < 100; ++f)
+    {
+      nsJvdFrameProfile& frame = out_profiling.AddFrame(f * 2);
+      frame.m_StartTime = nsTime::MakeFromMicroseconds(f * 16667.0);
+      frame.m_Duration = nsTime::MakeFromMicroseconds(16667.0);
+
+      auto AddScope = [&](nsUInt32 uiName, nsUInt16 uiThread, nsUInt16 uiDepth, double fBeginUs, double fDurationUs)
+      {
+        nsJvdProfileScope& scope = frame.m_Scopes.ExpandAndGetRef();
+        scope.m_uiNameIndex = uiName;
+        scope.m_uiThreadIndex = uiThread;
+        scope.m_uiDepth = uiDepth;
+        scope.m_BeginTime = nsTime::MakeFromMicroseconds(fBeginUs);
+        scope.m_Duration = nsTime::MakeFromMicroseconds(fDurationUs);
+      };
+
+      AddScope(uiStep, uiMain, 0, 100.0, 4000.0 + f);
+      AddScope(uiBroadphase, uiMain, 1, 150.0, 800.0);
+      AddScope(uiSolve, uiMain, 1, 1000.0, 2500.0);
+      AddScope(uiSolve, uiWorker, 0, 1010.0, 2400.0);
+    }
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Recording, ProfilingCapture)
+{
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Serialization")
+  {
+    nsJvdProfilingData profiling;
+    FillProfilingData(profiling);
+    profiling.SetCaptureOverhead(nsTime::MakeFromMicroseconds(1234.0));
+
+    NS_TEST_INT(profiling.InternScopeName("Solve"), 1);
+    NS_TEST_INT(profiling.GetScopeNames().GetCount(), 3);
+    NS_TEST_BOOL(profiling.FindFrame(20) != nullptr);
+    NS_TEST_BOOL(profiling.FindFrame(21) == nullptr);
+
+    nsDynamicArray<nsUInt8> data;
+    nsMemoryStreamContainerWrapperStorage<nsDynamicArray<nsUInt8>> storage(&data);
+    nsMemoryStreamWriter writer(&storage);
+    NS_TEST_BOOL(nsJvdSerialization::WriteProfilingData(writer, profiling).Succeeded());
+
+    // the names are stored once, every scope takes a few varints
+    NS_TEST_BOOL(data.GetCount() * 2 < 100 * 4 * sizeof(nsJvdProfileScope));
+
+    nsJvdProfilingData loaded;
+    nsMemoryStreamReader reader(&storage);
+    NS_TEST_BOOL(nsJvdSerialization::ReadProfilingData(reader, loaded).Succeeded());
+
+    NS_TEST_INT(loaded.GetFrames().GetCount(), 100);
+    NS_TEST_INT(loaded.GetThreadNames().GetCount(), 2);
+    NS_TEST_STRING(loaded.GetScopeNames()[2], "Broadphase");
+    NS_TEST_FLOAT(loaded.GetCaptureOverhead().GetMicroseconds(), 1234.0, 0.01);
+
+    bool bAllEqual = true;
+    for (nsUInt32 f = 0; f < 100; ++f)
+    {
+      const nsJvdFrameProfile& a = profiling.GetFrames()[f];
+      const nsJvdFrameProfile& b = loaded.GetFrames()[f];
+      bAllEqual = bAllEqual && a.m_uiFrameIndex == b.m_uiFrameIndex && a.m_Scopes.GetCount() == b.m_Scopes.GetCount();
+      bAllEqual = bAllEqual && nsMath::Abs((a.m_StartTime - b.m_StartTime).GetNanoseconds()) < 100.0;
+
+      for (nsUInt32 s = 0; bAllEqual && s < a.m_Scopes.GetCount(); ++s)
+      {
+        const nsJvdProfileScope& sa = a.m_Scopes[s];
+        const nsJvdProfileScope& sb = b.m_Scopes[s];
+        bAllEqual = sa.m_uiNameIndex == sb.m_uiNameIndex && sa.m_uiThreadIndex == sb.m_uiThreadIndex && sa.m_uiDepth == sb.m_uiDepth;
+        bAllEqual = bAllEqual && nsMath::Abs((sa.m_BeginTime - sb.m_BeginTime).GetNanoseconds()) < 1.0;
+        bAllEqual = bAllEqual && nsMath::Abs((sa.m_Duration - sb.m_Duration).GetNanoseconds()) < 1.0;
+      }
+    }
+
+    NS_TEST_BOOL(bAllEqual);
+
+    loaded.RemoveFramesBefore(50);
+    NS_TEST_INT(loaded.GetFrames().GetCount(), 75);
+    NS_TEST_INT(loaded.GetFrames()[0].m_uiFrameIndex, 50);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Clip file")
+  {
+    nsStringBuilder sWriteDir = nsTestFramework::GetInstance()->GetAbsOutputPath();
+    NS_TEST_BOOL(nsFileSystem::AddDataDirectory(sWriteDir, "ProfilingCapture", "output", nsDataDirUsage::AllowWrites) == NS_SUCCESS);
+
+    nsJvdClip clip;
+    for (nsUInt32 f = 0; f < 200; ++f)
+    {
+      nsJvdFrame frame;
+      frame.m_uiFrameIndex = f;
+      frame.m_Timestamp = nsTime::MakeFromSeconds(f / 60.0);
+      frame.m_Bodies.ExpandAndGetRef().m_uiBodyId = 1;
+      clip.AddFrame(std::move(frame));
+    }
+
+    FillProfilingData(clip.GetProfiling());
+
+    NS_TEST_BOOL(nsJvdSerialization::SaveClipToFile(":output/Profiling.jvdrec", clip).Succeeded());
+
+    nsJvdClip loaded;
+    NS_TEST_BOOL(nsJvdSerialization::LoadClipFromFile(":output/Profiling.jvdrec", loaded).Succeeded());
+    NS_TEST_INT(loaded.GetFrames().GetCount(), 200);
+    NS_TEST_INT(loaded.GetProfiling().GetFrames().GetCount(), 100);
+
+    const nsJvdFrameProfile* pLastProfile = loaded.GetProfiling().FindFrame(198);
+    if (NS_TEST_BOOL(pLastProfile != nullptr))
+    {
+      NS_TEST_INT(pLastProfile->m_Scopes.GetCount(), 4);
+    }
+
+    nsDynamicArray<nsJvdClip> tracks;
+    tracks.PushBack(clip);
+    tracks.PushBack(nsJvdClip());
+    NS_TEST_BOOL(nsJvdSerialization::SaveSessionToFile(":output/Profiling.jvdses", tracks).Succeeded());
+
+    NS_TEST_BOOL(nsJvdSerialization::LoadSessionFromFile(":output/Profiling.jvdses", tracks).Succeeded());
+    NS_TEST_INT(tracks.GetCount(), 2);
+    NS_TEST_INT(tracks[0].GetProfiling().GetFrames().GetCount(), 100);
+    NS_TEST_BOOL(tracks[1].GetProfiling().IsEmpty());
+
+    nsFileSystem::DeleteFile(":output/Profiling.jvdrec");
+    nsFileSystem::DeleteFile(":output/Profiling.jvdses");
+    nsFileSystem::RemoveDataDirectoryGroup("ProfilingCapture");
+  }
+
+#if NS_ENABLED(NS_USE_PROFILING)
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Recorder")
+  {
+    nsJvdRecordingSettings settings;
+    settings.m_TargetFrameInterval = nsTime::MakeZero();
+    settings.m_bCaptureProfiling = true;
+
+    nsJvdRecorder recorder;
+    recorder.StartRecording(settings);
+
+    const nsJvdBodyState state;
+    for (nsUInt32 f = 0; f < 40; ++f)
+    {
+      {
+        NS_PROFILE_SCOPE("JvdTestStep");
+        BusyWait(nsTime::MakeFromMicroseconds(100.0));
+
+        {
+          NS_PROFILE_SCOPE("JvdTestSolve");
+          BusyWait(nsTime::MakeFromMicroseconds(300.0));
+        }
+      }
+
+      recorder.AppendFrame(nsTime::MakeFromSeconds(f / 60.0), nsMakeArrayPtr(&state, 1));
+    }
+
+    nsJvdClip clip;
+    NS_TEST_BOOL(recorder.StopRecording(clip).Succeeded());
+
+    const nsJvdProfilingData& profiling = clip.GetProfiling();
+    NS_TEST_INT(profiling.GetFrames().GetCount(), 40);
+    NS_TEST_BOOL(profiling.GetCaptureOverhead().IsPositive());
+
+    // every frame contains the scopes that ran since the previous frame, in the right nesting
+    bool bAllFramesProfiled = true;
+    for (const nsJvdFrameProfile& frame : profiling.GetFrames())
+    {
+      const nsJvdProfileScope* pStep = nullptr;
+      const nsJvdProfileScope* pSolve = nullptr;
+      for (const nsJvdProfileScope& scope : frame.m_Scopes)
+      {
+        const nsString& sName = profiling.GetScopeNames()[scope.m_uiNameIndex];
+        if (sName == "JvdTestStep")
+          pStep = &scope;
+        else if (sName == "JvdTestSolve")
+          pSolve = &scope;
+      }
+
+      bAllFramesProfiled = bAllFramesProfiled && pStep != nullptr && pSolve != nullptr;
+      if (!bAllFramesProfiled)
+        break;
+
+      bAllFramesProfiled = pStep->m_uiThreadIndex == pSolve->m_uiThreadIndex && pSolve->m_uiDepth == pStep->m_uiDepth + 1;
+      bAllFramesProfiled = bAllFramesProfiled && pStep->m_BeginTime + pStep->m_Duration <= frame.m_Duration;
+      bAllFramesProfiled = bAllFramesProfiled && pSolve->m_Duration.GetMicroseconds() >= 300.0;
+    }
+
+    NS_TEST_BOOL(bAllFramesProfiled);
+  }
+#endif
+}
@@ -0,0 +1,252 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+#include <Foundation/IO/FileSystem/FileSystem.h>
+#include <Foundation/Threading/DelegateTask.h>
+#include <TestFramework/Utilities/TestLogInterface.h>
+
+namespace
+{
+  /// Track t has the bodies t * 100 + i, body i moves along x in steps of i + 1.
+  void CaptureSessionFrame(nsJvdRecordingTrack& track, nsUInt32 uiTrack, nsUInt32 f, nsTime startTime, nsDynamicArray<nsJvdBodyState>& ref_states)
+  {
+    ref_states.Clear();
+    for (nsUInt32 i = 0; i < 3 + uiTrack; ++i)
+    {
+      nsJvdBodyState& state = ref_states.ExpandAndGetRef();
+      state.m_uiBodyId = uiTrack * 100 + i;
+      state.m_vPosition.Set(static_cast<float>(f * (i + 1)), static_cast<float>(uiTrack), 0.0f);
+    }
+
+    track.AppendFrame(startTime + nsTime::MakeFromMilliseconds(f * 10 + uiTrack), ref_states);
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Recording, RecordingSession)
+{
+  nsJvdRecordingSettings settings;
+  settings.Reset();
+  settings.m_TargetFrameInterval = nsTime::MakeZero();
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Frame queue")
+  {
+    nsJvdFrameQueue queue;
+    queue.Initialize(3);
+
+    nsJvdFrame frame;
+    for (nsUInt64 i = 0; i < 3; ++i)
+    {
+      frame.m_uiFrameIndex = i;
+      NS_TEST_BOOL(queue.TryPush(frame));
+    }
+
+    frame.m_uiFrameIndex = 3;
+    NS_TEST_BOOL(!queue.TryPush(frame));
+    NS_TEST_INT(frame.m_uiFrameIndex, 3);
+    NS_TEST_INT(queue.GetCount(), 3);
+
+    NS_TEST_BOOL(queue.TryPop(frame));
+    NS_TEST_INT(frame.m_uiFrameIndex, 0);
+
+    // wraps around
+    frame.m_uiFrameIndex = 3;
+    NS_TEST_BOOL(queue.TryPush(frame));
+
+    for (nsUInt64 i = 1; i < 4; ++i)
+    {
+      NS_TEST_BOOL(queue.TryPop(frame));
+      NS_TEST_INT(frame.m_uiFrameIndex, i);
+    }
+
+    NS_TEST_BOOL(!queue.TryPop(frame));
+    NS_TEST_INT(queue.GetCount(), 0);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Shared clock")
+  {
+    const nsTime startTime = nsTime::MakeFromSeconds(100.0);
+
+    nsJvdRecordingSession session;
+    NS_TEST_BOOL(session.AddTrack("Early") == nullptr);
+
+    session.StartRecording(settings, startTime);
+    nsJvdRecordingTrack* pTrackA = session.AddTrack("A", 4);
+    nsJvdRecordingTrack* pTrackB = session.AddTrack("B", 4);
+    NS_TEST_INT(pTrackB->GetTrackIndex(), 1);
+
+    nsDynamicArray<nsJvdBodyState> states;
+    for (nsUInt32 f = 0; f < 10; ++f)
+    {
+      CaptureSessionFrame(*pTrackA, 0, f, startTime, states);
+      CaptureSessionFrame(*pTrackB, 1, f + 5, startTime, states);
+      session.Update();
+    }
+
+    // without updates the queue overflows
+    for (nsUInt32 f = 10; f < 20; ++f)
+    {
+      CaptureSessionFrame(*pTrackA, 0, f, startTime, states);
+    }
+
+    NS_TEST_INT(pTrackA->GetNumDroppedFrames(), 6);
+
+    nsDynamicArray<nsJvdClip> tracks;
+    NS_TEST_BOOL(session.StopRecording(tracks).Succeeded());
+    NS_TEST_INT(tracks.GetCount(), 2);
+    NS_TEST_STRING(tracks[0].GetMetadata().m_sClipName, "A");
+    NS_TEST_STRING(tracks[1].GetMetadata().m_sClipName, "B");
+    NS_TEST_INT(tracks[0].GetFrames().GetCount(), 14);
+    NS_TEST_INT(tracks[1].GetFrames().GetCount(), 10);
+
+    // timestamps are relative to the session start, not to the first frame of the track
+    NS_TEST_DOUBLE(tracks[0].GetFrames()[0].m_Timestamp.GetMilliseconds(), 0.0, 0.001);
+    NS_TEST_DOUBLE(tracks[1].GetFrames()[0].m_Timestamp.GetMilliseconds(), 51.0, 0.001);
+    NS_TEST_INT(tracks[1].GetFrames()[0].m_uiFrameIndex, 0);
+    NS_TEST_INT(tracks[1].GetFrames()[9].m_Bodies.GetCount(), 4);
+
+    // the frames keep their body index hints from the capture thread
+    for (const nsJvdBodyState& state : tracks[1].GetFrames()[9].m_Bodies)
+    {
+      NS_TEST_BOOL(tracks[1].GetBodyIndexMap().GetBodyId(state.m_uiBodyIndex) == state.m_uiBodyId);
+    }
+
+    // stopped tracks ignore further captures
+    CaptureSessionFrame(*pTrackA, 0, 30, startTime, states);
+    NS_TEST_INT(pTrackA->GetNumDroppedFrames(), 6);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Concurrent capture")
+  {
+    constexpr nsUInt32 uiTrackCount = 4;
+    constexpr nsUInt32 uiFrameCount = 500;
+
+    const nsTime startTime = nsTime::Now();
+
+    nsJvdRecordingSession session;
+    session.StartRecording(settings, startTime);
+
+    nsTaskGroupID group = nsTaskSystem::CreateTaskGroup(nsTaskPriority::LongRunning);
+    for (nsUInt32 t = 0; t < uiTrackCount; ++t)
+    {
+      nsStringBuilder sName;
+      sName.SetFormat("World {0}", t);
+      nsJvdRecordingTrack* pTrack = session.AddTrack(sName, 1024);
+
+      nsSharedPtr<nsTask> pTask = NS_DEFAULT_NEW(nsDelegateTask<void>, "JVD Session Test Capture", nsTaskNesting::Never, [pTrack, t, startTime]()
+        {
+          nsDynamicArray<nsJvdBodyState> states;
+          for (nsUInt32 f = 0; f < uiFrameCount; ++f)
+          {
+            CaptureSessionFrame(*pTrack, t, f, startTime, states);
+          }
+        });
+
+      nsTaskSystem::AddTaskToGroup(group, pTask);
+    }
+
+    nsTaskSystem::StartTaskGroup(group);
+
+    // the main thread drains the queues while the worlds are captured
+    while (!nsTaskSystem::IsTaskGroupFinished(group))
+    {
+      session.Update();
+      nsThreadUtils::YieldTimeSlice();
+    }
+
+    nsDynamicArray<nsJvdClip> tracks;
+    NS_TEST_BOOL(session.StopRecording(tracks).Succeeded());
+    NS_TEST_INT(tracks.GetCount(), uiTrackCount);
+
+    for (nsUInt32 t = 0; t < tracks.GetCount(); ++t)
+    {
+      const nsDynamicArray<nsJvdFrame>& frames = tracks[t].GetFrames();
+      NS_TEST_INT(frames.GetCount() + session.GetTrack(t)->GetNumDroppedFrames(), uiFrameCount);
+
+      bool bInOrder = true;
+      for (nsUInt32 i = 1; i < frames.GetCount(); ++i)
+      {
+        bInOrder = bInOrder && frames[i - 1].m_uiFrameIndex + 1 == frames[i].m_uiFrameIndex && frames[i - 1].m_Timestamp < frames[i].m_Timestamp;
+      }
+      NS_TEST_BOOL(bInOrder);
+
+      if (!frames.IsEmpty())
+      {
+        NS_TEST_INT(frames.PeekBack().m_Bodies.GetCount(), 3 + t);
+        NS_TEST_INT(frames.PeekBack().m_Bodies[0].m_uiBodyId, t * 100);
+      }
+    }
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Session file")
+  {
+    nsStringBuilder sWriteDir = nsTestFramework::GetInstance()->GetAbsOutputPath();
+    NS_TEST_BOOL(nsFileSystem::AddDataDirectory(sWriteDir, "RecordingSession", "output", nsDataDirUsage::AllowWrites) == NS_SUCCESS);
+
+    const nsTime startTime = nsTime::MakeFromSeconds(10.0);
+
+    nsJvdRecordingSession session;
+    session.StartRecording(settings, startTime);
+    nsJvdRecordingTrack* pTrackA = session.AddTrack("A", 512);
+    nsJvdRecordingTrack* pTrackB = session.AddTrack("B", 512);
+
+    nsDynamicArray<nsJvdBodyState> states;
+    for (nsUInt32 f = 0; f < 300; ++f)
+    {
+      CaptureSessionFrame(*pTrackA, 0, f, startTime, states);
+
+      // the second world runs at half the rate
+      if (f % 2 == 0)
+      {
+        CaptureSessionFrame(*pTrackB, 1, f, startTime, states);
+      }
+    }
+
+    NS_TEST_BOOL(session.StopRecording(":output/Session.jvdses").Succeeded());
+    NS_TEST_BOOL(nsJvdSerialization::IsSessionFile(":output/Session.jvdses"));
+
+    nsDynamicArray<nsJvdClip> tracks;
+    NS_TEST_BOOL(nsJvdSerialization::LoadSessionFromFile(":output/Session.jvdses", tracks).Succeeded());
+    NS_TEST_INT(tracks.GetCount(), 2);
+    NS_TEST_STRING(tracks[1].GetMetadata().m_sClipName, "B");
+    NS_TEST_INT(tracks[0].GetFrames().GetCount(), 300);
+    NS_TEST_INT(tracks[1].GetFrames().GetCount(), 150);
+    NS_TEST_BOOL(tracks[1].IsTimelineSummaryUpToDate());
+
+    const nsJvdFrame& frame = tracks[1].GetFrames()[100];
+    NS_TEST_DOUBLE(frame.m_Timestamp.GetMilliseconds(), 2001.0, 0.01);
+    NS_TEST_FLOAT(frame.m_Bodies[2].m_vPosition.x, 600.0f, 0.0f);
+
+    // a session is not a clip
+    {
+      nsTestLogInterface log;
+      nsTestLogSystemScope logSystemScope(&log);
+      log.ExpectMessage("is a recording session with several tracks", nsLogMsgType::ErrorMsg);
+
+      nsJvdClip clip;
+      NS_TEST_BOOL(nsJvdSerialization::LoadClipFromFile(":output/Session.jvdses", clip).Failed());
+    }
+
+    // a broken track count is rejected before anything is allocated for it
+    {
+      nsFileWriter file;
+      NS_TEST_BOOL(file.Open(":output/Session.jvdses").Succeeded());
+
+      const nsUInt8 magic[] = {'J', 'V', 'D', 'S', 'E', 'S'};
+      file.WriteBytes(magic, sizeof(magic)).AssertSuccess();
+      const nsUInt32 uiVersion = nsJvdSerialization::g_uiFormatVersion;
+      const nsUInt32 uiTrackCount = 0xFFFFFFF0u;
+      file.WriteDWordValue(&uiVersion).AssertSuccess();
+      file.WriteDWordValue(&uiTrackCount).AssertSuccess();
+      file.Close();
+
+      nsTestLogInterface log;
+      nsTestLogSystemScope logSystemScope(&log);
+      log.ExpectMessage("claims an invalid number of tracks", nsLogMsgType::ErrorMsg);
+
+      NS_TEST_BOOL(nsJvdSerialization::LoadSessionFromFile(":output/Session.jvdses", tracks).Failed());
+      NS_TEST_BOOL(tracks.IsEmpty());
+    }
+
+    nsFileSystem::DeleteFile(":output/Session.jvdses");
+    nsFileSystem::RemoveDataDirectoryGroup("RecordingSession");
+  }
+}
@@ -0,0 +1,195 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+#include <Foundation/IO/MemoryStream.h>
+
+namespace
+{
+  nsJvdFrame MakeSummaryFrame(nsUInt32 uiFrameIndex)
+  {
+    nsJvdFrame frame;
+    frame.m_uiFrameIndex = uiFrameIndex;
+    frame.m_Timestamp = nsTime::MakeFromSeconds(uiFrameIndex / 60.0);
+
+    // the number of awake bodies and the speed both follow the frame index, so ranges have predictable maxima
+    const nsUInt32 uiBodyCount = 1 + uiFrameIndex % 13;
+    for (nsUInt32 i = 0; i < uiBodyCount; ++i)
+    {
+      nsJvdBodyState& state = frame.m_Bodies.ExpandAndGetRef();
+      state.m_uiBodyId = 1 + i;
+      state.m_bIsSleeping = i == 0;
+      state.m_vLinearVelocity.Set(static_cast<float>(uiFrameIndex % 100), 0.0f, 0.0f);
+    }
+
+    return frame;
+  }
+
+  void CompareSummaries(const nsJvdTimelineSummary& expected, const nsJvdTimelineSummary& actual)
+  {
+    NS_TEST_INT(actual.GetFrameCount(), expected.GetFrameCount());
+    NS_TEST_INT(actual.GetBookmarkCount(), expected.GetBookmarkCount());
+    NS_TEST_INT(actual.GetLevelCount(), expected.GetLevelCount());
+
+    for (nsUInt32 uiLevel = 0; uiLevel < nsMath::Min(actual.GetLevelCount(), expected.GetLevelCount()); ++uiLevel)
+    {
+      nsArrayPtr<const nsJvdTimelineBucket> a = actual.GetLevel(uiLevel);
+      nsArrayPtr<const nsJvdTimelineBucket> e = expected.GetLevel(uiLevel);
+      NS_TEST_INT(a.GetCount(), e.GetCount());
+
+      for (nsUInt32 i = 0; i < nsMath::Min(a.GetCount(), e.GetCount()); ++i)
+      {
+        NS_TEST_INT(a[i].m_uiMaxActiveBodies, e[i].m_uiMaxActiveBodies);
+        NS_TEST_INT(a[i].m_uiAnomalyMask, e[i].m_uiAnomalyMask);
+        NS_TEST_FLOAT(a[i].m_fMaxLinearSpeed, e[i].m_fMaxLinearSpeed, 0.0f);
+        NS_TEST_FLOAT(a[i].m_fMaxKineticEnergy, e[i].m_fMaxKineticEnergy, 0.0f);
+        NS_TEST_BOOL(a[i].m_Bounds == e[i].m_Bounds);
+      }
+    }
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Recording, TimelineSummary)
+{
+  nsJvdClip clip;
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Incremental")
+  {
+    for (nsUInt32 f = 0; f < 1000; ++f)
+    {
+      clip.AddFrame(MakeSummaryFrame(f));
+
+      if (f == 500)
+      {
+        nsJvdBookmark bookmark;
+        bookmark.m_uiFrameIndex = 500;
+        bookmark.m_Kind = nsJvdBookmarkKind::VelocitySpike;
+        clip.AddBookmark(bookmark);
+
+        bookmark.m_uiFrameIndex = 77;
+        bookmark.m_Kind = nsJvdBookmarkKind::Teleport;
+        clip.AddBookmark(bookmark);
+
+        // no such frame, only counted
+        bookmark.m_uiFrameIndex = 5000;
+        clip.AddBookmark(bookmark);
+      }
+    }
+
+    NS_TEST_BOOL(clip.IsTimelineSummaryUpToDate());
+
+    const nsJvdTimelineSummary& summary = clip.GetTimelineSummary();
+    NS_TEST_INT(summary.GetFrameCount(), 1000);
+    NS_TEST_INT(summary.GetBookmarkCount(), 3);
+    NS_TEST_INT(summary.GetLevelCount(), 11);
+    NS_TEST_INT(summary.GetLevel(10).GetCount(), 1);
+
+    nsJvdTimelineSummary rebuilt;
+    rebuilt.Build(clip.GetFrames(), clip.GetBookmarks());
+    CompareSummaries(rebuilt, summary);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Query")
+  {
+    const nsJvdTimelineSummary& summary = clip.GetTimelineSummary();
+
+    nsJvdTimelineBucket bucket = summary.Query(0, 1000);
+    NS_TEST_INT(bucket.m_uiMaxActiveBodies, 12);
+    NS_TEST_FLOAT(bucket.m_fMaxLinearSpeed, 99.0f, 0.0f);
+    NS_TEST_INT(bucket.m_uiAnomalyMask, (1u << nsJvdBookmarkKind::VelocitySpike) | (1u << nsJvdBookmarkKind::Teleport));
+
+    bucket = summary.Query(501, 1);
+    NS_TEST_INT(bucket.m_uiMaxActiveBodies, 501 % 13);
+    NS_TEST_FLOAT(bucket.m_fMaxLinearSpeed, 1.0f, 0.0f);
+    NS_TEST_FLOAT(bucket.m_fMaxKineticEnergy, 0.5f * (501 % 13 + 1), 0.0001f);
+    NS_TEST_INT(bucket.m_uiAnomalyMask, 0);
+
+    NS_TEST_INT(summary.Query(500, 1).m_uiAnomalyMask, 1u << nsJvdBookmarkKind::VelocitySpike);
+
+    // clamped to the end of the clip
+    bucket = summary.Query(990, 100);
+    NS_TEST_FLOAT(bucket.m_fMaxLinearSpeed, 99.0f, 0.0f);
+    NS_TEST_INT(summary.Query(1000, 10).m_uiMaxActiveBodies, 0);
+
+    nsJvdTimelineBucket samples[10];
+    summary.Sample(0, 1000, samples);
+    NS_TEST_INT(samples[0].m_uiAnomalyMask, 1u << nsJvdBookmarkKind::Teleport);
+    NS_TEST_INT(samples[5].m_uiAnomalyMask, 1u << nsJvdBookmarkKind::VelocitySpike);
+    NS_TEST_INT(samples[9].m_uiAnomalyMask, 0);
+    NS_TEST_FLOAT(samples[9].m_fMaxLinearSpeed, 99.0f, 0.0f);
+
+    // more samples than frames
+    nsJvdTimelineBucket fine[8];
+    summary.Sample(501, 2, fine);
+    NS_TEST_FLOAT(fine[0].m_fMaxLinearSpeed, 1.0f, 0.0f);
+    NS_TEST_FLOAT(fine[7].m_fMaxLinearSpeed, 2.0f, 0.0f);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Bounds")
+  {
+    nsJvdClip moving;
+    for (nsUInt32 f = 0; f < 100; ++f)
+    {
+      nsJvdFrame frame = MakeSummaryFrame(f);
+      frame.m_Bodies.SetCount(1);
+      frame.m_Bodies[0].m_vPosition.Set(static_cast<float>(f), 0.0f, 0.0f);
+      frame.m_Bodies[0].m_vScale.Set(2.0f, 4.0f, -6.0f);
+      moving.AddFrame(std::move(frame));
+    }
+
+    const nsJvdTimelineSummary& summary = moving.GetTimelineSummary();
+
+    nsBoundingBox bounds = summary.Query(10, 1).m_Bounds;
+    NS_TEST_VEC3(bounds.m_vMin, nsVec3(9.0f, -2.0f, -3.0f), 0.0f);
+    NS_TEST_VEC3(bounds.m_vMax, nsVec3(11.0f, 2.0f, 3.0f), 0.0f);
+
+    bounds = summary.Query(0, 100).m_Bounds;
+    NS_TEST_VEC3(bounds.m_vMin, nsVec3(-1.0f, -2.0f, -3.0f), 0.0f);
+    NS_TEST_VEC3(bounds.m_vMax, nsVec3(100.0f, 2.0f, 3.0f), 0.0f);
+
+    // broken bodies and empty frames do not contribute
+    nsJvdFrame frame;
+    NS_TEST_BOOL(!nsJvdTimelineBucket::MakeFromFrame(frame).m_Bounds.IsValid());
+
+    frame.m_Bodies.ExpandAndGetRef().m_vPosition.Set(nsMath::Infinity<float>(), 0.0f, 0.0f);
+    frame.m_Bodies.ExpandAndGetRef().m_vPosition.Set(1.0f, 2.0f, 3.0f);
+    bounds = nsJvdTimelineBucket::MakeFromFrame(frame).m_Bounds;
+    NS_TEST_BOOL(bounds.IsValid());
+    NS_TEST_VEC3(bounds.GetCenter(), nsVec3(1.0f, 2.0f, 3.0f), 0.0f);
+
+    nsJvdTimelineBucket merged = nsJvdTimelineBucket::MakeFromFrame(nsJvdFrame());
+    merged.Merge(nsJvdTimelineBucket::MakeFromFrame(frame));
+    NS_TEST_BOOL(merged.m_Bounds == bounds);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Out of sync")
+  {
+    nsJvdClip copy = clip;
+    NS_TEST_BOOL(copy.IsTimelineSummaryUpToDate());
+
+    copy.GetFrames().PopBack();
+    NS_TEST_BOOL(!copy.IsTimelineSummaryUpToDate());
+
+    copy.UpdateTimelineSummary();
+    NS_TEST_BOOL(copy.IsTimelineSummaryUpToDate());
+    NS_TEST_INT(copy.GetTimelineSummary().GetFrameCount(), 999);
+
+    copy.AddFrame(MakeSummaryFrame(1000));
+    NS_TEST_BOOL(copy.IsTimelineSummaryUpToDate());
+    NS_TEST_FLOAT(copy.GetTimelineSummary().Query(999, 1).m_fMaxLinearSpeed, 0.0f, 0.0f);
+
+    copy.AddFrame(MakeSummaryFrame(1001), false);
+    NS_TEST_BOOL(!copy.IsTimelineSummaryUpToDate());
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Built on load")
+  {
+    nsDefaultMemoryStreamStorage storage;
+    nsMemoryStreamWriter writer(&storage);
+    NS_TEST_BOOL(nsJvdSerialization::WriteClip(writer, clip).Succeeded());
+
+    nsMemoryStreamReader reader(&storage);
+    nsJvdClip loaded;
+    NS_TEST_BOOL(nsJvdSerialization::ReadClip(reader, loaded).Succeeded());
+    NS_TEST_BOOL(loaded.IsTimelineSummaryUpToDate());
+    CompareSummaries(clip.GetTimelineSummary(), loaded.GetTimelineSummary());
+  }
+}
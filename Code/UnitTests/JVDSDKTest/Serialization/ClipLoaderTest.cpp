@@ -0,0 +1,121 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+#include <Foundation/IO/FileSystem/FileSystem.h>
+#include <Foundation/Utilities/Progress.h>
+#include <JVDSDKTest/Serialization/ClipTestHelpers.h>
+#include <TestFramework/Utilities/TestLogInterface.h>
+
+NS_CREATE_SIMPLE_TEST(Serialization, ClipLoader)
+{
+  const nsJvdClip clip = MakeSerializationTestClip(200, 12);
+
+  nsStringBuilder sWriteDir = nsTestFramework::GetInstance()->GetAbsOutputPath();
+  NS_TEST_BOOL(nsFileSystem::AddDataDirectory(sWriteDir, "ClipLoader", "output", nsDataDirUsage::AllowWrites) == NS_SUCCESS);
+
+  nsJvdClipWriteSettings settings;
+  settings.m_Compression = nsJvdCompression::Zstd;
+  settings.m_uiFramesPerBlock = 9;
+  NS_TEST_BOOL(nsJvdSerialization::SaveClipToFile(":output/Loader.jvdrec", clip, settings).Succeeded());
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Wait")
+  {
+    nsJvdClip expected;
+    NS_TEST_BOOL(nsJvdSerialization::LoadClipFromFile(":output/Loader.jvdrec", expected).Succeeded());
+
+    nsJvdClipLoader loader;
+    NS_TEST_INT(loader.GetState(), nsJvdClipLoadState::Idle);
+    NS_TEST_BOOL(loader.Start(":output/Loader.jvdrec").Succeeded());
+    NS_TEST_BOOL(loader.IsLoading());
+
+    nsJvdClip loaded;
+    NS_TEST_BOOL(loader.Wait(loaded).Succeeded());
+    NS_TEST_INT(loader.GetState(), nsJvdClipLoadState::Succeeded);
+    NS_TEST_BOOL(SerializedClipMatches(expected, loaded));
+    NS_TEST_BOOL(loaded.IsTimelineSummaryUpToDate());
+
+    // the loader can be reused
+    NS_TEST_BOOL(loader.Start(":output/Loader.jvdrec").Succeeded());
+    NS_TEST_BOOL(loader.Wait(loaded).Succeeded());
+    NS_TEST_BOOL(SerializedClipMatches(expected, loaded));
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Update and progress")
+  {
+    nsProgress progress;
+    nsUInt32 uiStarted = 0;
+    nsUInt32 uiEnded = 0;
+    progress.m_Events.AddEventHandler([&](const nsProgressEvent& e)
+      {
+        uiStarted += e.m_Type == nsProgressEvent::Type::ProgressStarted ? 1 : 0;
+        uiEnded += e.m_Type == nsProgressEvent::Type::ProgressEnded ? 1 : 0; });
+
+    nsJvdClipLoader loader;
+    NS_TEST_BOOL(loader.Start(":output/Loader.jvdrec", &progress).Succeeded());
+    NS_TEST_INT(uiStarted, 1);
+
+    nsJvdClip loaded;
+    nsUInt32 uiUpdates = 0;
+    nsUInt32 uiFramesAdded = 0;
+    bool bInOrder = true;
+    while (loader.IsLoading())
+    {
+      const nsUInt32 uiNewFrames = loader.Update(loaded);
+      ++uiUpdates;
+
+      // every update hands out whole blocks at the end of what is already there
+      bInOrder = bInOrder && loaded.GetFrames().GetCount() == uiFramesAdded + uiNewFrames;
+      for (nsUInt32 f = uiFramesAdded; f < loaded.GetFrames().GetCount(); ++f)
+      {
+        bInOrder = bInOrder && loaded.GetFrames()[f].m_uiFrameIndex == f;
+      }
+      uiFramesAdded += uiNewFrames;
+
+      nsThreadUtils::YieldTimeSlice();
+    }
+
+    NS_TEST_BOOL(bInOrder);
+    NS_TEST_BOOL(uiUpdates > 0);
+    NS_TEST_INT(loader.GetState(), nsJvdClipLoadState::Succeeded);
+    NS_TEST_INT(uiFramesAdded, 200);
+    NS_TEST_BOOL(SerializedClipMatches(clip, loaded));
+    NS_TEST_INT(uiEnded, 1);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Cancel")
+  {
+    nsProgress progress;
+
+    nsJvdClipLoader loader;
+    NS_TEST_BOOL(loader.Start(":output/Loader.jvdrec", &progress).Succeeded());
+    progress.UserClickedCancel();
+
+    nsJvdClip loaded;
+    NS_TEST_BOOL(loader.Wait(loaded).Failed());
+    NS_TEST_INT(loader.GetState(), nsJvdClipLoadState::Canceled);
+    NS_TEST_INT(loaded.GetFrames().GetCount(), 0);
+
+    // destroying a running loader cancels it
+    nsJvdClipLoader abandoned;
+    NS_TEST_BOOL(abandoned.Start(":output/Loader.jvdrec").Succeeded());
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Errors")
+  {
+    const nsJvdClip tracks[] = {MakeSerializationTestClip(10, 2)};
+    NS_TEST_BOOL(nsJvdSerialization::SaveSessionToFile(":output/Loader.jvdses", tracks).Succeeded());
+
+    nsTestLogInterface log;
+    nsTestLogSystemScope logSystemScope(&log);
+    log.ExpectMessage("is a recording session with several tracks", nsLogMsgType::ErrorMsg);
+    log.ExpectMessage("Failed to open ':output/Missing.jvdrec'", nsLogMsgType::ErrorMsg);
+
+    nsJvdClipLoader loader;
+    NS_TEST_BOOL(loader.Start(":output/Loader.jvdses").Failed());
+    NS_TEST_BOOL(loader.Start(":output/Missing.jvdrec").Failed());
+    NS_TEST_INT(loader.GetState(), nsJvdClipLoadState::Idle);
+  }
+
+  nsFileSystem::DeleteFile(":output/Loader.jvdrec");
+  nsFileSystem::DeleteFile(":output/Loader.jvdses");
+  nsFileSystem::RemoveDataDirectoryGroup("ClipLoader");
+}
@@ -0,0 +1,211 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+#include <Foundation/IO/FileSystem/FileSystem.h>
+#include <Foundation/IO/OSFile.h>
+
+namespace
+{
+  /// Body 1 is thrown and spins, body 2 sleeps from frame 100 to 399, body 3 disappears between frame 200 and 299 and
+  /// teleports in frame 450, body 4 jitters.
+  nsJvdClip MakeSimplificationClip()
+  {
+    nsJvdClip clip;
+
+    const nsVec3 vGravity(0.0f, -9.81f, 0.0f);
+
+    for (nsUInt32 f = 0; f < 600; ++f)
+    {
+      const float t = f / 60.0f;
+
+      nsJvdFrame frame;
+      frame.m_uiFrameIndex = 1000 + f;
+      frame.m_Timestamp = nsTime::MakeFromSeconds(f / 60.0);
+
+      {
+        nsJvdBodyState& state = frame.m_Bodies.ExpandAndGetRef();
+        state.m_uiBodyId = 1;
+        state.m_vPosition = nsVec3(0.0f, 2.0f, 0.0f) + nsVec3(3.0f, 10.0f, 1.0f) * t + vGravity * (0.5f * t * t);
+        state.m_vLinearVelocity = nsVec3(3.0f, 10.0f, 1.0f) + vGravity * t;
+        state.m_qRotation = nsQuat::MakeFromAxisAndAngle(nsVec3(0, 1, 0), nsAngle::MakeFromRadian(2.0f * t));
+        state.m_vAngularVelocity.Set(0.0f, 2.0f, 0.0f);
+      }
+
+      {
+        const nsUInt32 uiMoving = f < 100 ? f : (f < 400 ? 100 : f - 300);
+
+        nsJvdBodyState& state = frame.m_Bodies.ExpandAndGetRef();
+        state.m_uiBodyId = 2;
+        state.m_vPosition.Set(uiMoving * 0.05f, 0.0f, 5.0f);
+        state.m_vLinearVelocity.Set(f >= 100 && f < 400 ? 0.0f : 3.0f, 0.0f, 0.0f);
+        state.m_bIsSleeping = f >= 100 && f < 400;
+        state.m_fFriction = f < 300 ? 0.5f : 0.8f;
+      }
+
+      if (f < 200 || f >= 300)
+      {
+        nsJvdBodyState& state = frame.m_Bodies.ExpandAndGetRef();
+        state.m_uiBodyId = 3;
+        state.m_vPosition.Set(-5.0f, f < 450 ? 1.0f : 20.0f, 0.0f);
+        state.m_bWasTeleported = f == 450;
+        state.m_vScale.Set(2.0f);
+      }
+
+      {
+        nsJvdBodyState& state = frame.m_Bodies.ExpandAndGetRef();
+        state.m_uiBodyId = 4;
+        state.m_vPosition.Set(nsMath::Sin(nsAngle::MakeFromRadian(f * 1.3f)) * 0.01f, 1.0f, nsMath::Cos(nsAngle::MakeFromRadian(f * 0.7f)) * 0.01f);
+        state.m_qRotation = nsQuat::MakeFromAxisAndAngle(nsVec3(1, 0, 0), nsAngle::MakeFromRadian(nsMath::Sin(nsAngle::MakeFromRadian(f * 0.9f)) * 0.01f));
+      }
+
+      clip.AddFrame(std::move(frame));
+    }
+
+    return clip;
+  }
+
+  void TestWithinTolerance(const nsJvdClip& original, const nsJvdClip& reconstructed, const nsJvdSimplificationSettings& settings)
+  {
+    // the reconstruction is converted to float and normalized
+    const float fEpsilon = 1e-5f;
+
+    NS_TEST_INT(reconstructed.GetFrames().GetCount(), original.GetFrames().GetCount());
+
+    float fMaxPositionError = 0.0f;
+    float fMaxRotationError = 0.0f;
+    float fMaxVelocityError = 0.0f;
+
+    for (nsUInt32 f = 0; f < nsMath::Min(original.GetFrames().GetCount(), reconstructed.GetFrames().GetCount()); ++f)
+    {
+      const nsJvdFrame& expected = original.GetFrames()[f];
+      const nsJvdFrame& actual = reconstructed.GetFrames()[f];
+      NS_TEST_INT(actual.m_uiFrameIndex, expected.m_uiFrameIndex);
+      NS_TEST_INT(actual.m_Bodies.GetCount(), expected.m_Bodies.GetCount());
+
+      for (const nsJvdBodyState& state : expected.m_Bodies)
+      {
+        const nsJvdBodyState* pState = actual.FindBody(state.m_uiBodyId);
+        if (!NS_TEST_BOOL(pState != nullptr))
+          continue;
+
+        fMaxPositionError = nsMath::Max(fMaxPositionError, (pState->m_vPosition - state.m_vPosition).GetLength());
+        fMaxRotationError = nsMath::Max(fMaxRotationError, 2.0f * nsMath::ACos(nsMath::Min(nsMath::Abs(pState->m_qRotation.Dot(state.m_qRotation)), 1.0f)).GetRadian());
+        fMaxVelocityError = nsMath::Max(fMaxVelocityError, (pState->m_vLinearVelocity - state.m_vLinearVelocity).GetLength());
+        fMaxVelocityError = nsMath::Max(fMaxVelocityError, (pState->m_vAngularVelocity - state.m_vAngularVelocity).GetLength());
+
+        NS_TEST_BOOL(pState->m_bIsSleeping == state.m_bIsSleeping);
+        NS_TEST_BOOL(pState->m_bWasTeleported == state.m_bWasTeleported);
+        NS_TEST_BOOL(pState->m_vScale == state.m_vScale);
+        NS_TEST_FLOAT(pState->m_fFriction, state.m_fFriction, 0.0f);
+      }
+    }
+
+    NS_TEST_BOOL(fMaxPositionError <= settings.m_fPositionTolerance + fEpsilon);
+    // acos is imprecise close to 1
+    NS_TEST_BOOL(fMaxRotationError <= settings.m_fRotationTolerance + 1e-3f);
+    NS_TEST_BOOL(fMaxVelocityError <= nsMath::Max(settings.m_fLinearVelocityTolerance, settings.m_fAngularVelocityTolerance) + fEpsilon);
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Serialization, ClipSimplification)
+{
+  const nsJvdClip clip = MakeSimplificationClip();
+
+  nsJvdSimplificationSettings settings;
+  settings.m_fPositionTolerance = 0.005f;
+  settings.m_fRotationTolerance = 0.01f;
+
+  nsJvdSimplifiedClip simplified;
+  simplified.Simplify(clip, settings);
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Curves")
+  {
+    NS_TEST_INT(simplified.GetFrameCount(), 600);
+    NS_TEST_INT(simplified.GetSampleCount(), 600 * 4 - 100);
+    NS_TEST_INT(simplified.GetBodies().GetCount(), 4);
+
+    // the recorded velocities make the ballistic path a few Hermite segments
+    const nsJvdSimplifiedBody& thrown = simplified.GetBodies()[0];
+    NS_TEST_BOOL(thrown.m_Position[0].GetNumControlPoints() <= 5);
+    NS_TEST_BOOL(thrown.m_LinearVelocity[0].GetNumControlPoints() <= 5);
+    NS_TEST_BOOL(thrown.m_Rotation[0].GetNumControlPoints() < 30);
+
+    // one constant segment while asleep
+    const nsJvdSimplifiedBody& sleeper = simplified.GetBodies()[1];
+    NS_TEST_INT(sleeper.m_Sleeping.GetCount(), 1);
+    NS_TEST_INT(sleeper.m_Sleeping[0].m_uiFirstFrame, 100);
+    NS_TEST_INT(sleeper.m_Sleeping[0].m_uiLastFrame, 399);
+    NS_TEST_INT(sleeper.m_PropertyChanges.GetCount(), 2);
+    for (nsUInt32 i = 0; i < sleeper.m_Position[0].GetNumControlPoints(); ++i)
+    {
+      const double x = sleeper.m_Position[0].GetControlPoint(i).m_Position.x;
+      NS_TEST_BOOL(x <= 100.0 || x >= 399.0);
+    }
+
+    const nsJvdSimplifiedBody& teleporter = simplified.GetBodies()[2];
+    NS_TEST_INT(teleporter.m_Present.GetCount(), 2);
+    NS_TEST_INT(teleporter.m_Present[0].m_uiLastFrame, 199);
+    NS_TEST_INT(teleporter.m_Present[1].m_uiFirstFrame, 300);
+    NS_TEST_BOOL(!teleporter.IsPresent(250));
+    NS_TEST_INT(teleporter.m_Teleported.GetCount(), 1);
+
+    NS_TEST_BOOL(simplified.GetKeyCount() * 4 < simplified.GetSampleCount());
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Reconstruct")
+  {
+    nsJvdClip reconstructed;
+    simplified.Reconstruct(reconstructed);
+    TestWithinTolerance(clip, reconstructed, settings);
+
+    NS_TEST_BOOL(reconstructed.IsTimelineSummaryUpToDate());
+
+    // exact when nothing may be dropped
+    nsJvdSimplificationSettings exact;
+    exact.m_fPositionTolerance = 0.0f;
+    exact.m_fRotationTolerance = 0.0f;
+    exact.m_fLinearVelocityTolerance = 0.0f;
+    exact.m_fAngularVelocityTolerance = 0.0f;
+
+    nsJvdSimplifiedClip lossless;
+    lossless.Simplify(clip, exact);
+
+    nsJvdFrame frame;
+    lossless.ReconstructFrame(123, frame);
+    NS_TEST_BOOL(frame.FindBody(1)->m_vPosition == clip.GetFrames()[123].FindBody(1)->m_vPosition);
+    NS_TEST_BOOL(frame.FindBody(4)->m_vPosition == clip.GetFrames()[123].FindBody(4)->m_vPosition);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "File")
+  {
+    nsStringBuilder sWriteDir = nsTestFramework::GetInstance()->GetAbsOutputPath();
+    NS_TEST_BOOL(nsFileSystem::AddDataDirectory(sWriteDir, "ClipSimplification", "output", nsDataDirUsage::AllowWrites) == NS_SUCCESS);
+
+    nsJvdClipWriteSettings uncompressed;
+    uncompressed.m_Compression = nsJvdCompression::None;
+    NS_TEST_BOOL(nsJvdSerialization::SaveClipToFile(":output/Dense.jvdrec", clip, uncompressed).Succeeded());
+    NS_TEST_BOOL(simplified.SaveToFile(":output/Simplified.jvdsim").Succeeded());
+
+    NS_TEST_BOOL(nsJvdSimplifiedClip::IsSimplifiedClipFile(":output/Simplified.jvdsim"));
+    NS_TEST_BOOL(!nsJvdSimplifiedClip::IsSimplifiedClipFile(":output/Dense.jvdrec"));
+
+    nsStringBuilder sDense, sSimplified;
+    NS_TEST_BOOL(nsFileSystem::ResolvePath(":output/Dense.jvdrec", &sDense, nullptr).Succeeded());
+    NS_TEST_BOOL(nsFileSystem::ResolvePath(":output/Simplified.jvdsim", &sSimplified, nullptr).Succeeded());
+
+    nsFileStats denseStats, simplifiedStats;
+    NS_TEST_BOOL(nsOSFile::GetFileStats(sDense, denseStats).Succeeded());
+    NS_TEST_BOOL(nsOSFile::GetFileStats(sSimplified, simplifiedStats).Succeeded());
+    // most of it is the jittering body, which can't be simplified much
+    NS_TEST_BOOL(simplifiedStats.m_uiFileSize * 2 < denseStats.m_uiFileSize);
+
+    // the player loads simplified clips like recordings
+    nsJvdClip loaded;
+    NS_TEST_BOOL(nsJvdSerialization::LoadClipFromFile(":output/Simplified.jvdsim", loaded).Succeeded());
+    TestWithinTolerance(clip, loaded, settings);
+    NS_TEST_DOUBLE(loaded.GetFrames()[10].m_Timestamp.GetSeconds(), clip.GetFrames()[10].m_Timestamp.GetSeconds(), 0.000001);
+
+    nsFileSystem::DeleteFile(":output/Dense.jvdrec");
+    nsFileSystem::DeleteFile(":output/Simplified.jvdsim");
+    nsFileSystem::RemoveDataDirectoryGroup("ClipSimplification");
+  }
+}
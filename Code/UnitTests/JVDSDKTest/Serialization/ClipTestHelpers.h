@@ -0,0 +1,60 @@
+#pragma once
+
+#include <JVDSDK/Recording/JvdRecordingTypes.h>
+
+/// A clip with one bookmark in which bodies come and go, so the per-block body tables differ.
+inline nsJvdClip MakeSerializationTestClip(nsUInt32 uiFrameCount, nsUInt32 uiBodyCount)
+{
+  nsJvdClip clip;
+
+  nsJvdClipMetadata metadata;
+  metadata.m_sClipName = "Serialization";
+  clip.SetMetadata(metadata);
+
+  nsJvdBookmark bookmark;
+  bookmark.m_uiFrameIndex = uiFrameCount / 3;
+  bookmark.m_Kind = nsJvdBookmarkKind::Teleport;
+  clip.AddBookmark(bookmark);
+
+  for (nsUInt32 f = 0; f < uiFrameCount; ++f)
+  {
+    nsJvdFrame frame;
+    frame.m_uiFrameIndex = f;
+    frame.m_Timestamp = nsTime::MakeFromSeconds(f / 60.0);
+
+    for (nsUInt32 i = f % 5; i < uiBodyCount; ++i)
+    {
+      nsJvdBodyState& state = frame.m_Bodies.ExpandAndGetRef();
+      state.m_uiBodyId = 100 + i;
+      state.m_vPosition.Set(static_cast<float>(i), f * 0.1f, 1.0f);
+      state.m_bIsSleeping = (i % 4) == 0;
+    }
+
+    clip.AddFrame(std::move(frame));
+  }
+
+  return clip;
+}
+
+/// Whether a clip that went through serialization still holds the same metadata, frames and bodies.
+inline bool SerializedClipMatches(const nsJvdClip& expected, const nsJvdClip& actual)
+{
+  if (actual.GetMetadata().m_sClipName != expected.GetMetadata().m_sClipName || actual.GetBookmarks().GetCount() != expected.GetBookmarks().GetCount() || actual.GetFrames().GetCount() != expected.GetFrames().GetCount())
+    return false;
+
+  for (nsUInt32 f = 0; f < actual.GetFrames().GetCount(); ++f)
+  {
+    const nsJvdFrame& a = actual.GetFrames()[f];
+    const nsJvdFrame& e = expected.GetFrames()[f];
+    if (a.m_uiFrameIndex != e.m_uiFrameIndex || a.m_Bodies.GetCount() != e.m_Bodies.GetCount())
+      return false;
+
+    for (nsUInt32 i = 0; i < a.m_Bodies.GetCount(); ++i)
+    {
+      if (a.m_Bodies[i].m_uiBodyId != e.m_Bodies[i].m_uiBodyId || a.m_Bodies[i].m_vPosition != e.m_Bodies[i].m_vPosition || a.m_Bodies[i].m_bIsSleeping != e.m_Bodies[i].m_bIsSleeping)
+        return false;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,124 @@
+#include <JVDSDKTest/JVDSDKTestPCH.h>
+
+#include <Foundation/IO/FileSystem/FileSystem.h>
+#include <Foundation/IO/MemoryStream.h>
+#include <JVDSDKTest/Serialization/ClipTestHelpers.h>
+#include <TestFramework/Utilities/TestLogInterface.h>
+
+NS_CREATE_SIMPLE_TEST_GROUP(Serialization);
+
+NS_CREATE_SIMPLE_TEST(Serialization, ClipWriter)
+{
+  const nsJvdClip clip = MakeSerializationTestClip(150, 20);
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Compressed blocks")
+  {
+    nsUInt64 uiUncompressedSize = 0;
+
+    for (nsUInt32 c = 0; c < 2; ++c)
+    {
+      nsJvdClipWriteSettings settings;
+      settings.m_Compression = c == 0 ? nsJvdCompression::None : nsJvdCompression::Zstd;
+      settings.m_uiFramesPerBlock = 32;
+
+      nsDefaultMemoryStreamStorage storage;
+      nsMemoryStreamWriter writer(&storage);
+      NS_TEST_BOOL(nsJvdSerialization::WriteClip(writer, clip, settings).Succeeded());
+
+      if (c == 0)
+      {
+        uiUncompressedSize = storage.GetStorageSize64();
+      }
+      else
+      {
+        NS_TEST_BOOL(storage.GetStorageSize64() < uiUncompressedSize / 2);
+      }
+
+      nsMemoryStreamReader reader(&storage);
+      nsJvdClip loaded;
+      NS_TEST_BOOL(nsJvdSerialization::ReadClip(reader, loaded).Succeeded());
+      NS_TEST_BOOL(SerializedClipMatches(clip, loaded));
+    }
+  }
+
+  nsStringBuilder sWriteDir = nsTestFramework::GetInstance()->GetAbsOutputPath();
+  NS_TEST_BOOL(nsFileSystem::AddDataDirectory(sWriteDir, "ClipWriter", "output", nsDataDirUsage::AllowWrites) == NS_SUCCESS);
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Streaming")
+  {
+    nsJvdClipWriteSettings settings;
+    settings.m_uiFramesPerBlock = 7;
+    settings.m_uiMaxBlocksInFlight = 2;
+
+    {
+      nsJvdClipWriter writer;
+      NS_TEST_BOOL(writer.Open(":output/Streamed.jvdrec", clip.GetMetadata(), clip.GetBodyMetadata(), clip.GetBookmarks(), settings).Succeeded());
+
+      for (const nsJvdFrame& frame : clip.GetFrames())
+      {
+        NS_TEST_BOOL(writer.WriteFrame(frame).Succeeded());
+      }
+
+      NS_TEST_INT(writer.GetNumFramesWritten(), 150);
+      NS_TEST_BOOL(writer.Close().Succeeded());
+    }
+
+    nsJvdClipReader reader;
+    NS_TEST_BOOL(reader.Open(":output/Streamed.jvdrec").Succeeded());
+    NS_TEST_INT(reader.GetVersion(), nsJvdSerialization::g_uiFormatVersion);
+    NS_TEST_BOOL(reader.GetFrameCount() == nsJvdSerialization::g_uiUnknownFrameCount);
+    NS_TEST_INT(reader.GetBookmarks().GetCount(), 1);
+
+    nsJvdFrame frame;
+    nsUInt32 uiFrames = 0;
+    while (reader.HasMoreFrames())
+    {
+      NS_TEST_BOOL(reader.ReadNextFrame(frame).Succeeded());
+      NS_TEST_INT(frame.m_uiFrameIndex, uiFrames);
+      ++uiFrames;
+    }
+
+    NS_TEST_INT(uiFrames, 150);
+    NS_TEST_BOOL(reader.ReadNextFrame(frame).Failed());
+    NS_TEST_BOOL(reader.GetNumUncompressedBytesRead() > 0);
+    reader.Close();
+
+    nsJvdClip loaded;
+    NS_TEST_BOOL(nsJvdSerialization::LoadClipFromFile(":output/Streamed.jvdrec", loaded).Succeeded());
+    NS_TEST_BOOL(SerializedClipMatches(clip, loaded));
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Frame count")
+  {
+    NS_TEST_BOOL(nsJvdSerialization::SaveClipToFile(":output/Counted.jvdrec", clip).Succeeded());
+
+    nsJvdClipReader reader;
+    NS_TEST_BOOL(reader.Open(":output/Counted.jvdrec").Succeeded());
+    NS_TEST_INT(reader.GetFrameCount(), 150);
+    reader.Close();
+
+    nsJvdClip empty;
+    NS_TEST_BOOL(nsJvdSerialization::SaveClipToFile(":output/Empty.jvdrec", empty).Succeeded());
+    NS_TEST_BOOL(reader.Open(":output/Empty.jvdrec").Succeeded());
+    NS_TEST_BOOL(!reader.HasMoreFrames());
+    reader.Close();
+
+    nsTestLogInterface log;
+    nsTestLogSystemScope logSystemScope(&log);
+    log.ExpectMessage("announced 10 frames but 3 were written", nsLogMsgType::ErrorMsg);
+
+    nsJvdClipWriter writer;
+    NS_TEST_BOOL(writer.Open(":output/Short.jvdrec", clip.GetMetadata(), {}, {}, nsJvdClipWriteSettings(), 10).Succeeded());
+    for (nsUInt32 f = 0; f < 3; ++f)
+    {
+      NS_TEST_BOOL(writer.WriteFrame(clip.GetFrames()[f]).Succeeded());
+    }
+    NS_TEST_BOOL(writer.Close().Failed());
+  }
+
+  nsFileSystem::DeleteFile(":output/Streamed.jvdrec");
+  nsFileSystem::DeleteFile(":output/Counted.jvdrec");
+  nsFileSystem::DeleteFile(":output/Empty.jvdrec");
+  nsFileSystem::DeleteFile(":output/Short.jvdrec");
+  nsFileSystem::RemoveDataDirectoryGroup("ClipWriter");
+}
@@ -0,0 +1,426 @@
+#include <VulkanRenderer/VulkanRendererPCH.h>
+#include <VulkanRenderer/Core/VkShaderCache.h>
+#include <VulkanRenderer/DxcSupport.h>
+
+#include <Foundation/Algorithm/HashingUtils.h>
+#include <Foundation/Containers/HybridArray.h>
+#include <Foundation/IO/FileSystem/FileReader.h>
+#include <Foundation/IO/OSFile.h>
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Memory/MemoryUtils.h>
+#include <Foundation/Strings/StringBuilder.h>
+#include <Foundation/Strings/StringConversion.h>
+#include <Foundation/Strings/StringUtils.h>
+#include <Foundation/Types/ScopeExit.h>
+
+namespace
+{
+  // everything but entry point and profile, part of the options hash so changing them invalidates all binaries
+  constexpr const char* s_CompileArguments[] = {"-spirv", "-fspv-target-env=vulkan1.2", "-fvk-use-dx-layout", "-O0"};
+
+  constexpr nsUInt32 s_uiSpirvFileMagic = 0x5650534A; // 'JSPV'
+  constexpr nsUInt32 s_uiSpirvFileVersion = 1;
+
+  struct SpirvFileHeader
+  {
+    nsUInt32 m_uiMagic = s_uiSpirvFileMagic;
+    nsUInt32 m_uiVersion = s_uiSpirvFileVersion;
+    nsUInt64 m_uiSourceHash = 0;
+    nsUInt64 m_uiOptionsHash = 0;
+    nsUInt32 m_uiWordCount = 0;
+    nsUInt32 m_uiPadding = 0;
+  };
+
+  nsResult LoadShaderSource(const char* szPath, nsDynamicArray<char>& outBuffer)
+  {
+    nsFileReader file;
+    nsHybridArray<nsString, 8> attemptedPaths;
+    nsString openedPath;
+
+    auto TryOpen = [&](nsStringView path) -> bool {
+      if (path.IsEmpty())
+        return false;
+
+      attemptedPaths.PushBack(path);
+      if (file.Open(path).Succeeded())
+      {
+        openedPath = path;
+        return true;
+      }
+      return false;
+    };
+
+    if (!TryOpen(szPath))
+    {
+      nsStringBuilder relativePath;
+
+      if (nsStringUtils::IsEqualN(szPath, ":base/", 6))
+      {
+        relativePath = "Data/Base/";
+        relativePath.Append(szPath + 6);
+      }
+      else if (szPath[0] == ':' && szPath[1] != '\0')
+      {
+        const char* szSlash = nsStringUtils::FindSubString(szPath, "/");
+        if (szSlash != nullptr && *(szSlash + 1) != '\0')
+        {
+          relativePath = szSlash + 1;
+        }
+      }
+      else
+      {
+        relativePath = szPath;
+      }
+
+      if (!relativePath.IsEmpty())
+      {
+        TryOpen(relativePath.GetView());
+
+        nsHybridArray<nsString, 4> searchRoots;
+        nsStringBuilder root = nsOSFile::GetApplicationDirectory();
+        root.MakeCleanPath();
+
+        for (nsUInt32 i = 0; i < 4 && !root.IsEmpty(); ++i)
+        {
+          searchRoots.PushBack(root.GetView());
+
+          const nsUInt32 uiLengthBefore = root.GetCharacterCount();
+          root.PathParentDirectory();
+          root.MakeCleanPath();
+
+          if (root.IsEmpty() || root.GetCharacterCount() >= uiLengthBefore)
+            break;
+        }
+
+        for (const nsString& rootPath : searchRoots)
+        {
+          nsStringBuilder candidate = rootPath;
+          candidate.AppendPath(relativePath);
+          candidate.MakeCleanPath();
+
+          if (TryOpen(candidate.GetView()))
+            break;
+        }
+      }
+    }
+
+    if (openedPath.IsEmpty())
+    {
+      nsStringBuilder attemptsList;
+      for (nsUInt32 i = 0; i < attemptedPaths.GetCount(); ++i)
+      {
+        if (i > 0)
+          attemptsList.Append(", ");
+        attemptsList.Append(attemptedPaths[i]);
+      }
+
+      nsLog::Error("Failed to open shader file '{0}'. Tried: {1}", szPath, attemptsList);
+      return NS_FAILURE;
+    }
+
+    const nsUInt64 uiFileSize = file.GetFileSize();
+    outBuffer.SetCount(static_cast<nsUInt32>(uiFileSize));
+
+    const nsUInt64 uiBytesRead = file.ReadBytes(outBuffer.GetData(), uiFileSize);
+    if (uiBytesRead != uiFileSize)
+    {
+      nsLog::Error("Failed to read shader file '{0}'", openedPath);
+      return NS_FAILURE;
+    }
+
+    return NS_SUCCESS;
+  }
+
+  nsUInt64 ComputeOptionsHash(const nsVkShaderDesc& desc)
+  {
+    nsUInt64 uiHash = nsHashingUtils::xxHash64String(desc.m_szEntryPoint);
+    uiHash = nsHashingUtils::xxHash64String(desc.m_szProfile, uiHash);
+    for (const char* szArgument : s_CompileArguments)
+    {
+      uiHash = nsHashingUtils::xxHash64String(szArgument, uiHash);
+    }
+    return uiHash;
+  }
+
+  nsString GetPrecompiledPath(const nsVkShaderDesc& desc, nsStringView sFolder)
+  {
+    nsStringBuilder sPath = sFolder;
+    sPath.AppendPath(nsStringView(desc.m_szSourcePath).GetFileName());
+    sPath.AppendFormat(".{}.spv", desc.m_szEntryPoint);
+    return sPath;
+  }
+
+  nsResult ReadSpirvFile(nsStringView sPath, nsUInt64 uiSourceHash, nsUInt64 uiOptionsHash, nsDynamicArray<nsUInt32>& out_spirv)
+  {
+    if (!nsOSFile::ExistsFile(sPath))
+      return NS_FAILURE;
+
+    nsOSFile file;
+    if (file.Open(sPath, nsFileOpenMode::Read).Failed())
+      return NS_FAILURE;
+
+    SpirvFileHeader header;
+    if (file.Read(&header, sizeof(header)) != sizeof(header))
+      return NS_FAILURE;
+
+    // a stale binary is not an error, the source or the options changed since it was written
+    if (header.m_uiMagic != s_uiSpirvFileMagic || header.m_uiVersion != s_uiSpirvFileVersion || header.m_uiSourceHash != uiSourceHash || header.m_uiOptionsHash != uiOptionsHash || header.m_uiWordCount == 0)
+      return NS_FAILURE;
+
+    out_spirv.SetCountUninitialized(header.m_uiWordCount);
+    const nsUInt64 uiBytes = static_cast<nsUInt64>(header.m_uiWordCount) * sizeof(nsUInt32);
+    if (file.Read(out_spirv.GetData(), uiBytes) != uiBytes)
+    {
+      out_spirv.Clear();
+      return NS_FAILURE;
+    }
+
+    return NS_SUCCESS;
+  }
+
+  nsResult WriteSpirvFile(nsStringView sPath, nsUInt64 uiSourceHash, nsUInt64 uiOptionsHash, nsArrayPtr<const nsUInt32> spirv)
+  {
+    nsStringBuilder sFolder = sPath;
+    sFolder.PathParentDirectory();
+    NS_SUCCEED_OR_RETURN(nsOSFile::CreateDirectoryStructure(sFolder));
+
+    // write to a temporary file first, a concurrently starting viewer must never see half a binary
+    nsStringBuilder sTempPath = sPath;
+    sTempPath.Append(".tmp");
+
+    {
+      nsOSFile file;
+      NS_SUCCEED_OR_RETURN(file.Open(sTempPath, nsFileOpenMode::Write));
+
+      SpirvFileHeader header;
+      header.m_uiSourceHash = uiSourceHash;
+      header.m_uiOptionsHash = uiOptionsHash;
+      header.m_uiWordCount = spirv.GetCount();
+
+      NS_SUCCEED_OR_RETURN(file.Write(&header, sizeof(header)));
+      NS_SUCCEED_OR_RETURN(file.Write(spirv.GetPtr(), spirv.GetCount() * sizeof(nsUInt32)));
+    }
+
+    nsOSFile::DeleteFile(sPath).IgnoreResult();
+    return nsOSFile::MoveFileOrDirectory(sTempPath, sPath);
+  }
+
+  /// Loads DXC and compiles HLSL to SPIR-V.
+  class DxcCompiler
+  {
+  public:
+    ~DxcCompiler()
+    {
+      if (m_pIncludeHandler)
+        m_pIncludeHandler->Release();
+      if (m_pCompiler)
+        m_pCompiler->Release();
+      if (m_pUtils)
+        m_pUtils->Release();
+    }
+
+    nsResult Initialize()
+    {
+      nsVulkanDxc::CreateInstanceProc pfnCreateInstance = nullptr;
+      if (nsVulkanDxc::ResolveCreateInstance(pfnCreateInstance).Failed() || pfnCreateInstance == nullptr)
+      {
+        nsLog::Error("DXC runtime is not available on this platform");
+        return NS_FAILURE;
+      }
+
+      HRESULT hr = pfnCreateInstance(CLSID_DxcUtils, __uuidof(IDxcUtils), reinterpret_cast<void**>(&m_pUtils));
+      if (FAILED(hr) || m_pUtils == nullptr)
+      {
+        nsLog::Error("Failed to create DxcUtils instance (HRESULT: 0x{0})", HResultHex(hr));
+        return NS_FAILURE;
+      }
+
+      hr = pfnCreateInstance(CLSID_DxcCompiler, __uuidof(IDxcCompiler3), reinterpret_cast<void**>(&m_pCompiler));
+      if (FAILED(hr) || m_pCompiler == nullptr)
+      {
+        nsLog::Error("Failed to create DxcCompiler instance (HRESULT: 0x{0})", HResultHex(hr));
+        return NS_FAILURE;
+      }
+
+      hr = m_pUtils->CreateDefaultIncludeHandler(&m_pIncludeHandler);
+      if (FAILED(hr) || m_pIncludeHandler == nullptr)
+      {
+        nsLog::Error("Failed to create Dxc include handler (HRESULT: 0x{0})", HResultHex(hr));
+        return NS_FAILURE;
+      }
+
+      IDxcVersionInfo* pVersionInfo = nullptr;
+      if (SUCCEEDED(m_pCompiler->QueryInterface(__uuidof(IDxcVersionInfo), reinterpret_cast<void**>(&pVersionInfo))) && pVersionInfo != nullptr)
+      {
+        UINT32 uiMajor = 0;
+        UINT32 uiMinor = 0;
+        if (SUCCEEDED(pVersionInfo->GetVersion(&uiMajor, &uiMinor)))
+        {
+          m_uiVersion = (static_cast<nsUInt64>(uiMajor) << 32) | uiMinor;
+        }
+        pVersionInfo->Release();
+      }
+
+      return NS_SUCCESS;
+    }
+
+    nsUInt64 GetVersion() const { return m_uiVersion; }
+
+    nsResult Compile(const nsVkShaderDesc& desc, nsArrayPtr<const char> source, nsDynamicArray<nsUInt32>& out_spirv)
+    {
+      DxcBuffer sourceBuffer = {};
+      sourceBuffer.Ptr = source.GetPtr();
+      sourceBuffer.Size = static_cast<SIZE_T>(source.GetCount());
+      sourceBuffer.Encoding = DXC_CP_UTF8;
+
+      nsHybridArray<nsStringWChar, 8> argumentStorage;
+      argumentStorage.PushBack(nsStringWChar("-E"));
+      argumentStorage.PushBack(nsStringWChar(desc.m_szEntryPoint));
+      argumentStorage.PushBack(nsStringWChar("-T"));
+      argumentStorage.PushBack(nsStringWChar(desc.m_szProfile));
+      for (const char* szArgument : s_CompileArguments)
+      {
+        argumentStorage.PushBack(nsStringWChar(szArgument));
+      }
+
+      nsHybridArray<const wchar_t*, 8> arguments;
+      for (const nsStringWChar& argument : argumentStorage)
+      {
+        arguments.PushBack(argument.GetData());
+      }
+
+      IDxcResult* pResult = nullptr;
+      HRESULT compileHr = m_pCompiler->Compile(&sourceBuffer, arguments.GetData(), arguments.GetCount(), m_pIncludeHandler, __uuidof(IDxcResult), reinterpret_cast<void**>(&pResult));
+      if (FAILED(compileHr) || pResult == nullptr)
+      {
+        nsLog::Error("Failed to compile shader '{0}' with DXC (HRESULT: 0x{1})", desc.m_szSourcePath, HResultHex(compileHr));
+        return NS_FAILURE;
+      }
+      NS_SCOPE_EXIT(if (pResult) { pResult->Release(); });
+
+      HRESULT status = S_OK;
+      if (FAILED(pResult->GetStatus(&status)) || FAILED(status))
+      {
+        IDxcBlobUtf8* pErrors = nullptr;
+        if (SUCCEEDED(pResult->GetOutput(DXC_OUT_ERRORS, __uuidof(IDxcBlobUtf8), reinterpret_cast<void**>(&pErrors), nullptr)) && pErrors && pErrors->GetStringLength() > 0)
+        {
+          nsLog::Error("DXC compilation error: {0}", pErrors->GetStringPointer());
+        }
+        if (pErrors)
+        {
+          pErrors->Release();
+        }
+        return NS_FAILURE;
+      }
+
+      IDxcBlob* pBlob = nullptr;
+      if (FAILED(pResult->GetOutput(DXC_OUT_OBJECT, __uuidof(IDxcBlob), reinterpret_cast<void**>(&pBlob), nullptr)) || pBlob == nullptr)
+      {
+        nsLog::Error("Failed to retrieve compiled shader blob");
+        return NS_FAILURE;
+      }
+      NS_SCOPE_EXIT(pBlob->Release());
+
+      const nsUInt32 uiWordCount = static_cast<nsUInt32>(pBlob->GetBufferSize() / sizeof(nsUInt32));
+      out_spirv.SetCountUninitialized(uiWordCount);
+      nsMemoryUtils::RawByteCopy(out_spirv.GetData(), pBlob->GetBufferPointer(), uiWordCount * sizeof(nsUInt32));
+      return NS_SUCCESS;
+    }
+
+  private:
+    static nsArgU HResultHex(HRESULT value)
+    {
+      return nsArgU(static_cast<nsUInt64>(static_cast<nsUInt32>(value)), 8, true, 16, true);
+    }
+
+    IDxcUtils* m_pUtils = nullptr;
+    IDxcCompiler3* m_pCompiler = nullptr;
+    IDxcIncludeHandler* m_pIncludeHandler = nullptr;
+    nsUInt64 m_uiVersion = 0;
+  };
+} // namespace
+
+nsResult nsVkShaderCache::GetSpirv(const nsVkShaderDesc& desc, nsDynamicArray<nsUInt32>& out_spirv, nsVkShaderOrigin* out_pOrigin)
+{
+  nsDynamicArray<char> source;
+  NS_SUCCEED_OR_RETURN(LoadShaderSource(desc.m_szSourcePath, source));
+
+  if (source.IsEmpty())
+  {
+    nsLog::Error("Shader source '{0}' is empty", desc.m_szSourcePath);
+    return NS_FAILURE;
+  }
+
+  const nsUInt64 uiSourceHash = nsHashingUtils::xxHash64(source.GetData(), source.GetCount());
+  const nsUInt64 uiOptionsHash = ComputeOptionsHash(desc);
+
+  // precompiled binaries are valid for any DXC version, so DXC does not even have to be installed
+  if (ReadSpirvFile(GetPrecompiledPath(desc, GetPrecompiledFolder()), uiSourceHash, uiOptionsHash, out_spirv).Succeeded())
+  {
+    if (out_pOrigin)
+      *out_pOrigin = nsVkShaderOrigin::Precompiled;
+    return NS_SUCCESS;
+  }
+
+  DxcCompiler compiler;
+  NS_SUCCEED_OR_RETURN(compiler.Initialize());
+
+  nsUInt64 uiCacheKey = nsHashingUtils::xxHash64(&uiSourceHash, sizeof(uiSourceHash), uiOptionsHash);
+  const nsUInt64 uiDxcVersion = compiler.GetVersion();
+  uiCacheKey = nsHashingUtils::xxHash64(&uiDxcVersion, sizeof(uiDxcVersion), uiCacheKey);
+
+  nsStringBuilder sCachePath = GetCacheFolder();
+  sCachePath.AppendFormat("/{}.spv", nsArgU(uiCacheKey, 16, true, 16));
+
+  if (ReadSpirvFile(sCachePath, uiSourceHash, uiOptionsHash, out_spirv).Succeeded())
+  {
+    if (out_pOrigin)
+      *out_pOrigin = nsVkShaderOrigin::Cache;
+    return NS_SUCCESS;
+  }
+
+  NS_SUCCEED_OR_RETURN(compiler.Compile(desc, source, out_spirv));
+
+  if (WriteSpirvFile(sCachePath, uiSourceHash, uiOptionsHash, out_spirv).Failed())
+  {
+    nsLog::Warning("Failed to write shader cache file '{0}'", sCachePath);
+  }
+
+  if (out_pOrigin)
+    *out_pOrigin = nsVkShaderOrigin::Compiled;
+  return NS_SUCCESS;
+}
+
+nsResult nsVkShaderCache::Precompile(const nsVkShaderDesc& desc, nsStringView sFolder)
+{
+  nsDynamicArray<char> source;
+  NS_SUCCEED_OR_RETURN(LoadShaderSource(desc.m_szSourcePath, source));
+
+  DxcCompiler compiler;
+  NS_SUCCEED_OR_RETURN(compiler.Initialize());
+
+  nsDynamicArray<nsUInt32> spirv;
+  NS_SUCCEED_OR_RETURN(compiler.Compile(desc, source, spirv));
+
+  const nsString sPath = GetPrecompiledPath(desc, sFolder);
+  if (WriteSpirvFile(sPath, nsHashingUtils::xxHash64(source.GetData(), source.GetCount()), ComputeOptionsHash(desc), spirv).Failed())
+  {
+    nsLog::Error("Failed to write precompiled shader '{0}'", sPath);
+    return NS_FAILURE;
+  }
+
+  nsLog::Info("Precompiled '{0}' ({1}) to '{2}'", desc.m_szSourcePath, desc.m_szEntryPoint, sPath);
+  return NS_SUCCESS;
+}
+
+nsString nsVkShaderCache::GetPrecompiledFolder()
+{
+  nsStringBuilder sFolder = nsOSFile::GetApplicationDirectory();
+  sFolder.AppendPath("VulkanShaders");
+  return sFolder;
+}
+
+nsString nsVkShaderCache::GetCacheFolder()
+{
+  return nsOSFile::GetTempDataFolder("JDebug/VulkanCache");
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <VulkanRenderer/VulkanRendererDLL.h>
+
+#include <Foundation/Containers/DynamicArray.h>
+#include <Foundation/Strings/String.h>
+
+/// \brief One HLSL entry point that is compiled to SPIR-V.
+struct nsVkShaderDesc
+{
+  const char* m_szSourcePath = nullptr; ///< For example ":base/Shaders/VulkanRenderer/PvdSceneVS.hlsl".
+  const char* m_szEntryPoint = nullptr;
+  const char* m_szProfile = nullptr; ///< DXC target profile, for example "vs_6_0".
+};
+
+/// \brief Where nsVkShaderCache::GetSpirv() found the SPIR-V of a shader.
+enum class nsVkShaderOrigin
+{
+  Precompiled, ///< Compiled at build time and shipped next to the executable.
+  Cache,       ///< Compiled by an earlier run of this DXC version.
+  Compiled,    ///< Compiled with DXC just now.
+};
+
+/// \brief Provides SPIR-V for the renderer's HLSL shaders without compiling them on every start.
+///
+/// Shaders are looked up in the precompiled folder next to the executable, then in the on-disk cache and only then
+/// compiled with DXC. Both locations are validated against a hash of the source and the compile options, cache entries
+/// are additionally keyed by the DXC version.
+class NS_VULKANRENDERER_DLL nsVkShaderCache
+{
+public:
+  static nsResult GetSpirv(const nsVkShaderDesc& desc, nsDynamicArray<nsUInt32>& out_spirv, nsVkShaderOrigin* out_pOrigin = nullptr);
+
+  /// \brief Compiles the shader with DXC and writes it to its precompiled location below sFolder.
+  static nsResult Precompile(const nsVkShaderDesc& desc, nsStringView sFolder);
+
+  /// \brief The folder the build step writes precompiled shaders to: 'VulkanShaders' next to the executable.
+  static nsString GetPrecompiledFolder();
+
+  /// \brief Folder for the SPIR-V and pipeline caches written at runtime.
+  static nsString GetCacheFolder();
+};
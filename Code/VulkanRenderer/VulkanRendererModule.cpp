@@ -1,10 +1,10 @@
 #include <VulkanRenderer/VulkanRendererPCH.h>
 #include <VulkanRenderer/VulkanRendererModule.h>
-#include <VulkanRenderer/DxcSupport.h>
 
 #include <VulkanRenderer/Core/VkCommandContext.h>
 #include <VulkanRenderer/Core/VkDevice.h>
 #include <VulkanRenderer/Core/VkInstance.h>
+#include <VulkanRenderer/Core/VkShaderCache.h>
 #include <VulkanRenderer/Core/VkSwapChain.h>
 
 #include <Foundation/Configuration/Startup.h>
@@ -19,12 +19,11 @@
 #include <Foundation/Memory/MemoryUtils.h>
 #include <Foundation/Strings/FormatString.h>
 #include <Foundation/Strings/StringUtils.h>
+#include <Foundation/Time/Stopwatch.h>
 #include <Foundation/Types/ScopeExit.h>
 
 #include <array>
 
-#include <dxcapi.h>
-
 #include <limits>
 
 #include <volk/volk.h>
@@ -41,118 +40,41 @@ namespace
     nsMat4 m_ViewProjection = nsMat4::MakeIdentity();
   };
 
-  struct alignas(16) PushConstantData
-  {
-    nsMat4 m_Model = nsMat4::MakeIdentity();
-    nsColor m_Color = nsColor::White;
-  };
+  // the vertex input layout in CreateGraphicsPipeline() reads the matrix as four float4 rows followed by the color
+  static_assert(sizeof(nsVulkanGpuInstance) == sizeof(float) * 20, "Instance layout does not match the vertex input description");
 
-  static_assert(sizeof(PushConstantData) <= 128, "Push constant data exceeds Vulkan limit");
+  // grow instance buffers in steps, so slowly growing scenes do not reallocate every frame
+  constexpr nsUInt32 s_uiMinInstanceCapacity = 1024;
 
-  constexpr const char* s_szVertexShaderPath = ":base/Shaders/VulkanRenderer/PvdSceneVS.hlsl";
-  constexpr const char* s_szFragmentShaderPath = ":base/Shaders/VulkanRenderer/PvdScenePS.hlsl";
+  // in the order of nsVulkanRenderer::ShaderIndex
+  constexpr nsVkShaderDesc s_Shaders[] = {
+    {":base/Shaders/VulkanRenderer/PvdSceneVS.hlsl", "mainVS", "vs_6_0"},
+    {":base/Shaders/VulkanRenderer/PvdScenePS.hlsl", "mainPS", "ps_6_0"},
+    {":base/Shaders/VulkanRenderer/PvdOverlayVS.hlsl", "mainTrailVS", "vs_6_0"},
+    {":base/Shaders/VulkanRenderer/PvdOverlayVS.hlsl", "mainVelocityVS", "vs_6_0"},
+    {":base/Shaders/VulkanRenderer/PvdOverlayVS.hlsl", "mainHeatmapVS", "vs_6_0"},
+    {":base/Shaders/VulkanRenderer/PvdOverlayPS.hlsl", "mainPS", "ps_6_0"},
+  };
 
-  nsResult LoadShaderSource(const char* szPath, nsDynamicArray<char>& outBuffer)
+  // push constants of the overlay shaders, see PvdOverlayVS.hlsl
+  struct OverlayConstants
   {
-    nsFileReader file;
-    nsHybridArray<nsString, 8> attemptedPaths;
-    nsString openedPath;
-
-    auto TryOpen = [&](nsStringView path) -> bool {
-      if (path.IsEmpty())
-        return false;
-
-      attemptedPaths.PushBack(path);
-      if (file.Open(path).Succeeded())
-      {
-        openedPath = path;
-        return true;
-      }
-      return false;
-    };
-
-    if (!TryOpen(szPath))
-    {
-      nsStringBuilder relativePath;
-
-      if (nsStringUtils::IsEqualN(szPath, ":base/", 6))
-      {
-        relativePath = "Data/Base/";
-        relativePath.Append(szPath + 6);
-      }
-      else if (szPath[0] == ':' && szPath[1] != '\0')
-      {
-        const char* szSlash = nsStringUtils::FindSubString(szPath, "/");
-        if (szSlash != nullptr && *(szSlash + 1) != '\0')
-        {
-          relativePath = szSlash + 1;
-        }
-      }
-      else
-      {
-        relativePath = szPath;
-      }
-
-      if (!relativePath.IsEmpty())
-      {
-        TryOpen(relativePath.GetView());
-
-        nsHybridArray<nsString, 4> searchRoots;
-        nsStringBuilder root = nsOSFile::GetApplicationDirectory();
-        root.MakeCleanPath();
-
-        for (nsUInt32 i = 0; i < 4 && !root.IsEmpty(); ++i)
-        {
-          searchRoots.PushBack(root.GetView());
-
-          const nsUInt32 uiLengthBefore = root.GetCharacterCount();
-          root.PathParentDirectory();
-          root.MakeCleanPath();
-
-          if (root.IsEmpty() || root.GetCharacterCount() >= uiLengthBefore)
-            break;
-        }
-
-        for (const nsString& rootPath : searchRoots)
-        {
-          nsStringBuilder candidate = rootPath;
-          candidate.AppendPath(relativePath);
-          candidate.MakeCleanPath();
-
-          if (TryOpen(candidate.GetView()))
-            break;
-        }
-      }
-    }
-
-    if (openedPath.IsEmpty())
-    {
-      nsStringBuilder attemptsList;
-      for (nsUInt32 i = 0; i < attemptedPaths.GetCount(); ++i)
-      {
-        if (i > 0)
-          attemptsList.Append(", ");
-        attemptsList.Append(attemptedPaths[i]);
-      }
+    nsUInt32 m_uiHeadRow = 0;
+    nsUInt32 m_uiFrameCount = 0;
+    nsUInt32 m_uiFrameCapacity = 0;
+    nsUInt32 m_uiBodyCapacity = 0;
+    float m_fVelocityScale = 0.0f;
+    float m_fPadding[3] = {};
+  };
 
-      nsLog::Error("Failed to open shader file '{0}'. Tried: {1}", szPath, attemptsList);
-      return NS_FAILURE;
-    }
+  // the overlay shaders read the history as a StructuredBuffer with this stride
+  static_assert(sizeof(nsVulkanHistorySample) == sizeof(float) * 8, "History sample layout does not match PvdOverlayVS.hlsl");
 
-    const nsUInt64 uiFileSize = file.GetFileSize();
-    outBuffer.SetCount(static_cast<nsUInt32>(uiFileSize + 1));
+  // 64 frames of 64k bodies, anything beyond that is not worth keeping on the GPU
+  constexpr nsUInt64 s_uiMaxHistoryBytes = 128ull * 1024 * 1024;
 
-    const nsUInt64 uiBytesRead = file.ReadBytes(outBuffer.GetData(), uiFileSize);
-    if (uiBytesRead != uiFileSize)
-    {
-      nsLog::Error("Failed to read shader file '{0}'", openedPath);
-      return NS_FAILURE;
-    }
-
-    outBuffer[static_cast<nsUInt32>(uiFileSize)] = '\0';
-    return NS_SUCCESS;
-  }
-}
+  constexpr const char* s_szPipelineCacheFile = "PipelineCache.bin";
+} // namespace
 
 nsVulkanRenderer::nsVulkanRenderer() = default;
 nsVulkanRenderer::~nsVulkanRenderer()
@@ -164,6 +86,9 @@ nsResult nsVulkanRenderer::Initialize(const nsVulkanRendererCreateInfo& createIn
 {
   NS_LOG_BLOCK("VulkanRenderer::Initialize");
 
+  nsStopwatch initTimer;
+  m_startupStats = {};
+
   m_pInstance = NS_DEFAULT_NEW(nsVkInstance);
 
   nsVkInstanceCreateInfo instanceInfo;
@@ -227,11 +152,15 @@ nsResult nsVulkanRenderer::Initialize(const nsVulkanRendererCreateInfo& createIn
   m_uiCurrentFrame = 0;
   m_bResizePending = true;
 
+  const nsTime shaderStart = initTimer.GetRunningTotal();
   if (CreateShaderModules().Failed())
   {
     nsLog::Error("Failed to create Vulkan shader modules");
     return NS_FAILURE;
   }
+  m_startupStats.m_ShaderDuration = initTimer.GetRunningTotal() - shaderStart;
+
+  CreatePipelineCache();
 
   if (CreateDescriptorResources().Failed())
   {
@@ -263,15 +192,30 @@ nsResult nsVulkanRenderer::Initialize(const nsVulkanRendererCreateInfo& createIn
     return NS_FAILURE;
   }
 
+  const nsTime pipelineStart = initTimer.GetRunningTotal();
   if (CreateGraphicsPipeline().Failed())
   {
     nsLog::Error("Failed to create Vulkan graphics pipeline");
     return NS_FAILURE;
   }
+  m_startupStats.m_PipelineDuration = initTimer.GetRunningTotal() - pipelineStart;
+  m_startupStats.m_TotalDuration = initTimer.GetRunningTotal();
+
+  nsLog::Info("Vulkan renderer started in {0} ms: shaders {1} ms ({2} compiled), pipeline {3} ms (cache {4})",
+    nsArgF(m_startupStats.m_TotalDuration.GetMilliseconds(), 1),
+    nsArgF(m_startupStats.m_ShaderDuration.GetMilliseconds(), 1),
+    m_startupStats.m_uiShadersCompiled,
+    nsArgF(m_startupStats.m_PipelineDuration.GetMilliseconds(), 1),
+    m_startupStats.m_bPipelineCacheLoaded ? "loaded" : "empty");
 
   return NS_SUCCESS;
 }
 
+nsArrayPtr<const nsVkShaderDesc> nsVulkanRenderer::GetShaderDescs()
+{
+  return s_Shaders;
+}
+
 void nsVulkanRenderer::SetBackBufferSize(nsUInt32 uiWidth, nsUInt32 uiHeight)
 {
   VkExtent2D newExtent = {uiWidth, uiHeight};
@@ -593,6 +537,26 @@ nsResult nsVulkanRenderer::CreateDescriptorResources()
     }
   }
 
+  if (m_historySetLayout == VK_NULL_HANDLE)
+  {
+    VkDescriptorSetLayoutBinding layoutBinding = {};
+    layoutBinding.binding = 0;
+    layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    layoutBinding.descriptorCount = 1;
+    layoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &layoutBinding;
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &m_historySetLayout) != VK_SUCCESS)
+    {
+      nsLog::Error("Failed to create Vulkan descriptor set layout for the motion history");
+      return NS_FAILURE;
+    }
+  }
+
   if (m_descriptorPool == VK_NULL_HANDLE)
   {
     VkDescriptorPoolSize poolSize = {};
@@ -841,147 +805,37 @@ nsResult nsVulkanRenderer::CreateShaderModules()
   if (device == VK_NULL_HANDLE)
     return NS_FAILURE;
 
-  if (m_vertexShaderModule != VK_NULL_HANDLE && m_fragmentShaderModule != VK_NULL_HANDLE)
-    return NS_SUCCESS;
-
-  nsDynamicArray<char> vertexSource;
-  NS_SUCCEED_OR_RETURN(LoadShaderSource(s_szVertexShaderPath, vertexSource));
-
-  nsDynamicArray<char> fragmentSource;
-  NS_SUCCEED_OR_RETURN(LoadShaderSource(s_szFragmentShaderPath, fragmentSource));
-
-  auto MakeSourceView = [](const nsDynamicArray<char>& buffer) {
-    const nsUInt32 count = buffer.GetCount();
-    if (count == 0)
-      return nsArrayPtr<const char>();
-    return nsArrayPtr<const char>(buffer.GetData(), count - 1);
-  };
-
-  nsArrayPtr<const char> vertexSourceView = MakeSourceView(vertexSource);
-  nsArrayPtr<const char> fragmentSourceView = MakeSourceView(fragmentSource);
-
-  nsVulkanDxc::CreateInstanceProc pfnCreateInstance = nullptr;
-  if (nsVulkanDxc::ResolveCreateInstance(pfnCreateInstance).Failed() || pfnCreateInstance == nullptr)
-  {
-    nsLog::Error("DXC runtime is not available on this platform");
-    return NS_FAILURE;
-  }
-
-  auto hresultHex = [](HRESULT value) {
-    return nsArgU(static_cast<nsUInt64>(static_cast<nsUInt32>(value)), 8, true, 16, true);
-  };
-
-  IDxcUtils* pUtils = nullptr;
-  HRESULT hr = pfnCreateInstance(CLSID_DxcUtils, __uuidof(IDxcUtils), reinterpret_cast<void**>(&pUtils));
-  if (FAILED(hr) || pUtils == nullptr)
-  {
-    nsLog::Error("Failed to create DxcUtils instance (HRESULT: 0x{0})", hresultHex(hr));
-    return NS_FAILURE;
-  }
-  NS_SCOPE_EXIT(if (pUtils) { pUtils->Release(); });
-
-  IDxcCompiler3* pCompiler = nullptr;
-  hr = pfnCreateInstance(CLSID_DxcCompiler, __uuidof(IDxcCompiler3), reinterpret_cast<void**>(&pCompiler));
-  if (FAILED(hr) || pCompiler == nullptr)
-  {
-    nsLog::Error("Failed to create DxcCompiler instance (HRESULT: 0x{0})", hresultHex(hr));
-    return NS_FAILURE;
-  }
-  NS_SCOPE_EXIT(if (pCompiler) { pCompiler->Release(); });
+  static_assert(NS_ARRAY_SIZE(s_Shaders) == ShaderCount);
 
-  IDxcIncludeHandler* pIncludeHandler = nullptr;
-  hr = pUtils->CreateDefaultIncludeHandler(&pIncludeHandler);
-  if (FAILED(hr) || pIncludeHandler == nullptr)
+  nsDynamicArray<nsUInt32> spirv;
+  for (nsUInt32 i = 0; i < ShaderCount; ++i)
   {
-    nsLog::Error("Failed to create Dxc include handler (HRESULT: 0x{0})", hresultHex(hr));
-    return NS_FAILURE;
-  }
-  NS_SCOPE_EXIT(if (pIncludeHandler) { pIncludeHandler->Release(); });
+    if (m_shaderModules[i] != VK_NULL_HANDLE)
+      continue;
 
-  auto CompileShader = [&](nsArrayPtr<const char> source, const wchar_t* entryPoint, const wchar_t* targetProfile, const char* szDebugName, IDxcBlob*& outBlob) -> nsResult {
-    if (source.IsEmpty())
+    nsVkShaderOrigin origin = nsVkShaderOrigin::Compiled;
+    if (nsVkShaderCache::GetSpirv(s_Shaders[i], spirv, &origin).Failed())
     {
-      nsLog::Error("Shader source '{0}' is empty", szDebugName);
+      DestroyShaderModules();
       return NS_FAILURE;
     }
 
-    DxcBuffer sourceBuffer = {};
-    sourceBuffer.Ptr = source.GetPtr();
-    sourceBuffer.Size = static_cast<SIZE_T>(source.GetCount());
-    sourceBuffer.Encoding = DXC_CP_UTF8;
-
-    const wchar_t* arguments[] = {
-      L"-E", entryPoint,
-      L"-T", targetProfile,
-      L"-spirv",
-      L"-fspv-target-env=vulkan1.2",
-      L"-fvk-use-dx-layout",
-      L"-O0"
-    };
-
-    IDxcResult* pResult = nullptr;
-    HRESULT compileHr = pCompiler->Compile(&sourceBuffer, arguments, NS_ARRAY_SIZE(arguments), pIncludeHandler, __uuidof(IDxcResult), reinterpret_cast<void**>(&pResult));
-    if (FAILED(compileHr) || pResult == nullptr)
+    if (origin == nsVkShaderOrigin::Compiled)
     {
-      nsLog::Error("Failed to compile shader '{0}' with DXC (HRESULT: 0x{1})", szDebugName, hresultHex(compileHr));
-      return NS_FAILURE;
+      ++m_startupStats.m_uiShadersCompiled;
     }
-    NS_SCOPE_EXIT(if (pResult) { pResult->Release(); });
 
-    HRESULT status = S_OK;
-    if (FAILED(pResult->GetStatus(&status)) || FAILED(status))
-    {
-      IDxcBlobUtf8* pErrors = nullptr;
-      if (SUCCEEDED(pResult->GetOutput(DXC_OUT_ERRORS, __uuidof(IDxcBlobUtf8), reinterpret_cast<void**>(&pErrors), nullptr)) && pErrors && pErrors->GetStringLength() > 0)
-      {
-        nsLog::Error("DXC compilation error: {0}", pErrors->GetStringPointer());
-      }
-      if (pErrors)
-      {
-        pErrors->Release();
-      }
-      return NS_FAILURE;
-    }
+    VkShaderModuleCreateInfo moduleInfo = {};
+    moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize = spirv.GetCount() * sizeof(nsUInt32);
+    moduleInfo.pCode = spirv.GetData();
 
-    if (FAILED(pResult->GetOutput(DXC_OUT_OBJECT, __uuidof(IDxcBlob), reinterpret_cast<void**>(&outBlob), nullptr)) || outBlob == nullptr)
+    if (vkCreateShaderModule(device, &moduleInfo, nullptr, &m_shaderModules[i]) != VK_SUCCESS)
     {
-      nsLog::Error("Failed to retrieve compiled shader blob");
+      nsLog::Error("Failed to create Vulkan shader module for '{0}' ({1})", s_Shaders[i].m_szSourcePath, s_Shaders[i].m_szEntryPoint);
+      DestroyShaderModules();
       return NS_FAILURE;
     }
-
-    return NS_SUCCESS;
-  };
-
-  IDxcBlob* pVertexBlob = nullptr;
-  NS_SCOPE_EXIT(if (pVertexBlob) { pVertexBlob->Release(); });
-  NS_SUCCEED_OR_RETURN(CompileShader(vertexSourceView, L"mainVS", L"vs_6_0", s_szVertexShaderPath, pVertexBlob));
-
-  IDxcBlob* pFragmentBlob = nullptr;
-  NS_SCOPE_EXIT(if (pFragmentBlob) { pFragmentBlob->Release(); });
-  NS_SUCCEED_OR_RETURN(CompileShader(fragmentSourceView, L"mainPS", L"ps_6_0", s_szFragmentShaderPath, pFragmentBlob));
-
-  VkShaderModuleCreateInfo vertexModuleInfo = {};
-  vertexModuleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-  vertexModuleInfo.codeSize = pVertexBlob->GetBufferSize();
-  vertexModuleInfo.pCode = reinterpret_cast<const nsUInt32*>(pVertexBlob->GetBufferPointer());
-
-  if (vkCreateShaderModule(device, &vertexModuleInfo, nullptr, &m_vertexShaderModule) != VK_SUCCESS)
-  {
-    nsLog::Error("Failed to create Vulkan vertex shader module");
-    return NS_FAILURE;
-  }
-
-  VkShaderModuleCreateInfo fragmentModuleInfo = {};
-  fragmentModuleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-  fragmentModuleInfo.codeSize = pFragmentBlob->GetBufferSize();
-  fragmentModuleInfo.pCode = reinterpret_cast<const nsUInt32*>(pFragmentBlob->GetBufferPointer());
-
-  if (vkCreateShaderModule(device, &fragmentModuleInfo, nullptr, &m_fragmentShaderModule) != VK_SUCCESS)
-  {
-    nsLog::Error("Failed to create Vulkan fragment shader module");
-    vkDestroyShaderModule(device, m_vertexShaderModule, nullptr);
-    m_vertexShaderModule = VK_NULL_HANDLE;
-    return NS_FAILURE;
   }
 
   return NS_SUCCESS;
@@ -996,16 +850,13 @@ void nsVulkanRenderer::DestroyShaderModules()
   if (device == VK_NULL_HANDLE)
     return;
 
-  if (m_vertexShaderModule != VK_NULL_HANDLE)
-  {
-    vkDestroyShaderModule(device, m_vertexShaderModule, nullptr);
-    m_vertexShaderModule = VK_NULL_HANDLE;
-  }
-
-  if (m_fragmentShaderModule != VK_NULL_HANDLE)
+  for (VkShaderModule& shaderModule : m_shaderModules)
   {
-    vkDestroyShaderModule(device, m_fragmentShaderModule, nullptr);
-    m_fragmentShaderModule = VK_NULL_HANDLE;
+    if (shaderModule != VK_NULL_HANDLE)
+    {
+      vkDestroyShaderModule(device, shaderModule, nullptr);
+      shaderModule = VK_NULL_HANDLE;
+    }
   }
 }
 
@@ -1021,10 +872,10 @@ nsResult nsVulkanRenderer::CreateGraphicsPipeline()
   if (m_renderPass == VK_NULL_HANDLE)
     return NS_FAILURE;
 
-  if (m_vertexShaderModule == VK_NULL_HANDLE || m_fragmentShaderModule == VK_NULL_HANDLE)
+  if (m_shaderModules[SceneVS] == VK_NULL_HANDLE || m_shaderModules[ScenePS] == VK_NULL_HANDLE)
     return NS_FAILURE;
 
-  if (m_descriptorSetLayout == VK_NULL_HANDLE)
+  if (m_descriptorSetLayout == VK_NULL_HANDLE || m_historySetLayout == VK_NULL_HANDLE)
     return NS_FAILURE;
 
   if (m_graphicsPipeline != VK_NULL_HANDLE)
@@ -1033,31 +884,43 @@ nsResult nsVulkanRenderer::CreateGraphicsPipeline()
   VkPipelineShaderStageCreateInfo shaderStages[2] = {};
   shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
   shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-  shaderStages[0].module = m_vertexShaderModule;
-  shaderStages[0].pName = "mainVS";
+  shaderStages[0].module = m_shaderModules[SceneVS];
+  shaderStages[0].pName = s_Shaders[SceneVS].m_szEntryPoint;
 
   shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
   shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-  shaderStages[1].module = m_fragmentShaderModule;
-  shaderStages[1].pName = "mainPS";
+  shaderStages[1].module = m_shaderModules[ScenePS];
+  shaderStages[1].pName = s_Shaders[ScenePS].m_szEntryPoint;
 
-  VkVertexInputBindingDescription bindingDescription = {};
-  bindingDescription.binding = 0;
-  bindingDescription.stride = sizeof(float) * 3;
-  bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+  VkVertexInputBindingDescription bindingDescriptions[2] = {};
+  bindingDescriptions[0].binding = 0;
+  bindingDescriptions[0].stride = sizeof(float) * 3;
+  bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+  bindingDescriptions[1].binding = 1;
+  bindingDescriptions[1].stride = sizeof(nsVulkanGpuInstance);
+  bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
 
-  VkVertexInputAttributeDescription attributeDescription = {};
-  attributeDescription.location = 0;
-  attributeDescription.binding = 0;
-  attributeDescription.format = VK_FORMAT_R32G32B32_SFLOAT;
-  attributeDescription.offset = 0;
+  // location 0: position, locations 1-4: model matrix rows, location 5: color
+  VkVertexInputAttributeDescription attributeDescriptions[6] = {};
+  attributeDescriptions[0].location = 0;
+  attributeDescriptions[0].binding = 0;
+  attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+  attributeDescriptions[0].offset = 0;
+
+  for (nsUInt32 i = 1; i < NS_ARRAY_SIZE(attributeDescriptions); ++i)
+  {
+    attributeDescriptions[i].location = i;
+    attributeDescriptions[i].binding = 1;
+    attributeDescriptions[i].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    attributeDescriptions[i].offset = (i - 1) * sizeof(float) * 4;
+  }
 
   VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
   vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-  vertexInputInfo.vertexBindingDescriptionCount = 1;
-  vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-  vertexInputInfo.vertexAttributeDescriptionCount = 1;
-  vertexInputInfo.pVertexAttributeDescriptions = &attributeDescription;
+  vertexInputInfo.vertexBindingDescriptionCount = NS_ARRAY_SIZE(bindingDescriptions);
+  vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions;
+  vertexInputInfo.vertexAttributeDescriptionCount = NS_ARRAY_SIZE(attributeDescriptions);
+  vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions;
 
   VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
   inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -1117,17 +980,10 @@ nsResult nsVulkanRenderer::CreateGraphicsPipeline()
 
   if (m_pipelineLayout == VK_NULL_HANDLE)
   {
-    VkPushConstantRange pushConstant = {};
-    pushConstant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-    pushConstant.offset = 0;
-    pushConstant.size = sizeof(PushConstantData);
-
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipelineLayoutInfo.setLayoutCount = 1;
     pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
-    pipelineLayoutInfo.pushConstantRangeCount = 1;
-    pipelineLayoutInfo.pPushConstantRanges = &pushConstant;
 
     if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS)
     {
@@ -1152,15 +1008,219 @@ nsResult nsVulkanRenderer::CreateGraphicsPipeline()
   pipelineInfo.renderPass = m_renderPass;
   pipelineInfo.subpass = 0;
 
-  if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_graphicsPipeline) != VK_SUCCESS)
+  if (vkCreateGraphicsPipelines(device, m_pipelineCache, 1, &pipelineInfo, nullptr, &m_graphicsPipeline) != VK_SUCCESS)
   {
     nsLog::Error("Failed to create Vulkan graphics pipeline");
     return NS_FAILURE;
   }
 
+  if (m_overlayPipelineLayout == VK_NULL_HANDLE)
+  {
+    VkDescriptorSetLayout setLayouts[] = {m_descriptorSetLayout, m_historySetLayout};
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(OverlayConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = NS_ARRAY_SIZE(setLayouts);
+    pipelineLayoutInfo.pSetLayouts = setLayouts;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &m_overlayPipelineLayout) != VK_SUCCESS)
+    {
+      nsLog::Error("Failed to create Vulkan overlay pipeline layout");
+      return NS_FAILURE;
+    }
+  }
+
+  NS_SUCCEED_OR_RETURN(CreateOverlayPipeline(TrailVS, VK_PRIMITIVE_TOPOLOGY_LINE_LIST, false, m_trailPipeline));
+  NS_SUCCEED_OR_RETURN(CreateOverlayPipeline(VelocityVS, VK_PRIMITIVE_TOPOLOGY_LINE_LIST, false, m_velocityPipeline));
+  NS_SUCCEED_OR_RETURN(CreateOverlayPipeline(HeatmapVS, VK_PRIMITIVE_TOPOLOGY_POINT_LIST, true, m_heatmapPipeline));
+
+  return NS_SUCCESS;
+}
+
+nsResult nsVulkanRenderer::CreateOverlayPipeline(ShaderIndex vertexShader, VkPrimitiveTopology topology, bool bAdditive, VkPipeline& out_pipeline)
+{
+  if (out_pipeline != VK_NULL_HANDLE)
+    return NS_SUCCESS;
+
+  if (m_shaderModules[vertexShader] == VK_NULL_HANDLE || m_shaderModules[OverlayPS] == VK_NULL_HANDLE)
+    return NS_FAILURE;
+
+  VkPipelineShaderStageCreateInfo shaderStages[2] = {};
+  shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+  shaderStages[0].module = m_shaderModules[vertexShader];
+  shaderStages[0].pName = s_Shaders[vertexShader].m_szEntryPoint;
+
+  shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+  shaderStages[1].module = m_shaderModules[OverlayPS];
+  shaderStages[1].pName = s_Shaders[OverlayPS].m_szEntryPoint;
+
+  // the overlay shaders fetch everything from the history buffer by vertex and instance index
+  VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+  vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+  VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+  inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+  inputAssembly.topology = topology;
+  inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+  VkPipelineViewportStateCreateInfo viewportState = {};
+  viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+  viewportState.viewportCount = 1;
+  viewportState.scissorCount = 1;
+
+  VkPipelineRasterizationStateCreateInfo rasterizer = {};
+  rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+  rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+  rasterizer.cullMode = VK_CULL_MODE_NONE;
+  rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+  rasterizer.lineWidth = 1.0f;
+
+  VkPipelineMultisampleStateCreateInfo multisampling = {};
+  multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+  multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+  VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+  colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+  colorBlendAttachment.blendEnable = VK_TRUE;
+  colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+  colorBlendAttachment.dstColorBlendFactor = bAdditive ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+  colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+  colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+  colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+  VkPipelineColorBlendStateCreateInfo colorBlending = {};
+  colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+  colorBlending.attachmentCount = 1;
+  colorBlending.pAttachments = &colorBlendAttachment;
+
+  VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+  VkPipelineDynamicStateCreateInfo dynamicState = {};
+  dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  dynamicState.dynamicStateCount = NS_ARRAY_SIZE(dynamicStates);
+  dynamicState.pDynamicStates = dynamicStates;
+
+  VkGraphicsPipelineCreateInfo pipelineInfo = {};
+  pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  pipelineInfo.stageCount = NS_ARRAY_SIZE(shaderStages);
+  pipelineInfo.pStages = shaderStages;
+  pipelineInfo.pVertexInputState = &vertexInputInfo;
+  pipelineInfo.pInputAssemblyState = &inputAssembly;
+  pipelineInfo.pViewportState = &viewportState;
+  pipelineInfo.pRasterizationState = &rasterizer;
+  pipelineInfo.pMultisampleState = &multisampling;
+  pipelineInfo.pColorBlendState = &colorBlending;
+  pipelineInfo.pDynamicState = &dynamicState;
+  pipelineInfo.layout = m_overlayPipelineLayout;
+  pipelineInfo.renderPass = m_renderPass;
+  pipelineInfo.subpass = 0;
+
+  if (vkCreateGraphicsPipelines(m_pDevice->GetDevice(), m_pipelineCache, 1, &pipelineInfo, nullptr, &out_pipeline) != VK_SUCCESS)
+  {
+    nsLog::Error("Failed to create Vulkan overlay pipeline for '{0}'", s_Shaders[vertexShader].m_szEntryPoint);
+    out_pipeline = VK_NULL_HANDLE;
+    return NS_FAILURE;
+  }
+
   return NS_SUCCESS;
 }
 
+void nsVulkanRenderer::CreatePipelineCache()
+{
+  VkDevice device = m_pDevice->GetDevice();
+
+  nsStringBuilder sPath = nsVkShaderCache::GetCacheFolder();
+  sPath.AppendPath(s_szPipelineCacheFile);
+
+  nsDynamicArray<nsUInt8> data;
+  if (nsOSFile::ExistsFile(sPath))
+  {
+    nsOSFile file;
+    if (file.Open(sPath, nsFileOpenMode::Read).Succeeded())
+    {
+      file.ReadAll(data);
+    }
+  }
+
+  // drivers are supposed to reject foreign data themselves, not all of them do, so only hand over data of this exact device
+  if (!data.IsEmpty())
+  {
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(m_pDevice->GetPhysicalDevice(), &properties);
+
+    bool bValid = false;
+    if (data.GetCount() >= sizeof(VkPipelineCacheHeaderVersionOne))
+    {
+      VkPipelineCacheHeaderVersionOne header = {};
+      nsMemoryUtils::RawByteCopy(&header, data.GetData(), sizeof(header));
+
+      bValid = header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE && header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+               nsMemoryUtils::IsEqual(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    }
+
+    if (!bValid)
+    {
+      nsLog::Dev("Ignoring pipeline cache '{0}', it was written by another device or driver", sPath);
+      data.Clear();
+    }
+  }
+
+  VkPipelineCacheCreateInfo cacheInfo = {};
+  cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  cacheInfo.initialDataSize = data.GetCount();
+  cacheInfo.pInitialData = data.GetData();
+
+  if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &m_pipelineCache) != VK_SUCCESS)
+  {
+    // not fatal, pipelines are just built from scratch
+    nsLog::Warning("Failed to create Vulkan pipeline cache");
+    m_pipelineCache = VK_NULL_HANDLE;
+    return;
+  }
+
+  m_startupStats.m_bPipelineCacheLoaded = !data.IsEmpty();
+}
+
+void nsVulkanRenderer::DestroyPipelineCache()
+{
+  if (!m_pDevice || m_pipelineCache == VK_NULL_HANDLE)
+    return;
+
+  VkDevice device = m_pDevice->GetDevice();
+
+  size_t uiDataSize = 0;
+  nsDynamicArray<nsUInt8> data;
+  if (vkGetPipelineCacheData(device, m_pipelineCache, &uiDataSize, nullptr) == VK_SUCCESS && uiDataSize > 0)
+  {
+    data.SetCountUninitialized(static_cast<nsUInt32>(uiDataSize));
+    if (vkGetPipelineCacheData(device, m_pipelineCache, &uiDataSize, data.GetData()) == VK_SUCCESS)
+    {
+      const nsString sFolder = nsVkShaderCache::GetCacheFolder();
+      nsStringBuilder sPath = sFolder;
+      sPath.AppendPath(s_szPipelineCacheFile);
+
+      nsOSFile file;
+      if (nsOSFile::CreateDirectoryStructure(sFolder).Failed() || file.Open(sPath, nsFileOpenMode::Write).Failed() || file.Write(data.GetData(), uiDataSize).Failed())
+      {
+        nsLog::Warning("Failed to write Vulkan pipeline cache '{0}'", sPath);
+      }
+    }
+  }
+
+  vkDestroyPipelineCache(device, m_pipelineCache, nullptr);
+  m_pipelineCache = VK_NULL_HANDLE;
+}
+
 void nsVulkanRenderer::DestroyGraphicsPipeline()
 {
   if (!m_pDevice)
@@ -1181,6 +1241,21 @@ void nsVulkanRenderer::DestroyGraphicsPipeline()
     vkDestroyPipelineLayout(device, m_pipelineLayout, nullptr);
     m_pipelineLayout = VK_NULL_HANDLE;
   }
+
+  for (VkPipeline* pPipeline : {&m_trailPipeline, &m_velocityPipeline, &m_heatmapPipeline})
+  {
+    if (*pPipeline != VK_NULL_HANDLE)
+    {
+      vkDestroyPipeline(device, *pPipeline, nullptr);
+      *pPipeline = VK_NULL_HANDLE;
+    }
+  }
+
+  if (m_overlayPipelineLayout != VK_NULL_HANDLE)
+  {
+    vkDestroyPipelineLayout(device, m_overlayPipelineLayout, nullptr);
+    m_overlayPipelineLayout = VK_NULL_HANDLE;
+  }
 }
 
 nsResult nsVulkanRenderer::CreateFrameResources()
@@ -1292,6 +1367,9 @@ void nsVulkanRenderer::DestroyFrameResources()
 
       for (FrameInFlight& frame : m_framesInFlight)
       {
+        DestroyInstanceBuffer(frame);
+        DestroyHistoryStaging(frame);
+
         if (frame.m_imageAvailableSemaphore != VK_NULL_HANDLE)
         {
           vkDestroySemaphore(deviceHandle, frame.m_imageAvailableSemaphore, nullptr);
@@ -1316,19 +1394,436 @@ void nsVulkanRenderer::DestroyFrameResources()
   m_framesInFlight.Clear();
   m_imagesInFlight.Clear();
   m_uiCurrentFrame = 0;
+  m_uiInstanceWriteFrame = nsInvalidIndex;
+  m_uiLatestInstanceFrame = nsInvalidIndex;
 }
 
 void nsVulkanRenderer::UpdateScene(const nsMat4& mViewProjection, nsArrayPtr<const nsVulkanInstanceData> instances)
 {
   m_viewProjection = mViewProjection;
 
-  m_sceneInstances.SetCount(instances.GetCount());
-  if (!instances.IsEmpty())
+  nsArrayPtr<nsVulkanGpuInstance> target = BeginInstances(instances.GetCount());
+  if (target.IsEmpty() && !instances.IsEmpty())
+    return;
+
+  nsUInt32 uiWritten = 0;
+  for (const nsVulkanInstanceData& instance : instances)
+  {
+    if (instance.m_bSleeping)
+      continue;
+
+    nsVulkanGpuInstance& gpuInstance = target[uiWritten++];
+    gpuInstance.m_ModelMatrix = instance.m_ModelMatrix;
+    gpuInstance.m_Color = instance.m_Color;
+  }
+
+  EndInstances(uiWritten);
+}
+
+nsArrayPtr<nsVulkanGpuInstance> nsVulkanRenderer::BeginInstances(nsUInt32 uiMaxInstances)
+{
+  NS_ASSERT_DEV(m_uiInstanceWriteFrame == nsInvalidIndex, "BeginInstances() was called twice without EndInstances()");
+
+  if (m_pDevice == nullptr || m_framesInFlight.IsEmpty())
+    return {};
+
+  VkDevice deviceHandle = m_pDevice->GetDevice();
+  FrameInFlight& frame = m_framesInFlight[m_uiCurrentFrame];
+
+  // the buffer stays in use until every frame that drew from it has finished, not only the frame that owns it
+  nsHybridArray<VkFence, 4> busyFences;
+  for (const FrameInFlight& other : m_framesInFlight)
+  {
+    if (other.m_uiInstanceSource == m_uiCurrentFrame && other.m_inFlightFence != VK_NULL_HANDLE)
+    {
+      busyFences.PushBack(other.m_inFlightFence);
+    }
+  }
+
+  if (!busyFences.IsEmpty() && vkWaitForFences(deviceHandle, busyFences.GetCount(), busyFences.GetData(), VK_TRUE, std::numeric_limits<nsUInt64>::max()) != VK_SUCCESS)
+  {
+    nsLog::Error("Failed to wait for Vulkan fences guarding the instance buffer");
+    return {};
+  }
+
+  if (EnsureInstanceCapacity(frame, uiMaxInstances).Failed())
+    return {};
+
+  m_uiInstanceWriteFrame = m_uiCurrentFrame;
+  return nsArrayPtr<nsVulkanGpuInstance>(frame.m_pInstanceMapped, uiMaxInstances);
+}
+
+void nsVulkanRenderer::EndInstances(nsUInt32 uiWrittenInstances)
+{
+  if (m_uiInstanceWriteFrame == nsInvalidIndex)
+    return;
+
+  FrameInFlight& frame = m_framesInFlight[m_uiInstanceWriteFrame];
+  NS_ASSERT_DEV(uiWrittenInstances <= frame.m_uiInstanceCapacity, "Wrote {0} instances into a buffer for {1}", uiWrittenInstances, frame.m_uiInstanceCapacity);
+
+  frame.m_uiInstanceCount = uiWrittenInstances;
+  m_uiLatestInstanceFrame = m_uiInstanceWriteFrame;
+  m_uiInstanceWriteFrame = nsInvalidIndex;
+}
+
+nsResult nsVulkanRenderer::EnsureInstanceCapacity(FrameInFlight& frame, nsUInt32 uiInstanceCount)
+{
+  if (frame.m_pInstanceMapped != nullptr && frame.m_uiInstanceCapacity >= uiInstanceCount)
+    return NS_SUCCESS;
+
+  DestroyInstanceBuffer(frame);
+
+  const nsUInt32 uiCapacity = nsMath::Max(s_uiMinInstanceCapacity, nsMath::PowerOfTwo_Ceil(uiInstanceCount));
+  const VkDeviceSize bufferSize = static_cast<VkDeviceSize>(uiCapacity) * sizeof(nsVulkanGpuInstance);
+
+  if (CreateBuffer(bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.m_instanceBuffer, frame.m_instanceMemory).Failed())
   {
-    nsMemoryUtils::Copy(m_sceneInstances.GetData(), instances.GetPtr(), instances.GetCount());
+    nsLog::Error("Failed to create Vulkan instance buffer for {0} instances", uiCapacity);
+    return NS_FAILURE;
   }
 
-  m_bSceneDirty = true;
+  void* pMapped = nullptr;
+  if (vkMapMemory(m_pDevice->GetDevice(), frame.m_instanceMemory, 0, bufferSize, 0, &pMapped) != VK_SUCCESS)
+  {
+    nsLog::Error("Failed to map Vulkan instance buffer");
+    DestroyInstanceBuffer(frame);
+    return NS_FAILURE;
+  }
+
+  frame.m_pInstanceMapped = static_cast<nsVulkanGpuInstance*>(pMapped);
+  frame.m_uiInstanceCapacity = uiCapacity;
+  return NS_SUCCESS;
+}
+
+void nsVulkanRenderer::DestroyInstanceBuffer(FrameInFlight& frame)
+{
+  VkDevice device = m_pDevice ? m_pDevice->GetDevice() : VK_NULL_HANDLE;
+  if (device == VK_NULL_HANDLE)
+    return;
+
+  if (frame.m_pInstanceMapped)
+  {
+    vkUnmapMemory(device, frame.m_instanceMemory);
+    frame.m_pInstanceMapped = nullptr;
+  }
+
+  if (frame.m_instanceBuffer != VK_NULL_HANDLE)
+  {
+    vkDestroyBuffer(device, frame.m_instanceBuffer, nullptr);
+    frame.m_instanceBuffer = VK_NULL_HANDLE;
+  }
+
+  if (frame.m_instanceMemory != VK_NULL_HANDLE)
+  {
+    vkFreeMemory(device, frame.m_instanceMemory, nullptr);
+    frame.m_instanceMemory = VK_NULL_HANDLE;
+  }
+
+  frame.m_uiInstanceCapacity = 0;
+  frame.m_uiInstanceCount = 0;
+}
+
+nsResult nsVulkanRenderer::ConfigureHistory(nsUInt32 uiFrameCapacity, nsUInt32 uiBodyCapacity)
+{
+  if (m_pDevice == nullptr || m_historySetLayout == VK_NULL_HANDLE)
+    return NS_FAILURE;
+
+  VkDevice device = m_pDevice->GetDevice();
+  if (device == VK_NULL_HANDLE)
+    return NS_FAILURE;
+
+  const nsUInt64 uiBufferSize = static_cast<nsUInt64>(uiFrameCapacity) * uiBodyCapacity * sizeof(nsVulkanHistorySample);
+  if (uiBufferSize == 0 || uiBufferSize > s_uiMaxHistoryBytes)
+  {
+    nsLog::Error("Motion history of {0} frames with {1} bodies does not fit into {2} MB", uiFrameCapacity, uiBodyCapacity, s_uiMaxHistoryBytes / (1024 * 1024));
+    return NS_FAILURE;
+  }
+
+  // the old ring and the staging rows may still be read by frames in flight
+  vkDeviceWaitIdle(device);
+
+  DestroyHistoryResources();
+  for (FrameInFlight& frame : m_framesInFlight)
+  {
+    DestroyHistoryStaging(frame);
+  }
+
+  if (CreateBuffer(uiBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_historyBuffer, m_historyMemory).Failed())
+  {
+    nsLog::Error("Failed to create Vulkan motion history buffer");
+    return NS_FAILURE;
+  }
+
+  VkDescriptorPoolSize poolSize = {};
+  poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  poolSize.descriptorCount = 1;
+
+  VkDescriptorPoolCreateInfo poolInfo = {};
+  poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  poolInfo.poolSizeCount = 1;
+  poolInfo.pPoolSizes = &poolSize;
+  poolInfo.maxSets = 1;
+
+  if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &m_historyDescriptorPool) != VK_SUCCESS)
+  {
+    nsLog::Error("Failed to create Vulkan descriptor pool for the motion history");
+    DestroyHistoryResources();
+    return NS_FAILURE;
+  }
+
+  VkDescriptorSetAllocateInfo allocInfo = {};
+  allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocInfo.descriptorPool = m_historyDescriptorPool;
+  allocInfo.descriptorSetCount = 1;
+  allocInfo.pSetLayouts = &m_historySetLayout;
+
+  if (vkAllocateDescriptorSets(device, &allocInfo, &m_historyDescriptorSet) != VK_SUCCESS)
+  {
+    nsLog::Error("Failed to allocate Vulkan descriptor set for the motion history");
+    DestroyHistoryResources();
+    return NS_FAILURE;
+  }
+
+  VkDescriptorBufferInfo bufferInfo = {};
+  bufferInfo.buffer = m_historyBuffer;
+  bufferInfo.offset = 0;
+  bufferInfo.range = uiBufferSize;
+
+  VkWriteDescriptorSet descriptorWrite = {};
+  descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  descriptorWrite.dstSet = m_historyDescriptorSet;
+  descriptorWrite.dstBinding = 0;
+  descriptorWrite.dstArrayElement = 0;
+  descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  descriptorWrite.descriptorCount = 1;
+  descriptorWrite.pBufferInfo = &bufferInfo;
+
+  vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+
+  m_uiHistoryFrameCapacity = uiFrameCapacity;
+  m_uiHistoryBodyCapacity = uiBodyCapacity;
+  return NS_SUCCESS;
+}
+
+nsArrayPtr<nsVulkanHistorySample> nsVulkanRenderer::WriteHistoryRow(nsUInt32 uiRow)
+{
+  if (m_historyBuffer == VK_NULL_HANDLE || m_framesInFlight.IsEmpty())
+    return {};
+
+  NS_ASSERT_DEV(uiRow < m_uiHistoryFrameCapacity, "History row {0} is out of range, the ring has {1} rows", uiRow, m_uiHistoryFrameCapacity);
+
+  FrameInFlight& frame = m_framesInFlight[m_uiCurrentFrame];
+
+  nsUInt32 uiSlot = frame.m_PendingHistoryRows.IndexOf(uiRow);
+  if (uiSlot == nsInvalidIndex)
+  {
+    uiSlot = frame.m_PendingHistoryRows.GetCount();
+    frame.m_PendingHistoryRows.PushBack(uiRow);
+    frame.m_PendingHistorySamples.SetCountUninitialized((uiSlot + 1) * m_uiHistoryBodyCapacity);
+  }
+
+  return frame.m_PendingHistorySamples.GetArrayPtr().GetSubArray(uiSlot * m_uiHistoryBodyCapacity, m_uiHistoryBodyCapacity);
+}
+
+void nsVulkanRenderer::SetHistoryRange(nsUInt32 uiHeadRow, nsUInt32 uiFrameCount)
+{
+  m_uiHistoryHeadRow = uiHeadRow;
+  m_uiHistoryFrameCount = nsMath::Min(uiFrameCount, m_uiHistoryFrameCapacity);
+}
+
+void nsVulkanRenderer::SetOverlays(nsBitflags<nsVulkanOverlay> overlays, float fVelocityScale)
+{
+  m_overlays = overlays;
+  m_fVelocityScale = fVelocityScale;
+}
+
+nsResult nsVulkanRenderer::EnsureHistoryStagingCapacity(FrameInFlight& frame, nsUInt32 uiRows)
+{
+  if (frame.m_pHistoryStagingMapped != nullptr && frame.m_uiHistoryStagingCapacity >= uiRows)
+    return NS_SUCCESS;
+
+  VkDevice device = m_pDevice->GetDevice();
+
+  // usually a few rows per frame, only seeks fill many rows at once
+  const nsUInt32 uiCapacity = nsMath::Min(nsMath::PowerOfTwo_Ceil(uiRows), m_uiHistoryFrameCapacity);
+  const VkDeviceSize bufferSize = static_cast<VkDeviceSize>(uiCapacity) * m_uiHistoryBodyCapacity * sizeof(nsVulkanHistorySample);
+
+  VkBuffer buffer = VK_NULL_HANDLE;
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  if (CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer, memory).Failed())
+  {
+    nsLog::Error("Failed to create Vulkan history staging buffer for {0} rows", uiCapacity);
+    return NS_FAILURE;
+  }
+
+  void* pMapped = nullptr;
+  if (vkMapMemory(device, memory, 0, bufferSize, 0, &pMapped) != VK_SUCCESS)
+  {
+    nsLog::Error("Failed to map Vulkan history staging buffer");
+    vkDestroyBuffer(device, buffer, nullptr);
+    vkFreeMemory(device, memory, nullptr);
+    return NS_FAILURE;
+  }
+
+  // the pending rows live on the CPU, so the old buffer holds nothing that has to move over
+  nsHybridArray<nsUInt32, 4> pendingRows = frame.m_PendingHistoryRows;
+  nsDynamicArray<nsVulkanHistorySample> pendingSamples;
+  pendingSamples.Swap(frame.m_PendingHistorySamples);
+
+  DestroyHistoryStaging(frame);
+
+  frame.m_historyStagingBuffer = buffer;
+  frame.m_historyStagingMemory = memory;
+  frame.m_pHistoryStagingMapped = static_cast<nsVulkanHistorySample*>(pMapped);
+  frame.m_uiHistoryStagingCapacity = uiCapacity;
+  frame.m_PendingHistoryRows = pendingRows;
+  frame.m_PendingHistorySamples.Swap(pendingSamples);
+  return NS_SUCCESS;
+}
+
+void nsVulkanRenderer::DestroyHistoryStaging(FrameInFlight& frame)
+{
+  VkDevice device = m_pDevice ? m_pDevice->GetDevice() : VK_NULL_HANDLE;
+  if (device == VK_NULL_HANDLE)
+    return;
+
+  if (frame.m_pHistoryStagingMapped)
+  {
+    vkUnmapMemory(device, frame.m_historyStagingMemory);
+    frame.m_pHistoryStagingMapped = nullptr;
+  }
+
+  if (frame.m_historyStagingBuffer != VK_NULL_HANDLE)
+  {
+    vkDestroyBuffer(device, frame.m_historyStagingBuffer, nullptr);
+    frame.m_historyStagingBuffer = VK_NULL_HANDLE;
+  }
+
+  if (frame.m_historyStagingMemory != VK_NULL_HANDLE)
+  {
+    vkFreeMemory(device, frame.m_historyStagingMemory, nullptr);
+    frame.m_historyStagingMemory = VK_NULL_HANDLE;
+  }
+
+  frame.m_uiHistoryStagingCapacity = 0;
+  frame.m_PendingHistoryRows.Clear();
+  frame.m_PendingHistorySamples.Clear();
+}
+
+void nsVulkanRenderer::DestroyHistoryResources()
+{
+  VkDevice device = m_pDevice ? m_pDevice->GetDevice() : VK_NULL_HANDLE;
+  if (device == VK_NULL_HANDLE)
+    return;
+
+  if (m_historyDescriptorPool != VK_NULL_HANDLE)
+  {
+    vkDestroyDescriptorPool(device, m_historyDescriptorPool, nullptr);
+    m_historyDescriptorPool = VK_NULL_HANDLE;
+    m_historyDescriptorSet = VK_NULL_HANDLE;
+  }
+
+  if (m_historyBuffer != VK_NULL_HANDLE)
+  {
+    vkDestroyBuffer(device, m_historyBuffer, nullptr);
+    m_historyBuffer = VK_NULL_HANDLE;
+  }
+
+  if (m_historyMemory != VK_NULL_HANDLE)
+  {
+    vkFreeMemory(device, m_historyMemory, nullptr);
+    m_historyMemory = VK_NULL_HANDLE;
+  }
+
+  m_uiHistoryFrameCapacity = 0;
+  m_uiHistoryBodyCapacity = 0;
+  m_uiHistoryHeadRow = 0;
+  m_uiHistoryFrameCount = 0;
+}
+
+void nsVulkanRenderer::RecordHistoryUploads(FrameInFlight& frame)
+{
+  if (frame.m_PendingHistoryRows.IsEmpty() || m_historyBuffer == VK_NULL_HANDLE)
+    return;
+
+  // the fence of this frame was waited on, the last copy out of the staging buffer is done
+  if (EnsureHistoryStagingCapacity(frame, frame.m_PendingHistoryRows.GetCount()).Failed())
+  {
+    frame.m_PendingHistoryRows.Clear();
+    frame.m_PendingHistorySamples.Clear();
+    return;
+  }
+
+  // one sequential write into the write-combined memory
+  nsMemoryUtils::Copy(frame.m_pHistoryStagingMapped, frame.m_PendingHistorySamples.GetData(), frame.m_PendingHistorySamples.GetCount());
+
+  const VkDeviceSize rowSize = static_cast<VkDeviceSize>(m_uiHistoryBodyCapacity) * sizeof(nsVulkanHistorySample);
+
+  nsHybridArray<VkBufferCopy, 4> regions;
+  for (nsUInt32 uiSlot = 0; uiSlot < frame.m_PendingHistoryRows.GetCount(); ++uiSlot)
+  {
+    VkBufferCopy& region = regions.ExpandAndGetRef();
+    region.srcOffset = uiSlot * rowSize;
+    region.dstOffset = frame.m_PendingHistoryRows[uiSlot] * rowSize;
+    region.size = rowSize;
+  }
+
+  // earlier frames may still draw overlays from the rows that are overwritten now
+  VkBufferMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.buffer = m_historyBuffer;
+  barrier.offset = 0;
+  barrier.size = VK_WHOLE_SIZE;
+  vkCmdPipelineBarrier(frame.m_commandBuffer, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+  vkCmdCopyBuffer(frame.m_commandBuffer, frame.m_historyStagingBuffer, m_historyBuffer, regions.GetCount(), regions.GetData());
+
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(frame.m_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+  frame.m_PendingHistoryRows.Clear();
+  frame.m_PendingHistorySamples.Clear();
+}
+
+void nsVulkanRenderer::RecordOverlays(FrameInFlight& frame)
+{
+  if (m_overlays.IsNoFlagSet() || m_historyDescriptorSet == VK_NULL_HANDLE || m_uiHistoryFrameCount == 0)
+    return;
+
+  VkDescriptorSet descriptorSets[] = {frame.m_descriptorSet, m_historyDescriptorSet};
+  vkCmdBindDescriptorSets(frame.m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_overlayPipelineLayout, 0, NS_ARRAY_SIZE(descriptorSets), descriptorSets, 0, nullptr);
+
+  OverlayConstants constants;
+  constants.m_uiHeadRow = m_uiHistoryHeadRow;
+  constants.m_uiFrameCount = m_uiHistoryFrameCount;
+  constants.m_uiFrameCapacity = m_uiHistoryFrameCapacity;
+  constants.m_uiBodyCapacity = m_uiHistoryBodyCapacity;
+  constants.m_fVelocityScale = m_fVelocityScale;
+  vkCmdPushConstants(frame.m_commandBuffer, m_overlayPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+
+  // one instance per body, the vertices of an instance walk through its history
+  if (m_overlays.IsSet(nsVulkanOverlay::Heatmap))
+  {
+    vkCmdBindPipeline(frame.m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_heatmapPipeline);
+    vkCmdDraw(frame.m_commandBuffer, m_uiHistoryFrameCount, m_uiHistoryBodyCapacity, 0, 0);
+  }
+
+  if (m_overlays.IsSet(nsVulkanOverlay::Trails) && m_uiHistoryFrameCount > 1)
+  {
+    vkCmdBindPipeline(frame.m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_trailPipeline);
+    vkCmdDraw(frame.m_commandBuffer, (m_uiHistoryFrameCount - 1) * 2, m_uiHistoryBodyCapacity, 0, 0);
+  }
+
+  if (m_overlays.IsSet(nsVulkanOverlay::Velocity))
+  {
+    vkCmdBindPipeline(frame.m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_velocityPipeline);
+    vkCmdDraw(frame.m_commandBuffer, 2, m_uiHistoryBodyCapacity, 0, 0);
+  }
 }
 
 nsResult nsVulkanRenderer::RenderFrame()
@@ -1448,6 +1943,8 @@ nsResult nsVulkanRenderer::RenderFrame()
     return NS_FAILURE;
   }
 
+  RecordHistoryUploads(frame);
+
   VkClearValue clearColor = {};
   clearColor.color = {{0.02f, 0.05f, 0.09f, 1.0f}};
 
@@ -1484,20 +1981,20 @@ nsResult nsVulkanRenderer::RenderFrame()
   vkCmdBindVertexBuffers(frame.m_commandBuffer, 0, 1, vertexBuffers, vertexOffsets);
   vkCmdBindIndexBuffer(frame.m_commandBuffer, m_indexBuffer, 0, VK_INDEX_TYPE_UINT16);
 
-  for (const nsVulkanInstanceData& instance : m_sceneInstances)
+  frame.m_uiInstanceSource = m_uiLatestInstanceFrame;
+  if (m_uiLatestInstanceFrame != nsInvalidIndex)
   {
-    if (instance.m_bSleeping)
-      continue;
-
-    PushConstantData pushConstants;
-    pushConstants.m_Model = instance.m_ModelMatrix;
-    pushConstants.m_Color = instance.m_Color;
-
-    vkCmdPushConstants(frame.m_commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstantData), &pushConstants);
-    vkCmdDrawIndexed(frame.m_commandBuffer, m_uiIndexCount, 1, 0, 0, 0);
+    const FrameInFlight& instanceFrame = m_framesInFlight[m_uiLatestInstanceFrame];
+    if (instanceFrame.m_uiInstanceCount > 0)
+    {
+      VkBuffer instanceBuffers[] = {instanceFrame.m_instanceBuffer};
+      VkDeviceSize instanceOffsets[] = {0};
+      vkCmdBindVertexBuffers(frame.m_commandBuffer, 1, 1, instanceBuffers, instanceOffsets);
+      vkCmdDrawIndexed(frame.m_commandBuffer, m_uiIndexCount, instanceFrame.m_uiInstanceCount, 0, 0, 0);
+    }
   }
 
-  m_bSceneDirty = false;
+  RecordOverlays(frame);
 
   vkCmdEndRenderPass(frame.m_commandBuffer);
 
@@ -1557,8 +2054,10 @@ nsResult nsVulkanRenderer::RenderFrame()
 void nsVulkanRenderer::Deinitialize()
 {
   DestroyFrameResources();
+  DestroyHistoryResources();
   DestroySwapChainResources();
   DestroyGeometryBuffers();
+  DestroyPipelineCache();
   DestroyShaderModules();
 
   if (m_pDevice && m_descriptorSetLayout != VK_NULL_HANDLE)
@@ -1567,6 +2066,12 @@ void nsVulkanRenderer::Deinitialize()
     m_descriptorSetLayout = VK_NULL_HANDLE;
   }
 
+  if (m_pDevice && m_historySetLayout != VK_NULL_HANDLE)
+  {
+    vkDestroyDescriptorSetLayout(m_pDevice->GetDevice(), m_historySetLayout, nullptr);
+    m_historySetLayout = VK_NULL_HANDLE;
+  }
+
   if (m_pCommandContext)
   {
     if (m_pDevice)
@@ -9,11 +9,15 @@
 #include <Foundation/Containers/HybridArray.h>
 #include <Foundation/Math/Color.h>
 #include <Foundation/Math/Mat4.h>
+#include <Foundation/Math/Vec3.h>
+#include <Foundation/Time/Time.h>
+#include <Foundation/Types/Bitflags.h>
 #include <Foundation/Types/UniquePtr.h>
 
 class nsVkInstance;
 class nsVkDevice;
 class nsVkCommandContext;
+struct nsVkShaderDesc;
 
 struct nsVulkanRendererCreateInfo
 {
@@ -30,6 +34,57 @@ struct nsVulkanInstanceData
   bool m_bSleeping = false;
 };
 
+/// \brief Where the time of the last nsVulkanRenderer::Initialize() went, shows whether shaders and pipelines came from the caches.
+struct nsVulkanRendererStartupStats
+{
+  nsTime m_TotalDuration;
+  nsTime m_ShaderDuration;
+  nsTime m_PipelineDuration;
+  nsUInt32 m_uiShadersCompiled = 0; ///< Shaders that had to be compiled with DXC, zero when every shader came from a cache.
+  bool m_bPipelineCacheLoaded = false;
+};
+
+/// \brief Overlays drawn on top of the bodies from the motion history, see nsVulkanRenderer::ConfigureHistory().
+struct nsVulkanOverlay
+{
+  using StorageType = nsUInt8;
+
+  enum Enum : nsUInt8
+  {
+    None = 0,
+    Trails = NS_BIT(0),   ///< A fading line through the recent positions of every body.
+    Velocity = NS_BIT(1), ///< A line along the current linear velocity of every body.
+    Heatmap = NS_BIT(2),  ///< Additive points at all recent positions, bright where bodies spent a lot of time.
+
+    Default = None
+  };
+
+  struct Bits
+  {
+    StorageType Trails : 1;
+    StorageType Velocity : 1;
+    StorageType Heatmap : 1;
+  };
+};
+
+NS_DECLARE_FLAGS_OPERATORS(nsVulkanOverlay);
+
+/// \brief One body in one frame of the motion history, as the overlay shaders read it.
+struct nsVulkanHistorySample
+{
+  nsVec3 m_vPosition;
+  float m_fValid; ///< 1 if the body exists in the frame, 0 otherwise.
+  nsVec3 m_vLinearVelocity;
+  float m_fPadding;
+};
+
+/// \brief Per-instance vertex data as the scene shader reads it, written directly into mapped GPU memory.
+struct nsVulkanGpuInstance
+{
+  nsMat4 m_ModelMatrix;
+  nsColor m_Color;
+};
+
 class NS_VULKANRENDERER_DLL nsVulkanRenderer
 {
 public:
@@ -41,7 +96,39 @@ public:
   nsResult RenderFrame();
   void SetBackBufferSize(nsUInt32 uiWidth, nsUInt32 uiHeight);
   void UpdateScene(const nsMat4& mViewProjection, nsArrayPtr<const nsVulkanInstanceData> instances);
+
+  /// \brief Returns room for up to uiMaxInstances instances in a persistently mapped buffer owned by the current frame in flight.
+  ///
+  /// Only writes are allowed, the memory is write-combined. Waits for the GPU if a previous frame still reads the buffer.
+  /// Every call must be followed by EndInstances() before the next RenderFrame(). Returns an empty array on failure.
+  nsArrayPtr<nsVulkanGpuInstance> BeginInstances(nsUInt32 uiMaxInstances);
+
+  /// \brief Publishes the first uiWrittenInstances instances of the last BeginInstances() buffer, all following frames draw them.
+  void EndInstances(nsUInt32 uiWrittenInstances);
+
+  void SetViewProjection(const nsMat4& mViewProjection) { m_viewProjection = mViewProjection; }
   bool IsInitialized() const { return m_pDevice != nullptr; }
+  const nsVulkanRendererStartupStats& GetStartupStats() const { return m_startupStats; }
+
+  /// \brief Creates the GPU ring for the motion history: uiFrameCapacity rows with uiBodyCapacity samples each.
+  ///
+  /// Waits until the GPU is idle, so only call it when the layout changes. All rows start out undefined.
+  nsResult ConfigureHistory(nsUInt32 uiFrameCapacity, nsUInt32 uiBodyCapacity);
+
+  /// \brief Returns memory for one row of the history ring, the next RenderFrame() copies it into the ring on the GPU.
+  ///
+  /// Every sample of the row has to be written, the memory starts out undefined. The array stays valid until the next call.
+  /// Writing the same row again before RenderFrame() replaces it. Returns an empty array if no history is configured.
+  nsArrayPtr<nsVulkanHistorySample> WriteHistoryRow(nsUInt32 uiRow);
+
+  /// \brief Which rows the overlays read: uiHeadRow holds the newest frame, the rows before it (wrapping around) the older ones.
+  void SetHistoryRange(nsUInt32 uiHeadRow, nsUInt32 uiFrameCount);
+
+  /// \brief Selects the overlays. Velocity lines are fVelocityScale seconds of movement long.
+  void SetOverlays(nsBitflags<nsVulkanOverlay> overlays, float fVelocityScale);
+
+  /// \brief The shaders the renderer uses, for precompiling them at build time.
+  static nsArrayPtr<const nsVkShaderDesc> GetShaderDescs();
 
 private:
   struct FrameInFlight
@@ -54,6 +141,33 @@ private:
     VkBuffer m_uniformBuffer = VK_NULL_HANDLE;
     VkDeviceMemory m_uniformMemory = VK_NULL_HANDLE;
     void* m_pUniformMapped = nullptr;
+
+    // instance ring: each frame owns one buffer, frames draw whichever buffer was written last
+    VkBuffer m_instanceBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory m_instanceMemory = VK_NULL_HANDLE;
+    nsVulkanGpuInstance* m_pInstanceMapped = nullptr;
+    nsUInt32 m_uiInstanceCapacity = 0;
+    nsUInt32 m_uiInstanceCount = 0;
+    nsUInt32 m_uiInstanceSource = nsInvalidIndex; ///< Instance buffer read by the last submission of this frame.
+
+    // history rows written since the last submission of this frame, copied into the ring before the render pass
+    VkBuffer m_historyStagingBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory m_historyStagingMemory = VK_NULL_HANDLE;
+    nsVulkanHistorySample* m_pHistoryStagingMapped = nullptr;
+    nsUInt32 m_uiHistoryStagingCapacity = 0; ///< In rows.
+    nsHybridArray<nsUInt32, 4> m_PendingHistoryRows;
+    nsDynamicArray<nsVulkanHistorySample> m_PendingHistorySamples; ///< The pending rows are kept on the CPU, the write-combined staging memory is only written once per submission.
+  };
+
+  enum ShaderIndex
+  {
+    SceneVS,
+    ScenePS,
+    TrailVS,
+    VelocityVS,
+    HeatmapVS,
+    OverlayPS,
+    ShaderCount
   };
 
   nsResult CreateSwapChainResources();
@@ -70,6 +184,16 @@ private:
   void DestroyShaderModules();
   nsResult CreateGraphicsPipeline();
   void DestroyGraphicsPipeline();
+  void CreatePipelineCache();
+  void DestroyPipelineCache();
+  nsResult CreateOverlayPipeline(ShaderIndex vertexShader, VkPrimitiveTopology topology, bool bAdditive, VkPipeline& out_pipeline);
+  nsResult EnsureHistoryStagingCapacity(FrameInFlight& frame, nsUInt32 uiRows);
+  void DestroyHistoryStaging(FrameInFlight& frame);
+  void DestroyHistoryResources();
+  void RecordHistoryUploads(FrameInFlight& frame);
+  void RecordOverlays(FrameInFlight& frame);
+  nsResult EnsureInstanceCapacity(FrameInFlight& frame, nsUInt32 uiInstanceCount);
+  void DestroyInstanceBuffer(FrameInFlight& frame);
   nsResult CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& outBuffer, VkDeviceMemory& outMemory);
   nsUInt32 FindMemoryType(nsUInt32 typeFilter, VkMemoryPropertyFlags properties) const;
 
@@ -90,14 +214,32 @@ private:
   nsUInt32 m_uiMaxFramesInFlight = 2;
   bool m_bResizePending = false;
   nsMat4 m_viewProjection = nsMat4::MakeIdentity();
-  nsDynamicArray<nsVulkanInstanceData> m_sceneInstances;
-  bool m_bSceneDirty = false;
+  nsUInt32 m_uiInstanceWriteFrame = nsInvalidIndex;
+  nsUInt32 m_uiLatestInstanceFrame = nsInvalidIndex;
   VkDescriptorSetLayout m_descriptorSetLayout = VK_NULL_HANDLE;
   VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
   VkPipeline m_graphicsPipeline = VK_NULL_HANDLE;
+  VkPipelineCache m_pipelineCache = VK_NULL_HANDLE;
+  nsVulkanRendererStartupStats m_startupStats;
+
+  // motion history overlays
+  VkDescriptorSetLayout m_historySetLayout = VK_NULL_HANDLE;
+  VkDescriptorPool m_historyDescriptorPool = VK_NULL_HANDLE;
+  VkDescriptorSet m_historyDescriptorSet = VK_NULL_HANDLE;
+  VkPipelineLayout m_overlayPipelineLayout = VK_NULL_HANDLE;
+  VkPipeline m_trailPipeline = VK_NULL_HANDLE;
+  VkPipeline m_velocityPipeline = VK_NULL_HANDLE;
+  VkPipeline m_heatmapPipeline = VK_NULL_HANDLE;
+  VkBuffer m_historyBuffer = VK_NULL_HANDLE;
+  VkDeviceMemory m_historyMemory = VK_NULL_HANDLE;
+  nsUInt32 m_uiHistoryFrameCapacity = 0;
+  nsUInt32 m_uiHistoryBodyCapacity = 0;
+  nsUInt32 m_uiHistoryHeadRow = 0;
+  nsUInt32 m_uiHistoryFrameCount = 0;
+  nsBitflags<nsVulkanOverlay> m_overlays;
+  float m_fVelocityScale = 0.25f;
   VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
-  VkShaderModule m_vertexShaderModule = VK_NULL_HANDLE;
-  VkShaderModule m_fragmentShaderModule = VK_NULL_HANDLE;
+  VkShaderModule m_shaderModules[ShaderCount] = {};
   VkBuffer m_vertexBuffer = VK_NULL_HANDLE;
   VkDeviceMemory m_vertexBufferMemory = VK_NULL_HANDLE;
   VkBuffer m_indexBuffer = VK_NULL_HANDLE;
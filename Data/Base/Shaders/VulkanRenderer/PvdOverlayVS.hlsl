@@ -0,0 +1,82 @@
+cbuffer SceneViewUniform : register(b0)
+{
+  row_major float4x4 g_ViewProjection;
+};
+
+// matches nsVulkanHistorySample
+struct HistorySample
+{
+  float3 Position;
+  float Valid;
+  float3 LinearVelocity;
+  float Padding;
+};
+
+// rows of a ring, one row per frame with one sample per body
+[[vk::binding(0, 1)]] StructuredBuffer<HistorySample> g_History : register(t0, space1);
+
+struct OverlayConstants
+{
+  uint HeadRow;
+  uint FrameCount;
+  uint FrameCapacity;
+  uint BodyCapacity;
+  float VelocityScale;
+};
+
+[[vk::push_constant]] OverlayConstants g_Overlay;
+
+struct VSOutput
+{
+  float4 Position : SV_Position;
+  float4 Color : COLOR0;
+  [[vk::builtin("PointSize")]] float PointSize : PSIZE;
+};
+
+// age 0 is the newest frame
+HistorySample LoadSample(uint age, uint body)
+{
+  uint row = (g_Overlay.HeadRow + g_Overlay.FrameCapacity - age) % g_Overlay.FrameCapacity;
+  return g_History[row * g_Overlay.BodyCapacity + body];
+}
+
+VSOutput MakeVertex(float3 worldPosition, float4 color, bool valid)
+{
+  VSOutput output;
+
+  // primitives with a missing sample are moved out of the clip volume and never rasterized
+  output.Position = valid ? mul(float4(worldPosition, 1.0f), g_ViewProjection) : float4(2.0f, 2.0f, 2.0f, 1.0f);
+  output.Color = color;
+  output.PointSize = 1.0f;
+
+  return output;
+}
+
+VSOutput mainTrailVS(uint vertexId : SV_VertexID, uint body : SV_InstanceID)
+{
+  // line list, segment n connects age n and age n + 1
+  uint segment = vertexId / 2;
+  uint age = segment + (vertexId & 1);
+
+  HistorySample sample = LoadSample(age, body);
+  HistorySample other = LoadSample((vertexId & 1) ? segment : segment + 1, body);
+
+  float fade = 1.0f - (float)age / (float)g_Overlay.FrameCount;
+  return MakeVertex(sample.Position, float4(1.0f, 0.8f, 0.2f, fade), sample.Valid > 0.0f && other.Valid > 0.0f);
+}
+
+VSOutput mainVelocityVS(uint vertexId : SV_VertexID, uint body : SV_InstanceID)
+{
+  HistorySample sample = LoadSample(0, body);
+
+  float3 position = sample.Position + sample.LinearVelocity * (g_Overlay.VelocityScale * (float)vertexId);
+  return MakeVertex(position, float4(0.3f, 0.9f, 1.0f, 1.0f), sample.Valid > 0.0f);
+}
+
+VSOutput mainHeatmapVS(uint vertexId : SV_VertexID, uint body : SV_InstanceID)
+{
+  HistorySample sample = LoadSample(vertexId, body);
+
+  // additive, places that are visited often saturate
+  return MakeVertex(sample.Position, float4(1.0f, 0.35f, 0.1f, 0.08f), sample.Valid > 0.0f);
+}
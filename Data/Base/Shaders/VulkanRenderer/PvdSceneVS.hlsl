@@ -5,7 +5,14 @@ cbuffer SceneViewUniform : register(b0)
 
 struct VSInput
 {
-  float3 Position : POSITION;
+  [[vk::location(0)]] float3 Position : POSITION;
+
+  // per instance, the model matrix arrives as four rows
+  [[vk::location(1)]] float4 Model0 : INSTANCE_MODEL0;
+  [[vk::location(2)]] float4 Model1 : INSTANCE_MODEL1;
+  [[vk::location(3)]] float4 Model2 : INSTANCE_MODEL2;
+  [[vk::location(4)]] float4 Model3 : INSTANCE_MODEL3;
+  [[vk::location(5)]] float4 Color : INSTANCE_COLOR;
 };
 
 struct VSOutput
@@ -15,22 +22,16 @@ struct VSOutput
   float4 Color : COLOR0;
 };
 
-struct PushConstants
-{
-  row_major float4x4 Model;
-  float4 Color;
-};
-
-[[vk::push_constant]] PushConstants g_Push;
-
 VSOutput mainVS(VSInput input)
 {
   VSOutput output;
 
-  float4 worldPos = mul(float4(input.Position, 1.0f), g_Push.Model);
+  float4x4 model = float4x4(input.Model0, input.Model1, input.Model2, input.Model3);
+
+  float4 worldPos = mul(float4(input.Position, 1.0f), model);
   output.WorldPosition = worldPos.xyz;
   output.Position = mul(worldPos, g_ViewProjection);
-  output.Color = g_Push.Color;
+  output.Color = input.Color;
 
   return output;
 }